@@ -3,6 +3,7 @@
 #define _EASYTEL_H_
 /* Includes */
 #include "SimpleDPP.h"
+#include "SimpleDPP_port.h"
 #include "cqueue.h"
 
 #define EASYTEL_VERSION "2.0.0"
@@ -13,7 +14,8 @@
 #endif
 
 /**
- * @brief 其data成员支持直接字符串化。
+ * @brief 其data成员支持直接字符串化（data[len]为0）。
+ * 收到的消息（curr_rev_msg）不复制，data指向SimpleDPP接收缓冲区中的帧，只在回调期间有效，capacity等于len。
  *
  */
 struct EasyTelMessage
@@ -25,9 +27,18 @@ struct EasyTelMessage
     uint8_t *data;
     uint16_t crc;
     uint16_t len;
-    uint16_t capacity; // 实际申请的内存大小为capacity+1，用于实现字符串的自动补0
+    uint16_t capacity; // data的大小为capacity+1，用于实现字符串的自动补0
 };
 
+// 帧头：src、dst、seq、type、len，帧尾：crc
+#define ETP_FRAME_HEAD_SIZE 9
+#define ETP_FRAME_CRC_SIZE 2
+// 窗口模式的数据前面有2字节的窗口起点
+#define ETP_FRAME_MAX_SIZE (ETP_FRAME_HEAD_SIZE + 2 + ETP_RECV_MSG_CAPACITY + ETP_FRAME_CRC_SIZE)
+// 每个端点的SimpleDPP缓冲区，发送缓冲区按全部字节都要转义计算
+#define ETP_SDP_RECV_BUFFER_SIZE ETP_FRAME_MAX_SIZE
+#define ETP_SDP_SEND_BUFFER_SIZE (2 + 2 * (ETP_FRAME_HEAD_SIZE + 2 + ETP_SEND_MSG_CAPACITY + ETP_FRAME_CRC_SIZE))
+
 struct tagEasyTelPoint;
 typedef struct tagEasyTelPoint EasyTelPoint, *pEasyTelPoint;
 
@@ -38,8 +49,60 @@ typedef void (*EasyTelRevCallback_t)(EasyTelPoint *etp, struct EasyTelMessage *m
 #define ETP_WRITE_RESULT_ERROR 2
 #define ETP_WRITE_RESULT_NONE 3 // 重置后没有请求的情况
 
+/**
+ * @brief 窗口模式中一条消息发送完成（收到确认或者重发次数用完）时调用。
+ *
+ * @param result ETP_WRITE_RESULT_OK或者ETP_WRITE_RESULT_TIMEOUT。
+ * @param arg EasyTel_obj_window_send传入的参数。
+ */
+typedef void (*EasyTelSendCallback_t)(EasyTelPoint *etp, uint16_t dst, uint16_t seq, uint16_t result, void *arg);
+
+/**
+ * @brief 窗口模式中一条没有确认的消息。由使用者提供数组，数组的长度就是窗口大小。
+ *
+ */
+typedef struct tagEasyTelWindowSlot
+{
+    struct EasyTelMessage msg;
+    uint8_t data[ETP_SEND_MSG_CAPACITY + 2]; // 前两个字节是发送时窗口的起点
+    bool used;
+    bool need_send;      // 新加入或者超时，等待发送
+    uint32_t order;      // 加入发送队列的顺序，按这个顺序发送
+    uint32_t send_time;  // 最后一次发送的时间
+    uint32_t retry_times; // 重试次数，不包含第一次发送
+    EasyTelSendCallback_t callback;
+    void *arg;
+} EasyTelWindowSlot_t;
+
+/**
+ * @brief 窗口模式中和一个地址通信的状态，两个方向的序号分别计数。
+ *
+ */
+typedef struct tagEasyTelWindowPeer
+{
+    uint16_t addr;
+    bool used;
+    uint16_t snd_next; // 下一条发送的消息的序号
+    bool rcv_synced;   // 已经从对方的消息中得到窗口的起点
+    bool ack_pending;  // 收到了消息，还没有回复确认
+    uint16_t rcv_next; // 下一条没有收到的消息的序号，就是回复的累计确认
+    uint32_t rcv_mask; // rcv_next之后已经收到的消息，bit i对应序号rcv_next+1+i
+} EasyTelWindowPeer_t;
+
+typedef struct tagEasyTelWindowStat
+{
+    uint32_t data_frames;  // 发送的数据帧，包括重发
+    uint32_t retransmits;  // 超时重发的数据帧
+    uint32_t completed;    // 收到确认的消息
+    uint32_t timeouts;     // 重发次数用完的消息
+    uint32_t ack_frames;   // 发送的确认帧
+    uint32_t recv_msgs;    // 收到并交给rev_callback的消息
+    uint32_t recv_dups;    // 收到的重复消息
+} EasyTelWindowStat_t;
+
 /* Class Structure */
 /**
+ * 所有的缓冲区都在结构体中，大小在编译时确定，不使用动态内存。
  * EasyTelPoint name rule:
  * etp : pointer of EasyTelPoint
  * etp_o: object of EasyTelPoint
@@ -62,6 +125,20 @@ struct tagEasyTelPoint
     uint32_t retry_times; // 重试次数，不包含第一次发送
     uint32_t retry_times_max;
     uint16_t seq;
+    // 窗口模式，见EasyTel_obj_window_init
+    EasyTelWindowSlot_t *win_slots;
+    uint16_t win_size;
+    uint32_t win_timeout;
+    uint32_t win_order;
+    EasyTelWindowPeer_t win_peers[ETP_WINDOW_PEER_MAX];
+    EasyTelWindowStat_t win_stat;
+    // 缓冲区
+    SimpleDPPAdapter_t sdp_adapter;
+    sdp_byte sdp_send_buf[ETP_SDP_SEND_BUFFER_SIZE];
+    sdp_byte sdp_recv_buf[ETP_SDP_RECV_BUFFER_SIZE];
+    uint8_t send_data[ETP_SEND_MSG_CAPACITY + 1];
+    uint8_t ack_data[ETP_SEND_MSG_CAPACITY + 1];     // 回复消息在这里生成
+    uint8_t rev_ack_data[ETP_RECV_MSG_CAPACITY + 1]; // 收到的回复在回调之后还要读取，复制一次
 };
 
 typedef struct tagEasyTelPointAdapter
@@ -80,6 +157,7 @@ typedef struct tagEasyTelPointAdapter
     void (*debug)(const char *fmt, ...);
 } EasyTelPointAdapter_t;
 
+void EasyTel_obj_init(EasyTelPoint *etp, const EasyTelPointAdapter_t *adapter, uint16_t addr);
 EasyTelPoint *EasyTel_obj_create(const EasyTelPointAdapter_t *adapter, uint16_t addr);
 void EasyTel_obj_destroy(EasyTelPoint *etp);
 void EasyTel_obj_process(EasyTelPoint *etp);
@@ -92,4 +170,9 @@ void EasyTel_obj_make_writeable(EasyTelPoint *etp);
 bool EasyTel_obj_have_response(EasyTelPoint *etp);
 #define EasyTel_obj_get_result(etp) ((etp)->write_result)
 uint32_t EasyTel_obj_ack_msg_push(EasyTelPoint *etp, const void *data, uint32_t len);
+
+bool EasyTel_obj_window_init(EasyTelPoint *etp, EasyTelWindowSlot_t *slots, uint16_t count);
+bool EasyTel_obj_window_send(EasyTelPoint *etp, uint16_t dst, const void *data, uint32_t len, EasyTelSendCallback_t callback, void *arg);
+uint16_t EasyTel_obj_window_free(EasyTelPoint *etp, uint16_t dst);
+#define EasyTel_obj_window_get_stat(etp) (&(etp)->win_stat)
 #endif // _EASYTEL_H_
\ No newline at end of file
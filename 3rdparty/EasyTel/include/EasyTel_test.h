@@ -0,0 +1,20 @@
+/**
+ * @file EasyTel_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef EASYTEL_TEST_H
+#define EASYTEL_TEST_H
+#include <stdint.h>
+#include "EasyTel.h"
+
+#ifdef SIMPLEDPP_SIMULATION
+uint32_t EasyTel_test();
+#endif
+#endif // !EASYTEL_TEST_H
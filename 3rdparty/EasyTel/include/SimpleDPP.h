@@ -55,7 +55,11 @@ typedef int SimpleDPPERROR;
 // default buffer size
 #define SIMPLEDDP_DEFAULT_BUFFER_SIZE 1024
 #define SIMPLEDDP_DEFAULT_FRAME_REV_TIMEOUT 500 // ms
+// SimpeDPP_poll reads this many bytes at a time from the stack and parses them with SimpleDPP_parse_buf
+#define SIMPLEDPP_POLL_READ_SIZE 64
 
+// data points into recv_buffer, or into the span given to SimpleDPP_parse_buf when the whole frame is in it.
+// It is only valid during the callback, copy it if needed later.
 typedef void (*SimpleDPPRecvCallback_t)(void *obj, const sdp_byte *data, int len);
 typedef void (*SimpleDPPRevErrorCallback_t)(void *obj, SimpleDPPERROR error_code);
 typedef sdp_byte (*SimpleDPP_putchar_t)(sdp_byte c);
@@ -114,6 +118,7 @@ int __SimpleDPP_send_datas_n(SimpleDPP *sdp, int arg_num, const sdp_byte *data,
 #endif
 
 void SimpleDPP_parse(SimpleDPP *sdp, sdp_byte c);
+void SimpleDPP_parse_buf(SimpleDPP *sdp, sdp_byte *data, int len);
 int getSimpleDPPErrorCnt(SimpleDPP *sdp);
 
 
@@ -20,6 +20,10 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
     uint32_t SimpleDPP_getMsTick(void);
+#ifdef SIMPLEDPP_SIMULATION
+    // 上位机仿真时SimpleDPP_getMsTick返回这个值
+    extern uint32_t sdp_sim_tick;
+#endif
     void *sdp_malloc(unsigned int nbytes);
 
     void sdp_free(void *ptr);
@@ -27,7 +31,9 @@ extern "C"
 /**
  *@brief Maximum memory usage limit (Valid when AT_MEM_WATCH_EN is enabled)
  */
+#ifndef SDP_MEM_LIMIT_SIZE
 #define SDP_MEM_LIMIT_SIZE (1 * 1024)
+#endif
 /**
  *@brief Enable memory watcher.
  */
@@ -46,11 +52,23 @@ void sdp_core_free(void *ptr);
 #define ETP_SEND_MSG_CAPACITY 128
 #define ETP_RECV_MSG_CAPACITY 128
 #define ETP_ADDR 0x00
+// EasyTel_obj_create从这么多个静态的EasyTelPoint中分配
+#define ETP_POINT_MAX 2
 #define ETP_WRITE_TIMEOUT 1500
 #define ETP_RETRY_TIMES_MAX 3
 
 #define ETP_MSG_TYPE_DATA 0x00
 #define ETP_MSG_TYPE_ACK 0x06
+// 窗口模式的数据和累计确认
+#define ETP_MSG_TYPE_WIN_DATA 0x10
+#define ETP_MSG_TYPE_WIN_ACK 0x16
+
+// 窗口模式：一条消息发出后多久没有确认就重发这一条
+#define ETP_WINDOW_TIMEOUT 300
+// 窗口最多同时有多少条没有确认的消息，受ACK中选择确认的位数限制
+#define ETP_WINDOW_SIZE_MAX 32
+// 窗口模式最多和多少个地址通信
+#define ETP_WINDOW_PEER_MAX 4
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,18 @@
+/**
+ * @file SimpleDPP_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef SIMPLEDPP_TEST_H
+#define SIMPLEDPP_TEST_H
+#include <stdint.h>
+#include "SimpleDPP.h"
+
+uint32_t SimpleDPP_test();
+#endif // !SIMPLEDPP_TEST_H
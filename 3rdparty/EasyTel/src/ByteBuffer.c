@@ -1,4 +1,5 @@
 #include "ByteBuffer.h"
+#include <string.h>
 void byte_buffer_setmemory(pByteBuffer p,sdp_byte *data,int capacity){
     p->data = data;
     p->capacity = capacity;
@@ -47,13 +48,17 @@ Return:
     fail: OVER_CAPACITY_ERROR
 */
 int byte_buffer_push_data(pByteBuffer p,const sdp_byte *data,int len){
-    int i;
-    for(i=0;i<len;i++){
-        if(byte_buffer_push(p,data[i])==OVER_CAPACITY_ERROR){
-            return OVER_CAPACITY_ERROR;
-        }
+    // push as much as fits, like pushing byte by byte
+    int room = p->capacity - p->size;
+    int n = len < room ? len : room;
+    if(n > 0){
+        memcpy(&p->data[p->size],data,n);
+        p->size += n;
     }
-    return i;
+    if(n < len){
+        return OVER_CAPACITY_ERROR;
+    }
+    return len;
 }
 
 void byte_buffer_clear(pByteBuffer p){
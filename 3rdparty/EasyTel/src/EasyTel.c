@@ -8,21 +8,22 @@ static bool EsayTel_obj_write(EasyTelPoint *etp, const struct EasyTelMessage *ms
 static void EasyTelRevInnerCallback(EasyTelPoint *etp, struct EasyTelMessage *msg);
 static void EasyTelAckInnerCallback(EasyTelPoint *etp, struct EasyTelMessage *msg);
 uint32_t EsayTel_obj_write_prepare(EasyTelPoint *etp, const struct EasyTelMessage *msg);
+static void EasyTel_window_recv(EasyTelPoint *etp, uint16_t src, uint16_t seq, uint8_t type, const uint8_t *data, uint16_t len);
+static void EasyTel_window_process(EasyTelPoint *etp);
 
-#define SIMPLE_DPP_REV_BUFFER_SIZE 512
-#define SIMPLE_DPP_SEND_BUFFER_SIZE 512
-static __implemented sdp_byte __send_data[SIMPLE_DPP_SEND_BUFFER_SIZE];
-static __implemented sdp_byte __recv_data[SIMPLE_DPP_REV_BUFFER_SIZE];
+// EasyTel_obj_create分配的端点
+static EasyTelPoint __etp_pool[ETP_POINT_MAX];
+static bool __etp_pool_used[ETP_POINT_MAX];
 
 static uint16_t EasyTel_obj_get_msg_crc(struct EasyTelMessage *msg)
 {
-    msg->crc = CRC16_Modbus_start();
-    msg->crc = CRC16_Modbus_update(msg->crc, (const uint8_t *)&msg->src, sizeof(msg->src));
-    msg->crc = CRC16_Modbus_update(msg->crc, (const uint8_t *)&msg->dst, sizeof(msg->dst));
-    msg->crc = CRC16_Modbus_update(msg->crc, (const uint8_t *)&msg->seq, sizeof(msg->seq));
-    msg->crc = CRC16_Modbus_update(msg->crc, (const uint8_t *)&msg->type, sizeof(msg->type));
-    msg->crc = CRC16_Modbus_update(msg->crc, (const uint8_t *)&msg->len, sizeof(msg->len));
-    msg->crc = CRC16_Modbus_update(msg->crc, (const uint8_t *)msg->data, msg->len);
+    msg->crc = CRC16_MODBUS_INIT;
+    msg->crc = CRC16_Modbus_Update(msg->crc, (const uint8_t *)&msg->src, sizeof(msg->src));
+    msg->crc = CRC16_Modbus_Update(msg->crc, (const uint8_t *)&msg->dst, sizeof(msg->dst));
+    msg->crc = CRC16_Modbus_Update(msg->crc, (const uint8_t *)&msg->seq, sizeof(msg->seq));
+    msg->crc = CRC16_Modbus_Update(msg->crc, (const uint8_t *)&msg->type, sizeof(msg->type));
+    msg->crc = CRC16_Modbus_Update(msg->crc, (const uint8_t *)&msg->len, sizeof(msg->len));
+    msg->crc = CRC16_Modbus_Update(msg->crc, (const uint8_t *)msg->data, msg->len);
     return msg->crc;
 }
 
@@ -33,6 +34,10 @@ static __implemented void SimpleDPPRecvCallback(void *obj, const sdp_byte *data,
     EasyTelPoint *etp = (EasyTelPoint *)sdp->obj;
 
     // 1. CRC 校验
+    if (len < ETP_FRAME_HEAD_SIZE + ETP_FRAME_CRC_SIZE)
+    {
+        return;
+    }
     uint16_t crc = CRC16_Modbus(data, len - 2);
     uint16_t crc_recv = data[len - 2] | (data[len - 1] << 8);
     if (crc != crc_recv)
@@ -48,7 +53,21 @@ static __implemented void SimpleDPPRecvCallback(void *obj, const sdp_byte *data,
     uint16_t data_len = data[7] | (data[8] << 8);
     uint8_t *data_ptr = (uint8_t *)&data[9];
 
-    if (data_len > etp->curr_rev_msg.capacity)
+    if (data_len != len - ETP_FRAME_HEAD_SIZE - ETP_FRAME_CRC_SIZE)
+    {
+        return;
+    }
+    // 消息的数据不复制，CRC已经校验过，把它的位置改成0用于字符串化。帧在SimpleDPP的接收缓冲区中，可以改写
+    ((uint8_t *)data)[ETP_FRAME_HEAD_SIZE + data_len] = '\0';
+    if (type == ETP_MSG_TYPE_WIN_DATA || type == ETP_MSG_TYPE_WIN_ACK)
+    {
+        if (dst == etp->addr)
+        {
+            EasyTel_window_recv(etp, src, seq, type, data_ptr, data_len);
+        }
+        return;
+    }
+    if (data_len > ETP_RECV_MSG_CAPACITY)
     {
         return;
     }
@@ -58,9 +77,9 @@ static __implemented void SimpleDPPRecvCallback(void *obj, const sdp_byte *data,
     etp->curr_rev_msg.seq = seq;
     etp->curr_rev_msg.type = type;
     etp->curr_rev_msg.len = data_len;
-    memcpy(etp->curr_rev_msg.data, data_ptr, data_len);
+    etp->curr_rev_msg.data = data_ptr;
+    etp->curr_rev_msg.capacity = data_len;
     etp->curr_rev_msg.crc = crc_recv;
-    etp->curr_rev_msg.data[data_len] = '\0';
 
     // 3. 地址过滤
     if (dst == 0xFFFF)
@@ -150,87 +169,83 @@ static void EasyTelAckInnerCallback(EasyTelPoint *etp, struct EasyTelMessage *ms
     }
 }
 
+/**
+ * @brief 在使用者提供的对象（通常是静态变量）上初始化端点，不使用动态内存。
+ *
+ * @param etp
+ * @param adapter 内容会被复制，可以是局部变量。
+ * @param addr 本机地址。
+ */
+void EasyTel_obj_init(EasyTelPoint *etp, const EasyTelPointAdapter_t *adapter, uint16_t addr)
+{
+    SimpleDPPAdapter_t *sdp_adapter = &etp->sdp_adapter;
+
+    memset(etp, 0, sizeof(EasyTelPoint));
+    sdp_adapter->lock = adapter->lock;
+    sdp_adapter->unlock = adapter->unlock;
+    sdp_adapter->write = adapter->write;
+    sdp_adapter->read = adapter->read;
+    sdp_adapter->error = adapter->error;
+    sdp_adapter->debug = adapter->debug;
+    sdp_adapter->write_buf = etp->sdp_send_buf;
+    sdp_adapter->write_buf_capacity = sizeof(etp->sdp_send_buf);
+    sdp_adapter->read_buf = etp->sdp_recv_buf;
+    sdp_adapter->read_buf_capacity = sizeof(etp->sdp_recv_buf);
+    sdp_adapter->SimpleDPPRecvCallback = SimpleDPPRecvCallback;
+    sdp_adapter->SimpleDPPRevErrorCallback = SimpleDPPRevErrorCallback;
+    SimpleDPP_Constructor(&etp->sdp, sdp_adapter);
+
+    etp->sdp.obj = etp;
+    etp->seq = 0;
+    etp->addr = addr;
+    etp->write_result = ETP_WRITE_RESULT_NONE;
+    etp->is_writing = false;
+    etp->rev_callback = NULL;
+    etp->have_write_task = false;
+    etp->write_start_time = 0;
+    etp->write_timeout = ETP_WRITE_TIMEOUT;
+    etp->retry_times = 0;
+    etp->retry_times_max = ETP_RETRY_TIMES_MAX;
+    etp->win_timeout = ETP_WINDOW_TIMEOUT;
+
+    // 收到的消息指向SimpleDPP的接收缓冲区，在收到时设置
+    etp->curr_rev_msg.data = NULL;
+    etp->curr_rev_msg.capacity = 0;
+    etp->curr_send_msg.data = etp->send_data;
+    etp->curr_send_msg.capacity = ETP_SEND_MSG_CAPACITY;
+    etp->curr_ack_msg.data = etp->ack_data;
+    etp->curr_ack_msg.capacity = ETP_SEND_MSG_CAPACITY;
+    etp->curr_rev_ack_msg.data = etp->rev_ack_data;
+    etp->curr_rev_ack_msg.capacity = ETP_RECV_MSG_CAPACITY;
+}
+
+/**
+ * @brief 从静态的ETP_POINT_MAX个端点中分配一个并初始化。
+ *
+ * @return EasyTelPoint* 没有空闲的端点时返回NULL。
+ */
 EasyTelPoint *EasyTel_obj_create(const EasyTelPointAdapter_t *adapter, uint16_t addr)
 {
-    EasyTelPoint *etp = NULL;
-    etp = (EasyTelPoint *)sdp_core_malloc(sizeof(EasyTelPoint));
-    if (etp != NULL)
+    for (int i = 0; i < ETP_POINT_MAX; i++)
     {
-        memset(etp, 0, sizeof(EasyTelPoint));
-        SimpleDPPAdapter_t *sdp_adapter = (SimpleDPPAdapter_t *)sdp_core_malloc(sizeof(SimpleDPPAdapter_t));
-        if (sdp_adapter == NULL)
+        if (!__etp_pool_used[i])
         {
-            EasyTel_obj_destroy(etp);
-            etp = NULL;
-            return etp;
-        }
-        memset(sdp_adapter, 0, sizeof(SimpleDPPAdapter_t));
-        sdp_adapter->lock = adapter->lock;
-        sdp_adapter->unlock = adapter->unlock;
-        sdp_adapter->write = adapter->write;
-        sdp_adapter->read = adapter->read;
-        sdp_adapter->error = adapter->error;
-        sdp_adapter->debug = adapter->debug;
-        sdp_adapter->write_buf = __send_data;
-        sdp_adapter->write_buf_capacity = SIMPLE_DPP_SEND_BUFFER_SIZE;
-        sdp_adapter->read_buf = __recv_data;
-        sdp_adapter->read_buf_capacity = SIMPLE_DPP_REV_BUFFER_SIZE;
-        sdp_adapter->SimpleDPPRecvCallback = SimpleDPPRecvCallback;
-        sdp_adapter->SimpleDPPRevErrorCallback = SimpleDPPRevErrorCallback;
-        SimpleDPP_Constructor(&etp->sdp, sdp_adapter);
-
-        etp->sdp.obj = etp;
-        etp->seq = 0;
-        etp->addr = addr;
-        etp->write_result = ETP_WRITE_RESULT_NONE;
-        etp->is_writing = false;
-        etp->rev_callback = NULL;
-        etp->have_write_task = false;
-        etp->write_start_time = 0;
-        etp->write_timeout = ETP_WRITE_TIMEOUT;
-        etp->retry_times = 0;
-        etp->retry_times_max = ETP_RETRY_TIMES_MAX;
-
-        etp->curr_rev_msg.data = (uint8_t *)sdp_core_malloc(ETP_RECV_MSG_CAPACITY + 1);
-        etp->curr_rev_msg.capacity = ETP_RECV_MSG_CAPACITY;
-        etp->curr_send_msg.data = (uint8_t *)sdp_core_malloc(ETP_SEND_MSG_CAPACITY + 1);
-        etp->curr_send_msg.capacity = ETP_SEND_MSG_CAPACITY;
-
-        etp->curr_ack_msg.data = (uint8_t *)sdp_core_malloc(ETP_SEND_MSG_CAPACITY + 1);
-        etp->curr_ack_msg.capacity = ETP_SEND_MSG_CAPACITY;
-        etp->curr_rev_ack_msg.data = (uint8_t *)sdp_core_malloc(ETP_SEND_MSG_CAPACITY + 1);
-        etp->curr_rev_ack_msg.capacity = ETP_SEND_MSG_CAPACITY;
-
-        if (etp->curr_rev_msg.data == NULL || etp->curr_send_msg.data == NULL)
-        {
-            EasyTel_obj_destroy(etp);
-            etp = NULL;
+            __etp_pool_used[i] = true;
+            EasyTel_obj_init(&__etp_pool[i], adapter, addr);
+            return &__etp_pool[i];
         }
     }
-    return etp;
+    return NULL;
 }
 
 void EasyTel_obj_destroy(EasyTelPoint *etp)
 {
-    if (etp != NULL)
+    for (int i = 0; i < ETP_POINT_MAX; i++)
     {
-        if (etp->curr_rev_msg.data != NULL)
-        {
-            sdp_core_free(etp->curr_rev_msg.data);
-            etp->curr_rev_msg.data = NULL;
-        }
-        if (etp->curr_send_msg.data != NULL)
-        {
-            sdp_core_free(etp->curr_send_msg.data);
-            etp->curr_send_msg.data = NULL;
-        }
-        if (etp->sdp.adapter != NULL)
+        if (etp == &__etp_pool[i])
         {
-            sdp_core_free(etp->sdp.adapter);
-            etp->sdp.adapter = NULL;
+            __etp_pool_used[i] = false;
         }
-        sdp_core_free(etp);
-        etp = NULL;
     }
 }
 
@@ -276,6 +291,7 @@ void EasyTel_obj_process(EasyTelPoint *etp)
 {
     uint32_t curr_time = SimpleDPP_getMsTick();
     SimpeDPP_poll(&etp->sdp);
+    EasyTel_window_process(etp);
 
     if (etp->have_write_task)
     {
@@ -383,6 +399,373 @@ uint32_t EasyTel_obj_ack_msg_push(EasyTelPoint *etp, const void *data, uint32_t
     return ret;
 }
 
+/**
+ * @brief 打开窗口模式。窗口模式的消息可以同时有count条没有确认，对方回复累计确认和之后32条消息的选择确认。
+ * 每条消息超时或者后发的消息先确认时单独重发，确认或者重发次数用完后调用各自的回调。
+ * 收到的消息按到达的顺序交给rev_callback，丢失重发的消息可能晚于后面的消息，msg->seq是发送的序号。
+ *
+ * @param etp
+ * @param slots 保存没有确认的消息，由使用者提供（通常是静态数组），关闭前不能释放。
+ * @param count 窗口大小，不能超过ETP_WINDOW_SIZE_MAX。
+ * @return true 成功。
+ * @return false 参数错误。
+ */
+bool EasyTel_obj_window_init(EasyTelPoint *etp, EasyTelWindowSlot_t *slots, uint16_t count)
+{
+    if (slots == NULL || count == 0 || count > ETP_WINDOW_SIZE_MAX)
+    {
+        return false;
+    }
+    memset(slots, 0, sizeof(EasyTelWindowSlot_t) * count);
+    memset(etp->win_peers, 0, sizeof(etp->win_peers));
+    memset(&etp->win_stat, 0, sizeof(etp->win_stat));
+    etp->win_slots = slots;
+    etp->win_size = count;
+    etp->win_order = 0;
+    return true;
+}
+
+static EasyTelWindowPeer_t *EasyTel_window_peer(EasyTelPoint *etp, uint16_t addr, bool create)
+{
+    EasyTelWindowPeer_t *free_peer = NULL;
+    for (int i = 0; i < ETP_WINDOW_PEER_MAX; i++)
+    {
+        EasyTelWindowPeer_t *peer = &etp->win_peers[i];
+        if (peer->used && peer->addr == addr)
+        {
+            return peer;
+        }
+        if (!peer->used && free_peer == NULL)
+        {
+            free_peer = peer;
+        }
+    }
+    if (create && free_peer != NULL)
+    {
+        memset(free_peer, 0, sizeof(EasyTelWindowPeer_t));
+        free_peer->used = true;
+        free_peer->addr = addr;
+    }
+    return create ? free_peer : NULL;
+}
+
+/**
+ * @brief 发给peer的消息中最早没有确认的序号，没有时是下一条消息的序号。
+ *
+ */
+static uint16_t EasyTel_window_base(EasyTelPoint *etp, EasyTelWindowPeer_t *peer)
+{
+    uint16_t base = peer->snd_next;
+    for (int i = 0; i < etp->win_size; i++)
+    {
+        EasyTelWindowSlot_t *slot = &etp->win_slots[i];
+        if (slot->used && slot->msg.dst == peer->addr && (int16_t)(slot->msg.seq - base) < 0)
+        {
+            base = slot->msg.seq;
+        }
+    }
+    return base;
+}
+
+/**
+ * @brief 还可以发给dst多少条窗口模式的消息。
+ *
+ */
+uint16_t EasyTel_obj_window_free(EasyTelPoint *etp, uint16_t dst)
+{
+    uint16_t used = 0;
+    uint16_t span = 0;
+    EasyTelWindowPeer_t *peer = EasyTel_window_peer(etp, dst, false);
+
+    if (etp->win_slots == NULL)
+    {
+        return 0;
+    }
+    for (int i = 0; i < etp->win_size; i++)
+    {
+        used += etp->win_slots[i].used ? 1 : 0;
+    }
+    if (peer != NULL)
+    {
+        // 最早没有确认的消息和下一条消息的序号差不能超过窗口，否则对方的选择确认放不下
+        span = (uint16_t)(peer->snd_next - EasyTel_window_base(etp, peer));
+    }
+    used = used > span ? used : span;
+    return etp->win_size - used;
+}
+
+/**
+ * @brief 窗口模式发送一条消息，消息复制到窗口中，在EasyTel_obj_process中发送。
+ *
+ * @param etp
+ * @param dst 不能是广播地址。
+ * @param data
+ * @param len 不能超过ETP_SEND_MSG_CAPACITY。
+ * @param callback 确认或者重发次数用完后调用，可以为NULL。
+ * @param arg 传给callback。
+ * @return true 已经加入窗口。
+ * @return false 窗口已满或者参数错误。
+ */
+bool EasyTel_obj_window_send(EasyTelPoint *etp, uint16_t dst, const void *data, uint32_t len, EasyTelSendCallback_t callback, void *arg)
+{
+    EasyTelWindowSlot_t *slot = NULL;
+    EasyTelWindowPeer_t *peer;
+
+    if (dst == 0xFFFF || len > ETP_SEND_MSG_CAPACITY || EasyTel_obj_window_free(etp, dst) == 0)
+    {
+        return false;
+    }
+    peer = EasyTel_window_peer(etp, dst, true);
+    if (peer == NULL)
+    {
+        return false;
+    }
+    for (int i = 0; i < etp->win_size; i++)
+    {
+        if (!etp->win_slots[i].used)
+        {
+            slot = &etp->win_slots[i];
+            break;
+        }
+    }
+    slot->msg.src = etp->addr;
+    slot->msg.dst = dst;
+    slot->msg.seq = peer->snd_next++;
+    slot->msg.type = ETP_MSG_TYPE_WIN_DATA;
+    slot->msg.data = slot->data;
+    slot->msg.len = (uint16_t)(len + 2);
+    slot->msg.capacity = sizeof(slot->data);
+    memcpy(&slot->data[2], data, len);
+    slot->used = true;
+    slot->need_send = true;
+    slot->order = etp->win_order++;
+    slot->retry_times = 0;
+    slot->callback = callback;
+    slot->arg = arg;
+    return true;
+}
+
+static void EasyTel_window_complete(EasyTelPoint *etp, EasyTelWindowSlot_t *slot, uint16_t result)
+{
+    slot->used = false;
+    if (result == ETP_WRITE_RESULT_OK)
+    {
+        etp->win_stat.completed++;
+    }
+    else
+    {
+        etp->win_stat.timeouts++;
+    }
+    if (slot->callback != NULL)
+    {
+        slot->callback(etp, slot->msg.dst, slot->msg.seq, result, slot->arg);
+    }
+}
+
+/**
+ * @brief 重发一条消息，重发次数用完时结束。
+ *
+ */
+static void EasyTel_window_resend(EasyTelPoint *etp, EasyTelWindowSlot_t *slot)
+{
+    if (slot->retry_times < etp->retry_times_max)
+    {
+        slot->retry_times++;
+        slot->need_send = true;
+        slot->order = etp->win_order++;
+        etp->win_stat.retransmits++;
+    }
+    else
+    {
+        EasyTel_window_complete(etp, slot, ETP_WRITE_RESULT_TIMEOUT);
+    }
+}
+
+/**
+ * @brief 收到rcv_next，窗口向后移动到下一条没有收到的消息。
+ *
+ */
+static void EasyTel_window_rcv_advance(EasyTelWindowPeer_t *peer)
+{
+    peer->rcv_next++;
+    while (peer->rcv_mask & 1)
+    {
+        peer->rcv_mask >>= 1;
+        peer->rcv_next++;
+    }
+    peer->rcv_mask >>= 1;
+}
+
+static void EasyTel_window_recv(EasyTelPoint *etp, uint16_t src, uint16_t seq, uint8_t type, const uint8_t *data, uint16_t len)
+{
+    EasyTelWindowPeer_t *peer = EasyTel_window_peer(etp, src, type == ETP_MSG_TYPE_WIN_DATA);
+    int16_t diff;
+
+    if (peer == NULL)
+    {
+        return;
+    }
+    if (type == ETP_MSG_TYPE_WIN_ACK)
+    {
+        // seq是累计确认，数据是之后32条消息的选择确认
+        uint32_t mask;
+        uint32_t acked_order = 0;
+        bool acked = false;
+        if (len != 4 || etp->win_slots == NULL || (int16_t)(seq - peer->snd_next) > 0)
+        {
+            return;
+        }
+        mask = data[0] | (data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+        for (int i = 0; i < etp->win_size; i++)
+        {
+            EasyTelWindowSlot_t *slot = &etp->win_slots[i];
+            if (!slot->used || slot->msg.dst != src || slot->need_send)
+            {
+                continue;
+            }
+            diff = (int16_t)(slot->msg.seq - seq);
+            if (diff < 0 || (diff >= 1 && diff <= 32 && (mask & (1UL << (diff - 1)))))
+            {
+                if (!acked || (int32_t)(slot->order - acked_order) > 0)
+                {
+                    acked_order = slot->order;
+                    acked = true;
+                }
+                EasyTel_window_complete(etp, slot, ETP_WRITE_RESULT_OK);
+            }
+        }
+        // 总线上的帧按顺序到达，比确认了的消息先发出却没有确认的消息已经丢了，不等超时立即重发
+        for (int i = 0; acked && i < etp->win_size; i++)
+        {
+            EasyTelWindowSlot_t *slot = &etp->win_slots[i];
+            if (slot->used && slot->msg.dst == src && !slot->need_send && (int32_t)(slot->order - acked_order) < 0)
+            {
+                EasyTel_window_resend(etp, slot);
+            }
+        }
+        return;
+    }
+
+    if (len < 2 || len - 2 > ETP_RECV_MSG_CAPACITY)
+    {
+        return;
+    }
+    // 对方最早没有确认的消息之前的消息已经确认或者放弃了，窗口至少移动到这里
+    uint16_t base = data[0] | (data[1] << 8);
+    if (!peer->rcv_synced || (int16_t)(base - peer->rcv_next) > 32)
+    {
+        peer->rcv_synced = true;
+        peer->rcv_next = base;
+        peer->rcv_mask = 0;
+    }
+    while ((int16_t)(base - peer->rcv_next) > 0)
+    {
+        EasyTel_window_rcv_advance(peer);
+    }
+    peer->ack_pending = true;
+
+    diff = (int16_t)(seq - peer->rcv_next);
+    if (diff < 0 || (diff >= 1 && diff <= 32 && (peer->rcv_mask & (1UL << (diff - 1)))))
+    {
+        etp->win_stat.recv_dups++;
+        return;
+    }
+    if (diff > 32)
+    {
+        return;
+    }
+    if (diff == 0)
+    {
+        EasyTel_window_rcv_advance(peer);
+    }
+    else
+    {
+        peer->rcv_mask |= 1UL << (diff - 1);
+    }
+
+    etp->curr_rev_msg.src = src;
+    etp->curr_rev_msg.dst = etp->addr;
+    etp->curr_rev_msg.seq = seq;
+    etp->curr_rev_msg.type = type;
+    etp->curr_rev_msg.len = len - 2;
+    etp->curr_rev_msg.data = (uint8_t *)&data[2];
+    etp->curr_rev_msg.capacity = len - 2;
+    etp->win_stat.recv_msgs++;
+    EasyTelRevInnerCallback(etp, &etp->curr_rev_msg);
+}
+
+/**
+ * @brief 回复确认，处理超时，按加入的顺序发送新的和要重发的消息。
+ *
+ */
+static void EasyTel_window_process(EasyTelPoint *etp)
+{
+    uint32_t now = SimpleDPP_getMsTick();
+    EasyTelWindowSlot_t *next;
+
+    for (int i = 0; i < ETP_WINDOW_PEER_MAX; i++)
+    {
+        EasyTelWindowPeer_t *peer = &etp->win_peers[i];
+        if (peer->used && peer->ack_pending)
+        {
+            struct EasyTelMessage ack;
+            uint8_t mask[4];
+            mask[0] = (uint8_t)peer->rcv_mask;
+            mask[1] = (uint8_t)(peer->rcv_mask >> 8);
+            mask[2] = (uint8_t)(peer->rcv_mask >> 16);
+            mask[3] = (uint8_t)(peer->rcv_mask >> 24);
+            ack.src = etp->addr;
+            ack.dst = peer->addr;
+            ack.seq = peer->rcv_next;
+            ack.type = ETP_MSG_TYPE_WIN_ACK;
+            ack.data = mask;
+            ack.len = sizeof(mask);
+            ack.capacity = sizeof(mask);
+            EasyTel_obj_get_msg_crc(&ack);
+            EsayTel_obj_write(etp, &ack);
+            peer->ack_pending = false;
+            etp->win_stat.ack_frames++;
+        }
+    }
+
+    if (etp->win_slots == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < etp->win_size; i++)
+    {
+        EasyTelWindowSlot_t *slot = &etp->win_slots[i];
+        if (slot->used && !slot->need_send && now - slot->send_time > etp->win_timeout)
+        {
+            // 只重发超时的这一条
+            EasyTel_window_resend(etp, slot);
+        }
+    }
+    do
+    {
+        next = NULL;
+        for (int i = 0; i < etp->win_size; i++)
+        {
+            EasyTelWindowSlot_t *slot = &etp->win_slots[i];
+            if (slot->used && slot->need_send && (next == NULL || (int32_t)(slot->order - next->order) < 0))
+            {
+                next = slot;
+            }
+        }
+        if (next != NULL)
+        {
+            uint16_t base = EasyTel_window_base(etp, EasyTel_window_peer(etp, next->msg.dst, false));
+            next->data[0] = (uint8_t)base;
+            next->data[1] = (uint8_t)(base >> 8);
+            EasyTel_obj_get_msg_crc(&next->msg);
+            EsayTel_obj_write(etp, &next->msg);
+            next->need_send = false;
+            next->send_time = now;
+            etp->win_stat.data_frames++;
+        }
+    } while (next != NULL);
+}
+
 __attribute__((weak)) uint32_t EsayTel_obj_write_prepare(EasyTelPoint *etp, const struct EasyTelMessage *msg)
 {
     return 0;
@@ -0,0 +1,378 @@
+/**
+ * @file EasyTel_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief EasyTel窗口模式的测试：两个端点接在一条仿真的RS485总线上（半双工，帧按顺序占用总线，
+ * 115200bps），按比例损坏帧中的一个字节。检查每条消息只交给接收方一次、内容正确，确认过的消息一定收到了，
+ * 然后比较不同窗口大小和丢帧率下的有效吞吐量，以及原来一问一答的EasyTel_obj_send（回复带数据）。
+ * 端点分别用EasyTel_obj_init（静态对象）和EasyTel_obj_create（静态池）创建，检查没有使用动态内存，
+ * 收到的消息指向接收缓冲区并且以0结尾。
+ * 两个端点每5ms处理一次收发，和目标板上由调度器调用的情况相同。
+ * 时间使用虚拟时钟，编译时定义SIMPLEDPP_SIMULATION，目标板上也可以运行。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "EasyTel_test.h"
+#include "SimpleDPP_port.h"
+#include "log.h"
+
+#ifdef SIMPLEDPP_SIMULATION
+#define ADDR_A      0x0001
+#define ADDR_B      0x0002
+#define BAUDRATE    115200
+#define BYTE_NS     (10ULL * 1000000000ULL / BAUDRATE)
+#define STEP_US     100ULL
+// 目标板上EasyTel_obj_process由调度器周期调用，两个端点错开半个周期
+#define POLL_US     5000ULL
+#define MSG_COUNT   300
+#define MSG_LEN     100
+#define FRAME_MAX   320
+#define RX_FRAMES   64
+// 一次仿真最长的虚拟时间
+#define RUN_MAX_MS  600000ULL
+
+typedef struct {
+    uint8_t data[FRAME_MAX];
+    uint16_t len;
+    uint16_t pos;      // 已经读走的字节数
+    uint64_t startNs;  // 第一个字节开始发送的时间
+} RxFrame_t;
+
+typedef struct {
+    RxFrame_t frames[RX_FRAMES];
+    uint32_t head;
+    uint32_t tail;
+} RxQueue_t;
+
+static RxQueue_t _gRx[2]; // 0：A收到的，1：B收到的
+static uint64_t _gNowNs     = 0;
+static uint64_t _gBusFreeNs = 0;
+static uint64_t _gBusBusyNs = 0;
+static uint32_t _gLossPpm   = 0;
+static uint32_t _gRng       = 0x2468ACE1UL;
+static uint32_t _gErrorCnt  = 0;
+
+static EasyTelPoint _gPointA;
+static EasyTelPoint _gPointB;
+static EasyTelWindowSlot_t _gSlotsA[ETP_WINDOW_SIZE_MAX];
+static EasyTelWindowSlot_t _gSlotsB[ETP_WINDOW_SIZE_MAX];
+// 每条消息收到的次数和发送完成的结果
+static uint8_t _gRecvCnt[MSG_COUNT];
+static uint16_t _gResult[MSG_COUNT];
+static uint32_t _gCorrupt = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[EasyTel Test] check failed: %s", what);
+    }
+}
+
+static uint32_t rng()
+{
+    _gRng ^= _gRng << 13;
+    _gRng ^= _gRng >> 17;
+    _gRng ^= _gRng << 5;
+    return _gRng;
+}
+
+/**
+ * @brief 一个端点写入的帧排在总线上，按比例损坏其中一个字节。
+ *
+ */
+static void bus_write(RxQueue_t *rx, const void *buf, unsigned int len)
+{
+    RxFrame_t *frame;
+    if (len > FRAME_MAX || rx->tail - rx->head >= RX_FRAMES) {
+        check(false, "rx queue overflow");
+        return;
+    }
+    frame = &rx->frames[rx->tail % RX_FRAMES];
+    memcpy(frame->data, buf, len);
+    frame->len     = (uint16_t)len;
+    frame->pos     = 0;
+    frame->startNs = _gNowNs > _gBusFreeNs ? _gNowNs : _gBusFreeNs;
+    _gBusFreeNs    = frame->startNs + len * BYTE_NS;
+    _gBusBusyNs += len * BYTE_NS;
+    if (rng() % 1000000UL < _gLossPpm) {
+        frame->data[rng() % len] ^= (uint8_t)(1 + rng() % 255);
+        _gCorrupt++;
+    }
+    rx->tail++;
+}
+
+static unsigned int bus_read(RxQueue_t *rx, void *buf, unsigned int len)
+{
+    unsigned int n = 0;
+    while (n < len && rx->head != rx->tail) {
+        RxFrame_t *frame = &rx->frames[rx->head % RX_FRAMES];
+        uint64_t arrived = _gNowNs < frame->startNs ? 0 : (_gNowNs - frame->startNs) / BYTE_NS;
+        uint32_t avail   = arrived > frame->len ? frame->len : (uint32_t)arrived;
+        uint32_t copy    = avail - frame->pos;
+        copy             = copy > len - n ? len - n : copy;
+        memcpy((uint8_t *)buf + n, &frame->data[frame->pos], copy);
+        frame->pos += copy;
+        n += copy;
+        if (frame->pos < frame->len) {
+            break;
+        }
+        rx->head++;
+    }
+    return n;
+}
+
+static unsigned int write_a(const void *buf, unsigned int len)
+{
+    bus_write(&_gRx[1], buf, len);
+    return len;
+}
+
+static unsigned int write_b(const void *buf, unsigned int len)
+{
+    bus_write(&_gRx[0], buf, len);
+    return len;
+}
+
+static unsigned int read_a(void *buf, unsigned int len)
+{
+    return bus_read(&_gRx[0], buf, len);
+}
+
+static unsigned int read_b(void *buf, unsigned int len)
+{
+    return bus_read(&_gRx[1], buf, len);
+}
+
+static void make_msg(uint8_t *buf, uint32_t id)
+{
+    for (uint32_t i = 0; i < MSG_LEN; i++) {
+        buf[i] = (uint8_t)(id * 31U + i * 7U);
+    }
+    buf[0] = (uint8_t)id;
+    buf[1] = (uint8_t)(id >> 8);
+}
+
+static void b_rev_callback(EasyTelPoint *etp, struct EasyTelMessage *msg)
+{
+    uint8_t expect[MSG_LEN];
+    uint32_t id;
+
+    if (msg->len != MSG_LEN || msg->capacity != MSG_LEN || msg->data[msg->len] != '\0') {
+        check(false, "received length");
+        return;
+    }
+    id = msg->data[0] | (msg->data[1] << 8);
+    make_msg(expect, id);
+    check(id < MSG_COUNT && memcmp(expect, msg->data, MSG_LEN) == 0, "received content");
+    if (id < MSG_COUNT) {
+        _gRecvCnt[id]++;
+    }
+}
+
+// 一问一答时B的回复
+static void b_ack_callback(EasyTelPoint *etp, struct EasyTelMessage *msg)
+{
+    char text[16];
+    int len = snprintf(text, sizeof(text), "ack %u", (unsigned)(msg->data[0] | (msg->data[1] << 8)));
+    EasyTel_obj_ack_msg_push(etp, text, (uint32_t)len);
+}
+
+static void a_send_callback(EasyTelPoint *etp, uint16_t dst, uint16_t seq, uint16_t result, void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    check(_gResult[id] == ETP_WRITE_RESULT_NONE, "one completion per message");
+    _gResult[id] = result;
+}
+
+static void sim_reset(uint32_t lossPpm)
+{
+    memset(_gRx, 0, sizeof(_gRx));
+    memset(_gRecvCnt, 0, sizeof(_gRecvCnt));
+    for (int i = 0; i < MSG_COUNT; i++) {
+        _gResult[i] = ETP_WRITE_RESULT_NONE;
+    }
+    _gNowNs      = 0;
+    _gBusFreeNs  = 0;
+    _gBusBusyNs  = 0;
+    _gCorrupt    = 0;
+    _gLossPpm    = lossPpm;
+    sdp_sim_tick = 0;
+}
+
+/**
+ * @brief 推进到A的下一次处理，B在两次之间处理一次。
+ *
+ */
+static void sim_step(EasyTelPoint *a, EasyTelPoint *b)
+{
+    do {
+        _gNowNs += STEP_US * 1000ULL;
+        sdp_sim_tick = (uint32_t)(_gNowNs / 1000000ULL);
+        if (_gNowNs % (POLL_US * 1000ULL) == POLL_US * 500ULL) {
+            EasyTel_obj_process(b);
+        }
+    } while (_gNowNs % (POLL_US * 1000ULL) != 0);
+    EasyTel_obj_process(a);
+}
+
+static void create_points(EasyTelPoint **pA, EasyTelPoint **pB)
+{
+    EasyTelPointAdapter_t adapterA = {0};
+    EasyTelPointAdapter_t adapterB = {0};
+    adapterA.write                 = write_a;
+    adapterA.read                  = read_a;
+    adapterB.write                 = write_b;
+    adapterB.read                  = read_b;
+    *pA                            = EasyTel_obj_create(&adapterA, ADDR_A);
+    *pB                            = EasyTel_obj_create(&adapterB, ADDR_B);
+    check(*pA != NULL && *pB != NULL, "create points");
+    check(ETP_POINT_MAX != 2 || EasyTel_obj_create(&adapterB, ADDR_B) == NULL, "static pool exhausted");
+    EasyTel_obj_set_rev_callback(*pB, b_rev_callback);
+}
+
+/**
+ * @brief 窗口模式发送MSG_COUNT条消息，返回有效吞吐量（B/s），结果在_gRecvCnt和_gResult中。
+ *
+ */
+static double run_window(uint16_t window, uint32_t lossPpm, EasyTelWindowStat_t *pStat)
+{
+    EasyTelPoint *a, *b;
+    uint8_t msg[MSG_LEN];
+    uint32_t next = 0;
+    uint32_t done = 0;
+    uint32_t delivered = 0;
+
+    sim_reset(lossPpm);
+    create_points(&a, &b);
+    if (a == NULL || b == NULL) {
+        return 0;
+    }
+    check(EasyTel_obj_window_init(a, _gSlotsA, window), "window init a");
+    check(EasyTel_obj_window_init(b, _gSlotsB, window), "window init b");
+    check(!EasyTel_obj_window_init(a, _gSlotsA, ETP_WINDOW_SIZE_MAX + 1), "window too large");
+
+    while (done < MSG_COUNT && _gNowNs < RUN_MAX_MS * 1000000ULL) {
+        while (next < MSG_COUNT && EasyTel_obj_window_free(a, ADDR_B) > 0) {
+            make_msg(msg, next);
+            check(EasyTel_obj_window_send(a, ADDR_B, msg, MSG_LEN, a_send_callback, (void *)(uintptr_t)next), "window send");
+            next++;
+        }
+        if (next < MSG_COUNT) {
+            check(!EasyTel_obj_window_send(a, ADDR_B, msg, MSG_LEN, NULL, NULL), "window full");
+        }
+        sim_step(a, b);
+        done = 0;
+        for (int i = 0; i < MSG_COUNT; i++) {
+            done += _gResult[i] != ETP_WRITE_RESULT_NONE ? 1 : 0;
+        }
+    }
+    for (int i = 0; i < MSG_COUNT; i++) {
+        delivered += _gRecvCnt[i] > 0 ? 1 : 0;
+        if (_gRecvCnt[i] > 1 || (_gResult[i] == ETP_WRITE_RESULT_OK && _gRecvCnt[i] != 1)) {
+            check(false, "delivered once when acknowledged");
+            break;
+        }
+    }
+    check(done == MSG_COUNT, "all messages completed");
+    *pStat = *EasyTel_obj_window_get_stat(a);
+    pStat->recv_msgs = EasyTel_obj_window_get_stat(b)->recv_msgs;
+    pStat->recv_dups = EasyTel_obj_window_get_stat(b)->recv_dups;
+    pStat->ack_frames = EasyTel_obj_window_get_stat(b)->ack_frames;
+    check(pStat->recv_msgs == delivered, "receiver stat");
+    EasyTel_obj_destroy(a);
+    EasyTel_obj_destroy(b);
+    return (double)delivered * MSG_LEN * 1e9 / (double)_gNowNs;
+}
+
+/**
+ * @brief 原来的一问一答：每条消息等到回复后再发下一条。
+ *
+ */
+static double run_legacy()
+{
+    EasyTelPointAdapter_t adapterA = {0};
+    EasyTelPointAdapter_t adapterB = {0};
+    EasyTelPoint *a = &_gPointA;
+    EasyTelPoint *b = &_gPointB;
+    uint8_t msg[MSG_LEN];
+    char expect[16];
+    uint32_t next = 0;
+    uint32_t delivered = 0;
+
+    sim_reset(0);
+    adapterA.write = write_a;
+    adapterA.read  = read_a;
+    adapterB.write = write_b;
+    adapterB.read  = read_b;
+    EasyTel_obj_init(a, &adapterA, ADDR_A);
+    EasyTel_obj_init(b, &adapterB, ADDR_B);
+    EasyTel_obj_set_rev_callback(b, b_rev_callback);
+    EasyTel_obj_set_ack_callback(b, b_ack_callback);
+    while (next < MSG_COUNT || !EasyTel_ctx_is_writeable(a)) {
+        if (EasyTel_obj_have_response(a)) {
+            snprintf(expect, sizeof(expect), "ack %u", (unsigned)(next - 1));
+            check(EasyTel_obj_get_result(a) == ETP_WRITE_RESULT_OK, "legacy response");
+            check(strcmp((const char *)a->curr_rev_ack_msg.data, expect) == 0, "legacy response data");
+            EasyTel_obj_make_writeable(a);
+        }
+        if (next < MSG_COUNT && EasyTel_ctx_is_writeable(a)) {
+            make_msg(msg, next);
+            check(EasyTel_obj_send(a, ADDR_B, msg, MSG_LEN), "legacy send");
+            next++;
+        }
+        sim_step(a, b);
+    }
+    for (int i = 0; i < MSG_COUNT; i++) {
+        delivered += _gRecvCnt[i];
+    }
+    check(delivered == MSG_COUNT, "legacy delivered");
+    return (double)delivered * MSG_LEN * 1e9 / (double)_gNowNs;
+}
+
+/**
+ * @brief EasyTel窗口模式的仿真测试，需要定义SIMPLEDPP_SIMULATION。
+ *
+ * @return uint32_t 错误数。
+ */
+uint32_t EasyTel_test()
+{
+    static const uint16_t windows[] = {1, 2, 4, 8, 16};
+    static const uint32_t losses[]  = {0, 20000, 100000};
+    const double line = BAUDRATE / 10.0;
+    EasyTelWindowStat_t stat = {0};
+    double goodput[sizeof(losses) / sizeof(losses[0])][sizeof(windows) / sizeof(windows[0])];
+    double legacy;
+
+    _gErrorCnt = 0;
+    _gRng      = 0x2468ACE1UL;
+    ULOG_INFO("[EasyTel Test] EasyTelPoint %u bytes, window slot %u bytes, all static", (unsigned)sizeof(EasyTelPoint),
+              (unsigned)sizeof(EasyTelWindowSlot_t));
+    // 帧数、重发、确认帧、重复收到、超时放弃、损坏的帧
+    legacy = run_legacy();
+    ULOG_INFO("[EasyTel Test] stop-and-wait EasyTel_obj_send: %.0f B/s (%.1f%% of line)", legacy, legacy * 100 / line);
+    for (uint32_t l = 0; l < sizeof(losses) / sizeof(losses[0]); l++) {
+        for (uint32_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+            goodput[l][w] = run_window(windows[w], losses[l], &stat);
+            ULOG_INFO("[EasyTel Test] loss %4.1f%% win %2u: %4.0f B/s %4.1f%%, frm %u rs %u ack %u dup %u to %u bad %u",
+                      losses[l] / 10000.0, windows[w], goodput[l][w], goodput[l][w] * 100 / line, stat.data_frames,
+                      stat.retransmits, stat.ack_frames, stat.recv_dups, stat.timeouts, _gCorrupt);
+            if (losses[l] == 0) {
+                check(stat.retransmits == 0 && stat.timeouts == 0 && stat.completed == MSG_COUNT, "no loss no resend");
+            }
+        }
+    }
+    // 窗口为1时和一问一答相当，窗口越大吞吐量越高
+    check(goodput[0][3] > legacy * 1.2, "window 8 faster than stop-and-wait");
+    check(goodput[0][3] > goodput[0][0] * 1.2, "window 8 faster than window 1");
+    check(goodput[2][3] > goodput[2][0] * 3, "window 8 faster than window 1 with loss");
+    check(sdp_max_used_memory() == 0, "no dynamic memory");
+    ULOG_INFO("[EasyTel Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
+#endif
@@ -1,9 +1,14 @@
 #include "SimpleDPP.h"
 #include "SimpleDPP_port.h"
+#include <string.h>
 static bool SimpleDPP_isTimeout(uint32_t start, uint32_t timeout);
 static void SimpleDPP_send_buffer(SimpleDPP *sdp);
 static void SimpleDPPRecvInnerCallback(SimpleDPP *sdp);
 static void SimpleDPPRevErrorInnerCallback(SimpleDPP *sdp, SimpleDPPERROR error_code);
+static int SimpleDPP_push_escaped(ByteBuffer *buf, const sdp_byte *data, int len);
+
+// 1 for the control bytes which must be escaped, used to find the clean runs
+static const uint8_t SimpleDPPCtrlByteTable[256] = {[SOH] = 1, [EOT] = 1, [ESC] = 1};
 
 // #define SimpleDPP_ESCAPE_CHAR_LEN 2
 // static char SimpleDPP_control_byte_buf[SimpleDPP_ESCAPE_CHAR_LEN] = {0};
@@ -26,12 +31,17 @@ static void SimpleDPP_send_buffer(SimpleDPP *sdp)
     }
 }
 
-static void SimpleDPPRecvInnerCallback(SimpleDPP *sdp)
+static void SimpleDPPRecvFrameInnerCallback(SimpleDPP *sdp, const sdp_byte *data, int len)
 {
     if (sdp->adapter->SimpleDPPRecvCallback != NULL)
     {
-        sdp->adapter->SimpleDPPRecvCallback(sdp, sdp->recv_buffer.data, sdp->recv_buffer.size);
+        sdp->adapter->SimpleDPPRecvCallback(sdp, data, len);
     }
+}
+
+static void SimpleDPPRecvInnerCallback(SimpleDPP *sdp)
+{
+    SimpleDPPRecvFrameInnerCallback(sdp, sdp->recv_buffer.data, sdp->recv_buffer.size);
     byte_buffer_clear(&sdp->recv_buffer);
 }
 
@@ -50,41 +60,73 @@ int getSimpleDPPErrorCnt(SimpleDPP *sdp)
     return sdp->SimpleDPPErrorCnt;
 }
 
-/*
-Return:
-    success: The number of bytes actually sent
-    fail: SIMPLEDPP_SENDFAILED
-*/
-int SimpleDPP_send(SimpleDPP *sdp, const sdp_byte *data, int len)
+/**
+ * @brief push data into buf, the control bytes are escaped with ESC.
+ * The clean runs between control bytes are copied with memcpy.
+ * @return success : the number of bytes in buf
+ * fail : SIMPLEDPP_SENDFAILED
+ */
+static int SimpleDPP_push_escaped(ByteBuffer *buf, const sdp_byte *data, int len)
 {
-    int i;
-    // 1. empty buffer
-    byte_buffer_clear(&sdp->send_buffer);
-    // 2. push SHO
-    byte_buffer_push(&sdp->send_buffer, SOH);
-    for (i = 0; i < len; i++)
+    const sdp_byte *end = data + len;
+    const sdp_byte *run;
+    int n;
+
+    while (data < end)
     {
-        // 3. push message body,when encounter SOH,EOT or ESC,using ESC escape it.
-        if (containSimpleDPPCtrolByte(data[i]))
+        run = data;
+        while (data < end && !SimpleDPPCtrlByteTable[*data])
         {
-            // escaped control byte only 2 bytes
-            if (byte_buffer_push(&sdp->send_buffer, ESC) == OVER_CAPACITY_ERROR)
-            {
-                return SIMPLEDPP_SENDFAILED;
-            }
-            if (byte_buffer_push(&sdp->send_buffer, data[i]) == OVER_CAPACITY_ERROR)
+            data++;
+        }
+        n = (int)(data - run);
+        if (buf->capacity - buf->size < n)
+        {
+            return SIMPLEDPP_SENDFAILED;
+        }
+        // 转义很多时普通字节的段很短，逐字节复制比调用memcpy快
+        if (n <= 8)
+        {
+            for (int i = 0; i < n; i++)
             {
-                return SIMPLEDPP_SENDFAILED;
+                buf->data[buf->size + i] = run[i];
             }
         }
         else
         {
-            if (byte_buffer_push(&sdp->send_buffer, data[i]) == OVER_CAPACITY_ERROR)
+            memcpy(&buf->data[buf->size], run, n);
+        }
+        buf->size += n;
+        if (data < end)
+        {
+            // escaped control byte only 2 bytes
+            if (buf->capacity - buf->size < 2)
             {
                 return SIMPLEDPP_SENDFAILED;
             }
+            buf->data[buf->size++] = ESC;
+            buf->data[buf->size++] = *data++;
         }
     }
+    return buf->size;
+}
+
+/*
+Return:
+    success: The number of bytes actually sent
+    fail: SIMPLEDPP_SENDFAILED
+*/
+int SimpleDPP_send(SimpleDPP *sdp, const sdp_byte *data, int len)
+{
+    // 1. empty buffer
+    byte_buffer_clear(&sdp->send_buffer);
+    // 2. push SHO
+    byte_buffer_push(&sdp->send_buffer, SOH);
+    // 3. push message body,when encounter SOH,EOT or ESC,using ESC escape it.
+    if (SimpleDPP_push_escaped(&sdp->send_buffer, data, len) == SIMPLEDPP_SENDFAILED)
+    {
+        return SIMPLEDPP_SENDFAILED;
+    }
     // 4. push EOT
     if (byte_buffer_push(&sdp->send_buffer, EOT) == OVER_CAPACITY_ERROR)
     {
@@ -119,30 +161,8 @@ int send_datas_start(SimpleDPP *sdp)
  */
 int send_datas_add(SimpleDPP *sdp, const sdp_byte *data, int len)
 {
-    for (int i = 0; i < len; i++)
-    {
-        // 3. push message body,when encounter SOH,EOT or ESC,using ESC escape it.
-        if (containSimpleDPPCtrolByte(data[i]))
-        {
-            // escaped control byte only 2 bytes
-            if (byte_buffer_push(&sdp->send_buffer, ESC) == OVER_CAPACITY_ERROR)
-            {
-                return SIMPLEDPP_SENDFAILED;
-            }
-            if (byte_buffer_push(&sdp->send_buffer, data[i]) == OVER_CAPACITY_ERROR)
-            {
-                return SIMPLEDPP_SENDFAILED;
-            }
-        }
-        else
-        {
-            if (byte_buffer_push(&sdp->send_buffer, data[i]) == OVER_CAPACITY_ERROR)
-            {
-                return SIMPLEDPP_SENDFAILED;
-            }
-        }
-    }
-    return byte_buffer_size(&sdp->send_buffer);
+    // 3. push message body,when encounter SOH,EOT or ESC,using ESC escape it.
+    return SimpleDPP_push_escaped(&sdp->send_buffer, data, len);
 }
 
 /**
@@ -171,7 +191,6 @@ int send_datas_end(SimpleDPP *sdp)
 int __SimpleDPP_send_datas(SimpleDPP *sdp, const sdp_byte *data, int data_len, ...)
 {
     va_list args;
-    int i;
     // 1. empty buffer
     byte_buffer_clear(&sdp->send_buffer);
     // 2. push SHO
@@ -180,28 +199,10 @@ int __SimpleDPP_send_datas(SimpleDPP *sdp, const sdp_byte *data, int data_len, .
     va_start(args, data_len);
     while (true)
     {
-        for (i = 0; i < data_len; i++)
+        if (SimpleDPP_push_escaped(&sdp->send_buffer, data, data_len) == SIMPLEDPP_SENDFAILED)
         {
-            // 3. push message body,when encounter SOH,EOT or ESC,using ESC escape it.
-            if (containSimpleDPPCtrolByte(data[i]))
-            {
-                // escaped control byte only 2 bytes
-                if (byte_buffer_push(&sdp->send_buffer, ESC) == OVER_CAPACITY_ERROR)
-                {
-                    return SIMPLEDPP_SENDFAILED;
-                }
-                if (byte_buffer_push(&sdp->send_buffer, data[i]) == OVER_CAPACITY_ERROR)
-                {
-                    return SIMPLEDPP_SENDFAILED;
-                }
-            }
-            else
-            {
-                if (byte_buffer_push(&sdp->send_buffer, data[i]) == OVER_CAPACITY_ERROR)
-                {
-                    return SIMPLEDPP_SENDFAILED;
-                }
-            }
+            va_end(args);
+            return SIMPLEDPP_SENDFAILED;
         }
         data = va_arg(args, const sdp_byte *);
         if (data == VAR_ARG_END)
@@ -250,6 +251,8 @@ void SimpleDPP_parse(SimpleDPP *sdp, sdp_byte c)
         default:
             if (byte_buffer_push(&sdp->recv_buffer, c) == OVER_CAPACITY_ERROR)
             {
+                // drop the rest of the frame, otherwise its tail would be received as a frame
+                sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
                 SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_OVER_CAPACITY);
             }
             break;
@@ -260,12 +263,17 @@ void SimpleDPP_parse(SimpleDPP *sdp, sdp_byte c)
         {
             if (byte_buffer_push(&sdp->recv_buffer, c) == OVER_CAPACITY_ERROR)
             {
+                sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
                 SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_OVER_CAPACITY);
             }
-            sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_END;
+            else
+            {
+                sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_END;
+            }
         }
         else
         {
+            sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
             SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_NONCTRL_BYTE_WHEN_WAIT_CTRL_BYTE);
         }
         break;
@@ -274,6 +282,152 @@ void SimpleDPP_parse(SimpleDPP *sdp, sdp_byte c)
     }
 }
 
+/**
+ * @brief 把收到的一段帧数据复制到*pOut处。
+ *
+ * @return true 成功。
+ * @return false 帧长度超过了recv_buffer的容量。
+ */
+static inline bool SimpleDPP_recv_append(SimpleDPP *sdp, const sdp_byte *frame, sdp_byte **pOut, const sdp_byte *src, int len)
+{
+    sdp_byte *out = *pOut;
+
+    if (out - frame + len > sdp->recv_buffer.capacity)
+    {
+        return false;
+    }
+    if (out != src)
+    {
+        // 转义很多时普通字节的段很短，逐字节复制比调用memmove快
+        if (len <= 8)
+        {
+            for (int i = 0; i < len; i++)
+            {
+                out[i] = src[i];
+            }
+        }
+        else
+        {
+            memmove(out, src, len);
+        }
+    }
+    *pOut = out + len;
+    return true;
+}
+
+/**
+ * @brief 一次解析一段接收到的数据，和逐字节调用@SimpleDPP_parse的结果相同（回调的帧和错误的顺序都一样）。
+ * 两个控制字节之间的普通字节一次找出、一次复制。在这段数据中开始的帧直接在data中去掉转义字节，
+ * 收齐后回调的数据指向data，不经过recv_buffer；上一段数据中开始的帧接着写入recv_buffer；
+ * 没有收齐的帧在返回前复制到recv_buffer，和下一段数据拼接。回调的数据只在回调期间有效。
+ *
+ * @param sdp
+ * @param data 接收到的数据，会被改写。
+ * @param len
+ */
+void SimpleDPP_parse_buf(SimpleDPP *sdp, sdp_byte *data, int len)
+{
+    sdp_byte *end   = data + len;
+    sdp_byte *frame = sdp->recv_buffer.data; // 去掉转义后的帧数据从这里开始
+    sdp_byte *out   = frame + sdp->recv_buffer.size;
+    sdp_byte *run;
+    sdp_byte *soh;
+
+    while (data < end)
+    {
+        switch (sdp->SimpleDPPRevState)
+        {
+        case SIMPLEDPP_REV_WAIT_START:
+            soh = (sdp_byte *)memchr(data, SOH, end - data);
+            if (soh == NULL)
+            {
+                return;
+            }
+            data = soh + 1;
+            sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_END;
+            sdp->SimpleDPPFrameRevStartTick = SimpleDPP_getMsTick();
+            frame = data;
+            out = data;
+            break;
+        case SIMPLEDPP_REV_WAIT_END:
+            // 普通字节和转义的控制字节连续处理，直到帧结束、出错或者这段数据结束
+            do
+            {
+                run = data;
+                while (data < end && !SimpleDPPCtrlByteTable[*data])
+                {
+                    data++;
+                }
+                if (!SimpleDPP_recv_append(sdp, frame, &out, run, (int)(data - run)))
+                {
+                    sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
+                    SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_OVER_CAPACITY);
+                    break;
+                }
+                if (data == end)
+                {
+                    break;
+                }
+                if (*data == ESC && data + 1 < end && SimpleDPPCtrlByteTable[data[1]])
+                {
+                    data += 2;
+                    if (!SimpleDPP_recv_append(sdp, frame, &out, data - 1, 1))
+                    {
+                        sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
+                        SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_OVER_CAPACITY);
+                        break;
+                    }
+                    continue;
+                }
+                switch (*data++)
+                {
+                case SOH:
+                    sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
+                    SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_SOH_WHEN_WAIT_END);
+                    break;
+                case EOT:
+                    sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
+                    SimpleDPPRecvFrameInnerCallback(sdp, frame, (int)(out - frame));
+                    byte_buffer_clear(&sdp->recv_buffer);
+                    break;
+                default: // ESC, 后面的字节在下一段数据中或者不是控制字节
+                    sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_CTRL_BYTE;
+                    break;
+                }
+            } while (sdp->SimpleDPPRevState == SIMPLEDPP_REV_WAIT_END);
+            break;
+        case SIMPLEDPP_REV_WAIT_CTRL_BYTE:
+            if (!SimpleDPPCtrlByteTable[*data])
+            {
+                data++;
+                sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
+                SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_NONCTRL_BYTE_WHEN_WAIT_CTRL_BYTE);
+            }
+            else if (!SimpleDPP_recv_append(sdp, frame, &out, data++, 1))
+            {
+                sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_START;
+                SimpleDPPRevErrorInnerCallback(sdp, SIMPLEDPP_ERROR_REV_OVER_CAPACITY);
+            }
+            else
+            {
+                sdp->SimpleDPPRevState = SIMPLEDPP_REV_WAIT_END;
+            }
+            break;
+        default:
+            return;
+        }
+    }
+    // 没有收齐的帧留到下一段数据，长度已经检查过，一定放得下
+    if (sdp->SimpleDPPRevState != SIMPLEDPP_REV_WAIT_START)
+    {
+        if (frame != sdp->recv_buffer.data)
+        {
+            memcpy(sdp->recv_buffer.data, frame, out - frame);
+        }
+        sdp->recv_buffer.size = (int)(out - frame);
+    }
+}
+
 static bool SimpleDPP_isTimeout(uint32_t start, uint32_t timeout)
 {
     return SimpleDPP_getMsTick() - start > timeout;
@@ -296,10 +450,11 @@ void SimpeDPP_poll(SimpleDPP *sdp)
 
     if (sdp->adapter->read != NULL)
     {
-        sdp_byte c;
-        while (sdp->adapter->read(&c, 1) == 1)
+        sdp_byte buf[SIMPLEDPP_POLL_READ_SIZE];
+        unsigned int len;
+        while ((len = sdp->adapter->read(buf, sizeof(buf))) > 0)
         {
-            SimpleDPP_parse(sdp, c);
+            SimpleDPP_parse_buf(sdp, buf, (int)len);
         }
     }
 }
\ No newline at end of file
@@ -12,12 +12,20 @@
 #include "SimpleDPP_port.h"
 #include "HDL_CPU_Time.h"
 #include <stdlib.h>
+#ifdef SIMPLEDPP_SIMULATION
+// 上位机仿真时使用虚拟时钟，由仿真程序推进
+uint32_t sdp_sim_tick = 0;
+#endif
+
 uint32_t SimpleDPP_getMsTick(void)
 {
-    // TODO:
+#ifdef SIMPLEDPP_SIMULATION
+    return sdp_sim_tick;
+#else
     uint32_t msTimestamp = 0;
     msTimestamp = HDL_CPU_Time_GetTick();
     return msTimestamp;
+#endif
 }
 
 void *sdp_malloc(unsigned int nbytes)
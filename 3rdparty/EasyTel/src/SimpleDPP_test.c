@@ -0,0 +1,391 @@
+/**
+ * @file SimpleDPP_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief SimpleDPP的成块编码和SimpleDPP_parse_buf测试：
+ * 编码结果和原来逐字节push的编码相同；随机切分的数据流（包括错误的转义、帧中的SOH、超长帧、丢失的EOT）
+ * 用SimpleDPP_parse_buf解析和逐字节SimpleDPP_parse回调的帧和错误完全相同；
+ * 最后比较随机数据和转义很多的数据（一半是控制字节）编码、解析的MB/s。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "SimpleDPP_test.h"
+#include "HDL_CPU_Time.h"
+#include "crc.h"
+#include "log.h"
+
+#define SEND_CAPACITY  1024
+#define RECV_CAPACITY  512
+// 吞吐量测试：每帧的数据长度和每轮的字节数
+#define BENCH_FRAME    256
+#define BENCH_BYTES    (8UL * 1024 * 1024)
+// 吞吐量测试中解析时每次从接收缓冲区取出的字节数，和SimpeDPP_poll相同
+#define BENCH_CHUNK    SIMPLEDPP_POLL_READ_SIZE
+// 解析测试的数据流长度和每轮记录的帧数，默认按目标板的RAM，主机上可以改大
+#ifndef SIMPLEDPP_TEST_STREAM_MAX
+#define SIMPLEDPP_TEST_STREAM_MAX (16UL * 1024)
+#endif
+#ifndef SIMPLEDPP_TEST_EVENT_MAX
+#define SIMPLEDPP_TEST_EVENT_MAX 512
+#endif
+#define STREAM_MAX     SIMPLEDPP_TEST_STREAM_MAX
+#define EVENT_MAX      SIMPLEDPP_TEST_EVENT_MAX
+
+typedef struct {
+    int len;       // 帧长度，错误时为错误码
+    uint16_t crc;  // 帧数据的CRC
+} Event_t;
+
+typedef struct {
+    Event_t events[EVENT_MAX];
+    int count;
+} EventLog_t;
+
+static uint8_t _gStream[STREAM_MAX];
+static uint32_t _gStreamLen = 0;
+static uint8_t _gChunk[STREAM_MAX];
+static uint8_t _gPayload[RECV_CAPACITY * 2];
+static uint8_t _gSendBuf[SEND_CAPACITY];
+static uint8_t _gRecvBuf[RECV_CAPACITY];
+static EventLog_t _gLogByte;
+static EventLog_t _gLogBuf;
+static EventLog_t *_gLog = NULL;
+static uint32_t _gRng   = 0x12345678UL;
+static uint64_t _gBenchBytes = 0;
+static uint32_t _gErrorCnt   = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[SimpleDPP Test] check failed: %s", what);
+    }
+}
+
+static uint32_t rng()
+{
+    _gRng ^= _gRng << 13;
+    _gRng ^= _gRng >> 17;
+    _gRng ^= _gRng << 5;
+    return _gRng;
+}
+
+// escape为true时一半是控制字节
+static void make_payload(uint8_t *buf, int len, bool escape)
+{
+    static const uint8_t ctrl[] = {SOH, EOT, ESC};
+    for (int i = 0; i < len; i++) {
+        uint32_t r = rng();
+        buf[i]     = (escape && (r & 0x100)) ? ctrl[(r >> 9) % 3] : (uint8_t)r;
+    }
+}
+
+static unsigned int stream_write(const void *buf, unsigned int len)
+{
+    if (_gStreamLen + len <= sizeof(_gStream)) {
+        memcpy(&_gStream[_gStreamLen], buf, len);
+        _gStreamLen += len;
+    }
+    return len;
+}
+
+static unsigned int bench_write(const void *buf, unsigned int len)
+{
+    _gBenchBytes += len + ((const uint8_t *)buf)[len - 1];
+    return len;
+}
+
+static void log_recv(void *obj, const sdp_byte *data, int len)
+{
+    if (_gLog->count < EVENT_MAX) {
+        _gLog->events[_gLog->count].len = len;
+        _gLog->events[_gLog->count].crc = CRC16_Modbus(data, (uint16_t)len);
+        _gLog->count++;
+    }
+}
+
+static void log_error(void *obj, SimpleDPPERROR error_code)
+{
+    if (_gLog->count < EVENT_MAX) {
+        _gLog->events[_gLog->count].len = error_code;
+        _gLog->events[_gLog->count].crc = 0;
+        _gLog->count++;
+    }
+}
+
+static void bench_recv(void *obj, const sdp_byte *data, int len)
+{
+    _gBenchBytes += len + data[0];
+}
+
+static void sdp_init(SimpleDPP *sdp, SimpleDPPAdapter_t *adapter, unsigned int (*write)(const void *, unsigned int),
+                     SimpleDPPRecvCallback_t recv)
+{
+    memset(adapter, 0, sizeof(*adapter));
+    adapter->write                     = write;
+    adapter->write_buf                 = _gSendBuf;
+    adapter->write_buf_capacity        = sizeof(_gSendBuf);
+    adapter->read_buf                  = _gRecvBuf;
+    adapter->read_buf_capacity         = sizeof(_gRecvBuf);
+    adapter->SimpleDPPRecvCallback     = recv;
+    adapter->SimpleDPPRevErrorCallback = log_error;
+    SimpleDPP_Constructor(sdp, adapter);
+}
+
+/**
+ * @brief 原来的编码：每个字节push一次并检查容量。
+ *
+ */
+static int legacy_encode(uint8_t *out, int capacity, const uint8_t *data, int len)
+{
+    ByteBuffer buf;
+    byte_buffer_setmemory(&buf, out, capacity);
+    byte_buffer_push(&buf, SOH);
+    for (int i = 0; i < len; i++) {
+        if (containSimpleDPPCtrolByte(data[i])) {
+            if (byte_buffer_push(&buf, ESC) == OVER_CAPACITY_ERROR) {
+                return SIMPLEDPP_SENDFAILED;
+            }
+        }
+        if (byte_buffer_push(&buf, data[i]) == OVER_CAPACITY_ERROR) {
+            return SIMPLEDPP_SENDFAILED;
+        }
+    }
+    if (byte_buffer_push(&buf, EOT) == OVER_CAPACITY_ERROR) {
+        return SIMPLEDPP_SENDFAILED;
+    }
+    return byte_buffer_size(&buf);
+}
+
+static void encode_test()
+{
+    static uint8_t legacy[SEND_CAPACITY];
+    SimpleDPPAdapter_t adapter;
+    SimpleDPP sdp;
+
+    sdp_init(&sdp, &adapter, stream_write, log_recv);
+    for (int n = 0; n < 2000; n++) {
+        int len     = (int)(rng() % sizeof(_gPayload));
+        int expect  = 0;
+        int split   = len == 0 ? 0 : (int)(rng() % len);
+        bool escape = n & 1;
+
+        make_payload(_gPayload, len, escape);
+        expect      = legacy_encode(legacy, sizeof(legacy), _gPayload, len);
+        _gStreamLen = 0;
+        if (SimpleDPP_send(&sdp, _gPayload, len) == SIMPLEDPP_SENDFAILED) {
+            check(expect == SIMPLEDPP_SENDFAILED && _gStreamLen == 0, "send fails like legacy");
+        } else {
+            check(expect == (int)_gStreamLen && memcmp(legacy, _gStream, _gStreamLen) == 0, "send same as legacy");
+        }
+
+        // 分两段添加，结果相同
+        _gStreamLen = 0;
+        if (send_datas_start(&sdp) == SIMPLEDPP_SENDFAILED ||
+            send_datas_add(&sdp, _gPayload, split) == SIMPLEDPP_SENDFAILED ||
+            send_datas_add(&sdp, _gPayload + split, len - split) == SIMPLEDPP_SENDFAILED ||
+            send_datas_end(&sdp) == SIMPLEDPP_SENDFAILED) {
+            check(expect == SIMPLEDPP_SENDFAILED, "send datas fails like legacy");
+        } else {
+            check(expect == (int)_gStreamLen && memcmp(legacy, _gStream, _gStreamLen) == 0, "send datas same as legacy");
+        }
+
+        _gStreamLen = 0;
+        if (SimpleDPP_send_datas(&sdp, _gPayload, split, _gPayload + split, len - split) == SIMPLEDPP_SENDFAILED) {
+            check(expect == SIMPLEDPP_SENDFAILED, "send_datas fails like legacy");
+        } else {
+            check(expect == (int)_gStreamLen && memcmp(legacy, _gStream, _gStreamLen) == 0, "send_datas same as legacy");
+        }
+    }
+}
+
+/**
+ * @brief 生成一段数据流：正常的帧中夹着错误。
+ *
+ */
+static void make_stream(SimpleDPP *sdp)
+{
+    _gStreamLen = 0;
+    while (_gStreamLen < sizeof(_gStream) - SEND_CAPACITY * 2) {
+        uint32_t r  = rng() % 16;
+        int len     = (int)(rng() % (r == 0 ? sizeof(_gPayload) : RECV_CAPACITY / 2));
+        uint32_t at = _gStreamLen;
+
+        make_payload(_gPayload, len, rng() & 1);
+        SimpleDPP_send(sdp, _gPayload, len);
+        if (_gStreamLen - at < 3) {
+            continue;
+        }
+        uint32_t pos = at + 1 + rng() % (_gStreamLen - at - 2);
+        switch (r) {
+        case 1: // 转义后面不是控制字节
+            _gStream[pos] = ESC;
+            _gStream[pos + 1] = 'x';
+            break;
+        case 2: // 帧中出现SOH
+            _gStream[pos] = SOH;
+            break;
+        case 3: // 丢失EOT，和下一帧连在一起
+            _gStreamLen--;
+            break;
+        case 4: // 帧之间的杂散字节
+            _gStream[_gStreamLen++] = (uint8_t)rng();
+            _gStream[_gStreamLen++] = ESC;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static bool log_equal()
+{
+    if (_gLogByte.count != _gLogBuf.count) {
+        return false;
+    }
+    return memcmp(_gLogByte.events, _gLogBuf.events, _gLogByte.count * sizeof(Event_t)) == 0;
+}
+
+static void parse_test()
+{
+    SimpleDPPAdapter_t adapterByte, adapterBuf;
+    SimpleDPP sdpByte, sdpBuf;
+    static uint8_t recvBuf2[RECV_CAPACITY];
+    int frames = 0;
+    int errors = 0;
+
+    for (int round = 0; round < 20; round++) {
+        sdp_init(&sdpByte, &adapterByte, stream_write, log_recv);
+        make_stream(&sdpByte);
+        sdp_init(&sdpBuf, &adapterBuf, stream_write, log_recv);
+        // 两个对象的接收缓冲区不能共用
+        adapterBuf.read_buf = recvBuf2;
+        SimpleDPP_Constructor(&sdpBuf, &adapterBuf);
+
+        memset(&_gLogByte, 0, sizeof(_gLogByte));
+        memset(&_gLogBuf, 0, sizeof(_gLogBuf));
+        _gLog = &_gLogByte;
+        for (uint32_t i = 0; i < _gStreamLen; i++) {
+            SimpleDPP_parse(&sdpByte, _gStream[i]);
+        }
+
+        // 随机切分，第一轮整段解析
+        _gLog = &_gLogBuf;
+        memcpy(_gChunk, _gStream, _gStreamLen);
+        for (uint32_t i = 0; i < _gStreamLen;) {
+            uint32_t len = round == 0 ? _gStreamLen : 1 + rng() % (round < 10 ? 8 : 700);
+            len          = len > _gStreamLen - i ? _gStreamLen - i : len;
+            SimpleDPP_parse_buf(&sdpBuf, &_gChunk[i], (int)len);
+            i += len;
+        }
+        check(log_equal(), "parse_buf same frames and errors as parse");
+        check(sdpByte.SimpleDPPRevState == sdpBuf.SimpleDPPRevState, "same state at the end");
+        check(getSimpleDPPErrorCnt(&sdpByte) == getSimpleDPPErrorCnt(&sdpBuf), "same error count");
+        for (int i = 0; i < _gLogByte.count; i++) {
+            if (_gLogByte.events[i].len >= 0) {
+                frames++;
+            } else {
+                errors++;
+            }
+        }
+    }
+    ULOG_INFO("[SimpleDPP Test] parse: %d frames, %d errors, same with parse_buf", frames, errors);
+    check(frames > 1000 && errors > 100, "stream has frames and errors");
+}
+
+static double mbps(uint64_t bytes, uint64_t us)
+{
+    return us == 0 ? 0.0 : (double)bytes / (1024.0 * 1024.0) * 1e6 / (double)us;
+}
+
+static void bench(bool escape, double *pResult)
+{
+    static uint8_t legacy[SEND_CAPACITY];
+    SimpleDPPAdapter_t adapter;
+    SimpleDPP sdp;
+    uint64_t us;
+    uint32_t encoded;
+
+    make_payload(_gPayload, BENCH_FRAME, escape);
+
+    // 编码
+    sdp_init(&sdp, &adapter, bench_write, bench_recv);
+    us = HDL_CPU_Time_GetUsTick64();
+    for (uint32_t n = 0; n < BENCH_BYTES / BENCH_FRAME; n++) {
+        _gPayload[0] = (uint8_t)n;
+        int len      = legacy_encode(legacy, sizeof(legacy), _gPayload, BENCH_FRAME);
+        bench_write(legacy, len);
+    }
+    pResult[0] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    us         = HDL_CPU_Time_GetUsTick64();
+    for (uint32_t n = 0; n < BENCH_BYTES / BENCH_FRAME; n++) {
+        _gPayload[0] = (uint8_t)n;
+        SimpleDPP_send(&sdp, _gPayload, BENCH_FRAME);
+    }
+    pResult[1] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+
+    // 解析：先编码一段数据流，反复解析
+    sdp_init(&sdp, &adapter, stream_write, bench_recv);
+    _gStreamLen = 0;
+    while (_gStreamLen < sizeof(_gStream) - SEND_CAPACITY) {
+        _gPayload[0] = (uint8_t)rng();
+        SimpleDPP_send(&sdp, _gPayload, BENCH_FRAME);
+    }
+    encoded = _gStreamLen;
+
+    us = HDL_CPU_Time_GetUsTick64();
+    for (uint32_t done = 0; done < BENCH_BYTES; done += encoded) {
+        for (uint32_t i = 0; i < encoded; i++) {
+            SimpleDPP_parse(&sdp, _gStream[i]);
+        }
+    }
+    pResult[2] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    // parse_buf会改写数据，和SimpeDPP_poll一样每次从接收缓冲区复制出一段
+    us = HDL_CPU_Time_GetUsTick64();
+    for (uint32_t done = 0; done < BENCH_BYTES; done += encoded) {
+        for (uint32_t i = 0; i < encoded; i += BENCH_CHUNK) {
+            uint32_t len = encoded - i < BENCH_CHUNK ? encoded - i : BENCH_CHUNK;
+            memcpy(_gChunk, &_gStream[i], len);
+            SimpleDPP_parse_buf(&sdp, _gChunk, (int)len);
+        }
+    }
+    pResult[3] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    check(getSimpleDPPErrorCnt(&sdp) == 0, "bench without errors");
+
+    ULOG_INFO("[SimpleDPP Test] %s: encode legacy %.1f MB/s, bulk %.1f MB/s", escape ? "escape-heavy" : "random",
+              pResult[0], pResult[1]);
+    ULOG_INFO("[SimpleDPP Test] %s: parse %.1f MB/s, parse_buf %.1f MB/s", escape ? "escape-heavy" : "random",
+              pResult[2], pResult[3]);
+}
+
+static void bench_test()
+{
+    double random[4];
+    double escape[4];
+
+    bench(false, random);
+    bench(true, escape);
+    check(random[1] > random[0], "bulk encode faster on random payload");
+    check(random[3] > random[2], "parse_buf faster on random payload");
+}
+
+/**
+ * @brief SimpleDPP测试，只依赖HDL_CPU_Time的us计时，可以在目标板上运行。
+ *
+ * @return uint32_t 错误数。
+ */
+uint32_t SimpleDPP_test()
+{
+    _gErrorCnt = 0;
+    _gRng      = 0x12345678UL;
+    encode_test();
+    parse_test();
+    bench_test();
+    ULOG_INFO("[SimpleDPP Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
@@ -48,12 +48,24 @@
 #include "HDL_SPI.h"
 #include "HDL_CPU_Time.h"
 #include "log.h"
-#include "app_fatfs.h"
+
+// 初始化阶段时钟不能超过400kHz。SPI最大256分频，PCLK1为170MHz时实际为664kHz，一般的卡都能工作
+#define SD_SPI_INIT_CLOCK_HZ 400000U
+// 初始化完成后切换到默认速度模式的最高时钟
+#define SD_SPI_FULL_CLOCK_HZ 25000000U
+// ACMD41初始化的超时时间，ms
+#define SD_INIT_TIMEOUT_MS   1000U
+// 等待数据令牌的超时时间，ms。SDHC卡的读访问时间不超过100ms
+#define SD_READ_TIMEOUT_MS   100U
+// 等待写入完成（卡忙）的超时时间，ms。SDHC卡的写忙时间不超过250ms
+#define SD_WRITE_TIMEOUT_MS  500U
 
 // 记录卡的类型
 uint8_t SD_Type = SD_TYPE_NOT_SD; // 存储卡的类型
 SD_CardInfo SDCardInfo;           // 用于存储卡的信息
 bool g_sd_spi_if_inited = false;  // SD卡SPI接口是否初始化
+static uint32_t g_sd_spi_clock      = 0; // 当前SPI时钟，Hz
+static uint32_t g_sd_written_blocks = 0; // 最近一次多块写成功写入的块数
 
 /**
  * @brief SD卡SPI接口是否初始化
@@ -69,6 +81,161 @@ bool SD_Card_Is_IF_Inited()
 bool g_sd_card_has_changed = false;
 #define SD_SPI SPI_1
 
+/**
+ * @brief 当前的SPI时钟。
+ *
+ * @return uint32_t Hz
+ */
+uint32_t SD_GetClock(void)
+{
+    return g_sd_spi_clock;
+}
+
+/**
+ * @brief 最近一次SD_WriteMultiBlocks成功写入的块数，中途出错时是ACMD22查询到的卡实际写入的块数。
+ *
+ * @return uint32_t
+ */
+uint32_t SD_GetWrittenBlocks(void)
+{
+    return g_sd_written_blocks;
+}
+
+/**
+ * @brief 等待卡不忙，卡忙时MISO保持低电平。
+ *
+ * @param timeout 超时时间，ms。
+ * @return true 卡空闲。
+ * @return false 超时。
+ */
+static bool SD_WaitReady(uint32_t timeout)
+{
+    uint32_t startMoment = HDL_CPU_Time_GetTick();
+
+    while (SD_ReadByte() != SD_DUMMY_BYTE) {
+        if (HDL_CPU_Time_GetTick() - startMoment > timeout) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 读取R1响应。命令之后的0~8个字节为0xFF，R1的最高位为0。
+ *
+ * @return uint8_t R1响应，超时返回0xFF。
+ */
+static uint8_t SD_GetR1(void)
+{
+    uint8_t r1 = SD_DUMMY_BYTE;
+
+    for (uint32_t i = 0; i < 9 && (r1 & 0x80); i++) {
+        r1 = SD_ReadByte();
+    }
+    return r1;
+}
+
+/**
+ * @brief 接收一个数据块：等待起始令牌，数据由DMA读入，最后读掉2字节CRC。
+ *
+ * @param pBuffer 接收缓冲区。
+ * @param len 块大小。
+ * @return true 成功。
+ * @return false 等待令牌超时、收到错误令牌或者SPI传输失败。
+ */
+static bool SD_ReadData(uint8_t *pBuffer, uint16_t len)
+{
+    uint32_t startMoment = HDL_CPU_Time_GetTick();
+    uint8_t token        = SD_DUMMY_BYTE;
+
+    while ((token = SD_ReadByte()) == SD_DUMMY_BYTE) {
+        if (HDL_CPU_Time_GetTick() - startMoment > SD_READ_TIMEOUT_MS) {
+            return false;
+        }
+    }
+    // 读出错时卡回复错误令牌（0000xxxx）而不是起始令牌
+    if (token != SD_START_DATA_SINGLE_BLOCK_READ) {
+        return false;
+    }
+    if (!HDL_SPI_ReadBlock(SD_SPI, pBuffer, len, SD_DUMMY_BYTE, SD_READ_TIMEOUT_MS)) {
+        return false;
+    }
+    /*!< Get CRC bytes (not really needed by us, but required by SD) */
+    SD_ReadByte();
+    SD_ReadByte();
+    return true;
+}
+
+/**
+ * @brief 发送一个数据块：起始令牌，数据由DMA发出，2字节CRC，然后检查数据响应并等待写入完成。
+ * 写忙只在这里等待，SD_GetDataResponse不等待。
+ *
+ * @param pBuffer 待写入的数据。
+ * @param len 块大小。
+ * @param token 起始令牌，单块写为0xFE，多块写为0xFC。
+ * @return true 卡接收并写入了数据。
+ * @return false 数据被拒绝、写忙超时或者SPI传输失败。
+ */
+static bool SD_WriteData(const uint8_t *pBuffer, uint16_t len, uint8_t token)
+{
+    uint8_t response;
+
+    SD_WriteByte(token);
+    if (!HDL_SPI_WriteBlock(SD_SPI, pBuffer, len, SD_WRITE_TIMEOUT_MS)) {
+        return false;
+    }
+    /*!< Put CRC bytes (not really needed by us, but required by SD) */
+    SD_WriteByte(SD_DUMMY_BYTE);
+    SD_WriteByte(SD_DUMMY_BYTE);
+    response = SD_GetDataResponse();
+    // 数据被拒绝时卡也可能忙，忙结束后才能发送停止令牌
+    if (!SD_WaitReady(SD_WRITE_TIMEOUT_MS)) {
+        return false;
+    }
+    return response == SD_DATA_OK;
+}
+
+/**
+ * @brief 多块写失败后查询卡实际写入的块数：先用CMD13读出并清除错误状态，再用ACMD22读出成功写入的块数。
+ * ACMD22的响应是R1和一个4字节的数据块，高字节在前。
+ *
+ * @return uint32_t 成功写入的块数，查询失败时为0。
+ */
+static uint32_t SD_GetWellWrittenBlocks(void)
+{
+    uint8_t num[4];
+
+    SD_SendCmd(SD_CMD_SEND_STATUS, 0, 0xFF);
+    // R2：R1之后还有一个状态字节
+    SD_GetR1();
+    SD_ReadByte();
+    SD_SendCmd(SD_CMD_APP_CMD, 0, 0xFF);
+    if (SD_GetR1() != SD_RESPONSE_NO_ERROR) {
+        return 0;
+    }
+    SD_SendCmd(SD_ACMD_SEND_NUM_WR_BLOCKS, 0, 0xFF);
+    if (SD_GetR1() != SD_RESPONSE_NO_ERROR || !SD_ReadData(num, sizeof(num))) {
+        return 0;
+    }
+    return ((uint32_t)num[0] << 24) | ((uint32_t)num[1] << 16) | ((uint32_t)num[2] << 8) | num[3];
+}
+
+/**
+ * @brief 用CMD12结束连续读。CMD12之后先是一个填充字节，然后是R1响应，之后卡可能忙。
+ *
+ * @return true 成功。
+ * @return false 没有响应或者忙超时。
+ */
+static bool SD_StopTransmission(void)
+{
+    SD_SendCmd(SD_CMD_STOP_TRANSMISSION, 0, 0xFF);
+    SD_ReadByte();
+    if (SD_GetR1() != SD_RESPONSE_NO_ERROR) {
+        return false;
+    }
+    return SD_WaitReady(SD_READ_TIMEOUT_MS);
+}
+
 const char *SD_TypetoString(uint8_t type)
 {
     switch (type) {
@@ -176,7 +343,11 @@ void SD_SPI_IF_Init()
  */
 SD_Error SD_Init(void)
 {
-    uint32_t i = 0;
+    uint32_t i      = 0;
+    SD_Error status = SD_RESPONSE_FAILURE;
+
+    // 重新插卡后再次初始化，先降低时钟
+    g_sd_spi_clock = HDL_SPI_SetClock(SD_SPI, SD_SPI_INIT_CLOCK_HZ);
 
     /*!< SD chip select high */
     SD_CS_HIGH();
@@ -204,7 +375,11 @@ SD_Error SD_Init(void)
         return SD_RESPONSE_FAILURE;
     }
 
-    return SD_GetCardInfo(&SDCardInfo);
+    status = SD_GetCardInfo(&SDCardInfo);
+    if (status == SD_RESPONSE_NO_ERROR) {
+        g_sd_spi_clock = HDL_SPI_SetClock(SD_SPI, SD_SPI_FULL_CLOCK_HZ);
+    }
+    return status;
 }
 
 SD_Error SD_Card_Init()
@@ -232,6 +407,7 @@ SD_Error SD_Card_Init()
         ULOG_INFO("[SD Card] Card serial number: %d", SDCardInfo.SD_cid.ProdSN);
         ULOG_INFO("[SD Card] Card manufacture date: %d", SDCardInfo.SD_cid.ManufactDate);
         ULOG_INFO("[SD Card] Card device size: %d", SDCardInfo.SD_csd.DeviceSize);
+        ULOG_INFO("[SD Card] SPI clock: %u Hz", g_sd_spi_clock);
     }
     return Status;
 }
@@ -297,7 +473,6 @@ SD_Error SD_GetCardInfo(SD_CardInfo *cardinfo)
  */
 SD_Error SD_ReadBlock(uint8_t *pBuffer, uint64_t ReadAddr, uint16_t BlockSize)
 {
-    uint32_t i      = 0;
     SD_Error rvalue = SD_RESPONSE_FAILURE;
 
     // SDHC卡块大小固定为512，且读命令中的地址的单位是sector
@@ -313,23 +488,9 @@ SD_Error SD_ReadBlock(uint8_t *pBuffer, uint64_t ReadAddr, uint16_t BlockSize)
     SD_SendCmd(SD_CMD_READ_SINGLE_BLOCK, ReadAddr, 0xFF);
 
     /*!< Check if the SD acknowledged the read block command: R1 response (0x00: no errors) */
-    if (!SD_GetResponse(SD_RESPONSE_NO_ERROR)) {
-        /*!< Now look for the data token to signify the start of the data */
-        if (!SD_GetResponse(SD_START_DATA_SINGLE_BLOCK_READ)) {
-            /*!< Read the SD block data : read NumByteToRead data */
-            for (i = 0; i < BlockSize; i++) {
-                /*!< Save the received data */
-                *pBuffer = SD_ReadByte();
-
-                /*!< Point to the next location where the byte read will be saved */
-                pBuffer++;
-            }
-            /*!< Get CRC bytes (not really needed by us, but required by SD) */
-            SD_ReadByte();
-            SD_ReadByte();
-            /*!< Set response value to success */
-            rvalue = SD_RESPONSE_NO_ERROR;
-        }
+    if (!SD_GetResponse(SD_RESPONSE_NO_ERROR) && SD_ReadData(pBuffer, BlockSize)) {
+        /*!< Set response value to success */
+        rvalue = SD_RESPONSE_NO_ERROR;
     }
     /*!< SD chip select high */
     SD_CS_HIGH();
@@ -343,6 +504,8 @@ SD_Error SD_ReadBlock(uint8_t *pBuffer, uint64_t ReadAddr, uint16_t BlockSize)
 
 /**
  * @brief  Reads multiple block of data from the SD.
+ *         一条CMD18连续读出所有块，每块之间只有起始令牌和CRC，最后用CMD12停止。
+ *         只读一块时使用CMD17，省掉CMD12。
  * @param  pBuffer: pointer to the buffer that receives the data read from the
  *                  SD.
  * @param  ReadAddr: SD's internal address to read from.
@@ -354,9 +517,15 @@ SD_Error SD_ReadBlock(uint8_t *pBuffer, uint64_t ReadAddr, uint16_t BlockSize)
  */
 SD_Error SD_ReadMultiBlocks(uint8_t *pBuffer, uint64_t ReadAddr, uint16_t BlockSize, uint32_t NumberOfBlocks)
 {
-    uint32_t i = 0, Offset = 0;
     SD_Error rvalue = SD_RESPONSE_FAILURE;
 
+    if (NumberOfBlocks == 0) {
+        return SD_RESPONSE_FAILURE;
+    }
+    if (NumberOfBlocks == 1) {
+        return SD_ReadBlock(pBuffer, ReadAddr, BlockSize);
+    }
+
     // SDHC卡块大小固定为512，且读命令中的地址的单位是sector
     if (SD_Type == SD_TYPE_V2HC) {
         BlockSize = 512;
@@ -365,41 +534,22 @@ SD_Error SD_ReadMultiBlocks(uint8_t *pBuffer, uint64_t ReadAddr, uint16_t BlockS
 
     /*!< SD chip select low */
     SD_CS_LOW();
-    /*!< Data transfer */
-    while (NumberOfBlocks--) {
-        /*!< Send CMD17 (SD_CMD_READ_SINGLE_BLOCK) to read one block */
-        SD_SendCmd(SD_CMD_READ_SINGLE_BLOCK, ReadAddr + Offset, 0xFF);
-        /*!< Check if the SD acknowledged the read block command: R1 response (0x00: no errors) */
-        if (SD_GetResponse(SD_RESPONSE_NO_ERROR)) {
-            return SD_RESPONSE_FAILURE;
-        }
-        /*!< Now look for the data token to signify the start of the data */
-        if (!SD_GetResponse(SD_START_DATA_SINGLE_BLOCK_READ)) {
-            /*!< Read the SD block data : read NumByteToRead data */
-            for (i = 0; i < BlockSize; i++) {
-                /*!< Read the pointed data */
-                *pBuffer = SD_ReadByte();
-                /*!< Point to the next location where the byte read will be saved */
-                pBuffer++;
-            }
-            /*!< Set next read address*/
-            if (SD_Type == SD_TYPE_V2HC) {
-                Offset += BlockSize / 512;
-            } else {
-                Offset += BlockSize;
+    /*!< Send CMD18 (SD_CMD_READ_MULT_BLOCK) to read blocks until CMD12 */
+    SD_SendCmd(SD_CMD_READ_MULT_BLOCK, ReadAddr, 0xFF);
+    /*!< Check if the SD acknowledged the read block command: R1 response (0x00: no errors) */
+    if (!SD_GetResponse(SD_RESPONSE_NO_ERROR)) {
+        rvalue = SD_RESPONSE_NO_ERROR;
+        while (NumberOfBlocks--) {
+            if (!SD_ReadData(pBuffer, BlockSize)) {
+                rvalue = SD_RESPONSE_FAILURE;
+                break;
             }
-            /*!< get CRC bytes (not really needed by us, but required by SD) */
-            SD_ReadByte();
-            SD_ReadByte();
-            /*!< Set response value to success */
-            rvalue = SD_RESPONSE_NO_ERROR;
-        } else {
-            /*!< Set response value to failure */
+            pBuffer += BlockSize;
+        }
+        // 读完或者中途出错都要停止连续读，否则卡一直发送数据
+        if (!SD_StopTransmission()) {
             rvalue = SD_RESPONSE_FAILURE;
         }
-
-        /* 添加 Send dummy byte 防止读操作失败 */
-        SD_WriteByte(SD_DUMMY_BYTE);
     }
     /*!< SD chip select high */
     SD_CS_HIGH();
@@ -421,7 +571,6 @@ SD_Error SD_ReadMultiBlocks(uint8_t *pBuffer, uint64_t ReadAddr, uint16_t BlockS
  */
 SD_Error SD_WriteBlock(uint8_t *pBuffer, uint64_t WriteAddr, uint16_t BlockSize)
 {
-    uint32_t i      = 0;
     SD_Error rvalue = SD_RESPONSE_FAILURE;
 
     // SDHC卡块大小固定为512，且写命令中的地址的单位是sector
@@ -432,36 +581,17 @@ SD_Error SD_WriteBlock(uint8_t *pBuffer, uint64_t WriteAddr, uint16_t BlockSize)
 
     /*!< SD chip select low */
     SD_CS_LOW();
-    /*!< Data transfer */
 
     /*!< Send CMD24 (SD_CMD_WRITE_SINGLE_BLOCK) to write blocks */
     SD_SendCmd(SD_CMD_WRITE_SINGLE_BLOCK, WriteAddr, 0xFF);
     /*!< Check if the SD acknowledged the write block command: R1 response (0x00: no errors) */
-    if (SD_GetResponse(SD_RESPONSE_NO_ERROR)) {
-        return SD_RESPONSE_FAILURE;
-    }
-    /*!< Send dummy byte */
-    SD_WriteByte(SD_DUMMY_BYTE);
-    /*!< Send the data token to signify the start of the data */
-    SD_WriteByte(SD_START_DATA_SINGLE_BLOCK_WRITE);
-    /*!< Write the block data to SD : write count data by block */
-    for (i = 0; i < BlockSize; i++) {
-        /*!< Send the pointed byte */
-        SD_WriteByte(*pBuffer);
-        /*!< Point to the next location where the byte read will be saved */
-        pBuffer++;
-    }
-
-    /*!< Put CRC bytes (not really needed by us, but required by SD) */
-    SD_ReadByte();
-    SD_ReadByte();
-    /*!< Read data response */
-    if (SD_GetDataResponse() == SD_DATA_OK) {
-        /*!< Set response value to success */
-        rvalue = SD_RESPONSE_NO_ERROR;
-    } else {
-        /*!< Set response value to failure */
-        rvalue = SD_RESPONSE_FAILURE;
+    if (!SD_GetResponse(SD_RESPONSE_NO_ERROR)) {
+        /*!< Send dummy byte */
+        SD_WriteByte(SD_DUMMY_BYTE);
+        if (SD_WriteData(pBuffer, BlockSize, SD_START_DATA_SINGLE_BLOCK_WRITE)) {
+            /*!< Set response value to success */
+            rvalue = SD_RESPONSE_NO_ERROR;
+        }
     }
     /*!< SD chip select high */
     SD_CS_HIGH();
@@ -473,6 +603,10 @@ SD_Error SD_WriteBlock(uint8_t *pBuffer, uint64_t WriteAddr, uint16_t BlockSize)
 
 /**
  * @brief  Writes many blocks on the SD
+ *         先用ACMD23告诉卡要写的块数，卡可以预先擦除整段区域；
+ *         然后一条CMD25连续写入所有块，每块以0xFC开始，最后发送停止令牌0xFD。
+ *         只写一块时使用CMD24。
+ *         中途出错时用ACMD22查询卡实际写入的块数，由SD_GetWrittenBlocks读出。
  * @param  pBuffer: pointer to the buffer containing the data to be written on
  *                  the SD.
  * @param  WriteAddr: address to write on.
@@ -484,9 +618,18 @@ SD_Error SD_WriteBlock(uint8_t *pBuffer, uint64_t WriteAddr, uint16_t BlockSize)
  */
 SD_Error SD_WriteMultiBlocks(uint8_t *pBuffer, uint64_t WriteAddr, uint16_t BlockSize, uint32_t NumberOfBlocks)
 {
-    uint32_t i = 0, Offset = 0;
     SD_Error rvalue = SD_RESPONSE_FAILURE;
 
+    g_sd_written_blocks = 0;
+    if (NumberOfBlocks == 0) {
+        return SD_RESPONSE_FAILURE;
+    }
+    if (NumberOfBlocks == 1) {
+        rvalue              = SD_WriteBlock(pBuffer, WriteAddr, BlockSize);
+        g_sd_written_blocks = rvalue == SD_RESPONSE_NO_ERROR ? 1 : 0;
+        return rvalue;
+    }
+
     // SDHC卡块大小固定为512，且写命令中的地址的单位是sector
     if (SD_Type == SD_TYPE_V2HC) {
         BlockSize = 512;
@@ -495,41 +638,39 @@ SD_Error SD_WriteMultiBlocks(uint8_t *pBuffer, uint64_t WriteAddr, uint16_t Bloc
 
     /*!< SD chip select low */
     SD_CS_LOW();
-    /*!< Data transfer */
-    while (NumberOfBlocks--) {
-        /*!< Send CMD24 (SD_CMD_WRITE_SINGLE_BLOCK) to write blocks */
-        SD_SendCmd(SD_CMD_WRITE_SINGLE_BLOCK, WriteAddr + Offset, 0xFF);
-        /*!< Check if the SD acknowledged the write block command: R1 response (0x00: no errors) */
-        if (SD_GetResponse(SD_RESPONSE_NO_ERROR)) {
-            return SD_RESPONSE_FAILURE;
-        }
+
+    // 预擦除只是优化，卡不支持或者失败时照常写入
+    SD_SendCmd(SD_CMD_APP_CMD, 0, 0xFF);
+    if (SD_GetR1() == SD_RESPONSE_NO_ERROR) {
+        SD_SendCmd(SD_ACMD_SET_WR_BLK_ERASE_COUNT, NumberOfBlocks & 0x7FFFFF, 0xFF);
+        SD_GetR1();
+    }
+
+    /*!< Send CMD25 (SD_CMD_WRITE_MULT_BLOCK) to write blocks until stop token */
+    SD_SendCmd(SD_CMD_WRITE_MULT_BLOCK, WriteAddr, 0xFF);
+    /*!< Check if the SD acknowledged the write block command: R1 response (0x00: no errors) */
+    if (!SD_GetResponse(SD_RESPONSE_NO_ERROR)) {
         /*!< Send dummy byte */
-        // SD_WriteByte(SD_DUMMY_BYTE);
-        /*!< Send the data token to signify the start of the data */
-        SD_WriteByte(SD_START_DATA_SINGLE_BLOCK_WRITE);
-        /*!< Write the block data to SD : write count data by block */
-        for (i = 0; i < BlockSize; i++) {
-            /*!< Send the pointed byte */
-            SD_WriteByte(*pBuffer);
-            /*!< Point to the next location where the byte read will be saved */
-            pBuffer++;
-        }
-        /*!< Set next write address */
-        if (SD_Type == SD_TYPE_V2HC) {
-            Offset += BlockSize / 512;
-        } else {
-            Offset += BlockSize;
+        SD_WriteByte(SD_DUMMY_BYTE);
+        rvalue = SD_RESPONSE_NO_ERROR;
+        for (uint32_t i = 0; i < NumberOfBlocks; i++) {
+            if (!SD_WriteData(pBuffer, BlockSize, SD_START_DATA_MULTIPLE_BLOCK_WRITE)) {
+                rvalue = SD_RESPONSE_FAILURE;
+                break;
+            }
+            pBuffer += BlockSize;
         }
-        /*!< Put CRC bytes (not really needed by us, but required by SD) */
-        SD_ReadByte();
+        // 写完或者中途出错都用停止令牌结束，停止令牌之后一个字节卡开始忙
+        SD_WriteByte(SD_STOP_DATA_MULTIPLE_BLOCK_WRITE);
         SD_ReadByte();
-        /*!< Read data response */
-        if (SD_GetDataResponse() == SD_DATA_OK) {
-            /*!< Set response value to success */
-            rvalue = SD_RESPONSE_NO_ERROR;
-        } else {
-            /*!< Set response value to failure */
+        if (!SD_WaitReady(SD_WRITE_TIMEOUT_MS)) {
             rvalue = SD_RESPONSE_FAILURE;
+        } else if (rvalue != SD_RESPONSE_NO_ERROR) {
+            // 接收了数据响应的块不一定写入了，以卡的计数为准
+            g_sd_written_blocks = SD_GetWellWrittenBlocks();
+        }
+        if (rvalue == SD_RESPONSE_NO_ERROR) {
+            g_sd_written_blocks = NumberOfBlocks;
         }
     }
     /*!< SD chip select high */
@@ -796,6 +937,7 @@ void SD_SendCmd(uint8_t Cmd, uint32_t Arg, uint8_t Crc)
 
 /**
  * @brief  Get SD card data response.
+ *         只读取数据响应，不等待写入完成。
  * @param  None
  * @retval The SD status: Read data response xxx0<status>1
  *         - status 010: Data accecpted
@@ -834,9 +976,7 @@ uint8_t SD_GetDataResponse(void)
         i++;
     }
 
-    /*!< Wait null data */
-    while (SD_ReadByte() == 0);
-
+    // 不等待写忙，由调用者用SD_WaitReady等待
     /*!< Return response */
     return response;
 }
@@ -901,8 +1041,9 @@ uint16_t SD_GetStatus(void)
  */
 SD_Error SD_GetCardType(void)
 {
-    uint32_t i     = 0;
-    uint32_t Count = 0xFFF;
+    uint32_t i           = 0;
+    uint32_t Count       = 0xFFF;
+    uint32_t startMoment = 0;
 
     uint8_t R7R3_Resp[4];
     uint8_t R1_Resp;
@@ -972,20 +1113,20 @@ SD_Error SD_GetCardType(void)
         // 判断该卡是否支持2.7-3.6V电压
         if (R7R3_Resp[2] == 0x01 && R7R3_Resp[3] == 0xAA) {
             // 支持电压范围，可以操作
-            Count = 200;
-            // 发卡初始化指令CMD55+ACMD41
+            // 发卡初始化指令CMD55+ACMD41，初始化时钟很低，按时间而不是次数判断超时
+            startMoment = HDL_CPU_Time_GetTick();
             do {
-                // CMD55，以强调下面的是ACMD命令
+                // CMD55，以强调下面的是ACMD命令，空闲状态响应0x01
                 SD_SendCmd(SD_CMD_APP_CMD, 0, 0xFF);
-                if (!SD_GetResponse(SD_RESPONSE_NO_ERROR)) // SD_IN_IDLE_STATE
-                    return SD_RESPONSE_FAILURE;            // 超时返回
+                if (SD_GetR1() > SD_IN_IDLE_STATE)
+                    return SD_RESPONSE_FAILURE;
 
                 // ACMD41命令带HCS检查位
                 SD_SendCmd(SD_ACMD_SD_SEND_OP_COND, 0x40000000, 0xFF);
 
-                if (Count-- == 0)
-                    return SD_RESPONSE_FAILURE; // 重试次数超时
-            } while (SD_GetResponse(SD_RESPONSE_NO_ERROR));
+                if (HDL_CPU_Time_GetTick() - startMoment > SD_INIT_TIMEOUT_MS)
+                    return SD_RESPONSE_FAILURE; // 初始化超时
+            } while (SD_GetR1() != SD_RESPONSE_NO_ERROR);
 
             // 初始化指令完成，读取OCR信息，CMD58
 
@@ -239,6 +239,8 @@ extern SD_CardInfo SDCardInfo; // 用于存储卡的信息
 #define SD_CMD_READ_OCR           58 /*!< CMD58 */
 #define SD_CMD_APP_CMD            55 /*!< CMD55 返回0x01*/
 #define SD_ACMD_SD_SEND_OP_COND   41 /*!< ACMD41  返回0x00*/
+#define SD_ACMD_SET_WR_BLK_ERASE_COUNT 23 /*!< ACMD23 多块写之前预擦除的块数 */
+#define SD_ACMD_SEND_NUM_WR_BLOCKS     22 /*!< ACMD22 多块写成功写入的块数 */
 
 // SD卡的类型
 #define SD_TYPE_NOT_SD 0 // 非SD卡
@@ -275,6 +277,8 @@ uint8_t SD_WriteByte(uint8_t byte);
 uint8_t SD_ReadByte(void);
 uint8_t SD_CD_Has_Change();
 bool SD_Card_Is_IF_Inited();
+uint32_t SD_GetClock(void);
+uint32_t SD_GetWrittenBlocks(void);
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,7 @@
  */
 #include "./sdcard/sdcard_test.h"
 #include "./sdcard/bsp_spi_sdcard.h"
+#include "HDL_CPU_Time.h"
 #include "log.h"
 
 /* Private typedef -----------------------------------------------------------*/
@@ -30,6 +31,10 @@ typedef enum {
 #define NUMBER_OF_BLOCKS  10 /* For Multi Blocks operation (Read/Write) */
 #define MULTI_BUFFER_SIZE (BLOCK_SIZE * NUMBER_OF_BLOCKS)
 
+/* 吞吐量测试的起始扇区和总块数，1MB */
+#define SPEED_TEST_SECTOR 8192
+#define SPEED_TEST_BLOCKS 2048
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 uint8_t Buffer_Block_Tx[BLOCK_SIZE], Buffer_Block_Rx[BLOCK_SIZE];
@@ -127,6 +132,48 @@ void SD_MultiBlockTest(void)
     }
 }
 
+/**
+ * @brief 连续读写吞吐量测试。从SPEED_TEST_SECTOR开始每次读写NUMBER_OF_BLOCKS块，
+ * 和FatFs、USB MSC的访问方式相同，共SPEED_TEST_BLOCKS块，读回后比较。会覆盖卡上这段区域的数据。
+ */
+void SD_SpeedTest(void)
+{
+    uint64_t start    = 0;
+    uint64_t writeUs  = 0;
+    uint64_t readUs   = 0;
+    uint32_t errorCnt = 0;
+    uint64_t addr     = 0;
+
+    Fill_Buffer(Buffer_MultiBlock_Tx, MULTI_BUFFER_SIZE, 0x5A);
+
+    start = HDL_CPU_Time_GetUsTick64();
+    for (uint32_t i = 0; i < SPEED_TEST_BLOCKS; i += NUMBER_OF_BLOCKS) {
+        addr = (uint64_t)(SPEED_TEST_SECTOR + i) * BLOCK_SIZE;
+        if (SD_WriteMultiBlocks(Buffer_MultiBlock_Tx, addr, BLOCK_SIZE, NUMBER_OF_BLOCKS) != SD_RESPONSE_NO_ERROR) {
+            errorCnt++;
+        }
+    }
+    writeUs = HDL_CPU_Time_GetUsTick64() - start;
+
+    start = HDL_CPU_Time_GetUsTick64();
+    for (uint32_t i = 0; i < SPEED_TEST_BLOCKS; i += NUMBER_OF_BLOCKS) {
+        addr = (uint64_t)(SPEED_TEST_SECTOR + i) * BLOCK_SIZE;
+        if (SD_ReadMultiBlocks(Buffer_MultiBlock_Rx, addr, BLOCK_SIZE, NUMBER_OF_BLOCKS) != SD_RESPONSE_NO_ERROR ||
+            Buffercmp(Buffer_MultiBlock_Tx, Buffer_MultiBlock_Rx, MULTI_BUFFER_SIZE) == FAILED) {
+            errorCnt++;
+        }
+    }
+    readUs = HDL_CPU_Time_GetUsTick64() - start;
+
+    writeUs = writeUs == 0 ? 1 : writeUs;
+    readUs  = readUs == 0 ? 1 : readUs;
+    ULOG_INFO("[SD Speed] %u KB, SPI clock %u Hz", SPEED_TEST_BLOCKS * BLOCK_SIZE / 1024, SD_GetClock());
+    ULOG_INFO("[SD Speed] write %u KB/s, read %u KB/s",
+              (uint32_t)((uint64_t)SPEED_TEST_BLOCKS * BLOCK_SIZE * 1000000 / 1024 / writeUs),
+              (uint32_t)((uint64_t)SPEED_TEST_BLOCKS * BLOCK_SIZE * 1000000 / 1024 / readUs));
+    ULOG_INFO("[SD Speed] error cnt: %u, %s", errorCnt, errorCnt == 0 ? "pass" : "fail");
+}
+
 /**
  * @brief  Compares two buffers.
  * @param  pBuffer1, pBuffer2: buffers to be compared.
@@ -2,6 +2,7 @@
 #define __SDIO_TEST_H
 
 void SD_Test(void);
+void SD_SpeedTest(void);
 
 #endif
 
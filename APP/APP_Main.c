@@ -32,14 +32,20 @@
 #include "BFL_4G.h"
 #include "cqueue.h"
 #include "HDL_CPU_Time.h"
+#include "CHIP_W25Q512.h"
+#include "CHIP_W25Q512_LogPartition.h"
 #include "test.h"
 
 #include "./sdcard/bsp_spi_sdcard.h"
 #include "./sdcard/sdcard_test.h"
 #include "app_fatfs.h"
+#include "BFL_SDLog.h"
+#include "BFL_FileVerify.h"
 
 #include "usbd_cdc_if.h"
 #include "usb_device.h"
+#include "usbd_storage_if.h"
+#include "CHIP_W25Q512_MSC.h"
 
 typedef struct tagSysInfo_t {
     uint32_t devid;
@@ -91,6 +97,36 @@ void setCalibrateTimeByUtcSecondsCb(uint64_t unixSeconds)
     sys.ctrl.isTimeCalibrated = true;
 }
 
+// 主循环一次低功耗空闲的最长时间，也是period_query_user等轮询定时的最大误差
+#define APP_IDLE_MAX_TICKS    10
+// 打印CPU占用率和每秒唤醒次数的周期，ms
+#define APP_IDLE_REPORT_MS    10000
+
+/**
+ * @brief 打印上次打印以来CPU运行时间的占比和主循环每秒被唤醒的次数。
+ *
+ */
+static void app_idle_report()
+{
+    static HDL_CPU_Time_IdleStat_t last = {0};
+    static uint32_t lastUs              = 0;
+    HDL_CPU_Time_IdleStat_t stat;
+    uint32_t nowUs    = HDL_CPU_Time_GetUsTick();
+    uint32_t windowUs = nowUs - lastUs;
+    uint32_t sleepUs  = 0;
+    uint32_t wakeups  = 0;
+
+    HDL_CPU_Time_GetIdleStat(&stat);
+    sleepUs = (uint32_t)(stat.sleepUs - last.sleepUs);
+    wakeups = stat.wakeups - last.wakeups;
+    if (lastUs != 0 && windowUs != 0) {
+        ULOG_INFO("[Idle] duty cycle %.1f%%, %.1f wakeups/s",
+                  100.0f * (windowUs - sleepUs) / windowUs, wakeups * 1000000.0f / windowUs);
+    }
+    last   = stat;
+    lastUs = nowUs;
+}
+
 #define RTU_DEV_ID_SET    (0x1111111111111111ULL)
 #define AppMainGetDevID() RTU_DEV_ID_SET
 
@@ -111,13 +147,8 @@ uint8_t Sensor_Queue_Read(RTU_Sampling_Var_t *var)
     return cqueue_dequeue(&Sensor_Queue, var);
 }
 
-// 创建带日期的文件路径
-void create_dated_filepath(char *filePath, size_t size)
-{
-    mtime_t datetime;
-    datetime_get_localtime(&datetime);
-    snprintf(filePath, size, "1:%04d%02d%02d.txt", datetime.nYear, datetime.nMonth, datetime.nDay);
-}
+// 转发数据按天保存在SD卡上的文件
+#define APP_SD_DRIVE "1:"
 
 /**
  * @brief 光伏RTU主程序处理器。
@@ -147,6 +178,8 @@ void APP_Main()
     // HDL_WATCHDOG_Init(20);
     datetime_init();
     ulog_init_user();
+    // Flash日志分区在启动日志之前加载，复位前后的日志都能读出
+    log_flash_init();
     BFL_LED_Init();
 
     ULOG_INFO("====================================================================");
@@ -178,9 +211,8 @@ void APP_Main()
     BFL_4G_TCP_Init(SOCKET0, "8.135.10.183", 38944);
     BFL_4G_SetCalibrateTimeByUtcSecondsCb(setCalibrateTimeByUtcSecondsCb);
 
-    RTU_Packet_t pkg = {0};
-    BFL_RTU_Packet_init(&pkg, rtu_packet_buf, sizeof(rtu_packet_buf));
-    int pushed_sample_var_num = 0;
+    RTU_PacketBuilder_t builder;
+    BFL_RTU_PacketBuilder_init(&builder, rtu_packet_buf, sizeof(rtu_packet_buf), RTU_PACKET_MAX_LEN);
     RTU_Sampling_Var_t vqr_header;
     RTU_Sampling_Var_t var;
     Sensor_Queue_Init();
@@ -201,12 +233,8 @@ void APP_Main()
 
     uint32_t last_recv_time = 0;
     PeriodREC_t s_tims1;
-    PeriodREC_t s_tims2;
-    uint32_t sd_write_times = 0;
-    FRESULT res;
-    UINT w_buf_len     = 0;
-    UINT r_buf_len     = 0;
-    char filePath[128] = {0};
+    PeriodREC_t s_idleReport = 0;
+    uint32_t idleTicks       = 0;
 
     int appMainStage = 0;
     while (1) {
@@ -214,10 +242,14 @@ void APP_Main()
         uint8_t sd_change = SD_CD_Has_Change();
         if (sd_change == 2) {
             ULOG_INFO("[SD Card] SD Card is removed");
+            BFL_SDLog_Stop();
             SD_Card_FatFs_DeInit();
         } else if (sd_change == 1) {
             ULOG_INFO("[SD Card] SD Card is inserted");
             SD_Card_FatFs_Init();
+            if (datetime_has_synced() && SD_Card_Fs_IsMounted()) {
+                BFL_SDLog_Start(APP_SD_DRIVE);
+            }
         }
 
         BFL_4G_Poll();
@@ -237,15 +269,9 @@ void APP_Main()
             case 0: {
                 if (datetime_has_synced()) {
                     appMainStage = 1;
-                    // 根据当前日期创建文件
-                    create_dated_filepath((char *)filePath, sizeof(filePath));
-                    // 尝试以 FA_OPEN_APPEND 模式打开文件
-                    res = f_open(&USERFile1, filePath, FA_OPEN_APPEND | FA_WRITE | FA_READ);
-
-                    if (res != FR_OK) {
-                        ULOG_ERROR("[FatFs] open %s failed err code = %d", filePath, res);
-                    } else {
-                        ULOG_INFO("[FatFs] open %s  ok", filePath);
+                    // 时间校准之后才能确定文件的日期
+                    if (SD_Card_Fs_IsMounted()) {
+                        BFL_SDLog_Start(APP_SD_DRIVE);
                     }
                 }
 
@@ -283,35 +309,25 @@ void APP_Main()
 
                         BFL_4G_TCP_Write(SOCKET0, (uint8_t *)sc_byte_buffer_data_ptr(&_4G_rev_buffer), sc_byte_buffer_size(&_4G_rev_buffer));
                         BFL_LED_Toggle(LED1);
-                        // 在每次准备写入数据之前检查文件是否可写
-                        res = f_write(&USERFile1, sc_byte_buffer_data_ptr(&_4G_rev_buffer), sc_byte_buffer_size(&_4G_rev_buffer), &w_buf_len);
-                        if (res != FR_OK) {
-                            ULOG_ERROR("[FatFs] write %s failed  err code = %d", filePath, res);
-                        } else {
-                            ULOG_INFO("[FatFs] write %s  ok", filePath);
-                        }
-
-                        sd_write_times++;
-
+                        // 先放入RAM缓冲区，凑够整扇区、到同步时间时由BFL_SDLog_Poll写入文件
+                        BFL_SDLog_Write(sc_byte_buffer_data_ptr(&_4G_rev_buffer), sc_byte_buffer_size(&_4G_rev_buffer));
                         sc_byte_buffer_clear(&_4G_rev_buffer);
                     }
                 }
 
-                if (period_query_user(&s_tims2, 2000)) {
-                    if (sd_write_times > 0) {
-                        sd_write_times = 0;
-
-                        // 关闭文件
-                        f_close(&USERFile1);
-                        // 根据当前日期创建文件
-                        create_dated_filepath((char *)filePath, sizeof(filePath));
-                        res = f_open(&USERFile1, filePath, FA_OPEN_APPEND | FA_WRITE | FA_READ);
-                        if (res != FR_OK) {
-                            ULOG_ERROR("[FatFs] open %s failed err code = %d", filePath, res);
-                        } else {
-                            ULOG_INFO("[FatFs] open %s  ok", filePath);
-                        }
-                    }
+                // 流式构建RTU数据包：采样点直接从Sensor_Queue编码到数据包缓冲区，CRC增量计算，
+                // 22个采样点(包含中心标识采样点)或者数据包满了就发送
+                if (BFL_RTU_PacketBuilder_get_Sampling_Var_num(&builder) == 0 && !cqueue_is_empty(&Sensor_Queue)) {
+                    // 存放RTU设备代号
+                    uint64_t rtu_devid = AppMainGetDevID();
+                    // 编码采样点的时间和校验和
+                    RTU_Sampling_Var_encoder(&vqr_header, SENSOR_CODE_DEVICE_ID, &rtu_devid, sizeof(uint64_t));
+                    BFL_RTU_PacketBuilder_push_Sampling_Var(&builder, &vqr_header);
+                }
+                BFL_RTU_PacketBuilder_push_from_queue(&builder, &Sensor_Queue, 22 - BFL_RTU_PacketBuilder_get_Sampling_Var_num(&builder));
+                if (BFL_RTU_PacketBuilder_get_Sampling_Var_num(&builder) >= 22 || BFL_RTU_PacketBuilder_residual_var_num(&builder) == 0) {
+                    // 4G发送队列放不下时保留数据包，下次再发
+                    BFL_RTU_PacketBuilder_send_by_4G(&builder, SOCKET0);
                 }
 
                 if (BFL_4G_TCP_Readable(SOCKET0)) {
@@ -334,45 +350,30 @@ void APP_Main()
                 break;
         }
 
-        // continue;
-
-        //    if (BFL_4G_TCP_Writeable(0) && Sensor_Queue_Read(&var))
-        //    {
-        //      // 存放数据到RTU数据包中(存放数据到RTU数据包的数据域)
-        //      switch (pushed_sample_var_num)
-        //      {
-        //      case 0:
-        //      {
-        //        // 存放RTU设备代号
-        //        uint64_t rtu_devid = AppMainGetDevID();
-        //        // 编码采样点的时间和校验和
-        //        RTU_Sampling_Var_encoder(&vqr_header, SENSOR_CODE_DEVICE_ID, &rtu_devid, sizeof(uint64_t));
-
-        //        BFL_RTU_Packet_push_Sampling_Var(&pkg, &vqr_header);
-        //        BFL_RTU_Packet_push_Sampling_Var(&pkg, &var);
-        //        pushed_sample_var_num += 2;
-        //      }
-        //      break;
-        //      case 22 - 1: // n - 1，包含中心标识采样点一个n个采样点
-        //      {
-        //        pushed_sample_var_num = 0;
-        //        BFL_RTU_Packet_push_Sampling_Var(&pkg, &var);
-        //        // 编码位字节流
-        //        BFL_RTU_Packet_encoder(&pkg);
-        //        // 发送字节流
-        //        BFL_RTU_Packet_send_by_4G(&pkg, 1);
-        //        // 每次使用完成后清空，防止上一次的数据带来的影响
-        //        BFL_RTU_Packet_clear_buffer(&pkg);
-        //      }
-        //      break;
-        //      default:
-        //      {
-        //        // 这里最好自己预先确定有多少数据需要存放到数据域
-        //        BFL_RTU_Packet_push_Sampling_Var(&pkg, &var);
-        //        pushed_sample_var_num++;
-        //      }
-        //      break;
-        //      }
-        //    }
+        // 每次最多一步：写入整扇区、同步、零点换文件
+        BFL_SDLog_Poll();
+        // USB MSC写回缓存超时写入Flash
+        STORAGE_Poll_FS();
+        // 文件校验每次读取、计算一块
+        BFL_FileVerify_Poll();
+
+        // 延迟日志在主循环中输出，调试口发送缓冲区满时下一轮再输出
+        dlog_drain(DLOG_RING_SIZE);
+        log_flash_handler();
+
+        // 没有马上需要处理的工作时低功耗空闲，直到下一个调度任务到期、最长空闲时间到或者有中断到来
+        if (!Uart_HasPendingWork() && !BFL_4G_HasPendingWork() && !CHIP_W25Q512_IsBusy() &&
+            !BFL_SDLog_HasPendingWork() && !BFL_FileVerify_IsBusy() && sc_byte_buffer_size(&_4G_rev_buffer) == 0) {
+            idleTicks = scheduler_next_deadline();
+            HDL_CPU_Time_Idle(idleTicks < APP_IDLE_MAX_TICKS ? idleTicks : APP_IDLE_MAX_TICKS);
+        }
+        if (period_query_user(&s_idleReport, APP_IDLE_REPORT_MS)) {
+            app_idle_report();
+            dlog_stat_show();
+            CHIP_W25Q512_LOG_stat_show();
+            BFL_SDLog_StatShow();
+            CHIP_W25Q512_MSC_stat_show();
+            BFL_FileVerify_StatShow();
+        }
     }
 }
@@ -4,7 +4,7 @@
  * @brief
  * @version 0.1
  * @date 2023-10-07
- * @last modified 2023-10-07
+ * @last modified 2023-10-24
  *
  * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
  *
@@ -28,21 +28,43 @@
 AsyncTask_t *AsyncTask_Create(void *func, void *param, uint32_t beforeReadyDelay)
 {
     AsyncTask_t *pTask = (AsyncTask_t *)malloc(sizeof(AsyncTask_t));
+    if (pTask != NULL) {
+        AsyncTask_Init(pTask, func, param, beforeReadyDelay);
+        pTask->_static = false;
+    }
+    return pTask;
+}
+
+/**
+ * @brief 初始化一个静态分配的任务，参数同AsyncTask_Create。
+ * 用于反复作为路由目标的常驻任务（例如链路检查），不需要动态分配，也不会被AsyncTask_Destroy释放。
+ *
+ * @param pTask
+ * @param func
+ * @param param
+ * @param beforeReadyDelay
+ */
+void AsyncTask_Init(AsyncTask_t *pTask, void *func, void *param, uint32_t beforeReadyDelay)
+{
     if (pTask != NULL) {
         memset(pTask, 0, sizeof(AsyncTask_t));
         pTask->func               = func;
         pTask->param              = param;
         pTask->before_ready_delay = beforeReadyDelay;
         pTask->state              = ASYNC_TASK_STATE_INITIAL;
-        memset(pTask->route, NULL, sizeof(pTask->route));
+        pTask->_static            = true;
         sc_list_init(&pTask->node);
     }
-    return pTask;
 }
 
+/**
+ * @brief 图任务和AsyncTask_Init初始化的任务是静态分配的，不释放。
+ *
+ * @param pTask
+ */
 void AsyncTask_Destroy(AsyncTask_t *pTask)
 {
-    if (pTask != NULL) {
+    if (pTask != NULL && pTask->graph == NULL && !pTask->_static) {
         free(pTask);
     }
 }
@@ -111,6 +133,147 @@ void AsyncTask_SetFuncResult(AsyncTask_t *pTask, int32_t result)
     }
 }
 
+static void async_task_graph_load(AsyncTask_t *pTask, uint8_t state)
+{
+    const AsyncTaskGraphState_t *pState = NULL;
+
+    if (state >= pTask->graph->state_num) {
+        state = 0;
+    }
+    pState                    = &pTask->graph->states[state];
+    pTask->graph_state        = state;
+    pTask->func               = pState->func;
+    pTask->before_ready_delay = pState->before_ready_delay;
+}
+
+static void async_task_graph_trace(AsyncTask_t *pTask, uint32_t result)
+{
+    AsyncTaskGraphTrace_t *pTrace = NULL;
+    uint32_t costMs               = 0;
+
+    if (pTask->trace == NULL) {
+        return;
+    }
+    pTrace = &pTask->trace[pTask->graph_state];
+    costMs = AsyncTaskGetMsTick() - pTask->_run_moment;
+    pTrace->exe_cnt++;
+    if (result < ASYNCTASK_NEXT_ROUTE_NUM) {
+        pTrace->result_cnt[result]++;
+    }
+    pTrace->last_ms = costMs;
+    pTrace->total_ms += costMs;
+    if (costMs > pTrace->max_ms) {
+        pTrace->max_ms = costMs;
+    }
+}
+
+/**
+ * @brief 图任务的一个状态执行完成，按状态表选择下一个状态。
+ *
+ * @param pTask
+ * @return true 在图内部跳转，已经装入下一个状态。
+ * @return false 不是图任务，或者需要离开图：按任务的路由和任务表继续。
+ */
+static bool async_task_graph_step(AsyncTask_t *pTask)
+{
+    uint32_t result = 0;
+    uint8_t next    = ASYNC_TASK_GRAPH_END;
+
+    if (pTask == NULL || pTask->graph == NULL) {
+        return false;
+    }
+    result = (uint32_t)pTask->func_result;
+    async_task_graph_trace(pTask, result);
+
+    // 未知的执行结果按图结束处理
+    if (result >= ASYNCTASK_NEXT_ROUTE_NUM) {
+        return false;
+    }
+    // 任务函数中设置的路由优先
+    if (pTask->route[result] != NULL) {
+        return false;
+    }
+    next = pTask->graph->states[pTask->graph_state].next[result];
+    if (next == ASYNC_TASK_GRAPH_EXIT) {
+        pTask->route[result] = pTask->graph_exit;
+        return false;
+    }
+    if (next >= pTask->graph->state_num) {
+        return false;
+    }
+    async_task_graph_load(pTask, next);
+    return true;
+}
+
+/**
+ * @brief 初始化一个图任务。图任务不需要AsyncTask_Create，一般定义为静态变量，
+ * 之后和普通任务一样加入任务表或者作为路由目标。
+ *
+ * @param pTask
+ * @param graph 状态表。
+ * @param trace 每个状态的执行统计，长度为graph->state_num，为NULL时不统计。
+ * @param param 所有状态的任务函数的参数。
+ * @param pExit 状态表中ASYNC_TASK_GRAPH_EXIT路由到的任务，可以为NULL，之后也可以直接修改graph_exit。
+ */
+void AsyncTaskGraph_Init(AsyncTask_t *pTask, const AsyncTaskGraph_t *graph, AsyncTaskGraphTrace_t *trace, void *param, AsyncTask_t *pExit)
+{
+    if (pTask != NULL && graph != NULL && graph->state_num > 0) {
+        memset(pTask, 0, sizeof(AsyncTask_t));
+        sc_list_init(&pTask->node);
+        pTask->state      = ASYNC_TASK_STATE_INITIAL;
+        pTask->param      = param;
+        pTask->graph      = graph;
+        pTask->trace      = trace;
+        pTask->graph_exit = pExit;
+        async_task_graph_load(pTask, 0);
+        AsyncTaskGraph_TraceReset(pTask);
+    }
+}
+
+/**
+ * @brief 作为路由目标时，从图的哪个状态开始执行。只对下一次进入图有效，之后恢复为从第一个状态开始。
+ *
+ * @param pTask
+ * @param state
+ * @return AsyncTask_t* pTask，可以直接作为AsyncTask_SetRoute的参数。
+ */
+AsyncTask_t *AsyncTaskGraph_Entry(AsyncTask_t *pTask, uint8_t state)
+{
+    if (pTask != NULL && pTask->graph != NULL && state < pTask->graph->state_num) {
+        pTask->_graph_entry = state;
+    }
+    return pTask;
+}
+
+void AsyncTaskGraph_TraceReset(AsyncTask_t *pTask)
+{
+    if (pTask != NULL && pTask->graph != NULL && pTask->trace != NULL) {
+        memset(pTask->trace, 0, sizeof(AsyncTaskGraphTrace_t) * pTask->graph->state_num);
+    }
+}
+
+/**
+ * @brief 打印图中每个状态的执行次数、结果分布和执行时间。
+ *
+ * @param pTask
+ */
+void AsyncTaskGraph_TraceShow(AsyncTask_t *pTask)
+{
+    const AsyncTaskGraphTrace_t *pTrace = NULL;
+
+    if (pTask == NULL || pTask->graph == NULL || pTask->trace == NULL) {
+        return;
+    }
+    ULOG_INFO("[AsyncTask] graph %s, current state:%s", pTask->graph->name, pTask->graph->states[pTask->graph_state].name);
+    ULOG_INFO("%-16s %6s %6s %6s %6s %8s %8s %8s", "state", "exe", "ok", "error", "timeout", "last_ms", "avg_ms", "max_ms");
+    for (uint8_t i = 0; i < pTask->graph->state_num; i++) {
+        pTrace = &pTask->trace[i];
+        ULOG_INFO("%-16s %6u %6u %6u %6u %8u %8u %8u", pTask->graph->states[i].name, pTrace->exe_cnt,
+                  pTrace->result_cnt[0], pTrace->result_cnt[1], pTrace->result_cnt[2], pTrace->last_ms,
+                  pTrace->exe_cnt ? pTrace->total_ms / pTrace->exe_cnt : 0, pTrace->max_ms);
+    }
+}
+
 AsyncTaskList_t *AsyncTaskList_Create()
 {
     AsyncTaskList_t *pList = (AsyncTaskList_t *)malloc(sizeof(AsyncTaskList_t));
@@ -148,57 +311,80 @@ AsyncTask_t *AsyncTaskList_Next(AsyncTaskList_t *pList)
 {
     AsyncTask_t *res   = NULL;
     AsyncTask_t *route = NULL;
+    AsyncTask_t *prev  = NULL;
+    bool stepped       = false;
     // 到这里pList->pCurrentTask是已经完成的了
     if (pList != NULL) {
-        switch (pList->state) {
-            case ASYNC_TASK_LIST_STATE_INITIAL:
-                if (!sc_list_is_empty(&pList->staticList)) {
-                    struct sc_list *iter;
-                    iter         = pList->staticList.next;
-                    res          = sc_list_entry(iter, AsyncTask_t, node);
-                    pList->state = ASYNC_TASK_LIST_STATE_RUN_IN_STATIC_LIST;
-                } else if (!sc_list_is_empty(&pList->dynamicList)) {
-                    res          = AsyncTaskList_DynamicPop(pList);
-                    pList->state = ASYNC_TASK_LIST_STATE_RUN_IN_DYNAMIC_LIST;
-                } else {
-                    // PASS
-                }
-                break;
-            case ASYNC_TASK_LIST_STATE_RUN_IN_STATIC_LIST: {
-                // 路由选择
-                route = AsyncTask_GetRoute(pList->pCurrentTask, pList->pCurrentTask->func_result);
-                if (route != NULL) {
-                    res = route;
-                } else {
-                    if (AsyncTaskList_IsStaticLastTask(pList, pList->pCurrentTask)) {
-                        res          = NULL;
+        prev = pList->pCurrentTask;
+        // 图任务在图内部跳转，不经过任务表
+        if (pList->state != ASYNC_TASK_LIST_STATE_INITIAL && async_task_graph_step(prev)) {
+            res     = prev;
+            stepped = true;
+        } else {
+            switch (pList->state) {
+                case ASYNC_TASK_LIST_STATE_INITIAL:
+                    if (!sc_list_is_empty(&pList->staticList)) {
+                        struct sc_list *iter;
+                        iter         = pList->staticList.next;
+                        res          = sc_list_entry(iter, AsyncTask_t, node);
+                        pList->state = ASYNC_TASK_LIST_STATE_RUN_IN_STATIC_LIST;
+                    } else if (!sc_list_is_empty(&pList->dynamicList)) {
+                        res          = AsyncTaskList_DynamicPop(pList);
                         pList->state = ASYNC_TASK_LIST_STATE_RUN_IN_DYNAMIC_LIST;
                     } else {
-                        struct sc_list *iter;
-                        iter = pList->pCurrentTask->node.next;
-                        res  = sc_list_entry(iter, AsyncTask_t, node);
+                        // PASS
+                    }
+                    break;
+                case ASYNC_TASK_LIST_STATE_RUN_IN_STATIC_LIST: {
+                    // 路由选择
+                    route = AsyncTask_GetRoute(pList->pCurrentTask, pList->pCurrentTask->func_result);
+                    if (route != NULL) {
+                        res = route;
+                    } else {
+                        // 游离任务（未加入静态任务表，只作为路由目标）执行完且没有后继路由时，同样视为静态任务表执行结束
+                        if (AsyncTaskList_IsStaticLastTask(pList, pList->pCurrentTask) ||
+                            sc_list_is_empty(&pList->pCurrentTask->node)) {
+                            res          = NULL;
+                            pList->state = ASYNC_TASK_LIST_STATE_RUN_IN_DYNAMIC_LIST;
+                        } else {
+                            struct sc_list *iter;
+                            iter = pList->pCurrentTask->node.next;
+                            res  = sc_list_entry(iter, AsyncTask_t, node);
+                        }
+                    }
+                } break;
+                case ASYNC_TASK_LIST_STATE_RUN_IN_DYNAMIC_LIST: {
+                    // 路由选择，静态任务表刚执行完时当前任务为NULL
+                    if (pList->pCurrentTask != NULL) {
+                        route = AsyncTask_GetRoute(pList->pCurrentTask, pList->pCurrentTask->func_result);
+                    }
+                    if (route != NULL) {
+                        pList->state = ASYNC_TASK_LIST_STATE_RUN_IN_STATIC_LIST;
+                        res          = route;
+                    } else {
+                        res = AsyncTaskList_DynamicPop(pList);
                     }
-                }
-            } break;
-            case ASYNC_TASK_LIST_STATE_RUN_IN_DYNAMIC_LIST: {
-                // 路由选择
-                route = AsyncTask_GetRoute(pList->pCurrentTask, pList->pCurrentTask->func_result);
-                if (route != NULL) {
-                    pList->state = ASYNC_TASK_LIST_STATE_RUN_IN_STATIC_LIST;
-                    res          = route;
-                } else {
-                    res = AsyncTaskList_DynamicPop(pList);
-                }
 
-                AsyncTask_Destroy(pList->pCurrentTask);
-                pList->pCurrentTask = NULL;
-            } break;
-            default:
-                break;
+                    AsyncTask_Destroy(pList->pCurrentTask);
+                    pList->pCurrentTask = NULL;
+                } break;
+                default:
+                    break;
+            }
+        }
+
+        // 运行时设置的路由只对图任务的当前状态生效一次
+        if (prev != NULL && prev->graph != NULL) {
+            memset(prev->route, 0, sizeof(prev->route));
         }
 
         // 重置任务
         if (res != NULL) {
+            // 从外部进入图任务
+            if (res->graph != NULL && !stepped) {
+                async_task_graph_load(res, res->_graph_entry);
+                res->_graph_entry = 0;
+            }
             res->state       = ASYNC_TASK_STATE_INITIAL;
             res->func_result = 0;
         }
@@ -245,6 +431,7 @@ void AsyncTaskList_Clear(AsyncTaskList_t *pList)
  * AsyncTask_GetState返回ASYNC_TASK_STATE_FINISHED。
  * 并且通过AsyncTaskList_Next获取下一个任务。
  * 路由路径一点只能路由到静态任务表。
+ * 也可以路由到没有加入任何任务表的游离任务，它执行完成后按照自身的路由继续，没有路由则进入动态任务表。
  * @param pList
  */
 
@@ -259,8 +446,10 @@ void AsyncTaskList_Exec(AsyncTaskList_t *pList)
             case ASYNC_TASK_STATE_READY:
                 if (AsyncTaskGetMsTick() - pList->pCurrentTask->_ready_moment >=
                     pList->pCurrentTask->before_ready_delay) {
+                    // 先切换到运行态，任务函数内可以直接标记完成
+                    pList->pCurrentTask->state       = ASYNC_TASK_STATE_RUNNING;
+                    pList->pCurrentTask->_run_moment = AsyncTaskGetMsTick();
                     AsyncTask_Exec(pList->pCurrentTask);
-                    pList->pCurrentTask->state = ASYNC_TASK_STATE_RUNNING;
                 }
                 break;
             case ASYNC_TASK_STATE_RUNNING:
@@ -4,7 +4,7 @@
  * @brief
  * @version 0.1
  * @date 2023-10-07
- * @last modified 2023-10-07
+ * @last modified 2023-10-24
  *
  * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
  *
@@ -53,6 +53,43 @@ enum ASYNC_TASK_LIST_STATE {
     ASYNC_TASK_LIST_STATE_RUN_IN_DYNAMIC_LIST,
 };
 
+/*
+任务图：
+固定的任务序列可以声明为const状态表放在flash中，由一个静态分配的AsyncTask_t执行（图任务）。
+图任务在任务表中和普通任务一样，状态执行完成后按状态表中func_result对应的下一个状态直接跳转，
+不经过任务表，也不需要动态分配。状态表中的路由值：
+0~state_num-1：图内的下一个状态；
+ASYNC_TASK_GRAPH_END：图执行结束，按普通任务没有路由时的规则继续任务表；
+ASYNC_TASK_GRAPH_EXIT：路由到图的出口任务（AsyncTaskGraph_Init时指定的游离任务）。
+任务函数中用AsyncTask_SetRoute设置的路由优先于状态表，只对当前状态生效一次。
+*/
+#define ASYNC_TASK_GRAPH_END  0xFF
+#define ASYNC_TASK_GRAPH_EXIT 0xFE
+
+typedef struct tagAsyncTaskGraphState_t {
+    const char *name;
+    AsyncTaskFunc_t func;
+    uint32_t before_ready_delay;
+    uint8_t next[ASYNCTASK_NEXT_ROUTE_NUM]; // 按func_result索引的下一个状态
+} AsyncTaskGraphState_t;
+
+typedef struct tagAsyncTaskGraph_t {
+    const char *name;
+    const AsyncTaskGraphState_t *states;
+    uint8_t state_num;
+} AsyncTaskGraph_t;
+
+#define ASYNC_TASK_GRAPH_STATE_NUM(states) ((uint8_t)(sizeof(states) / sizeof((states)[0])))
+
+// 图中每个状态的执行统计，执行时间为从开始执行到完成，不包括before_ready_delay
+typedef struct tagAsyncTaskGraphTrace_t {
+    uint32_t exe_cnt;
+    uint32_t result_cnt[ASYNCTASK_NEXT_ROUTE_NUM];
+    uint32_t last_ms;
+    uint32_t max_ms;
+    uint32_t total_ms;
+} AsyncTaskGraphTrace_t;
+
 typedef struct tagAsyncTask_t {
     struct sc_list node;
 
@@ -65,6 +102,15 @@ typedef struct tagAsyncTask_t {
     void *param;
     struct tagAsyncTask_t *route[ASYNCTASK_NEXT_ROUTE_NUM];
     int32_t func_result;
+    uint32_t _run_moment;
+    bool _static; // 静态分配，AsyncTask_Destroy不释放
+
+    // 图任务，普通任务为NULL
+    const AsyncTaskGraph_t *graph;
+    AsyncTaskGraphTrace_t *trace; // 长度为graph->state_num，可以为NULL
+    struct tagAsyncTask_t *graph_exit;
+    uint8_t graph_state;
+    uint8_t _graph_entry;
 } AsyncTask_t;
 
 typedef struct tagAsyncTaskList_t {
@@ -75,6 +121,7 @@ typedef struct tagAsyncTaskList_t {
 } AsyncTaskList_t;
 
 AsyncTask_t *AsyncTask_Create(void *func, void *param, uint32_t beforeReadyDelay);
+void AsyncTask_Init(AsyncTask_t *pTask, void *func, void *param, uint32_t beforeReadyDelay);
 void AsyncTask_Destroy(AsyncTask_t *pTask);
 void AsyncTask_Exec(AsyncTask_t *pTask);
 enum ASYNC_TASK_STATE AsyncTask_GetState(AsyncTask_t *pTask);
@@ -83,6 +130,11 @@ AsyncTask_t *AsyncTask_GetRoute(AsyncTask_t *pTask, uint32_t funcResult);
 void AsyncTask_SetState(AsyncTask_t *pTask, enum ASYNC_TASK_STATE state);
 void AsyncTask_SetFuncResult(AsyncTask_t *pTask, int32_t result);
 
+void AsyncTaskGraph_Init(AsyncTask_t *pTask, const AsyncTaskGraph_t *graph, AsyncTaskGraphTrace_t *trace, void *param, AsyncTask_t *pExit);
+AsyncTask_t *AsyncTaskGraph_Entry(AsyncTask_t *pTask, uint8_t state);
+void AsyncTaskGraph_TraceReset(AsyncTask_t *pTask);
+void AsyncTaskGraph_TraceShow(AsyncTask_t *pTask);
+
 AsyncTaskList_t *AsyncTaskList_Create();
 void AsyncTaskList_Destroy(AsyncTaskList_t *pList);
 void AsyncTaskList_StaticAdd(AsyncTaskList_t *pList, AsyncTask_t *pTask);
@@ -8,6 +8,7 @@
  * @copyright Copyright (c) 2022 Liu Yuanlin Personal.
  *
  */
+#include <string.h>
 #include "BFL_RTU_Packet.h"
 #include "crc.h"
 #include "BFL_4G.h"
@@ -200,3 +201,175 @@ void BFL_RTU_Packet_send_by_4G(RTU_Packet_t *ppacket, int sockid)
     buf                 = BFL_RTU_Packet_get_buffer(ppacket);
     BFL_4G_TCP_Write(0, (uint8_t *)sc_byte_buffer_data_ptr(buf), sc_byte_buffer_size(buf));
 }
+
+/**
+ * @brief 初始化流式RTU数据包构建器，在缓冲区开始处写入首部，rem_len先填0。
+ *
+ * @param pbuilder
+ * @param buf 数据包缓冲区，发送完成之前不能修改。
+ * @param capacity 缓冲区容量。
+ * @param mtu 传输层一次能发送的最大长度，数据包长度不会超过它，为0时使用RTU_PACKET_MAX_LEN。
+ * @return uint8_t 0失败，1成功。
+ */
+uint8_t BFL_RTU_PacketBuilder_init(RTU_PacketBuilder_t *pbuilder, uint8_t *buf, uint32_t capacity, uint32_t mtu)
+{
+    if (mtu == 0 || mtu > RTU_PACKET_MAX_LEN) {
+        mtu = RTU_PACKET_MAX_LEN;
+    }
+    if (capacity > mtu) {
+        capacity = mtu;
+    }
+    if (buf == NULL || capacity < RTU_PACKET_MIN_LEN + RTU_SAMPLING_VAR_T_SIZE) {
+        return 0;
+    }
+
+    pbuilder->buf      = buf;
+    pbuilder->capacity = capacity;
+    BFL_RTU_PacketBuilder_reset(pbuilder);
+    return 1;
+}
+
+/**
+ * @brief 清空数据域，开始构建下一个数据包。
+ *
+ * @param pbuilder
+ */
+void BFL_RTU_PacketBuilder_reset(RTU_PacketBuilder_t *pbuilder)
+{
+    // 首部按小端序存放，与BFL_RTU_Packet_encoder一致
+    pbuilder->buf[0]     = (uint8_t)(RTU_PACKET_ID & 0xFF);
+    pbuilder->buf[1]     = (uint8_t)(RTU_PACKET_ID >> 8);
+    pbuilder->buf[2]     = 0;
+    pbuilder->buf[3]     = 0;
+    pbuilder->size       = RTU_PACKET_HEADER_LEN;
+    pbuilder->header_crc = CRC16_Modbus_Update(CRC16_MODBUS_INIT, pbuilder->buf, RTU_PACKET_HEADER_LEN);
+    pbuilder->crc        = pbuilder->header_crc;
+}
+
+/**
+ * @brief 向数据域追加数据，放不下时一个字节也不写入。
+ *
+ * @param pbuilder
+ * @param data
+ * @param len
+ * @return uint32_t 实际写入的字节数，0或者len。
+ */
+uint32_t BFL_RTU_PacketBuilder_push_data(RTU_PacketBuilder_t *pbuilder, const uint8_t *data, uint32_t len)
+{
+    if (pbuilder->size + len + RTU_PACKET_CRC_LEN > pbuilder->capacity) {
+        return 0;
+    }
+    memcpy(pbuilder->buf + pbuilder->size, data, len);
+    pbuilder->crc = CRC16_Modbus_Update(pbuilder->crc, pbuilder->buf + pbuilder->size, len);
+    pbuilder->size += len;
+    return len;
+}
+
+/**
+ * @brief 向数据域追加一个采样值。
+ *
+ * @param pbuilder
+ * @param pvar
+ * @return uint32_t 0失败没有存进去，1成功。
+ */
+uint32_t BFL_RTU_PacketBuilder_push_Sampling_Var(RTU_PacketBuilder_t *pbuilder, const RTU_Sampling_Var_t *pvar)
+{
+    return BFL_RTU_PacketBuilder_push_data(pbuilder, (const uint8_t *)pvar, RTU_SAMPLING_VAR_T_SIZE) == RTU_SAMPLING_VAR_T_SIZE;
+}
+
+/**
+ * @brief 从元素为RTU_Sampling_Var_t的队列中直接取出采样值编码到数据域，不经过中间缓冲。
+ *
+ * @param pbuilder
+ * @param Q 采样值队列，元素大小必须为RTU_SAMPLING_VAR_T_SIZE。
+ * @param num 最多取出的个数。
+ * @return uint32_t 实际取出的采样值个数，受队列中的个数和数据包剩余空间限制。
+ */
+uint32_t BFL_RTU_PacketBuilder_push_from_queue(RTU_PacketBuilder_t *pbuilder, CQueue Q, uint32_t num)
+{
+    uint32_t residual = BFL_RTU_PacketBuilder_residual_var_num(pbuilder);
+    uint8_t *pData    = pbuilder->buf + pbuilder->size;
+
+    if (Q->ItemSize != RTU_SAMPLING_VAR_T_SIZE) {
+        return 0;
+    }
+    if (num > residual) {
+        num = residual;
+    }
+    num = cqueue_out(Q, pData, num);
+    pbuilder->crc = CRC16_Modbus_Update(pbuilder->crc, pData, num * RTU_SAMPLING_VAR_T_SIZE);
+    pbuilder->size += num * RTU_SAMPLING_VAR_T_SIZE;
+    return num;
+}
+
+/**
+ * @brief 数据包还能放下多少个采样值。
+ *
+ * @param pbuilder
+ * @return uint32_t
+ */
+uint32_t BFL_RTU_PacketBuilder_residual_var_num(RTU_PacketBuilder_t *pbuilder)
+{
+    return (pbuilder->capacity - pbuilder->size - RTU_PACKET_CRC_LEN) / RTU_SAMPLING_VAR_T_SIZE;
+}
+
+/**
+ * @brief 数据域中已经有多少个采样值。
+ *
+ * @param pbuilder
+ * @return uint32_t
+ */
+uint32_t BFL_RTU_PacketBuilder_get_Sampling_Var_num(RTU_PacketBuilder_t *pbuilder)
+{
+    return (pbuilder->size - RTU_PACKET_HEADER_LEN) / RTU_SAMPLING_VAR_T_SIZE;
+}
+
+/**
+ * @brief 结束构建：回填rem_len，用CRC16_Modbus_Shift修正首部改变带来的CRC变化，追加CRC。
+ * 修正的开销与数据长度的对数成正比，不需要再遍历一遍数据。
+ *
+ * @param pbuilder
+ * @param plen 数据包长度。
+ * @return const uint8_t* 可以直接发送的数据包，就是初始化时传入的缓冲区。
+ */
+const uint8_t *BFL_RTU_PacketBuilder_finish(RTU_PacketBuilder_t *pbuilder, uint32_t *plen)
+{
+    uint32_t data_len = pbuilder->size - RTU_PACKET_HEADER_LEN;
+    uint16_t rem_len  = (uint16_t)(data_len + RTU_PACKET_CRC_LEN);
+    uint16_t crc      = 0;
+
+    pbuilder->buf[2] = (uint8_t)(rem_len & 0xFF);
+    pbuilder->buf[3] = (uint8_t)(rem_len >> 8);
+    crc              = CRC16_Modbus_Update(CRC16_MODBUS_INIT, pbuilder->buf, RTU_PACKET_HEADER_LEN);
+    crc              = pbuilder->crc ^ CRC16_Modbus_Shift(crc ^ pbuilder->header_crc, data_len);
+
+    // crc端序
+    pbuilder->buf[pbuilder->size]     = (uint8_t)(crc >> 8);
+    pbuilder->buf[pbuilder->size + 1] = (uint8_t)(crc & 0xFF);
+    if (plen != NULL) {
+        *plen = pbuilder->size + RTU_PACKET_CRC_LEN;
+    }
+    return pbuilder->buf;
+}
+
+/**
+ * @brief 结束构建并通过4G模块发送，发送后构建器复位。
+ * 数据包会被拷贝一次到套接字的发送队列，QISEND从发送队列分块转换成十六进制发送，所以返回后缓冲区马上可以重新构建。
+ *
+ * @param pbuilder
+ * @param sockid 套接字。
+ * @return uint32_t 4G模块接收的字节数，发送队列放不下整个数据包时不发送，返回0，构建器保持不变。
+ */
+uint32_t BFL_RTU_PacketBuilder_send_by_4G(RTU_PacketBuilder_t *pbuilder, int sockid)
+{
+    uint32_t len        = 0;
+    const uint8_t *pbuf = NULL;
+
+    if (BFL_4G_TCP_Writeable(sockid) < pbuilder->size + RTU_PACKET_CRC_LEN) {
+        return 0;
+    }
+    pbuf = BFL_RTU_PacketBuilder_finish(pbuilder, &len);
+    len  = BFL_4G_TCP_Write(sockid, (uint8_t *)pbuf, len);
+    BFL_RTU_PacketBuilder_reset(pbuilder);
+    return len;
+}
@@ -13,12 +13,15 @@
 #include <stdint.h>
 #include "sc_byte_buffer.h"
 #include "APP_RTU_Sampler.h"
+#include "cqueue.h"
 
 #define RTU_PACKET_ID                 0xAA55U
 #define RTU_PACKET_HEADER_LEN         4 // 字节
 #define RTU_PACKET_CRC_LEN            2 // 字节
 #define RTU_PACKET_MIN_LEN            6 // 字节
 #define RTU_PACKET_MAX_DATA_FILED_LEN (60U * 16U)
+// 数据包最大长度，流式构建时的默认MTU
+#define RTU_PACKET_MAX_LEN            (RTU_PACKET_HEADER_LEN + RTU_PACKET_MAX_DATA_FILED_LEN + RTU_PACKET_CRC_LEN)
 typedef struct tagRTU_PacketHeader_t {
     uint16_t id;      // 标识符
     uint16_t rem_len; // 剩余部分长度
@@ -36,6 +39,18 @@ typedef struct tagRTU_Packet_t {
     */
 } RTU_Packet_t;
 
+/**
+ * @brief 流式RTU数据包构建器。首部在缓冲区开始处原地预留，采样点直接追加到数据域并增量计算CRC，
+ * 结束时回填rem_len并修正CRC，缓冲区中就是可以直接发送的完整数据包，不需要再组包拷贝或者再计算一遍CRC。
+ */
+typedef struct tagRTU_PacketBuilder_t {
+    uint8_t *buf;         // 数据包缓冲区，buf[0]开始就是首部
+    uint32_t capacity;    // 数据包最大长度，不超过传输层的MTU
+    uint32_t size;        // 已经写入的长度，包含首部
+    uint16_t crc;         // 首部rem_len按0计算时，到目前为止的CRC
+    uint16_t header_crc;  // 首部rem_len按0计算时，首部的CRC
+} RTU_PacketBuilder_t;
+
 uint8_t BFL_RTU_Packet_init(RTU_Packet_t *ppacket, byte *data, int capacity);
 uint8_t BFL_RTU_Packet_encoder(RTU_Packet_t *ppacket);
 void BFL_RTU_Packet_clear_buffer(RTU_Packet_t *ppacket);
@@ -48,4 +63,14 @@ uint32_t BFL_RTU_Packet_get_Sampling_Var_num(RTU_Packet_t *ppacket);
 
 sc_byte_buffer *BFL_RTU_Packet_get_buffer(RTU_Packet_t *ppacket);
 void BFL_RTU_Packet_send_by_4G(RTU_Packet_t *ppacket, int sockid);
+
+uint8_t BFL_RTU_PacketBuilder_init(RTU_PacketBuilder_t *pbuilder, uint8_t *buf, uint32_t capacity, uint32_t mtu);
+void BFL_RTU_PacketBuilder_reset(RTU_PacketBuilder_t *pbuilder);
+uint32_t BFL_RTU_PacketBuilder_push_data(RTU_PacketBuilder_t *pbuilder, const uint8_t *data, uint32_t len);
+uint32_t BFL_RTU_PacketBuilder_push_Sampling_Var(RTU_PacketBuilder_t *pbuilder, const RTU_Sampling_Var_t *pvar);
+uint32_t BFL_RTU_PacketBuilder_push_from_queue(RTU_PacketBuilder_t *pbuilder, CQueue Q, uint32_t num);
+uint32_t BFL_RTU_PacketBuilder_residual_var_num(RTU_PacketBuilder_t *pbuilder);
+uint32_t BFL_RTU_PacketBuilder_get_Sampling_Var_num(RTU_PacketBuilder_t *pbuilder);
+const uint8_t *BFL_RTU_PacketBuilder_finish(RTU_PacketBuilder_t *pbuilder, uint32_t *plen);
+uint32_t BFL_RTU_PacketBuilder_send_by_4G(RTU_PacketBuilder_t *pbuilder, int sockid);
 #endif // !BFL_RTU_PACKET_H
\ No newline at end of file
@@ -0,0 +1,204 @@
+/**
+ * @file BFL_RTU_PacketBuilder_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 流式构建器测试：不同的数据域（单个采样点、MTU内最多的采样点、奇数长度的原始数据、限制MTU、
+ * 从队列取出、结束后继续追加）分别用RTU_PacketBuilder和原来的BFL_RTU_Packet_encoder构建，逐字节比较；
+ * CRC16_Modbus_Shift和逐字节追加0的CRC比较。不发送，可以在目标板上运行。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "BFL_RTU_PacketBuilder_test.h"
+#include "BFL_RTU_Packet.h"
+#include "crc.h"
+
+#define TEST_VAR_MAX   64U
+#define TEST_QUEUE_LEN 37U
+
+static RTU_Sampling_Var_t vars[TEST_VAR_MAX];
+static uint8_t raw[RTU_PACKET_MAX_DATA_FILED_LEN];
+static uint8_t builder_buf[RTU_PACKET_MAX_LEN];
+// BFL_RTU_Packet_init给字节化缓冲的容量是capacity-4，给数据域的容量是capacity但从第4个字节开始，
+// 按最大数据包多给一个首部的容量，缓冲区再多一个首部的长度
+#define ENCODER_CAPACITY (RTU_PACKET_MAX_LEN + RTU_PACKET_HEADER_LEN)
+static uint8_t encoder_buf[ENCODER_CAPACITY + RTU_PACKET_HEADER_LEN];
+// 循环队列空出一个位置区分空和满
+static uint8_t queue_buf[(TEST_QUEUE_LEN + 1) * RTU_SAMPLING_VAR_T_SIZE];
+static uint32_t check_errors = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("[RTU_PacketBuilder Test]: check failed: %s\r\n", what);
+        check_errors++;
+    }
+}
+
+static void test_var_init()
+{
+    for (uint32_t i = 0; i < TEST_VAR_MAX; i++) {
+        uint8_t *p = (uint8_t *)&vars[i];
+        for (uint32_t j = 0; j < RTU_SAMPLING_VAR_T_SIZE; j++) {
+            p[j] = (uint8_t)(i * 29U + j * 7U + 1U);
+        }
+    }
+    for (uint32_t i = 0; i < sizeof(raw); i++) {
+        raw[i] = (uint8_t)(i * 13U + (i >> 8));
+    }
+}
+
+/**
+ * @brief 用原来的编码器构建数据域为data的数据包，和构建器的结果比较，并检查可以解码。
+ *
+ */
+static void compare_with_encoder(const char *name, const uint8_t *data, uint32_t len, const uint8_t *frame, uint32_t frame_len)
+{
+    RTU_Packet_t packet;
+    RTU_Packet_t decoded;
+    sc_byte_buffer *buf = NULL;
+    char what[96];
+
+    memset(encoder_buf, 0, sizeof(encoder_buf));
+    BFL_RTU_Packet_init(&packet, encoder_buf, ENCODER_CAPACITY);
+    BFL_RTU_Packet_push_data(&packet, data, len);
+    BFL_RTU_Packet_encoder(&packet);
+    buf = BFL_RTU_Packet_get_buffer(&packet);
+
+    snprintf(what, sizeof(what), "%s: length %u vs encoder %u", name, frame_len, (uint32_t)sc_byte_buffer_size(buf));
+    check(frame_len == sc_byte_buffer_size(buf), what);
+    snprintf(what, sizeof(what), "%s: bytes differ from encoder", name);
+    check(frame_len == sc_byte_buffer_size(buf) && memcmp(frame, sc_byte_buffer_data_ptr(buf), frame_len) == 0, what);
+    snprintf(what, sizeof(what), "%s: CRC over frame", name);
+    check(CRC16_Modbus(frame, frame_len) == 0, what);
+    snprintf(what, sizeof(what), "%s: decode", name);
+    memcpy(encoder_buf, frame, frame_len);
+    check(BFL_RTU_Packet_decoder(&decoded, encoder_buf, frame_len) == 0 && decoded.header.id == RTU_PACKET_ID &&
+              decoded.header.rem_len == len + RTU_PACKET_CRC_LEN,
+          what);
+}
+
+/**
+ * @brief 构建器中有var_num个采样点，依次是vars[first]开始的采样点。
+ *
+ */
+static void check_vars(const char *name, RTU_PacketBuilder_t *pbuilder, uint32_t first, uint32_t var_num)
+{
+    const uint8_t *frame = NULL;
+    uint32_t len         = 0;
+    char what[96];
+
+    snprintf(what, sizeof(what), "%s: var num", name);
+    check(BFL_RTU_PacketBuilder_get_Sampling_Var_num(pbuilder) == var_num, what);
+    frame = BFL_RTU_PacketBuilder_finish(pbuilder, &len);
+    compare_with_encoder(name, (const uint8_t *)&vars[first], var_num * RTU_SAMPLING_VAR_T_SIZE, frame, len);
+}
+
+static void shift_test()
+{
+    static const uint16_t crcs[]  = {0xFFFF, 0x0000, 0x0001, 0x8000, 0x1234, 0xA5C3};
+    static const uint32_t lens[]  = {0, 1, 2, 3, 5, 16, 17, 255, 256, 960, 4096, 65537};
+    static const uint8_t zeros[64] = {0};
+
+    for (uint32_t c = 0; c < sizeof(crcs) / sizeof(crcs[0]); c++) {
+        for (uint32_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+            uint16_t ref = crcs[c];
+            for (uint32_t done = 0; done < lens[l]; done += sizeof(zeros)) {
+                uint32_t n = lens[l] - done < sizeof(zeros) ? lens[l] - done : sizeof(zeros);
+                ref        = CRC16_Modbus_Update(ref, zeros, n);
+            }
+            if (CRC16_Modbus_Shift(crcs[c], lens[l]) != ref) {
+                printf("[RTU_PacketBuilder Test]: check failed: shift crc 0x%04X len %u\r\n", crcs[c], lens[l]);
+                check_errors++;
+            }
+        }
+    }
+    // 分段更新和一次计算相同
+    check(CRC16_Modbus_Update(CRC16_Modbus_Update(CRC16_MODBUS_INIT, raw, 7), raw + 7, 100) == CRC16_Modbus(raw, 107),
+          "split update");
+}
+
+/**
+ * @brief 流式构建器测试。
+ *
+ * @return int 0通过，1失败。
+ */
+int BFL_RTU_PacketBuilder_test()
+{
+    RTU_PacketBuilder_t builder;
+    CQueue_t queue;
+    const uint8_t *frame    = NULL;
+    uint32_t len            = 0;
+    uint32_t num            = 0;
+    uint32_t max_vars       = (RTU_PACKET_MAX_LEN - RTU_PACKET_MIN_LEN) / RTU_SAMPLING_VAR_T_SIZE;
+    static const uint32_t raw_lens[] = {1, 3, 7, 250};
+
+    check_errors = 0;
+    test_var_init();
+    shift_test();
+
+    check(BFL_RTU_PacketBuilder_init(&builder, builder_buf, RTU_PACKET_MIN_LEN, 0) == 0, "init rejects tiny buffer");
+    check(BFL_RTU_PacketBuilder_init(&builder, builder_buf, sizeof(builder_buf), 0) == 1, "init");
+
+    // 一个采样点
+    check(BFL_RTU_PacketBuilder_push_Sampling_Var(&builder, &vars[0]) == 1, "push one var");
+    check_vars("one var", &builder, 0, 1);
+
+    // 默认MTU内最多的采样点，再多一个放不下
+    BFL_RTU_PacketBuilder_reset(&builder);
+    for (uint32_t i = 0; i < max_vars; i++) {
+        check(BFL_RTU_PacketBuilder_push_Sampling_Var(&builder, &vars[i]) == 1, "push vars up to MTU");
+    }
+    check(BFL_RTU_PacketBuilder_residual_var_num(&builder) == 0, "no room after max vars");
+    check(BFL_RTU_PacketBuilder_push_Sampling_Var(&builder, &vars[max_vars]) == 0, "push past MTU rejected");
+    check_vars("max vars", &builder, 0, max_vars);
+
+    // 奇数长度的原始数据，分几次追加
+    BFL_RTU_PacketBuilder_reset(&builder);
+    num = 0;
+    for (uint32_t i = 0; i < sizeof(raw_lens) / sizeof(raw_lens[0]); i++) {
+        check(BFL_RTU_PacketBuilder_push_data(&builder, raw + num, raw_lens[i]) == raw_lens[i], "push raw");
+        num += raw_lens[i];
+    }
+    frame = BFL_RTU_PacketBuilder_finish(&builder, &len);
+    compare_with_encoder("raw bytes", raw, num, frame, len);
+
+    // 结束之后继续追加再结束，CRC覆盖的位置被新的数据覆盖
+    check(BFL_RTU_PacketBuilder_push_data(&builder, raw + num, 33) == 33, "push after finish");
+    frame = BFL_RTU_PacketBuilder_finish(&builder, &len);
+    compare_with_encoder("push after finish", raw, num + 33, frame, len);
+    frame = BFL_RTU_PacketBuilder_finish(&builder, &len);
+    compare_with_encoder("finish twice", raw, num + 33, frame, len);
+
+    // 限制MTU：数据包不超过256字节
+    check(BFL_RTU_PacketBuilder_init(&builder, builder_buf, sizeof(builder_buf), 256) == 1, "init with MTU");
+    num = BFL_RTU_PacketBuilder_residual_var_num(&builder);
+    check(num == (256 - RTU_PACKET_MIN_LEN) / RTU_SAMPLING_VAR_T_SIZE, "residual with MTU");
+    for (uint32_t i = 0; i < num; i++) {
+        BFL_RTU_PacketBuilder_push_Sampling_Var(&builder, &vars[i]);
+    }
+    check(BFL_RTU_PacketBuilder_push_data(&builder, raw, RTU_PACKET_CRC_LEN + 256) == 0, "raw past MTU rejected");
+    check_vars("MTU 256", &builder, 0, num);
+
+    // 从队列中直接取出：37个采样点按每包最多18个分成18、18、1
+    cqueue_create(&queue, queue_buf, TEST_QUEUE_LEN + 1, RTU_SAMPLING_VAR_T_SIZE);
+    check(cqueue_in(&queue, vars, TEST_QUEUE_LEN) == TEST_QUEUE_LEN, "queue fill");
+    check(BFL_RTU_PacketBuilder_init(&builder, builder_buf, sizeof(builder_buf), 300) == 1, "init for queue");
+    for (uint32_t first = 0; first < TEST_QUEUE_LEN; first += num) {
+        BFL_RTU_PacketBuilder_reset(&builder);
+        num = BFL_RTU_PacketBuilder_push_from_queue(&builder, &queue, TEST_QUEUE_LEN);
+        check(num == (TEST_QUEUE_LEN - first < 18 ? TEST_QUEUE_LEN - first : 18), "queue batch size");
+        if (num == 0) {
+            break;
+        }
+        check_vars("from queue", &builder, first, num);
+    }
+
+    printf("[RTU_PacketBuilder Test] %s\r\n", check_errors == 0 ? "pass" : "fail");
+    return check_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+/**
+ * @file BFL_RTU_PacketBuilder_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_RTU_PACKETBUILDER_TEST_H
+#define BFL_RTU_PACKETBUILDER_TEST_H
+
+int BFL_RTU_PacketBuilder_test();
+#endif // !BFL_RTU_PACKETBUILDER_TEST_H
@@ -0,0 +1,341 @@
+/**
+ * @file BFL_RTU_Packet_Delta.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 差分压缩的RTU数据包编解码，格式见BFL_RTU_Packet_Delta.h。
+ * @version 0.1
+ * @date 2023-10-22
+ * @last modified 2023-10-22
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include <stdbool.h>
+#include "BFL_RTU_Packet_Delta.h"
+#include "BFL_RTU_Packet.h"
+#include "crc.h"
+
+#define DELTA_MASK_WORD_NUM 4
+#define DELTA_MASK_RAW_TIME (1U << 4)
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t capacity;
+    uint32_t pos;
+    bool overflow;
+} DeltaWriter_t;
+
+typedef struct {
+    const uint8_t *buf;
+    uint32_t end;
+    uint32_t pos;
+    bool overflow;
+} DeltaReader_t;
+
+static uint32_t zigzag32(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag32(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static uint16_t var_word(const RTU_Sampling_Var_t *pvar, int i)
+{
+    return (uint16_t)(pvar->data[i * 2] | (pvar->data[i * 2 + 1] << 8));
+}
+
+static void var_set_word(RTU_Sampling_Var_t *pvar, int i, uint16_t word)
+{
+    pvar->data[i * 2]     = (uint8_t)(word & 0xFF);
+    pvar->data[i * 2 + 1] = (uint8_t)(word >> 8);
+}
+
+static uint64_t var_time_ms(const RTU_Sampling_Var_t *pvar)
+{
+    return (uint64_t)pvar->datetime * 1000U + pvar->ms;
+}
+
+/**
+ * @brief 与RTU_Sampling_Var_checksum相同：除checksum外所有字节之和的低8位。
+ *
+ * @param pvar
+ * @return uint8_t
+ */
+static uint8_t var_checksum(const RTU_Sampling_Var_t *pvar)
+{
+    const uint8_t *p = (const uint8_t *)pvar;
+    uint32_t sum     = 0;
+    for (uint32_t i = 0; i < RTU_SAMPLING_VAR_T_SIZE - 1; i++) {
+        sum += p[i];
+    }
+    return sum & 0xFF;
+}
+
+static void delta_put(DeltaWriter_t *w, const uint8_t *p, uint32_t len)
+{
+    if (w->pos + len > w->capacity) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->pos, p, len);
+    w->pos += len;
+}
+
+static void delta_put_le(DeltaWriter_t *w, uint32_t v, uint32_t len)
+{
+    uint8_t b[4];
+    for (uint32_t i = 0; i < len; i++) {
+        b[i] = (uint8_t)(v >> (i * 8));
+    }
+    delta_put(w, b, len);
+}
+
+static void delta_put_varint(DeltaWriter_t *w, uint32_t v)
+{
+    uint8_t b[5];
+    uint32_t len = 0;
+    while (v >= 0x80) {
+        b[len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    b[len++] = (uint8_t)v;
+    delta_put(w, b, len);
+}
+
+static void delta_get(DeltaReader_t *r, uint8_t *p, uint32_t len)
+{
+    if (r->pos + len > r->end) {
+        r->overflow = true;
+        memset(p, 0, len);
+        return;
+    }
+    memcpy(p, r->buf + r->pos, len);
+    r->pos += len;
+}
+
+static uint32_t delta_get_le(DeltaReader_t *r, uint32_t len)
+{
+    uint8_t b[4];
+    uint32_t v = 0;
+    delta_get(r, b, len);
+    for (uint32_t i = 0; i < len; i++) {
+        v |= (uint32_t)b[i] << (i * 8);
+    }
+    return v;
+}
+
+static uint32_t delta_get_varint(DeltaReader_t *r)
+{
+    uint32_t v = 0;
+    uint8_t b  = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7) {
+        delta_get(r, &b, 1);
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return v;
+        }
+    }
+    r->overflow = true;
+    return 0;
+}
+
+/**
+ * @brief 编码一组同类型的采样点，vars中从first开始所有类型相同的采样点。
+ *
+ */
+static void delta_encode_group(DeltaWriter_t *w, const RTU_Sampling_Var_t *vars, uint32_t num, uint32_t first)
+{
+    const RTU_Sampling_Var_t *pprev = &vars[first];
+    const RTU_Sampling_Var_t *pcur  = NULL;
+    uint8_t type                    = pprev->type;
+    uint32_t count                  = 0;
+    int64_t prevDelta               = 0;
+    int64_t delta                   = 0;
+    int64_t dod                     = 0;
+    uint8_t mask                    = 0;
+
+    for (uint32_t i = first; i < num; i++) {
+        count += vars[i].type == type;
+    }
+    delta_put(w, &type, 1);
+    delta_put_varint(w, count);
+    delta_put_le(w, pprev->datetime, 4);
+    delta_put_le(w, pprev->ms, 2);
+    delta_put(w, pprev->data, sizeof(pprev->data));
+
+    for (uint32_t i = first + 1; i < num; i++) {
+        if (vars[i].type != type) {
+            continue;
+        }
+        pcur = &vars[i];
+
+        mask = 0;
+        for (int k = 0; k < DELTA_MASK_WORD_NUM; k++) {
+            if (var_word(pcur, k) != var_word(pprev, k)) {
+                mask |= 1U << k;
+            }
+        }
+        // ms不在0-999时无法用毫秒时间戳表示，二阶差分超出32位时也直接传原始时间
+        if (pprev->ms >= 1000 || pcur->ms >= 1000) {
+            mask |= DELTA_MASK_RAW_TIME;
+        } else {
+            delta = (int64_t)(var_time_ms(pcur) - var_time_ms(pprev));
+            dod   = delta - prevDelta;
+            if (dod > INT32_MAX || dod < INT32_MIN) {
+                mask |= DELTA_MASK_RAW_TIME;
+            }
+        }
+
+        delta_put(w, &mask, 1);
+        if (mask & DELTA_MASK_RAW_TIME) {
+            delta_put_le(w, pcur->datetime, 4);
+            delta_put_le(w, pcur->ms, 2);
+            prevDelta = 0;
+        } else {
+            delta_put_varint(w, zigzag32((int32_t)dod));
+            prevDelta = delta;
+        }
+        for (int k = 0; k < DELTA_MASK_WORD_NUM; k++) {
+            if (mask & (1U << k)) {
+                delta_put_varint(w, zigzag32((int16_t)(var_word(pcur, k) - var_word(pprev, k))));
+            }
+        }
+        pprev = pcur;
+    }
+}
+
+/**
+ * @brief 把一批采样点编码为差分压缩的RTU数据包。采样点按传感器类型分组，组内保持原来的顺序，
+ * 组的顺序为每种类型第一次出现的顺序。
+ *
+ * @param vars 采样点数组。
+ * @param num 采样点个数。
+ * @param buf 存放数据包的缓冲区，最多需要RTU_PACKET_DELTA_MAX_LEN(num)字节。
+ * @param capacity 缓冲区容量。
+ * @return uint32_t 数据包长度，0表示缓冲区不够或者没有采样点。
+ */
+uint32_t BFL_RTU_Packet_Delta_encode(const RTU_Sampling_Var_t *vars, uint32_t num, uint8_t *buf, uint32_t capacity)
+{
+    DeltaWriter_t w = {buf, capacity, RTU_PACKET_HEADER_LEN, false};
+    uint32_t rem_len = 0;
+    uint16_t crc     = 0;
+    bool seen        = false;
+
+    if (num == 0 || capacity < RTU_PACKET_MIN_LEN) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < num && !w.overflow; i++) {
+        seen = false;
+        for (uint32_t j = 0; j < i; j++) {
+            if (vars[j].type == vars[i].type) {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen) {
+            delta_encode_group(&w, vars, num, i);
+        }
+    }
+
+    rem_len = w.pos - RTU_PACKET_HEADER_LEN + RTU_PACKET_CRC_LEN;
+    if (w.overflow || w.pos + RTU_PACKET_CRC_LEN > capacity || rem_len > 0xFFFF) {
+        return 0;
+    }
+
+    buf[0] = (uint8_t)(RTU_PACKET_DELTA_ID & 0xFF);
+    buf[1] = (uint8_t)(RTU_PACKET_DELTA_ID >> 8);
+    buf[2] = (uint8_t)(rem_len & 0xFF);
+    buf[3] = (uint8_t)(rem_len >> 8);
+    crc    = CRC16_Modbus_Update(CRC16_MODBUS_INIT, buf, w.pos);
+    // crc端序
+    buf[w.pos]     = (uint8_t)(crc >> 8);
+    buf[w.pos + 1] = (uint8_t)(crc & 0xFF);
+    return w.pos + RTU_PACKET_CRC_LEN;
+}
+
+/**
+ * @brief 解码差分压缩的RTU数据包，还原出的采样点按类型分组排列，checksum重新计算。
+ *
+ * @param data 数据包。
+ * @param len 数据包长度。
+ * @param vars 存放解码结果的数组。
+ * @param capacity 数组能存放的采样点个数。
+ * @param pnum 解码出的采样点个数。
+ * @return uint8_t 0成功，1长度、标识符或者CRC错误，2格式错误，3数组容量不够。
+ */
+uint8_t BFL_RTU_Packet_Delta_decode(const uint8_t *data, uint32_t len, RTU_Sampling_Var_t *vars, uint32_t capacity, uint32_t *pnum)
+{
+    DeltaReader_t r          = {data, 0, RTU_PACKET_HEADER_LEN, false};
+    RTU_Sampling_Var_t *pvar = NULL;
+    RTU_Sampling_Var_t *prev = NULL;
+    uint32_t num             = 0;
+    uint32_t count           = 0;
+    uint8_t type             = 0;
+    uint8_t mask             = 0;
+    int64_t prevDelta        = 0;
+    uint64_t t               = 0;
+
+    *pnum = 0;
+    if (len < RTU_PACKET_MIN_LEN || CRC16_Modbus_Update(CRC16_MODBUS_INIT, data, len) != 0) {
+        return 1;
+    }
+    if ((data[0] | (data[1] << 8)) != RTU_PACKET_DELTA_ID || (uint32_t)(data[2] | (data[3] << 8)) != len - RTU_PACKET_HEADER_LEN) {
+        return 1;
+    }
+    r.end = len - RTU_PACKET_CRC_LEN;
+
+    while (r.pos < r.end) {
+        delta_get(&r, &type, 1);
+        count = delta_get_varint(&r);
+        if (r.overflow || count == 0) {
+            return 2;
+        }
+        if (count > capacity - num) {
+            return 3;
+        }
+
+        pvar = &vars[num];
+        memset(pvar, 0, sizeof(RTU_Sampling_Var_t));
+        pvar->type     = type;
+        pvar->datetime = delta_get_le(&r, 4);
+        pvar->ms       = (uint16_t)delta_get_le(&r, 2);
+        delta_get(&r, pvar->data, sizeof(pvar->data));
+        pvar->checksum = var_checksum(pvar);
+        prevDelta      = 0;
+
+        for (uint32_t i = 1; i < count; i++) {
+            prev  = pvar;
+            pvar  = &vars[num + i];
+            *pvar = *prev;
+
+            delta_get(&r, &mask, 1);
+            if (mask & DELTA_MASK_RAW_TIME) {
+                pvar->datetime = delta_get_le(&r, 4);
+                pvar->ms       = (uint16_t)delta_get_le(&r, 2);
+                prevDelta      = 0;
+            } else {
+                prevDelta += unzigzag32(delta_get_varint(&r));
+                t              = var_time_ms(prev) + (uint64_t)prevDelta;
+                pvar->datetime = (uint32_t)(t / 1000U);
+                pvar->ms       = (uint16_t)(t % 1000U);
+            }
+            for (int k = 0; k < DELTA_MASK_WORD_NUM; k++) {
+                if (mask & (1U << k)) {
+                    var_set_word(pvar, k, (uint16_t)(var_word(prev, k) + (uint16_t)unzigzag32(delta_get_varint(&r))));
+                }
+            }
+            pvar->checksum = var_checksum(pvar);
+        }
+        if (r.overflow) {
+            return 2;
+        }
+        num += count;
+    }
+
+    *pnum = num;
+    return 0;
+}
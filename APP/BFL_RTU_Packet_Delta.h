@@ -0,0 +1,35 @@
+/**
+ * @file BFL_RTU_Packet_Delta.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 差分压缩的RTU数据包，用于批量上传周期性采样点。
+ * 帧格式与RTU数据包相同，只是标识符不同：
+ * | id 0xAA56(LE,2) | rem_len(LE,2) | 分组... | CRC16(高字节在前,2) |
+ * 采样点按传感器类型分组，每组：
+ * | type(1) | count(varint) | 第一个采样点 datetime(LE,4) ms(LE,2) data(8) | 后续采样点... |
+ * 后续采样点：
+ * | mask(1) | 时间 | 数据差分 |
+ * mask bit0-3：data按4个int16(LE)分段，对应段与上一个采样点不同，后面跟zigzag varint编码的差值；
+ * mask bit4：时间为原始的datetime(LE,4) ms(LE,2)，否则为时间(ms)二阶差分的zigzag varint。
+ * 采样点的checksum不传输，解码时重新计算。
+ * 这个文件不依赖硬件，可以直接在上位机上编译解码。
+ * @version 0.1
+ * @date 2023-10-22
+ * @last modified 2023-10-22
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_RTU_PACKET_DELTA_H
+#define BFL_RTU_PACKET_DELTA_H
+#include <stdint.h>
+#include "APP_RTU_Sampler.h"
+
+#define RTU_PACKET_DELTA_ID 0xAA56U
+// 最坏情况下每个采样点编码后的长度：mask(1)+原始时间(6)+4段差分(3*4)，再加上分组头(type+count)
+#define RTU_PACKET_DELTA_VAR_MAX_LEN 23U
+// num个采样点编码后数据包的最大长度
+#define RTU_PACKET_DELTA_MAX_LEN(num) (4U + 2U + (num) * RTU_PACKET_DELTA_VAR_MAX_LEN)
+
+uint32_t BFL_RTU_Packet_Delta_encode(const RTU_Sampling_Var_t *vars, uint32_t num, uint8_t *buf, uint32_t capacity);
+uint8_t BFL_RTU_Packet_Delta_decode(const uint8_t *data, uint32_t len, RTU_Sampling_Var_t *vars, uint32_t capacity, uint32_t *pnum);
+#endif // !BFL_RTU_PACKET_DELTA_H
@@ -0,0 +1,144 @@
+/**
+ * @file BFL_RTU_Packet_Delta_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-22
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "BFL_RTU_Packet_Delta_test.h"
+#include "BFL_RTU_Packet_Delta.h"
+
+#define TEST_VAR_NUM 64
+
+static RTU_Sampling_Var_t vars[TEST_VAR_NUM];
+static RTU_Sampling_Var_t expect[TEST_VAR_NUM];
+static RTU_Sampling_Var_t decoded[TEST_VAR_NUM];
+static uint8_t packet_buf[RTU_PACKET_DELTA_MAX_LEN(TEST_VAR_NUM)];
+
+static void test_var_set(RTU_Sampling_Var_t *pvar, uint8_t type, uint32_t datetime, uint16_t ms, const int16_t *words)
+{
+    uint32_t sum = 0;
+    memset(pvar, 0, sizeof(RTU_Sampling_Var_t));
+    pvar->type     = type;
+    pvar->datetime = datetime;
+    pvar->ms       = ms;
+    memcpy(pvar->data, words, sizeof(pvar->data));
+    for (uint32_t i = 0; i < RTU_SAMPLING_VAR_T_SIZE - 1; i++) {
+        sum += ((uint8_t *)pvar)[i];
+    }
+    pvar->checksum = sum & 0xFF;
+}
+
+/**
+ * @brief 编码再解码，结果应该与按类型稳定分组后的输入完全相同。
+ *
+ * @return int 0通过，1失败。
+ */
+static int delta_round_trip(const char *name, uint32_t num)
+{
+    uint32_t len      = 0;
+    uint32_t out_num  = 0;
+    uint32_t expect_n = 0;
+    uint8_t ret       = 0;
+
+    // 期望的顺序：按每种类型第一次出现的顺序分组，组内保持原来的顺序
+    for (uint32_t i = 0; i < num; i++) {
+        bool seen = false;
+        for (uint32_t j = 0; j < i; j++) {
+            seen = seen || vars[j].type == vars[i].type;
+        }
+        for (uint32_t j = i; j < num && !seen; j++) {
+            if (vars[j].type == vars[i].type) {
+                expect[expect_n++] = vars[j];
+            }
+        }
+    }
+
+    len = BFL_RTU_Packet_Delta_encode(vars, num, packet_buf, sizeof(packet_buf));
+    ret = BFL_RTU_Packet_Delta_decode(packet_buf, len, decoded, TEST_VAR_NUM, &out_num);
+    if (len == 0 || ret != 0 || out_num != num || memcmp(decoded, expect, num * sizeof(RTU_Sampling_Var_t)) != 0) {
+        printf("[RTU_Packet Test]: %s FAIL len:%u ret:%u num:%u\r\n", name, len, ret, out_num);
+        return 1;
+    }
+    printf("[RTU_Packet Test]: %s PASS %u vars %u -> %u bytes (%.1fx)\r\n", name, num,
+           num * RTU_SAMPLING_VAR_T_SIZE + 6, len, (num * RTU_SAMPLING_VAR_T_SIZE + 6) * 1.0f / len);
+    return 0;
+}
+
+/**
+ * @brief 差分压缩RTU数据包编解码往返测试。
+ *
+ * @return int 失败的用例数。
+ */
+int BFL_RTU_Packet_Delta_test()
+{
+    int fail         = 0;
+    int16_t words[4] = {0};
+    uint32_t len     = 0;
+    uint32_t num     = 0;
+
+    // 1. 同一传感器，1s一个，数据缓慢变化
+    for (int i = 0; i < 22; i++) {
+        words[0] = 2500 + i % 3;
+        words[1] = -120;
+        words[2] = (int16_t)(i * 5);
+        words[3] = 0;
+        test_var_set(&vars[i], SENSOR_CODE_TEMP_HUMI, 1697900000U + i, 0, words);
+    }
+    fail += delta_round_trip("periodic", 22);
+
+    // 2. 多种传感器交替，带毫秒和抖动
+    for (int i = 0; i < 48; i++) {
+        words[0] = (int16_t)(rand() % 200 - 100);
+        words[1] = (int16_t)(i * 1000);
+        words[2] = (int16_t)rand();
+        words[3] = (int16_t)(i & 1);
+        test_var_set(&vars[i], (uint8_t)(SENSOR_CODE_WIND_SPEED_AND_DIRECTION + i % 3), 1697900000U + i / 3, (uint16_t)(i * 37 % 1000), words);
+    }
+    fail += delta_round_trip("interleaved", 48);
+
+    // 3. 时间倒退、跳变、非法毫秒需要原始时间
+    for (int i = 0; i < 8; i++) {
+        words[0] = (int16_t)(INT16_MAX - i);
+        words[1] = INT16_MIN;
+        words[2] = (int16_t)(i % 2 ? INT16_MAX : INT16_MIN);
+        words[3] = (int16_t)i;
+        test_var_set(&vars[i], SENSOR_CODE_DISPLACEMENTx(1), i % 2 ? 0xFFFFFFF0U : 5U, (uint16_t)(i == 4 ? 1500 : 999), words);
+    }
+    fail += delta_round_trip("extreme", 8);
+
+    // 4. 随机字节
+    for (int i = 0; i < TEST_VAR_NUM; i++) {
+        for (int k = 0; k < 4; k++) {
+            words[k] = (int16_t)rand();
+        }
+        test_var_set(&vars[i], (uint8_t)(rand() % 4), (uint32_t)rand(), (uint16_t)(rand() % 1000), words);
+    }
+    fail += delta_round_trip("random", TEST_VAR_NUM);
+
+    // 5. 损坏的数据包和不够的容量要被拒绝
+    len = BFL_RTU_Packet_Delta_encode(vars, 10, packet_buf, sizeof(packet_buf));
+    if (BFL_RTU_Packet_Delta_decode(packet_buf, len, decoded, 5, &num) != 3) {
+        printf("[RTU_Packet Test]: capacity FAIL\r\n");
+        fail++;
+    }
+    packet_buf[len / 2] ^= 0x01;
+    if (BFL_RTU_Packet_Delta_decode(packet_buf, len, decoded, TEST_VAR_NUM, &num) != 1) {
+        printf("[RTU_Packet Test]: corrupt FAIL\r\n");
+        fail++;
+    }
+    if (BFL_RTU_Packet_Delta_encode(vars, 10, packet_buf, 20) != 0) {
+        printf("[RTU_Packet Test]: small buffer FAIL\r\n");
+        fail++;
+    }
+
+    printf("[RTU_Packet Test]: delta %s\r\n", fail == 0 ? "PASS" : "FAIL");
+    return fail;
+}
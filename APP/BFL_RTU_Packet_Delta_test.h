@@ -0,0 +1,15 @@
+/**
+ * @file BFL_RTU_Packet_Delta_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-22
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_RTU_PACKET_DELTA_TEST_H
+#define BFL_RTU_PACKET_DELTA_TEST_H
+
+int BFL_RTU_Packet_Delta_test();
+#endif // !BFL_RTU_PACKET_DELTA_TEST_H
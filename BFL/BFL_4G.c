@@ -18,8 +18,12 @@
 #include "ccommon.h"
 #include "log.h"
 #include "BFL_4G_Task.h"
+#include "BFL_4G_MQTT_Task.h"
+#include "HDL_Uart.h"
+#include "CHIP_EC800M.h"
 
-#define SOCKET_BUF_SIZE 512
+#define SOCKET_BUF_SIZE      512
+#define SOCKET_SEND_BUF_SIZE 2048
 AsyncTaskExecContext_t context;
 
 void BFL_4G_Init(const char *PDP_type, const char *APN)
@@ -60,6 +64,11 @@ int32_t BFL_4G_TCP_Init(int sockid, const char *hostAddr, uint16_t port)
         BFL_4G_TCP_Task_UCRTable_Init(sockid);
         context.socketRevBufs[sockid] = (uint8_t *)at_malloc(SOCKET_BUF_SIZE);
         cqueue_create(&context.socketRevQueues[sockid], context.socketRevBufs[sockid], SOCKET_BUF_SIZE, sizeof(uint8_t));
+        context.socketWrites[sockid].sendBuf = (uint8_t *)at_malloc(SOCKET_SEND_BUF_SIZE);
+        cqueue_create(&context.socketWrites[sockid].sendQueue, context.socketWrites[sockid].sendBuf, SOCKET_SEND_BUF_SIZE, sizeof(uint8_t));
+        if (context.socketWrites[sockid].weight == 0) {
+            context.socketWrites[sockid].weight = BFL_4G_SOCKET_SEND_WEIGHT_DEF;
+        }
     }
     return 0;
 }
@@ -73,12 +82,7 @@ uint32_t BFL_4G_TCP_Write(int sockid, uint8_t *writeBuf, uint32_t uLen)
 
 uint32_t BFL_4G_TCP_Writeable(int sockid)
 {
-    UNUSED(sockid);
-    uint32_t ret = 0;
-    bool result  = false;
-    result       = BFL_4G_TCP_Task_Writeable();
-    ret          = (uint32_t)result;
-    return ret;
+    return BFL_4G_TCP_Task_Writeable(sockid);
 }
 
 uint32_t BFL_4G_TCP_Read(int sockid, unsigned char *pBuf, uint32_t uiLen)
@@ -93,10 +97,82 @@ uint32_t BFL_4G_TCP_Readable(int sockid)
     return cqueue_size(&context.socketRevQueues[sockid]);
 }
 
+bool BFL_4G_TCP_IsConnected(int sockid)
+{
+    return BFL_4G_TCP_Task_IsConnected(sockid);
+}
+
+void BFL_4G_TCP_LinkStatShow(int sockid)
+{
+    BFL_4G_TCP_Task_LinkStatShow(sockid);
+}
+
+void BFL_4G_TCP_SetWeight(int sockid, uint8_t weight)
+{
+    BFL_4G_TCP_Task_SetWeight(sockid, weight);
+}
+
+void BFL_4G_TCP_GetStat(int sockid, BFL_4G_TCP_Stat_t *pStat)
+{
+    BFL_4G_TCP_Task_GetStat(sockid, pStat);
+}
+
 void BFL_4G_Poll()
 {
     at_obj_process(context.at_obj);
     AsyncTaskList_Exec(context.task_list);
+    BFL_4G_TCP_Poll_Task();
+    BFL_4G_MQTT_Poll_Task();
+}
+
+bool BFL_4G_HasPendingWork()
+{
+    return Uart_AvailableBytes(CHIP_EC800M_COM) > 0 || BFL_4G_TCP_HasPendingWork_Task() || BFL_4G_MQTT_HasPendingWork_Task();
+}
+
+int32_t BFL_4G_MQTT_Init(const char *hostName, uint32_t port, const char *clientID, const char *userName, const char *password)
+{
+    return BFL_4G_MQTT_TaskList_Create(hostName, port, clientID, userName, password);
+}
+
+int32_t BFL_4G_MQTT_Subscribe(int mqttSubId, const char *topic, uint8_t qos, BFL_4G_MQTT_SubHandler_t handler)
+{
+    return BFL_4G_MQTT_Subscribe_Task(mqttSubId, topic, qos, handler);
+}
+
+int32_t BFL_4G_MQTT_PublishTopicInit(int mqttPubId, const char *topic, bool batch)
+{
+    return BFL_4G_MQTT_PublishTopic_Task(mqttPubId, topic, batch);
+}
+
+bool BFL_4G_MQTT_IsConnected()
+{
+    return BFL_4G_MQTT_IsConnected_Task();
+}
+
+void BFL_4G_MQTT_StatShow()
+{
+    BFL_4G_MQTT_StatShow_Task();
+}
+
+uint32_t BFL_4G_MQTT_Write(int mqttPubId, const uint8_t *payload, uint32_t uiLen, uint8_t qos, uint8_t retain)
+{
+    return BFL_4G_MQTT_Write_Task(mqttPubId, payload, uiLen, qos, retain);
+}
+
+bool BFL_4G_MQTT_Writeable(int mqttPubId)
+{
+    return BFL_4G_MQTT_Writeable_Task(mqttPubId);
+}
+
+uint32_t BFL_4G_MQTT_Read(int mqttSubId, uint8_t *pBuf, uint32_t uiLen)
+{
+    return BFL_4G_MQTT_Read_Task(mqttSubId, pBuf, uiLen);
+}
+
+bool BFL_4G_MQTT_Readable(int mqttSubId)
+{
+    return BFL_4G_MQTT_Readable_Task(mqttSubId);
 }
 
 void BFL_4G_SetCalibrateTimeByUtcSecondsCb(void (*setCalibrateTimeByUtcSecondsCb)(uint64_t utcSeconds))
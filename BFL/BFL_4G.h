@@ -18,11 +18,30 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "BFL_4G_MQTT_Task.h"
 
 #define SOCKET0 0
 #define SOCKET1 1
 #define SOCKET2 2
 
+/**
+ * @brief Socket发送统计。
+ *
+ */
+typedef struct {
+    uint32_t txBytes;     // 发送成功的字节数
+    uint32_t txTimes;     // QISEND成功次数
+    uint32_t txFailTimes; // QISEND失败次数
+    uint32_t txRateBps;   // 最近一个统计窗口的发送速率，byte/s
+    uint32_t lastSendMs;  // QISEND往返耗时
+    uint32_t maxSendMs;
+    uint32_t avgSendMs;
+    uint32_t lastWaitMs; // 数据从写入到开始发送的排队时间
+    uint32_t maxWaitMs;
+    uint32_t queued;    // 发送队列中还没有发送成功的字节数
+    uint32_t dropBytes; // 发送队列满了丢弃的字节数
+} BFL_4G_TCP_Stat_t;
+
 /**
  * @brief 4G模块初始化。
  *
@@ -51,12 +70,103 @@ uint32_t BFL_4G_TCP_Read(int sockid, unsigned char *pBuf, uint32_t uiLen);
 uint32_t BFL_4G_TCP_Writeable(int sockid);
 uint32_t BFL_4G_TCP_Readable(int sockid);
 
+/**
+ * @brief Socket链路当前是否已连接。断线后会按指数退避自动重连，重连期间未发送成功的数据会保留并在恢复后重发。
+ *
+ * @param sockid
+ * @return true
+ * @return false
+ */
+bool BFL_4G_TCP_IsConnected(int sockid);
+
+/**
+ * @brief 打印Socket的重连统计：重连次数、最近/最大/平均重连耗时。
+ *
+ * @param sockid
+ */
+void BFL_4G_TCP_LinkStatShow(int sockid);
+
+/**
+ * @brief 设置Socket的发送权重，默认1。多个socket同时有数据要发送时，
+ * 每一轮按权重分配可以发送的字节数，大量积压的socket不会长时间阻塞其他socket。
+ *
+ * @param sockid
+ * @param weight 1-255
+ */
+void BFL_4G_TCP_SetWeight(int sockid, uint8_t weight);
+
+/**
+ * @brief 获取Socket的发送吞吐量和延时统计。
+ *
+ * @param sockid
+ * @param pStat
+ */
+void BFL_4G_TCP_GetStat(int sockid, BFL_4G_TCP_Stat_t *pStat);
+
 /**
  * @brief 模块轮询处理
  *
  */
 void BFL_4G_Poll();
 
+/**
+ * @brief 模块是否有马上需要BFL_4G_Poll处理的工作：串口收到了数据，或者有数据等待发送。
+ * 只是在等待模组应答时返回false，应答到来时串口中断会唤醒CPU。
+ *
+ * @return true 有工作需要处理。
+ * @return false 可以低功耗空闲。
+ */
+bool BFL_4G_HasPendingWork();
+
+/**
+ * @brief MQTT初始化，需要在BFL_4G_Init之后调用。
+ *
+ * @param hostName 服务器地址
+ * @param port 服务器端口
+ * @param clientID 客户端ID
+ * @param userName 用户名，为NULL时不使用用户名密码登录。
+ * @param password 密码
+ * @return int32_t 0成功，-1失败。
+ */
+int32_t BFL_4G_MQTT_Init(const char *hostName, uint32_t port, const char *clientID, const char *userName, const char *password);
+
+/**
+ * @brief 配置订阅ID对应的主题，主题过滤器支持'+'和'#'通配符。
+ * 收到的消息按订阅ID顺序匹配第一个符合的主题过滤器，handler不为NULL时直接回调，
+ * 否则放入该订阅ID的接收队列，通过BFL_4G_MQTT_Read读取。
+ *
+ * @param mqttSubId
+ * @param topic
+ * @param qos
+ * @param handler 可以为NULL
+ * @return int32_t 0成功，-1失败。
+ */
+int32_t BFL_4G_MQTT_Subscribe(int mqttSubId, const char *topic, uint8_t qos, BFL_4G_MQTT_SubHandler_t handler);
+
+/**
+ * @brief 配置发布ID对应的主题。
+ *
+ * @param mqttPubId
+ * @param topic
+ * @param batch 是否把连续写入的同一发布ID的消息合并成一次发布，适合数据流式的主题。
+ * @return int32_t 0成功，-1失败。
+ */
+int32_t BFL_4G_MQTT_PublishTopicInit(int mqttPubId, const char *topic, bool batch);
+
+/**
+ * @brief MQTT是否已经连接。
+ *
+ * @return true
+ * @return false
+ */
+bool BFL_4G_MQTT_IsConnected();
+
+/**
+ * @brief 打印MQTT的发布、接收、溢出和重连统计。
+ *
+ */
+void BFL_4G_MQTT_StatShow();
+
 /**
  * @brief
  *
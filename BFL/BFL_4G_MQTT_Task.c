@@ -0,0 +1,1085 @@
+/**
+ * @file BFL_4G_MQTT_Task.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 基于EC800M AT+QMT*指令的MQTT客户端。
+ * 发送队列中的消息以记录的形式存放：
+ * | 0xA5 | pubId | qos|retain<<2 | len(LE,2) | payload | CRC16(高字节在前) |
+ * 内存队列写满后记录溢出到W25Q512的QFS中，记录不会跨越扇区，扇区尾部放不下时用0xFF填充，
+ * 这样QFS掉电恢复后从扇区开始读取总是记录的开始（QFS为空时直接从写入缓存读出的部分在扇区开头填充0xFF，
+ * 恢复时逐字节跳过）。QoS1的消息只有收到PUBACK后才从队列中删除。
+ * @version 0.1
+ * @date 2023-10-20
+ * @last modified 2023-10-20
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "BFL_4G_MQTT_Task.h"
+#include "BFL_4G_Task.h"
+#include "BFL_4G.h"
+#include "log.h"
+#include "at_chat.h"
+#include "cqueue.h"
+#include "crc.h"
+#include "ccommon.h"
+#if BFL_4G_MQTT_USING_QFS_SPILL
+#include "CHIP_W25Q512_QueueFileSystem.h"
+#endif
+
+#define MQTT_RECORD_MAGIC     0xA5
+#define MQTT_RECORD_HEAD_SIZE 5
+#define MQTT_RECORD_CRC_SIZE  2
+#define MQTT_RECORD_SIZE(LEN) (MQTT_RECORD_HEAD_SIZE + (LEN) + MQTT_RECORD_CRC_SIZE)
+
+// 连接任务链卡住（例如被socket的恢复过程提前结束了静态任务表）时，超过这个时间重新触发重连
+#define MQTT_CHAIN_TIMEOUT_MS (120 * 1000)
+
+#define MQTT_STR_(X) #X
+#define MQTT_STR(X)  MQTT_STR_(X)
+
+typedef struct {
+    BFL_4G_MQTT_SubHandler_t handler;
+    CQueue_t rxQueue; // 接收到的消息：| len(LE,2) | payload |
+    bool subscribed;
+} MQTT_Sub_t;
+
+typedef struct {
+    bool inited;
+    bool connected;
+    bool chainRunning;     // 连接任务链正在执行，期间不再触发重连
+    bool recoverFromCheck; // 只重建MQTT层，连接任务链结束后直接结束静态任务表
+    uint32_t chainMoment;
+    bool publishBatch[ALLOWED_PUBLIC_TOPIC_NUM];
+    MQTT_Sub_t subs[ALLOWED_SUBSCRIBE_TOPIC_NUM];
+    int subNext;
+
+    CQueue_t txQueue;
+    // 正在发布的消息
+    bool inflight;
+    uint16_t msgId;
+    int pubId;
+    uint8_t pubFlags;
+    uint32_t pubLen;         // 荷载长度
+    uint32_t pubRecordBytes; // 在发送队列中占用的字节数
+    uint32_t pubRecordNum;   // 合并了多少条消息
+    uint32_t pubStartMoment;
+    uint32_t pubFailTimes;
+    uint32_t pubRetryMoment;
+    uint32_t pubRetryDelay;
+
+    // Flash溢出
+    uint32_t spillBytes;
+    uint32_t spillWriteOffset; // 写位置在扇区内的偏移
+    uint32_t spillReadOffset;  // 读位置在扇区内的偏移
+    uint32_t spillSkip;        // 还需要跳过的填充字节数
+    uint32_t spillRecordGot;   // 正在重组的记录已经读到的字节数
+    bool spillFiller;          // 掉电恢复的第一个扇区开头可能有QFS填充的0xFF，逐字节跳过
+
+    // 重连
+    AsyncTask_t *checkTask;
+    AsyncTask_t *closeTask;
+    uint32_t backoffTimes;
+    bool isOutage;
+    uint32_t outageMoment;
+
+    // 统计
+    uint32_t pubTimes;
+    uint32_t pubMsgNum;
+    uint32_t pubBytes;
+    uint32_t lastAckMs;
+    uint32_t maxAckMs;
+    uint32_t writeDropTimes;
+    uint32_t recvTimes;
+    uint32_t recvDropTimes;
+    uint32_t spillCorruptTimes;
+    uint32_t reconnectTimes;
+    uint32_t lastReconnectMs;
+    uint32_t maxReconnectMs;
+} MQTT_t;
+
+extern AsyncTaskExecContext_t context;
+void at_link_idle_task_send(void *param);
+int32_t AsyncTaskFuncResultMap(at_resp_code code);
+
+static MQTT_t mqtt;
+static uint8_t mqtt_tx_ram_buf[BFL_4G_MQTT_TX_RAM_SIZE];
+static uint8_t mqtt_sub_rx_buf[ALLOWED_SUBSCRIBE_TOPIC_NUM][BFL_4G_MQTT_SUB_RX_SIZE];
+static uint8_t mqtt_pub_buf[BFL_4G_MQTT_BATCH_SIZE];
+static uint8_t mqtt_record_buf[MQTT_RECORD_SIZE(BFL_4G_MQTT_PAYLOAD_MAX)];
+static uint8_t mqtt_rx_buf[BFL_4G_MQTT_PAYLOAD_MAX];
+static char mqtt_pub_suffix[32];
+static char mqtt_sub_suffix[32];
+static char mqtt_cfg_cmd_bufs[6][48];
+static const char *mqtt_cfg_cmds[6 + 1];
+#if BFL_4G_MQTT_USING_QFS_SPILL
+static uint8_t mqtt_spill_record_buf[MQTT_RECORD_SIZE(BFL_4G_MQTT_PAYLOAD_MAX)];
+#endif
+
+static void at_mqtt_down(bool trigger);
+static void at_mqtt_up();
+
+static uint16_t at_mqtt_next_msg_id()
+{
+    mqtt.msgId++;
+    if (mqtt.msgId == 0) {
+        mqtt.msgId = 1;
+    }
+    return mqtt.msgId;
+}
+
+static uint32_t at_mqtt_record_encode(uint8_t *rec, int pubId, uint8_t qos, uint8_t retain, const uint8_t *payload, uint32_t uiLen)
+{
+    uint16_t crc = 0;
+
+    rec[0] = MQTT_RECORD_MAGIC;
+    rec[1] = (uint8_t)pubId;
+    rec[2] = (uint8_t)((qos & 0x03) | ((retain & 0x01) << 2));
+    rec[3] = (uint8_t)(uiLen & 0xFF);
+    rec[4] = (uint8_t)(uiLen >> 8);
+    memcpy(rec + MQTT_RECORD_HEAD_SIZE, payload, uiLen);
+    crc                                       = CRC16_Modbus(rec, MQTT_RECORD_HEAD_SIZE + uiLen);
+    rec[MQTT_RECORD_HEAD_SIZE + uiLen]        = (uint8_t)(crc >> 8);
+    rec[MQTT_RECORD_HEAD_SIZE + uiLen + 1]    = (uint8_t)(crc & 0xFF);
+    return MQTT_RECORD_SIZE(uiLen);
+}
+
+static bool at_mqtt_record_check(const uint8_t *rec, uint32_t uiLen)
+{
+    uint16_t crc = CRC16_Modbus(rec, MQTT_RECORD_HEAD_SIZE + uiLen);
+    return rec[MQTT_RECORD_HEAD_SIZE + uiLen] == (uint8_t)(crc >> 8) &&
+           rec[MQTT_RECORD_HEAD_SIZE + uiLen + 1] == (uint8_t)(crc & 0xFF);
+}
+
+#if BFL_4G_MQTT_USING_QFS_SPILL
+/**
+ * @brief 记录写入QFS，放不下当前扇区剩余空间时先用0xFF填充到扇区结束。
+ *
+ * @param rec
+ * @param recLen
+ * @return true 写入成功
+ * @return false QFS空间不足
+ */
+static bool at_mqtt_spill_push(uint8_t *rec, uint32_t recLen)
+{
+    uint8_t fill[32];
+    uint32_t pad  = 0;
+    uint32_t len  = 0;
+    uint32_t room = W25Q512_SECTOR_SIZE - mqtt.spillWriteOffset;
+
+    if (room < recLen) {
+        pad = room;
+    }
+    if (CHIP_W25Q512_QFS_residual_byte_size() < pad + recLen) {
+        return false;
+    }
+
+    memset(fill, 0xFF, sizeof(fill));
+    while (len < pad) {
+        len += CHIP_W25Q512_QFS_push(fill, pad - len > sizeof(fill) ? sizeof(fill) : pad - len);
+    }
+    CHIP_W25Q512_QFS_push(rec, recLen);
+
+    mqtt.spillWriteOffset = (mqtt.spillWriteOffset + pad + recLen) % W25Q512_SECTOR_SIZE;
+    mqtt.spillBytes += pad + recLen;
+    return true;
+}
+
+static void at_mqtt_spill_consume(uint32_t len)
+{
+    mqtt.spillBytes -= len;
+    mqtt.spillReadOffset = (mqtt.spillReadOffset + len) % W25Q512_SECTOR_SIZE;
+}
+
+static void at_mqtt_spill_resync()
+{
+    mqtt.spillCorruptTimes++;
+    mqtt.spillRecordGot = 0;
+    mqtt.spillSkip      = (W25Q512_SECTOR_SIZE - mqtt.spillReadOffset) % W25Q512_SECTOR_SIZE;
+    if (mqtt.spillSkip > mqtt.spillBytes) {
+        mqtt.spillSkip = mqtt.spillBytes;
+    }
+}
+
+/**
+ * @brief 内存队列有空位时把QFS中的记录读回内存队列，QFS芯片忙时读不到数据就下次再读。
+ *
+ */
+static void at_mqtt_spill_refill()
+{
+    uint8_t *rec        = mqtt_spill_record_buf;
+    uint32_t need       = 0;
+    uint32_t len        = 0;
+    uint32_t payloadLen = 0;
+
+    while (mqtt.spillBytes > 0) {
+        if (mqtt.spillSkip > 0) {
+            len = CHIP_W25Q512_QFS_asyn_read(rec, mqtt.spillSkip > sizeof(mqtt_spill_record_buf) ? sizeof(mqtt_spill_record_buf) : mqtt.spillSkip);
+            if (len == 0) {
+                break;
+            }
+            at_mqtt_spill_consume(len);
+            mqtt.spillSkip -= len;
+            continue;
+        }
+
+        if (mqtt.spillRecordGot == 0) {
+            // 每条记录开始读之前确认内存队列能放下最长的一条记录
+            if (cqueue_residual_capacity(&mqtt.txQueue) <= MQTT_RECORD_SIZE(BFL_4G_MQTT_PAYLOAD_MAX)) {
+                break;
+            }
+            need = 1;
+        } else if (mqtt.spillRecordGot < MQTT_RECORD_HEAD_SIZE) {
+            need = MQTT_RECORD_HEAD_SIZE;
+        } else {
+            payloadLen = rec[3] | (rec[4] << 8);
+            need       = MQTT_RECORD_SIZE(payloadLen);
+        }
+
+        len = CHIP_W25Q512_QFS_asyn_read(rec + mqtt.spillRecordGot, need - mqtt.spillRecordGot);
+        if (len == 0) {
+            break;
+        }
+        at_mqtt_spill_consume(len);
+        mqtt.spillRecordGot += len;
+        if (mqtt.spillRecordGot == 1 && rec[0] == MQTT_RECORD_MAGIC) {
+            mqtt.spillFiller = false;
+        }
+
+        if (mqtt.spillRecordGot == 1 && rec[0] != MQTT_RECORD_MAGIC && mqtt.spillFiller) {
+            mqtt.spillRecordGot = 0;
+        } else if (mqtt.spillRecordGot == 1 && rec[0] != MQTT_RECORD_MAGIC) {
+            // 扇区尾部的填充，跳到下一个扇区开始
+            mqtt.spillRecordGot = 0;
+            mqtt.spillSkip      = (W25Q512_SECTOR_SIZE - mqtt.spillReadOffset) % W25Q512_SECTOR_SIZE;
+            if (mqtt.spillSkip > mqtt.spillBytes) {
+                mqtt.spillSkip = mqtt.spillBytes;
+            }
+        } else if (mqtt.spillRecordGot == MQTT_RECORD_HEAD_SIZE) {
+            payloadLen = rec[3] | (rec[4] << 8);
+            if (payloadLen == 0 || payloadLen > BFL_4G_MQTT_PAYLOAD_MAX || rec[1] >= ALLOWED_PUBLIC_TOPIC_NUM) {
+                at_mqtt_spill_resync();
+            }
+        } else if (mqtt.spillRecordGot > MQTT_RECORD_HEAD_SIZE && mqtt.spillRecordGot == need) {
+            if (at_mqtt_record_check(rec, payloadLen)) {
+                cqueue_in(&mqtt.txQueue, rec, mqtt.spillRecordGot);
+                mqtt.spillRecordGot = 0;
+            } else {
+                at_mqtt_spill_resync();
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * @brief MQTT主题过滤器匹配，支持'+'和'#'通配符。
+ *
+ * @param filter 订阅时使用的主题过滤器
+ * @param topic 收到的消息的主题
+ * @return true 匹配
+ * @return false 不匹配
+ */
+static bool at_mqtt_topic_match(const char *filter, const char *topic)
+{
+    while (*filter != '\0') {
+        if (*filter == '#') {
+            return true;
+        }
+        if (*filter == '+') {
+            while (*topic != '\0' && *topic != '/') {
+                topic++;
+            }
+            filter++;
+            continue;
+        }
+        // "a/#"同时匹配父级"a"
+        if (*topic == '\0' && strcmp(filter, "/#") == 0) {
+            return true;
+        }
+        if (*filter != *topic) {
+            return false;
+        }
+        filter++;
+        topic++;
+    }
+    return *topic == '\0';
+}
+
+static int at_hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief +QMTRECV: <client_idx>,<msgID>,"<topic>",<payload_len>,"<payload>"
+ * 接收模式配置为URC中直接带荷载，荷载格式配置为16进制字符串。
+ *
+ * @param info
+ * @return int
+ */
+int at_qmtrecv_handler(at_urc_info_t *info)
+{
+    char *pTopic   = NULL;
+    char *p        = NULL;
+    int len        = 0;
+    int hi         = 0;
+    int lo         = 0;
+    uint8_t lenLE[2];
+
+    pTopic = strchr(info->urcbuf, '"');
+    if (pTopic == NULL) {
+        return 0;
+    }
+    pTopic++;
+    p = strchr(pTopic, '"');
+    if (p == NULL) {
+        return 0;
+    }
+    *p++ = '\0';
+    if (sscanf(p, ",%d", &len) != 1 || len <= 0) {
+        return 0;
+    }
+    p = strchr(p, '"');
+    if (p == NULL) {
+        return 0;
+    }
+    p++;
+
+    if (len > BFL_4G_MQTT_PAYLOAD_MAX) {
+        ULOG_ERROR("[MQTT] %s message too long:%d", pTopic, len);
+        len = BFL_4G_MQTT_PAYLOAD_MAX;
+    }
+    for (int i = 0; i < len; i++) {
+        hi = at_hex_nibble(p[i * 2]);
+        lo = at_hex_nibble(hi < 0 ? '\0' : p[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            len = i;
+            break;
+        }
+        mqtt_rx_buf[i] = (uint8_t)((hi << 4) | lo);
+    }
+    if (len == 0) {
+        // 空消息或者一开始就不是十六进制，读取端无法区分空记录，丢弃
+        ULOG_ERROR("[MQTT] %s empty or malformed payload", pTopic);
+        mqtt.recvDropTimes++;
+        return 0;
+    }
+
+    mqtt.recvTimes++;
+    // 订阅分发表：按订阅ID顺序匹配第一个符合的主题过滤器
+    for (int subId = 0; subId < ALLOWED_SUBSCRIBE_TOPIC_NUM; subId++) {
+        const char *filter = context.CommunPara.subscribeTopic[subId];
+        if (filter[0] == '\0' || !at_mqtt_topic_match(filter, pTopic)) {
+            continue;
+        }
+
+        MQTT_Sub_t *pSub = &mqtt.subs[subId];
+        if (pSub->handler != NULL) {
+            pSub->handler(subId, mqtt_rx_buf, len);
+        } else if (cqueue_residual_capacity(&pSub->rxQueue) > (uint32_t)len + sizeof(lenLE)) {
+            lenLE[0] = (uint8_t)(len & 0xFF);
+            lenLE[1] = (uint8_t)(len >> 8);
+            cqueue_in(&pSub->rxQueue, lenLE, sizeof(lenLE));
+            cqueue_in(&pSub->rxQueue, mqtt_rx_buf, len);
+        } else {
+            mqtt.recvDropTimes++;
+        }
+        return 0;
+    }
+    ULOG_INFO("[MQTT] no subscriber for %s", pTopic);
+    return 0;
+}
+
+/**
+ * @brief +QMTSTAT: <client_idx>,<err_code> 连接被断开。
+ *
+ * @param info
+ * @return int
+ */
+int at_qmtstat_handler(at_urc_info_t *info)
+{
+    ULOG_ERROR("[MQTT] %s", info->urcbuf);
+    if (!mqtt.chainRunning) {
+        at_mqtt_down(true);
+    }
+    return 0;
+}
+
+static void at_mqtt_urc_add(const char *prefix, int (*handler)(at_urc_info_t *info))
+{
+    if (context.urc_table_size >= BFL_4G_URC_TABLE_SIZE) {
+        ULOG_ERROR("[MQTT] URC table is full.");
+        return;
+    }
+    context.urc_table[context.urc_table_size].prefix  = prefix;
+    context.urc_table[context.urc_table_size].stem    = ",";
+    context.urc_table[context.urc_table_size].endmark = '\n';
+    context.urc_table[context.urc_table_size].handler = handler;
+    context.urc_table_size++;
+    at_obj_set_urc(context.at_obj, context.urc_table, context.urc_table_size);
+}
+
+/**
+ * @brief 连接任务链执行完成，只重建MQTT层时直接结束静态任务表，不影响socket。
+ *
+ * @param pTask 连接任务链中最后执行的任务
+ */
+static void at_mqtt_chain_finish(AsyncTask_t *pTask)
+{
+    AsyncTask_SetRoute(pTask, AsyncTaskFuncResultMap(AT_RESP_OK), mqtt.recoverFromCheck ? context.linkIdleTask : NULL);
+    mqtt.chainRunning     = false;
+    mqtt.recoverFromCheck = false;
+}
+
+static void at_mqtt_up()
+{
+    uint32_t costMs = 0;
+
+    mqtt.connected    = true;
+    mqtt.backoffTimes = 0;
+    mqtt.pubFailTimes = 0;
+    if (mqtt.isOutage) {
+        mqtt.isOutage = false;
+        costMs        = AsyncTaskGetMsTick() - mqtt.outageMoment;
+        mqtt.reconnectTimes++;
+        mqtt.lastReconnectMs = costMs;
+        if (costMs > mqtt.maxReconnectMs) {
+            mqtt.maxReconnectMs = costMs;
+        }
+        ULOG_INFO("[MQTT] 连接恢复，耗时:%ums", costMs);
+    }
+}
+
+/**
+ * @brief MQTT连接异常。在途的消息还在发送队列中，重连后重发。
+ *
+ * @param trigger 是否需要主动触发重连，连接任务链中失败时由路由进入检查任务，不需要触发。
+ */
+static void at_mqtt_down(bool trigger)
+{
+    uint32_t delay = 0;
+
+    if (mqtt.connected && !mqtt.isOutage) {
+        mqtt.isOutage     = true;
+        mqtt.outageMoment = AsyncTaskGetMsTick();
+    }
+    mqtt.connected = false;
+    mqtt.inflight  = false;
+
+    delay = at_link_backoff_delay(mqtt.backoffTimes);
+    mqtt.backoffTimes++;
+    mqtt.checkTask->before_ready_delay = delay;
+    ULOG_INFO("[MQTT] 连接异常，%ums后检查链路(第%u次)", delay, mqtt.backoffTimes);
+
+    if (trigger && !mqtt.chainRunning) {
+        // 用一个立即完成的动态任务路由到检查任务
+        AsyncTask_t *pTrigger = AsyncTask_Create(at_link_idle_task_send, NULL, 0);
+        if (pTrigger != NULL) {
+            AsyncTask_SetRoute(pTrigger, AsyncTaskFuncResultMap(AT_RESP_OK), mqtt.checkTask);
+            AsyncTaskList_DynamicPush(context.task_list, pTrigger);
+            mqtt.chainRunning = true;
+            mqtt.chainMoment  = AsyncTaskGetMsTick();
+        }
+    }
+}
+
+void at_qmtclose_task_send(void *param)
+{
+    UNUSED(param);
+    at_attr_t attr;
+
+    // 重新订阅所有主题
+    mqtt.subNext = 0;
+    for (int i = 0; i < ALLOWED_SUBSCRIBE_TOPIC_NUM; i++) {
+        mqtt.subs[i].subscribed = false;
+    }
+
+    attr.params   = &context;
+    attr.prefix   = NULL;
+    attr.suffix   = "OK";
+    attr.cb       = NULL;
+    attr.timeout  = 3000;
+    attr.retry    = 0;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_exec_cmd(context.at_obj, &attr, "AT+QMTCLOSE=%d", BFL_4G_MQTT_CLIENT_IDX);
+}
+
+void at_qmtcfg_task_send(void *param)
+{
+    UNUSED(param);
+    at_attr_t attr;
+
+    attr.params   = &context;
+    attr.prefix   = NULL;
+    attr.suffix   = "OK";
+    attr.cb       = NULL;
+    attr.timeout  = 1000;
+    attr.retry    = 2;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_send_multiline(context.at_obj, &attr, mqtt_cfg_cmds);
+}
+
+void at_qmtopen_callback(at_response_t *r)
+{
+    if (r->code == AT_RESP_OK) {
+        ULOG_INFO("[MQTT] AT+QMTOPEN R OK! %s:%u", context.CommunPara.hostName, context.CommunPara.port);
+    } else {
+        ULOG_ERROR("[MQTT] AT+QMTOPEN R FAIL!");
+        at_mqtt_down(false);
+    }
+}
+
+void at_qmtopen_task_send(void *param)
+{
+    UNUSED(param);
+    at_attr_t attr;
+
+    attr.params   = &context;
+    attr.prefix   = NULL;
+    attr.suffix   = "+QMTOPEN: " MQTT_STR(BFL_4G_MQTT_CLIENT_IDX) ",0";
+    attr.cb       = at_qmtopen_callback;
+    attr.timeout  = 30000;
+    attr.retry    = 0;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_exec_cmd(context.at_obj, &attr, "AT+QMTOPEN=%d,\"%s\",%u", BFL_4G_MQTT_CLIENT_IDX,
+                context.CommunPara.hostName, context.CommunPara.port);
+}
+
+void at_qmtconn_callback(at_response_t *r)
+{
+    if (r->code == AT_RESP_OK) {
+        ULOG_INFO("[MQTT] AT+QMTCONN R OK!");
+        at_mqtt_up();
+    } else {
+        ULOG_ERROR("[MQTT] AT+QMTCONN R FAIL!");
+        at_mqtt_down(false);
+    }
+}
+
+void at_qmtconn_task_send(void *param)
+{
+    UNUSED(param);
+    at_attr_t attr;
+    CommunPara_t *pCommunPara = &context.CommunPara;
+
+    attr.params   = &context;
+    attr.prefix   = NULL;
+    attr.suffix   = "+QMTCONN: " MQTT_STR(BFL_4G_MQTT_CLIENT_IDX) ",0,0";
+    attr.cb       = at_qmtconn_callback;
+    attr.timeout  = 10000;
+    attr.retry    = 0;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    if (pCommunPara->userName[0] == '\0') {
+        at_exec_cmd(context.at_obj, &attr, "AT+QMTCONN=%d,\"%s\"", BFL_4G_MQTT_CLIENT_IDX, pCommunPara->clientID);
+    } else {
+        at_exec_cmd(context.at_obj, &attr, "AT+QMTCONN=%d,\"%s\",\"%s\",\"%s\"", BFL_4G_MQTT_CLIENT_IDX,
+                    pCommunPara->clientID, pCommunPara->userName, pCommunPara->password);
+    }
+}
+
+void at_qmtsub_callback(at_response_t *r)
+{
+    int subId = (int)r->params;
+    if (r->code == AT_RESP_OK) {
+        ULOG_INFO("[MQTT] 订阅成功:%s", context.CommunPara.subscribeTopic[subId]);
+        mqtt.subs[subId].subscribed = true;
+        // 继续订阅下一个主题
+        AsyncTask_SetRoute(context.task_list->pCurrentTask, AsyncTaskFuncResultMap(AT_RESP_OK), context.task_list->pCurrentTask);
+    } else {
+        ULOG_ERROR("[MQTT] 订阅失败:%s", context.CommunPara.subscribeTopic[subId]);
+        at_mqtt_down(false);
+    }
+}
+
+/**
+ * @brief 每次订阅一个还没有订阅的主题，订阅成功后路由回自身，直到全部订阅完成。
+ *
+ * @param param
+ */
+void at_qmtsub_task_send(void *param)
+{
+    UNUSED(param);
+    at_attr_t attr;
+    CommunPara_t *pCommunPara = &context.CommunPara;
+    AsyncTask_t *pTask        = context.task_list->pCurrentTask;
+
+    while (mqtt.subNext < ALLOWED_SUBSCRIBE_TOPIC_NUM &&
+           (pCommunPara->subscribeTopic[mqtt.subNext][0] == '\0' || mqtt.subs[mqtt.subNext].subscribed)) {
+        mqtt.subNext++;
+    }
+    if (mqtt.subNext >= ALLOWED_SUBSCRIBE_TOPIC_NUM) {
+        at_mqtt_chain_finish(pTask);
+        AsyncTask_SetFuncResult(pTask, AsyncTaskFuncResultMap(AT_RESP_OK));
+        AsyncTask_SetState(pTask, ASYNC_TASK_STATE_FINISHED);
+        return;
+    }
+
+    uint16_t msgId = at_mqtt_next_msg_id();
+    sprintf(mqtt_sub_suffix, "+QMTSUB: %d,%u,0", BFL_4G_MQTT_CLIENT_IDX, msgId);
+    attr.params   = (void *)mqtt.subNext;
+    attr.prefix   = NULL;
+    attr.suffix   = mqtt_sub_suffix;
+    attr.cb       = at_qmtsub_callback;
+    attr.timeout  = 10000;
+    attr.retry    = 0;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_exec_cmd(context.at_obj, &attr, "AT+QMTSUB=%d,%u,\"%s\",%u", BFL_4G_MQTT_CLIENT_IDX, msgId,
+                pCommunPara->subscribeTopic[mqtt.subNext], pCommunPara->subscribeTopicQos[mqtt.subNext]);
+}
+
+void at_qmt_check_callback(at_response_t *r)
+{
+    AsyncTask_t *pNextTask = NULL;
+    char *p                = NULL;
+    int stat               = 0;
+    int state              = 0;
+    bool isConnected       = false;
+
+    if (r->code == AT_RESP_OK) {
+        p                     = strstr(r->recvbuf, "+CREG: ");
+        context.netRegistered = p != NULL && sscanf(p, "+CREG: %*d,%d", &stat) == 1 && (stat == 1 || stat == 5);
+        p                     = strstr(r->recvbuf, "+QIACT: ");
+        context.pdpIsActive   = p != NULL && sscanf(p, "+QIACT: %*d,%d", &state) == 1 && state == 1;
+        // +QMTCONN: <client_idx>,<state>  3:已连接
+        p           = strstr(r->recvbuf, "+QMTCONN: ");
+        isConnected = p != NULL && sscanf(p, "+QMTCONN: %*d,%d", &state) == 1 && state == 3;
+    }
+
+    if (r->code != AT_RESP_OK) {
+        pNextTask = BFL_4G_BaseCfgTaskEntry(BFL_4G_BASE_CFG_AT);
+    } else if (!context.netRegistered) {
+        pNextTask = BFL_4G_BaseCfgTaskEntry(BFL_4G_BASE_CFG_CREG);
+    } else if (!context.pdpIsActive) {
+        pNextTask = BFL_4G_BaseCfgTaskEntry(BFL_4G_BASE_CFG_QICSGP);
+    } else if (!isConnected || mqtt.pubFailTimes > BFL_4G_MQTT_PUB_RETRY_MAX) {
+        pNextTask             = mqtt.closeTask;
+        mqtt.recoverFromCheck = true;
+    } else {
+        // 连接正常，只是发布失败，直接重发
+        pNextTask         = NULL;
+        mqtt.chainRunning = false;
+        at_mqtt_up();
+    }
+    ULOG_INFO("[MQTT] 链路检查 REG:%d PDP:%d MQTT:%d", context.netRegistered, context.pdpIsActive, isConnected);
+
+    AsyncTask_SetRoute(mqtt.checkTask, AsyncTaskFuncResultMap(AT_RESP_OK), pNextTask);
+    AsyncTask_SetRoute(mqtt.checkTask, AsyncTaskFuncResultMap(AT_RESP_ERROR), pNextTask);
+    AsyncTask_SetRoute(mqtt.checkTask, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), pNextTask);
+}
+
+void at_qmt_check_task_send(void *param)
+{
+    UNUSED(param);
+    at_attr_t attr;
+
+    attr.params   = &context;
+    attr.prefix   = NULL;
+    attr.suffix   = "OK";
+    attr.cb       = at_qmt_check_callback;
+    attr.timeout  = 3000;
+    attr.retry    = 1;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_exec_cmd(context.at_obj, &attr, "AT+CREG?;+QIACT?;+QMTCONN?");
+}
+
+static void at_mqtt_publish_fail()
+{
+    mqtt.inflight = false;
+    mqtt.pubFailTimes++;
+    mqtt.pubRetryMoment = AsyncTaskGetMsTick();
+    mqtt.pubRetryDelay  = at_link_backoff_delay(mqtt.pubFailTimes - 1);
+    ULOG_ERROR("[MQTT] 发布失败次数:%u", mqtt.pubFailTimes);
+    if (mqtt.pubFailTimes > BFL_4G_MQTT_PUB_RETRY_MAX) {
+        at_mqtt_down(true);
+    }
+}
+
+void at_qmtpubex_callback(at_response_t *r)
+{
+    uint32_t costMs = 0;
+
+    // 重连时在途标志已经清除，迟到的响应不再处理
+    if (!mqtt.inflight || (uint16_t)(int)r->params != mqtt.msgId) {
+        return;
+    }
+
+    if (r->code == AT_RESP_OK) {
+        costMs = AsyncTaskGetMsTick() - mqtt.pubStartMoment;
+        cqueue_skip(&mqtt.txQueue, mqtt.pubRecordBytes);
+        mqtt.inflight      = false;
+        mqtt.pubFailTimes  = 0;
+        mqtt.pubRetryDelay = 0;
+        mqtt.pubTimes++;
+        mqtt.pubMsgNum += mqtt.pubRecordNum;
+        mqtt.pubBytes += mqtt.pubLen;
+        mqtt.lastAckMs = costMs;
+        if (costMs > mqtt.maxAckMs) {
+            mqtt.maxAckMs = costMs;
+        }
+    } else {
+        at_mqtt_publish_fail();
+    }
+}
+
+/**
+ * @brief 收到'>'后发送荷载，QoS1等待PUBACK，QoS0等待模组发送完成。
+ *
+ * @param r
+ */
+void at_qmtpubex_prompt_callback(at_response_t *r)
+{
+    at_attr_t attr;
+
+    if (!mqtt.inflight || (uint16_t)(int)r->params != mqtt.msgId) {
+        return;
+    }
+    if (r->code != AT_RESP_OK) {
+        at_mqtt_publish_fail();
+        return;
+    }
+
+    sprintf(mqtt_pub_suffix, "+QMTPUBEX: %d,%u,0", BFL_4G_MQTT_CLIENT_IDX, (mqtt.pubFlags & 0x03) ? mqtt.msgId : 0);
+    attr.params   = (void *)(int)mqtt.msgId;
+    attr.prefix   = NULL;
+    attr.suffix   = mqtt_pub_suffix;
+    attr.cb       = at_qmtpubex_callback;
+    attr.timeout  = BFL_4G_MQTT_ACK_TIMEOUT_MS;
+    attr.retry    = 0;
+    attr.priority = AT_PRIORITY_HIGH; // 必须紧跟在'>'之后
+    attr.ctx      = NULL;
+    at_send_data(context.at_obj, &attr, mqtt_pub_buf, mqtt.pubLen);
+}
+
+void at_qmtpubex_task_send(void *param)
+{
+    UNUSED(param);
+    at_attr_t attr;
+    uint8_t qos    = mqtt.pubFlags & 0x03;
+    uint8_t retain = (mqtt.pubFlags >> 2) & 0x01;
+
+    attr.params   = (void *)(int)mqtt.msgId;
+    attr.prefix   = NULL;
+    attr.suffix   = ">";
+    attr.cb       = at_qmtpubex_prompt_callback;
+    attr.timeout  = 3000;
+    attr.retry    = 0;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_exec_cmd(context.at_obj, &attr, "AT+QMTPUBEX=%d,%u,%u,%u,\"%s\",%u", BFL_4G_MQTT_CLIENT_IDX,
+                qos ? mqtt.msgId : 0, qos, retain, context.CommunPara.publishTopic[mqtt.pubId], mqtt.pubLen);
+}
+
+/**
+ * @brief 从发送队列首部取出一条消息发布，开启合并发布的发布ID会把连续的同一发布ID、
+ * 同样QoS和retain的消息合并成一次发布。
+ *
+ */
+static void at_mqtt_publish_start()
+{
+    uint8_t head[MQTT_RECORD_HEAD_SIZE];
+    uint32_t offset = 0;
+    uint32_t len    = 0;
+
+    mqtt.pubLen       = 0;
+    mqtt.pubRecordNum = 0;
+    while (cqueue_peek(&mqtt.txQueue, offset, head, MQTT_RECORD_HEAD_SIZE) == MQTT_RECORD_HEAD_SIZE) {
+        len = head[3] | (head[4] << 8);
+        if (mqtt.pubRecordNum == 0) {
+            mqtt.pubId    = head[1];
+            mqtt.pubFlags = head[2];
+        } else if (head[1] != mqtt.pubId || head[2] != mqtt.pubFlags || mqtt.pubLen + len > BFL_4G_MQTT_BATCH_SIZE) {
+            break;
+        }
+        cqueue_peek(&mqtt.txQueue, offset + MQTT_RECORD_HEAD_SIZE, mqtt_pub_buf + mqtt.pubLen, len);
+        offset += MQTT_RECORD_SIZE(len);
+        mqtt.pubLen += len;
+        mqtt.pubRecordNum++;
+        if (!mqtt.publishBatch[mqtt.pubId]) {
+            break;
+        }
+    }
+    mqtt.pubRecordBytes = offset;
+
+    AsyncTask_t *pTask = AsyncTask_Create(at_qmtpubex_task_send, NULL, 0);
+    if (pTask == NULL) {
+        ULOG_ERROR("[Async] AT qmtpubex task create failed.");
+        return;
+    }
+    if (mqtt.pubFlags & 0x03) {
+        at_mqtt_next_msg_id();
+    }
+    mqtt.inflight       = true;
+    mqtt.pubStartMoment = AsyncTaskGetMsTick();
+    AsyncTaskList_DynamicPush(context.task_list, pTask);
+}
+
+/**
+ * @brief 创建MQTT连接任务链，需要在BFL_4G_Init之后调用，只会创建一次。
+ *
+ * @param hostName
+ * @param port
+ * @param clientID
+ * @param userName 为NULL或者""时不使用用户名密码。
+ * @param password
+ * @return int32_t 0成功，-1失败。
+ */
+int32_t BFL_4G_MQTT_TaskList_Create(const char *hostName, uint32_t port, const char *clientID, const char *userName, const char *password)
+{
+    CommunPara_t *pCommunPara = &context.CommunPara;
+    AsyncTaskList_t *task_list = context.task_list;
+
+    if (mqtt.inited || hostName == NULL || clientID == NULL) {
+        return -1;
+    }
+
+    strncpy(pCommunPara->hostName, hostName, sizeof(pCommunPara->hostName) - 1);
+    strncpy(pCommunPara->clientID, clientID, sizeof(pCommunPara->clientID) - 1);
+    if (userName != NULL) {
+        strncpy(pCommunPara->userName, userName, sizeof(pCommunPara->userName) - 1);
+    }
+    if (password != NULL) {
+        strncpy(pCommunPara->password, password, sizeof(pCommunPara->password) - 1);
+    }
+    pCommunPara->port = port;
+    if (pCommunPara->keepAliveInterval == 0) {
+        pCommunPara->keepAliveInterval = 120;
+    }
+
+    cqueue_create(&mqtt.txQueue, mqtt_tx_ram_buf, sizeof(mqtt_tx_ram_buf), sizeof(uint8_t));
+    for (int i = 0; i < ALLOWED_SUBSCRIBE_TOPIC_NUM; i++) {
+        cqueue_create(&mqtt.subs[i].rxQueue, mqtt_sub_rx_buf[i], BFL_4G_MQTT_SUB_RX_SIZE, sizeof(uint8_t));
+    }
+
+    // 荷载接收为16进制字符串，URC中直接带荷载和长度；超时5s重传3次，不上报重传
+    sprintf(mqtt_cfg_cmd_bufs[0], "AT+QMTCFG=\"version\",%d,4", BFL_4G_MQTT_CLIENT_IDX);
+    sprintf(mqtt_cfg_cmd_bufs[1], "AT+QMTCFG=\"keepalive\",%d,%u", BFL_4G_MQTT_CLIENT_IDX, pCommunPara->keepAliveInterval);
+    sprintf(mqtt_cfg_cmd_bufs[2], "AT+QMTCFG=\"session\",%d,%u", BFL_4G_MQTT_CLIENT_IDX, pCommunPara->cleanSession);
+    sprintf(mqtt_cfg_cmd_bufs[3], "AT+QMTCFG=\"timeout\",%d,5,3,0", BFL_4G_MQTT_CLIENT_IDX);
+    sprintf(mqtt_cfg_cmd_bufs[4], "AT+QMTCFG=\"recv/mode\",%d,0,1", BFL_4G_MQTT_CLIENT_IDX);
+    sprintf(mqtt_cfg_cmd_bufs[5], "AT+QMTCFG=\"dataformat\",%d,0,1", BFL_4G_MQTT_CLIENT_IDX);
+    for (int i = 0; i < 6; i++) {
+        mqtt_cfg_cmds[i] = mqtt_cfg_cmd_bufs[i];
+    }
+    mqtt_cfg_cmds[6] = NULL;
+
+    AsyncTask_t *at_qmtclose_task = AsyncTask_Create(at_qmtclose_task_send, NULL, 0);
+    AsyncTask_t *at_qmtcfg_task   = AsyncTask_Create(at_qmtcfg_task_send, NULL, 0);
+    AsyncTask_t *at_qmtopen_task  = AsyncTask_Create(at_qmtopen_task_send, NULL, 0);
+    AsyncTask_t *at_qmtconn_task  = AsyncTask_Create(at_qmtconn_task_send, NULL, 0);
+    AsyncTask_t *at_qmtsub_task   = AsyncTask_Create(at_qmtsub_task_send, NULL, 0);
+    AsyncTask_t *at_qmtcheck_task = AsyncTask_Create(at_qmt_check_task_send, NULL, 0);
+    if (at_qmtclose_task == NULL || at_qmtcfg_task == NULL || at_qmtopen_task == NULL ||
+        at_qmtconn_task == NULL || at_qmtsub_task == NULL || at_qmtcheck_task == NULL) {
+        ULOG_ERROR("[MQTT] Async task create failed.");
+        return -1;
+    }
+    mqtt.closeTask = at_qmtclose_task;
+    mqtt.checkTask = at_qmtcheck_task;
+
+    // at_qmtcheck_task不加入静态任务表，只作为失败时的路由目标
+    AsyncTaskList_StaticAdd(task_list, at_qmtclose_task);
+    AsyncTaskList_StaticAdd(task_list, at_qmtcfg_task);
+    AsyncTaskList_StaticAdd(task_list, at_qmtopen_task);
+    AsyncTaskList_StaticAdd(task_list, at_qmtconn_task);
+    AsyncTaskList_StaticAdd(task_list, at_qmtsub_task);
+
+    AsyncTask_SetRoute(at_qmtcfg_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qmtcfg_task);
+    AsyncTask_SetRoute(at_qmtopen_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qmtcheck_task);
+    AsyncTask_SetRoute(at_qmtopen_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qmtcheck_task);
+    AsyncTask_SetRoute(at_qmtconn_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qmtcheck_task);
+    AsyncTask_SetRoute(at_qmtconn_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qmtcheck_task);
+    AsyncTask_SetRoute(at_qmtsub_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qmtcheck_task);
+    AsyncTask_SetRoute(at_qmtsub_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qmtcheck_task);
+
+    /*
+    Invake Map:
+    at_qmtclose_task->at_qmtcfg_task->at_qmtopen_task->at_qmtconn_task->at_qmtsub_task(逐个订阅，路由回自身)
+                                      |                |                |
+                                      +----------------+----------------+
+                                                       | ERROR/TIMEOUT
+                                                       v
+                 at_qmtcheck_task(退避延时) -> 基本配置图的AT / CREG / QICSGP / at_qmtclose_task / 重发
+    */
+
+    at_mqtt_urc_add("+QMTRECV:", at_qmtrecv_handler);
+    at_mqtt_urc_add("+QMTSTAT:", at_qmtstat_handler);
+
+#if BFL_4G_MQTT_USING_QFS_SPILL
+    CHIP_W25Q512_QFS_init();
+    // 掉电前没有发送完的消息
+    mqtt.spillBytes  = CHIP_W25Q512_QFS_byte_size();
+    mqtt.spillFiller = mqtt.spillBytes > 0;
+#endif
+
+    mqtt.inited       = true;
+    mqtt.chainRunning = true;
+    mqtt.chainMoment  = AsyncTaskGetMsTick();
+    return 0;
+}
+
+int32_t BFL_4G_MQTT_Subscribe_Task(int mqttSubId, const char *topic, uint8_t qos, BFL_4G_MQTT_SubHandler_t handler)
+{
+    CommunPara_t *pCommunPara = &context.CommunPara;
+    if (mqttSubId < 0 || mqttSubId >= ALLOWED_SUBSCRIBE_TOPIC_NUM || topic == NULL) {
+        return -1;
+    }
+    strncpy(pCommunPara->subscribeTopic[mqttSubId], topic, sizeof(pCommunPara->subscribeTopic[mqttSubId]) - 1);
+    pCommunPara->subscribeTopicQos[mqttSubId] = qos;
+    mqtt.subs[mqttSubId].handler              = handler;
+    mqtt.subs[mqttSubId].subscribed           = false;
+    mqtt.subNext                              = 0;
+    return 0;
+}
+
+int32_t BFL_4G_MQTT_PublishTopic_Task(int mqttPubId, const char *topic, bool batch)
+{
+    CommunPara_t *pCommunPara = &context.CommunPara;
+    if (mqttPubId < 0 || mqttPubId >= ALLOWED_PUBLIC_TOPIC_NUM || topic == NULL) {
+        return -1;
+    }
+    strncpy(pCommunPara->publishTopic[mqttPubId], topic, sizeof(pCommunPara->publishTopic[mqttPubId]) - 1);
+    mqtt.publishBatch[mqttPubId] = batch;
+    return 0;
+}
+
+uint32_t BFL_4G_MQTT_Write_Task(int mqttPubId, const uint8_t *payload, uint32_t uiLen, uint8_t qos, uint8_t retain)
+{
+    uint32_t recLen = 0;
+
+    if (!mqtt.inited || mqttPubId < 0 || mqttPubId >= ALLOWED_PUBLIC_TOPIC_NUM ||
+        context.CommunPara.publishTopic[mqttPubId][0] == '\0' ||
+        payload == NULL || uiLen == 0 || uiLen > BFL_4G_MQTT_PAYLOAD_MAX || qos > 1) {
+        return 0;
+    }
+
+    recLen = at_mqtt_record_encode(mqtt_record_buf, mqttPubId, qos, retain, payload, uiLen);
+    // 已经有消息溢出到Flash时，新消息也写到Flash，保持先进先出
+    if (mqtt.spillBytes == 0 && cqueue_residual_capacity(&mqtt.txQueue) > recLen) {
+        cqueue_in(&mqtt.txQueue, mqtt_record_buf, recLen);
+        return uiLen;
+    }
+#if BFL_4G_MQTT_USING_QFS_SPILL
+    if (at_mqtt_spill_push(mqtt_record_buf, recLen)) {
+        return uiLen;
+    }
+#endif
+    mqtt.writeDropTimes++;
+    return 0;
+}
+
+bool BFL_4G_MQTT_Writeable_Task(int mqttPubId)
+{
+    uint32_t maxRecLen = MQTT_RECORD_SIZE(BFL_4G_MQTT_PAYLOAD_MAX);
+
+    if (!mqtt.inited || mqttPubId < 0 || mqttPubId >= ALLOWED_PUBLIC_TOPIC_NUM) {
+        return false;
+    }
+    if (mqtt.spillBytes == 0 && cqueue_residual_capacity(&mqtt.txQueue) > maxRecLen) {
+        return true;
+    }
+#if BFL_4G_MQTT_USING_QFS_SPILL
+    // 最坏情况下需要先填充到扇区结束
+    return CHIP_W25Q512_QFS_residual_byte_size() >= maxRecLen * 2;
+#else
+    return false;
+#endif
+}
+
+uint32_t BFL_4G_MQTT_Read_Task(int mqttSubId, uint8_t *pBuf, uint32_t uiLen)
+{
+    uint8_t lenLE[2];
+    uint32_t len = 0;
+
+    if (!BFL_4G_MQTT_Readable_Task(mqttSubId) || pBuf == NULL || uiLen == 0) {
+        return 0;
+    }
+
+    CQueue_t *pQueue = &mqtt.subs[mqttSubId].rxQueue;
+    cqueue_out(pQueue, lenLE, sizeof(lenLE));
+    len = lenLE[0] | (lenLE[1] << 8);
+    if (len > uiLen) {
+        // 缓冲区不够时截断，丢弃剩余部分
+        cqueue_out(pQueue, pBuf, uiLen);
+        cqueue_skip(pQueue, len - uiLen);
+        return uiLen;
+    }
+    return cqueue_out(pQueue, pBuf, len);
+}
+
+bool BFL_4G_MQTT_Readable_Task(int mqttSubId)
+{
+    if (!mqtt.inited || mqttSubId < 0 || mqttSubId >= ALLOWED_SUBSCRIBE_TOPIC_NUM) {
+        return false;
+    }
+    return cqueue_size(&mqtt.subs[mqttSubId].rxQueue) >= 2;
+}
+
+bool BFL_4G_MQTT_IsConnected_Task()
+{
+    return mqtt.connected;
+}
+
+/**
+ * @brief 在BFL_4G_Poll中调用：推进QFS，把溢出的消息读回内存，发布队首的消息。
+ *
+ */
+void BFL_4G_MQTT_Poll_Task()
+{
+    if (!mqtt.inited) {
+        return;
+    }
+
+#if BFL_4G_MQTT_USING_QFS_SPILL
+    CHIP_W25Q512_QFS_handler();
+    at_mqtt_spill_refill();
+#endif
+
+    if (mqtt.chainRunning && AsyncTaskGetMsTick() - mqtt.chainMoment > MQTT_CHAIN_TIMEOUT_MS) {
+        ULOG_ERROR("[MQTT] 连接任务链超时，重新连接");
+        mqtt.chainRunning = false;
+        at_mqtt_down(true);
+    }
+
+    if (mqtt.connected && !mqtt.inflight && !cqueue_is_empty(&mqtt.txQueue) &&
+        AsyncTaskGetMsTick() - mqtt.pubRetryMoment >= mqtt.pubRetryDelay) {
+        at_mqtt_publish_start();
+    }
+}
+
+/**
+ * @brief 下一次BFL_4G_MQTT_Poll_Task是否会发布，条件与BFL_4G_MQTT_Poll_Task相同。
+ * 发布失败后的重试延时期间返回false，延时的精度由主循环空闲的最长时间保证。
+ *
+ * @return true
+ * @return false
+ */
+bool BFL_4G_MQTT_HasPendingWork_Task()
+{
+    return mqtt.inited && mqtt.connected && !mqtt.inflight && !cqueue_is_empty(&mqtt.txQueue) &&
+           AsyncTaskGetMsTick() - mqtt.pubRetryMoment >= mqtt.pubRetryDelay;
+}
+
+void BFL_4G_MQTT_StatShow_Task()
+{
+    ULOG_INFO("[MQTT] connected:%d pub:%u msg:%u bytes:%u ack last:%ums max:%ums",
+              mqtt.connected, mqtt.pubTimes, mqtt.pubMsgNum, mqtt.pubBytes, mqtt.lastAckMs, mqtt.maxAckMs);
+    ULOG_INFO("[MQTT] queue:%u spill:%u corrupt:%u drop:%u recv:%u recv drop:%u reconnect:%u last:%ums max:%ums",
+              cqueue_size(&mqtt.txQueue), mqtt.spillBytes, mqtt.spillCorruptTimes, mqtt.writeDropTimes,
+              mqtt.recvTimes, mqtt.recvDropTimes, mqtt.reconnectTimes, mqtt.lastReconnectMs, mqtt.maxReconnectMs);
+}
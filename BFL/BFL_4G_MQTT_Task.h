@@ -0,0 +1,56 @@
+/**
+ * @file BFL_4G_MQTT_Task.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 基于EC800M AT+QMT*指令的MQTT客户端。
+ * @version 0.1
+ * @date 2023-10-20
+ * @last modified 2023-10-20
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_4G_MQTT_TASK_H
+#define BFL_4G_MQTT_TASK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 模组中使用的MQTT客户端编号
+#define BFL_4G_MQTT_CLIENT_IDX     0
+// 单条消息荷载的最大长度
+#define BFL_4G_MQTT_PAYLOAD_MAX    1024
+// 合并发布时一次发布的最大长度，不小于BFL_4G_MQTT_PAYLOAD_MAX
+#define BFL_4G_MQTT_BATCH_SIZE     1024
+// 发送队列内存部分的大小，写满后溢出到Flash
+#define BFL_4G_MQTT_TX_RAM_SIZE    4096
+// 每个订阅ID的接收队列大小
+#define BFL_4G_MQTT_SUB_RX_SIZE    1024
+// 同一条消息连续发布失败多少次后认为连接断开
+#define BFL_4G_MQTT_PUB_RETRY_MAX  3
+// QoS1等待PUBACK的超时时间，ms
+#define BFL_4G_MQTT_ACK_TIMEOUT_MS 15000
+// 发送队列写满后溢出到W25Q512的QFS，只有MQTT写入和出队，ymodem导出只读取快照
+#define BFL_4G_MQTT_USING_QFS_SPILL 1
+
+typedef void (*BFL_4G_MQTT_SubHandler_t)(int mqttSubId, const uint8_t *payload, uint32_t uiLen);
+
+int32_t BFL_4G_MQTT_TaskList_Create(const char *hostName, uint32_t port, const char *clientID, const char *userName, const char *password);
+int32_t BFL_4G_MQTT_Subscribe_Task(int mqttSubId, const char *topic, uint8_t qos, BFL_4G_MQTT_SubHandler_t handler);
+int32_t BFL_4G_MQTT_PublishTopic_Task(int mqttPubId, const char *topic, bool batch);
+uint32_t BFL_4G_MQTT_Write_Task(int mqttPubId, const uint8_t *payload, uint32_t uiLen, uint8_t qos, uint8_t retain);
+bool BFL_4G_MQTT_Writeable_Task(int mqttPubId);
+uint32_t BFL_4G_MQTT_Read_Task(int mqttSubId, uint8_t *pBuf, uint32_t uiLen);
+bool BFL_4G_MQTT_Readable_Task(int mqttSubId);
+bool BFL_4G_MQTT_IsConnected_Task();
+void BFL_4G_MQTT_Poll_Task();
+bool BFL_4G_MQTT_HasPendingWork_Task();
+void BFL_4G_MQTT_StatShow_Task();
+
+#ifdef __cplusplus
+}
+#endif
+#endif //! BFL_4G_MQTT_TASK_H
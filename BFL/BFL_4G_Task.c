@@ -20,6 +20,7 @@
 #include "at_chat.h"
 #include "mtime.h"
 #include "cqueue.h"
+#include "ccommon.h"
 
 #ifdef FREE_RTOS
 #include "FreeRTOS.h"
@@ -80,6 +81,8 @@ static const at_adapter_t at_adapter = {
 
 #define AT_BUF_LEN 1024
 static uint8_t at_output_buf[AT_BUF_LEN];
+// 一次QISENDEX最多发送的字节数：AT+QISENDEX=x,"<hex>"，最后留给'"'和'\0'
+#define AT_QISEND_CHUNK_MAX ((AT_BUF_LEN - 2 - sizeof("AT+QISENDEX=0,\"") + 1) / 2)
 extern AsyncTaskExecContext_t context;
 
 void at_task_delay(uint32_t delayMs);
@@ -97,6 +100,23 @@ void at_qisde_task_send(int sockid);
 void at_qiopen_task_send(int sockid);
 void at_qiswtmd_task_send(int sockid);
 void at_qisend_task_send(int sockid);
+void at_qiclose_task_send(int sockid);
+void at_link_check_task_send(int sockid);
+AsyncTask_t *at_qisend_task_push(int sockid);
+static void at_link_down(int sockid);
+static void at_link_up(int sockid);
+
+// 基本配置、TCP连接和校时都是固定的任务序列，用const状态表描述，由静态分配的图任务执行
+static AsyncTask_t at_base_cfg_task;
+static AsyncTask_t at_tcp_open_tasks[3];
+static AsyncTask_t at_calibrate_time_task;
+// 链路检查和空闲任务不加入静态任务表，只作为路由目标，同样静态分配
+static AsyncTask_t at_link_check_tasks[3];
+static AsyncTask_t at_link_idle_task_;
+static AsyncTaskGraphTrace_t at_base_cfg_trace[BFL_4G_BASE_CFG_STATE_NUM];
+static AsyncTaskGraphTrace_t at_tcp_open_trace[3][BFL_4G_TCP_OPEN_STATE_NUM];
+static AsyncTaskGraphTrace_t at_calibrate_time_trace[1];
+AsyncTask_t *at_link_idle_task;
 
 void at_task_delay(uint32_t delayMs)
 {
@@ -471,20 +491,27 @@ void at_qiopen_callback(at_response_t *r)
     params_tuple += sizeof(AsyncTaskExecContext_t *);
     int sockid = *(int *)params_tuple;
     at_free(r->params);
+
+    // +QIOPEN: <connectID>,<err>，err不为0时模组同样返回OK
+    int err       = -1;
+    char *pQIOPEN = NULL;
     if (r->code == AT_RESP_OK) {
+        pQIOPEN = strstr(r->recvbuf, "+QIOPEN: ");
+        if (pQIOPEN == NULL || sscanf(pQIOPEN, "+QIOPEN: %*d,%d", &err) != 1) {
+            err = 0;
+        }
+    }
+
+    if (err == 0) {
         ULOG_INFO("[4G] TCP连接成功");
         context.qiopen_fail_times = 0;
+        AsyncTask_SetRoute(context.task_list->pCurrentTask, AsyncTaskFuncResultMap(AT_RESP_OK), NULL);
     } else {
-        ULOG_INFO("[4G] TCP连接失败");
-        at_task_delay(1000);
-        at_qiopen_task_send(sockid);
-
         context.qiopen_fail_times++;
-        ULOG_ERROR("[4G] TCP连接失败次数:%d", context.qiopen_fail_times);
-        if (context.qiopen_fail_times > 3) {
-            ULOG_ERROR("[4G] TCP连接失败次数过多，重新连接");
-            context.qiopen_fail_times = 0;
-        }
+        ULOG_ERROR("[4G] TCP连接失败(%d)，失败次数:%d", err, context.qiopen_fail_times);
+        // 不在这里直接重发，交给链路检查任务退避后决定从哪一层重建
+        AsyncTask_SetRoute(context.task_list->pCurrentTask, AsyncTaskFuncResultMap(AT_RESP_OK), context.linkCheckTasks[sockid]);
+        at_link_down(sockid);
     }
 }
 
@@ -523,9 +550,13 @@ void at_qiswtmd_callback(at_response_t *r)
     at_free(r->params);
     if (r->code == AT_RESP_OK) {
         ULOG_INFO("[4G] TCP设置为直吐模式");
-        context.writeIsUsing = 0;
+        // 只重建了Socket层时，其他socket不受影响，直接结束静态任务表
+        AsyncTask_SetRoute(context.task_list->pCurrentTask, AsyncTaskFuncResultMap(AT_RESP_OK),
+                           context.socketLinks[sockid].recoverLayer == BFL_4G_LINK_LAYER_SOCKET ? context.linkIdleTask : NULL);
+        at_link_up(sockid);
     } else {
         ULOG_INFO("[4G] TCP设置为直吐模式失败");
+        at_link_down(sockid);
     }
 }
 
@@ -555,6 +586,41 @@ void at_qiswtmd_task_send_(void *param)
     at_qiswtmd_task_send(sockid);
 }
 
+/**
+ * @brief 发送成功后释放发送队列中已经发送的数据，并弹出已经发送完的写入标记。
+ *
+ * @param sockid
+ */
+static void at_socket_send_done(int sockid)
+{
+    BFL_4G_SocketWrite_t *pWrite = &context.socketWrites[sockid];
+    BFL_4G_TCP_Stat_t *pStat     = &pWrite->stat;
+    uint32_t now                 = AsyncTaskGetMsTick();
+    uint32_t costMs              = now - pWrite->sendMoment;
+
+    cqueue_skip(&pWrite->sendQueue, pWrite->inflight);
+    pStat->txBytes += pWrite->inflight;
+    pStat->txTimes++;
+    pStat->lastSendMs = costMs;
+    pWrite->totalSendMs += costMs;
+    pStat->avgSendMs = pWrite->totalSendMs / pStat->txTimes;
+    if (costMs > pStat->maxSendMs) {
+        pStat->maxSendMs = costMs;
+    }
+    pWrite->inflight = 0;
+
+    while (pWrite->markNum > 0 && (int32_t)(pWrite->marks[pWrite->markHead].end - pStat->txBytes) <= 0) {
+        pWrite->markHead = (pWrite->markHead + 1) % BFL_4G_SOCKET_WRITE_MARK_NUM;
+        pWrite->markNum--;
+    }
+
+    if (now - pWrite->rateMoment >= BFL_4G_SOCKET_RATE_WINDOW_MS) {
+        pStat->txRateBps   = (pStat->txBytes - pWrite->rateBytes) * 1000 / (now - pWrite->rateMoment);
+        pWrite->rateMoment = now;
+        pWrite->rateBytes  = pStat->txBytes;
+    }
+}
+
 void at_qisend_callback(at_response_t *r)
 {
     uint8_t *params_tuple            = (uint8_t *)r->params;
@@ -563,29 +629,66 @@ void at_qisend_callback(at_response_t *r)
     int sockid = *(int *)params_tuple;
     at_free(r->params);
 
+    pContext->sendBusy = false;
     if (r->code == AT_RESP_OK) {
-        context.writeIsUsing                     = 0;
+        at_socket_send_done(sockid);
         pContext->socket_send_fail_times[sockid] = 0;
-        ULOG_INFO("[4G] TCP发送成功!");
+        at_link_up(sockid);
     } else {
-        if (pContext->socket_send_fail_times[sockid] > 3) {
-            ULOG_ERROR("[4G] TCP发送失败次数过多，重新连接");
-            pContext->socket_send_fail_times[sockid] = 0;
-        } else {
-            pContext->socket_send_fail_times[sockid]++;
-            ULOG_ERROR("[4G] TCP发送失败次数:%d", pContext->socket_send_fail_times[sockid]);
-        }
+        // 数据还在发送队列中，链路恢复后重发
+        pContext->socketWrites[sockid].inflight = 0;
+        pContext->socketWrites[sockid].stat.txFailTimes++;
+        pContext->socket_send_fail_times[sockid]++;
+        ULOG_ERROR("[4G] SOCKET%d TCP发送失败次数:%d", sockid, pContext->socket_send_fail_times[sockid]);
+        at_link_down(sockid);
     }
 }
 
 /**
- * @brief
+ * @brief 从发送队列首部取出本轮可以发送的数据，转换为QISENDEX命令发送。
+ * 数据在执行时才取出，任务在动态任务表中等待期间写入的数据也可以一起发送。
  *
  * @param sockid
  */
 void at_qisend_task_send(int sockid)
 {
     at_attr_t attr;
+    BFL_4G_SocketWrite_t *pWrite = &context.socketWrites[sockid];
+    AsyncTask_t *pTask           = context.task_list->pCurrentTask;
+    static uint8_t chunk[AT_QISEND_CHUNK_MAX];
+    uint32_t len                 = 0;
+    size_t wATBufLen             = 0;
+
+    len = pWrite->deficit < AT_QISEND_CHUNK_MAX ? pWrite->deficit : AT_QISEND_CHUNK_MAX;
+    len = cqueue_peek(&pWrite->sendQueue, 0, chunk, len);
+    if (len == 0 || !context.socketLinks[sockid].isOpen) {
+        // 等待期间链路断开了，数据留在发送队列中
+        context.sendBusy = false;
+        AsyncTask_SetFuncResult(pTask, AsyncTaskFuncResultMap(AT_RESP_OK));
+        AsyncTask_SetState(pTask, ASYNC_TASK_STATE_FINISHED);
+        return;
+    }
+
+    /**
+     AT+QISENDEX=0,"3132333435" //发送 16 进制字符串数据。
+     SEND OK
+      */
+    wATBufLen = sprintf((char *)at_output_buf, "AT+QISENDEX=%d,\"", sockid);
+    for (uint32_t i = 0; i < len; i++) {
+        sprintf((char *)at_output_buf + wATBufLen + i * 2, "%02X", chunk[i]);
+    }
+    wATBufLen += len * 2;
+    sprintf((char *)at_output_buf + wATBufLen, "\"");
+
+    pWrite->deficit -= len;
+    pWrite->inflight   = len;
+    pWrite->sendMoment = AsyncTaskGetMsTick();
+    if (pWrite->markNum > 0) {
+        pWrite->stat.lastWaitMs = pWrite->sendMoment - pWrite->marks[pWrite->markHead].moment;
+        if (pWrite->stat.lastWaitMs > pWrite->stat.maxWaitMs) {
+            pWrite->stat.maxWaitMs = pWrite->stat.lastWaitMs;
+        }
+    }
 
     void *params                             = at_malloc(sizeof(AsyncTaskExecContext_t *) + sizeof(int));
     uint8_t *params_tuple                    = (uint8_t *)params;
@@ -602,7 +705,7 @@ void at_qisend_task_send(int sockid)
     attr.priority = AT_PRIORITY_LOW;
     attr.ctx      = NULL;
 
-    at_send_singlline(context.at_obj, &attr, (char *)context.write_buf);
+    at_send_singlline(context.at_obj, &attr, (char *)at_output_buf);
 }
 
 void at_qisend_task_send_(void *param)
@@ -611,6 +714,207 @@ void at_qisend_task_send_(void *param)
     at_qisend_task_send(sockid);
 }
 
+/**
+ * @brief 把socket发送队列首部的数据作为一个发送任务压入动态任务表。
+ *
+ * @param sockid
+ * @return AsyncTask_t* 创建失败返回NULL。
+ */
+AsyncTask_t *at_qisend_task_push(int sockid)
+{
+    AsyncTask_t *at_qisend_task = AsyncTask_Create(at_qisend_task_send_, (void *)sockid, 0);
+    if (at_qisend_task != NULL) {
+        AsyncTaskList_DynamicPush(context.task_list, at_qisend_task);
+        AsyncTask_SetRoute(at_qisend_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), context.linkCheckTasks[sockid]);
+        AsyncTask_SetRoute(at_qisend_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), context.linkCheckTasks[sockid]);
+    }
+    return at_qisend_task;
+}
+
+void at_qiclose_task_send(int sockid)
+{
+    at_attr_t attr;
+
+    attr.params   = &context;
+    attr.prefix   = NULL;
+    attr.suffix   = "OK";
+    attr.cb       = NULL;
+    attr.timeout  = 3000;
+    attr.retry    = 0;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_exec_cmd(context.at_obj, &attr, "AT+QICLOSE=%d", sockid);
+}
+
+void at_qiclose_task_send_(void *param)
+{
+    int sockid = (int)param;
+    at_qiclose_task_send(sockid);
+}
+
+/**
+ * @brief 计算下一次重连前的退避时间，指数增长并在[d/2, d]之间随机抖动，
+ * 避免网络抖动时反复冲击模组和串口。
+ *
+ * @param backoffTimes 已经连续退避的次数
+ * @return uint32_t ms
+ */
+uint32_t at_link_backoff_delay(uint32_t backoffTimes)
+{
+    uint32_t shift = backoffTimes < 16 ? backoffTimes : 16;
+    uint32_t delay = (uint32_t)BFL_4G_RECONNECT_BACKOFF_BASE_MS << shift;
+    if (delay > BFL_4G_RECONNECT_BACKOFF_MAX_MS) {
+        delay = BFL_4G_RECONNECT_BACKOFF_MAX_MS;
+    }
+    return delay / 2 + (uint32_t)rand() % (delay / 2 + 1);
+}
+
+/**
+ * @brief 检测到socket链路异常，开始计时并设置链路检查任务的退避延时。
+ *
+ * @param sockid
+ */
+static void at_link_down(int sockid)
+{
+    BFL_4G_SocketLink_t *pLink = &context.socketLinks[sockid];
+    uint32_t delay             = 0;
+
+    // 只统计连接成功过之后的断线
+    if (pLink->isOpen && !pLink->isOutage) {
+        pLink->isOutage     = true;
+        pLink->outageMoment = AsyncTaskGetMsTick();
+    }
+    pLink->isOpen = false;
+
+    delay = at_link_backoff_delay(pLink->backoffTimes);
+    pLink->backoffTimes++;
+    AsyncTask_t *pLinkCheckTask = context.linkCheckTasks[sockid];
+    if (pLinkCheckTask != NULL) {
+        pLinkCheckTask->before_ready_delay = delay;
+    }
+    ULOG_INFO("[4G] SOCKET%d 链路异常，%ums后检查链路(第%u次)", sockid, delay, pLink->backoffTimes);
+}
+
+/**
+ * @brief socket链路可用，清除退避计数并统计重连耗时。
+ *
+ * @param sockid
+ */
+static void at_link_up(int sockid)
+{
+    BFL_4G_SocketLink_t *pLink = &context.socketLinks[sockid];
+    uint32_t costMs            = 0;
+
+    pLink->isOpen         = true;
+    pLink->backoffTimes   = 0;
+    context.netRegistered = true;
+    context.pdpIsActive   = true;
+
+    if (pLink->isOutage) {
+        pLink->isOutage = false;
+        costMs          = AsyncTaskGetMsTick() - pLink->outageMoment;
+        pLink->reconnectTimes++;
+        pLink->lastReconnectMs = costMs;
+        pLink->totalReconnectMs += costMs;
+        if (costMs > pLink->maxReconnectMs) {
+            pLink->maxReconnectMs = costMs;
+        }
+        ULOG_INFO("[4G] SOCKET%d 链路恢复，重建层:%d，耗时:%ums", sockid, pLink->recoverLayer, costMs);
+    }
+    pLink->recoverLayer = BFL_4G_LINK_LAYER_NONE;
+}
+
+void at_link_check_callback(at_response_t *r)
+{
+    uint8_t *params_tuple            = (uint8_t *)r->params;
+    AsyncTaskExecContext_t *pContext = *(AsyncTaskExecContext_t **)params_tuple;
+    params_tuple += sizeof(AsyncTaskExecContext_t *);
+    int sockid = *(int *)params_tuple;
+    at_free(r->params);
+
+    BFL_4G_SocketLink_t *pLink = &pContext->socketLinks[sockid];
+    AsyncTask_t *pNextTask     = NULL;
+    char *p                    = NULL;
+    int stat                   = 0;
+    int state                  = 0;
+
+    if (r->code == AT_RESP_OK) {
+        // +CREG: <n>,<stat>  stat 1:本地网络 5:漫游
+        p                       = strstr(r->recvbuf, "+CREG: ");
+        pContext->netRegistered = p != NULL && sscanf(p, "+CREG: %*d,%d", &stat) == 1 && (stat == 1 || stat == 5);
+        // +QIACT: <contextID>,<context_state>,...
+        p                     = strstr(r->recvbuf, "+QIACT: ");
+        pContext->pdpIsActive = p != NULL && sscanf(p, "+QIACT: %*d,%d", &state) == 1 && state == 1;
+        // +QISTATE: <connectID>,<service_type>,<IP_address>,<remote_port>,<local_port>,<socket_state>,...  2:已连接
+        p             = strstr(r->recvbuf, "+QISTATE: ");
+        pLink->isOpen = p != NULL && sscanf(p, "+QISTATE: %*d,\"%*[^\"]\",\"%*[^\"]\",%*d,%*d,%d", &state) == 1 && state == 2;
+    }
+
+    if (r->code != AT_RESP_OK) {
+        pLink->recoverLayer = BFL_4G_LINK_LAYER_MODEM;
+        pNextTask           = BFL_4G_BaseCfgTaskEntry(BFL_4G_BASE_CFG_AT);
+    } else if (!pContext->netRegistered) {
+        pLink->recoverLayer = BFL_4G_LINK_LAYER_REG;
+        pNextTask           = BFL_4G_BaseCfgTaskEntry(BFL_4G_BASE_CFG_CREG);
+    } else if (!pContext->pdpIsActive) {
+        pLink->recoverLayer = BFL_4G_LINK_LAYER_PDP;
+        pNextTask           = BFL_4G_BaseCfgTaskEntry(BFL_4G_BASE_CFG_QICSGP);
+    } else if (!pLink->isOpen || pLink->backoffTimes > BFL_4G_RECONNECT_RESEND_MAX_TIMES) {
+        // 模组认为连接正常但多次重发仍失败，按半开连接处理
+        pLink->isOpen       = false;
+        pLink->recoverLayer = BFL_4G_LINK_LAYER_SOCKET;
+        pNextTask           = pContext->sockeOpenTasks[sockid];
+    } else {
+        // 各层都正常，只是这一次发送失败，数据还在发送队列中，由调度直接重发
+        pLink->recoverLayer = BFL_4G_LINK_LAYER_NONE;
+        pNextTask           = NULL;
+    }
+    ULOG_INFO("[4G] SOCKET%d 链路检查 REG:%d PDP:%d SOCKET:%d，重建层:%d", sockid,
+              pContext->netRegistered, pContext->pdpIsActive, pLink->isOpen, pLink->recoverLayer);
+
+    AsyncTask_t *pLinkCheckTask = pContext->linkCheckTasks[sockid];
+    AsyncTask_SetRoute(pLinkCheckTask, AsyncTaskFuncResultMap(AT_RESP_OK), pNextTask);
+    AsyncTask_SetRoute(pLinkCheckTask, AsyncTaskFuncResultMap(AT_RESP_ERROR), pNextTask);
+    AsyncTask_SetRoute(pLinkCheckTask, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), pNextTask);
+}
+
+/**
+ * @brief 一次查询网络注册、PDP上下文和socket三层的状态。
+ *
+ * @param sockid
+ */
+void at_link_check_task_send(int sockid)
+{
+    at_attr_t attr;
+    void *params                             = at_malloc(sizeof(AsyncTaskExecContext_t *) + sizeof(int));
+    uint8_t *params_tuple                    = (uint8_t *)params;
+    *(AsyncTaskExecContext_t **)params_tuple = &context;
+    params_tuple += sizeof(AsyncTaskExecContext_t *);
+    *(int *)params_tuple = sockid;
+
+    attr.params   = params;
+    attr.prefix   = NULL;
+    attr.suffix   = "OK";
+    attr.cb       = at_link_check_callback;
+    attr.timeout  = 3000;
+    attr.retry    = 1;
+    attr.priority = AT_PRIORITY_LOW;
+    attr.ctx      = NULL;
+    at_exec_cmd(context.at_obj, &attr, "AT+CREG?;+QIACT?;+QISTATE=1,%d", sockid);
+}
+
+void at_link_check_task_send_(void *param)
+{
+    int sockid = (int)param;
+    at_link_check_task_send(sockid);
+}
+
+void at_link_idle_task_send(void *param)
+{
+    UNUSED(param);
+    AsyncTask_SetState(context.task_list->pCurrentTask, ASYNC_TASK_STATE_FINISHED);
+}
+
 void BFL_4G_BaseCfgTaskCreate()
 {
     // at_task_delay(5000);
@@ -628,66 +932,72 @@ void BFL_4G_BaseCfgTaskCreate()
     at_clk_task_send();
 }
 
-AsyncTask_t *at_task;
-AsyncTask_t *at_cpin_q_task;
-AsyncTask_t *at_creg_q_task;
-AsyncTask_t *at_cfun_task;
-AsyncTask_t *at_cgdcont_task;
-AsyncTask_t *at_cgact_task;
-AsyncTask_t *at_qicsgp_task;
-AsyncTask_t *at_qicfg_task;
-AsyncTask_t *at_clk_task;
-AsyncTask_t *at_qicfg_close_task;
-AsyncTask_t *at_qicfg_dataformat_task;
+/*
+Invake Map:
+AT->CPIN->CREG->CFUN->CGDCONT->CGACT->QICSGP->QICFG->CLK->QICFG_CLOSE->QICFG_DATAFORMAT
+除CFUN、CGDCONT(ERROR)、QICFG_CLOSE外，ERROR/TIMEOUT时重发本状态。
+*/
+#define BASE_CFG_RETRY(self, next) {(next), (self), (self)}
+static const AsyncTaskGraphState_t at_base_cfg_states[] = {
+    [BFL_4G_BASE_CFG_AT]               = {"AT", at_task_send, 5000, BASE_CFG_RETRY(BFL_4G_BASE_CFG_AT, BFL_4G_BASE_CFG_CPIN)},
+    [BFL_4G_BASE_CFG_CPIN]             = {"CPIN", at_cpin_q_task_send, 0, BASE_CFG_RETRY(BFL_4G_BASE_CFG_CPIN, BFL_4G_BASE_CFG_CREG)},
+    [BFL_4G_BASE_CFG_CREG]             = {"CREG", at_creg_q_task_send, 0, BASE_CFG_RETRY(BFL_4G_BASE_CFG_CREG, BFL_4G_BASE_CFG_CFUN)},
+    [BFL_4G_BASE_CFG_CFUN]             = {"CFUN", at_cfun_task_send, 0, {BFL_4G_BASE_CFG_CGDCONT, BFL_4G_BASE_CFG_CGDCONT, BFL_4G_BASE_CFG_CGDCONT}},
+    [BFL_4G_BASE_CFG_CGDCONT]          = {"CGDCONT", at_cgdcont_task_send, 0, {BFL_4G_BASE_CFG_CGACT, BFL_4G_BASE_CFG_CGACT, BFL_4G_BASE_CFG_CGDCONT}},
+    [BFL_4G_BASE_CFG_CGACT]            = {"CGACT", at_cgact_task_send, 0, BASE_CFG_RETRY(BFL_4G_BASE_CFG_CGACT, BFL_4G_BASE_CFG_QICSGP)},
+    [BFL_4G_BASE_CFG_QICSGP]           = {"QICSGP", at_qicsgp_task_send, 0, BASE_CFG_RETRY(BFL_4G_BASE_CFG_QICSGP, BFL_4G_BASE_CFG_QICFG)},
+    [BFL_4G_BASE_CFG_QICFG]            = {"QICFG", at_qicfg_task_send, 0, BASE_CFG_RETRY(BFL_4G_BASE_CFG_QICFG, BFL_4G_BASE_CFG_CLK)},
+    [BFL_4G_BASE_CFG_CLK]              = {"CLK", at_clk_task_send, 0, BASE_CFG_RETRY(BFL_4G_BASE_CFG_CLK, BFL_4G_BASE_CFG_QICFG_CLOSE)},
+    [BFL_4G_BASE_CFG_QICFG_CLOSE]      = {"QICFG_CLOSE", at_qicfg_close_task_send, 0, {BFL_4G_BASE_CFG_QICFG_DATAFORMAT, BFL_4G_BASE_CFG_QICFG_DATAFORMAT, BFL_4G_BASE_CFG_QICFG_DATAFORMAT}},
+    [BFL_4G_BASE_CFG_QICFG_DATAFORMAT] = {"QICFG_DATAFORMAT", at_qicfg_dataformat_task_send, 0, BASE_CFG_RETRY(BFL_4G_BASE_CFG_QICFG_DATAFORMAT, ASYNC_TASK_GRAPH_END)},
+};
+static const AsyncTaskGraph_t at_base_cfg_graph = {"base_cfg", at_base_cfg_states, ASYNC_TASK_GRAPH_STATE_NUM(at_base_cfg_states)};
+
+/*
+Invake Map:
+at_qiclose->at_qiopen->at_qisde->at_qiswtmd
+            |                    |
+            +---------+----------+
+                      | ERROR/TIMEOUT
+                      v
+     at_link_check_task(图的出口，退避延时) -> 基本配置图的AT / CREG / QICSGP / at_qiclose / 重发
+*/
+static const AsyncTaskGraphState_t at_tcp_open_states[] = {
+    [BFL_4G_TCP_OPEN_QICLOSE] = {"QICLOSE", at_qiclose_task_send_, 0, {BFL_4G_TCP_OPEN_QIOPEN, BFL_4G_TCP_OPEN_QIOPEN, BFL_4G_TCP_OPEN_QIOPEN}},
+    [BFL_4G_TCP_OPEN_QIOPEN]  = {"QIOPEN", at_qiopen_task_send_, 0, {BFL_4G_TCP_OPEN_QISDE, ASYNC_TASK_GRAPH_EXIT, ASYNC_TASK_GRAPH_EXIT}},
+    [BFL_4G_TCP_OPEN_QISDE]   = {"QISDE", at_qisde_task_send_, 0, {BFL_4G_TCP_OPEN_QISWTMD, BFL_4G_TCP_OPEN_QISDE, BFL_4G_TCP_OPEN_QISDE}},
+    [BFL_4G_TCP_OPEN_QISWTMD] = {"QISWTMD", at_qiswtmd_task_send_, 0, {ASYNC_TASK_GRAPH_END, ASYNC_TASK_GRAPH_EXIT, ASYNC_TASK_GRAPH_EXIT}},
+};
+static const AsyncTaskGraph_t at_tcp_open_graph = {"tcp_open", at_tcp_open_states, ASYNC_TASK_GRAPH_STATE_NUM(at_tcp_open_states)};
+
+// 校时只查询一次，失败时由at_clk_task_send的重发次数兜底
+static const AsyncTaskGraphState_t at_calibrate_time_states[] = {
+    {"CLK", at_clk_task_send, 0, {ASYNC_TASK_GRAPH_END, ASYNC_TASK_GRAPH_END, ASYNC_TASK_GRAPH_END}},
+};
+static const AsyncTaskGraph_t at_calibrate_time_graph = {"calibrate_time", at_calibrate_time_states, ASYNC_TASK_GRAPH_STATE_NUM(at_calibrate_time_states)};
+
+/**
+ * @brief 基本配置图任务，从指定的状态开始执行，用于链路检查后从需要重建的层开始重新配置。
+ *
+ * @param state
+ * @return AsyncTask_t* 作为路由目标。
+ */
+AsyncTask_t *BFL_4G_BaseCfgTaskEntry(enum BFL_4G_BASE_CFG_STATE state)
+{
+    return AsyncTaskGraph_Entry(&at_base_cfg_task, (uint8_t)state);
+}
 
 void BFL_4G_List_BaseCfgTaskCreate()
 {
     AsyncTaskList_t *task_list = context.task_list;
-    at_task                    = AsyncTask_Create(at_task_send, NULL, 5000);
-    at_cpin_q_task             = AsyncTask_Create(at_cpin_q_task_send, NULL, 0);
-    at_creg_q_task             = AsyncTask_Create(at_creg_q_task_send, NULL, 0);
-    at_cfun_task               = AsyncTask_Create(at_cfun_task_send, NULL, 0);
-    at_cgdcont_task            = AsyncTask_Create(at_cgdcont_task_send, NULL, 0);
-    at_cgact_task              = AsyncTask_Create(at_cgact_task_send, NULL, 0);
-    at_qicsgp_task             = AsyncTask_Create(at_qicsgp_task_send, NULL, 0);
-    at_qicfg_task              = AsyncTask_Create(at_qicfg_task_send, NULL, 0);
-    at_clk_task                = AsyncTask_Create(at_clk_task_send, NULL, 0);
-    at_qicfg_close_task        = AsyncTask_Create(at_qicfg_close_task_send, NULL, 0);
-    at_qicfg_dataformat_task   = AsyncTask_Create(at_qicfg_dataformat_task_send, NULL, 0);
-
-    AsyncTaskList_StaticAdd(task_list, at_task);
-    AsyncTaskList_StaticAdd(task_list, at_cpin_q_task);
-    AsyncTaskList_StaticAdd(task_list, at_creg_q_task);
-    AsyncTaskList_StaticAdd(task_list, at_cfun_task);
-    AsyncTaskList_StaticAdd(task_list, at_cgdcont_task);
-    AsyncTaskList_StaticAdd(task_list, at_cgact_task);
-    AsyncTaskList_StaticAdd(task_list, at_qicsgp_task);
-    AsyncTaskList_StaticAdd(task_list, at_qicfg_task);
-    AsyncTaskList_StaticAdd(task_list, at_clk_task);
-    AsyncTaskList_StaticAdd(task_list, at_qicfg_close_task);
-    AsyncTaskList_StaticAdd(task_list, at_qicfg_dataformat_task);
-
-    AsyncTask_SetRoute(at_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_task);
-    AsyncTask_SetRoute(at_cpin_q_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_cpin_q_task);
-    AsyncTask_SetRoute(at_creg_q_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_creg_q_task);
-    // AsyncTask_SetRoute(at_cgdcont_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_cgdcont_task);
-    AsyncTask_SetRoute(at_cgact_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_cgact_task);
-    AsyncTask_SetRoute(at_qicsgp_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qicsgp_task);
-    AsyncTask_SetRoute(at_qicfg_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qicfg_task);
-    AsyncTask_SetRoute(at_clk_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_clk_task);
-    // AsyncTask_SetRoute(at_qicfg_close_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qicfg_close_task);
-    AsyncTask_SetRoute(at_qicfg_dataformat_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qicfg_dataformat_task);
-
-    AsyncTask_SetRoute(at_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_task);
-    AsyncTask_SetRoute(at_cpin_q_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_cpin_q_task);
-    AsyncTask_SetRoute(at_creg_q_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_creg_q_task);
-    AsyncTask_SetRoute(at_cgdcont_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_cgdcont_task);
-    AsyncTask_SetRoute(at_cgact_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_cgact_task);
-    AsyncTask_SetRoute(at_qicsgp_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qicsgp_task);
-    AsyncTask_SetRoute(at_qicfg_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qicfg_task);
-    AsyncTask_SetRoute(at_clk_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_clk_task);
-    // AsyncTask_SetRoute(at_qicfg_close_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qicfg_close_task);
-    AsyncTask_SetRoute(at_qicfg_dataformat_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qicfg_dataformat_task);
+    at_link_idle_task          = &at_link_idle_task_;
+    context.linkIdleTask       = at_link_idle_task;
+
+    AsyncTask_Init(at_link_idle_task, at_link_idle_task_send, NULL, 0);
+
+    AsyncTaskGraph_Init(&at_base_cfg_task, &at_base_cfg_graph, at_base_cfg_trace, NULL, NULL);
+    AsyncTaskGraph_Init(&at_calibrate_time_task, &at_calibrate_time_graph, at_calibrate_time_trace, NULL, NULL);
+    AsyncTaskList_StaticAdd(task_list, &at_base_cfg_task);
 }
 
 void BFL_4G_TCP_TaskCreate(int sockid)
@@ -710,23 +1020,30 @@ void BFL_4G_TCP_TaskCreate(int sockid)
 
 void BFL_4G_TaskList_Create(int sockid)
 {
-    AsyncTask_t *at_qiopen_task    = AsyncTask_Create(at_qiopen_task_send_, (void *)sockid, 0);
-    AsyncTask_t *at_qisde_task     = AsyncTask_Create(at_qisde_task_send_, (void *)sockid, 0);
-    AsyncTask_t *at_qiswtmd_task   = AsyncTask_Create(at_qiswtmd_task_send_, (void *)sockid, 0);
-    context.sockeOpenTasks[sockid] = at_qiopen_task;
-
-    AsyncTaskList_t *task_list = context.task_list;
-    AsyncTaskList_StaticAdd(task_list, at_qiopen_task);
-    AsyncTaskList_StaticAdd(task_list, at_qisde_task);
-    AsyncTaskList_StaticAdd(task_list, at_qiswtmd_task);
-
-    AsyncTask_SetRoute(at_qiopen_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qiopen_task);
-    AsyncTask_SetRoute(at_qisde_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qisde_task);
-    AsyncTask_SetRoute(at_qiswtmd_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), at_qicfg_close_task);
+    AsyncTask_t *at_tcp_open_task   = &at_tcp_open_tasks[sockid];
+    AsyncTask_t *at_link_check_task = &at_link_check_tasks[sockid];
+    context.sockeOpenTasks[sockid]  = at_tcp_open_task;
+    context.linkCheckTasks[sockid]  = at_link_check_task;
+
+    // at_link_check_task不加入静态任务表，作为图的出口
+    AsyncTask_Init(at_link_check_task, at_link_check_task_send_, (void *)sockid, 0);
+    AsyncTaskGraph_Init(at_tcp_open_task, &at_tcp_open_graph, at_tcp_open_trace[sockid], (void *)sockid, at_link_check_task);
+    AsyncTaskList_StaticAdd(context.task_list, at_tcp_open_task);
+}
 
-    AsyncTask_SetRoute(at_qiopen_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qiopen_task);
-    AsyncTask_SetRoute(at_qisde_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qisde_task);
-    AsyncTask_SetRoute(at_qiswtmd_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), at_qicfg_close_task);
+/**
+ * @brief 打印基本配置、TCP连接和校时图中每个状态的执行统计。
+ *
+ */
+void BFL_4G_TaskGraph_TraceShow_Task()
+{
+    AsyncTaskGraph_TraceShow(&at_base_cfg_task);
+    for (int i = 0; i < 3; i++) {
+        if (context.sockeOpenTasks[i] != NULL) {
+            AsyncTaskGraph_TraceShow(&at_tcp_open_tasks[i]);
+        }
+    }
+    AsyncTaskGraph_TraceShow(&at_calibrate_time_task);
 }
 
 int32_t AsyncTaskFuncResultMap(at_resp_code code)
@@ -755,15 +1072,15 @@ void BFL_4G_AsyncTaskExecContext_Init()
 {
     if (!context.base_cfg_ok) {
         memset(&context, 0, sizeof(context));
+        srand(HDL_CPU_Time_GetUsTick()); // 重连退避抖动用
         context.task_list = AsyncTaskList_Create();
         if (context.task_list == NULL) {
             ULOG_ERROR("[4G] Async task list create failed.");
         }
 
         CHIP_EC800M_Init();
-        context.base_cfg_ok  = true;
-        context.writeIsUsing = 1; // 这里是想判断有没有成功初始化并且连接到服务器了，后面会更换标志位
-        context.baseCfgIsOk  = false;
+        context.base_cfg_ok = true;
+        context.baseCfgIsOk = false;
 
         BFL_4G_IOInterfaceInit();
         BFL_4G_List_BaseCfgTaskCreate();
@@ -771,67 +1088,158 @@ void BFL_4G_AsyncTaskExecContext_Init()
 }
 
 /**
- * @brief
+ * @brief 数据写入socket的发送队列，由BFL_4G_TCP_Poll_Task调度发送。
  *
  * @param sockid
  * @param writeBuf
  * @param uLen
- * @return uint32_t 实际写入的字节数，如果写入失败则返回0。可以通过BFL_4G_TCP_Task_Writeable()来
+ * @return uint32_t 实际写入的字节数，发送队列放不下时只写入能放下的部分。可以通过BFL_4G_TCP_Task_Writeable()来
  * 查看是否可以写数据。
  */
 uint32_t BFL_4G_TCPWrite_Task(int sockid, uint8_t *writeBuf, uint32_t uLen)
 {
-    uint32_t ret = 0;
-    if (BFL_4G_TCP_Task_Writeable()) {
-
-        size_t wLen = 0;
-
-        /**
-         AT+QISENDEX=0,"3132333435" //发送 16 进制字符串数据。
-         SEND OK
-          */
-        size_t wDataHexLen     = 0;
-        size_t wATBufRemainLen = AT_BUF_LEN - 2; // 最后一个字节留给'\0'和命令的'"'
-        size_t wATBufLen       = 0;
-        wDataHexLen            = uLen * 2;
-        wATBufLen              = sprintf((char *)at_output_buf, "AT+QISENDEX=%d,\"", sockid);
-        wATBufRemainLen -= wATBufLen;
-
-        wLen = wDataHexLen > wATBufRemainLen ? wATBufRemainLen : wDataHexLen;
-        wLen = wLen / 2; // 转换为字节
-        // 转换为16进制
-        for (size_t i = 0; i < wLen; i++) {
-            sprintf((char *)at_output_buf + wATBufLen + i * 2, "%02X", writeBuf[i]);
-        }
-        wATBufLen += wLen * 2;
-        wATBufLen += sprintf((char *)at_output_buf + wATBufLen, "\"");
+    BFL_4G_SocketWrite_t *pWrite    = &context.socketWrites[sockid];
+    BFL_4G_SocketWriteMark_t *pMark = NULL;
+    uint32_t wLen                   = 0;
+
+    if (pWrite->sendBuf == NULL || uLen == 0) {
+        return 0;
+    }
 
-        AsyncTaskList_t *task_list  = context.task_list;
-        AsyncTask_t *at_qisend_task = AsyncTask_Create(at_qisend_task_send_, (void *)sockid, 0);
-        if (at_qisend_task == NULL) {
-            ULOG_ERROR("[Async] AT qisend task create failed.");
-            ret = 0;
+    wLen = cqueue_residual_capacity(&pWrite->sendQueue) - 1;
+    if (wLen > uLen) {
+        wLen = uLen;
+    }
+    pWrite->stat.dropBytes += uLen - wLen;
+    if (wLen == 0) {
+        return 0;
+    }
+    cqueue_in(&pWrite->sendQueue, writeBuf, wLen);
+    pWrite->enqBytes += wLen;
+
+    // 记录写入时刻，标记用完时合并到最后一个标记里
+    if (pWrite->markNum < BFL_4G_SOCKET_WRITE_MARK_NUM) {
+        pMark         = &pWrite->marks[(pWrite->markHead + pWrite->markNum) % BFL_4G_SOCKET_WRITE_MARK_NUM];
+        pMark->moment = AsyncTaskGetMsTick();
+        pWrite->markNum++;
+    } else {
+        pMark = &pWrite->marks[(pWrite->markHead + pWrite->markNum - 1) % BFL_4G_SOCKET_WRITE_MARK_NUM];
+    }
+    pMark->end = pWrite->enqBytes;
+    return wLen;
+}
 
-            for (;;) {
-            }
-        } else {
-            context.write_buf     = at_output_buf;
-            context.write_buf_len = wLen;
-            context.writeIsUsing  = 1;
+/**
+ * @brief socket已经连接，并且发送队列至少还能放下一次QISENDEX的数据量时才可写。
+ *
+ * @param sockid
+ * @return uint32_t 发送队列剩余空间，不可写时返回0。
+ */
+uint32_t BFL_4G_TCP_Task_Writeable(int sockid)
+{
+    BFL_4G_SocketWrite_t *pWrite = &context.socketWrites[sockid];
+    uint32_t residual            = 0;
 
-            AsyncTaskList_DynamicPush(task_list, at_qisend_task);
-            AsyncTask_SetRoute(at_qisend_task, AsyncTaskFuncResultMap(AT_RESP_TIMEOUT), context.sockeOpenTasks[sockid]);
-            AsyncTask_SetRoute(at_qisend_task, AsyncTaskFuncResultMap(AT_RESP_ERROR), context.sockeOpenTasks[sockid]);
+    if (pWrite->sendBuf == NULL || !context.socketLinks[sockid].isOpen) {
+        return 0;
+    }
+    residual = cqueue_residual_capacity(&pWrite->sendQueue) - 1;
+    return residual >= AT_QISEND_CHUNK_MAX ? residual : 0;
+}
+
+void BFL_4G_TCP_Task_SetWeight(int sockid, uint8_t weight)
+{
+    context.socketWrites[sockid].weight = weight == 0 ? 1 : weight;
+}
+
+void BFL_4G_TCP_Task_GetStat(int sockid, BFL_4G_TCP_Stat_t *pStat)
+{
+    BFL_4G_SocketWrite_t *pWrite = &context.socketWrites[sockid];
+    *pStat                       = pWrite->stat;
+    pStat->queued                = pWrite->sendBuf == NULL ? 0 : cqueue_size(&pWrite->sendQueue);
+}
+
+static bool at_socket_sendable(int sockid)
+{
+    BFL_4G_SocketWrite_t *pWrite = &context.socketWrites[sockid];
+    return pWrite->sendBuf != NULL && context.socketLinks[sockid].isOpen && !cqueue_is_empty(&pWrite->sendQueue);
+}
+
+static void at_socket_send_turn_next()
+{
+    BFL_4G_SocketWrite_t *pWrite = NULL;
 
-            ret = wLen;
+    context.sendTurn = (context.sendTurn + 1) % 3;
+    pWrite           = &context.socketWrites[context.sendTurn];
+    pWrite->deficit += (uint32_t)pWrite->weight * BFL_4G_SOCKET_SEND_QUANTUM;
+}
+
+/**
+ * @brief 多个socket之间按权重轮转(Deficit Round Robin)发送：轮到的socket每轮获得
+ * 权重*BFL_4G_SOCKET_SEND_QUANTUM字节的额度，额度用完或者没有数据时轮到下一个socket。
+ * 同一时刻只有一个QISEND在执行，其他socket最多等待一个额度的数据发送完成。
+ *
+ */
+void BFL_4G_TCP_Poll_Task()
+{
+    if (context.sendBusy || context.task_list == NULL) {
+        return;
+    }
+
+    // 最多转一圈多一步，保证转回来的socket能拿到新的额度
+    for (int i = 0; i <= 3; i++) {
+        int sockid = context.sendTurn;
+        if (!at_socket_sendable(sockid)) {
+            // 没有数据的socket不积累额度
+            context.socketWrites[sockid].deficit = 0;
+        } else if (context.socketWrites[sockid].deficit > 0) {
+            if (at_qisend_task_push(sockid) == NULL) {
+                ULOG_ERROR("[Async] AT qisend task create failed.");
+            } else {
+                context.sendBusy = true;
+            }
+            return;
+        }
+        at_socket_send_turn_next();
+    }
+}
+
+/**
+ * @brief 没有QISEND在执行并且有socket有数据可以发送，下一次BFL_4G_TCP_Poll_Task就会发送。
+ *
+ * @return true
+ * @return false
+ */
+bool BFL_4G_TCP_HasPendingWork_Task()
+{
+    if (context.sendBusy || context.task_list == NULL) {
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (at_socket_sendable(i)) {
+            return true;
         }
     }
-    return ret;
+    return false;
+}
+
+bool BFL_4G_TCP_Task_IsConnected(int sockid)
+{
+    return context.socketLinks[sockid].isOpen;
 }
 
-bool BFL_4G_TCP_Task_Writeable()
+void BFL_4G_TCP_Task_LinkStatShow(int sockid)
 {
-    return context.writeIsUsing == 0;
+    BFL_4G_SocketLink_t *pLink = &context.socketLinks[sockid];
+    uint32_t avgMs             = pLink->reconnectTimes == 0 ? 0 : pLink->totalReconnectMs / pLink->reconnectTimes;
+    BFL_4G_TCP_Stat_t stat;
+    ULOG_INFO("[4G] SOCKET%d open:%d reconnect:%u last:%ums max:%ums avg:%ums backoff:%u",
+              sockid, pLink->isOpen, pLink->reconnectTimes, pLink->lastReconnectMs, pLink->maxReconnectMs,
+              avgMs, pLink->backoffTimes);
+    BFL_4G_TCP_Task_GetStat(sockid, &stat);
+    ULOG_INFO("[4G] SOCKET%d tx:%uB %u times fail:%u rate:%uB/s send last:%ums max:%ums avg:%ums wait last:%ums max:%ums queued:%u drop:%u",
+              sockid, stat.txBytes, stat.txTimes, stat.txFailTimes, stat.txRateBps, stat.lastSendMs, stat.maxSendMs,
+              stat.avgSendMs, stat.lastWaitMs, stat.maxWaitMs, stat.queued, stat.dropBytes);
 }
 
 int socket0_recv_handler(at_urc_info_t *info);
@@ -892,9 +1300,12 @@ void BFL_4G_TCP_Task_UCRTable_Init(int sockid)
 
 void BFL_4G_StartCalibrateTimeOneTimes_Task()
 {
-    AsyncTask_t *at_clk_task   = AsyncTask_Create(at_clk_task_send, NULL, 0);
     AsyncTaskList_t *task_list = context.task_list;
-    AsyncTaskList_DynamicPush(task_list, at_clk_task);
+    // 已经在排队或者正在执行时不重复加入
+    if (!sc_list_is_empty(&at_calibrate_time_task.node) || task_list->pCurrentTask == &at_calibrate_time_task) {
+        return;
+    }
+    AsyncTaskList_DynamicPush(task_list, &at_calibrate_time_task);
 }
 
 int socket0_recv_handler(at_urc_info_t *info)
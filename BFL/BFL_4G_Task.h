@@ -21,9 +21,12 @@ extern "C" {
 #include "at_chat.h"
 #include "cqueue.h"
 #include "AsyncTaskList.h"
+#include "BFL_4G.h"
 
 #define ALLOWED_PUBLIC_TOPIC_NUM    1
 #define ALLOWED_SUBSCRIBE_TOPIC_NUM 4
+// 3个socket的数据接收，以及MQTT的消息接收和连接状态
+#define BFL_4G_URC_TABLE_SIZE       (3 + 2)
 
 /*
 可用订阅ID: 0-4
@@ -54,19 +57,119 @@ typedef struct
     bool socketIsEnable[3];   ////socket是否使能
 } CommunPara_t;
 
+// 重连退避的基准时间和上限，实际延时在[d/2, d]之间随机抖动，d = BASE * 2^n
+#define BFL_4G_RECONNECT_BACKOFF_BASE_MS  500
+#define BFL_4G_RECONNECT_BACKOFF_MAX_MS   60000
+// 各层都正常时直接重发的最大次数，超过后按半开连接处理，重建Socket层
+#define BFL_4G_RECONNECT_RESEND_MAX_TIMES 2
+
+/**
+ * @brief 链路分层，重连时只重建失效的那一层以及它之上的层。
+ *
+ */
+typedef enum {
+    BFL_4G_LINK_LAYER_NONE = 0, // 链路正常，只需要重发
+    BFL_4G_LINK_LAYER_SOCKET,   // Socket断开，PDP仍然激活
+    BFL_4G_LINK_LAYER_PDP,      // PDP上下文去激活，网络仍然注册
+    BFL_4G_LINK_LAYER_REG,      // 网络未注册
+    BFL_4G_LINK_LAYER_MODEM,    // 模组无响应，需要从头初始化
+} BFL_4G_LinkLayer_t;
+
+typedef struct {
+    bool isOpen;
+    bool isOutage;                   // 是否处于断线恢复过程中
+    uint32_t outageMoment;           // 检测到断线的时刻，ms
+    uint32_t backoffTimes;           // 当前连续退避次数
+    BFL_4G_LinkLayer_t recoverLayer; // 本次恢复从哪一层开始重建
+
+    // 重连耗时统计，ms
+    uint32_t reconnectTimes;
+    uint32_t lastReconnectMs;
+    uint32_t maxReconnectMs;
+    uint32_t totalReconnectMs;
+} BFL_4G_SocketLink_t;
+
+// 每个socket一轮调度可以发送的字节数 = 权重 * BFL_4G_SOCKET_SEND_QUANTUM
+#define BFL_4G_SOCKET_SEND_QUANTUM    256
+#define BFL_4G_SOCKET_SEND_WEIGHT_DEF 1
+// 发送速率的统计窗口，ms
+#define BFL_4G_SOCKET_RATE_WINDOW_MS  5000
+// 记录写入时刻的标记数，用来统计排队延时，写满后合并到最后一个标记
+#define BFL_4G_SOCKET_WRITE_MARK_NUM  8
+
+typedef struct {
+    uint32_t end;     // 这次写入结束时的累计写入字节数
+    uint32_t moment;  // 写入时刻，ms
+} BFL_4G_SocketWriteMark_t;
+
+/**
+ * @brief 每个socket独立的发送上下文，发送队列之间按权重轮转调度(DRR)。
+ *
+ */
+typedef struct {
+    CQueue_t sendQueue;
+    uint8_t *sendBuf;
+    uint8_t weight;
+    uint32_t deficit;  // 本轮还可以发送的字节数
+    uint32_t inflight; // 正在发送的字节数，发送成功后才从发送队列中删除
+
+    uint32_t sendMoment; // 本次QISEND开始的时刻
+    uint32_t enqBytes;   // 累计写入字节数
+    BFL_4G_SocketWriteMark_t marks[BFL_4G_SOCKET_WRITE_MARK_NUM];
+    uint8_t markHead;
+    uint8_t markNum;
+
+    uint32_t rateMoment;
+    uint32_t rateBytes;
+    uint32_t totalSendMs;
+    BFL_4G_TCP_Stat_t stat;
+} BFL_4G_SocketWrite_t;
+
+// 基本配置任务图的状态，链路检查后按需要重建的层从对应的状态开始
+enum BFL_4G_BASE_CFG_STATE {
+    BFL_4G_BASE_CFG_AT,
+    BFL_4G_BASE_CFG_CPIN,
+    BFL_4G_BASE_CFG_CREG,
+    BFL_4G_BASE_CFG_CFUN,
+    BFL_4G_BASE_CFG_CGDCONT,
+    BFL_4G_BASE_CFG_CGACT,
+    BFL_4G_BASE_CFG_QICSGP,
+    BFL_4G_BASE_CFG_QICFG,
+    BFL_4G_BASE_CFG_CLK,
+    BFL_4G_BASE_CFG_QICFG_CLOSE,
+    BFL_4G_BASE_CFG_QICFG_DATAFORMAT,
+    BFL_4G_BASE_CFG_STATE_NUM,
+};
+
+// TCP连接任务图的状态
+enum BFL_4G_TCP_OPEN_STATE {
+    BFL_4G_TCP_OPEN_QICLOSE,
+    BFL_4G_TCP_OPEN_QIOPEN,
+    BFL_4G_TCP_OPEN_QISDE,
+    BFL_4G_TCP_OPEN_QISWTMD,
+    BFL_4G_TCP_OPEN_STATE_NUM,
+};
+
 typedef struct AsyncTaskExecContext {
     CommunPara_t CommunPara;
     at_obj_t *at_obj;
     bool isIdel;
     bool base_cfg_ok; // 参数是否设置了
-    uint8_t *write_buf;
-    uint32_t write_buf_len;
-    uint8_t writeIsUsing; // write Buffer 是否被占用
-    bool baseCfgIsOk;     // 基本配置过程实际执行完成
+    bool baseCfgIsOk; // 基本配置过程实际执行完成
+    BFL_4G_SocketWrite_t socketWrites[3];
+    bool sendBusy; // 同一时刻只有一个QISEND在执行
+    int sendTurn;  // 当前轮到哪个socket发送
     uint8_t *socketRevBufs[3];
     CQueue_t socketRevQueues[3];
-    AsyncTask_t *sockeOpenTasks[3];
-    urc_item_t urc_table[3]; // URC table
+    AsyncTask_t *sockeOpenTasks[3]; // TCP连接图任务，从QICLOSE开始
+    AsyncTask_t *linkCheckTasks[3]; // 游离任务：退避延时后查询各层状态，再路由到需要重建的层
+    AsyncTask_t *linkIdleTask;      // 游离任务：只重建Socket层时用来结束静态任务表
+
+    // 链路状态
+    bool netRegistered;
+    bool pdpIsActive;
+    BFL_4G_SocketLink_t socketLinks[3];
+    urc_item_t urc_table[BFL_4G_URC_TABLE_SIZE]; // URC table
     uint8_t urc_table_size;
 
     void (*setCalibrateTimeByUtcSecondsCb)(uint64_t utcSeconds);
@@ -84,12 +187,21 @@ void BFL_4G_BaseCfgTaskCreate();
 void BFL_4G_IOInterfaceInit();
 void BFL_4G_TCP_TaskCreate(int sockid);
 uint32_t BFL_4G_TCPWrite_Task(int sockid, uint8_t *writeBuf, uint32_t uLen);
-bool BFL_4G_TCP_Task_Writeable();
+uint32_t BFL_4G_TCP_Task_Writeable(int sockid);
+void BFL_4G_TCP_Task_SetWeight(int sockid, uint8_t weight);
+void BFL_4G_TCP_Task_GetStat(int sockid, BFL_4G_TCP_Stat_t *pStat);
+void BFL_4G_TCP_Poll_Task();
+bool BFL_4G_TCP_HasPendingWork_Task();
 void BFL_4G_TCP_Task_UCRTable_Init(int sockid);
 void BFL_4G_StartCalibrateTimeOneTimes_Task();
+bool BFL_4G_TCP_Task_IsConnected(int sockid);
+uint32_t at_link_backoff_delay(uint32_t backoffTimes);
+void BFL_4G_TCP_Task_LinkStatShow(int sockid);
 
 void BFL_4G_List_BaseCfgTaskCreate();
 void BFL_4G_TaskList_Create(int sockid);
+AsyncTask_t *BFL_4G_BaseCfgTaskEntry(enum BFL_4G_BASE_CFG_STATE state);
+void BFL_4G_TaskGraph_TraceShow_Task();
 #ifdef __cplusplus
 }
 #endif
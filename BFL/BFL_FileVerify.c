@@ -0,0 +1,201 @@
+/**
+ * @file BFL_FileVerify.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief FatFs文件的CRC32校验服务，说明见BFL_FileVerify.h。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "BFL_FileVerify.h"
+#include "crc.h"
+#include "HDL_CPU_Time.h"
+#include "log.h"
+
+typedef struct {
+    BFL_FileVerify_State_t state;
+    FIL file;
+    FIL *pFile;        // 正在校验的文件，BFL_FileVerify_Start打开的是file
+    uint32_t crc;      // 没有取反的CRC
+    uint32_t pending;  // 另一个缓冲区中还没有计算CRC的字节数
+    uint32_t cur;      // 下一次读取使用的缓冲区
+    bool eof;          // 已经读到文件末尾
+    uint64_t startUs;
+    BFL_FileVerify_Result_t result;
+} FileVerify_t;
+
+static FileVerify_t fv;
+// 按32位对齐，SPI DMA直接读到这里，CRC按4字节一组计算
+static uint32_t fv_buf[2][BFL_FILE_VERIFY_CHUNK / 4];
+
+static void BFL_FileVerify_Begin(FIL *pFile)
+{
+    memset(&fv.result, 0, sizeof(fv.result));
+    fv.pFile       = pFile;
+    fv.crc         = 0xFFFFFFFFUL;
+    fv.pending     = 0;
+    fv.cur         = 0;
+    fv.result.size = (uint32_t)f_size(pFile);
+    fv.eof         = fv.result.size == 0;
+    fv.startUs     = HDL_CPU_Time_GetUsTick64();
+    fv.state       = BFL_FILE_VERIFY_RUNNING;
+}
+
+static void BFL_FileVerify_Finish(BFL_FileVerify_State_t state, FRESULT res)
+{
+    fv.result.res       = res;
+    fv.result.elapsedUs = (uint32_t)(HDL_CPU_Time_GetUsTick64() - fv.startUs);
+    if (state == BFL_FILE_VERIFY_DONE) {
+        fv.result.crc = fv.crc ^ 0xFFFFFFFFUL;
+    }
+    if (fv.pFile == &fv.file) {
+        f_close(&fv.file);
+    }
+    fv.pFile = NULL;
+    fv.state = state;
+}
+
+/**
+ * @brief 执行一步：读取下一块到一个缓冲区，计算上一次读到另一个缓冲区的数据的CRC。
+ *
+ */
+static void BFL_FileVerify_Step()
+{
+    uint64_t startUs = HDL_CPU_Time_GetUsTick64();
+    uint32_t us;
+    UINT br = 0;
+    FRESULT res;
+
+    if (!fv.eof) {
+        res = f_read(fv.pFile, fv_buf[fv.cur], BFL_FILE_VERIFY_CHUNK, &br);
+        fv.result.reads++;
+        if (res != FR_OK) {
+            BFL_FileVerify_Finish(BFL_FILE_VERIFY_ERROR, res);
+            return;
+        }
+        fv.eof = br < BFL_FILE_VERIFY_CHUNK || f_eof(fv.pFile);
+    }
+    if (fv.pending > 0) {
+        fv.crc = CRC32_With((const uint8_t *)fv_buf[fv.cur ^ 1], fv.pending, fv.crc);
+        fv.result.bytes += fv.pending;
+    }
+    fv.pending = br;
+    fv.cur ^= 1;
+
+    us = (uint32_t)(HDL_CPU_Time_GetUsTick64() - startUs);
+    fv.result.polls++;
+    fv.result.busyUs += us;
+    if (us > fv.result.maxPollUs) {
+        fv.result.maxPollUs = us;
+    }
+    if (fv.eof && fv.pending == 0) {
+        // 文件在校验期间被截断时读到的字节数比开始时的长度少
+        BFL_FileVerify_Finish(fv.result.bytes == fv.result.size ? BFL_FILE_VERIFY_DONE : BFL_FILE_VERIFY_ERROR, FR_OK);
+    }
+}
+
+/**
+ * @brief 打开文件开始校验，之后在主循环中调用BFL_FileVerify_Poll，直到BFL_FileVerify_IsBusy返回false。
+ * 正在校验的文件被放弃。
+ *
+ * @param path 文件路径，例如"1:20240301.txt"。
+ * @return int32_t 成功返回0，打开失败返回-1，错误码见BFL_FileVerify_GetResult。
+ */
+int32_t BFL_FileVerify_Start(const char *path)
+{
+    FRESULT res;
+
+    BFL_FileVerify_Abort();
+    res = f_open(&fv.file, path, FA_READ);
+    if (res != FR_OK) {
+        memset(&fv.result, 0, sizeof(fv.result));
+        fv.result.res = res;
+        fv.state      = BFL_FILE_VERIFY_ERROR;
+        ULOG_ERROR("[FileVerify] open %s failed err code = %d", path, res);
+        return -1;
+    }
+    BFL_FileVerify_Begin(&fv.file);
+    return 0;
+}
+
+/**
+ * @brief 在主循环中调用，每次执行一步。
+ *
+ */
+void BFL_FileVerify_Poll()
+{
+    if (fv.state == BFL_FILE_VERIFY_RUNNING) {
+        BFL_FileVerify_Step();
+    }
+}
+
+/**
+ * @brief 放弃正在进行的校验并关闭文件。
+ *
+ */
+void BFL_FileVerify_Abort()
+{
+    if (fv.state == BFL_FILE_VERIFY_RUNNING) {
+        BFL_FileVerify_Finish(BFL_FILE_VERIFY_IDLE, FR_OK);
+    }
+}
+
+bool BFL_FileVerify_IsBusy()
+{
+    return fv.state == BFL_FILE_VERIFY_RUNNING;
+}
+
+BFL_FileVerify_State_t BFL_FileVerify_GetState()
+{
+    return fv.state;
+}
+
+void BFL_FileVerify_GetResult(BFL_FileVerify_Result_t *pResult)
+{
+    *pResult = fv.result;
+}
+
+/**
+ * @brief 一次计算已经打开的文件的CRC32，不会修改文件指针的位置。
+ * 和BFL_FileVerify_Start共用缓冲区，正在校验其他文件时返回错误。
+ *
+ * @param pFile 已经打开的文件对象指针，需要有读权限。
+ * @param pCrc
+ * @return int32_t 成功返回0，失败返回-1。
+ */
+int32_t BFL_FileVerify_CRC32(FIL *pFile, uint32_t *pCrc)
+{
+    FSIZE_t filePos;
+
+    if (pFile == NULL || pCrc == NULL || fv.state == BFL_FILE_VERIFY_RUNNING) {
+        return -1;
+    }
+    filePos = f_tell(pFile);
+    // 从文件开头读取，文件位置扇区对齐
+    if (f_lseek(pFile, 0) != FR_OK) {
+        return -1;
+    }
+    BFL_FileVerify_Begin(pFile);
+    while (fv.state == BFL_FILE_VERIFY_RUNNING) {
+        BFL_FileVerify_Step();
+    }
+    f_lseek(pFile, filePos);
+    if (fv.state != BFL_FILE_VERIFY_DONE) {
+        return -1;
+    }
+    *pCrc = fv.result.crc;
+    return 0;
+}
+
+void BFL_FileVerify_StatShow()
+{
+    uint32_t kbps = fv.result.busyUs > 0 ? (uint32_t)((uint64_t)fv.result.bytes * 1000000U / 1024U / fv.result.busyUs) : 0;
+
+    ULOG_INFO("[FileVerify] state:%d crc:%08x bytes:%u/%u reads:%u polls:%u", (int)fv.state, fv.result.crc,
+              fv.result.bytes, fv.result.size, fv.result.reads, fv.result.polls);
+    ULOG_INFO("[FileVerify] elapsed:%u us busy:%u us max poll:%u us, %u KB/s", fv.result.elapsedUs, fv.result.busyUs,
+              fv.result.maxPollUs, kbps);
+}
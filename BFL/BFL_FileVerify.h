@@ -0,0 +1,62 @@
+/**
+ * @file BFL_FileVerify.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief FatFs文件的CRC32校验服务，不使用malloc，用于校验Ymodem接收的固件、日志文件和QFS导出的文件。
+ * 文件按BFL_FILE_VERIFY_CHUNK（_MAX_SS的整数倍）分块读取，文件位置保持扇区对齐，
+ * FatFs直接把整扇区读到静态缓冲区（SD卡多块读），不经过文件对象的扇区缓冲。
+ * 两个缓冲区轮流使用：每次BFL_FileVerify_Poll读取下一块到一个缓冲区，再计算上一次读到另一个缓冲区的数据的CRC，
+ * 每次调用的耗时不超过读取一块加上计算一块，可以在主循环中逐步完成，不会长时间阻塞。
+ * 同时只能校验一个文件。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_FILE_VERIFY_H
+#define BFL_FILE_VERIFY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+
+// 每次读取的字节数，扇区大小的整数倍
+#define BFL_FILE_VERIFY_CHUNK (_MAX_SS)
+
+typedef enum {
+    BFL_FILE_VERIFY_IDLE = 0,
+    BFL_FILE_VERIFY_RUNNING,
+    BFL_FILE_VERIFY_DONE,
+    BFL_FILE_VERIFY_ERROR,
+} BFL_FileVerify_State_t;
+
+typedef struct {
+    uint32_t crc;        // 文件的CRC32，BFL_FILE_VERIFY_DONE时有效
+    uint32_t size;       // 文件长度
+    uint32_t bytes;      // 已经计算CRC的字节数
+    uint32_t reads;      // f_read次数
+    uint32_t polls;      // 执行的步数
+    uint32_t elapsedUs;  // 从开始到结束的时间
+    uint32_t busyUs;     // 各步耗时之和
+    uint32_t maxPollUs;  // 最长的一步
+    FRESULT res;         // 出错时FatFs返回的错误码
+} BFL_FileVerify_Result_t;
+
+int32_t BFL_FileVerify_Start(const char *path);
+void BFL_FileVerify_Poll(void);
+void BFL_FileVerify_Abort(void);
+bool BFL_FileVerify_IsBusy(void);
+BFL_FileVerify_State_t BFL_FileVerify_GetState(void);
+void BFL_FileVerify_GetResult(BFL_FileVerify_Result_t *pResult);
+int32_t BFL_FileVerify_CRC32(FIL *pFile, uint32_t *pCrc);
+void BFL_FileVerify_StatShow(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !BFL_FILE_VERIFY_H
@@ -0,0 +1,257 @@
+/**
+ * @file BFL_FileVerify_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief BFL_FileVerify测试：
+ * 先检查按4字节一组计算的CRC32和逐位计算的结果相同（各种起始地址和长度），
+ * 再写入不同长度的文件，检查逐步校验和一次校验的CRC、f_read次数、读取失败和放弃，
+ * 最后和原来的CRC32_File（malloc 1KB缓冲区，每次读1KB）比较按SPI时钟折算的吞吐量。
+ * 文件写在SD卡（1:盘）上，需要已经挂载。
+ * 没有SD卡的统计（目标板上pHooks为NULL）时按CPU时间计时，不比较读命令数。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "BFL_FileVerify_test.h"
+#include "app_fatfs.h"
+#include "HDL_CPU_Time.h"
+#include "crc.h"
+#include "log.h"
+
+// 吞吐量比较用的文件长度
+#define BENCH_BYTES  (1024UL * 1024)
+// 原来的CRC32_File每次读取的字节数
+#define LEGACY_CHUNK 1024U
+
+static const uint32_t _gSizes[] = {0, 1, 511, 4095, 4096, 4097, 100003, BENCH_BYTES};
+static uint8_t _gBuf[LEGACY_CHUNK];
+static const BFL_FileVerify_TestHooks_t *_gHooks = NULL;
+static uint32_t _gErrorCnt                       = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[FileVerify Test] check failed: %s", what);
+    }
+}
+
+// 文件中第pos个字节
+static uint8_t pattern(uint32_t pos)
+{
+    return (uint8_t)(pos * 167U + (pos >> 11));
+}
+
+static uint32_t crc32_bitwise(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+        }
+    }
+    return crc;
+}
+
+static uint32_t pattern_crc(uint32_t size)
+{
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (uint32_t pos = 0; pos < size; pos++) {
+        uint8_t b = pattern(pos);
+        crc       = crc32_bitwise(crc, &b, 1);
+    }
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+static uint64_t bus_ns()
+{
+    if (_gHooks == NULL) {
+        return HDL_CPU_Time_GetUsTick64() * 1000ULL;
+    }
+    return _gHooks->bus_ns();
+}
+
+static void bench_reset()
+{
+    if (_gHooks != NULL) {
+        _gHooks->reset();
+    }
+}
+
+static uint32_t read_cmds()
+{
+    return _gHooks != NULL ? _gHooks->read_cmds() : 0;
+}
+
+static void crc_table_test()
+{
+    static uint8_t buf[80];
+
+    for (uint32_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = pattern(i * 7U);
+    }
+    check(CRC32((const uint8_t *)"123456789", 9) == 0xCBF43926UL, "crc32 check value");
+    for (uint32_t offset = 0; offset < 8; offset++) {
+        for (uint32_t len = 0; len + offset <= sizeof(buf); len++) {
+            if (CRC32(buf + offset, len) != (crc32_bitwise(0xFFFFFFFFUL, buf + offset, len) ^ 0xFFFFFFFFUL)) {
+                check(false, "crc32 matches bitwise reference");
+                return;
+            }
+        }
+    }
+}
+
+static void make_file(const char *path, uint32_t size)
+{
+    FIL *pFile = &USERFile1;
+    UINT written;
+
+    check(f_open(pFile, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "create file");
+    for (uint32_t pos = 0; pos < size; pos += sizeof(_gBuf)) {
+        uint32_t len = size - pos < sizeof(_gBuf) ? size - pos : sizeof(_gBuf);
+        for (uint32_t i = 0; i < len; i++) {
+            _gBuf[i] = pattern(pos + i);
+        }
+        f_write(pFile, _gBuf, len, &written);
+    }
+    check(f_close(pFile) == FR_OK, "close file");
+}
+
+/**
+ * @brief 原来的CRC32_File：每次读取1KB。
+ *
+ */
+static uint32_t legacy_crc(const char *path)
+{
+    FIL *pFile   = &USERFile1;
+    uint32_t crc = 0xFFFFFFFFUL;
+    UINT br;
+
+    check(f_open(pFile, path, FA_READ) == FR_OK, "legacy open");
+    while (f_read(pFile, _gBuf, LEGACY_CHUNK, &br) == FR_OK && br > 0) {
+        crc = CRC32_With(_gBuf, br, crc);
+    }
+    f_close(pFile);
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+static void size_test()
+{
+    BFL_FileVerify_Result_t result;
+    FIL *pFile = &USERFile2;
+    char path[16];
+    uint32_t crc;
+
+    for (uint32_t n = 0; n < sizeof(_gSizes) / sizeof(_gSizes[0]); n++) {
+        uint32_t size   = _gSizes[n];
+        uint32_t expect = pattern_crc(size);
+
+        snprintf(path, sizeof(path), "1:f%u.bin", n);
+        make_file(path, size);
+
+        check(BFL_FileVerify_Start(path) == 0, "start");
+        for (int i = 0; i < 10000 && BFL_FileVerify_IsBusy(); i++) {
+            BFL_FileVerify_Poll();
+        }
+        BFL_FileVerify_GetResult(&result);
+        check(BFL_FileVerify_GetState() == BFL_FILE_VERIFY_DONE, "verify done");
+        check(result.crc == expect, "incremental crc");
+        check(result.size == size && result.bytes == size, "verified bytes");
+        check(result.reads == (size == 0 ? 0 : (size + BFL_FILE_VERIFY_CHUNK - 1) / BFL_FILE_VERIFY_CHUNK), "one read per chunk");
+
+        // 一次校验，不修改文件位置
+        check(f_open(pFile, path, FA_READ) == FR_OK, "open for crc");
+        f_lseek(pFile, size / 2);
+        check(BFL_FileVerify_CRC32(pFile, &crc) == 0 && crc == expect, "blocking crc");
+        check(f_tell(pFile) == size / 2, "file position restored");
+        f_close(pFile);
+    }
+}
+
+static void error_test()
+{
+    BFL_FileVerify_Result_t result;
+    FIL *pFile = &USERFile2;
+    uint32_t crc;
+
+    check(BFL_FileVerify_Start("1:none.bin") != 0, "missing file");
+    BFL_FileVerify_GetResult(&result);
+    check(BFL_FileVerify_GetState() == BFL_FILE_VERIFY_ERROR && result.res == FR_NO_FILE, "missing file error");
+
+    // 放弃后文件已经关闭，可以删除
+    check(BFL_FileVerify_Start("1:f7.bin") == 0, "start before abort");
+    BFL_FileVerify_Poll();
+    BFL_FileVerify_Poll();
+    check(BFL_FileVerify_IsBusy(), "busy");
+    check(f_open(pFile, "1:f7.bin", FA_READ) == FR_OK, "open while verifying");
+    check(BFL_FileVerify_CRC32(pFile, &crc) != 0, "blocking crc refused while busy");
+    f_close(pFile);
+    BFL_FileVerify_Abort();
+    check(BFL_FileVerify_GetState() == BFL_FILE_VERIFY_IDLE, "aborted");
+    check(f_unlink("1:f7.bin") == FR_OK, "file closed after abort");
+}
+
+static void bench_test()
+{
+    BFL_FileVerify_Result_t result;
+    uint64_t legacyNs;
+    uint64_t verifyNs;
+    uint64_t hostUs;
+    uint32_t legacyCmds;
+    uint32_t verifyCmds;
+
+    make_file("1:bench.bin", BENCH_BYTES);
+
+    bench_reset();
+    legacyNs = bus_ns();
+    check(legacy_crc("1:bench.bin") == pattern_crc(BENCH_BYTES), "legacy crc");
+    legacyNs   = bus_ns() - legacyNs;
+    legacyCmds = read_cmds();
+
+    bench_reset();
+    verifyNs = bus_ns();
+    hostUs   = HDL_CPU_Time_GetUsTick64();
+    check(BFL_FileVerify_Start("1:bench.bin") == 0, "bench start");
+    while (BFL_FileVerify_IsBusy()) {
+        BFL_FileVerify_Poll();
+    }
+    hostUs     = HDL_CPU_Time_GetUsTick64() - hostUs;
+    verifyNs   = bus_ns() - verifyNs;
+    verifyCmds = read_cmds();
+    BFL_FileVerify_GetResult(&result);
+    BFL_FileVerify_StatShow();
+
+    ULOG_INFO("[FileVerify Test] legacy 1KB reads: %u read commands, bus %.1f ms, %.2f MB/s", legacyCmds,
+              (double)legacyNs / 1e6, (double)BENCH_BYTES / (1024.0 * 1024.0) * 1e9 / (double)legacyNs);
+    ULOG_INFO("[FileVerify Test] BFL_FileVerify: %u read commands, bus %.1f ms, %.2f MB/s", verifyCmds,
+              (double)verifyNs / 1e6, (double)BENCH_BYTES / (1024.0 * 1024.0) * 1e9 / (double)verifyNs);
+    ULOG_INFO("[FileVerify Test] host cpu %.1f ms, %u polls, max poll %u us", (double)hostUs / 1e3, result.polls,
+              result.maxPollUs);
+    check(result.crc == pattern_crc(BENCH_BYTES), "bench crc");
+    if (_gHooks != NULL) {
+        check(verifyCmds < legacyCmds, "fewer sd read commands than legacy");
+    }
+    check(verifyNs <= legacyNs, "no more bus time than legacy");
+}
+
+/**
+ * @brief BFL_FileVerify测试，SD卡（1:盘）需要已经挂载。
+ *
+ * @param pHooks SD卡的统计，没有时为NULL。
+ * @return uint32_t 错误数。
+ */
+uint32_t BFL_FileVerify_test(const BFL_FileVerify_TestHooks_t *pHooks)
+{
+    _gHooks    = pHooks;
+    _gErrorCnt = 0;
+    crc_table_test();
+    size_test();
+    error_test();
+    bench_test();
+    ULOG_INFO("[FileVerify Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
@@ -0,0 +1,25 @@
+/**
+ * @file BFL_FileVerify_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_FILEVERIFY_TEST_H
+#define BFL_FILEVERIFY_TEST_H
+#include <stdint.h>
+#include "BFL_FileVerify.h"
+
+// SD卡的统计，主机上由SD卡模型提供，目标板上为NULL
+typedef struct {
+    void (*reset)(void);         // 清零统计
+    uint64_t (*bus_ns)(void);    // SPI总线时间，ns
+    uint32_t (*read_cmds)(void); // 读命令数（CMD17、CMD18）
+} BFL_FileVerify_TestHooks_t;
+
+uint32_t BFL_FileVerify_test(const BFL_FileVerify_TestHooks_t *pHooks);
+#endif // !BFL_FILEVERIFY_TEST_H
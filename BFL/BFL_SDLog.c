@@ -0,0 +1,442 @@
+/**
+ * @file BFL_SDLog.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 按天保存到SD卡的数据文件，说明见BFL_SDLog.h。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "BFL_SDLog.h"
+#include "ff.h"
+#include "datetime.h"
+#include "HDL_CPU_Time.h"
+#include "log.h"
+
+#define SDLOG_SECONDS_PER_DAY 86400U
+
+typedef enum {
+    SDLOG_STOPPED = 0,
+    SDLOG_OPENING,   // 等待打开当天的文件
+    SDLOG_EXPANDING, // 新建的文件等待预分配
+    SDLOG_OPEN,
+} SDLog_State_t;
+
+typedef struct {
+    SDLog_State_t state;
+    FIL file;
+    char drive[4];
+    char path[24];
+    uint32_t day;          // 当前文件的日期，1970-1-1以来的天数（本地时间）
+    uint32_t used;         // 缓冲区中的字节数
+    bool rolling;          // 已经过了零点，等待关闭当前文件
+    uint32_t rollBytes;    // 过零点时缓冲区中还属于当前文件的字节数
+    uint32_t syncMs;       // 上次同步的时间
+    uint32_t unsynced;     // 上次同步以来写入文件的字节数
+    uint32_t lastTryMs;    // 上次打开文件的时间
+    bool tried;            // 打开过文件，重试时等待BFL_SDLOG_RETRY_MS
+    BFL_SDLog_Stat_t stat;
+} SDLog_t;
+
+static SDLog_t sdlog;
+// 按32位对齐，SPI DMA从这里直接搬运整扇区
+static uint32_t sdlog_buf[BFL_SDLOG_BUF_SIZE / 4];
+
+static void BFL_SDLog_UpdateMax(uint32_t *pMax, uint32_t startUs)
+{
+    uint32_t us = HDL_CPU_Time_GetUsTick() - startUs;
+    if (us > *pMax) {
+        *pMax = us;
+    }
+}
+
+static void BFL_SDLog_Error(const char *what, FRESULT res)
+{
+    sdlog.stat.errors++;
+    ULOG_ERROR("[SDLog] %s %s failed err code = %d", what, sdlog.path, res);
+}
+
+/**
+ * @brief 把缓冲区前面的len字节写入文件，剩下的移到缓冲区开头。
+ *
+ * @return FRESULT
+ */
+static FRESULT BFL_SDLog_WriteOut(uint32_t len)
+{
+    uint8_t *buf     = (uint8_t *)sdlog_buf;
+    uint32_t startUs = HDL_CPU_Time_GetUsTick();
+    UINT written     = 0;
+    FRESULT res      = f_write(&sdlog.file, buf, len, &written);
+
+    BFL_SDLog_UpdateMax(&sdlog.stat.maxWriteUs, startUs);
+    sdlog.stat.writes++;
+    sdlog.stat.bytes += written;
+    sdlog.unsynced += written;
+    if (res == FR_OK && written != len) {
+        res = FR_DENIED; // 磁盘满
+    }
+    if (written > 0) {
+        memmove(buf, buf + written, sdlog.used - written);
+        sdlog.used -= written;
+        if (sdlog.rolling) {
+            sdlog.rollBytes -= written;
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief 缓冲区中属于当前文件的字节数，过零点之后写入的数据属于下一个文件。
+ *
+ */
+static uint32_t BFL_SDLog_Pending()
+{
+    return sdlog.rolling ? sdlog.rollBytes : sdlog.used;
+}
+
+/**
+ * @brief 检查是否过了零点，过了零点时记下缓冲区中属于当前文件的字节数。
+ *
+ */
+static void BFL_SDLog_CheckDay()
+{
+    if (!sdlog.rolling && (uint32_t)(datetime_get_local_timestamp() / SDLOG_SECONDS_PER_DAY) != sdlog.day) {
+        sdlog.rolling   = true;
+        sdlog.rollBytes = sdlog.used;
+    }
+}
+
+/**
+ * @brief 写入缓冲区中能让文件位置回到扇区边界的字节和之后的整扇区，整扇区不足minSize时不写。
+ *
+ * @param minSize 最少写入的整扇区字节数。
+ * @return FRESULT
+ */
+static FRESULT BFL_SDLog_FlushSectors(uint32_t minSize)
+{
+    uint32_t lead    = (BFL_SDLOG_SECTOR_SIZE - (uint32_t)(f_tell(&sdlog.file) % BFL_SDLOG_SECTOR_SIZE)) % BFL_SDLOG_SECTOR_SIZE;
+    uint32_t pending = BFL_SDLog_Pending();
+
+    if (pending < lead + minSize) {
+        return FR_OK;
+    }
+    return BFL_SDLog_WriteOut(lead + (pending - lead) / BFL_SDLOG_SECTOR_SIZE * BFL_SDLOG_SECTOR_SIZE);
+}
+
+/**
+ * @brief 写入缓冲区中属于当前文件的全部数据并同步。目录项中的文件长度在这里更新。
+ *
+ * @return FRESULT
+ */
+static FRESULT BFL_SDLog_Sync()
+{
+    uint32_t startUs = HDL_CPU_Time_GetUsTick();
+    uint32_t pending = BFL_SDLog_Pending();
+    FRESULT res      = FR_OK;
+
+    if (pending > 0) {
+        res = BFL_SDLog_WriteOut(pending);
+    }
+    if (res == FR_OK) {
+        res = f_sync(&sdlog.file);
+        sdlog.stat.syncs++;
+    }
+    sdlog.syncMs   = HDL_CPU_Time_GetTick();
+    sdlog.unsynced = 0;
+    BFL_SDLog_UpdateMax(&sdlog.stat.maxSyncUs, startUs);
+    return res;
+}
+
+/**
+ * @brief 打开当天的文件。新建的文件之后再预分配，已经存在的文件（例如当天复位过）在末尾继续写入。
+ *
+ */
+static void BFL_SDLog_Open()
+{
+    uint64_t now = datetime_get_local_timestamp();
+    mtime_t date;
+    FRESULT res;
+
+    mtime_unix_sec_2_time((unsigned int)now, &date);
+    sdlog.day = (uint32_t)(now / SDLOG_SECONDS_PER_DAY);
+    snprintf(sdlog.path, sizeof(sdlog.path), "%s%04d%02d%02d.txt", sdlog.drive, date.nYear, date.nMonth, date.nDay);
+
+    sdlog.rolling   = false;
+    sdlog.tried     = true;
+    sdlog.lastTryMs = HDL_CPU_Time_GetTick();
+    res             = f_open(&sdlog.file, sdlog.path, FA_CREATE_NEW | FA_WRITE);
+    if (res == FR_OK) {
+        sdlog.state = SDLOG_EXPANDING;
+    } else if (res == FR_EXIST) {
+        res = f_open(&sdlog.file, sdlog.path, FA_OPEN_APPEND | FA_WRITE);
+        if (res == FR_OK) {
+            sdlog.state = SDLOG_OPEN;
+        }
+    }
+    if (res != FR_OK) {
+        BFL_SDLog_Error("open", res);
+        return;
+    }
+    sdlog.stat.files++;
+    sdlog.syncMs   = HDL_CPU_Time_GetTick();
+    sdlog.unsynced = 0;
+    ULOG_INFO("[SDLog] open %s, size %u", sdlog.path, (uint32_t)f_size(&sdlog.file));
+}
+
+/**
+ * @brief 给新建的文件分配BFL_SDLOG_PREALLOC_SIZE的连续簇。
+ * f_expand把簇链写入FAT，同时把文件长度设为预分配的大小，这里把长度改回0，
+ * 之后f_write从文件开头沿已有的簇链写入（create_chain遇到已经链接的簇直接返回），文件长度随写入增长。
+ * 没有足够大的连续空间时不预分配，按普通文件写入。
+ */
+static void BFL_SDLog_Expand()
+{
+    FRESULT res = f_expand(&sdlog.file, BFL_SDLOG_PREALLOC_SIZE, 1);
+
+    if (res == FR_OK) {
+        sdlog.file.obj.objsize = 0;
+        // 目录项中记下起始簇，掉电后预分配的簇仍然属于这个文件
+        res = f_sync(&sdlog.file);
+        if (res != FR_OK) {
+            BFL_SDLog_Error("sync", res);
+        }
+    } else {
+        ULOG_WARNING("[SDLog] expand %s failed err code = %d, write without preallocation", sdlog.path, res);
+    }
+    sdlog.state = SDLOG_OPEN;
+}
+
+/**
+ * @brief 写入缓冲区中的数据，截断到实际长度并关闭文件。
+ * 预分配的簇链比文件长，f_truncate只在文件位置小于文件长度时释放簇，
+ * 所以先沿簇链把文件位置移到预分配的大小（不写入数据），再移回实际长度截断。
+ * 没有预分配的文件会在这里临时分配再释放，结果相同。
+ */
+static void BFL_SDLog_Close()
+{
+    FSIZE_t end;
+    FRESULT res = BFL_SDLog_Sync();
+
+    end = f_tell(&sdlog.file);
+    if (res == FR_OK && end < BFL_SDLOG_PREALLOC_SIZE) {
+        res = f_lseek(&sdlog.file, BFL_SDLOG_PREALLOC_SIZE);
+        if (res == FR_OK) {
+            res = f_lseek(&sdlog.file, end);
+        }
+        if (res == FR_OK) {
+            res = f_truncate(&sdlog.file);
+        }
+    }
+    if (res != FR_OK) {
+        BFL_SDLog_Error("truncate", res);
+    }
+    res = f_close(&sdlog.file);
+    if (res != FR_OK) {
+        BFL_SDLog_Error("close", res);
+    } else {
+        ULOG_INFO("[SDLog] close %s, size %u", sdlog.path, (uint32_t)end);
+    }
+}
+
+/**
+ * @brief 写入出错（例如SD卡拔出）后关闭文件，稍后重新打开，缓冲区中没有写入的数据保留。
+ *
+ */
+static void BFL_SDLog_Abort(const char *what, FRESULT res)
+{
+    BFL_SDLog_Error(what, res);
+    f_close(&sdlog.file);
+    sdlog.state = SDLOG_OPENING;
+}
+
+/**
+ * @brief 开始写入，时间校准、SD卡挂载之后调用。文件在BFL_SDLog_Poll中打开。
+ *
+ * @param drive 盘符，例如"1:"。
+ */
+void BFL_SDLog_Start(const char *drive)
+{
+    if (sdlog.state != SDLOG_STOPPED) {
+        return;
+    }
+    strncpy(sdlog.drive, drive, sizeof(sdlog.drive) - 1);
+    sdlog.drive[sizeof(sdlog.drive) - 1] = '\0';
+    sdlog.state                          = SDLOG_OPENING;
+    sdlog.tried                          = false;
+    if (sdlog.stat.startMs == 0) {
+        sdlog.stat.startMs = HDL_CPU_Time_GetTick();
+    }
+}
+
+/**
+ * @brief 写入缓冲区中的数据并关闭文件，SD卡卸载之前调用。
+ *
+ */
+void BFL_SDLog_Stop()
+{
+    if (sdlog.state == SDLOG_EXPANDING || sdlog.state == SDLOG_OPEN) {
+        BFL_SDLog_Close();
+    }
+    sdlog.state   = SDLOG_STOPPED;
+    sdlog.used    = 0;
+    sdlog.rolling = false;
+}
+
+bool BFL_SDLog_IsStarted()
+{
+    return sdlog.state != SDLOG_STOPPED;
+}
+
+/**
+ * @brief 写入数据。数据先复制到缓冲区，缓冲区放不下时先写入文件中的整扇区，
+ * 仍然放不下（文件没有打开或者写入出错）的部分丢弃。
+ *
+ * @param pData
+ * @param size
+ * @return uint32_t 接收的字节数。
+ */
+uint32_t BFL_SDLog_Write(const void *pData, uint32_t size)
+{
+    const uint8_t *pSrc = (const uint8_t *)pData;
+    uint32_t accepted   = 0;
+    uint32_t n          = 0;
+    FRESULT res;
+
+    if (sdlog.state == SDLOG_STOPPED) {
+        sdlog.stat.dropped += size;
+        return 0;
+    }
+    // 过零点之前的数据写入旧文件，从这里开始的数据写入新文件
+    if (sdlog.state == SDLOG_OPEN) {
+        BFL_SDLog_CheckDay();
+    }
+    while (accepted < size) {
+        if (sdlog.used == BFL_SDLOG_BUF_SIZE) {
+            if (sdlog.state != SDLOG_OPEN) {
+                break;
+            }
+            res = BFL_SDLog_FlushSectors(BFL_SDLOG_SECTOR_SIZE);
+            if (res != FR_OK) {
+                BFL_SDLog_Abort("write", res);
+                break;
+            }
+            if (sdlog.used == BFL_SDLOG_BUF_SIZE) {
+                break; // 缓冲区中都是零点之前的数据，等待BFL_SDLog_Poll关闭旧文件
+            }
+        }
+        n = BFL_SDLOG_BUF_SIZE - sdlog.used;
+        if (n > size - accepted) {
+            n = size - accepted;
+        }
+        memcpy((uint8_t *)sdlog_buf + sdlog.used, pSrc + accepted, n);
+        sdlog.used += n;
+        accepted += n;
+    }
+    sdlog.stat.dropped += size - accepted;
+    return accepted;
+}
+
+/**
+ * @brief 在主循环中调用。每次最多执行一步：打开文件、预分配、零点关闭旧文件、同步或者写入整扇区。
+ *
+ */
+void BFL_SDLog_Poll()
+{
+    uint32_t startUs = HDL_CPU_Time_GetUsTick();
+    uint32_t nowMs   = HDL_CPU_Time_GetTick();
+    uint32_t writes  = 0;
+    FRESULT res;
+
+    switch (sdlog.state) {
+        case SDLOG_OPENING:
+            if (sdlog.tried && nowMs - sdlog.lastTryMs < BFL_SDLOG_RETRY_MS) {
+                return;
+            }
+            BFL_SDLog_Open();
+            break;
+        case SDLOG_EXPANDING:
+            BFL_SDLog_Expand();
+            break;
+        case SDLOG_OPEN:
+            BFL_SDLog_CheckDay();
+            if (sdlog.rolling) {
+                // 零点之前的数据写入旧文件，下一次打开新文件
+                BFL_SDLog_Close();
+                sdlog.state = SDLOG_OPENING;
+                sdlog.tried = false;
+                break;
+            }
+            writes = sdlog.stat.writes;
+            if (sdlog.unsynced >= BFL_SDLOG_SYNC_BYTES ||
+                ((sdlog.unsynced > 0 || sdlog.used > 0) && nowMs - sdlog.syncMs >= BFL_SDLOG_SYNC_MS)) {
+                // 同步分两步：先写入整扇区，下一次只剩不足一个扇区的数据和目录项
+                res = BFL_SDLog_FlushSectors(BFL_SDLOG_SECTOR_SIZE);
+                if (res == FR_OK && writes == sdlog.stat.writes) {
+                    res = BFL_SDLog_Sync();
+                }
+            } else {
+                res = BFL_SDLog_FlushSectors(BFL_SDLOG_FLUSH_SIZE);
+            }
+            if (res != FR_OK) {
+                BFL_SDLog_Abort("write", res);
+            }
+            return;
+        default:
+            return;
+    }
+    BFL_SDLog_UpdateMax(&sdlog.stat.maxRollUs, startUs);
+}
+
+/**
+ * @brief 是否有马上需要处理的工作，主循环据此决定能否低功耗空闲。
+ *
+ */
+bool BFL_SDLog_HasPendingWork()
+{
+    switch (sdlog.state) {
+        case SDLOG_OPENING:
+            return !sdlog.tried || HDL_CPU_Time_GetTick() - sdlog.lastTryMs >= BFL_SDLOG_RETRY_MS;
+        case SDLOG_EXPANDING:
+            return true;
+        case SDLOG_OPEN:
+            return sdlog.rolling || BFL_SDLog_Pending() >= BFL_SDLOG_FLUSH_SIZE + BFL_SDLOG_SECTOR_SIZE ||
+                   sdlog.unsynced >= BFL_SDLOG_SYNC_BYTES;
+        default:
+            return false;
+    }
+}
+
+void BFL_SDLog_GetStat(BFL_SDLog_Stat_t *pStat)
+{
+    if (pStat != NULL) {
+        *pStat = sdlog.stat;
+    }
+}
+
+void BFL_SDLog_ResetStat()
+{
+    memset(&sdlog.stat, 0, sizeof(sdlog.stat));
+    sdlog.stat.startMs = HDL_CPU_Time_GetTick();
+}
+
+/**
+ * @brief 打印写入速度（MB/小时）和各步骤的最长耗时。
+ *
+ */
+void BFL_SDLog_StatShow()
+{
+    uint32_t elapsedMs = HDL_CPU_Time_GetTick() - sdlog.stat.startMs;
+    float mbPerHour    = 0;
+
+    if (elapsedMs > 0) {
+        mbPerHour = (float)sdlog.stat.bytes / (1024.0f * 1024.0f) * 3600000.0f / elapsedMs;
+    }
+    ULOG_INFO("[SDLog] %s %u KB, %.2f MB/h, writes:%u syncs:%u files:%u dropped:%u errors:%u",
+              sdlog.path, (uint32_t)(sdlog.stat.bytes / 1024), mbPerHour, sdlog.stat.writes, sdlog.stat.syncs,
+              sdlog.stat.files, sdlog.stat.dropped, sdlog.stat.errors);
+    ULOG_INFO("[SDLog] max us write:%u sync:%u roll:%u", sdlog.stat.maxWriteUs, sdlog.stat.maxSyncUs, sdlog.stat.maxRollUs);
+}
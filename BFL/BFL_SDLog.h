@@ -0,0 +1,70 @@
+/**
+ * @file BFL_SDLog.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 按天保存到SD卡的数据文件，文件名为<盘符>YYYYMMDD.txt。
+ * 新建的文件用f_expand预分配一段连续的簇，簇链一次写入FAT，之后的写入沿已有的簇链进行，不再修改FAT。
+ * 文件长度仍然是实际写入的长度，掉电后目录项中是最近一次同步时的长度，重新上电后在文件末尾继续写入。
+ * 写入的数据先放在RAM缓冲区中，凑够整扇区时才调用f_write，文件位置保持扇区对齐，
+ * FatFs直接把整扇区交给磁盘驱动（SD卡多块写），不经过文件对象的扇区缓冲。
+ * 按时间或者写入的字节数同步（f_sync），不再关闭、重新打开文件。
+ * 零点换文件分几步完成：关闭旧文件（截断到实际长度，释放没有用到的预分配簇）、打开新文件、预分配，
+ * 每次BFL_SDLog_Poll最多执行一步，期间写入的数据留在缓冲区中。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_SDLOG_H
+#define BFL_SDLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+// 扇区大小，和SD卡块大小相同
+#define BFL_SDLOG_SECTOR_SIZE   512U
+// RAM缓冲区大小，扇区的整数倍
+#define BFL_SDLOG_BUF_SIZE      (8U * BFL_SDLOG_SECTOR_SIZE)
+// 缓冲区中凑够多少字节的整扇区时写入文件，一次多块写
+#define BFL_SDLOG_FLUSH_SIZE    (2U * BFL_SDLOG_SECTOR_SIZE)
+// 每天的文件预分配的大小，字节
+#define BFL_SDLOG_PREALLOC_SIZE (8UL * 1024 * 1024)
+// 距上次同步的最长时间，ms
+#define BFL_SDLOG_SYNC_MS       2000U
+// 距上次同步写入多少字节后同步
+#define BFL_SDLOG_SYNC_BYTES    (64UL * 1024)
+// 打开文件失败后重试的间隔，ms
+#define BFL_SDLOG_RETRY_MS      1000U
+
+typedef struct {
+    uint64_t bytes;      // 写入文件的字节数
+    uint32_t writes;     // f_write次数
+    uint32_t syncs;      // f_sync次数
+    uint32_t files;      // 打开的文件数
+    uint32_t dropped;    // 缓冲区满或者没有启动时丢弃的字节数
+    uint32_t errors;     // FatFs返回错误的次数
+    uint32_t maxWriteUs; // 一次f_write的最长耗时
+    uint32_t maxSyncUs;  // 一次同步的最长耗时
+    uint32_t maxRollUs;  // 打开、预分配、关闭文件中最长的一步
+    uint32_t startMs;    // 开始统计的时间
+} BFL_SDLog_Stat_t;
+
+void BFL_SDLog_Start(const char *drive);
+void BFL_SDLog_Stop(void);
+bool BFL_SDLog_IsStarted(void);
+uint32_t BFL_SDLog_Write(const void *pData, uint32_t size);
+void BFL_SDLog_Poll(void);
+bool BFL_SDLog_HasPendingWork(void);
+void BFL_SDLog_GetStat(BFL_SDLog_Stat_t *pStat);
+void BFL_SDLog_ResetStat(void);
+void BFL_SDLog_StatShow(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !BFL_SDLOG_H
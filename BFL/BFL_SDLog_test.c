@@ -0,0 +1,279 @@
+/**
+ * @file BFL_SDLog_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief BFL_SDLog测试：
+ * 先按原来主程序的方式（每段数据一次f_write，每2秒关闭、重新打开文件）写入同样多的数据作为对照，
+ * 再用BFL_SDLog写入并跨过零点，比较写入SD卡的块数、按SPI时钟折算的吞吐量（MB/小时）和最长的一次调用，
+ * 检查文件内容、预分配的簇连续、零点换文件后多余的簇已经释放、复位后在当天的文件末尾继续写入。
+ * SD卡是1:盘，需要已经挂载；测试用到的文件开始时删除。
+ * 没有SD卡的统计（目标板上pHooks为NULL）时按CPU时间计时，不比较写入的块数。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "BFL_SDLog_test.h"
+#include "app_fatfs.h"
+#include "HDL_CPU_Time.h"
+#include "datetime.h"
+#include "log.h"
+
+// 4G转发的数据每段不超过400字节
+#define CHUNK_SIZE     400U
+// 第一天写入的字节数
+#define DAY1_BYTES     (1024UL * 1024)
+// 过零点之后写入的字节数
+#define DAY2_BYTES     (64UL * 1024)
+// 复位后继续写入的字节数
+#define RESUME_BYTES   1000U
+// 原来的主程序每2秒关闭、重新打开一次文件，按串口115200bps满速约23KB
+#define REOPEN_CHUNKS  57U
+// 2024-03-01 23:59:00，本地时间
+#define DAY1_TIMESTAMP 1709337540ULL
+
+typedef struct {
+    uint32_t blocks;  // 写入SD卡的数据块数，包括FAT和目录项
+    uint32_t extra;   // 其中数据之外多写的块数
+    uint64_t busNs;   // 总线时间
+    uint64_t maxNs;   // 最长的一次调用的总线时间
+    uint64_t rollNs;  // 零点换文件中最长的一步
+} Bench_t;
+
+static uint8_t _gChunk[CHUNK_SIZE];
+static const BFL_SDLog_TestHooks_t *_gHooks = NULL;
+static uint32_t _gErrorCnt                  = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[SDLog Test] check failed: %s", what);
+    }
+}
+
+// 数据流中第pos个字节
+static uint8_t pattern(uint32_t pos)
+{
+    return (uint8_t)(pos * 131U + (pos >> 9));
+}
+
+static const uint8_t *make_chunk(uint32_t pos, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        _gChunk[i] = pattern(pos + i);
+    }
+    return _gChunk;
+}
+
+static uint64_t bus_ns()
+{
+    if (_gHooks == NULL) {
+        return HDL_CPU_Time_GetUsTick64() * 1000ULL;
+    }
+    return _gHooks->bus_ns();
+}
+
+static void bench_begin(Bench_t *pBench)
+{
+    memset(pBench, 0, sizeof(*pBench));
+    if (_gHooks != NULL) {
+        _gHooks->reset();
+    }
+    pBench->busNs = bus_ns();
+}
+
+static void bench_end(Bench_t *pBench, const char *name, uint32_t bytes)
+{
+    if (_gHooks != NULL) {
+        pBench->blocks = _gHooks->blocks_written();
+        pBench->extra  = pBench->blocks - bytes / 512U;
+    }
+    pBench->busNs = bus_ns() - pBench->busNs;
+    ULOG_INFO("[SDLog Test] %s: %u KB, %u blocks (%u extra), %.0f MB/h", name, bytes / 1024, pBench->blocks,
+              pBench->extra, (double)bytes / (1024.0 * 1024.0) * 3600e9 / (double)pBench->busNs);
+    ULOG_INFO("[SDLog Test] %s: max call %.2f ms, max roll step %.2f ms", name, (double)pBench->maxNs / 1e6,
+              (double)pBench->rollNs / 1e6);
+}
+
+static void bench_call(uint64_t *pMax, uint64_t startNs)
+{
+    uint64_t ns = bus_ns() - startNs;
+    if (ns > *pMax) {
+        *pMax = ns;
+    }
+}
+
+/**
+ * @brief 原来主程序的写法：每段数据一次f_write，每2秒关闭、重新打开文件。
+ *
+ */
+static void legacy_write(Bench_t *pBench)
+{
+    FIL *pFile = &USERFile1;
+    uint32_t chunks = 0;
+    uint64_t startNs;
+    UINT written;
+
+    bench_begin(pBench);
+    check(f_open(pFile, "1:legacy.txt", FA_OPEN_APPEND | FA_WRITE) == FR_OK, "legacy open");
+    for (uint32_t pos = 0; pos < DAY1_BYTES; pos += CHUNK_SIZE) {
+        uint32_t len = DAY1_BYTES - pos < CHUNK_SIZE ? DAY1_BYTES - pos : CHUNK_SIZE;
+        startNs      = bus_ns();
+        f_write(pFile, make_chunk(pos, len), len, &written);
+        bench_call(&pBench->maxNs, startNs);
+        if (++chunks % REOPEN_CHUNKS == 0) {
+            startNs = bus_ns();
+            f_close(pFile);
+            f_open(pFile, "1:legacy.txt", FA_OPEN_APPEND | FA_WRITE);
+            bench_call(&pBench->maxNs, startNs);
+        }
+    }
+    f_close(pFile);
+    bench_end(pBench, "legacy f_write + reopen", DAY1_BYTES);
+}
+
+/**
+ * @brief 用BFL_SDLog写入数据流中[from, to)的字节，每段数据之后调用一次BFL_SDLog_Poll。
+ *
+ */
+static void sdlog_write(Bench_t *pBench, uint32_t from, uint32_t to)
+{
+    uint64_t startNs;
+
+    for (uint32_t pos = from; pos < to; pos += CHUNK_SIZE) {
+        uint32_t len = to - pos < CHUNK_SIZE ? to - pos : CHUNK_SIZE;
+        startNs      = bus_ns();
+        check(BFL_SDLog_Write(make_chunk(pos, len), len) == len, "sdlog write accepted");
+        BFL_SDLog_Poll();
+        bench_call(&pBench->maxNs, startNs);
+    }
+}
+
+/**
+ * @brief 轮询直到没有马上需要处理的工作：关闭旧文件、打开新文件、预分配，每一步计入rollNs。
+ *
+ */
+static void sdlog_settle(Bench_t *pBench)
+{
+    uint64_t startNs;
+
+    for (int i = 0; i < 8 && BFL_SDLog_HasPendingWork(); i++) {
+        startNs = bus_ns();
+        BFL_SDLog_Poll();
+        bench_call(&pBench->rollNs, startNs);
+    }
+}
+
+/**
+ * @brief 检查文件的长度和内容，内容是数据流中从from开始的字节。
+ *
+ * @return uint32_t 文件的碎片数
+ */
+static uint32_t verify_file(const char *path, uint32_t from, uint32_t size)
+{
+    FIL *pFile = &USERFile2;
+    DWORD linkMap[16];
+    uint8_t buf[512];
+    uint32_t bad = 0;
+    UINT br      = 0;
+
+    if (f_open(pFile, path, FA_READ) != FR_OK) {
+        check(false, "open log file");
+        return 0;
+    }
+    check(f_size(pFile) == size, "log file size");
+    for (uint32_t pos = 0; pos < size; pos += br) {
+        if (f_read(pFile, buf, sizeof(buf), &br) != FR_OK || br == 0) {
+            bad++;
+            break;
+        }
+        for (UINT i = 0; i < br; i++) {
+            bad += buf[i] != pattern(from + pos + i);
+        }
+    }
+    check(bad == 0, "log file content");
+    // 建立簇链映射表，linkMap[0]为用到的表项数：每个碎片2项，加上表头和结束标志
+    pFile->cltbl = linkMap;
+    linkMap[0]   = sizeof(linkMap) / sizeof(linkMap[0]);
+    check(f_lseek(pFile, CREATE_LINKMAP) == FR_OK, "link map");
+    f_close(pFile);
+    return (linkMap[0] - 2) / 2;
+}
+
+static DWORD free_clusters()
+{
+    FATFS *fs;
+    DWORD freeClust = 0;
+    f_getfree("1:", &freeClust, &fs);
+    return freeClust;
+}
+
+/**
+ * @brief BFL_SDLog测试，SD卡（1:盘）需要已经挂载。
+ *
+ * @param pHooks SD卡的统计，没有时为NULL。
+ * @return uint32_t 错误数。
+ */
+uint32_t BFL_SDLog_test(const BFL_SDLog_TestHooks_t *pHooks)
+{
+    Bench_t legacy;
+    Bench_t sink;
+    BFL_SDLog_Stat_t stat;
+    DWORD freeBefore;
+    DWORD clusterBytes;
+    FATFS *fs;
+
+    _gHooks    = pHooks;
+    _gErrorCnt = 0;
+    // 从没有测试文件开始，可以重复运行
+    f_unlink("1:legacy.txt");
+    f_unlink("1:20240301.txt");
+    f_unlink("1:20240302.txt");
+    f_getfree("1:", &freeBefore, &fs);
+    clusterBytes = (DWORD)fs->csize * 512U;
+
+    legacy_write(&legacy);
+
+    datetime_set_local_timestamp(DAY1_TIMESTAMP);
+    freeBefore = free_clusters();
+    bench_begin(&sink);
+    BFL_SDLog_ResetStat();
+    BFL_SDLog_Start("1:");
+    sdlog_settle(&sink);
+    sdlog_write(&sink, 0, DAY1_BYTES);
+
+    // 过零点：缓冲区中之前写入的数据写入旧文件，之后的写入新文件
+    datetime_set_local_timestamp(DAY1_TIMESTAMP + 61);
+    check(BFL_SDLog_Write(make_chunk(DAY1_BYTES, CHUNK_SIZE), CHUNK_SIZE) == CHUNK_SIZE, "write after midnight");
+    sdlog_settle(&sink);
+    sdlog_write(&sink, DAY1_BYTES + CHUNK_SIZE, DAY1_BYTES + DAY2_BYTES);
+    BFL_SDLog_Stop();
+    bench_end(&sink, "BFL_SDLog", DAY1_BYTES + DAY2_BYTES);
+    BFL_SDLog_GetStat(&stat);
+    BFL_SDLog_StatShow();
+
+    check(verify_file("1:20240301.txt", 0, DAY1_BYTES) == 1, "day file is contiguous");
+    check(verify_file("1:20240302.txt", DAY1_BYTES, DAY2_BYTES) == 1, "next day file is contiguous");
+    check(freeBefore - free_clusters() == (DAY1_BYTES + clusterBytes - 1) / clusterBytes + (DAY2_BYTES + clusterBytes - 1) / clusterBytes,
+          "preallocated clusters released");
+    check(stat.files == 2, "two files");
+    check(stat.dropped == 0 && stat.errors == 0, "no dropped bytes or errors");
+    check(stat.bytes / stat.writes >= 2 * CHUNK_SIZE, "batched writes");
+    if (_gHooks != NULL) {
+        check(sink.extra < legacy.extra, "fewer extra blocks written than legacy");
+    }
+    check(sink.maxNs < legacy.maxNs, "shorter worst case call than legacy");
+
+    // 复位后同一天在文件末尾继续写入
+    BFL_SDLog_Start("1:");
+    sdlog_settle(&sink);
+    sdlog_write(&sink, DAY1_BYTES + DAY2_BYTES, DAY1_BYTES + DAY2_BYTES + RESUME_BYTES);
+    BFL_SDLog_Stop();
+    verify_file("1:20240302.txt", DAY1_BYTES, DAY2_BYTES + RESUME_BYTES);
+
+    ULOG_INFO("[SDLog Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
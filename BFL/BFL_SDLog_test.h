@@ -0,0 +1,25 @@
+/**
+ * @file BFL_SDLog_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BFL_SDLOG_TEST_H
+#define BFL_SDLOG_TEST_H
+#include <stdint.h>
+#include "BFL_SDLog.h"
+
+// SD卡的统计，主机上由SD卡模型提供，目标板上为NULL
+typedef struct {
+    void (*reset)(void);              // 清零统计
+    uint64_t (*bus_ns)(void);         // SPI总线时间，ns
+    uint32_t (*blocks_written)(void); // 写入SD卡的数据块数，包括FAT和目录项
+} BFL_SDLog_TestHooks_t;
+
+uint32_t BFL_SDLog_test(const BFL_SDLog_TestHooks_t *pHooks);
+#endif // !BFL_SDLOG_TEST_H
@@ -11,19 +11,24 @@
  */
 #include "datetime.h"
 #include <stddef.h>
+#include "main.h"
 #include "HDL_RTC.h"
 
 // RTC上跑的是UTC+0时区，所以需要设置时区
 static int8_t timezone = 8;
 
+// 最近一次转换的本地时间戳和对应的本地时间，同一秒内多次获取本地时间(日志、文件名)时不用重复转换
+static uint64_t localtime_cache_sec = UINT64_MAX;
+static mtime_t localtime_cache;
+
 void datetime_init(void)
 {
     HDL_RTC_Init();
 }
 
-void datetime_set_timezone(int8_t timezone)
+void datetime_set_timezone(int8_t tz)
 {
-    timezone = timezone;
+    timezone = tz;
 }
 int8_t datetime_get_timezone()
 {
@@ -35,11 +40,35 @@ void datetime_set_localtime(mtime_t *mtime)
     uint64_t utc0_timestamp  = local_timestamp - timezone * 3600;
     HDL_RTC_SetTimeTick(utc0_timestamp);
 }
+/**
+ * @brief 获取本地时间。秒数变化时才重新转换，同一秒内返回缓存的结果，可以在中断中调用。
+ *
+ * @param mtime
+ */
 void datetime_get_localtime(mtime_t *mtime)
 {
     uint64_t utc0_timestamp  = HDL_RTC_GetTimeTick(NULL);
     uint64_t local_timestamp = utc0_timestamp + timezone * 3600;
-    mtime_unix_sec_2_time(local_timestamp, mtime);
+    uint32_t primask         = 0;
+    mtime_t tmp;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (local_timestamp == localtime_cache_sec) {
+        *mtime = localtime_cache;
+        __set_PRIMASK(primask);
+        return;
+    }
+    __set_PRIMASK(primask);
+
+    mtime_unix_sec_2_time(local_timestamp, &tmp);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    localtime_cache     = tmp;
+    localtime_cache_sec = local_timestamp;
+    __set_PRIMASK(primask);
+    *mtime = tmp;
 }
 void datetime_set_local_timestamp(uint64_t timestamp)
 {
@@ -0,0 +1,150 @@
+/**
+ * @file dlog.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 延迟输出的二进制日志，格式见dlog.h。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdarg.h>
+#include <string.h>
+#include "main.h"
+#include "dlog.h"
+#include "HDL_CPU_Time.h"
+
+static uint8_t dlog_ring[DLOG_RING_SIZE];
+// 自由增长的读写位置，head-tail为缓冲区中的字节数
+static volatile uint32_t dlog_head;
+static volatile uint32_t dlog_tail;
+static uint8_t dlog_seq;
+static uint8_t dlog_level = DLOG_LEVEL_DEBUG;
+static dlog_sink_t dlog_sink;
+static DLOG_Stat_t dlog_stat;
+
+/**
+ * @brief 写入一条记录，可以在中断中调用。一般通过DLOG_*宏调用。
+ *
+ * @param level DLOG_LEVEL_*
+ * @param argc fmt之后参数的个数。
+ * @param fmt 格式字符串，必须是常量字符串，只记录它的地址。
+ * @param ... argc个uint32_t参数，DLOG_*宏已经用DLOG_ARG转换过，直接调用时也必须传uint32_t。
+ */
+void dlog_write(uint8_t level, uint32_t argc, const char *fmt, ...)
+{
+    uint32_t rec[DLOG_HEADER_LEN / 4 + DLOG_ARG_MAX];
+    uint32_t len     = 0;
+    uint32_t used    = 0;
+    uint32_t off     = 0;
+    uint32_t first   = 0;
+    uint32_t primask = 0;
+    va_list vArgs;
+
+    if (level < dlog_level) {
+        return;
+    }
+    if (argc > DLOG_ARG_MAX) {
+        argc = DLOG_ARG_MAX;
+    }
+    rec[1] = (uint32_t)(uintptr_t)fmt;
+    rec[2] = HDL_CPU_Time_GetUsTick();
+    va_start(vArgs, fmt);
+    for (uint32_t i = 0; i < argc; i++) {
+        rec[3 + i] = va_arg(vArgs, uint32_t);
+    }
+    va_end(vArgs);
+    len = DLOG_HEADER_LEN + argc * 4;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    rec[0] = DLOG_SYNC | (argc << 8) | ((uint32_t)level << 16) | ((uint32_t)dlog_seq << 24);
+    dlog_seq++;
+    used = dlog_head - dlog_tail;
+    if (DLOG_RING_SIZE - used < len) {
+        dlog_stat.dropped++;
+    } else {
+        off   = dlog_head & (DLOG_RING_SIZE - 1);
+        first = DLOG_RING_SIZE - off < len ? DLOG_RING_SIZE - off : len;
+        memcpy(&dlog_ring[off], rec, first);
+        memcpy(dlog_ring, (uint8_t *)rec + first, len - first);
+        dlog_head += len;
+        dlog_stat.written++;
+        if (used + len > dlog_stat.maxUsed) {
+            dlog_stat.maxUsed = used + len;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void dlog_set_sink(dlog_sink_t sink)
+{
+    dlog_sink = sink;
+}
+
+dlog_sink_t dlog_get_sink()
+{
+    return dlog_sink;
+}
+
+/**
+ * @brief 低于level的记录不写入。
+ *
+ * @param level DLOG_LEVEL_*
+ */
+void dlog_set_level(uint8_t level)
+{
+    dlog_level = level;
+}
+
+/**
+ * @brief 把缓冲区中的记录交给输出接口，在主循环等低优先级的地方调用。
+ * 只有一个调用者，不需要关中断。
+ *
+ * @param maxBytes 本次最多输出的字节数。
+ * @return uint32_t 实际输出的字节数。
+ */
+uint32_t dlog_drain(uint32_t maxBytes)
+{
+    uint32_t tail  = dlog_tail;
+    uint32_t total = 0;
+    uint32_t n     = 0;
+    uint32_t off   = 0;
+    uint32_t w     = 0;
+
+    if (dlog_sink == NULL) {
+        return 0;
+    }
+    while (total < maxBytes && dlog_head != tail) {
+        off = tail & (DLOG_RING_SIZE - 1);
+        n   = dlog_head - tail;
+        n   = n < DLOG_RING_SIZE - off ? n : DLOG_RING_SIZE - off;
+        n   = n < maxBytes - total ? n : maxBytes - total;
+        w   = dlog_sink(&dlog_ring[off], n);
+        tail += w;
+        total += w;
+        if (w < n) {
+            break;
+        }
+    }
+    dlog_tail = tail;
+    dlog_stat.drainBytes += total;
+    return total;
+}
+
+bool dlog_pending()
+{
+    return dlog_head != dlog_tail;
+}
+
+void dlog_get_stat(DLOG_Stat_t *pStat)
+{
+    *pStat = dlog_stat;
+}
+
+void dlog_stat_show()
+{
+    ULOG_INFO("[DLOG] written:%u dropped:%u drain:%uB max used:%u/%uB", dlog_stat.written, dlog_stat.dropped,
+              dlog_stat.drainBytes, dlog_stat.maxUsed, DLOG_RING_SIZE);
+}
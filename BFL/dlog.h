@@ -0,0 +1,113 @@
+/**
+ * @file dlog.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 延迟输出的二进制日志。
+ * DLOG_*只把格式字符串的地址、时间戳和参数原样写入RAM环形缓冲区，不做格式化，也不等待串口，
+ * 适合SD卡读写、中断等热路径。dlog_drain在主循环中把缓冲区中的记录交给输出接口（串口/RTT/Flash），
+ * 上位机用tools/dlog_decode.py按固件ELF(.axf)中的格式字符串还原为文本。
+ * 记录格式（小端）：
+ * | 0xD1 | argc(1) | level(1) | seq(1) | fmt地址(4) | 时间戳us(4) | 参数(4*argc) |
+ * seq每写一条加1，写不下丢弃的记录也占用seq，上位机据此发现丢失。
+ * 限制：参数只能是不超过32位的整数和字符，DLOG_*宏在编译时检查，64位整数、浮点数和指针会编译报错。
+ * %s和%p的参数用DLOG_ADDR()记录地址，%s只能用于Flash中的常量字符串。不支持%f和%ll。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef DLOG_H
+#define DLOG_H
+#include <stdint.h>
+#include <stdbool.h>
+#include "ulog.h"
+
+// 延迟日志开关，为0时DLOG_*直接按ULOG_*输出
+#ifndef DLOG_ENABLE
+#define DLOG_ENABLE 1
+#endif
+
+// 环形缓冲区大小，必须是2的幂
+#define DLOG_RING_SIZE  2048U
+// 一条记录最多的参数个数
+#define DLOG_ARG_MAX    8U
+#define DLOG_SYNC       0xD1U
+#define DLOG_HEADER_LEN 12U
+
+#define DLOG_LEVEL_DEBUG   1U
+#define DLOG_LEVEL_INFO    2U
+#define DLOG_LEVEL_WARNING 3U
+#define DLOG_LEVEL_ERROR   4U
+
+// 格式字符串之后参数的个数，最多DLOG_ARG_MAX个
+#define DLOG_NARG(...)                                           DLOG_NARG_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+#define DLOG_NARG_(fmt, a1, a2, a3, a4, a5, a6, a7, a8, n, ...) n
+
+#if DLOG_ENABLE
+/*
+每个参数经过DLOG_ARG转换为uint32_t再传给dlog_write，dlog_write按uint32_t读取，参数宽度总是一致。
+(a) | 0U 让指针和浮点数编译报错，sizeof检查让64位整数编译报错(数组大小为负)。
+参数超过DLOG_ARG_MAX个时DLOG_NARG得不到个数，同样编译报错。
+*/
+#define DLOG_ARG(a)  ((uint32_t)((a) | 0U) + 0U * sizeof(char[sizeof(a) <= sizeof(uint32_t) ? 1 : -1]))
+// %s、%p的参数，记录32位地址
+#define DLOG_ADDR(p) ((uint32_t)(uintptr_t)(const void *)(p))
+
+#define DLOG_CALL(level, ...)        DLOG_CALL_(DLOG_NARG(__VA_ARGS__), level, __VA_ARGS__)
+#define DLOG_CALL_(n, level, ...)    DLOG_CALL__(n, level, __VA_ARGS__)
+#define DLOG_CALL__(n, level, ...)   DLOG_CALL_##n(level, __VA_ARGS__)
+#define DLOG_CALL_0(level, fmt)      dlog_write(level, 0, fmt)
+#define DLOG_CALL_1(level, fmt, a1)  dlog_write(level, 1, fmt, DLOG_ARG(a1))
+#define DLOG_CALL_2(level, fmt, a1, a2) \
+    dlog_write(level, 2, fmt, DLOG_ARG(a1), DLOG_ARG(a2))
+#define DLOG_CALL_3(level, fmt, a1, a2, a3) \
+    dlog_write(level, 3, fmt, DLOG_ARG(a1), DLOG_ARG(a2), DLOG_ARG(a3))
+#define DLOG_CALL_4(level, fmt, a1, a2, a3, a4) \
+    dlog_write(level, 4, fmt, DLOG_ARG(a1), DLOG_ARG(a2), DLOG_ARG(a3), DLOG_ARG(a4))
+#define DLOG_CALL_5(level, fmt, a1, a2, a3, a4, a5) \
+    dlog_write(level, 5, fmt, DLOG_ARG(a1), DLOG_ARG(a2), DLOG_ARG(a3), DLOG_ARG(a4), DLOG_ARG(a5))
+#define DLOG_CALL_6(level, fmt, a1, a2, a3, a4, a5, a6) \
+    dlog_write(level, 6, fmt, DLOG_ARG(a1), DLOG_ARG(a2), DLOG_ARG(a3), DLOG_ARG(a4), DLOG_ARG(a5), DLOG_ARG(a6))
+#define DLOG_CALL_7(level, fmt, a1, a2, a3, a4, a5, a6, a7)                                                    \
+    dlog_write(level, 7, fmt, DLOG_ARG(a1), DLOG_ARG(a2), DLOG_ARG(a3), DLOG_ARG(a4), DLOG_ARG(a5), DLOG_ARG(a6), \
+               DLOG_ARG(a7))
+#define DLOG_CALL_8(level, fmt, a1, a2, a3, a4, a5, a6, a7, a8)                                                \
+    dlog_write(level, 8, fmt, DLOG_ARG(a1), DLOG_ARG(a2), DLOG_ARG(a3), DLOG_ARG(a4), DLOG_ARG(a5), DLOG_ARG(a6), \
+               DLOG_ARG(a7), DLOG_ARG(a8))
+
+#define DLOG_DEBUG(...)   DLOG_CALL(DLOG_LEVEL_DEBUG, __VA_ARGS__)
+#define DLOG_INFO(...)    DLOG_CALL(DLOG_LEVEL_INFO, __VA_ARGS__)
+#define DLOG_WARNING(...) DLOG_CALL(DLOG_LEVEL_WARNING, __VA_ARGS__)
+#define DLOG_ERROR(...)   DLOG_CALL(DLOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define DLOG_ADDR(p)      (p)
+#define DLOG_DEBUG(...)   ULOG_DEBUG(__VA_ARGS__)
+#define DLOG_INFO(...)    ULOG_INFO(__VA_ARGS__)
+#define DLOG_WARNING(...) ULOG_WARNING(__VA_ARGS__)
+#define DLOG_ERROR(...)   ULOG_ERROR(__VA_ARGS__)
+#endif
+
+/**
+ * @brief 输出接口。
+ * @return uint32_t 实际接收的字节数，可以少于len，剩下的下次再输出。
+ */
+typedef uint32_t (*dlog_sink_t)(const uint8_t *buf, uint32_t len);
+
+typedef struct tagDLOG_Stat_t {
+    uint32_t written;     // 写入的记录数
+    uint32_t dropped;     // 缓冲区满丢弃的记录数
+    uint32_t drainBytes;  // 已经输出的字节数
+    uint32_t maxUsed;     // 缓冲区最大占用，字节
+} DLOG_Stat_t;
+
+void dlog_write(uint8_t level, uint32_t argc, const char *fmt, ...);
+void dlog_set_sink(dlog_sink_t sink);
+dlog_sink_t dlog_get_sink();
+void dlog_set_level(uint8_t level);
+uint32_t dlog_drain(uint32_t maxBytes);
+bool dlog_pending();
+void dlog_get_stat(DLOG_Stat_t *pStat);
+void dlog_stat_show();
+
+#endif // !DLOG_H
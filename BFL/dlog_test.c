@@ -0,0 +1,209 @@
+/**
+ * @file dlog_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 延迟日志测试：记录格式、输出接口每次只接收一部分、缓冲区满丢弃和seq跳变、等级过滤。
+ * 测试期间输出接口换成测试用的接口，结束后恢复。在目标板上运行时不要有其他地方同时写DLOG。
+ * 输出的字节流保存在dlog_test_capture中，可以交给tools/dlog_decode.py解析。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "dlog_test.h"
+
+#define DLOG_TEST_CAPTURE_MAX 8192U
+// 溢出测试写入的记录数，每条16字节，环形缓冲区只能放下DLOG_RING_SIZE/16条
+#define DLOG_TEST_BURST       200U
+
+static const char dlog_test_fmt_args[]  = "dlog test %u %d %c %s 0x%04X";
+static const char dlog_test_fmt_none[]  = "dlog test no args";
+static const char dlog_test_fmt_eight[] = "dlog test %u %u %u %u %u %u %u %u";
+static const char dlog_test_fmt_burst[] = "dlog burst %u";
+static const char dlog_test_fmt_level[] = "dlog filtered %u";
+static const char dlog_test_str[]       = "hello";
+
+static uint8_t dlog_test_buf[DLOG_TEST_CAPTURE_MAX];
+static uint32_t dlog_test_len   = 0;
+static uint32_t dlog_test_chunk = 0; // 输出接口每次最多接收的字节数
+static uint32_t dlog_test_over  = 0; // 单次输出超过dlog_test_chunk的次数
+static uint32_t dlog_test_error = 0;
+
+static void dlog_check(bool ok, const char *what)
+{
+    if (!ok) {
+        ULOG_INFO("[DLOG Test]: check failed: %s\r\n", what);
+        dlog_test_error++;
+    }
+}
+
+static uint32_t dlog_test_sink(const uint8_t *buf, uint32_t len)
+{
+    if (len > dlog_test_chunk) {
+        len = dlog_test_chunk;
+    }
+    if (len > DLOG_TEST_CAPTURE_MAX - dlog_test_len) {
+        dlog_test_over++;
+        len = DLOG_TEST_CAPTURE_MAX - dlog_test_len;
+    }
+    memcpy(&dlog_test_buf[dlog_test_len], buf, len);
+    dlog_test_len += len;
+    return len;
+}
+
+static uint32_t dlog_test_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 检查capture中from处的一条记录。
+ *
+ * @return uint32_t 记录长度，0表示不是合法的记录。
+ */
+static uint32_t dlog_test_record(uint32_t from, uint8_t level, uint8_t seq, const char *fmt, uint32_t argc,
+                                 const uint32_t *args)
+{
+    const uint8_t *p = &dlog_test_buf[from];
+    uint32_t len     = DLOG_HEADER_LEN + argc * 4;
+
+    if (from + len > dlog_test_len || p[0] != DLOG_SYNC || p[1] != argc || p[2] != level || p[3] != seq ||
+        dlog_test_u32(p + 4) != DLOG_ADDR(fmt)) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < argc; i++) {
+        if (dlog_test_u32(p + DLOG_HEADER_LEN + i * 4) != args[i]) {
+            return 0;
+        }
+    }
+    return len;
+}
+
+static void dlog_test_drain_all(uint32_t chunk)
+{
+    dlog_test_chunk = chunk;
+    while (dlog_pending() && dlog_drain(DLOG_RING_SIZE) > 0) {
+    }
+}
+
+/**
+ * @brief 延迟日志测试。
+ *
+ * @return uint32_t 错误数。
+ */
+uint32_t dlog_test()
+{
+    const uint32_t args[]  = {42, (uint32_t)-7, 'x', DLOG_ADDR(dlog_test_str), 0xBEEF};
+    const uint32_t eight[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    dlog_sink_t old_sink   = dlog_get_sink();
+    DLOG_Stat_t start      = {0};
+    DLOG_Stat_t stat       = {0};
+    uint32_t pos           = 0;
+    uint32_t n             = 0;
+    uint32_t fit           = 0;
+    uint8_t seq            = 0;
+    uint8_t u8             = 'x';
+    int16_t i16            = -7;
+
+    dlog_test_error = 0;
+    dlog_test_over  = 0;
+    // 先把缓冲区中已有的记录交给原来的输出接口
+    while (old_sink != NULL && dlog_pending() && dlog_drain(DLOG_RING_SIZE) > 0) {
+    }
+    dlog_set_sink(dlog_test_sink);
+    dlog_test_drain_all(DLOG_RING_SIZE);
+    dlog_test_len = 0;
+    dlog_get_stat(&start);
+
+    // 记录格式，参数有不同的宽度和符号
+    DLOG_INFO(dlog_test_fmt_args, 42U, i16, u8, DLOG_ADDR(dlog_test_str), (uint16_t)0xBEEF);
+    DLOG_DEBUG(dlog_test_fmt_none);
+    DLOG_ERROR(dlog_test_fmt_eight, 1, 2, 3, 4, 5, 6, 7, 8);
+    dlog_test_drain_all(DLOG_RING_SIZE);
+    seq = dlog_test_buf[3];
+    n   = dlog_test_record(pos, DLOG_LEVEL_INFO, seq, dlog_test_fmt_args, 5, args);
+    dlog_check(n == DLOG_HEADER_LEN + 20, "record with mixed args");
+    pos += n;
+    n = dlog_test_record(pos, DLOG_LEVEL_DEBUG, seq + 1, dlog_test_fmt_none, 0, NULL);
+    dlog_check(n == DLOG_HEADER_LEN, "record without args");
+    pos += n;
+    n = dlog_test_record(pos, DLOG_LEVEL_ERROR, seq + 2, dlog_test_fmt_eight, 8, eight);
+    dlog_check(n == DLOG_HEADER_LEN + 32, "record with eight args");
+    pos += n;
+    dlog_check(pos == dlog_test_len, "no extra bytes");
+
+    // 低于等级的记录不写入，也不占用seq
+    dlog_set_level(DLOG_LEVEL_WARNING);
+    DLOG_INFO(dlog_test_fmt_level, 1);
+    dlog_set_level(DLOG_LEVEL_DEBUG);
+    dlog_check(!dlog_pending(), "filtered record written");
+
+    // 输出接口每次只接收5字节，并且一次最多输出7字节
+    for (uint32_t i = 0; i < 20; i++) {
+        DLOG_INFO(dlog_test_fmt_burst, i);
+    }
+    dlog_test_chunk = 0;
+    dlog_check(dlog_drain(DLOG_RING_SIZE) == 0 && dlog_pending(), "sink refusing all bytes");
+    dlog_test_chunk = 5;
+    while (dlog_pending()) {
+        n = dlog_drain(7);
+        dlog_check(n > 0 && n <= 7, "drain limited by maxBytes");
+        if (n == 0) {
+            break;
+        }
+    }
+    for (uint32_t i = 0; i < 20; i++) {
+        n = dlog_test_record(pos, DLOG_LEVEL_INFO, (uint8_t)(seq + 3 + i), dlog_test_fmt_burst, 1, &i);
+        dlog_check(n == DLOG_HEADER_LEN + 4, "record after partial sink writes");
+        pos += n;
+    }
+    dlog_check(pos == dlog_test_len, "no extra bytes after partial sink writes");
+
+    // 不输出时写满缓冲区，写不下的记录丢弃但是占用seq
+    fit = DLOG_RING_SIZE / (DLOG_HEADER_LEN + 4);
+    for (uint32_t i = 0; i < DLOG_TEST_BURST; i++) {
+        DLOG_INFO(dlog_test_fmt_burst, 100 + i);
+    }
+    dlog_get_stat(&stat);
+    dlog_check(stat.dropped - start.dropped == DLOG_TEST_BURST - fit, "dropped count");
+    dlog_check(stat.maxUsed == DLOG_RING_SIZE, "ring full");
+    dlog_test_drain_all(64);
+    for (uint32_t i = 0; i < fit; i++) {
+        uint32_t v = 100 + i;
+        n = dlog_test_record(pos, DLOG_LEVEL_INFO, (uint8_t)(seq + 23 + i), dlog_test_fmt_burst, 1, &v);
+        dlog_check(n == DLOG_HEADER_LEN + 4, "record before overflow");
+        pos += n;
+    }
+    // 丢弃之后的第一条记录，seq跳过了丢弃的记录
+    DLOG_WARNING(dlog_test_fmt_burst, 999);
+    dlog_test_drain_all(DLOG_RING_SIZE);
+    n = 999;
+    n = dlog_test_record(pos, DLOG_LEVEL_WARNING, (uint8_t)(seq + 23 + DLOG_TEST_BURST), dlog_test_fmt_burst, 1, &n);
+    dlog_check(n == DLOG_HEADER_LEN + 4, "seq after overflow");
+    pos += n;
+    dlog_check(pos == dlog_test_len, "no extra bytes after overflow");
+    dlog_check(dlog_test_over == 0, "capture buffer overflow");
+
+    dlog_get_stat(&stat);
+    dlog_check(stat.written - start.written == 3 + 20 + fit + 1, "written count");
+    dlog_check(stat.drainBytes - start.drainBytes == dlog_test_len, "drain bytes");
+
+    dlog_set_sink(old_sink);
+    ULOG_INFO("[DLOG Test]: %u bytes, %u records dropped\r\n", dlog_test_len, stat.dropped - start.dropped);
+    ULOG_INFO("[DLOG Test] %s\r\n", dlog_test_error == 0 ? "pass" : "fail");
+    return dlog_test_error;
+}
+
+/**
+ * @brief 测试输出的字节流，可以交给tools/dlog_decode.py解析。
+ *
+ * @param pLen
+ * @return const uint8_t*
+ */
+const uint8_t *dlog_test_capture(uint32_t *pLen)
+{
+    *pLen = dlog_test_len;
+    return dlog_test_buf;
+}
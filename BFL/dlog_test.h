@@ -0,0 +1,19 @@
+/**
+ * @file dlog_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef DLOG_TEST_H
+#define DLOG_TEST_H
+#include <stdint.h>
+#include "dlog.h"
+
+uint32_t dlog_test();
+const uint8_t *dlog_test_capture(uint32_t *pLen);
+#endif // !DLOG_TEST_H
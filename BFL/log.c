@@ -4,6 +4,8 @@
 #include "HDL_RTC.h"
 #include "datetime.h"
 #include "HDL_Uart.h"
+#include "usbd_cdc_if.h"
+#include "CHIP_W25Q512_LogPartition.h"
 #include <stdio.h>
 
 // #undef FREE_RTOS
@@ -77,6 +79,161 @@ void my_console_logger(ulog_level_t severity, char *msg)
 #endif // ULOG_ENABLED
 }
 
+#if LOG_FLASH_ENABLE
+/**
+ * @brief 把文本日志写入Flash日志分区，格式和调试口输出的一样。
+ *
+ * @param severity
+ * @param msg
+ */
+void my_flash_logger(ulog_level_t severity, char *msg)
+{
+    char line[MAXDEBUGSEND];
+    int len = 0;
+    mtime_t mtime;
+    datetime_get_localtime(&mtime);
+
+    len = snprintf(line, sizeof(line), ">%04d.%02d.%02d %02d:%02d:%02d  [%s]: %s\r\n",
+                   mtime.nYear, mtime.nMonth, mtime.nDay, mtime.nHour, mtime.nMin, mtime.nSec,
+                   ulog_level_name(severity),
+                   msg);
+    if (len > (int)sizeof(line) - 1) {
+        len = sizeof(line) - 1;
+    }
+    if (len > 0) {
+        CHIP_W25Q512_LOG_append(CHIP_W25Q512_LOG_TYPE_TEXT, line, len);
+    }
+}
+#endif // LOG_FLASH_ENABLE
+
+/**
+ * @brief 延迟日志的输出接口，和文本日志使用同一个调试口。
+ *
+ * @param buf
+ * @param len
+ * @return uint32_t 实际接收的字节数。
+ */
+static uint32_t dlog_console_sink(const uint8_t *buf, uint32_t len)
+{
+#if USING_RTT == 1
+    len = SEGGER_RTT_Write(0, buf, len);
+#elif USING_USB_CDC == 1
+    len = CDC_Transmit_FS((uint8_t *)buf, len) == USBD_OK ? len : 0;
+#elif USING_UART == 1
+    len = Uart_Write(DEBUG_COM, buf, len);
+#endif
+#if LOG_FLASH_ENABLE
+    // 调试口接收的部分同时写入Flash日志分区，分段写入不影响上位机按字节流解析
+    for (uint32_t off = 0; off < len; off += CHIP_W25Q512_LOG_RECORD_MAX) {
+        CHIP_W25Q512_LOG_append(CHIP_W25Q512_LOG_TYPE_DLOG, buf + off,
+                                len - off < CHIP_W25Q512_LOG_RECORD_MAX ? len - off : CHIP_W25Q512_LOG_RECORD_MAX);
+    }
+#endif
+    return len;
+}
+
+/**
+ * @brief 通过USB CDC输出，可以作为dlog_sink_t使用。
+ * CDC_Transmit_FS不复制数据，上一包发送完成之前buf不能修改。
+ *
+ * @param buf
+ * @param len 不超过65535。
+ * @return uint32_t USB忙时返回0。
+ */
+uint32_t log_cdc_write(const uint8_t *buf, uint32_t len)
+{
+    return CDC_Transmit_FS((uint8_t *)buf, (uint16_t)len) == USBD_OK ? len : 0;
+}
+
+#if LOG_FLASH_ENABLE
+#define LOG_FLASH_DUMP_WAIT_MS 100U
+// 读出Flash日志的状态，两个记录缓冲区轮流使用，输出接口可以异步发送上一个缓冲区
+static struct {
+    volatile uint32_t request; // 请求读出的记录条数，0表示没有请求
+    dlog_sink_t requestSink;
+    uint32_t requestTick;      // 开始等待缓冲区写入Flash的时刻，0表示没有等待
+    dlog_sink_t sink;
+    W25Q512_LogCursor_t cursor;
+    uint32_t left;             // 还要读出的记录条数
+    uint8_t buf[2][CHIP_W25Q512_LOG_RECORD_MAX];
+    uint8_t idx;               // 正在输出的缓冲区
+    uint32_t len;              // 正在输出的记录长度
+    uint32_t sent;             // 正在输出的记录已经输出的字节数
+} log_dump;
+
+/**
+ * @brief 加载Flash日志分区并订阅文本日志，在ulog_init_user之后调用。
+ *
+ */
+void log_flash_init()
+{
+    if (CHIP_W25Q512_LOG_init() == 0) {
+        ULOG_SUBSCRIBE(my_flash_logger, ULOG_INFO_LEVEL);
+    }
+}
+
+/**
+ * @brief 请求把最近n条Flash日志输出到sink，实际输出在log_flash_handler中进行，可以在中断中调用。
+ * 正在输出时再次请求会从新的位置重新开始。
+ *
+ * @param n 记录条数。
+ * @param sink 输出接口，例如log_cdc_write或者对BFL_4G_TCP_Write的封装。
+ */
+void log_flash_dump(uint32_t n, dlog_sink_t sink)
+{
+    log_dump.requestSink = sink;
+    log_dump.request     = n;
+}
+
+bool log_flash_dumping()
+{
+    return log_dump.request != 0 || log_dump.left != 0;
+}
+
+/**
+ * @brief Flash日志处理器，在主循环中调用：把缓冲区中的日志批量写入Flash，输出请求的历史日志。
+ *
+ */
+void log_flash_handler()
+{
+    int32_t len = 0;
+
+    CHIP_W25Q512_LOG_handler();
+
+    if (log_dump.request != 0) {
+        // 先把缓冲区中的日志写入Flash，读出的日志包括请求之前的最后一条。日志一直在产生时最多等待LOG_FLASH_DUMP_WAIT_MS
+        if (log_dump.requestTick == 0) {
+            log_dump.requestTick = HDL_CPU_Time_GetTick() | 1;
+        }
+        CHIP_W25Q512_LOG_flush();
+        if (!CHIP_W25Q512_LOG_is_idle() && HDL_CPU_Time_GetTick() - log_dump.requestTick < LOG_FLASH_DUMP_WAIT_MS) {
+            return;
+        }
+        log_dump.requestTick = 0;
+        log_dump.sink    = log_dump.requestSink;
+        log_dump.left    = CHIP_W25Q512_LOG_seek_tail(&log_dump.cursor, log_dump.request);
+        log_dump.request = 0;
+        log_dump.len     = 0;
+        log_dump.sent    = 0;
+    }
+
+    // 每次最多输出一条记录，不长时间占用主循环
+    if (log_dump.sent < log_dump.len) {
+        log_dump.sent += log_dump.sink(&log_dump.buf[log_dump.idx][log_dump.sent], log_dump.len - log_dump.sent);
+    } else if (log_dump.left != 0 && !CHIP_W25Q512_LOG_flash_busy()) {
+        log_dump.idx ^= 1;
+        len = CHIP_W25Q512_LOG_read_next(&log_dump.cursor, NULL, log_dump.buf[log_dump.idx], CHIP_W25Q512_LOG_RECORD_MAX);
+        if (len <= 0) {
+            log_dump.left = 0;
+            return;
+        }
+        log_dump.left--;
+        log_dump.len  = len;
+        log_dump.sent = log_dump.sink(log_dump.buf[log_dump.idx], len);
+    }
+}
+#endif // LOG_FLASH_ENABLE
+
 void ulog_init_user()
 {
     ULOG_INIT();
@@ -93,4 +250,5 @@ void ulog_init_user()
 #endif
     // dynamically change the threshold for a specific logger
     ULOG_SUBSCRIBE(my_console_logger, ULOG_DEBUG_LEVEL);
+    dlog_set_sink(dlog_console_sink);
 }
\ No newline at end of file
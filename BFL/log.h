@@ -13,10 +13,15 @@
 #define LOG_H
 
 #include "ulog.h"
+#include "dlog.h"
 
 #define USING_RTT     0
 #define USING_USB_CDC 0
 #define USING_UART    1
+// 文本日志和延迟日志同时写入W25Q512的日志分区，见CHIP_W25Q512_LogPartition.h
+#ifndef LOG_FLASH_ENABLE
+#define LOG_FLASH_ENABLE 1
+#endif
 #if USING_RTT == 1
 #include "SEGGER_RTT.h"
 #elif USING_USB_CDC == 1
@@ -70,5 +75,30 @@
 
 void ulog_init_user();
 void Debug_Printf(const void *format, ...);
+uint32_t log_cdc_write(const uint8_t *buf, uint32_t len);
+
+#if LOG_FLASH_ENABLE
+void log_flash_init();
+void log_flash_handler();
+void log_flash_dump(uint32_t n, dlog_sink_t sink);
+bool log_flash_dumping();
+#endif
+
+/*************************Document****************************/
+/*
+
+// 通过4G连接读出最近200条Flash日志
+static uint32_t log_4g_sink(const uint8_t *buf, uint32_t len)
+{
+    return BFL_4G_TCP_Writeable(SOCKET0) ? BFL_4G_TCP_Write(SOCKET0, (uint8_t *)buf, len) : 0;
+}
+
+log_flash_dump(200, log_4g_sink);
+while (log_flash_dumping()) {
+    log_flash_handler();
+    //...some other handler
+}
+ */
+/*************************Document End************************/
 
 #endif //! LOG_H
\ No newline at end of file
@@ -44,7 +44,11 @@ uint32_t getCPUMsTick()
 
 uint32_t getCPUTick()
 {
+#ifdef SCHEDULER_SIMULATION
+    return scheduler_sim_tick;
+#else
     return HDL_CPU_Time_GetTick();
+#endif
 }
 
 float getCPUOneTickTime()
@@ -61,6 +65,11 @@ static struct sc_list _gSchedulerList = {NULL, NULL};
 static struct sc_list *gSchedulerList = &_gSchedulerList;
 static float oen_tick_time            = 1; // ms
 
+// 按_due_tick排序的最小堆，堆顶是最早到期的任务
+static SchedulerTask_t *gSchedulerHeap[SCHEDULER_TASK_MAX_NUM];
+static uint32_t gSchedulerHeapSize = 0;
+static uint32_t gSchedulerTaskNum  = 0; // 注册的任务数，不超过堆的容量
+
 /*
 这个调度器原理：
 如果exe_cnt < exe_times
@@ -73,6 +82,11 @@ static float oen_tick_time            = 1; // ms
     第一次初始化那么last_exe_tick为0，如果cpu已经运行超过一秒(或者tick溢出后超过1s)
     复用之前注册过的task，且距离上次取消注册超过一秒(或者tick溢出后超过1s)
 那么到scheduler_handler中处理相应的task时会马上就执行一次。
+
+实现上任务在注册、执行完或者修改周期时算出下一次到期的时刻_due_tick，放入最小堆，
+scheduler_handler只需要看堆顶，取出到期的任务执行，执行完再按新的last_exe_tick放回堆中。
+执行次数用完的任务不在堆中，只留在注册链表里，scheduler_reset_exe_cnt后重新放回堆中。
+tick比较都用差值的符号判断，tick溢出后仍然正确。
 */
 
 void Functional_execute(Functional_t *functional)
@@ -82,6 +96,117 @@ void Functional_execute(Functional_t *functional)
     }
 }
 
+#define SCHEDULER_TICK_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+
+/**
+ * @brief 计算任务下一次到期的时刻：注册延时已过，并且距离上一次执行至少period。
+ *
+ * @param task
+ * @param now 当前tick。
+ * @return uint32_t
+ */
+static uint32_t scheduler_task_due_tick(SchedulerTask_t *task, uint32_t now)
+{
+    uint32_t wait    = 0;
+    uint32_t elapsed = now - task->register_tick;
+
+    if (elapsed < task->delay_before_first_exe) {
+        wait = task->delay_before_first_exe - elapsed;
+    }
+    elapsed = now - task->last_exe_tick;
+    if (elapsed < task->period && task->period - elapsed > wait) {
+        wait = task->period - elapsed;
+    }
+    return now + wait;
+}
+
+static void scheduler_heap_set(uint32_t pos, SchedulerTask_t *task)
+{
+    gSchedulerHeap[pos] = task;
+    task->_heap_pos     = pos + 1;
+}
+
+static void scheduler_heap_sift_up(uint32_t pos)
+{
+    SchedulerTask_t *task = gSchedulerHeap[pos];
+    uint32_t parent       = 0;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (!SCHEDULER_TICK_BEFORE(task->_due_tick, gSchedulerHeap[parent]->_due_tick)) {
+            break;
+        }
+        scheduler_heap_set(pos, gSchedulerHeap[parent]);
+        pos = parent;
+    }
+    scheduler_heap_set(pos, task);
+}
+
+static void scheduler_heap_sift_down(uint32_t pos)
+{
+    SchedulerTask_t *task = gSchedulerHeap[pos];
+    uint32_t child        = 0;
+
+    while ((child = pos * 2 + 1) < gSchedulerHeapSize) {
+        if (child + 1 < gSchedulerHeapSize &&
+            SCHEDULER_TICK_BEFORE(gSchedulerHeap[child + 1]->_due_tick, gSchedulerHeap[child]->_due_tick)) {
+            child++;
+        }
+        if (!SCHEDULER_TICK_BEFORE(gSchedulerHeap[child]->_due_tick, task->_due_tick)) {
+            break;
+        }
+        scheduler_heap_set(pos, gSchedulerHeap[child]);
+        pos = child;
+    }
+    scheduler_heap_set(pos, task);
+}
+
+static bool scheduler_heap_push(SchedulerTask_t *task)
+{
+    if (gSchedulerHeapSize >= SCHEDULER_TASK_MAX_NUM) {
+        return false;
+    }
+    gSchedulerHeap[gSchedulerHeapSize] = task;
+    scheduler_heap_sift_up(gSchedulerHeapSize++);
+    return true;
+}
+
+static void scheduler_heap_remove(SchedulerTask_t *task)
+{
+    uint32_t pos          = task->_heap_pos - 1;
+    SchedulerTask_t *last = NULL;
+
+    task->_heap_pos = 0;
+    last            = gSchedulerHeap[--gSchedulerHeapSize];
+    if (pos == gSchedulerHeapSize) {
+        return;
+    }
+    gSchedulerHeap[pos] = last;
+    if (pos > 0 && SCHEDULER_TICK_BEFORE(last->_due_tick, gSchedulerHeap[(pos - 1) / 2]->_due_tick)) {
+        scheduler_heap_sift_up(pos);
+    } else {
+        scheduler_heap_sift_down(pos);
+    }
+}
+
+/**
+ * @brief 按当前的last_exe_tick、period重新计算任务的到期时刻并调整在堆中的位置，
+ * 执行次数用完的任务移出堆。
+ *
+ * @param task
+ * @param now
+ */
+static void scheduler_task_reschedule(SchedulerTask_t *task, uint32_t now)
+{
+    if (task->_heap_pos != 0) {
+        scheduler_heap_remove(task);
+    }
+    if (task->_exe_cnt < task->exe_times) {
+        task->_due_tick = scheduler_task_due_tick(task, now);
+        scheduler_heap_push(task);
+    }
+}
+
 /**
  * @brief Scheduler初始化。
  *
@@ -89,58 +214,126 @@ void Functional_execute(Functional_t *functional)
 void scheduler_init()
 {
     sc_list_init(gSchedulerList);
-    oen_tick_time = getCPUOneTickTime();
+    gSchedulerHeapSize = 0;
+    gSchedulerTaskNum  = 0;
+    oen_tick_time      = getCPUOneTickTime();
 }
 
 /**
  * @brief scheduler处理器。
  * 只有保证scheduler_handler执行频率大于scheduler计时器的计时分辨率的频率才能保证时间相对准确的定时任务调度。
+ * 每次调用只处理堆顶到期的任务，每个任务最多执行一次。
  */
 void scheduler_handler()
 {
-    struct sc_list *it    = NULL;
     SchedulerTask_t *task = NULL;
+    uint32_t now          = getCPUTick();
+#if TASK_PROFILE_ENABLE
+    uint32_t late_tick = 0;
+    uint32_t start_us  = 0;
+    uint32_t exe_us    = 0;
+#endif
 
-    sc_list_foreach(gSchedulerList, it)
-    {
-        task = sc_list_entry(it, SchedulerTask_t, next);
-        if (getCPUTick() >= (task->register_tick + task->delay_before_first_exe)) {
-            if (task->_exe_cnt < task->exe_times) {
-                // 这里一定是>=，如果是 > ，那么在1 cpu tick间隔的时候时间上是2cpu tick执行一次。
-                // 这里不允许period为0，不然就会失去调度作用。
-                // 这里需要保证一定的实时性
-                if ((getCPUTick() - task->last_exe_tick) >= task->period) {
-
-                    Functional_execute(&task->fun);
-                    task->_elapsed_tick_since_last_exe = getCPUTick() - task->last_exe_tick;
-                    task->_exe_tick_error              = task->_elapsed_tick_since_last_exe - task->period;
-                    if (task->_exe_tick_error > 0) {
-                        task->last_exe_tick = getCPUTick();
-                    } else {
-                        task->last_exe_tick += task->period;
-                    }
-                    task->_exe_cnt++;
-                    task->_exe_cnt = task->_exe_cnt == SCHEDULER_EXE_TIMES_INF ? 0 : task->_exe_cnt;
-                }
-            }
+    // 任务执行完后新的到期时刻一定晚于now(period>0)，所以同一次调用里不会重复执行同一个任务
+    while (gSchedulerHeapSize > 0 && !SCHEDULER_TICK_BEFORE(now, gSchedulerHeap[0]->_due_tick)) {
+        task = gSchedulerHeap[0];
+        scheduler_heap_remove(task);
+
+#if TASK_PROFILE_ENABLE
+        late_tick = getCPUTick() - task->_due_tick;
+        start_us  = HDL_CPU_Time_GetUsTick();
+        Functional_execute(&task->fun);
+        exe_us = HDL_CPU_Time_GetUsTick() - start_us;
+        task_profile_exe_time(&task->profile, exe_us);
+        task_profile_release(&task->profile, late_tick, exe_us, task->period);
+#else
+        Functional_execute(&task->fun);
+#endif
+        task->_elapsed_tick_since_last_exe = getCPUTick() - task->last_exe_tick;
+        task->_exe_tick_error              = task->_elapsed_tick_since_last_exe - task->period;
+        if (task->_exe_tick_error > 0) {
+            task->last_exe_tick = getCPUTick();
+        } else {
+            task->last_exe_tick += task->period;
+        }
+        task->_exe_cnt++;
+        task->_exe_cnt = task->_exe_cnt == SCHEDULER_EXE_TIMES_INF ? 0 : task->_exe_cnt;
+
+        // 任务在执行过程中可能取消注册了自己
+        if (!sc_list_is_empty(&task->next)) {
+            scheduler_task_reschedule(task, getCPUTick());
+        }
+    }
+}
+
+/**
+ * @brief 距离最早到期的任务还有多少tick，主循环可以据此低功耗空闲。
+ *
+ * @return uint32_t 0表示有任务已经到期，没有需要执行的任务时返回UINT32_MAX。
+ */
+uint32_t scheduler_next_deadline()
+{
+    uint32_t now = getCPUTick();
+
+    if (gSchedulerHeapSize == 0) {
+        return UINT32_MAX;
+    }
+    if (!SCHEDULER_TICK_BEFORE(now, gSchedulerHeap[0]->_due_tick)) {
+        return 0;
+    }
+    return gSchedulerHeap[0]->_due_tick - now;
+}
+
+/**
+ * @brief 检查最小堆：每个父节点不晚于子节点到期，_heap_pos与所在位置一致，
+ * 堆里的任务都是注册的且执行次数没用完。用于测试。
+ *
+ * @return true 堆正确，false 堆被破坏。
+ */
+bool scheduler_heap_check()
+{
+    SchedulerTask_t *task = NULL;
+
+    if (gSchedulerHeapSize > gSchedulerTaskNum) {
+        return false;
+    }
+    for (uint32_t pos = 0; pos < gSchedulerHeapSize; pos++) {
+        task = gSchedulerHeap[pos];
+        if (task->_heap_pos != pos + 1 || task->_exe_cnt >= task->exe_times || sc_list_is_empty(&task->next)) {
+            return false;
+        }
+        if (pos > 0 && SCHEDULER_TICK_BEFORE(task->_due_tick, gSchedulerHeap[(pos - 1) / 2]->_due_tick)) {
+            return false;
         }
     }
+    return true;
 }
 
 /**
  * @brief 将任务节点注册到scheduler中。
  * @note 这个函数会避免period为0的情况，如果period为0，那么period会变为1。
  * @param sche_node
- * @retval true 注册成功，false 注册失败。
+ * @retval true 注册成功，false 注册失败(已注册SCHEDULER_TASK_MAX_NUM个任务)。
  */
 bool scheduler_register(SchedulerTask_t *task)
 {
     bool ret = false;
     if (task != NULL) {
+        if (scheduler_is_task_registered(task)) {
+            // 重复注册只重新开始计时
+            sc_list_del(gSchedulerList, &task->next);
+            gSchedulerTaskNum--;
+        } else if (gSchedulerTaskNum >= SCHEDULER_TASK_MAX_NUM) {
+            return false;
+        } else {
+            task->_heap_pos = 0;
+        }
+        gSchedulerTaskNum++;
         task->register_tick = getCPUTick();
         task->period        = task->period == 0 ? 1 : task->period;
         sc_list_init(&task->next);
         sc_list_add_tail(gSchedulerList, &task->next);
+        scheduler_task_reschedule(task, task->register_tick);
         ret = true;
     }
     return ret;
@@ -195,6 +388,10 @@ bool scheduler_unregister(SchedulerTask_t *task)
                 task->_exe_cnt = 0;
 
                 sc_list_del(gSchedulerList, &_task->next);
+                gSchedulerTaskNum--;
+                if (task->_heap_pos != 0) {
+                    scheduler_heap_remove(task);
+                }
                 ret = true;
                 break;
             }
@@ -212,12 +409,16 @@ void scheduler_reset_exe_cnt(SchedulerTask_t *task)
 {
     if (task != NULL) {
         task->_exe_cnt = 0;
+        // 执行次数用完的任务已经移出了堆，需要重新放回去
+        if (task->_heap_pos == 0 && scheduler_is_task_registered(task)) {
+            scheduler_task_reschedule(task, getCPUTick());
+        }
     }
 }
 
 /**
  * @brief 设置任务节点的频率。
- *
+ * @note 频率超过1000Hz时period会变为1。
  * @param task
  * @param freq 1-1000Hz
  * @return None
@@ -226,8 +427,49 @@ void scheduler_set_freq(SchedulerTask_t *task, int freq)
 {
     if (task != NULL) {
         task->period = 1000.0f / freq / oen_tick_time;
+        task->period = task->period == 0 ? 1 : task->period;
+        if (task->_heap_pos != 0) {
+            scheduler_task_reschedule(task, getCPUTick());
+        }
+    }
+}
+
+#if TASK_PROFILE_ENABLE
+/**
+ * @brief 按总执行时间从大到小打印注册的任务的执行时间统计。
+ *
+ * @param top_n 打印前多少个任务，最多TASK_PROFILE_TOP_MAX个。
+ */
+void scheduler_profile_dump(uint32_t top_n)
+{
+    TaskProfileTop_t top[TASK_PROFILE_TOP_MAX];
+    uint32_t num          = 0;
+    struct sc_list *it    = NULL;
+    SchedulerTask_t *task = NULL;
+
+    top_n = top_n > TASK_PROFILE_TOP_MAX ? TASK_PROFILE_TOP_MAX : top_n;
+    sc_list_foreach(gSchedulerList, it)
+    {
+        task = sc_list_entry(it, SchedulerTask_t, next);
+        task_profile_top_insert(top, &num, top_n, &task->profile, NULL, task);
+    }
+    task_profile_top_show(top, num, "Scheduler");
+}
+
+/**
+ * @brief 清空所有注册的任务的执行时间统计。
+ *
+ */
+void scheduler_profile_reset()
+{
+    struct sc_list *it = NULL;
+
+    sc_list_foreach(gSchedulerList, it)
+    {
+        task_profile_reset(&sc_list_entry(it, SchedulerTask_t, next)->profile);
     }
 }
+#endif
 
 /**
  * @brief 获取指定时间对应的tick数量。
@@ -16,6 +16,7 @@
 #include <stdbool.h>
 #include <limits.h>
 #include "sc_list.h"
+#include "task_profile.h"
 
 typedef void (*Function_t)(void *arg);
 
@@ -26,6 +27,16 @@ typedef struct tagFunctional {
 
 #define SCHEDULER_EXE_TIMES_INF UINT_MAX
 
+#ifdef SCHEDULER_SIMULATION
+// 上位机仿真时使用虚拟时钟，由仿真程序推进
+extern uint32_t scheduler_sim_tick;
+#endif
+
+// 最多同时注册的任务数，即按到期时刻排序的最小堆的容量
+#ifndef SCHEDULER_TASK_MAX_NUM
+#define SCHEDULER_TASK_MAX_NUM 64
+#endif
+
 typedef struct tagSchedulerTask {
     /*上一次执行的CPU时间戳：每次执行的时候或者第一次启动任务的时候更新。
     当当前CPU tick >= last_exe_tick+exe_times时执行，之后更新last_exe_tick。
@@ -41,6 +52,11 @@ typedef struct tagSchedulerTask {
 
     int32_t _exe_tick_error;               // 执行时刻误差
     uint32_t _elapsed_tick_since_last_exe; // 距离上传执行逝去了多少事件
+    uint32_t _due_tick;                    // 下一次到期的时刻，最小堆的键值
+    uint32_t _heap_pos;                    // 在最小堆中的位置+1，0表示不在堆中
+#if TASK_PROFILE_ENABLE
+    TaskProfile_t profile; // 执行时间统计
+#endif
 } SchedulerTask_t;
 
 /**
@@ -52,14 +68,29 @@ void scheduler_init();
 /**
  * @brief scheduler处理器。
  * 只有保证scheduler_handler执行频率大于scheduler计时器的计时分辨率的频率才能保证时间相对准确的定时任务调度。
+ * 任务按下一次到期的时刻放在最小堆中，每次调用只处理到期的任务，开销与注册的任务总数无关。
  */
 void scheduler_handler();
 
+/**
+ * @brief 距离最早到期的任务还有多少tick，主循环可以据此低功耗空闲。
+ *
+ * @return uint32_t 0表示有任务已经到期，没有需要执行的任务时返回UINT32_MAX。
+ */
+uint32_t scheduler_next_deadline();
+
+/**
+ * @brief 检查最小堆的顺序和_heap_pos是否一致，用于测试。
+ *
+ * @return true 堆正确，false 堆被破坏。
+ */
+bool scheduler_heap_check();
+
 /**
  * @brief 将任务节点注册到scheduler中。
  *
  * @param sche_node
- * @retval true 注册成功，false 注册失败。
+ * @retval true 注册成功，false 注册失败(已注册SCHEDULER_TASK_MAX_NUM个任务)。
  */
 bool scheduler_register(SchedulerTask_t *task);
 
@@ -103,6 +134,21 @@ void scheduler_set_freq(SchedulerTask_t *task, int freq);
  */
 uint32_t scheduler_get_ms_ticks(uint32_t ms);
 
+#if TASK_PROFILE_ENABLE
+/**
+ * @brief 按总执行时间从大到小打印注册的任务的执行时间统计。
+ *
+ * @param top_n 打印前多少个任务，最多TASK_PROFILE_TOP_MAX个。
+ */
+void scheduler_profile_dump(uint32_t top_n);
+
+/**
+ * @brief 清空所有注册的任务的执行时间统计。
+ *
+ */
+void scheduler_profile_reset();
+#endif
+
 typedef uint32_t PeriodREC_t;
 #define MAX_PERIOD_ID 10 // 最大的周期ID号，从0开始计数。
 
@@ -9,9 +9,14 @@
  *
  */
 
+#include <stdio.h>
+#include <string.h>
 #include "scheduler_test.h"
-#include "test_lib.h"
+#include "test.h"
 #include "mtime.h"
+#if TASK_PROFILE_ENABLE
+#include "task_profile_test.h"
+#endif
 
 /*
 task1会执行十次fun1,1000ms执行一次
@@ -36,6 +41,14 @@ if (i % 1000 == 0)
 [Scheduler Test]: fun3:exe times: 2000
 [Scheduler Test]: fun3:exe times: 3000
 */
+#ifdef SCHEDULER_SIMULATION
+// 编译时定义SCHEDULER_SIMULATION，scheduler使用虚拟时钟scheduler_sim_tick，测试结果和主机负载无关
+uint32_t scheduler_sim_tick = 0;
+#define scheduler_test_get_tick() scheduler_sim_tick
+#else
+#define scheduler_test_get_tick() HDL_CPU_Time_GetTick()
+#endif
+
 SchedulerTask_t *gTask = NULL;
 void fun1()
 {
@@ -114,4 +127,361 @@ void period_test()
             fun1();
         }
     }
-}
\ No newline at end of file
+}
+
+/*
+scheduler_benchmark_test分别注册10、100、1000个周期1s的任务，到期时刻均匀分布，
+用test_LoopFrequencyTest_handler测量只调用scheduler_handler的循环频率。
+线性扫描的实现循环频率随任务数成反比下降，最小堆的实现只和每个tick到期的任务数有关。
+1000个任务需要SCHEDULER_TASK_MAX_NUM不小于1000，一般在上位机上编译时定义。
+*/
+#define SCHEDULER_BENCHMARK_TASK_MAX 1000
+
+static uint32_t bench_exe_cnt = 0;
+static void bench_fun(void *arg)
+{
+    (void)arg;
+    bench_exe_cnt++;
+}
+
+/**
+ * @brief 测量注册了task_num个任务时主循环的频率。
+ *
+ * @param tasks
+ * @param task_num
+ */
+static void scheduler_benchmark(SchedulerTask_t *tasks, uint32_t task_num)
+{
+    char prefix[32];
+    LoopFrequencyTest_t loop_frq_test = {
+        .measure_time = 1000,
+    };
+
+    if (task_num > SCHEDULER_TASK_MAX_NUM) {
+        ULOG_INFO("[Scheduler Benchmark]: %u tasks skipped, SCHEDULER_TASK_MAX_NUM=%u\r\n", task_num, SCHEDULER_TASK_MAX_NUM);
+        return;
+    }
+
+#ifdef SCHEDULER_SIMULATION
+    // 测的是真实的循环频率，虚拟时钟跟随CPU时钟
+    scheduler_sim_tick = HDL_CPU_Time_GetTick();
+#endif
+    scheduler_init();
+    bench_exe_cnt = 0;
+    for (uint32_t i = 0; i < task_num; i++) {
+        memset(&tasks[i], 0, sizeof(SchedulerTask_t));
+        tasks[i].exe_times     = SCHEDULER_EXE_TIMES_INF;
+        tasks[i].period        = scheduler_get_ms_ticks(1000);
+        tasks[i].fun.fun       = bench_fun;
+        tasks[i].last_exe_tick = scheduler_test_get_tick() - tasks[i].period + i * tasks[i].period / task_num;
+        scheduler_register(&tasks[i]);
+    }
+
+    while (!test_LoopFrequencyTest_readable(&loop_frq_test)) {
+#ifdef SCHEDULER_SIMULATION
+        scheduler_sim_tick = HDL_CPU_Time_GetTick();
+#endif
+        scheduler_handler();
+        test_LoopFrequencyTest_handler(&loop_frq_test);
+    }
+    snprintf(prefix, sizeof(prefix), "%u tasks, %u exe", task_num, bench_exe_cnt);
+    test_LoopFrequencyTest_show(&loop_frq_test, prefix);
+
+    for (uint32_t i = 0; i < task_num; i++) {
+        scheduler_unregister(&tasks[i]);
+    }
+}
+
+/**
+ * @brief Scheduler调度器在不同任务数下的主循环频率测试。
+ *
+ */
+void scheduler_benchmark_test()
+{
+    static SchedulerTask_t tasks[SCHEDULER_BENCHMARK_TASK_MAX];
+    const uint32_t task_nums[] = {10, 100, 1000};
+
+    ulog_init_user();
+    HDL_CPU_Time_Init();
+    for (uint32_t i = 0; i < sizeof(task_nums) / sizeof(task_nums[0]); i++) {
+        scheduler_benchmark(tasks, task_nums[i]);
+    }
+}
+
+/*
+scheduler_check_test检查调度的正确性，而不只是循环频率：
+注册最多1000个周期100ms、到期时刻均匀分布的任务，外加一个只执行3次的10ms任务，运行10个周期。
+每次执行时检查：
+    不早于_due_tick执行；
+    执行顺序按_due_tick不减，也就是堆顶总是最早到期的任务；
+    同一个任务两次执行间隔不小于period(没有重复执行)，小于2倍period(没有漏掉)，
+    漏执行的检查依赖主循环足够快，上位机上定义SCHEDULER_SIMULATION用虚拟时钟运行；
+    取消注册后不再执行。
+第3个周期取消注册每7个任务中的一个，第5个周期重新注册其中一半，并把每11个任务中的一个改为20Hz，
+每次修改后用scheduler_heap_check检查堆。结束后检查每个任务的执行次数。
+*/
+#define SCHEDULER_CHECK_TASK_NUM (SCHEDULER_TASK_MAX_NUM < 1000 ? SCHEDULER_TASK_MAX_NUM : 1000)
+#define SCHEDULER_CHECK_PERIOD   100
+#define SCHEDULER_CHECK_ROUNDS   10
+#define SCHEDULER_CHECK_LIMITED  (SCHEDULER_CHECK_TASK_NUM - 1) // 只执行3次的任务
+
+static SchedulerTask_t check_tasks[SCHEDULER_CHECK_TASK_NUM];
+static uint32_t check_fires[SCHEDULER_CHECK_TASK_NUM];
+static uint32_t check_last_tick[SCHEDULER_CHECK_TASK_NUM];
+static bool check_cancelled[SCHEDULER_CHECK_TASK_NUM];
+static bool check_restart[SCHEDULER_CHECK_TASK_NUM]; // 修改周期或者重置次数后下一次执行不检查间隔
+static uint32_t check_prev_due     = 0;
+static bool check_has_prev         = false;
+static uint32_t check_total_fires  = 0;
+static uint32_t check_errors       = 0;
+
+static void scheduler_check(bool ok, const char *what, uint32_t id)
+{
+    if (!ok) {
+        // 只打印前几个错误，避免刷屏
+        if (check_errors < 10) {
+            ULOG_INFO("[Scheduler Test]: check failed: %s, task %u\r\n", what, id);
+        }
+        check_errors++;
+    }
+}
+
+static void check_fun(void *arg)
+{
+    uint32_t id           = (uint32_t)(uintptr_t)arg;
+    SchedulerTask_t *task = &check_tasks[id];
+    uint32_t now          = scheduler_test_get_tick();
+    uint32_t gap          = now - check_last_tick[id];
+
+    scheduler_check(!check_cancelled[id], "fired after unregister", id);
+    scheduler_check((int32_t)(now - task->_due_tick) >= 0, "fired before due", id);
+    scheduler_check(!check_has_prev || (int32_t)(task->_due_tick - check_prev_due) >= 0, "fired out of deadline order", id);
+    if (check_fires[id] > 0 && !check_restart[id]) {
+        scheduler_check(gap >= task->period, "duplicate fire", id);
+        scheduler_check(gap < 2 * task->period, "missed fire", id);
+    }
+    check_restart[id]   = false;
+    check_prev_due      = task->_due_tick;
+    check_has_prev      = true;
+    check_last_tick[id] = now;
+    check_fires[id]++;
+    check_total_fires++;
+}
+
+static void scheduler_check_run(uint32_t ticks)
+{
+#ifdef SCHEDULER_SIMULATION
+    // 每个tick调用一次scheduler_handler，相当于主循环足够快，任务不会因为主机负载漏执行
+    for (uint32_t i = 0; i < ticks; i++) {
+        scheduler_handler();
+        scheduler_sim_tick++;
+    }
+#else
+    uint32_t start = HDL_CPU_Time_GetTick();
+
+    while (HDL_CPU_Time_GetTick() - start < ticks) {
+        scheduler_handler();
+    }
+#endif
+}
+
+/**
+ * @brief Scheduler调度正确性测试：堆顺序、到期顺序、取消注册、修改周期、漏执行和重复执行。
+ *
+ */
+void scheduler_check_test()
+{
+    uint32_t task_num = SCHEDULER_CHECK_LIMITED;
+    uint32_t period   = scheduler_get_ms_ticks(SCHEDULER_CHECK_PERIOD);
+    uint32_t now      = 0;
+    uint32_t min_fire = 0;
+
+    ulog_init_user();
+    HDL_CPU_Time_Init();
+    scheduler_init();
+    memset(check_fires, 0, sizeof(check_fires));
+    memset(check_cancelled, 0, sizeof(check_cancelled));
+    memset(check_restart, 0, sizeof(check_restart));
+    check_has_prev    = false;
+    check_total_fires = 0;
+    check_errors      = 0;
+
+    scheduler_check(scheduler_next_deadline() == UINT32_MAX, "empty scheduler has a deadline", 0);
+    now = scheduler_test_get_tick();
+    for (uint32_t i = 0; i < task_num; i++) {
+        memset(&check_tasks[i], 0, sizeof(SchedulerTask_t));
+        check_tasks[i].exe_times     = SCHEDULER_EXE_TIMES_INF;
+        check_tasks[i].period        = period;
+        check_tasks[i].fun.fun       = check_fun;
+        check_tasks[i].fun.arg       = (void *)(uintptr_t)i;
+        check_tasks[i].last_exe_tick = now - period + 1 + i * (period - 1) / task_num;
+        scheduler_check(scheduler_register(&check_tasks[i]), "register", i);
+    }
+    memset(&check_tasks[SCHEDULER_CHECK_LIMITED], 0, sizeof(SchedulerTask_t));
+    check_tasks[SCHEDULER_CHECK_LIMITED].exe_times     = 3;
+    check_tasks[SCHEDULER_CHECK_LIMITED].period        = scheduler_get_ms_ticks(10);
+    check_tasks[SCHEDULER_CHECK_LIMITED].fun.fun       = check_fun;
+    check_tasks[SCHEDULER_CHECK_LIMITED].fun.arg       = (void *)(uintptr_t)SCHEDULER_CHECK_LIMITED;
+    check_tasks[SCHEDULER_CHECK_LIMITED].last_exe_tick = now;
+    scheduler_check(scheduler_register(&check_tasks[SCHEDULER_CHECK_LIMITED]), "register", SCHEDULER_CHECK_LIMITED);
+    scheduler_check(scheduler_heap_check(), "heap after register", 0);
+    scheduler_check(scheduler_next_deadline() <= period, "first deadline", 0);
+
+    scheduler_check_run(3 * period);
+    for (uint32_t i = 0; i < task_num; i += 7) {
+        scheduler_check(scheduler_unregister(&check_tasks[i]), "unregister", i);
+        check_cancelled[i] = true;
+    }
+    scheduler_check(scheduler_heap_check(), "heap after unregister", 0);
+    scheduler_check(check_fires[SCHEDULER_CHECK_LIMITED] == 3, "limited task exe times", SCHEDULER_CHECK_LIMITED);
+    scheduler_check(check_tasks[SCHEDULER_CHECK_LIMITED]._heap_pos == 0, "limited task still in heap", SCHEDULER_CHECK_LIMITED);
+    check_restart[SCHEDULER_CHECK_LIMITED] = true;
+    scheduler_reset_exe_cnt(&check_tasks[SCHEDULER_CHECK_LIMITED]);
+
+    scheduler_check_run(2 * period);
+    for (uint32_t i = 0; i < task_num; i += 14) {
+        check_cancelled[i] = false;
+        check_fires[i]     = 0;
+        scheduler_check(scheduler_register(&check_tasks[i]), "register again", i);
+    }
+    for (uint32_t i = 1; i < task_num; i += 11) {
+        if (!check_cancelled[i]) {
+            check_restart[i] = true;
+            scheduler_set_freq(&check_tasks[i], 20);
+        }
+    }
+    scheduler_check(scheduler_heap_check(), "heap after reschedule", 0);
+    scheduler_check(check_fires[SCHEDULER_CHECK_LIMITED] == 6, "limited task exe times after reset", SCHEDULER_CHECK_LIMITED);
+
+    scheduler_check_run((SCHEDULER_CHECK_ROUNDS - 5) * period);
+    scheduler_check(scheduler_heap_check(), "heap at end", 0);
+    for (uint32_t i = 0; i < task_num; i++) {
+        if (check_cancelled[i]) {
+            min_fire = 0;
+            scheduler_check(check_fires[i] <= 4, "cancelled task fire count", i);
+        } else if (i % 14 == 0) {
+            min_fire = SCHEDULER_CHECK_ROUNDS - 5 - 1;
+        } else if (i % 11 == 1) {
+            min_fire = SCHEDULER_CHECK_ROUNDS + (SCHEDULER_CHECK_ROUNDS - 5) - 2;
+        } else {
+            min_fire = SCHEDULER_CHECK_ROUNDS - 1;
+        }
+        scheduler_check(check_fires[i] >= min_fire, "task fire count", i);
+    }
+
+    for (uint32_t i = 0; i < SCHEDULER_CHECK_TASK_NUM; i++) {
+        scheduler_unregister(&check_tasks[i]);
+    }
+    scheduler_check(scheduler_next_deadline() == UINT32_MAX, "deadline after unregister all", 0);
+    ULOG_INFO("[Scheduler Test]: %u tasks, %u fires, %u errors\r\n", SCHEDULER_CHECK_TASK_NUM, check_total_fires, check_errors);
+    ULOG_INFO("[Scheduler Test] %s\r\n", check_errors == 0 ? "pass" : "fail");
+}
+
+#if TASK_PROFILE_ENABLE
+static void profile_fun(void *arg)
+{
+    HDL_CPU_Time_DelayUs((uint32_t)(uintptr_t)arg);
+}
+
+/**
+ * @brief 执行时间统计测试：三个执行时间不同的任务运行10s后打印统计，
+ * 100us任务周期1tick，执行时间加上延迟会偶尔超过周期，应该能看到deadline miss。
+ *
+ */
+void scheduler_profile_test()
+{
+    static SchedulerTask_t tasks[3];
+    const uint32_t exe_us[] = {100, 500, 2000};
+    const uint32_t period[] = {1, 10, 100};
+    uint32_t start          = 0;
+
+    ulog_init_user();
+    HDL_CPU_Time_Init();
+    scheduler_init();
+    for (uint32_t i = 0; i < 3; i++) {
+        memset(&tasks[i], 0, sizeof(SchedulerTask_t));
+        tasks[i].exe_times = SCHEDULER_EXE_TIMES_INF;
+        tasks[i].period    = period[i];
+        tasks[i].fun.fun   = profile_fun;
+        tasks[i].fun.arg   = (void *)(uintptr_t)exe_us[i];
+        scheduler_register(&tasks[i]);
+    }
+    scheduler_profile_reset();
+
+    start = HDL_CPU_Time_GetTick();
+    while (HDL_CPU_Time_GetTick() - start < 10000) {
+        scheduler_handler();
+    }
+    scheduler_profile_dump(3);
+}
+
+#ifdef SCHEDULER_SIMULATION
+/*
+scheduler_profile_check用虚拟时钟检查scheduler记录的执行时间统计，结果和主机负载无关：
+scheduler_handler每4个tick调用一次，1tick周期、执行2tick的任务除第一次外每次晚3个tick，每次都超时；
+100tick周期、几乎不执行的任务每次调用时正好到期，不超时。打印时前者排在前面，top_n截断。
+*/
+#define SCHEDULER_PROFILE_STEP  4
+#define SCHEDULER_PROFILE_TICKS 400
+
+/**
+ * @brief Scheduler执行时间统计检查，和LIB/task_profile_test.c一起编译。
+ *
+ * @return uint32_t 错误数。
+ */
+uint32_t scheduler_profile_check()
+{
+    static SchedulerTask_t tasks[2];
+    const uint32_t tick_us     = (uint32_t)HDL_CPU_TIME_OEN_TICK_TIME;
+    const TaskProfile_t *pSlow = &tasks[0].profile;
+    const TaskProfile_t *pIdle = &tasks[1].profile;
+    const uint32_t period[]    = {1, 100};
+    const uint32_t exe_us[]    = {2 * tick_us, 0};
+
+    check_errors       = 0;
+    scheduler_sim_tick = 1000;
+    scheduler_init();
+    for (uint32_t i = 0; i < 2; i++) {
+        memset(&tasks[i], 0, sizeof(SchedulerTask_t));
+        tasks[i].exe_times = SCHEDULER_EXE_TIMES_INF;
+        tasks[i].period    = period[i];
+        tasks[i].fun.fun   = profile_fun;
+        tasks[i].fun.arg   = (void *)(uintptr_t)exe_us[i];
+        scheduler_register(&tasks[i]);
+    }
+    scheduler_profile_reset();
+
+    for (uint32_t i = 0; i < SCHEDULER_PROFILE_TICKS; i += SCHEDULER_PROFILE_STEP) {
+        scheduler_handler();
+        scheduler_sim_tick += SCHEDULER_PROFILE_STEP;
+    }
+
+    scheduler_check(pSlow->call_cnt == SCHEDULER_PROFILE_TICKS / SCHEDULER_PROFILE_STEP && pSlow->release_cnt == pSlow->call_cnt,
+                    "profile releases", 0);
+    scheduler_check(pSlow->min_us >= exe_us[0] && pSlow->min_us <= pSlow->total_us / pSlow->call_cnt &&
+                        pSlow->total_us / pSlow->call_cnt <= pSlow->max_us,
+                    "profile min max mean", 0);
+    scheduler_check(pSlow->deadline_miss == pSlow->release_cnt, "profile deadline miss", 0);
+    scheduler_check(pSlow->jitter_hist[0] == 1 && pSlow->jitter_hist[2] == pSlow->release_cnt - 1, "profile late 2-3 bin", 0);
+    scheduler_check(pIdle->call_cnt == SCHEDULER_PROFILE_TICKS / period[1] && pIdle->release_cnt == pIdle->call_cnt,
+                    "profile releases", 1);
+    scheduler_check(pIdle->min_us <= pIdle->total_us / pIdle->call_cnt && pIdle->total_us / pIdle->call_cnt <= pIdle->max_us,
+                    "profile min max mean", 1);
+    scheduler_check(pIdle->deadline_miss == 0 && pIdle->jitter_hist[0] == pIdle->release_cnt, "profile on time", 1);
+
+    // 表头两行之后按总执行时间从大到小
+    scheduler_check(task_profile_test_capture(scheduler_profile_dump, 2) == 4 &&
+                        strstr(task_profile_test_line(0), "[Scheduler] top 2") != NULL,
+                    "profile dump header", 0);
+    scheduler_check(task_profile_test_row(2, 0, NULL, &tasks[0]) && task_profile_test_row(3, 1, NULL, &tasks[1]),
+                    "profile dump sorted", 0);
+    scheduler_check(task_profile_test_capture(scheduler_profile_dump, 1) == 3 && task_profile_test_row(2, 0, NULL, &tasks[0]),
+                    "profile dump top 1", 0);
+
+    scheduler_unregister(&tasks[0]);
+    scheduler_unregister(&tasks[1]);
+    ULOG_INFO("[Scheduler Profile Test] %s\r\n", check_errors == 0 ? "pass" : "fail");
+    return check_errors;
+}
+#endif
+#endif
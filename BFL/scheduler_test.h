@@ -14,4 +14,12 @@
 
 void scheduler_test();
 void period_test();
+void scheduler_benchmark_test();
+void scheduler_check_test();
+#if TASK_PROFILE_ENABLE
+void scheduler_profile_test();
+#ifdef SCHEDULER_SIMULATION
+uint32_t scheduler_profile_check();
+#endif
+#endif
 #endif // !SCHEDULER_TEST_H
\ No newline at end of file
@@ -9,10 +9,13 @@
  * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
  *
  */
-#include "Ymodem.h"
+#include "ymodem.h"
 #include "ymodem_if_prototype.h"
+#include "crc.h"
+#include "HDL_CPU_Time.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /* ASCII control codes: */
 #define SOH (0x01) /* start of 128-byte data packet */
@@ -28,99 +31,65 @@
 
 #define YMODEM_IS_CONTROL_CHAR(c) ((c) == SOH || (c) == STX || (c) == EOT || (c) == ACK || (c) == NAK || (c) == CAN || (c) == CNC)
 
-/**
- * @brief 使用该方法需要保证Message是YMODEM_MESSAGE_TYPE_CMDS
- */
-#define YMODEM_MESSAGE_TYPE_CMDS_IS(buf, CMD1, CMD2) (buf[0] == CMD1 && buf[1] == CMD2)
-#define YMODEM_FRAME_SIZE_BY_HEADER(frame_header)    ((frame_header) == SOH ? (128 + (YMODEM_FRAME_HEADER_LEN + YMODEM_FRAME_CHECK_LEN)) : (1024 + (YMODEM_FRAME_HEADER_LEN + YMODEM_FRAME_CHECK_LEN)))
+#define YMODEM_FRAME_SIZE_BY_HEADER(frame_header) ((frame_header) == SOH ? (128 + (YMODEM_FRAME_HEADER_LEN + YMODEM_FRAME_CHECK_LEN)) : (1024 + (YMODEM_FRAME_HEADER_LEN + YMODEM_FRAME_CHECK_LEN)))
+#define YMODEM_DATA_SIZE_BY_HEADER(frame_header)  ((frame_header) == SOH ? 128U : 1024U)
+// 帧中间超过这个时间没有收到数据，丢弃收到的部分
+#define YMODEM_FRAME_TIMEOUT_MS                   100U
+// 续传时每次读出多少已有的数据比较
+#define YMODEM_COMPARE_CHUNK                      128U
 
-YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session, uint8_t *data, uint32_t size);
 /**
- * @brief 计算crc16校验码.
+ * @brief 续传记录。FatFs文件的已有长度就是文件长度，原始分区没有文件长度，记录在这里，复位后不保留。
  *
- * @param buf
- * @param count
- * @return uint16_t
  */
-static uint16_t Ymodem_CRC16(const uint8_t *buf, size_t count)
-{
-    uint16_t crc = 0;
-    int i;
+typedef struct {
+    uint32_t name_crc;  // 文件名的CRC32
+    uint32_t size;      // 文件大小
+    uint32_t committed; // 已经写入的长度
+} YmodemRawResume_t;
 
-    while (count--) {
-        crc = crc ^ *buf++ << 8;
+static YmodemRawResume_t ymodem_raw_resume;
 
-        for (i = 0; i < 8; i++) {
-            if (crc & 0x8000) {
-                crc = crc << 1 ^ 0x1021;
-            } else {
-                crc = crc << 1;
-            }
-        }
-    }
-    return crc;
+static uint32_t YmodemSessionFrameCount(YmodemSession_t *session)
+{
+    return (uint8_t)(session->ready_tail_ - session->ready_head_);
 }
 
+/**
+ * @brief 检查收完的帧。单个字节的帧是命令，数据帧检查编号和反码、CRC16-CCITT。
+ *
+ * @param data
+ * @param size
+ * @return YmodemMessageType_t
+ */
 static YmodemMessageType_t YmodemMessageCheck(const uint8_t *data, uint32_t size)
 {
+    uint32_t data_size = 0;
+
     if (data == NULL || size == 0) {
         return YMODEM_MESSAGE_TYPE_UNKNOWN;
     }
-
     if (size == 1) {
-        if (YMODEM_IS_CONTROL_CHAR(data[0])) {
-            return YMODEM_MESSAGE_TYPE_CMD;
-        } else {
-            return YMODEM_MESSAGE_TYPE_UNKNOWN;
-        }
+        return YMODEM_IS_CONTROL_CHAR(data[0]) ? YMODEM_MESSAGE_TYPE_CMD : YMODEM_MESSAGE_TYPE_UNKNOWN;
     }
-    // 按照《XMODEM/YMODEM PROTOCOL REFERENCE》只会有两个控制字符会连续发送，但是许多上位机主动结束发送时会发送连续4个CAN控制字符，有些还会附带一些不知道什么作用的字符。
-    // 这里16是估算可能的没有按照规定写的发送程序
-    else if (size > 1 && size < 16) {
-        YmodemMessageType_t type = YMODEM_MESSAGE_TYPE_CMDS;
-        // 两个CAN或者ACK,CNC
-        if (size == 2) {
-            for (uint32_t i = 0; i < size; i++) {
-                if (!YMODEM_IS_CONTROL_CHAR(data[i])) {
-                    type = YMODEM_MESSAGE_TYPE_UNKNOWN;
-                    break;
-                }
-            }
-        } else {
-            // CAN CAN CAN CAN 或者 CAN CAN CAN CAN X X X X
-            // 一般来说最多会有四个连续的CAN控制字符
-            size = size > 4 ? 4 : size;
-            for (uint32_t i = 0; i < size; i++) {
-                if (!YMODEM_IS_CONTROL_CHAR(data[i])) {
-                    type = YMODEM_MESSAGE_TYPE_UNKNOWN;
-                    break;
-                }
-            }
-        }
-        return type;
-    } else if (size == YMODEM_FRAME_SIZE_BY_HEADER(SOH)) {
-        uint16_t crc = Ymodem_CRC16(data + YMODEM_FRAME_HEADER_LEN, YMODEM_FRAME_SIZE_BY_HEADER(SOH) - YMODEM_FRAME_HEADER_LEN);
-        if (crc == 0) {
-            if (data[1] == 0x00) {
-                for (uint32_t i = 0; i < YMODEM_FRAME_SIZE_BY_HEADER(SOH); i++) {
-                    if (data[i + YMODEM_FRAME_HEADER_LEN] != 0x00) {
-                        return YMODEM_MESSAGE_TYPE_128_BLOCK;
-                    }
-                }
-            }
-            return YMODEM_MESSAGE_TYPE_128_NUL_BLOCK;
-        } else {
-            return YMODEM_MESSAGE_TYPE_UNKNOWN;
-        }
-    } else if (size == YMODEM_FRAME_SIZE_BY_HEADER(STX)) {
-        uint16_t crc = Ymodem_CRC16(data + YMODEM_FRAME_HEADER_LEN, YMODEM_FRAME_SIZE_BY_HEADER(STX) - YMODEM_FRAME_HEADER_LEN);
-        if (crc == 0) {
-            return YMODEM_MESSAGE_TYPE_1K_BLOCK;
-        } else {
-            return YMODEM_MESSAGE_TYPE_UNKNOWN;
+    if ((data[0] != SOH && data[0] != STX) || size != YMODEM_FRAME_SIZE_BY_HEADER(data[0]) || (uint8_t)(data[1] ^ data[2]) != 0xFF) {
+        return YMODEM_MESSAGE_TYPE_UNKNOWN;
+    }
+    // 数据加上高位在前的CRC一起计算，结果为0
+    if (CRC16_CCITT_Update(CRC16_CCITT_XMODEM_INIT, data + YMODEM_FRAME_HEADER_LEN, size - YMODEM_FRAME_HEADER_LEN) != 0) {
+        return YMODEM_MESSAGE_TYPE_UNKNOWN;
+    }
+    if (data[0] == STX) {
+        return YMODEM_MESSAGE_TYPE_1K_BLOCK;
+    }
+    // 空的block0：文件名为空
+    data_size = YMODEM_DATA_SIZE_BY_HEADER(SOH);
+    for (uint32_t i = 0; i < data_size; i++) {
+        if (data[i + YMODEM_FRAME_HEADER_LEN] != 0x00) {
+            return YMODEM_MESSAGE_TYPE_128_BLOCK;
         }
     }
-    return YMODEM_MESSAGE_TYPE_UNKNOWN;
+    return YMODEM_MESSAGE_TYPE_128_NUL_BLOCK;
 }
 
 void YmodemReceiveSessionInit(YmodemSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size))
@@ -135,20 +104,29 @@ void YmodemReceiveSessionInit(YmodemSession_t *session, size_t (*read)(uint8_t *
     session->retry_max_count_           = 8;
     session->state_                     = YMODEM_SESSION_CLOSED;
     session->result_                    = YMODEM_SESSION_RESULT_NONE;
-    memset(session->buffer_, 0, sizeof(session->buffer_));
+    memset((void *)session->block_size_, 0, sizeof(session->block_size_));
+    session->ready_head_  = 0;
+    session->ready_tail_  = 0;
+    session->rx_          = 0;
     session->buffer_size_ = 0;
+    session->frame_size_  = 0;
     session->read         = read;
     session->write        = write;
     memset(&session->file_name_, 0, sizeof(session->file_name_));
-    session->file_size_   = 0;
-    session->file_offset_ = NULL;
+    session->file_size_     = 0;
+    session->file_offset_   = 0;
+    session->resume_offset_ = 0;
+    session->unsynced_      = 0;
+    session->target_        = YMODEM_TARGET_FATFS;
 
     session->received_cancle_count_ = 0;
     session->file_is_open_          = false;
     session->last_read_tick_ms_     = 0;
+    memset(&session->stat_, 0, sizeof(session->stat_));
 }
 
-bool YmodemReceiveSessionOpen(YmodemSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size))
+bool YmodemReceiveSessionOpenTarget(YmodemSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size),
+                                    YmodemTarget_t target)
 {
     if (session == NULL) {
         return false;
@@ -159,10 +137,16 @@ bool YmodemReceiveSessionOpen(YmodemSession_t *session, size_t (*read)(uint8_t *
     }
 
     YmodemReceiveSessionInit(session, read, write);
-    session->state_ = YMODEM_RECEIVE_WAIT_HEADER;
+    session->target_ = target;
+    session->state_  = YMODEM_RECEIVE_WAIT_HEADER;
     return true;
 }
 
+bool YmodemReceiveSessionOpen(YmodemSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size))
+{
+    return YmodemReceiveSessionOpenTarget(session, read, write, YMODEM_TARGET_FATFS);
+}
+
 void YmodemReceiveSessionCancle(YmodemSession_t *session)
 {
     if (session == NULL) {
@@ -195,47 +179,270 @@ void YmodemSessionClearResult(YmodemSession_t *session)
     session->result_ = YMODEM_SESSION_RESULT_NONE;
 }
 
+void YmodemSessionGetStat(YmodemSession_t *session, YmodemSessionStat_t *pStat)
+{
+    if (session == NULL || pStat == NULL) {
+        return;
+    }
+    *pStat = session->stat_;
+}
+
+/**
+ * @brief 当前帧收完，放入队列。另一个缓冲区空闲时接着接收下一帧，否则暂停接收，直到主循环处理完一帧。
+ *
+ */
+static void YmodemReceiveFrameDone(YmodemSession_t *session)
+{
+    int8_t rx = session->rx_;
+
+    session->block_size_[rx]                   = session->buffer_size_;
+    session->ready_[session->ready_tail_ & 1U] = (uint8_t)rx;
+    session->ready_tail_++;
+    session->buffer_size_ = 0;
+    session->frame_size_  = 0;
+    session->rx_          = session->block_size_[rx ^ 1] == 0 ? (int8_t)(rx ^ 1) : -1;
+}
+
+/**
+ * @brief 送入一个收到的字节，可以在串口接收中断中调用（Uart_RegisterReceiveCharCallback）。
+ * 帧头决定帧的长度，数据直接放进接收缓冲区，收满一帧后交给YmodemSessionPoll处理。
+ * 帧之间不是帧头、也不是命令的字节丢弃。
+ *
+ * @param session
+ * @param ch
+ */
+void YmodemReceiveSessionPushByte(YmodemSession_t *session, uint8_t ch)
+{
+    int8_t rx = session->rx_;
+
+    if (session->state_ == YMODEM_SESSION_CLOSED) {
+        return;
+    }
+    if (rx < 0) {
+        session->stat_.overruns++;
+        return;
+    }
+    if (session->buffer_size_ == 0) {
+        if (ch == SOH || ch == STX) {
+            session->frame_size_ = YMODEM_FRAME_SIZE_BY_HEADER(ch);
+        } else if (YMODEM_IS_CONTROL_CHAR(ch)) {
+            session->frame_size_ = 1;
+        } else {
+            return;
+        }
+    }
+    session->block_[rx][session->buffer_size_++] = ch;
+    session->last_read_tick_ms_                  = YMODEM_GET_MS_TICK();
+    if (session->buffer_size_ == session->frame_size_) {
+        YmodemReceiveFrameDone(session);
+    }
+}
+
+/**
+ * @brief 从read读取数据。帧头之后的数据直接读到接收缓冲区中帧的位置，每次最多读到帧结束。
+ *
+ */
+static void YmodemReceiveSessionRead(YmodemSession_t *session)
+{
+    uint8_t ch = 0;
+    size_t len = 0;
+
+    while (session->rx_ >= 0) {
+        if (session->buffer_size_ == 0) {
+            if (session->read(&ch, 1) == 0) {
+                break;
+            }
+            YmodemReceiveSessionPushByte(session, ch);
+            continue;
+        }
+        len = session->read(session->block_[session->rx_] + session->buffer_size_, session->frame_size_ - session->buffer_size_);
+        if (len == 0) {
+            break;
+        }
+        session->buffer_size_ += len;
+        session->last_read_tick_ms_ = YMODEM_GET_MS_TICK();
+        if (session->buffer_size_ == session->frame_size_) {
+            YmodemReceiveFrameDone(session);
+        }
+    }
+}
+
+static uint32_t YmodemNameCRC(const char *name)
+{
+    return CRC32((const uint8_t *)name, strlen(name));
+}
+
 static void YmodemReceiveSessionFileHandleBegin(YmodemSession_t *session, uint8_t *data, uint32_t size)
 {
     // eg . SHO 00 FF "f00.c" 1234 00 00 00 CRCH CRCL
-    char *file_name = (char *)(data + YMODEM_FRAME_HEADER_LEN);
+    char *file_name    = (char *)(data + YMODEM_FRAME_HEADER_LEN);
+    uint32_t committed = 0;
 
-    strncpy(session->file_name_, file_name, YMODEM_FRAME_SIZE_BY_HEADER(SOH));
-    session->file_name_[YMODEM_FRAME_SIZE_BY_HEADER(SOH)] = '\0';
+    strncpy(session->file_name_, file_name, YMODEM_DATA_SIZE_BY_HEADER(SOH));
+    session->file_name_[YMODEM_DATA_SIZE_BY_HEADER(SOH)] = '\0';
 
     size_t file_name_len = strlen(session->file_name_);
     uint32_t file_size   = 0;
-    sscanf((char *)(data + YMODEM_FRAME_HEADER_LEN + file_name_len + 1), "%d", &file_size);
+    if (file_name_len + 1 < YMODEM_DATA_SIZE_BY_HEADER(SOH)) {
+        file_size = (uint32_t)strtoul((char *)(data + YMODEM_FRAME_HEADER_LEN + file_name_len + 1), NULL, 10);
+    }
 
+    if (session->target_ == YMODEM_TARGET_RAW) {
+        if (ymodem_raw_resume.name_crc == YmodemNameCRC(session->file_name_) && ymodem_raw_resume.size == file_size) {
+            committed = ymodem_raw_resume.committed;
+        }
+        session->file_is_open_ = YmodemRawOpen(&session->file, file_size, committed);
+    } else {
+#if YMODEM_RESUME
+        session->file_is_open_ = YmodemFileOpen(&session->file, session->file_name_);
+        if (session->file_is_open_) {
+            committed = YmodemFileGetSize(&session->file);
+            // 只有比要接收的文件短的已有文件才续传
+            if (file_size == 0 || committed >= file_size) {
+                committed              = 0;
+                session->file_is_open_ = YmodemFileTruncate(&session->file, 0);
+            }
+        }
+#else
 #if YMODEM_FILE_OVERWRITE
-    if (YmodemIsFileExist(session->file_name_)) {
-        YmodemFileRemove(session->file_name_);
-    }
+        if (YmodemIsFileExist(session->file_name_)) {
+            YmodemFileRemove(session->file_name_);
+        }
 #endif
-    session->file_is_open_ = YmodemFileOpen(&session->file, session->file_name_);
+        session->file_is_open_ = YmodemFileOpen(&session->file, session->file_name_);
+#endif
+    }
     if (session->file_is_open_ == false) {
         YmodemReceiveSessionCancle(session);
         session->result_ = YMODEM_SESSION_RESULT_ERROR;
         session->state_  = YMODEM_SESSION_CLOSED;
     } else {
-        session->file_size_   = file_size;
-        session->file_offset_ = 0;
-        session->result_      = YMODEM_SESSION_RESULT_NONE;
+        session->file_size_     = file_size;
+        session->file_offset_   = 0;
+        session->resume_offset_ = committed;
+        session->unsynced_      = 0;
+        session->result_        = YMODEM_SESSION_RESULT_NONE;
+        if (session->stat_.startTickMs == 0) {
+            session->stat_.startTickMs = YMODEM_GET_MS_TICK();
+        }
+    }
+}
+
+/**
+ * @brief 续传时比较数据块和已有的数据。相同时返回true，不再写入；不同时从这里截断，之后的数据重新写入。
+ *
+ */
+static bool YmodemResumeMatch(YmodemSession_t *session, const uint8_t *data, uint32_t size)
+{
+    uint8_t chunk[YMODEM_COMPARE_CHUNK];
+    uint32_t n    = 0;
+    bool is_match = session->file_offset_ + size <= session->resume_offset_;
+
+    for (uint32_t i = 0; is_match && i < size; i += n) {
+        n = size - i < sizeof(chunk) ? size - i : sizeof(chunk);
+        if (YmodemFileReadAt(&session->file, session->file_offset_ + i, chunk, n) != n || memcmp(chunk, data + i, n) != 0) {
+            is_match = false;
+        }
+    }
+    if (!is_match) {
+        YmodemFileTruncate(&session->file, session->file_offset_);
+        session->resume_offset_ = 0;
     }
+    return is_match;
 }
 
-static void YmodemPushDataToFile(YmodemSession_t *session, uint8_t *data, uint32_t size)
+/**
+ * @brief 把数据块写入存储，最后一块只写入文件大小以内的部分。
+ *
+ * @return true 成功。
+ * @return false 写入失败。
+ */
+static bool YmodemPushDataToFile(YmodemSession_t *session, uint8_t *data, uint32_t size)
 {
     uint8_t cmd            = data[0];
-    size_t valid_data_size = 0;
-    if (session->file_size_ - session->file_offset_ < YMODEM_FRAME_SIZE_BY_HEADER(cmd)) {
-        valid_data_size = session->file_size_ - session->file_offset_;
-    } else {
-        valid_data_size = YMODEM_FRAME_SIZE_BY_HEADER(cmd);
+    size_t valid_data_size = YMODEM_DATA_SIZE_BY_HEADER(cmd);
+    uint32_t startUs       = 0;
+    uint32_t us            = 0;
+
+    if (session->file_size_ > 0) {
+        if (session->file_offset_ >= session->file_size_) {
+            return true;
+        }
+        if (session->file_size_ - session->file_offset_ < valid_data_size) {
+            valid_data_size = session->file_size_ - session->file_offset_;
+        }
     }
+    data += YMODEM_FRAME_HEADER_LEN;
 
-    YmodemFileAppend(&session->file, data + YMODEM_FRAME_HEADER_LEN, valid_data_size);
+    if (session->resume_offset_ > 0 && YmodemResumeMatch(session, data, valid_data_size)) {
+        session->stat_.resumed += valid_data_size;
+    } else {
+        startUs = HDL_CPU_Time_GetUsTick();
+        if (YmodemFileAppend(&session->file, data, valid_data_size) != valid_data_size) {
+            return false;
+        }
+        session->stat_.bytes += valid_data_size;
+        session->unsynced_ += valid_data_size;
+        if (session->unsynced_ >= YMODEM_SYNC_BYTES) {
+            session->unsynced_ = 0;
+            YmodemFileSync(&session->file);
+        }
+        us = HDL_CPU_Time_GetUsTick() - startUs;
+        if (us > session->stat_.maxWriteUs) {
+            session->stat_.maxWriteUs = us;
+        }
+    }
     session->file_offset_ += valid_data_size;
+    if (session->target_ == YMODEM_TARGET_RAW) {
+        ymodem_raw_resume.name_crc  = YmodemNameCRC(session->file_name_);
+        ymodem_raw_resume.size      = session->file_size_;
+        ymodem_raw_resume.committed = session->file_offset_;
+    }
+    return true;
+}
+
+/**
+ * @brief 关闭文件。成功接收完整的文件后清除原始分区的续传记录。
+ *
+ * @return true 文件完整并且关闭成功。
+ * @return false 关闭失败，或者文件头给出了大小而收到的数据不够（发送方提前发送了EOT），
+ * 原始分区保留续传记录。
+ */
+static bool YmodemReceiveSessionFileEnd(YmodemSession_t *session)
+{
+    bool ret = YmodemFileClose(&session->file);
+
+    session->file_is_open_ = false;
+    if (session->file_size_ > 0 && session->file_offset_ < session->file_size_) {
+        ret = false;
+    }
+    if (session->target_ == YMODEM_TARGET_RAW && ret) {
+        memset(&ymodem_raw_resume, 0, sizeof(ymodem_raw_resume));
+    }
+    return ret;
+}
+
+static void YmodemSendCmd(YmodemSession_t *session, uint8_t cmd)
+{
+    session->write(&cmd, 1);
+}
+
+/**
+ * @brief 收到当前编号的数据块：先回复ACK，发送方开始发送下一块，同时把这一块写入存储，
+ * 下一块放进另一个缓冲区。
+ *
+ */
+static void YmodemReceiveDataBlock(YmodemSession_t *session, uint8_t *data, uint32_t size)
+{
+    session->next_expected_sequence_ = (session->next_expected_sequence_ + 1) & 0xFFU;
+    session->state_                  = YMODEM_RECEIVE_WAIT_DATA;
+    session->retry_count_            = 0;
+    session->stat_.blocks++;
+    YmodemSendCmd(session, ACK);
+    if (!YmodemPushDataToFile(session, data, size)) {
+        YmodemReceiveSessionCancle(session);
+        session->result_ = YMODEM_SESSION_RESULT_ERROR;
+    }
 }
 
 /**
@@ -246,7 +453,7 @@ static void YmodemPushDataToFile(YmodemSession_t *session, uint8_t *data, uint32
  * @param size
  * @return YmodemSessionResult_t
  */
-YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session, uint8_t *data, uint32_t size)
+static YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session, uint8_t *data, uint32_t size)
 {
     if (session == NULL || data == NULL || size == 0 || session->state_ == YMODEM_SESSION_CLOSED) {
         return YMODEM_SESSION_RESULT_NONE;
@@ -256,7 +463,7 @@ YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session
     uint8_t sequence             = 0;
     uint8_t cmd                  = 0;
     cmd                          = data[0];
-    if (msg_type == YMODEM_MESSAGE_TYPE_128_BLOCK || msg_type == YMODEM_MESSAGE_TYPE_1K_BLOCK) {
+    if (msg_type == YMODEM_MESSAGE_TYPE_128_BLOCK || msg_type == YMODEM_MESSAGE_TYPE_128_NUL_BLOCK || msg_type == YMODEM_MESSAGE_TYPE_1K_BLOCK) {
         sequence = data[1];
     }
 
@@ -272,6 +479,16 @@ YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session
             return YMODEM_SESSION_RESULT_NONE;
         }
     }
+    session->received_cancle_count_ = 0;
+
+    // 校验失败、不完整的帧请求重发
+    if (msg_type == YMODEM_MESSAGE_TYPE_UNKNOWN) {
+        session->stat_.errors++;
+        if (session->state_ == YMODEM_RECEIVE_WAIT_DATA || session->state_ == YMODEM_RECEIVE_WAIT_DATA_BEGIN) {
+            YmodemSendCmd(session, NAK);
+        }
+        return session->result_;
+    }
 
     switch (session->state_) {
         case YMODEM_RECEIVE_WAIT_HEADER:
@@ -288,51 +505,30 @@ YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session
             }
             break;
         case YMODEM_RECEIVE_WAIT_DATA_BEGIN:
-            msg_type = msg_type == YMODEM_MESSAGE_TYPE_128_NUL_BLOCK ? YMODEM_MESSAGE_TYPE_128_BLOCK : msg_type;
-            if (msg_type == YMODEM_MESSAGE_TYPE_128_BLOCK && session->next_expected_sequence_ == sequence) {
-                session->next_expected_sequence_ = sequence + 1;
-                session->state_                  = YMODEM_RECEIVE_WAIT_DATA;
-                session->retry_count_            = 0;
-                const uint8_t ack                = ACK;
-                session->write(&ack, 1);
-                YmodemPushDataToFile(session, data, size);
-            } else if (msg_type == YMODEM_MESSAGE_TYPE_1K_BLOCK && session->next_expected_sequence_ == sequence) {
-                session->next_expected_sequence_ = sequence + 1;
-                session->state_                  = YMODEM_RECEIVE_WAIT_DATA;
-                session->retry_count_            = 0;
-                const uint8_t ack                = ACK;
-                session->write(&ack, 1);
-                YmodemPushDataToFile(session, data, size);
-            } else if (msg_type == YMODEM_MESSAGE_TYPE_CMD && cmd == EOT) {
-                session->state_       = YMODEM_RECEIVE_WAIT_SECOND_EOT;
-                session->retry_count_ = 0;
-            } else {
-                // Nothing to do
-            }
-            break;
         case YMODEM_RECEIVE_WAIT_DATA:
-            msg_type = msg_type == YMODEM_MESSAGE_TYPE_128_NUL_BLOCK ? YMODEM_MESSAGE_TYPE_128_BLOCK : msg_type;
-            if (msg_type == YMODEM_MESSAGE_TYPE_128_BLOCK && session->next_expected_sequence_ == sequence) {
-                session->retry_count_            = 0;
-                session->next_expected_sequence_ = sequence + 1;
-                const uint8_t ack                = ACK;
-                session->write(&ack, 1);
-                YmodemPushDataToFile(session, data, size);
-            } else if (msg_type == YMODEM_MESSAGE_TYPE_1K_BLOCK && session->next_expected_sequence_ == sequence) {
-                session->retry_count_            = 0;
-                session->next_expected_sequence_ = sequence + 1;
-                const uint8_t ack                = ACK;
-                session->write(&ack, 1);
-                YmodemPushDataToFile(session, data, size);
-            } else if (msg_type == YMODEM_MESSAGE_TYPE_CMD && cmd == EOT) {
+            if (msg_type == YMODEM_MESSAGE_TYPE_CMD && cmd == EOT) {
                 session->state_       = YMODEM_RECEIVE_WAIT_SECOND_EOT;
                 session->retry_count_ = 0;
-                bool ret              = YmodemFileClose(&session->file);
-                if (ret) {
+                if (YmodemReceiveSessionFileEnd(session)) {
                     session->result_ = YMODEM_SESSION_RESULT_OK;
                 } else {
+                    // 不完整的文件不能当作成功，结束会话，否则之后的结束帧会把结果改成成功
+                    YmodemReceiveSessionCancle(session);
                     session->result_ = YMODEM_SESSION_RESULT_ERROR;
                 }
+            } else if (msg_type == YMODEM_MESSAGE_TYPE_CMD) {
+                // Nothing to do
+            } else if (sequence == session->next_expected_sequence_) {
+                YmodemReceiveDataBlock(session, data, size);
+            } else if (sequence == ((session->next_expected_sequence_ - 1) & 0xFFU)) {
+                // 发送方没有收到ACK，重发了上一块（第一块之前是文件头）
+                session->stat_.duplicates++;
+                if (session->state_ == YMODEM_RECEIVE_WAIT_DATA_BEGIN) {
+                    // 文件头的ACK丢失，重新开始计数，马上再回复ACK、'C'
+                    session->retry_count_ = 0;
+                } else {
+                    YmodemSendCmd(session, ACK);
+                }
             } else {
                 YmodemReceiveSessionCancle(session);
                 session->retry_count_ = 0;
@@ -352,9 +548,9 @@ YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session
             if (msg_type == YMODEM_MESSAGE_TYPE_128_NUL_BLOCK) {
                 session->state_       = YMODEM_SESSION_CLOSED;
                 session->retry_count_ = 0;
-                const uint8_t ack     = ACK;
-                session->write(&ack, 1);
-                session->result_ = YMODEM_SESSION_RESULT_OK;
+                YmodemSendCmd(session, ACK);
+                session->result_          = YMODEM_SESSION_RESULT_OK;
+                session->stat_.endTickMs = YMODEM_GET_MS_TICK();
             } else if (msg_type == YMODEM_MESSAGE_TYPE_128_BLOCK && sequence == 0) {
                 session->next_expected_sequence_ = sequence + 1;
                 session->state_                  = YMODEM_RECEIVE_WAIT_DATA_BEGIN;
@@ -371,6 +567,40 @@ YmodemSessionResult_t YmodemPushMessageToReceiveSession(YmodemSession_t *session
     return session->result_;
 }
 
+/**
+ * @brief 处理队列中收完的帧，处理完的缓冲区交还给接收。
+ *
+ */
+static void YmodemReceiveSessionProcess(YmodemSession_t *session)
+{
+    uint32_t last_read_tick_ms = 0;
+
+    while (YmodemSessionFrameCount(session) > 0 && session->state_ != YMODEM_SESSION_CLOSED) {
+        uint8_t idx = session->ready_[session->ready_head_ & 1U];
+
+        YmodemPushMessageToReceiveSession(session, session->block_[idx], session->block_size_[idx]);
+        YMODEM_ENTER_CRITICAL();
+        session->block_size_[idx] = 0;
+        session->ready_head_++;
+        if (session->rx_ < 0) {
+            session->rx_ = (int8_t)idx;
+        }
+        YMODEM_EXIT_CRITICAL();
+    }
+    // 帧中间停顿太久，丢弃收到的部分，请求重发。先取接收时间再取当前时间，中断中更新接收时间时差值不会是负数
+    last_read_tick_ms = session->last_read_tick_ms_;
+    if (session->buffer_size_ > 0 && YMODEM_GET_MS_TICK() - last_read_tick_ms > YMODEM_FRAME_TIMEOUT_MS) {
+        YMODEM_ENTER_CRITICAL();
+        session->buffer_size_ = 0;
+        session->frame_size_  = 0;
+        YMODEM_EXIT_CRITICAL();
+        session->stat_.errors++;
+        if (session->state_ == YMODEM_RECEIVE_WAIT_DATA || session->state_ == YMODEM_RECEIVE_WAIT_DATA_BEGIN) {
+            YmodemSendCmd(session, NAK);
+        }
+    }
+}
+
 void YmodemSessionPoll(YmodemSession_t *session)
 {
     if (session == NULL) {
@@ -381,22 +611,23 @@ void YmodemSessionPoll(YmodemSession_t *session)
         return;
     }
 
-    size_t len = 0;
-    len        = session->read(session->buffer_ + session->buffer_size_, YMODEM_FRAME_SIZE_1K - session->buffer_size_);
-    if (len > 0) {
-        session->buffer_size_ += len;
-        session->last_read_tick_ms_ = YMODEM_GET_MS_TICK();
+    if (session->read != NULL) {
+        YmodemReceiveSessionRead(session);
     }
-
-    if (YMODEM_GET_MS_TICK() - session->last_read_tick_ms_ > 10 && session->buffer_size_ > 0) {
-        // 10ms内没有读到数据，且缓冲区有数据，视为一条消息
-        YmodemPushMessageToReceiveSession(session, session->buffer_, session->buffer_size_);
-        session->buffer_size_ = 0;
+    YmodemReceiveSessionProcess(session);
+    if (session->read != NULL) {
+        // 处理期间释放了缓冲区，串口接收缓冲区中可能还有数据
+        YmodemReceiveSessionRead(session);
     }
 
     if (session->file_is_open_ == true && session->result_ != YMODEM_SESSION_RESULT_NONE) {
-        YmodemFileClose(&session->file);
-        session->file_is_open_ = false;
+        YmodemReceiveSessionFileEnd(session);
+    }
+    if (session->state_ == YMODEM_SESSION_CLOSED) {
+        if (session->stat_.endTickMs == 0) {
+            session->stat_.endTickMs = YMODEM_GET_MS_TICK();
+        }
+        return;
     }
 
     // 确保第一次发送在开始会话后直接开始
@@ -404,16 +635,18 @@ void YmodemSessionPoll(YmodemSession_t *session)
     if (YMODEM_GET_MS_TICK() - session->last_send_message_tick_ms_ > session->timeout_ || session->retry_count_ == 0) {
         if (session->retry_count_ > session->retry_max_count_) {
             YmodemReceiveSessionCancle(session);
-            session->result_ = YMODEM_SESSION_RESULT_TIMEOUT;
-            session->state_  = YMODEM_SESSION_CLOSED;
+            session->result_         = YMODEM_SESSION_RESULT_TIMEOUT;
+            session->state_          = YMODEM_SESSION_CLOSED;
+            session->stat_.endTickMs = YMODEM_GET_MS_TICK();
 
             if (session->file_is_open_) {
-                YmodemFileClose(&session->file);
-                if (YmodemIsFileExist(session->file_name_)) {
+                YmodemReceiveSessionFileEnd(session);
+#if !YMODEM_RESUME
+                if (session->target_ == YMODEM_TARGET_FATFS && YmodemIsFileExist(session->file_name_)) {
                     // 文件存在，删除
                     YmodemFileRemove(session->file_name_);
                 }
-                session->file_is_open_ = false;
+#endif
             }
             return;
         }
@@ -428,11 +661,23 @@ void YmodemSessionPoll(YmodemSession_t *session)
                 session->write(cmds_buf, 1);
                 break;
             case YMODEM_RECEIVE_WAIT_DATA_BEGIN:
-                cmds_buf[0] = ACK;
-                cmds_buf[1] = CNC;
-                session->write(cmds_buf, 2);
+                // 第一次是确认文件头。重试时只发送'C'：第一个数据块丢失时发送方在等待它的ACK，
+                // 把ACK当作确认会跳过第一块。文件头的ACK丢失时发送方重发文件头，重复的文件头再回复ACK、'C'
+                if (session->retry_count_ == 1) {
+                    cmds_buf[0] = ACK;
+                    cmds_buf[1] = CNC;
+                    session->write(cmds_buf, 2);
+                } else {
+                    cmds_buf[0] = CNC;
+                    session->write(cmds_buf, 1);
+                }
                 break;
             case YMODEM_RECEIVE_WAIT_DATA:
+                // 第一次是收到数据块的时候，ACK已经发送；之后超时没有收到下一块时重发ACK
+                if (session->retry_count_ > 1) {
+                    cmds_buf[0] = ACK;
+                    session->write(cmds_buf, 1);
+                }
                 break;
             case YMODEM_RECEIVE_WAIT_SECOND_EOT:
                 cmds_buf[0] = NAK;
@@ -448,3 +693,340 @@ void YmodemSessionPoll(YmodemSession_t *session)
         }
     }
 }
+
+/*************************发送会话*******************************/
+// 接收方回复ACK和处理一帧的时间，折算成字节数，用于选择最后一块的大小
+#define YMODEM_SEND_TURNAROUND_BYTES 16U
+
+/**
+ * @brief 选择下一个数据块的大小。剩下的数据用几个128字节的块发送比一个1K的块（大部分是填充）更快时用128字节的块。
+ *
+ */
+static uint32_t YmodemSendBlockDataSize(uint32_t remain)
+{
+    uint32_t blocks128 = (remain + 127U) / 128U;
+
+    if (blocks128 * (YMODEM_FRAME_SIZE_128 + YMODEM_SEND_TURNAROUND_BYTES) < YMODEM_FRAME_SIZE_1K + YMODEM_SEND_TURNAROUND_BYTES) {
+        return 128U;
+    }
+    return 1024U;
+}
+
+static void YmodemSendFrameFinish(uint8_t *frame, uint8_t sequence, uint32_t data_size)
+{
+    uint16_t crc = CRC16_CCITT_Update(CRC16_CCITT_XMODEM_INIT, frame + YMODEM_FRAME_HEADER_LEN, data_size);
+
+    frame[0]                                        = data_size == 128U ? SOH : STX;
+    frame[1]                                        = sequence;
+    frame[2]                                        = (uint8_t)~sequence;
+    frame[YMODEM_FRAME_HEADER_LEN + data_size]      = (uint8_t)(crc >> 8);
+    frame[YMODEM_FRAME_HEADER_LEN + data_size + 1U] = (uint8_t)crc;
+}
+
+static void YmodemSendSessionFinish(YmodemSendSession_t *session, YmodemSessionResult_t result)
+{
+    if (session->source_is_open_) {
+        YmodemSourceClose(&session->source);
+        session->source_is_open_ = false;
+    }
+    session->state_          = YMODEM_SESSION_CLOSED;
+    session->result_         = result;
+    session->stat_.endTickMs = YMODEM_GET_MS_TICK();
+}
+
+/**
+ * @brief 把下一个数据块读到空闲的缓冲区，算好CRC，收到ACK后直接发送。
+ *
+ */
+static void YmodemSendPrefetch(YmodemSendSession_t *session)
+{
+    uint8_t idx        = session->cur_ ^ 1U;
+    uint8_t *frame     = session->block_[idx];
+    uint32_t remain    = 0;
+    uint32_t data_size = 0;
+    uint32_t n         = 0;
+    uint32_t startUs   = 0;
+    uint32_t us        = 0;
+
+    if (session->block_size_[idx] != 0 || session->read_offset_ >= session->file_size_) {
+        return;
+    }
+    remain    = session->file_size_ - session->read_offset_;
+    data_size = YmodemSendBlockDataSize(remain);
+    n         = remain < data_size ? remain : data_size;
+    startUs   = HDL_CPU_Time_GetUsTick();
+    if (YmodemSourceRead(&session->source, session->read_offset_, frame + YMODEM_FRAME_HEADER_LEN, n) != n) {
+        YmodemSendSessionCancle(session);
+        session->result_ = YMODEM_SESSION_RESULT_ERROR;
+        return;
+    }
+    memset(frame + YMODEM_FRAME_HEADER_LEN + n, CPMEOF, data_size - n);
+    YmodemSendFrameFinish(frame, session->sequence_, data_size);
+    us = HDL_CPU_Time_GetUsTick() - startUs;
+    session->stat_.readUs += us;
+    if (us > session->stat_.maxReadUs) {
+        session->stat_.maxReadUs = us;
+    }
+    session->block_size_[idx] = data_size + YMODEM_FRAME_HEADER_LEN + YMODEM_FRAME_CHECK_LEN;
+    session->sequence_++;
+    session->read_offset_ += n;
+}
+
+static void YmodemSendCurrent(YmodemSendSession_t *session)
+{
+    session->write(session->block_[session->cur_], session->block_size_[session->cur_]);
+    session->last_send_message_tick_ms_ = YMODEM_GET_MS_TICK();
+}
+
+static void YmodemSendEOT(YmodemSendSession_t *session)
+{
+    uint8_t cmd = EOT;
+
+    session->write(&cmd, 1);
+    session->last_send_message_tick_ms_ = YMODEM_GET_MS_TICK();
+}
+
+/**
+ * @brief 打开下一个文件，在缓冲区0中准备文件头：文件名NUL文件大小NUL，没有文件了就是空的文件头。
+ *
+ * @return true 成功。
+ * @return false 打开文件失败。
+ */
+static bool YmodemSendPrepareHeader(YmodemSendSession_t *session)
+{
+    uint8_t *frame   = session->block_[0];
+    char *payload    = (char *)(frame + YMODEM_FRAME_HEADER_LEN);
+    const char *name = NULL;
+    const char *p    = NULL;
+    size_t len       = 0;
+
+    memset(frame, 0, YMODEM_FRAME_SIZE_128);
+    session->cur_           = 0;
+    session->block_size_[0] = YMODEM_FRAME_SIZE_128;
+    session->block_size_[1] = 0;
+    if (session->file_index_ < session->file_count_) {
+        name = session->files_[session->file_index_].path;
+        if (!YmodemSourceOpen(&session->source, &session->files_[session->file_index_], &session->file_size_)) {
+            return false;
+        }
+        session->source_is_open_ = true;
+        session->read_offset_    = 0;
+        session->sequence_       = 1;
+        // 去掉盘符和目录
+        for (p = name; *p != '\0'; p++) {
+            if (*p == ':' || *p == '/' || *p == '\\') {
+                name = p + 1;
+            }
+        }
+        len = strlen(name);
+        if (len > YMODEM_DATA_SIZE_BY_HEADER(SOH) - 16U) {
+            len = YMODEM_DATA_SIZE_BY_HEADER(SOH) - 16U;
+        }
+        memcpy(payload, name, len);
+        snprintf(payload + len + 1, YMODEM_DATA_SIZE_BY_HEADER(SOH) - len - 1, "%lu", (unsigned long)session->file_size_);
+    }
+    YmodemSendFrameFinish(frame, 0, YMODEM_DATA_SIZE_BY_HEADER(SOH));
+    return true;
+}
+
+bool YmodemSendSessionOpen(YmodemSendSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size),
+                           const YmodemSendFile_t *files, uint32_t count)
+{
+    if (session == NULL || read == NULL || write == NULL || (files == NULL && count > 0)) {
+        return false;
+    }
+    if (session->state_ != YMODEM_SESSION_CLOSED) {
+        return false;
+    }
+    memset(session, 0, sizeof(YmodemSendSession_t));
+    session->timeout_                   = 3000;
+    session->retry_max_count_           = 10;
+    session->read                       = read;
+    session->write                      = write;
+    session->files_                     = files;
+    session->file_count_                = count;
+    session->state_                     = YMODEM_SEND_WAIT_START;
+    session->result_                    = YMODEM_SESSION_RESULT_NONE;
+    session->last_send_message_tick_ms_ = YMODEM_GET_MS_TICK();
+    return true;
+}
+
+void YmodemSendSessionCancle(YmodemSendSession_t *session)
+{
+    if (session == NULL || session->state_ == YMODEM_SESSION_CLOSED) {
+        return;
+    }
+
+    const uint8_t cmds_buf[4] = {CAN, CAN, CAN, CAN};
+    session->write(cmds_buf, sizeof(cmds_buf));
+    YmodemSendSessionFinish(session, YMODEM_SESSION_RESULT_CANCLE);
+}
+
+YmodemSessionResult_t YmodemSendSessionGetResult(YmodemSendSession_t *session)
+{
+    if (session == NULL) {
+        return YMODEM_SESSION_RESULT_NONE;
+    }
+    return session->result_;
+}
+
+void YmodemSendSessionClearResult(YmodemSendSession_t *session)
+{
+    if (session == NULL) {
+        return;
+    }
+    session->result_ = YMODEM_SESSION_RESULT_NONE;
+}
+
+void YmodemSendSessionGetStat(YmodemSendSession_t *session, YmodemSendStat_t *pStat)
+{
+    if (session == NULL || pStat == NULL) {
+        return;
+    }
+    *pStat = session->stat_;
+}
+
+/**
+ * @brief 发送下一个数据块。下一块已经读好时直接发送，释放刚确认的一块，再读取之后的一块；文件发送完了发送EOT。
+ *
+ */
+static void YmodemSendNextBlock(YmodemSendSession_t *session)
+{
+    uint8_t acked = session->cur_;
+
+    session->retry_count_ = 0;
+    if (session->block_size_[acked ^ 1U] == 0) {
+        session->block_size_[acked] = 0;
+        session->state_             = YMODEM_SEND_WAIT_EOT_NAK;
+        YmodemSendEOT(session);
+        return;
+    }
+    session->cur_               = acked ^ 1U;
+    session->block_size_[acked] = 0;
+    session->state_             = YMODEM_SEND_WAIT_DATA_ACK;
+    YmodemSendCurrent(session);
+    session->stat_.blocks++;
+    YmodemSendPrefetch(session);
+}
+
+/**
+ * @brief 处理接收方发来的一个字节。
+ *
+ */
+static void YmodemSendSessionHandle(YmodemSendSession_t *session, uint8_t ch)
+{
+    if (ch == CAN) {
+        session->received_cancle_count_++;
+        if (session->received_cancle_count_ >= 2) {
+            YmodemSendSessionFinish(session, YMODEM_SESSION_RESULT_CANCLE);
+        }
+        return;
+    }
+    session->received_cancle_count_ = 0;
+
+    switch (session->state_) {
+        case YMODEM_SEND_WAIT_START:
+            if (ch == CNC) {
+                if (!YmodemSendPrepareHeader(session)) {
+                    YmodemSendSessionCancle(session);
+                    session->result_ = YMODEM_SESSION_RESULT_ERROR;
+                    break;
+                }
+                if (session->stat_.startTickMs == 0) {
+                    session->stat_.startTickMs = YMODEM_GET_MS_TICK();
+                }
+                session->retry_count_ = 0;
+                session->state_       = session->file_index_ < session->file_count_ ? YMODEM_SEND_WAIT_HEADER_ACK : YMODEM_SEND_WAIT_END_ACK;
+                YmodemSendCurrent(session);
+                // 等待文件头的ACK时读取第一个数据块
+                YmodemSendPrefetch(session);
+            }
+            break;
+        case YMODEM_SEND_WAIT_HEADER_ACK:
+            if (ch == ACK) {
+                session->retry_count_ = 0;
+                session->state_       = YMODEM_SEND_WAIT_DATA_START;
+            } else if (ch == NAK || ch == CNC) {
+                session->stat_.resends++;
+                YmodemSendCurrent(session);
+            }
+            break;
+        case YMODEM_SEND_WAIT_DATA_START:
+            if (ch == CNC) {
+                YmodemSendNextBlock(session);
+            }
+            break;
+        case YMODEM_SEND_WAIT_DATA_ACK:
+            if (ch == ACK) {
+                YmodemSendNextBlock(session);
+            } else if (ch == NAK || (ch == CNC && session->block_[session->cur_][1] == 1)) {
+                // 第一个数据块没有收到时接收方还会发送'C'
+                session->stat_.resends++;
+                YmodemSendCurrent(session);
+            }
+            break;
+        case YMODEM_SEND_WAIT_EOT_NAK:
+        case YMODEM_SEND_WAIT_EOT_ACK:
+            if (ch == NAK && session->state_ == YMODEM_SEND_WAIT_EOT_NAK) {
+                session->state_ = YMODEM_SEND_WAIT_EOT_ACK;
+                YmodemSendEOT(session);
+            } else if (ch == ACK) {
+                // 有的接收方第一个EOT就回复ACK
+                YmodemSourceClose(&session->source);
+                session->source_is_open_ = false;
+                session->stat_.files++;
+                session->stat_.bytes += session->file_size_;
+                session->file_index_++;
+                session->retry_count_ = 0;
+                session->state_       = YMODEM_SEND_WAIT_START;
+            }
+            break;
+        case YMODEM_SEND_WAIT_END_ACK:
+            if (ch == ACK) {
+                YmodemSendSessionFinish(session, YMODEM_SESSION_RESULT_OK);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void YmodemSendSessionPoll(YmodemSendSession_t *session)
+{
+    uint8_t ch = 0;
+
+    if (session == NULL || session->state_ == YMODEM_SESSION_CLOSED) {
+        return;
+    }
+    while (session->state_ != YMODEM_SESSION_CLOSED && session->read(&ch, 1) == 1) {
+        YmodemSendSessionHandle(session, ch);
+    }
+    if (session->state_ == YMODEM_SESSION_CLOSED) {
+        return;
+    }
+
+    if (YMODEM_GET_MS_TICK() - session->last_send_message_tick_ms_ > session->timeout_) {
+        if (session->retry_count_ >= session->retry_max_count_) {
+            YmodemSendSessionCancle(session);
+            session->result_ = YMODEM_SESSION_RESULT_TIMEOUT;
+            return;
+        }
+        session->retry_count_++;
+        session->last_send_message_tick_ms_ = YMODEM_GET_MS_TICK();
+        switch (session->state_) {
+            case YMODEM_SEND_WAIT_HEADER_ACK:
+            case YMODEM_SEND_WAIT_DATA_ACK:
+            case YMODEM_SEND_WAIT_END_ACK:
+                session->stat_.resends++;
+                YmodemSendCurrent(session);
+                break;
+            case YMODEM_SEND_WAIT_EOT_NAK:
+            case YMODEM_SEND_WAIT_EOT_ACK:
+                YmodemSendEOT(session);
+                break;
+            default:
+                // 等待'C'时不发送
+                break;
+        }
+    }
+}
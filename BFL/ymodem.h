@@ -63,6 +63,20 @@ typedef enum eYmodemSessionState_t {
     此时如果收到非空block0，则进入等待接收非空首部block0状态。
     */
     YMODEM_RECEIVE_WAIT_NEXT_FILE_OR_WAIT_END,
+    // 发送会话：等待接收方的'C'，然后发送文件头，没有文件了就发送空的文件头
+    YMODEM_SEND_WAIT_START,
+    // 等待文件头的ACK
+    YMODEM_SEND_WAIT_HEADER_ACK,
+    // 等待接收方的'C'，然后发送第一个数据块，空文件直接发送EOT
+    YMODEM_SEND_WAIT_DATA_START,
+    // 等待数据块的ACK，收到后发送已经读好的下一块，NAK重发当前块
+    YMODEM_SEND_WAIT_DATA_ACK,
+    // 等待第一个EOT的NAK，然后发送第二个EOT
+    YMODEM_SEND_WAIT_EOT_NAK,
+    // 等待第二个EOT的ACK，然后发送下一个文件
+    YMODEM_SEND_WAIT_EOT_ACK,
+    // 等待空文件头的ACK，结束会话
+    YMODEM_SEND_WAIT_END_ACK,
 } YmodemSessionState_t;
 
 typedef enum eYmodemSessionResult_t {
@@ -73,6 +87,23 @@ typedef enum eYmodemSessionResult_t {
     YMODEM_SESSION_RESULT_CANCLE,  // 取消
 } YmodemSessionResult_t;
 
+typedef enum eYmodemTarget_t {
+    YMODEM_TARGET_FATFS, // 保存为YMODEM_DRIVE中的文件
+    YMODEM_TARGET_RAW,   // 直接写入原始Flash分区（YMODEM_RAW_ADDR），用于固件镜像
+} YmodemTarget_t;
+
+typedef struct eYmodemSessionStat_t {
+    uint32_t blocks;      // 收到的有效数据块数，不包括重复的数据块
+    uint32_t bytes;       // 写入存储的字节数
+    uint32_t resumed;     // 续传时和已有数据相同、没有重新写入的字节数
+    uint32_t duplicates;  // 重复的数据块（发送方没有收到ACK）
+    uint32_t errors;      // 校验失败、不完整的帧，回复NAK
+    uint32_t overruns;    // 两个缓冲区都在使用时丢弃的字节数
+    uint32_t maxWriteUs;  // 一个数据块写入存储的最长时间
+    uint32_t startTickMs; // 收到第一个文件头的时间
+    uint32_t endTickMs;   // 会话结束的时间
+} YmodemSessionStat_t;
+
 typedef struct eYmodemSession_t {
     uint32_t timeout_;                   // 单次等待回复超时时间，单位毫秒
     uint32_t last_send_message_tick_ms_; // 时间戳，单位毫秒
@@ -83,31 +114,92 @@ typedef struct eYmodemSession_t {
     YmodemSessionState_t state_;         // 会话状态
     YmodemSessionResult_t result_;       // 会话结果
 
-    uint8_t buffer_[(1024 + (YMODEM_FRAME_HEADER_LEN + YMODEM_FRAME_CHECK_LEN))]; // 数据缓冲区
-    uint32_t buffer_size_;                                                        // 数据缓冲区当前元素个数
-    uint32_t last_read_tick_ms_;                                                  // 时间戳，单位毫秒
-    size_t (*read)(uint8_t *buffer, size_t size);                                 // 读数据
-    size_t (*write)(const uint8_t *buffer, size_t size);                          // 写数据
+    /*
+    接收双缓冲：一个缓冲区接收帧，另一个缓冲区中收完的帧在主循环中校验、回复ACK后写入存储，
+    写入期间发送方发来的下一帧直接放进空闲的缓冲区（串口中断调用YmodemReceiveSessionPushByte，
+    或者YmodemSessionPoll从read读取），不经过中间缓冲区，不靠空闲时间判断帧结束。
+    */
+    uint8_t block_[2][YMODEM_FRAME_SIZE_1K];          // 帧缓冲区
+    volatile uint32_t block_size_[2];                 // 缓冲区中完整的帧的长度，0表示空闲
+    volatile uint8_t ready_[2];                       // 收完的帧按顺序排队
+    volatile uint8_t ready_head_;                     // 下一个要处理的帧在ready_中的位置
+    volatile uint8_t ready_tail_;                     // 下一个收完的帧放在ready_中的位置
+    volatile int8_t rx_;                              // 正在接收的缓冲区，-1表示两个都在使用
+    volatile uint32_t buffer_size_;                   // 正在接收的帧已经收到的字节数
+    volatile uint32_t frame_size_;                    // 正在接收的帧的长度
+    volatile uint32_t last_read_tick_ms_;             // 时间戳，单位毫秒
+    size_t (*read)(uint8_t *buffer, size_t size);     // 读数据，为NULL时由YmodemReceiveSessionPushByte送入数据
+    size_t (*write)(const uint8_t *buffer, size_t size); // 写数据
 
     char file_name_[YMODEM_FRAME_SIZE_128 + 1]; // 文件名
-    uint32_t file_size_;                        // 文件大小,单位字节
+    uint32_t file_size_;                        // 文件大小,单位字节，0表示发送方没有给出
     uint32_t file_offset_;                      // 文件偏移量
+    uint32_t resume_offset_;                    // 已有数据的长度，之前的数据块和已有数据比较
+    uint32_t unsynced_;                         // 上次同步以来写入的字节数
+    YmodemTarget_t target_;                     // 保存到哪里
     YmodemFile_t file;                          // 文件指针
     bool file_is_open_;                         // 文件是否打开
+    YmodemSessionStat_t stat_;                  // 统计
 } YmodemSession_t;
 
+typedef struct eYmodemSendStat_t {
+    uint32_t files;       // 发送完成的文件数
+    uint32_t blocks;      // 发送的数据块数，不包括重发
+    uint32_t bytes;       // 发送完成的文件的字节数
+    uint32_t resends;     // 重发的帧数（NAK、超时）
+    uint32_t readUs;      // 从存储读取数据的总时间
+    uint32_t maxReadUs;   // 读取一个数据块的最长时间
+    uint32_t startTickMs; // 发送第一个文件头的时间
+    uint32_t endTickMs;   // 会话结束的时间
+} YmodemSendStat_t;
+
+typedef struct eYmodemSendSession_t {
+    uint32_t timeout_;                   // 单次等待回复超时时间，单位毫秒
+    uint32_t last_send_message_tick_ms_; // 时间戳，单位毫秒
+    uint8_t retry_count_;                // 当前重试次数
+    uint8_t retry_max_count_;            // 最大重试次数
+    uint8_t received_cancle_count_;      // 是否收到了取消命令
+    YmodemSessionState_t state_;         // 会话状态
+    YmodemSessionResult_t result_;       // 会话结果
+
+    /*
+    发送双缓冲：一个缓冲区是正在发送、等待ACK的帧，NAK或者超时时原样重发；发送之后马上把下一块读到另一个缓冲区、
+    算好CRC，串口在后台发送当前帧的同时读取存储，收到ACK后立即发送下一帧。
+    */
+    uint8_t block_[2][YMODEM_FRAME_SIZE_1K];             // 完整的帧
+    uint32_t block_size_[2];                             // 帧长度，0表示没有
+    uint8_t cur_;                                        // 正在发送的帧所在的缓冲区
+    uint8_t sequence_;                                   // 下一个读取的数据块的编号
+    size_t (*read)(uint8_t *buffer, size_t size);        // 读数据
+    size_t (*write)(const uint8_t *buffer, size_t size); // 写数据
+
+    const YmodemSendFile_t *files_; // 要发送的文件
+    uint32_t file_count_;           // 文件数
+    uint32_t file_index_;           // 正在发送的文件
+    YmodemSource_t source;          // 正在发送的文件
+    bool source_is_open_;           // 文件是否打开
+    uint32_t file_size_;            // 文件大小，单位字节
+    uint32_t read_offset_;          // 下一次读取的位置
+    YmodemSendStat_t stat_;         // 统计
+} YmodemSendSession_t;
+
 /**
- * @brief 打开一个发送会话。
+ * @brief 打开一个接收会话，接收的文件保存到YMODEM_DRIVE。
  *
  * @param session
+ * @param read 读取串口数据，为NULL时在串口中断中调用YmodemReceiveSessionPushByte送入数据。
+ * @param write 发送数据。
  * @return true 打开成功。
  * @return false 打开失败。
  */
 bool YmodemReceiveSessionOpen(YmodemSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size));
+bool YmodemReceiveSessionOpenTarget(YmodemSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size),
+                                    YmodemTarget_t target);
 void YmodemReceiveSessionCancle(YmodemSession_t *session);
 void YmodemReceiveSessionInit(YmodemSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size));
+void YmodemReceiveSessionPushByte(YmodemSession_t *session, uint8_t ch);
 /**
- * @brief 时间轮询，负责处理超时重试。
+ * @brief 时间轮询，负责处理收到的帧、写入存储和超时重试。
  *
  * @param session
  */
@@ -115,6 +207,31 @@ void YmodemSessionPoll(YmodemSession_t *session);
 
 YmodemSessionResult_t YmodemSessionGetResult(YmodemSession_t *session);
 void YmodemSessionClearResult(YmodemSession_t *session);
+void YmodemSessionGetStat(YmodemSession_t *session, YmodemSessionStat_t *pStat);
+
+/**
+ * @brief 打开一个发送会话，一次发送files中的所有文件，之后调用YmodemSendSessionPoll直到YmodemSendSessionGetResult不为NONE。
+ *
+ * @param session
+ * @param read 读取串口数据。
+ * @param write 发送数据。
+ * @param files 要发送的文件，会话结束之前要保持有效。
+ * @param count 文件数。
+ * @return true 打开成功。
+ * @return false 打开失败。
+ */
+bool YmodemSendSessionOpen(YmodemSendSession_t *session, size_t (*read)(uint8_t *buf, size_t size), size_t (*write)(const uint8_t *buf, size_t size),
+                           const YmodemSendFile_t *files, uint32_t count);
+void YmodemSendSessionCancle(YmodemSendSession_t *session);
+/**
+ * @brief 时间轮询，负责处理接收方的应答、发送帧、读取下一块和超时重发。
+ *
+ * @param session
+ */
+void YmodemSendSessionPoll(YmodemSendSession_t *session);
+YmodemSessionResult_t YmodemSendSessionGetResult(YmodemSendSession_t *session);
+void YmodemSendSessionClearResult(YmodemSendSession_t *session);
+void YmodemSendSessionGetStat(YmodemSendSession_t *session, YmodemSendStat_t *pStat);
 
 typedef enum {
     YMODEM_MESSAGE_TYPE_128_BLOCK,     // 128字节的数据块
@@ -9,8 +9,9 @@
  * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
  *
  */
-#include "Ymodem_if_prototype.h"
+#include "ymodem_if_prototype.h"
 #include <stdio.h>
+#include <string.h>
 #include "HDL_CPU_Time.h"
 
 bool YmodemIsFileExist(const char *file_name)
@@ -18,7 +19,7 @@ bool YmodemIsFileExist(const char *file_name)
     FRESULT res;
     FILINFO fno;
     char path[256];
-    snprintf(path, sizeof(path), "0:%s", file_name);
+    snprintf(path, sizeof(path), YMODEM_DRIVE "%s", file_name);
     res = f_stat(path, &fno);
     if (res == FR_OK) {
         return true;
@@ -37,7 +38,7 @@ bool YmodemFileRemove(const char *file_name)
 {
     FRESULT res;
     char path[256];
-    snprintf(path, sizeof(path), "0:%s", file_name);
+    snprintf(path, sizeof(path), YMODEM_DRIVE "%s", file_name);
     res = f_unlink(path);
     if (res == FR_OK) {
         return true;
@@ -58,9 +59,10 @@ bool YmodemFileOpen(YmodemFile_t *pFILE, const char *file_name)
     FIL *pFile = &pFILE->file;
     FRESULT res;
     char path[256];
-    snprintf(path, sizeof(path), "0:%s", file_name);
+    snprintf(path, sizeof(path), YMODEM_DRIVE "%s", file_name);
 
-    res = f_open(pFile, path, FA_OPEN_APPEND | FA_WRITE | FA_READ);
+    pFILE->raw = false;
+    res        = f_open(pFile, path, FA_OPEN_APPEND | FA_WRITE | FA_READ);
     if (res == FR_OK) {
         return true;
     } else {
@@ -68,6 +70,67 @@ bool YmodemFileOpen(YmodemFile_t *pFILE, const char *file_name)
     }
 }
 
+bool YmodemRawOpen(YmodemFile_t *pFILE, uint32_t size, uint32_t committed)
+{
+    if (size > YMODEM_RAW_SIZE || committed > size) {
+        return false;
+    }
+    pFILE->raw     = true;
+    pFILE->rawSize = committed;
+    // committed所在的page已经擦除过，committed之后还没有编程
+    pFILE->rawErased = (committed + HDL_FLASH_SECTOR_SIZE - 1) / HDL_FLASH_SECTOR_SIZE * HDL_FLASH_SECTOR_SIZE;
+    return true;
+}
+
+/**
+ * @brief 在原始分区末尾写入。进入一个新的page时先擦除，之后直接按双字编程，不读出、不重复擦除；
+ * 末尾不足双字的部分补0xFF。截断后从page中间写入时按读出、修改、擦除、写回的方式写入这个page。
+ *
+ * @return uint32_t 写入的字节数。
+ */
+static uint32_t YmodemRawAppend(YmodemFile_t *pFILE, const uint8_t *data, uint32_t size)
+{
+    uint8_t tail[HDL_FLASH_PROGRAMM_BYTE_WIDTHT];
+    uint32_t offset = pFILE->rawSize;
+    uint32_t done   = 0;
+
+    if (size > YMODEM_RAW_SIZE - offset) {
+        return 0;
+    }
+    while (done < size) {
+        uint32_t pageEnd = (offset / HDL_FLASH_SECTOR_SIZE + 1) * HDL_FLASH_SECTOR_SIZE;
+        uint32_t n       = pageEnd - offset < size - done ? pageEnd - offset : size - done;
+        uint32_t aligned = n / HDL_FLASH_PROGRAMM_BYTE_WIDTHT * HDL_FLASH_PROGRAMM_BYTE_WIDTHT;
+        int status       = 0;
+
+        if (offset >= pFILE->rawErased && offset % HDL_FLASH_SECTOR_SIZE == 0) {
+            status           = HDL_Flash_erase_one_sector(HDL_SECTOR_OF_ADDRESS(YMODEM_RAW_ADDR + offset));
+            pFILE->rawErased = pageEnd;
+        }
+        if (status != 0) {
+            break;
+        }
+        if (offset < pFILE->rawErased && offset % HDL_FLASH_PROGRAMM_BYTE_WIDTHT == 0) {
+            status = HDL_Flash_program_nocheck(YMODEM_RAW_ADDR + offset, data + done, aligned);
+            if (status == 0 && aligned < n) {
+                memset(tail, 0xFF, sizeof(tail));
+                memcpy(tail, data + done + aligned, n - aligned);
+                status = HDL_Flash_program_nocheck(YMODEM_RAW_ADDR + offset + aligned, tail, sizeof(tail));
+            }
+        } else {
+            status           = HDL_Flash_write(YMODEM_RAW_ADDR + offset, (uint8_t *)data + done, n);
+            pFILE->rawErased = offset + n;
+        }
+        if (status != 0) {
+            break;
+        }
+        offset += n;
+        done += n;
+    }
+    pFILE->rawSize = offset;
+    return done;
+}
+
 /**
  * @brief
  *
@@ -81,6 +144,13 @@ uint32_t YmodemFileAppend(YmodemFile_t *pFILE, uint8_t *data, uint32_t size)
     FIL *pFile = &pFILE->file;
     UINT bw;
     FRESULT res;
+    if (pFILE->raw) {
+        return YmodemRawAppend(pFILE, data, size);
+    }
+    // 续传时比较过已有的数据，文件位置可能不在末尾
+    if (f_tell(pFile) != f_size(pFile) && f_lseek(pFile, f_size(pFile)) != FR_OK) {
+        return 0;
+    }
     res = f_write(pFile, data, size, &bw);
     if (res == FR_OK) {
         return bw;
@@ -90,16 +160,65 @@ uint32_t YmodemFileAppend(YmodemFile_t *pFILE, uint8_t *data, uint32_t size)
 }
 
 /**
- * @brief 关闭文件。这个方法要保证传入NULL能够识别返回成功。
+ * @brief 从文件的offset处读取数据，用于续传时比较已有的数据。
  *
  * @param pFILE
- * @return true 成功。
- * @return false 失败。
+ * @param offset
+ * @param buf
+ * @param size
+ * @return uint32_t 读到的字节数。
  */
+uint32_t YmodemFileReadAt(YmodemFile_t *pFILE, uint32_t offset, uint8_t *buf, uint32_t size)
+{
+    FIL *pFile = &pFILE->file;
+    UINT br    = 0;
+
+    if (pFILE->raw) {
+        if (offset > pFILE->rawSize || size > pFILE->rawSize - offset) {
+            return 0;
+        }
+        return HDL_Flash_read(YMODEM_RAW_ADDR + offset, buf, size) < 0 ? 0 : size;
+    }
+    if (f_lseek(pFile, offset) != FR_OK || f_read(pFile, buf, size, &br) != FR_OK) {
+        return 0;
+    }
+    return br;
+}
+
+bool YmodemFileTruncate(YmodemFile_t *pFILE, uint32_t size)
+{
+    FIL *pFile = &pFILE->file;
+
+    if (pFILE->raw) {
+        if (size < pFILE->rawSize) {
+            // size之后的数据已经编程，再写入时需要先擦除
+            pFILE->rawSize   = size;
+            pFILE->rawErased = size;
+        }
+        return true;
+    }
+    if (f_lseek(pFile, size) != FR_OK) {
+        return false;
+    }
+    return f_truncate(pFile) == FR_OK;
+}
+
+bool YmodemFileSync(YmodemFile_t *pFILE)
+{
+    if (pFILE->raw) {
+        return true;
+    }
+    return f_sync(&pFILE->file) == FR_OK;
+}
+
 bool YmodemFileClose(YmodemFile_t *pFILE)
 {
     FIL *pFile = &pFILE->file;
     FRESULT res;
+    if (pFILE->raw) {
+        pFILE->raw = false;
+        return true;
+    }
     res = f_close(pFile);
     if (res == FR_OK) {
         return true;
@@ -112,6 +231,50 @@ uint32_t YmodemFileGetSize(YmodemFile_t *pFILE)
 {
     FIL *pFile = &pFILE->file;
     FSIZE_t res;
+    if (pFILE->raw) {
+        return pFILE->rawSize;
+    }
     res = f_size(pFile);
     return res;
-}
\ No newline at end of file
+}
+
+bool YmodemSourceOpen(YmodemSource_t *pSrc, const YmodemSendFile_t *pFile, uint32_t *pSize)
+{
+    pSrc->type = pFile->type;
+    if (pFile->type == YMODEM_SOURCE_QFS) {
+        CHIP_W25Q512_QFS_snapshot(&pSrc->qfs);
+        *pSize = pSrc->qfs.byte_size;
+        return true;
+    }
+    if (f_open(&pSrc->file, pFile->path, FA_READ) != FR_OK) {
+        return false;
+    }
+    *pSize = (uint32_t)f_size(&pSrc->file);
+    return true;
+}
+
+uint32_t YmodemSourceRead(YmodemSource_t *pSrc, uint32_t offset, uint8_t *buf, uint32_t size)
+{
+    FIL *pFile = &pSrc->file;
+    UINT br    = 0;
+
+    if (pSrc->type == YMODEM_SOURCE_QFS) {
+        return CHIP_W25Q512_QFS_snapshot_read(&pSrc->qfs, offset, buf, size);
+    }
+    // 顺序读取时文件位置已经在offset，不需要移动
+    if (f_tell(pFile) != offset && f_lseek(pFile, offset) != FR_OK) {
+        return 0;
+    }
+    if (f_read(pFile, buf, size, &br) != FR_OK) {
+        return 0;
+    }
+    return br;
+}
+
+bool YmodemSourceClose(YmodemSource_t *pSrc)
+{
+    if (pSrc->type == YMODEM_SOURCE_QFS) {
+        return true;
+    }
+    return f_close(&pSrc->file) == FR_OK;
+}
@@ -20,14 +20,57 @@ extern "C" {
 #include <stddef.h>
 
 #include "ff.h"
+#include "HDL_Flash.h"
+#include "CHIP_W25Q512_QueueFileSystem.h"
 typedef struct tagYmodemFile_t {
     FIL file;
+    bool raw;           // 写入片内Flash的原始分区，不经过FatFs
+    uint32_t rawSize;   // 原始分区中已经写入的长度
+    uint32_t rawErased; // 原始分区中从这里开始的page还没有擦除
 } YmodemFile_t;
 
+typedef enum eYmodemSourceType_t {
+    YMODEM_SOURCE_FATFS, // FatFs文件
+    YMODEM_SOURCE_QFS,   // W25Q512队列文件系统中的数据（MQTT溢出的记录），发送打开时的快照，不出队
+} YmodemSourceType_t;
+
+/**
+ * @brief 发送会话中的一个文件。
+ *
+ */
+typedef struct tagYmodemSendFile_t {
+    YmodemSourceType_t type;
+    const char *path; // FatFs：文件路径，例如"1:20240301.txt"，发送时去掉盘符和目录；QFS：发送的文件名
+} YmodemSendFile_t;
+
+typedef struct tagYmodemSource_t {
+    YmodemSourceType_t type;
+    FIL file;
+    QFSSnapshot_t qfs;
+} YmodemSource_t;
+
+#ifdef YMODEM_SIMULATION
+// 上位机仿真时使用虚拟时钟，由仿真程序推进
+extern uint32_t ymodem_sim_tick;
+#define YMODEM_GET_MS_TICK() ymodem_sim_tick
+#else
 #include "HDL_CPU_Time.h"
-#define YMODEM_GET_MS_TICK()  HDL_CPU_Time_GetTick()
+#define YMODEM_GET_MS_TICK() HDL_CPU_Time_GetTick()
+#endif
+// YmodemReceiveSessionPushByte在串口中断中调用时，主循环修改接收状态需要关中断
+#define YMODEM_ENTER_CRITICAL() __disable_irq()
+#define YMODEM_EXIT_CRITICAL()  __enable_irq()
 
+// 接收的文件保存到的盘符
+#define YMODEM_DRIVE          "0:"
 #define YMODEM_FILE_OVERWRITE (0x01)
+// 断点续传：同名文件已经存在且比要接收的文件短时，已有的部分和重新发来的数据相同就不再写入
+#define YMODEM_RESUME         (0x01)
+// 写入FatFs文件时每隔多少字节同步一次，掉电后目录项中的长度就是续传的起点
+#define YMODEM_SYNC_BYTES     (32UL * 1024)
+// 原始分区：片内Flash的BANK2，用于接收固件镜像
+#define YMODEM_RAW_ADDR       (HDL_FLASH_BASE_ADDR + HDL_FLASH_SIZE / 2)
+#define YMODEM_RAW_SIZE       (HDL_FLASH_SIZE / 2)
 #ifdef __cplusplus
 }
 #endif
@@ -39,6 +39,17 @@ bool YmodemFileRemove(const char *file_name);
  */
 bool YmodemFileOpen(YmodemFile_t *pFILE, const char *file_name);
 
+/**
+ * @brief 打开原始分区，之后的写入从分区的committed处开始。
+ *
+ * @param pFILE
+ * @param size 要写入的长度，不能超过YMODEM_RAW_SIZE。
+ * @param committed 已经写入的长度，续传时使用，否则为0。
+ * @return true 成功。
+ * @return false 分区放不下。
+ */
+bool YmodemRawOpen(YmodemFile_t *pFILE, uint32_t size, uint32_t committed);
+
 /**
  * @brief
  *
@@ -49,6 +60,36 @@ bool YmodemFileOpen(YmodemFile_t *pFILE, const char *file_name);
  */
 uint32_t YmodemFileAppend(YmodemFile_t *pFILE, uint8_t *data, uint32_t size);
 
+/**
+ * @brief 从文件的offset处读取数据，不影响之后的追加写入。
+ *
+ * @param pFILE
+ * @param offset
+ * @param buf
+ * @param size
+ * @return uint32_t 读到的字节数。
+ */
+uint32_t YmodemFileReadAt(YmodemFile_t *pFILE, uint32_t offset, uint8_t *buf, uint32_t size);
+
+/**
+ * @brief 把文件截断到size，之后从size处追加写入。
+ *
+ * @param pFILE
+ * @param size
+ * @return true 成功。
+ * @return false 失败。
+ */
+bool YmodemFileTruncate(YmodemFile_t *pFILE, uint32_t size);
+
+/**
+ * @brief 把已经写入的数据和文件长度写入存储。
+ *
+ * @param pFILE
+ * @return true 成功。
+ * @return false 失败。
+ */
+bool YmodemFileSync(YmodemFile_t *pFILE);
+
 /**
  * @brief 关闭文件。这个方法要保证传入NULL能够识别返回成功。
  *
@@ -65,6 +106,30 @@ bool YmodemFileClose(YmodemFile_t *pFILE);
  * @return uint32_t 文件大小。失败返回0。
  */
 uint32_t YmodemFileGetSize(YmodemFile_t *pFILE);
+
+/**
+ * @brief 打开要发送的文件。QFS在这时记录快照，之后写入的数据不发送。
+ *
+ * @param pSrc
+ * @param pFile
+ * @param pSize 文件大小。
+ * @return true 成功。
+ * @return false 失败。
+ */
+bool YmodemSourceOpen(YmodemSource_t *pSrc, const YmodemSendFile_t *pFile, uint32_t *pSize);
+
+/**
+ * @brief 读取要发送的文件offset处的数据。
+ *
+ * @param pSrc
+ * @param offset
+ * @param buf
+ * @param size
+ * @return uint32_t 读到的字节数。
+ */
+uint32_t YmodemSourceRead(YmodemSource_t *pSrc, uint32_t offset, uint8_t *buf, uint32_t size);
+
+bool YmodemSourceClose(YmodemSource_t *pSrc);
 #ifdef __cplusplus
 }
 #endif
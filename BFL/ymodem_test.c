@@ -1,6 +1,873 @@
-#include "Ymodem.h"
+/**
+ * @file ymodem_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief Ymodem测试：先检查查表计算的CRC16和逐位计算的结果相同。
+ * 定义YMODEM_SIMULATION时用虚拟时间测试会话：串口按115200 8N1逐字节送到接收方，存储时间由pHooks提供，
+ * 测试中的发送方按协议一帧一帧发送、等待应答。
+ * 检查串口中断送入数据（双缓冲，写入期间接收下一帧）和轮询读取200字节串口缓冲区两种方式、一次发送多个文件、
+ * 校验错误重发、ACK丢失后的重复数据块、中断后续传（已有数据相同和不同）、写入片内Flash的原始分区，
+ * 并和线路速率比较吞吐量。
+ * 发送会话和接收会话接在同一条线路上，一次发送SD卡中的多个文件和QFS的快照，检查内容、校验错误重发、接收方取消和没有接收方时超时，
+ * 并统计总的传输时间。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
 #include <stdio.h>
+#include <string.h>
+#include "ymodem_test.h"
+#include "ff.h"
+#include "CHIP_W25Q512_QueueFileSystem.h"
+#include "crc.h"
+#include "HDL_CPU_Time.h"
+#include "log.h"
 
-int main()
+static uint8_t _gCrcBuf[1024];
+static uint32_t _gErrorCnt = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[Ymodem Test] check failed: %s", what);
+    }
+}
+
+static void crc_test()
+{
+    uint16_t crc = 0;
+
+    check(CRC16_CCITT_Update(CRC16_CCITT_XMODEM_INIT, (const uint8_t *)"123456789", 9) == 0x31C3, "crc16 xmodem check value");
+    for (uint32_t i = 0; i < sizeof(_gCrcBuf); i++) {
+        _gCrcBuf[i] = (uint8_t)(i * 131U + (i >> 9) + 7U);
+        crc ^= (uint16_t)_gCrcBuf[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    check(CRC16_CCITT_Update(CRC16_CCITT_XMODEM_INIT, _gCrcBuf, sizeof(_gCrcBuf)) == crc, "crc16 matches bitwise reference");
+}
+
+#ifdef YMODEM_SIMULATION
+// 115200 8N1一个字节的时间，ns
+#define BYTE_NS           (10ULL * 1000000000ULL / 115200ULL)
+// 主循环一次的时间（没有写入存储时），ns
+#define LOOP_NS           50000ULL
+// 目标板COM1的接收缓冲区大小
+#define UART_RING_SIZE    200U
+// 发送方等待应答的超时时间，ns
+#define SENDER_TIMEOUT_NS 1000000000ULL
+#define LINE_MAX          (YMODEM_FRAME_SIZE_1K * 2)
+
+#define SOH 0x01
+#define STX 0x02
+#define EOT 0x04
+#define ACK 0x06
+#define NAK 0x15
+#define CAN 0x18
+#define CNC 0x43
+
+typedef enum {
+    SENDER_WAIT_C,      // 等待'C'，然后发送文件头（或者空文件头结束）
+    SENDER_WAIT_HEADER_ACK,
+    SENDER_WAIT_DATA_C, // 文件头的ACK之后等待'C'
+    SENDER_WAIT_ACK,    // 等待数据块的ACK
+    SENDER_WAIT_EOT_NAK,
+    SENDER_WAIT_EOT_ACK,
+    SENDER_WAIT_END_ACK,
+    SENDER_DONE,
+} SenderState_t;
+
+typedef struct {
+    const char *name;
+    uint32_t size;
+    uint32_t seed; // 内容
+} SimFile_t;
+
+typedef struct {
+    const SimFile_t *files;
+    uint32_t fileCnt;
+    uint32_t file;       // 正在发送的文件
+    uint32_t block;      // 正在发送的数据块，从1开始
+    SenderState_t state;
+    uint64_t sentNs;     // 最后一次发送的时间
+    uint32_t corruptAt;  // 第一次发送这一块时破坏一个字节，0表示不破坏
+    uint32_t dropAckAt;  // 丢弃这一块的第一个ACK，0表示不丢弃
+    uint32_t stopAt;     // 发送到这一块时停止发送，模拟线路断开，0表示不停止
+    uint32_t resends;
+    uint64_t nowNs;      // 发送方的时间
+    bool dropHeaderAck;  // 丢弃文件头的第一个ACK
+    uint32_t loseAt;     // 第一次发送这一块时整帧丢失，0表示不丢失
+    uint32_t eotAt;      // 发完这一块就发送EOT，文件头中的大小不变，0表示发完整个文件
+    uint64_t timeoutNs;  // 等待数据块ACK的超时
+} Sender_t;
+
+// 下一次run的附加故障，run开始时复制到发送方后清除
+typedef struct {
+    bool dropHeaderAck;
+    uint32_t loseAt;
+    uint32_t eotAt;
+    uint64_t timeoutNs; // 0表示SENDER_TIMEOUT_NS
+} Fault_t;
+
+typedef struct {
+    uint8_t data[LINE_MAX];
+    uint64_t at[LINE_MAX]; // 到达时间
+    uint32_t head;
+    uint32_t tail;
+    uint64_t freeNs;       // 线路空闲的时间
+} Line_t;
+
+uint32_t ymodem_sim_tick = 0;
+
+static const Ymodem_TestHooks_t *_gHooks = NULL;
+static YmodemSession_t _gSession;
+static YmodemSendSession_t _gSend;
+static Sender_t _gSender;
+static Fault_t _gFault;
+static Line_t _gToRx;  // 发送方到接收方
+static Line_t _gToTx;  // 接收方到发送方
+static uint64_t _gNowNs;
+static bool _gIsrMode;
+static uint8_t _gRing[UART_RING_SIZE];
+static uint32_t _gRingHead;
+static uint32_t _gRingCnt;
+static uint32_t _gRingDrops;
+static uint32_t _gRxBytes;
+static uint32_t _gCorruptByte = UINT32_MAX; // 接收方收到的第几个字节被破坏
+static uint8_t _gFrame[YMODEM_FRAME_SIZE_1K];
+static uint8_t _gBuf[1024];
+static FIL _gFile;
+
+// 接收方写入存储的时间，没有模型时是实际经过的时间
+static uint64_t flash_ns()
+{
+    if (_gHooks == NULL) {
+        return HDL_CPU_Time_GetUsTick64() * 1000ULL;
+    }
+    return _gHooks->flash_ns();
+}
+
+// 目标板上Flash按实际时间工作，不需要推进
+static void flash_elapse(uint64_t ns)
+{
+    if (_gHooks != NULL) {
+        _gHooks->elapse(ns);
+    }
+}
+
+// 文件中第pos个字节
+static uint8_t pattern(uint32_t seed, uint32_t pos)
+{
+    return (uint8_t)(pos * 131U + (pos >> 9) + seed);
+}
+
+static void line_put(Line_t *line, uint64_t nowNs, const uint8_t *data, uint32_t size)
+{
+    uint64_t t = line->freeNs > nowNs ? line->freeNs : nowNs;
+
+    for (uint32_t i = 0; i < size && line->tail - line->head < LINE_MAX; i++) {
+        t += BYTE_NS;
+        line->data[line->tail % LINE_MAX] = data[i];
+        line->at[line->tail % LINE_MAX]   = t;
+        line->tail++;
+    }
+    line->freeNs = t;
+}
+
+static bool line_get(Line_t *line, uint8_t *ch, uint64_t *pAtNs)
+{
+    if (line->head == line->tail || line->at[line->head % LINE_MAX] > _gNowNs) {
+        return false;
+    }
+    *ch    = line->data[line->head % LINE_MAX];
+    *pAtNs = line->at[line->head % LINE_MAX];
+    line->head++;
+    return true;
+}
+
+static size_t rx_write(const uint8_t *buf, size_t size)
+{
+    line_put(&_gToTx, _gNowNs, buf, (uint32_t)size);
+    return size;
+}
+
+static size_t rx_read(uint8_t *buf, size_t size)
+{
+    size_t n = 0;
+
+    while (n < size && _gRingCnt > 0) {
+        buf[n++] = _gRing[_gRingHead];
+        _gRingHead = (_gRingHead + 1) % UART_RING_SIZE;
+        _gRingCnt--;
+    }
+    return n;
+}
+
+/**
+ * @brief 到达接收方的字节：中断方式直接送入会话，轮询方式放进串口缓冲区，满了丢弃。
+ *
+ */
+static void deliver_to_rx()
+{
+    uint8_t ch;
+    uint64_t atNs;
+
+    while (line_get(&_gToRx, &ch, &atNs)) {
+        if (_gRxBytes++ == _gCorruptByte) {
+            ch ^= 0x55;
+        }
+        if (_gIsrMode) {
+            YmodemReceiveSessionPushByte(&_gSession, ch);
+        } else if (_gRingCnt < UART_RING_SIZE) {
+            _gRing[(_gRingHead + _gRingCnt) % UART_RING_SIZE] = ch;
+            _gRingCnt++;
+        } else {
+            _gRingDrops++;
+        }
+    }
+}
+
+static size_t tx_write(const uint8_t *buf, size_t size)
+{
+    line_put(&_gToRx, _gNowNs, buf, (uint32_t)size);
+    return size;
+}
+
+static size_t tx_read(uint8_t *buf, size_t size)
+{
+    size_t n = 0;
+    uint64_t atNs;
+
+    while (n < size && line_get(&_gToTx, buf + n, &atNs)) {
+        n++;
+    }
+    return n;
+}
+
+static void sender_frame(uint8_t seq, const uint8_t *payload, uint32_t size)
+{
+    uint16_t crc;
+
+    _gFrame[0] = size == 128 ? SOH : STX;
+    _gFrame[1] = seq;
+    _gFrame[2] = (uint8_t)~seq;
+    memcpy(_gFrame + 3, payload, size);
+    crc                   = CRC16_CCITT_Update(CRC16_CCITT_XMODEM_INIT, payload, size);
+    _gFrame[3 + size]     = (uint8_t)(crc >> 8);
+    _gFrame[3 + size + 1] = (uint8_t)crc;
+}
+
+static void sender_send_header()
+{
+    uint8_t payload[128];
+
+    memset(payload, 0, sizeof(payload));
+    if (_gSender.file < _gSender.fileCnt) {
+        const SimFile_t *f = &_gSender.files[_gSender.file];
+        int n              = snprintf((char *)payload, sizeof(payload), "%s", f->name);
+        snprintf((char *)payload + n + 1, sizeof(payload) - n - 1, "%u", f->size);
+    }
+    sender_frame(0, payload, sizeof(payload));
+    line_put(&_gToRx, _gSender.nowNs, _gFrame, 133);
+    _gSender.sentNs = _gSender.nowNs;
+}
+
+static void sender_send_block(bool first)
+{
+    const SimFile_t *f = &_gSender.files[_gSender.file];
+    uint32_t offset    = (_gSender.block - 1) * 1024U;
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        _gBuf[i] = offset + i < f->size ? pattern(f->seed, offset + i) : 0x1A;
+    }
+    sender_frame((uint8_t)_gSender.block, _gBuf, 1024);
+    if (first && _gSender.block == _gSender.corruptAt) {
+        _gFrame[500] ^= 0x5A;
+    }
+    if (first && _gSender.block == _gSender.loseAt) {
+        _gSender.sentNs = _gSender.nowNs;
+        return;
+    }
+    line_put(&_gToRx, _gSender.nowNs, _gFrame, YMODEM_FRAME_SIZE_1K);
+    _gSender.sentNs = _gSender.nowNs;
+}
+
+static uint32_t sender_blocks()
+{
+    uint32_t blocks = (_gSender.files[_gSender.file].size + 1023U) / 1024U;
+
+    return _gSender.eotAt != 0 && _gSender.eotAt < blocks ? _gSender.eotAt : blocks;
+}
+
+static void sender_next_block()
+{
+    if (_gSender.block >= sender_blocks()) {
+        const uint8_t eot = EOT;
+        line_put(&_gToRx, _gSender.nowNs, &eot, 1);
+        _gSender.sentNs = _gSender.nowNs;
+        _gSender.state  = SENDER_WAIT_EOT_NAK;
+        return;
+    }
+    _gSender.block++;
+    if (_gSender.block == _gSender.stopAt) {
+        _gSender.state = SENDER_DONE;
+        return;
+    }
+    sender_send_block(true);
+    _gSender.state = SENDER_WAIT_ACK;
+}
+
+/**
+ * @brief 发送方处理收到的一个字节。
+ *
+ */
+static void sender_on_byte(uint8_t ch)
+{
+    const uint8_t eot = EOT;
+
+    switch (_gSender.state) {
+        case SENDER_WAIT_C:
+            if (ch == CNC) {
+                sender_send_header();
+                _gSender.state = _gSender.file < _gSender.fileCnt ? SENDER_WAIT_HEADER_ACK : SENDER_WAIT_END_ACK;
+            }
+            break;
+        case SENDER_WAIT_HEADER_ACK:
+            if (ch == ACK) {
+                if (_gSender.dropHeaderAck) {
+                    _gSender.dropHeaderAck = false;
+                    break;
+                }
+                _gSender.state = SENDER_WAIT_DATA_C;
+            } else if (ch == NAK) {
+                sender_send_header();
+            }
+            break;
+        case SENDER_WAIT_DATA_C:
+            if (ch == CNC) {
+                _gSender.block = 0;
+                sender_next_block();
+            }
+            break;
+        case SENDER_WAIT_ACK:
+            if (ch == ACK) {
+                if (_gSender.block == _gSender.dropAckAt) {
+                    _gSender.dropAckAt = 0;
+                    break;
+                }
+                sender_next_block();
+            } else if (ch == NAK || (ch == CNC && _gSender.block == 1)) {
+                // 第一个数据块没有收到时接收方还会发送'C'
+                _gSender.resends++;
+                sender_send_block(false);
+            }
+            break;
+        case SENDER_WAIT_EOT_NAK:
+            if (ch == NAK) {
+                line_put(&_gToRx, _gSender.nowNs, &eot, 1);
+                _gSender.sentNs = _gSender.nowNs;
+                _gSender.state  = SENDER_WAIT_EOT_ACK;
+            }
+            break;
+        case SENDER_WAIT_EOT_ACK:
+            if (ch == ACK) {
+                _gSender.file++;
+                _gSender.state = SENDER_WAIT_C;
+            }
+            break;
+        case SENDER_WAIT_END_ACK:
+            if (ch == ACK) {
+                _gSender.state = SENDER_DONE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void sender_poll()
+{
+    uint8_t ch;
+
+    // 发送方收到应答后立即发送，不等接收方的主循环
+    while (line_get(&_gToTx, &ch, &_gSender.nowNs)) {
+        sender_on_byte(ch);
+    }
+    _gSender.nowNs = _gNowNs;
+    // 没有收到应答，重发数据块
+    if (_gSender.state == SENDER_WAIT_ACK && _gNowNs - _gSender.sentNs > _gSender.timeoutNs) {
+        _gSender.resends++;
+        sender_send_block(false);
+    }
+    if (_gSender.state == SENDER_WAIT_HEADER_ACK && _gNowNs - _gSender.sentNs > _gSender.timeoutNs) {
+        _gSender.resends++;
+        sender_send_header();
+    }
+}
+
+typedef struct {
+    YmodemSessionResult_t result;
+    YmodemSessionStat_t stat;
+    uint64_t elapsedNs;
+    uint64_t storageNs;
+    uint32_t ringDrops;
+    uint32_t resends;
+} RunResult_t;
+
+/**
+ * @brief 运行一次接收会话，直到会话结束。
+ *
+ */
+static void run(const SimFile_t *files, uint32_t fileCnt, YmodemTarget_t target, bool isrMode, uint32_t corruptAt,
+                uint32_t dropAckAt, uint32_t stopAt, RunResult_t *pResult)
+{
+    uint64_t startNs;
+    uint64_t storageNs = 0;
+    uint64_t beforeNs;
+    uint64_t busyNs;
+
+    memset(&_gSender, 0, sizeof(_gSender));
+    memset(&_gToRx, 0, sizeof(_gToRx));
+    memset(&_gToTx, 0, sizeof(_gToTx));
+    _gSender.files     = files;
+    _gSender.fileCnt   = fileCnt;
+    _gSender.corruptAt = corruptAt;
+    _gSender.dropAckAt = dropAckAt;
+    _gSender.stopAt    = stopAt;
+
+    _gSender.dropHeaderAck = _gFault.dropHeaderAck;
+    _gSender.loseAt        = _gFault.loseAt;
+    _gSender.eotAt         = _gFault.eotAt;
+    _gSender.timeoutNs     = _gFault.timeoutNs != 0 ? _gFault.timeoutNs : SENDER_TIMEOUT_NS;
+    memset(&_gFault, 0, sizeof(_gFault));
+    _gIsrMode          = isrMode;
+    _gRingHead         = 0;
+    _gRingCnt          = 0;
+    _gRingDrops        = 0;
+    startNs            = _gNowNs;
+
+    check(YmodemReceiveSessionOpenTarget(&_gSession, isrMode ? NULL : rx_read, rx_write, target), "open session");
+    while (_gSession.state_ != YMODEM_SESSION_CLOSED) {
+        if (_gNowNs - startNs > 600ULL * 1000000000ULL) {
+            check(false, "session finished");
+            YmodemReceiveSessionCancle(&_gSession);
+            break;
+        }
+        ymodem_sim_tick = (uint32_t)(_gNowNs / 1000000ULL);
+        deliver_to_rx();
+        sender_poll();
+
+        beforeNs = flash_ns();
+        YmodemSessionPoll(&_gSession);
+        busyNs = flash_ns() - beforeNs;
+        // 写入存储期间主循环阻塞，之后到达的字节在下一次循环处理
+        if (busyNs > LOOP_NS) {
+            storageNs += busyNs;
+            _gNowNs += busyNs;
+        } else {
+            flash_elapse(LOOP_NS - busyNs);
+            _gNowNs += LOOP_NS;
+        }
+    }
+    pResult->result    = YmodemSessionGetResult(&_gSession);
+    pResult->elapsedNs = _gNowNs - startNs;
+    pResult->storageNs = storageNs;
+    pResult->ringDrops = _gRingDrops;
+    pResult->resends   = _gSender.resends;
+    YmodemSessionGetStat(&_gSession, &pResult->stat);
+    YmodemSessionClearResult(&_gSession);
+}
+
+static bool file_matches(const SimFile_t *f)
+{
+    char path[32];
+    UINT br;
+    bool ok = true;
+
+    snprintf(path, sizeof(path), "0:%s", f->name);
+    if (f_open(&_gFile, path, FA_READ) != FR_OK) {
+        return false;
+    }
+    ok = f_size(&_gFile) == f->size;
+    for (uint32_t pos = 0; ok && pos < f->size; pos += br) {
+        if (f_read(&_gFile, _gBuf, sizeof(_gBuf), &br) != FR_OK || br == 0) {
+            ok = false;
+            break;
+        }
+        for (uint32_t i = 0; i < br; i++) {
+            ok = ok && _gBuf[i] == pattern(f->seed, pos + i);
+        }
+    }
+    f_close(&_gFile);
+    return ok;
+}
+
+static bool raw_matches(const SimFile_t *f)
+{
+    for (uint32_t pos = 0; pos < f->size; pos += sizeof(_gBuf)) {
+        uint32_t len = f->size - pos < sizeof(_gBuf) ? f->size - pos : sizeof(_gBuf);
+        HDL_Flash_read(YMODEM_RAW_ADDR + pos, _gBuf, len);
+        for (uint32_t i = 0; i < len; i++) {
+            if (_gBuf[i] != pattern(f->seed, pos + i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static double line_percent(const RunResult_t *r, uint32_t bytes)
+{
+    return (double)bytes * BYTE_NS * 100.0 / (double)r->elapsedNs;
+}
+
+static void show(const char *what, const RunResult_t *r, uint32_t bytes)
+{
+    ULOG_INFO("[Ymodem Test] %s: %u bytes in %.2f s, %.0f B/s, %.1f%% of line rate, storage %.2f s, max write %u us",
+              what, bytes, (double)r->elapsedNs / 1e9, (double)bytes * 1e9 / (double)r->elapsedNs,
+              line_percent(r, bytes), (double)r->storageNs / 1e9, r->stat.maxWriteUs);
+    ULOG_INFO("[Ymodem Test] %s: blocks %u written %u resumed %u dup %u errors %u overruns %u ring drops %u resends %u",
+              what, r->stat.blocks, r->stat.bytes, r->stat.resumed, r->stat.duplicates, r->stat.errors,
+              r->stat.overruns, r->ringDrops, r->resends);
+}
+
+static void isr_test()
+{
+    static const SimFile_t files[] = {{"big.bin", 256U * 1024U, 1}, {"small.txt", 3000, 2}};
+    RunResult_t r;
+
+    run(files, 2, YMODEM_TARGET_FATFS, true, 0, 0, 0, &r);
+    show("isr 2 files", &r, files[0].size + files[1].size);
+    check(r.result == YMODEM_SESSION_RESULT_OK, "isr result");
+    check(file_matches(&files[0]) && file_matches(&files[1]), "isr files");
+    check(r.stat.overruns == 0 && r.stat.errors == 0 && r.resends == 0, "isr no errors");
+    check(line_percent(&r, files[0].size + files[1].size) > 90.0, "isr above 90% of line rate");
+}
+
+static void poll_test()
+{
+    static const SimFile_t files[] = {{"poll.bin", 64U * 1024U, 3}};
+    RunResult_t r;
+
+    run(files, 1, YMODEM_TARGET_FATFS, false, 0, 0, 0, &r);
+    show("poll 200B ring", &r, files[0].size);
+    check(r.result == YMODEM_SESSION_RESULT_OK, "poll result");
+    check(file_matches(&files[0]), "poll file");
+}
+
+static void error_test()
+{
+    static const SimFile_t files[] = {{"err.bin", 20U * 1024U + 77U, 4}};
+    RunResult_t r;
+
+    run(files, 1, YMODEM_TARGET_FATFS, true, 3, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_OK && file_matches(&files[0]), "crc error resent");
+    check(r.stat.errors == 1 && r.resends == 1, "one nak");
+
+    run(files, 1, YMODEM_TARGET_FATFS, true, 0, 5, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_OK && file_matches(&files[0]), "lost ack");
+    check(r.stat.duplicates == 1 && r.stat.blocks == 21, "duplicate block not written twice");
+
+    // 文件头的ACK丢失：发送方超时重发文件头，接收方再确认
+    _gFault.dropHeaderAck = true;
+    run(files, 1, YMODEM_TARGET_FATFS, true, 0, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_OK && file_matches(&files[0]), "lost header ack");
+    check(r.stat.duplicates == 1 && r.resends == 1 && r.stat.blocks == 21, "header acknowledged again");
+
+    // 第一个数据块丢失，发送方的超时比接收方长：接收方重试只发送'C'，ACK会让发送方跳过第一块
+    _gFault.loseAt    = 1;
+    _gFault.timeoutNs = 10ULL * 1000000000ULL;
+    run(files, 1, YMODEM_TARGET_FATFS, true, 0, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_OK && file_matches(&files[0]), "lost first block");
+    check(r.resends == 1 && r.stat.blocks == 21, "first block resent on 'C'");
+}
+
+static void resume_test(YmodemTarget_t target)
+{
+    static const SimFile_t file[]    = {{"resume.bin", 100U * 1024U + 5U, 5}};
+    static const SimFile_t changed[] = {{"resume.bin", 100U * 1024U + 5U, 6}};
+    bool raw                         = target == YMODEM_TARGET_RAW;
+    RunResult_t r;
+
+    // 发送到第61块时线路断开，接收方超时
+    run(file, 1, target, true, 0, 0, 61, &r);
+    check(r.result == YMODEM_SESSION_RESULT_TIMEOUT, "interrupted");
+    check(raw || f_stat("0:resume.bin", NULL) == FR_OK, "partial file kept");
+
+    run(file, 1, target, true, 0, 0, 0, &r);
+    show(raw ? "raw resume" : "resume", &r, file[0].size);
+    check(r.result == YMODEM_SESSION_RESULT_OK, "resume result");
+    check(raw ? raw_matches(&file[0]) : file_matches(&file[0]), "resumed content");
+    check(r.stat.resumed >= (raw ? 60U * 1024U : 32U * 1024U), "resumed bytes not rewritten");
+    check(r.stat.resumed + r.stat.bytes == file[0].size, "every byte written or resumed");
+
+    // 已有的数据和重新发送的不同时从不同的地方重新写入
+    run(file, 1, target, true, 0, 0, 31, &r);
+    run(changed, 1, target, true, 0, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_OK, "changed result");
+    check(raw ? raw_matches(&changed[0]) : file_matches(&changed[0]), "changed content");
+    check(r.stat.resumed == 0, "changed data rewritten");
+}
+
+static void raw_test()
+{
+    static const SimFile_t files[] = {{"fw.bin", 150U * 1024U + 3U, 8}};
+    RunResult_t r;
+
+    run(files, 1, YMODEM_TARGET_RAW, true, 0, 0, 0, &r);
+    show("raw", &r, files[0].size);
+    check(r.result == YMODEM_SESSION_RESULT_OK && raw_matches(&files[0]), "raw content");
+
+    // 分区放不下的文件被拒绝
+    static const SimFile_t big[] = {{"big.bin", YMODEM_RAW_SIZE + 1U, 9}};
+    run(big, 1, YMODEM_TARGET_RAW, true, 0, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_ERROR, "raw too big");
+
+    // 发送方提前发送EOT：文件头中的大小没有收够，不是成功，续传记录保留
+    static const SimFile_t part[] = {{"part.bin", 30U * 1024U + 11U, 10}};
+    _gFault.eotAt = 10;
+    run(part, 1, YMODEM_TARGET_RAW, true, 0, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_ERROR, "raw incomplete is an error");
+    run(part, 1, YMODEM_TARGET_RAW, true, 0, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_OK && raw_matches(&part[0]), "raw incomplete resumed");
+    check(r.stat.resumed == 10U * 1024U, "raw incomplete resume point");
+
+    _gFault.eotAt = 3;
+    run(part, 1, YMODEM_TARGET_FATFS, true, 0, 0, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_ERROR, "fatfs incomplete is an error");
+}
+
+typedef struct {
+    YmodemSessionResult_t result;
+    YmodemSessionResult_t rxResult;
+    YmodemSendStat_t stat;
+    YmodemSessionStat_t rxStat;
+    uint64_t elapsedNs;
+    uint64_t readNs; // 发送方读取存储的时间
+} SendResult_t;
+
+static uint64_t sender_storage_ns()
+{
+    if (_gHooks == NULL) {
+        return flash_ns();
+    }
+    return _gHooks->flash_ns() + _gHooks->sd_ns();
+}
+
+/**
+ * @brief 发送会话和接收会话（串口中断方式）接在同一条线路上，各自在存储忙的时候不处理。
+ *
+ * @param withReceiver 为false时没有接收方。
+ * @param cancelAfter 接收方收到这么多数据块后取消，0表示不取消。
+ */
+static void run_send(const YmodemSendFile_t *files, uint32_t count, bool withReceiver, uint32_t cancelAfter, SendResult_t *pResult)
+{
+    uint64_t startNs = _gNowNs;
+    uint64_t rxBusyNs = 0;
+    uint64_t txBusyNs = 0;
+    uint64_t beforeNs;
+
+    memset(pResult, 0, sizeof(*pResult));
+    memset(&_gToRx, 0, sizeof(_gToRx));
+    memset(&_gToTx, 0, sizeof(_gToTx));
+    _gIsrMode = true;
+    _gRxBytes = 0;
+    ymodem_sim_tick = (uint32_t)(_gNowNs / 1000000ULL);
+    check(YmodemSendSessionOpen(&_gSend, tx_read, tx_write, files, count), "open send session");
+    if (withReceiver) {
+        check(YmodemReceiveSessionOpen(&_gSession, NULL, rx_write), "open receive session");
+    }
+    while (_gSend.state_ != YMODEM_SESSION_CLOSED || _gSession.state_ != YMODEM_SESSION_CLOSED) {
+        if (_gNowNs - startNs > 600ULL * 1000000000ULL) {
+            check(false, "send session finished");
+            YmodemSendSessionCancle(&_gSend);
+            YmodemReceiveSessionCancle(&_gSession);
+            break;
+        }
+        ymodem_sim_tick = (uint32_t)(_gNowNs / 1000000ULL);
+        deliver_to_rx();
+        if (_gNowNs >= rxBusyNs) {
+            beforeNs = flash_ns();
+            YmodemSessionPoll(&_gSession);
+            rxBusyNs = _gNowNs + (flash_ns() - beforeNs);
+            if (cancelAfter > 0 && _gSession.stat_.blocks >= cancelAfter) {
+                YmodemReceiveSessionCancle(&_gSession);
+            }
+        }
+        if (_gNowNs >= txBusyNs) {
+            beforeNs = sender_storage_ns();
+            YmodemSendSessionPoll(&_gSend);
+            beforeNs = sender_storage_ns() - beforeNs;
+            pResult->readNs += beforeNs;
+            txBusyNs = _gNowNs + beforeNs;
+        }
+        _gNowNs += LOOP_NS;
+    }
+    pResult->result    = YmodemSendSessionGetResult(&_gSend);
+    pResult->rxResult  = YmodemSessionGetResult(&_gSession);
+    pResult->elapsedNs = _gNowNs - startNs;
+    YmodemSendSessionGetStat(&_gSend, &pResult->stat);
+    YmodemSessionGetStat(&_gSession, &pResult->rxStat);
+    YmodemSendSessionClearResult(&_gSend);
+    YmodemSessionClearResult(&_gSession);
+}
+
+static void make_sd_file(const char *path, const SimFile_t *f)
+{
+    UINT bw;
+
+    check(f_open(&_gFile, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "create sd file");
+    for (uint32_t pos = 0; pos < f->size; pos += sizeof(_gBuf)) {
+        uint32_t len = f->size - pos < sizeof(_gBuf) ? f->size - pos : sizeof(_gBuf);
+        for (uint32_t i = 0; i < len; i++) {
+            _gBuf[i] = pattern(f->seed, pos + i);
+        }
+        f_write(&_gFile, _gBuf, len, &bw);
+    }
+    check(f_close(&_gFile) == FR_OK, "close sd file");
+}
+
+static void send_batch_test()
+{
+    // 接收方保存的文件名（去掉了盘符和目录）和内容
+    static const SimFile_t files[] = {
+        {"A.BIN", 100U * 1024U + 300U, 11}, {"B.TXT", 50, 12}, {"EMPTY.BIN", 0, 13}, {"C.BIN", 4U * 1024U + 1000U, 14}};
+    static const YmodemSendFile_t send[] = {
+        {YMODEM_SOURCE_FATFS, "1:EXP/A.BIN"}, {YMODEM_SOURCE_FATFS, "1:B.TXT"}, {YMODEM_SOURCE_FATFS, "1:EMPTY.BIN"}, {YMODEM_SOURCE_FATFS, "1:C.BIN"}};
+    uint32_t total = 0;
+    SendResult_t r;
+
+    f_mkdir("1:EXP");
+    for (uint32_t i = 0; i < 4; i++) {
+        make_sd_file(send[i].path, &files[i]);
+        total += files[i].size;
+    }
+    run_send(send, 4, true, 0, &r);
+    ULOG_INFO("[Ymodem Test] send 4 files: %u bytes in %.2f s, %.1f%% of line rate, %u blocks, %u resends, storage read %.1f ms (max %u us per block)",
+              total, (double)r.elapsedNs / 1e9, (double)total * BYTE_NS * 100.0 / (double)r.elapsedNs, r.stat.blocks,
+              r.stat.resends, (double)r.readNs / 1e6, r.stat.maxReadUs);
+    check(r.result == YMODEM_SESSION_RESULT_OK && r.rxResult == YMODEM_SESSION_RESULT_OK, "send result");
+    check(r.stat.files == 4 && r.stat.bytes == total && r.stat.resends == 0, "send stat");
+    // 100个1K块+3个128字节块，50字节一个128字节块，空文件没有数据块，5096字节5个1K块
+    check(r.stat.blocks == 100 + 3 + 1 + 0 + 5, "small tail blocks");
+    for (uint32_t i = 0; i < 4; i++) {
+        check(file_matches(&files[i]), "sent file content");
+    }
+    check((double)total * BYTE_NS * 100.0 / (double)r.elapsedNs > 90.0, "send above 90% of line rate");
+
+    // 校验错误：接收方NAK，发送方重发
+    _gCorruptByte = 133 + 700;
+    run_send(send + 3, 1, true, 0, &r);
+    _gCorruptByte = UINT32_MAX;
+    check(r.result == YMODEM_SESSION_RESULT_OK && r.stat.resends == 1 && r.rxStat.errors == 1, "send resend after nak");
+    check(file_matches(&files[3]), "resent file content");
+
+    // 接收方取消
+    run_send(send, 1, true, 10, &r);
+    check(r.result == YMODEM_SESSION_RESULT_CANCLE, "send cancelled by receiver");
+
+    // 没有接收方
+    run_send(send, 1, false, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_TIMEOUT && r.stat.blocks == 0, "send timeout without receiver");
+}
+
+static void send_qfs_test()
+{
+    static const SimFile_t file[] = {{"QFS.BIN", 0, 15}};
+    static const YmodemSendFile_t send[] = {{YMODEM_SOURCE_QFS, "QFS.BIN"}};
+    uint8_t chunk[256];
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    SimFile_t expect;
+    SendResult_t r;
+    QFSSnapshot_t snap;
+
+    CHIP_W25Q512_QFS_make_empty();
+    // 写入5个多扇区，等待写入Flash
+    while (pushed < 5U * W25Q512_SECTOR_SIZE + 1000U) {
+        for (uint32_t i = 0; i < sizeof(chunk); i++) {
+            chunk[i] = pattern(file[0].seed, pushed + i);
+        }
+        pushed += CHIP_W25Q512_QFS_push(chunk, sizeof(chunk));
+        for (int i = 0; i < 100; i++) {
+            CHIP_W25Q512_QFS_handler();
+        }
+    }
+    for (int i = 0; i < 10000 || !CHIP_W25Q512_QFS_is_idle(); i++) {
+        CHIP_W25Q512_QFS_handler();
+    }
+    // 已经出队的部分不发送
+    popped = CHIP_W25Q512_QFS_pop(NULL, 1000);
+    CHIP_W25Q512_QFS_snapshot(&snap);
+    check(snap.byte_size > 0, "qfs has data");
+
+    run_send(send, 1, true, 0, &r);
+    check(r.result == YMODEM_SESSION_RESULT_OK && r.rxResult == YMODEM_SESSION_RESULT_OK, "qfs send result");
+    check(r.stat.bytes == snap.byte_size, "qfs snapshot size");
+    // 接收到的文件是从出队位置开始的数据
+    check(f_open(&_gFile, "0:QFS.BIN", FA_READ) == FR_OK, "qfs file received");
+    expect = file[0];
+    for (uint32_t pos = 0; pos < snap.byte_size; pos++) {
+        UINT br;
+        uint8_t b;
+        f_read(&_gFile, &b, 1, &br);
+        if (br != 1 || b != pattern(expect.seed, popped + pos)) {
+            check(false, "qfs content");
+            break;
+        }
+    }
+    f_close(&_gFile);
+    ULOG_INFO("[Ymodem Test] send qfs snapshot: %u bytes in %.2f s", snap.byte_size, (double)r.elapsedNs / 1e9);
+}
+
+// 上次运行留下的文件影响续传测试
+static void remove_files()
+{
+    static const char *const files[] = {"0:big.bin", "0:small.txt", "0:poll.bin", "0:err.bin", "0:resume.bin",
+                                        "0:fw.bin", "0:part.bin", "0:A.BIN", "0:B.TXT", "0:EMPTY.BIN",
+                                        "0:C.BIN", "0:QFS.BIN", "1:EXP/A.BIN", "1:B.TXT", "1:EMPTY.BIN",
+                                        "1:C.BIN"};
+
+    for (uint32_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        f_unlink(files[i]);
+    }
+}
+
+static void session_test()
+{
+    remove_files();
+    isr_test();
+    poll_test();
+    error_test();
+    resume_test(YMODEM_TARGET_FATFS);
+    resume_test(YMODEM_TARGET_RAW);
+    raw_test();
+    send_batch_test();
+    send_qfs_test();
+}
+#endif
+
+/**
+ * @brief Ymodem测试。接收的文件保存在YMODEM_DRIVE，发送的文件放在SD卡（1:盘）上，两个盘和QFS需要已经初始化。
+ * 会话测试需要定义YMODEM_SIMULATION，使用虚拟时钟。
+ *
+ * @param pHooks 存储的时间，没有时为NULL，按CPU时间计算。
+ * @return uint32_t 错误数。
+ */
+uint32_t ymodem_test(const Ymodem_TestHooks_t *pHooks)
 {
-}
\ No newline at end of file
+    _gErrorCnt = 0;
+    crc_test();
+#ifdef YMODEM_SIMULATION
+    _gHooks = pHooks;
+    session_test();
+#else
+    (void)pHooks;
+#endif
+    ULOG_INFO("[Ymodem Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
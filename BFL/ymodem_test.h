@@ -0,0 +1,25 @@
+/**
+ * @file ymodem_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef YMODEM_TEST_H
+#define YMODEM_TEST_H
+#include <stdint.h>
+#include "ymodem.h"
+
+// 存储的时间，主机上由W25Q512和SD卡模型提供，目标板上为NULL
+typedef struct {
+    uint64_t (*flash_ns)(void);  // W25Q512的时间，ns
+    uint64_t (*sd_ns)(void);     // SD卡的SPI总线时间，ns
+    void (*elapse)(uint64_t ns); // 主循环空闲时推进W25Q512的时间
+} Ymodem_TestHooks_t;
+
+uint32_t ymodem_test(const Ymodem_TestHooks_t *pHooks);
+#endif // !YMODEM_TEST_H
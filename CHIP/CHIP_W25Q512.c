@@ -22,6 +22,8 @@ DMA_HandleTypeDef hdma_quadspi;
 #define POSITION_VAL(VAL) (__CLZ(__RBIT(VAL)))
 // 大小为W25Q512一个Sector的缓存区，用于CHIP_W25Q512_write方法，在擦除一个扇区时缓存其数据。
 static __IO uint8_t w25q512_buf[W25Q512_SECTOR_SIZE] = {0};
+// 发出了不等待完成的页编程或者擦除命令（日志分区、QFS），芯片可能还在忙
+static volatile bool w25q512_pending = false;
 int32_t w25q512_send_cmd(uint8_t cmd);
 int32_t w25q512_wait_busy(uint32_t timeout);
 int32_t w25q512_erase_one_sector(uint32_t sector);
@@ -31,6 +33,7 @@ int32_t w25q512_write_one_sector(uint32_t sector, uint8_t *buf);
 uint8_t w25q512_read_status_reg(uint8_t reg);
 uint8_t w25q512_is_busy();
 int32_t w25q512_erase_one_sector_cmd(uint32_t sector);
+static int32_t w25q512_wait_pending();
 /**
  * @brief 初始化W25Q512，使得芯片能够正常读写。
  *
@@ -209,6 +212,57 @@ HAL_StatusTypeDef WaitForQSPI_DMACompletion(QSPI_HandleTypeDef *hqspi, uint32_t
     return HAL_OK; // 完成
 }
 
+/**
+ * @brief QSPI是否有传输正在进行，主循环据此决定能否低功耗空闲。
+ * 只查询QSPI外设的状态，不访问Flash芯片。
+ *
+ * @return true QSPI忙。
+ * @return false QSPI空闲。
+ */
+bool CHIP_W25Q512_IsBusy()
+{
+    // 未初始化(RESET)和出错的状态不算忙，否则主循环永远不能空闲
+    switch (HAL_QSPI_GetState(&w25qxx_hqspi)) {
+        case HAL_QSPI_STATE_BUSY:
+        case HAL_QSPI_STATE_BUSY_INDIRECT_TX:
+        case HAL_QSPI_STATE_BUSY_INDIRECT_RX:
+        case HAL_QSPI_STATE_BUSY_AUTO_POLLING:
+        case HAL_QSPI_STATE_ABORT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief 芯片是否正在执行不等待完成的页编程或者擦除（日志分区、QFS发出的）。
+ * 这时的读取要等编程或者擦除完成，USB中断中的预读据此跳过，不在中断里等待。
+ *
+ * @return true 正在编程或者擦除。
+ * @return false 空闲。
+ */
+bool CHIP_W25Q512_IsProgramming()
+{
+    return w25q512_pending && w25q512_is_busy();
+}
+
+/**
+ * @brief 等待CHIP_W25Q512_read_start启动的DMA读取完成。没有正在进行的读取时立即返回。
+ * 读取由QSPI中断结束，QSPI中断的优先级高于USB中断，可以在USB回调中等待。
+ *
+ * @return int32_t 成功返回0，超时返回-1。
+ */
+int32_t CHIP_W25Q512_read_wait()
+{
+    uint32_t startTick = HAL_GetTick();
+    while (HAL_QSPI_GetState(&w25qxx_hqspi) == HAL_QSPI_STATE_BUSY_INDIRECT_RX) {
+        if ((HAL_GetTick() - startTick) >= W25Q512_RECEIVE_TIMEOUT) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 /**
  * @brief 从flash芯片随机读取一定数量的数据到内存。
  *
@@ -218,6 +272,29 @@ HAL_StatusTypeDef WaitForQSPI_DMACompletion(QSPI_HandleTypeDef *hqspi, uint32_t
  * @return int32_t
  */
 int32_t CHIP_W25Q512_read(uint32_t address, uint8_t *buf, uint32_t size)
+{
+    int32_t status = CHIP_W25Q512_read_start(address, buf, size);
+
+    if (status == 0) {
+        status = CHIP_W25Q512_read_wait();
+    }
+    // 这一句是必要的
+    w25q512_wait_busy(W25Q512_TIMEOUT_DEFAULT_VALUE);
+    return status;
+}
+
+/**
+ * @brief 启动一次读取，使用DMA时发出读命令、启动DMA后立即返回，数据在CHIP_W25Q512_read_wait
+ * 返回之后（或者CHIP_W25Q512_IsBusy变为false之后）才可以使用。之前的读取没有完成时先等待。
+ * 芯片正在执行日志分区、QFS发出的编程或者擦除时先等待完成，芯片忙时读出的不是存储的数据。
+ * 不使用DMA时读取完成后返回。
+ *
+ * @param address 从Flash读取数据的地址。
+ * @param buf 指向待存放数据的指针，读取完成之前不能修改。
+ * @param size 需要读取数据的长度，单位字节。
+ * @return int32_t 成功返回0，失败或者等待编程、擦除超时返回-1。
+ */
+int32_t CHIP_W25Q512_read_start(uint32_t address, uint8_t *buf, uint32_t size)
 {
     int32_t status = 0;
     QSPI_CommandTypeDef s_command;
@@ -293,20 +370,22 @@ int32_t CHIP_W25Q512_read(uint32_t address, uint8_t *buf, uint32_t size)
     // pcmd->AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
 
     // 发送命令
+    CHIP_W25Q512_read_wait();
+    if (w25q512_wait_pending() != 0) {
+        status = -1;
+        return status;
+    }
     if (HAL_QSPI_Command(&w25qxx_hqspi, &s_command, W25Q512_TIMEOUT_DEFAULT_VALUE) != HAL_OK) {
         status = -1;
         return status;
     }
 
 #if CHIP_W25Q512_DMA_ENABLE
-    // 使用DMA方式接收数据
+    // 使用DMA方式接收数据，由CHIP_W25Q512_read_wait等待完成
     if (HAL_QSPI_Receive_DMA(&w25qxx_hqspi, buf) != HAL_OK) {
         status = -1;
         return status;
     }
-
-    // 等待DMA传输完成
-    WaitForQSPI_DMACompletion(&w25qxx_hqspi, W25Q512_RECEIVE_TIMEOUT);
 #else
     // 使用常规方式接收数据
     if (HAL_QSPI_Receive(&w25qxx_hqspi, buf, W25Q512_RECEIVE_TIMEOUT) != HAL_OK) {
@@ -314,9 +393,6 @@ int32_t CHIP_W25Q512_read(uint32_t address, uint8_t *buf, uint32_t size)
         return status;
     }
 #endif
-
-    // 这一句是必要的
-    w25q512_wait_busy(W25Q512_TIMEOUT_DEFAULT_VALUE);
     return status;
 }
 
@@ -408,12 +484,29 @@ int32_t w25q512_wait_busy(uint32_t timeout)
     s_config.StatusBytesSize = 1;
     s_config.Mask            = W25QXX_STATUS_REG1_BUSY;
 
+    CHIP_W25Q512_read_wait();
     if (HAL_QSPI_AutoPolling(&w25qxx_hqspi, &s_command, &s_config, timeout) != HAL_OK) {
         status = -1;
+    } else {
+        w25q512_pending = false;
     }
     return status;
 }
 
+/**
+ * @brief 有不等待完成的编程或者擦除时等待芯片空闲。芯片忙时只响应读状态寄存器，
+ * 读命令读出的不是存储的数据，写使能被忽略，之后的编程和擦除也不会执行。
+ *
+ * @return int32_t 成功返回0，超时返回-1。
+ */
+static int32_t w25q512_wait_pending()
+{
+    if (!w25q512_pending) {
+        return 0;
+    }
+    return w25q512_wait_busy(W25Q512_TIMEOUT_DEFAULT_VALUE);
+}
+
 /**
  * @brief 向W25Q512发送指令。但是只支持不包含地址也不需要读取数据的指令。
  *
@@ -436,6 +529,11 @@ int32_t w25q512_send_cmd(uint8_t cmd)
     qspi_handler.DdrMode             = QSPI_DDR_MODE_DISABLE;
     qspi_handler.DdrHoldHalfCycle    = QSPI_DDR_HHC_ANALOG_DELAY;
 
+    // 预读的DMA可能还没有结束，QSPI忙时HAL_QSPI_Command直接返回失败
+    CHIP_W25Q512_read_wait();
+    if (w25q512_wait_pending() != 0) {
+        return -1;
+    }
     if (HAL_QSPI_Command(&w25qxx_hqspi, &qspi_handler, W25Q512_TIMEOUT_DEFAULT_VALUE) != HAL_OK) {
         status = -1;
     }
@@ -514,6 +612,8 @@ int32_t w25q512_erase_one_sector_cmd(uint32_t sector)
     qspi_handler.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
     qspi_handler.DdrMode           = QSPI_DDR_MODE_DISABLE;
     qspi_handler.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+    // 命令发出之后的读取和命令要先等擦除完成，标志在发命令之前置位，中断里的读取也能看到
+    w25q512_pending = true;
     if (HAL_QSPI_Command(&w25qxx_hqspi, &qspi_handler, W25Q512_TIMEOUT_DEFAULT_VALUE) != HAL_OK) {
         status = -1;
     }
@@ -624,6 +724,8 @@ int32_t w25q512_write_page_no_erase_no_wait(uint32_t address, uint8_t *buf, uint
     s_command.NbData            = size;
     s_command.Address           = address;
 
+    // 同w25q512_erase_one_sector_cmd，发命令之前置位
+    w25q512_pending = true;
     if (HAL_QSPI_Command(&w25qxx_hqspi, &s_command, W25Q512_TIMEOUT_DEFAULT_VALUE) != HAL_OK) {
         status = -1;
         return status;
@@ -707,6 +809,7 @@ uint8_t w25q512_read_status_reg(uint8_t reg)
     qspi_handler.DdrMode           = QSPI_DDR_MODE_DISABLE;
     qspi_handler.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
     qspi_handler.NbData            = 1;
+    CHIP_W25Q512_read_wait();
     HAL_QSPI_Command(&w25qxx_hqspi, &qspi_handler, W25Q512_TIMEOUT_DEFAULT_VALUE);
     HAL_QSPI_Receive(&w25qxx_hqspi, &byte, W25Q512_TIMEOUT_DEFAULT_VALUE);
     return byte;
@@ -722,5 +825,8 @@ uint8_t w25q512_is_busy()
     uint8_t status = 0;
     uint8_t reg1   = w25q512_read_status_reg(W25QXX_CMD_ReadStatusReg1);
     status         = (uint8_t)((reg1 & W25QXX_STATUS_REG1_BUSY) == W25QXX_STATUS_REG1_BUSY);
+    if (status == 0) {
+        w25q512_pending = false;
+    }
     return status;
 }
\ No newline at end of file
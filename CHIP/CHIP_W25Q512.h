@@ -12,9 +12,14 @@
 #define CHIP_W25Q512_H_
 #include "main.h"
 #include <stdint.h>
+#include <stdbool.h>
 int32_t CHIP_W25Q512_Init();
 int32_t CHIP_W25Q512_read(uint32_t address, uint8_t *data, uint32_t size);
+int32_t CHIP_W25Q512_read_start(uint32_t address, uint8_t *data, uint32_t size);
+int32_t CHIP_W25Q512_read_wait();
 int32_t CHIP_W25Q512_write(uint32_t address, uint8_t *data, uint32_t size);
+bool CHIP_W25Q512_IsBusy();
+bool CHIP_W25Q512_IsProgramming();
 
 #define W25Q512_JEDEC_ID               0xEF4020UL
 #define W25Q512_FLASH_SIZE             0x4000000UL
@@ -90,6 +95,7 @@ regions beyond 128Mb. When ADP=1, the device will power up into 4-Byte Address M
 #define W25QXX_CMD_ResetDevice                          0x99 /* Reset Device */
 
 int32_t w25q512_erase_one_sector(uint32_t sector);
+int32_t w25q512_write_page_no_erase(uint32_t address, uint8_t *buf, uint32_t size);
 int32_t w25q512_write_one_sector_no_erase(uint32_t sector, uint8_t *buf);
 int32_t w25q512_write_one_sector(uint32_t sector, uint8_t *buf);
 int32_t CHIP_W25Q512_read_one_sector(uint32_t sec_idx, uint8_t *buf);
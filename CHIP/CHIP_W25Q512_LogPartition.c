@@ -0,0 +1,517 @@
+/**
+ * @file CHIP_W25Q512_LogPartition.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief W25Q512末尾的日志分区，格式见CHIP_W25Q512_LogPartition.h。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stddef.h>
+#include <string.h>
+#include "CHIP_W25Q512_LogPartition.h"
+#include "HDL_CPU_Time.h"
+#include "crc.h"
+#include "log.h"
+
+int32_t w25q512_wait_busy(uint32_t timeout);
+int32_t w25q512_write_page_no_erase_no_wait(uint32_t address, uint8_t *buf, uint32_t size);
+uint8_t w25q512_is_busy();
+int32_t w25q512_erase_one_sector_cmd(uint32_t sector);
+
+#define LOG_SECTOR_MAGIC 0x31474F4CUL // "LOG1"
+#define LOG_ADDRESS(SECTOR, OFFSET) ((W25Q512_LOG_FIRST_SECTOR + (SECTOR)) * W25Q512_SECTOR_SIZE + (OFFSET))
+
+typedef struct tagW25Q512_LogHeader_t {
+    uint32_t magic;
+    uint32_t sectorSeq;   // 扇区序号，每启用一个新扇区加1，从1开始
+    uint32_t firstRecSeq; // 扇区中第一条记录的序号，从0开始
+    uint32_t crc;         // 前12字节的CRC32
+} W25Q512_LogHeader_t;
+
+typedef enum {
+    LOG_IDLE,
+    LOG_WAITING_ERASE_FINISH,
+} W25Q512_LogState_t;
+
+static uint8_t log_buf[CHIP_W25Q512_LOG_BUF_SIZE];
+// 自由增长的读写位置，head-tail为缓冲区中还没有写入Flash的字节数
+static volatile uint32_t log_head;
+static volatile uint32_t log_tail;
+static volatile uint32_t log_first_tick; // 缓冲区由空变为非空的时刻
+static volatile bool log_flush_req;
+
+static bool log_mounted;
+static W25Q512_LogState_t log_state;
+static uint32_t log_sector;     // 当前写入的扇区，分区内的扇区号
+static uint32_t log_offset;     // 当前扇区下一个编程位置，0表示需要启用新的扇区
+static uint32_t log_sector_seq; // 当前扇区的扇区序号，0表示分区是空的
+static uint32_t log_rec_seq;    // 下一条放入Flash的记录的序号
+static uint32_t log_rec_left;   // 正在编程的记录还没有编程的字节数
+static uint32_t log_done_seq;   // 已经完整编程的记录数，读取只读到这里
+static uint8_t log_page[W25Q512_PAGE_SIZE];
+static W25Q512_LogStat_t log_stat;
+
+static void log_ring_get(uint32_t pos, uint8_t *dst, uint32_t len)
+{
+    uint32_t off   = pos & (CHIP_W25Q512_LOG_BUF_SIZE - 1);
+    uint32_t first = CHIP_W25Q512_LOG_BUF_SIZE - off < len ? CHIP_W25Q512_LOG_BUF_SIZE - off : len;
+    memcpy(dst, &log_buf[off], first);
+    memcpy(dst + first, log_buf, len - first);
+}
+
+static void log_ring_put(uint32_t pos, const uint8_t *src, uint32_t len)
+{
+    uint32_t off   = pos & (CHIP_W25Q512_LOG_BUF_SIZE - 1);
+    uint32_t first = CHIP_W25Q512_LOG_BUF_SIZE - off < len ? CHIP_W25Q512_LOG_BUF_SIZE - off : len;
+    memcpy(&log_buf[off], src, first);
+    memcpy(log_buf, src + first, len - first);
+}
+
+/**
+ * @brief 读取前等待正在进行的编程或者擦除完成。
+ *
+ */
+static void log_wait_flash()
+{
+    if (w25q512_is_busy()) {
+        w25q512_wait_busy(W25Q512_TIMEOUT_DEFAULT_VALUE);
+    }
+}
+
+/**
+ * @brief 读取扇区头。
+ *
+ * @param sector 分区内的扇区号。
+ * @param pHeader
+ * @return true 扇区头有效。
+ * @return false 扇区没有启用或者扇区头损坏。
+ */
+static bool log_read_header(uint32_t sector, W25Q512_LogHeader_t *pHeader)
+{
+    CHIP_W25Q512_read(LOG_ADDRESS(sector, 0), (uint8_t *)pHeader, sizeof(W25Q512_LogHeader_t));
+    return pHeader->magic == LOG_SECTOR_MAGIC && pHeader->sectorSeq != 0 &&
+           pHeader->crc == CRC32((const uint8_t *)pHeader, offsetof(W25Q512_LogHeader_t, crc));
+}
+
+/**
+ * @brief 读取并校验扇区中offset处的记录。
+ *
+ * @param sector 分区内的扇区号。
+ * @param offset 记录在扇区内的偏移。
+ * @param pType 记录类型，可以为NULL。
+ * @param buf 存放数据，可以为NULL，只校验不读取。
+ * @param size buf的大小，数据更长时只读取前size个字节。
+ * @param pLen 数据长度。
+ * @return int32_t 记录的总长度，0表示扇区中没有更多的记录，-1表示记录损坏。
+ */
+static int32_t log_load_record(uint32_t sector, uint32_t offset, uint8_t *pType, uint8_t *buf, uint32_t size,
+                               uint32_t *pLen)
+{
+    uint8_t head[4];
+    uint8_t tmp[64];
+    uint16_t crc   = 0;
+    uint32_t len   = 0;
+    uint32_t pos   = 0;
+    uint32_t chunk = 0;
+
+    if (offset + CHIP_W25Q512_LOG_RECORD_OVERHEAD > W25Q512_SECTOR_SIZE) {
+        return 0;
+    }
+    CHIP_W25Q512_read(LOG_ADDRESS(sector, offset), head, sizeof(head));
+    if (head[0] == 0xFF) {
+        return 0;
+    }
+    len = head[2] | ((uint32_t)head[3] << 8);
+    if (head[0] != CHIP_W25Q512_LOG_SYNC || len == 0 || len > CHIP_W25Q512_LOG_RECORD_MAX ||
+        offset + len + CHIP_W25Q512_LOG_RECORD_OVERHEAD > W25Q512_SECTOR_SIZE) {
+        return -1;
+    }
+
+    crc = CRC16_Modbus_Update(CRC16_MODBUS_INIT, &head[1], 3);
+    offset += sizeof(head);
+    if (buf != NULL) {
+        pos = len < size ? len : size;
+        CHIP_W25Q512_read(LOG_ADDRESS(sector, offset), buf, pos);
+        crc = CRC16_Modbus_Update(crc, buf, pos);
+    }
+    // 没有读到buf中的数据分段读到tmp中计算CRC
+    while (pos < len) {
+        chunk = len - pos < sizeof(tmp) ? len - pos : sizeof(tmp);
+        CHIP_W25Q512_read(LOG_ADDRESS(sector, offset + pos), tmp, chunk);
+        crc = CRC16_Modbus_Update(crc, tmp, chunk);
+        pos += chunk;
+    }
+    // CRC16高字节在前
+    CHIP_W25Q512_read(LOG_ADDRESS(sector, offset + len), tmp, 2);
+    if (crc != (((uint16_t)tmp[0] << 8) | tmp[1])) {
+        return -1;
+    }
+    if (pType != NULL) {
+        *pType = head[1];
+    }
+    if (pLen != NULL) {
+        *pLen = len;
+    }
+    return (int32_t)(len + CHIP_W25Q512_LOG_RECORD_OVERHEAD);
+}
+
+/**
+ * @brief 上电时加载日志分区：读取所有扇区头找到扇区序号最大的扇区，扫描其中的记录得到写入位置。
+ * 这个扇区末尾有损坏的记录(写入时掉电)时从下一个扇区继续写。
+ *
+ * @return int32_t 成功返回0，失败返回-1。
+ */
+int32_t CHIP_W25Q512_LOG_init()
+{
+    W25Q512_LogHeader_t header;
+    bool found        = false;
+    uint32_t offset   = CHIP_W25Q512_LOG_HEADER_LEN;
+    uint32_t count    = 0;
+    int32_t recordLen = 0;
+
+    log_mounted = false;
+    if (CHIP_W25Q512_Init() != 0) {
+        return -1;
+    }
+
+    log_head       = 0;
+    log_tail       = 0;
+    log_flush_req  = false;
+    log_state      = LOG_IDLE;
+    log_rec_left   = 0;
+    log_sector     = W25Q512_LOG_SECTOR_COUNT - 1;
+    log_offset     = 0;
+    log_sector_seq = 0;
+    log_rec_seq    = 0;
+    for (uint32_t i = 0; i < W25Q512_LOG_SECTOR_COUNT; i++) {
+        if (log_read_header(i, &header) && (!found || header.sectorSeq > log_sector_seq)) {
+            found          = true;
+            log_sector     = i;
+            log_sector_seq = header.sectorSeq;
+            log_rec_seq    = header.firstRecSeq;
+        }
+    }
+
+    if (found) {
+        while ((recordLen = log_load_record(log_sector, offset, NULL, NULL, 0, NULL)) > 0) {
+            offset += recordLen;
+            count++;
+        }
+        log_rec_seq += count;
+        // 记录损坏时不再往这个扇区写，避免在编程了一半的字节上再编程
+        log_offset = recordLen == 0 ? offset : 0;
+    }
+    log_done_seq = log_rec_seq;
+    log_mounted  = true;
+    ULOG_INFO("[LOG] partition mounted, sector:%u seq:%u offset:%u records:%u", log_sector, log_sector_seq, log_offset,
+              log_rec_seq);
+    return 0;
+}
+
+/**
+ * @brief 擦除整个日志分区，阻塞执行，大约需要十几秒。
+ *
+ */
+void CHIP_W25Q512_LOG_format()
+{
+    for (uint32_t i = 0; i < W25Q512_LOG_SECTOR_COUNT; i++) {
+        w25q512_erase_one_sector(W25Q512_LOG_FIRST_SECTOR + i);
+    }
+    CHIP_W25Q512_LOG_init();
+}
+
+/**
+ * @brief 写入一条记录到RAM缓冲区，可以在中断中调用。
+ *
+ * @param type CHIP_W25Q512_LOG_TYPE_*
+ * @param buf 数据。
+ * @param len 数据长度，1到CHIP_W25Q512_LOG_RECORD_MAX。
+ * @return true 写入成功。
+ * @return false 缓冲区满、数据超长或者分区没有加载。
+ */
+bool CHIP_W25Q512_LOG_append(uint8_t type, const void *buf, uint32_t len)
+{
+    uint8_t head[4];
+    uint8_t tail[2];
+    uint16_t crc     = 0;
+    uint32_t used    = 0;
+    uint32_t total   = len + CHIP_W25Q512_LOG_RECORD_OVERHEAD;
+    uint32_t primask = 0;
+    bool ok          = false;
+
+    if (!log_mounted || len == 0 || len > CHIP_W25Q512_LOG_RECORD_MAX) {
+        log_stat.dropped++;
+        return false;
+    }
+    head[0] = CHIP_W25Q512_LOG_SYNC;
+    head[1] = type;
+    head[2] = (uint8_t)len;
+    head[3] = (uint8_t)(len >> 8);
+    crc     = CRC16_Modbus_Update(CRC16_MODBUS_INIT, &head[1], 3);
+    crc     = CRC16_Modbus_Update(crc, (const uint8_t *)buf, len);
+    tail[0] = (uint8_t)(crc >> 8);
+    tail[1] = (uint8_t)crc;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    used = log_head - log_tail;
+    if (CHIP_W25Q512_LOG_BUF_SIZE - used < total) {
+        log_stat.dropped++;
+    } else {
+        if (used == 0) {
+            log_first_tick = HDL_CPU_Time_GetTick();
+        }
+        log_ring_put(log_head, head, sizeof(head));
+        log_ring_put(log_head + sizeof(head), (const uint8_t *)buf, len);
+        log_ring_put(log_head + sizeof(head) + len, tail, sizeof(tail));
+        log_head += total;
+        log_stat.appended++;
+        if (used + total > log_stat.maxUsed) {
+            log_stat.maxUsed = used + total;
+        }
+        ok = true;
+    }
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+/**
+ * @brief 要求把缓冲区中的记录尽快写入Flash，不等待一页凑满。
+ *
+ */
+void CHIP_W25Q512_LOG_flush()
+{
+    log_flush_req = true;
+}
+
+/**
+ * @brief 日志分区处理器，在主循环中调用。每次调用最多发出一个擦除或者页编程命令，不等待Flash完成。
+ *
+ */
+void CHIP_W25Q512_LOG_handler()
+{
+    W25Q512_LogHeader_t header;
+    uint8_t head[4];
+    uint32_t used     = 0;
+    uint32_t n        = 0;
+    uint32_t take     = 0;
+    uint32_t pageLeft = 0;
+    bool sectorFull   = false;
+
+    if (!log_mounted || w25q512_is_busy()) {
+        return;
+    }
+
+    if (log_state == LOG_WAITING_ERASE_FINISH) {
+        header.magic       = LOG_SECTOR_MAGIC;
+        header.sectorSeq   = log_sector_seq;
+        header.firstRecSeq = log_rec_seq;
+        header.crc         = CRC32((const uint8_t *)&header, offsetof(W25Q512_LogHeader_t, crc));
+        w25q512_write_page_no_erase_no_wait(LOG_ADDRESS(log_sector, 0), (uint8_t *)&header, sizeof(header));
+        log_stat.programs++;
+        log_offset = CHIP_W25Q512_LOG_HEADER_LEN;
+        log_state  = LOG_IDLE;
+        return;
+    }
+
+    used = log_head - log_tail;
+    if (used == 0) {
+        log_flush_req = false;
+        return;
+    }
+    // 凑够当前页剩余的空间再编程，每一页只编程一次
+    pageLeft = W25Q512_PAGE_SIZE - (log_offset == 0 ? CHIP_W25Q512_LOG_HEADER_LEN : log_offset % W25Q512_PAGE_SIZE);
+    if (used < pageLeft && !log_flush_req && HDL_CPU_Time_GetTick() - log_first_tick < CHIP_W25Q512_LOG_FLUSH_MS) {
+        return;
+    }
+
+    // 启用下一个扇区，分区满时擦除的是最老的扇区
+    if (log_offset == 0) {
+        log_sector = (log_sector + 1) % W25Q512_LOG_SECTOR_COUNT;
+        log_sector_seq++;
+        w25q512_erase_one_sector_cmd(W25Q512_LOG_FIRST_SECTOR + log_sector);
+        log_stat.erases++;
+        log_state = LOG_WAITING_ERASE_FINISH;
+        return;
+    }
+
+    // 从缓冲区取出不超过当前页剩余空间的字节，记录放不进当前扇区时换到下一个扇区
+    while (n < pageLeft && n < used) {
+        if (log_rec_left == 0) {
+            log_ring_get(log_tail + n, head, sizeof(head));
+            log_rec_left = (head[2] | ((uint32_t)head[3] << 8)) + CHIP_W25Q512_LOG_RECORD_OVERHEAD;
+            if (log_offset + n + log_rec_left > W25Q512_SECTOR_SIZE) {
+                log_rec_left = 0;
+                sectorFull   = true;
+                break;
+            }
+            log_rec_seq++;
+        }
+        take = pageLeft - n < log_rec_left ? pageLeft - n : log_rec_left;
+        log_ring_get(log_tail + n, &log_page[n], take);
+        n += take;
+        log_rec_left -= take;
+    }
+
+    if (n > 0) {
+        w25q512_write_page_no_erase_no_wait(LOG_ADDRESS(log_sector, log_offset), log_page, n);
+        log_stat.programs++;
+        log_offset += n;
+        log_tail += n;
+        log_done_seq = log_rec_left == 0 ? log_rec_seq : log_rec_seq - 1;
+    }
+    if (sectorFull) {
+        log_offset = 0;
+    }
+    if (log_head == log_tail) {
+        log_flush_req = false;
+    } else {
+        log_first_tick = HDL_CPU_Time_GetTick();
+    }
+}
+
+/**
+ * @brief 缓冲区为空并且Flash空闲。
+ *
+ */
+bool CHIP_W25Q512_LOG_is_idle()
+{
+    return log_head == log_tail && log_state == LOG_IDLE && !w25q512_is_busy();
+}
+
+/**
+ * @brief Flash正在编程或者擦除，这时读取需要等待。
+ *
+ */
+bool CHIP_W25Q512_LOG_flash_busy()
+{
+    return w25q512_is_busy();
+}
+
+/**
+ * @brief 已经写入Flash的记录数，也就是下一条写入Flash的记录的序号。
+ *
+ */
+uint32_t CHIP_W25Q512_LOG_record_seq()
+{
+    return log_done_seq;
+}
+
+/**
+ * @brief 把读取位置定位到最近的n条记录。从最新的扇区往回只读扇区头，找到包含目标记录的扇区后
+ * 再跳过扇区中前面的记录，不需要从头遍历整个分区。
+ *
+ * @param pCursor 读取位置。
+ * @param n 记录条数，分区中的记录不够时定位到最老的记录。
+ * @return uint32_t 可以读取的记录条数。
+ */
+uint32_t CHIP_W25Q512_LOG_seek_tail(W25Q512_LogCursor_t *pCursor, uint32_t n)
+{
+    W25Q512_LogHeader_t header;
+    uint8_t head[4];
+    uint32_t target = log_done_seq > n ? log_done_seq - n : 0;
+    uint32_t sector = log_sector;
+    uint32_t seq    = log_sector_seq;
+    bool found      = false;
+
+    pCursor->sector    = log_sector;
+    pCursor->offset    = W25Q512_SECTOR_SIZE;
+    pCursor->sectorSeq = log_sector_seq;
+    pCursor->recSeq    = log_done_seq;
+    if (!log_mounted) {
+        return 0;
+    }
+
+    log_wait_flash();
+    // 正在启用的扇区还没有扇区头
+    if (log_state == LOG_WAITING_ERASE_FINISH) {
+        sector = (sector + W25Q512_LOG_SECTOR_COUNT - 1) % W25Q512_LOG_SECTOR_COUNT;
+        seq--;
+    }
+    for (uint32_t i = 0; i < W25Q512_LOG_SECTOR_COUNT && seq != 0; i++) {
+        if (!log_read_header(sector, &header) || header.sectorSeq != seq) {
+            break;
+        }
+        found              = true;
+        pCursor->sector    = sector;
+        pCursor->offset    = CHIP_W25Q512_LOG_HEADER_LEN;
+        pCursor->sectorSeq = seq;
+        pCursor->recSeq    = header.firstRecSeq;
+        if (header.firstRecSeq <= target) {
+            break;
+        }
+        sector = (sector + W25Q512_LOG_SECTOR_COUNT - 1) % W25Q512_LOG_SECTOR_COUNT;
+        seq--;
+    }
+    if (!found) {
+        return 0;
+    }
+
+    // 只读记录头跳过前面的记录
+    while (pCursor->recSeq < target && pCursor->offset + sizeof(head) <= W25Q512_SECTOR_SIZE) {
+        CHIP_W25Q512_read(LOG_ADDRESS(pCursor->sector, pCursor->offset), head, sizeof(head));
+        if (head[0] != CHIP_W25Q512_LOG_SYNC) {
+            break;
+        }
+        pCursor->offset += (head[2] | ((uint32_t)head[3] << 8)) + CHIP_W25Q512_LOG_RECORD_OVERHEAD;
+        pCursor->recSeq++;
+    }
+    return log_done_seq - pCursor->recSeq;
+}
+
+/**
+ * @brief 读取下一条记录。读取位置所在的扇区被新的日志覆盖时返回-1，可以重新seek。
+ *
+ * @param pCursor 读取位置。
+ * @param pType 记录类型，可以为NULL。
+ * @param buf 存放数据。
+ * @param size buf的大小，数据更长时只读取前size个字节。
+ * @return int32_t 读到的字节数，0表示没有更多的记录，-1表示读取位置已经被覆盖。
+ */
+int32_t CHIP_W25Q512_LOG_read_next(W25Q512_LogCursor_t *pCursor, uint8_t *pType, uint8_t *buf, uint32_t size)
+{
+    W25Q512_LogHeader_t header;
+    uint32_t len      = 0;
+    int32_t recordLen = 0;
+
+    if (!log_mounted || pCursor->recSeq >= log_done_seq) {
+        return 0;
+    }
+    log_wait_flash();
+    if (!log_read_header(pCursor->sector, &header) || header.sectorSeq != pCursor->sectorSeq) {
+        return -1;
+    }
+    recordLen = log_load_record(pCursor->sector, pCursor->offset, pType, buf, size, &len);
+    if (recordLen <= 0) {
+        // 扇区结束或者扇区末尾的记录损坏，从下一个扇区的第一条记录继续
+        pCursor->sector = (pCursor->sector + 1) % W25Q512_LOG_SECTOR_COUNT;
+        if (!log_read_header(pCursor->sector, &header) || header.sectorSeq != pCursor->sectorSeq + 1) {
+            return 0;
+        }
+        pCursor->offset    = CHIP_W25Q512_LOG_HEADER_LEN;
+        pCursor->sectorSeq = header.sectorSeq;
+        pCursor->recSeq    = header.firstRecSeq;
+        recordLen          = log_load_record(pCursor->sector, pCursor->offset, pType, buf, size, &len);
+        if (recordLen <= 0) {
+            return 0;
+        }
+    }
+    pCursor->offset += recordLen;
+    pCursor->recSeq++;
+    return (int32_t)(len < size ? len : size);
+}
+
+void CHIP_W25Q512_LOG_get_stat(W25Q512_LogStat_t *pStat)
+{
+    *pStat = log_stat;
+}
+
+void CHIP_W25Q512_LOG_stat_show()
+{
+    ULOG_INFO("[LOG] records:%u appended:%u dropped:%u programs:%u erases:%u max used:%u/%uB", log_done_seq,
+              log_stat.appended, log_stat.dropped, log_stat.programs, log_stat.erases, log_stat.maxUsed,
+              CHIP_W25Q512_LOG_BUF_SIZE);
+}
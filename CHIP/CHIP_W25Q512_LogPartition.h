@@ -0,0 +1,110 @@
+/**
+ * @file CHIP_W25Q512_LogPartition.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief W25Q512末尾的日志分区，掉电不丢失的环形日志。
+ * 分区占用物理扇区W25Q512_LOG_FIRST_SECTOR开始的W25Q512_LOG_SECTOR_COUNT个扇区，按扇区循环使用，
+ * 写满后擦除最老的扇区。每个扇区开头是扇区头，之后是一条接一条的记录，记录不跨扇区，未写入的区域保持0xFF。
+ * 扇区头（16字节，小端）：
+ * | magic "LOG1"(4) | 扇区序号(4) | 扇区中第一条记录的序号(4) | 前12字节的CRC32(4) |
+ * 记录：
+ * | 0xA5 | 类型(1) | 长度(2) | 数据 | CRC16(2) |，CRC16覆盖类型、长度和数据。
+ * 写入先进入RAM缓冲区，由CHIP_W25Q512_LOG_handler按页批量编程，缓冲区凑够一页、距离第一条未写入的记录
+ * 超过CHIP_W25Q512_LOG_FLUSH_MS或者调用了CHIP_W25Q512_LOG_flush时才编程，高频写日志时每一页只编程一次。
+ * 上电时CHIP_W25Q512_LOG_init读取所有扇区头找到最新的扇区，再扫描这个扇区找到写入位置；
+ * 掉电时正在编程的记录CRC校验失败，这时从下一个扇区继续写，已经写入的记录不受影响。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef CHIP_W25Q512_LOGPARTITION_H
+#define CHIP_W25Q512_LOGPARTITION_H
+#include "CHIP_W25Q512.h"
+
+// 日志分区的扇区数，1MB
+#define W25Q512_LOG_SECTOR_COUNT 256UL
+// 日志分区的第一个物理扇区，在Flash的末尾，FatFS和USB MSC只使用这之前的扇区
+#define W25Q512_LOG_FIRST_SECTOR (W25Q512_SECTOR_COUNT - W25Q512_LOG_SECTOR_COUNT)
+
+// RAM缓冲区大小，必须是2的幂
+#define CHIP_W25Q512_LOG_BUF_SIZE  2048U
+// 缓冲区中的记录最多等待多长时间写入Flash，单位ms
+#define CHIP_W25Q512_LOG_FLUSH_MS  1000U
+// 一条记录最大的数据长度
+#define CHIP_W25Q512_LOG_RECORD_MAX 512U
+
+#define CHIP_W25Q512_LOG_SYNC       0xA5U
+#define CHIP_W25Q512_LOG_HEADER_LEN 16U
+// 记录头(同步字节、类型、长度)和CRC16的长度
+#define CHIP_W25Q512_LOG_RECORD_OVERHEAD 6U
+
+// 记录类型
+#define CHIP_W25Q512_LOG_TYPE_TEXT 0x01U // 文本日志，一条记录是一行
+#define CHIP_W25Q512_LOG_TYPE_DLOG 0x02U // dlog的二进制字节流，按tools/dlog_decode.py解析
+
+/**
+ * @brief 日志分区读取位置。
+ *
+ */
+typedef struct tagW25Q512_LogCursor_t {
+    uint32_t sector;    // 分区内的扇区号
+    uint32_t offset;    // 扇区内下一条记录的偏移
+    uint32_t sectorSeq; // 当前扇区的扇区序号
+    uint32_t recSeq;    // 下一条记录的序号
+} W25Q512_LogCursor_t;
+
+typedef struct tagW25Q512_LogStat_t {
+    uint32_t appended; // 写入缓冲区的记录数
+    uint32_t dropped;  // 缓冲区满或者超长丢弃的记录数
+    uint32_t programs; // 页编程次数
+    uint32_t erases;   // 扇区擦除次数
+    uint32_t maxUsed;  // 缓冲区最大占用，字节
+} W25Q512_LogStat_t;
+
+int32_t CHIP_W25Q512_LOG_init();
+void CHIP_W25Q512_LOG_handler();
+bool CHIP_W25Q512_LOG_append(uint8_t type, const void *buf, uint32_t len);
+void CHIP_W25Q512_LOG_flush();
+bool CHIP_W25Q512_LOG_is_idle();
+bool CHIP_W25Q512_LOG_flash_busy();
+void CHIP_W25Q512_LOG_format();
+uint32_t CHIP_W25Q512_LOG_record_seq();
+uint32_t CHIP_W25Q512_LOG_seek_tail(W25Q512_LogCursor_t *pCursor, uint32_t n);
+int32_t CHIP_W25Q512_LOG_read_next(W25Q512_LogCursor_t *pCursor, uint8_t *pType, uint8_t *buf, uint32_t size);
+void CHIP_W25Q512_LOG_get_stat(W25Q512_LogStat_t *pStat);
+void CHIP_W25Q512_LOG_stat_show();
+
+/*************************Document****************************/
+/*
+
+int main()
+{
+    //...
+    HDL_CPU_Time_Init();
+    CHIP_W25Q512_LOG_init();
+    while (1)
+    {
+        //...some other handler
+        CHIP_W25Q512_LOG_handler();
+        CHIP_W25Q512_LOG_append(CHIP_W25Q512_LOG_TYPE_TEXT, "hello", 5);
+    }
+}
+
+// 读出最近的20条记录
+W25Q512_LogCursor_t cursor;
+uint8_t type;
+uint8_t buf[CHIP_W25Q512_LOG_RECORD_MAX];
+int32_t len;
+CHIP_W25Q512_LOG_flush();
+while (!CHIP_W25Q512_LOG_is_idle()) {
+    CHIP_W25Q512_LOG_handler();
+}
+CHIP_W25Q512_LOG_seek_tail(&cursor, 20);
+while ((len = CHIP_W25Q512_LOG_read_next(&cursor, &type, buf, sizeof(buf))) > 0) {
+    BFL_4G_TCP_Write(SOCKET0, buf, len);
+}
+ */
+/*************************Document End************************/
+#endif // !CHIP_W25Q512_LOGPARTITION_H
@@ -0,0 +1,407 @@
+/**
+ * @file CHIP_W25Q512_MSC.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief USB MSC访问W25Q512的预读双缓冲和写回缓存，见CHIP_W25Q512_MSC.h。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "CHIP_W25Q512_MSC.h"
+#include "HDL_CPU_Time.h"
+#include "log.h"
+
+int32_t w25q512_write_page_no_erase_no_wait(uint32_t address, uint8_t *buf, uint32_t size);
+int32_t w25q512_erase_one_sector_cmd(uint32_t sector);
+
+// 预读缓冲区的个数
+#define MSC_RA_NUM           2
+#define MSC_SECTOR_NONE      0xFFFFFFFFUL
+#define MSC_PAGES_PER_SECTOR (W25Q512_SECTOR_SIZE / W25Q512_PAGE_SIZE)
+
+// 缓冲区按字对齐，DMA读取和逐字比较都用得上
+static uint32_t msc_ra_buf[MSC_RA_NUM][W25Q512_SECTOR_SIZE / 4];
+static uint32_t msc_ra_sector[MSC_RA_NUM] = {MSC_SECTOR_NONE, MSC_SECTOR_NONE}; // 缓冲区中的扇区
+static int32_t msc_ra_loading             = -1;                                 // 正在用DMA读取的缓冲区
+static uint32_t msc_ra_tick;                                                    // 最后一次读取的时刻
+static uint32_t msc_next_sector = MSC_SECTOR_NONE;                              // 顺序读取时下一个扇区
+
+static uint32_t msc_wb_buf[W25Q512_SECTOR_SIZE / 4];
+static uint32_t msc_wb_sector = MSC_SECTOR_NONE; // 写回缓存中的扇区，MSC_SECTOR_NONE表示缓存是空的
+static uint32_t msc_wb_tick;                     // 最后一次写入缓存的时刻
+static bool msc_wb_busy;                         // handler正在分步把缓存写入Flash
+static uint32_t msc_wb_pages;                    // 分步写入时还要编程的页，第i位对应第i页
+static CHIP_W25Q512_MSC_Stat_t msc_stat;
+
+static bool msc_range_ok(uint32_t sector, uint32_t count)
+{
+    return sector < CHIP_W25Q512_MSC_SECTOR_NUM && count <= CHIP_W25Q512_MSC_SECTOR_NUM - sector;
+}
+
+/**
+ * @brief 等待正在进行的预读完成，失败时丢弃这个缓冲区。
+ *
+ */
+static void msc_ra_wait(void)
+{
+    if (msc_ra_loading >= 0) {
+        if (CHIP_W25Q512_read_wait() != 0) {
+            msc_ra_sector[msc_ra_loading] = MSC_SECTOR_NONE;
+            msc_stat.errors++;
+        }
+        msc_ra_loading = -1;
+    }
+}
+
+static void msc_ra_drop(void)
+{
+    msc_ra_wait();
+    for (int32_t i = 0; i < MSC_RA_NUM; i++) {
+        msc_ra_sector[i] = MSC_SECTOR_NONE;
+    }
+}
+
+static int32_t msc_ra_find(uint32_t sector)
+{
+    for (int32_t i = 0; i < MSC_RA_NUM; i++) {
+        if (msc_ra_sector[i] == sector) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 预读sector之后MSC_RA_NUM个扇区中缓冲区里还没有的第一个，放到不在这个范围内的缓冲区中。
+ * QSPI同时只能进行一次读取，每次最多启动一次预读。日志分区、QFS的擦除或者编程没有完成时不预读，
+ * 预读在USB中断中启动，不在中断里等待擦除完成。
+ *
+ */
+static void msc_ra_prefetch(uint32_t sector)
+{
+    int32_t i;
+
+    if (CHIP_W25Q512_IsProgramming()) {
+        return;
+    }
+
+    for (uint32_t next = sector + 1; next <= sector + MSC_RA_NUM && next < CHIP_W25Q512_MSC_SECTOR_NUM; next++) {
+        if (msc_ra_find(next) >= 0 || next == msc_wb_sector) {
+            continue;
+        }
+        for (i = 0; i < MSC_RA_NUM; i++) {
+            if (msc_ra_sector[i] <= sector || msc_ra_sector[i] > sector + MSC_RA_NUM) {
+                break;
+            }
+        }
+        if (i == MSC_RA_NUM) {
+            return;
+        }
+        msc_ra_wait();
+        msc_ra_sector[i] = next;
+        if (CHIP_W25Q512_read_start(next * W25Q512_SECTOR_SIZE, (uint8_t *)msc_ra_buf[i], W25Q512_SECTOR_SIZE) != 0) {
+            msc_ra_sector[i] = MSC_SECTOR_NONE;
+            msc_stat.errors++;
+            return;
+        }
+        msc_ra_loading = i;
+        msc_stat.prefetches++;
+        return;
+    }
+}
+
+/**
+ * @brief 读出缓存中扇区原来的内容比较，算出需要编程的页。内容相同时不擦除也不编程；
+ * 只需要把1写成0时不擦除，只编程有变化的页；否则擦除后只编程不全是0xFF的页。
+ *
+ * @param pPages 需要编程的页，第i位对应第i页。
+ * @param pErase 是否需要擦除。
+ * @return int32_t 成功返回0，读取失败返回-1。
+ */
+static int32_t msc_wb_compare(uint32_t *pPages, bool *pErase)
+{
+    const uint8_t *pNew = (const uint8_t *)msc_wb_buf;
+    uint8_t *pOld       = (uint8_t *)msc_ra_buf[0];
+    bool erase          = false;
+    uint32_t pages      = 0;
+
+    // 借用预读缓冲区存放原来的内容
+    msc_ra_drop();
+    if (CHIP_W25Q512_read(msc_wb_sector * W25Q512_SECTOR_SIZE, pOld, W25Q512_SECTOR_SIZE) != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE / 4; i++) {
+        // 编程只能把1写成0
+        if ((msc_ra_buf[0][i] & msc_wb_buf[i]) != msc_wb_buf[i]) {
+            erase = true;
+            memset(pOld, 0xFF, W25Q512_SECTOR_SIZE);
+            break;
+        }
+    }
+    for (uint32_t page = 0; page < MSC_PAGES_PER_SECTOR; page++) {
+        uint32_t offset = page * W25Q512_PAGE_SIZE;
+        if (memcmp(pOld + offset, pNew + offset, W25Q512_PAGE_SIZE) != 0) {
+            pages |= 1UL << page;
+        }
+    }
+    *pPages = pages;
+    *pErase = erase;
+    return 0;
+}
+
+/**
+ * @brief 缓存中的扇区已经写入Flash。
+ *
+ */
+static void msc_wb_done(bool skipped)
+{
+    msc_stat.flushes++;
+    msc_stat.skipped += skipped;
+    msc_wb_busy   = false;
+    msc_wb_sector = MSC_SECTOR_NONE;
+}
+
+/**
+ * @brief 写入失败：缓存中的扇区保留，计一次错误，过CHIP_W25Q512_MSC_FLUSH_MS后handler再重试。
+ *
+ */
+static int32_t msc_wb_fail(void)
+{
+    msc_stat.errors++;
+    msc_wb_busy = false;
+    msc_wb_tick = HDL_CPU_Time_GetTick();
+    return -1;
+}
+
+/**
+ * @brief 把写回缓存中的扇区写入Flash，等待擦除、编程完成。handler正在分步写入时从头重新比较。
+ *
+ * @return int32_t 成功返回0，失败返回-1，失败时缓存中的数据保留。
+ */
+static int32_t msc_wb_flush(void)
+{
+    uint32_t sector = msc_wb_sector;
+    uint32_t pages  = 0;
+    bool erase      = false;
+
+    if (sector == MSC_SECTOR_NONE) {
+        return 0;
+    }
+    msc_wb_busy = false;
+    if (msc_wb_compare(&pages, &erase) != 0) {
+        return msc_wb_fail();
+    }
+    if (erase) {
+        if (w25q512_erase_one_sector(sector) != 0) {
+            return msc_wb_fail();
+        }
+        msc_stat.erases++;
+    }
+    for (uint32_t page = 0; page < MSC_PAGES_PER_SECTOR; page++) {
+        uint32_t offset = page * W25Q512_PAGE_SIZE;
+        if ((pages & (1UL << page)) == 0) {
+            continue;
+        }
+        if (w25q512_write_page_no_erase(sector * W25Q512_SECTOR_SIZE + offset, (uint8_t *)msc_wb_buf + offset,
+                                        W25Q512_PAGE_SIZE) != 0) {
+            return msc_wb_fail();
+        }
+        msc_stat.pagePrograms++;
+    }
+    msc_wb_done(!erase && pages == 0);
+    return 0;
+}
+
+/**
+ * @brief 分步把写回缓存中的扇区写入Flash，每次调用只做一步，不等待擦除、编程完成：
+ * 第一步读出比较，需要擦除时发出擦除命令；之后每次芯片空闲时发出一页的编程命令。
+ * 期间USB中断写入同一个扇区时从头重新比较，写入另一个扇区时msc_wb_flush直接写完。
+ *
+ */
+static void msc_wb_step(void)
+{
+    uint32_t sector = msc_wb_sector;
+    uint32_t page   = 0;
+    bool erase      = false;
+
+    // 芯片还在擦除、编程（包括上一次中断的分步写入和日志分区），下次再来，读取会等待
+    if (CHIP_W25Q512_IsProgramming()) {
+        return;
+    }
+    if (!msc_wb_busy) {
+        if (msc_wb_compare(&msc_wb_pages, &erase) != 0) {
+            msc_wb_fail();
+            return;
+        }
+        if (!erase && msc_wb_pages == 0) {
+            msc_wb_done(true);
+            return;
+        }
+        msc_wb_busy = true;
+        if (erase) {
+            if (w25q512_erase_one_sector_cmd(sector) != 0) {
+                msc_wb_fail();
+                return;
+            }
+            msc_stat.erases++;
+            return;
+        }
+    }
+    if (msc_wb_pages == 0) {
+        msc_wb_done(false);
+        return;
+    }
+    while ((msc_wb_pages & (1UL << page)) == 0) {
+        page++;
+    }
+    msc_wb_pages &= ~(1UL << page);
+    if (w25q512_write_page_no_erase_no_wait(sector * W25Q512_SECTOR_SIZE + page * W25Q512_PAGE_SIZE,
+                                            (uint8_t *)msc_wb_buf + page * W25Q512_PAGE_SIZE, W25Q512_PAGE_SIZE) != 0) {
+        msc_wb_fail();
+        return;
+    }
+    msc_stat.pagePrograms++;
+}
+
+/**
+ * @brief 读取扇区。写回缓存和预读缓冲区中有的扇区直接复制，没有的扇区直接读到buf。
+ * 这次读取紧接着上一次读取时（顺序读取），返回之前启动下一个扇区的预读。
+ *
+ * @param sector 起始扇区。
+ * @param buf 至少count个扇区大小的缓冲区。
+ * @param count 扇区数。
+ * @return int32_t 成功返回0，失败返回-1。
+ */
+int32_t CHIP_W25Q512_MSC_read(uint32_t sector, uint8_t *buf, uint32_t count)
+{
+    if (!msc_range_ok(sector, count)) {
+        return -1;
+    }
+    for (uint32_t n = 0; n < count; n++, sector++, buf += W25Q512_SECTOR_SIZE) {
+        bool sequential = sector == msc_next_sector;
+        int32_t i       = msc_ra_find(sector);
+
+        if (i >= 0 && i == msc_ra_loading) {
+            msc_ra_wait();
+            i = msc_ra_find(sector);
+        }
+        if (sector == msc_wb_sector) {
+            memcpy(buf, msc_wb_buf, W25Q512_SECTOR_SIZE);
+            msc_stat.readHits++;
+        } else if (i >= 0) {
+            memcpy(buf, msc_ra_buf[i], W25Q512_SECTOR_SIZE);
+            msc_stat.readHits++;
+        } else {
+            // 随机读取时预读的数据用不上
+            if (sequential) {
+                msc_ra_wait();
+            } else {
+                msc_ra_drop();
+            }
+            if (CHIP_W25Q512_read(sector * W25Q512_SECTOR_SIZE, buf, W25Q512_SECTOR_SIZE) != 0) {
+                msc_stat.errors++;
+                return -1;
+            }
+        }
+        msc_stat.readSectors++;
+        msc_next_sector = sector + 1;
+        if (sequential || i >= 0) {
+            msc_ra_prefetch(sector);
+        }
+    }
+    msc_ra_tick = HDL_CPU_Time_GetTick();
+    return 0;
+}
+
+/**
+ * @brief 写入扇区。数据放入写回缓存后返回，缓存中原来是另一个扇区时先把它写入Flash。
+ *
+ * @param sector 起始扇区。
+ * @param buf 待写入的数据，count个扇区。
+ * @param count 扇区数。
+ * @return int32_t 成功返回0，失败返回-1。缓存中原来的扇区写入Flash失败时它仍然留在缓存中，
+ * 这次的数据没有写入。
+ */
+int32_t CHIP_W25Q512_MSC_write(uint32_t sector, const uint8_t *buf, uint32_t count)
+{
+    if (!msc_range_ok(sector, count)) {
+        return -1;
+    }
+    for (uint32_t n = 0; n < count; n++, sector++, buf += W25Q512_SECTOR_SIZE) {
+        int32_t i = msc_ra_find(sector);
+
+        if (i >= 0) {
+            msc_ra_wait();
+            msc_ra_sector[i] = MSC_SECTOR_NONE;
+        }
+        if (sector == msc_wb_sector) {
+            // handler分步写入的是旧的内容，重新比较
+            msc_wb_busy = false;
+            msc_stat.writeMerged++;
+        } else if (msc_wb_flush() != 0) {
+            // 缓存中原来的扇区没有写入，保留它，这次写入失败
+            return -1;
+        }
+        memcpy(msc_wb_buf, buf, W25Q512_SECTOR_SIZE);
+        msc_wb_sector = sector;
+        msc_stat.writeSectors++;
+    }
+    msc_wb_tick = HDL_CPU_Time_GetTick();
+    return 0;
+}
+
+/**
+ * @brief 把写回缓存中的数据写入Flash，等待完成。主机同步缓存、允许移除和弹出时调用。
+ *
+ * @return int32_t 成功返回0，失败返回-1，失败时数据仍然留在缓存中。
+ */
+int32_t CHIP_W25Q512_MSC_flush(void)
+{
+    return msc_wb_flush();
+}
+
+/**
+ * @brief 在主循环中调用：写回缓存超过CHIP_W25Q512_MSC_FLUSH_MS没有新的写入时分步写入Flash，
+ * 每次调用只读出比较或者发出一个擦除、编程命令，不等待完成。
+ * 超过这个时间没有读取时丢弃预读的数据，Flash可能已经被FatFS修改。
+ * 和USB中断中的读写不能同时进行，调用时需要屏蔽USB中断，屏蔽的时间不包括擦除和编程。
+ *
+ */
+void CHIP_W25Q512_MSC_handler(void)
+{
+    uint32_t now = HDL_CPU_Time_GetTick();
+
+    if (msc_wb_sector != MSC_SECTOR_NONE && (msc_wb_busy || now - msc_wb_tick >= CHIP_W25Q512_MSC_FLUSH_MS)) {
+        msc_wb_step();
+    }
+    if (msc_next_sector != MSC_SECTOR_NONE && now - msc_ra_tick >= CHIP_W25Q512_MSC_FLUSH_MS) {
+        msc_ra_drop();
+        msc_next_sector = MSC_SECTOR_NONE;
+    }
+}
+
+bool CHIP_W25Q512_MSC_is_dirty(void)
+{
+    return msc_wb_sector != MSC_SECTOR_NONE;
+}
+
+void CHIP_W25Q512_MSC_get_stat(CHIP_W25Q512_MSC_Stat_t *pStat)
+{
+    *pStat = msc_stat;
+}
+
+void CHIP_W25Q512_MSC_reset_stat(void)
+{
+    memset(&msc_stat, 0, sizeof(msc_stat));
+}
+
+void CHIP_W25Q512_MSC_stat_show(void)
+{
+    ULOG_INFO("[MSC] read:%u hit:%u prefetch:%u write:%u merged:%u", msc_stat.readSectors, msc_stat.readHits,
+              msc_stat.prefetches, msc_stat.writeSectors, msc_stat.writeMerged);
+    ULOG_INFO("[MSC] flush:%u skipped:%u erases:%u programs:%u errors:%u", msc_stat.flushes, msc_stat.skipped,
+              msc_stat.erases, msc_stat.pagePrograms, msc_stat.errors);
+}
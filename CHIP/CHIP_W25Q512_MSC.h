@@ -0,0 +1,61 @@
+/**
+ * @file CHIP_W25Q512_MSC.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief USB MSC访问W25Q512的读写缓存，块大小为一个扇区（4KB），在USB中断中调用。
+ * 读：两个扇区的预读双缓冲。连续读取时返回数据之后立即用DMA读取下一个扇区，
+ * Flash读取和USB传输同时进行，下一次读取时数据通常已经在缓冲区中。
+ * 写：一个扇区的写回缓存。写入的数据先放在缓存中，写入另一个扇区、CHIP_W25Q512_MSC_flush（主机同步缓存、
+ * 允许移除、弹出）或者距离最后一次写入超过CHIP_W25Q512_MSC_FLUSH_MS时才写入Flash，
+ * 同一个扇区的连续写入（FAT、目录项）合并为一次。超时的写入由主循环中的handler分步进行，不等待擦除和编程。
+ * 写入Flash失败时数据留在缓存中，计一次错误，之后再重试。
+ * 写入Flash之前读出原来的内容比较：内容相同时跳过；只需要把1写成0时不擦除，只编程有变化的页；
+ * 否则擦除后只编程不全是0xFF的页。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef CHIP_W25Q512_MSC_H
+#define CHIP_W25Q512_MSC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "CHIP_W25Q512_QueueFileSystem.h"
+
+// 主机可以访问的扇区数，末尾的QFS和日志分区不给主机使用
+#define CHIP_W25Q512_MSC_SECTOR_NUM W25Q512_DISK_SECTOR_COUNT
+// 写回缓存中的数据最多等待多长时间写入Flash，单位ms
+#define CHIP_W25Q512_MSC_FLUSH_MS   200U
+
+typedef struct {
+    uint32_t readSectors;   // 主机读取的扇区数
+    uint32_t readHits;      // 其中由预读缓冲区或者写回缓存提供的扇区数
+    uint32_t prefetches;    // 启动的预读次数
+    uint32_t writeSectors;  // 主机写入的扇区数
+    uint32_t writeMerged;   // 其中写入缓存中同一个扇区、合并掉的次数
+    uint32_t flushes;       // 写入Flash完成的扇区数，包括跳过的扇区
+    uint32_t skipped;       // 其中内容没有变化、跳过的扇区数
+    uint32_t erases;        // 擦除的扇区数
+    uint32_t pagePrograms;  // 编程的页数
+    uint32_t errors;        // 读写失败的次数
+} CHIP_W25Q512_MSC_Stat_t;
+
+int32_t CHIP_W25Q512_MSC_read(uint32_t sector, uint8_t *buf, uint32_t count);
+int32_t CHIP_W25Q512_MSC_write(uint32_t sector, const uint8_t *buf, uint32_t count);
+int32_t CHIP_W25Q512_MSC_flush(void);
+void CHIP_W25Q512_MSC_handler(void);
+bool CHIP_W25Q512_MSC_is_dirty(void);
+void CHIP_W25Q512_MSC_get_stat(CHIP_W25Q512_MSC_Stat_t *pStat);
+void CHIP_W25Q512_MSC_reset_stat(void);
+void CHIP_W25Q512_MSC_stat_show(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !CHIP_W25Q512_MSC_H
@@ -0,0 +1,473 @@
+/**
+ * @file CHIP_W25Q512_MSC_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief CHIP_W25Q512_MSC测试，和原来USB MSC回调中逐扇区读写Flash的方式对照：
+ * 顺序读出2MB（一天的日志），每个扇区之后等待全速USB的传输时间，比较CPU等待Flash的时间和总时间；
+ * 按主机复制文件的写入序列写入（数据扇区、反复更新的FAT和目录项、同步时内容不变的重写），
+ * 比较擦除、页编程次数和等待时间，检查两种方式写入后Flash的内容相同，
+ * 再检查未写入Flash的扇区可以读回、超时后由handler分步写入Flash（不等待擦除、编程）、内容不变的重写不擦除也不编程，
+ * 以及写入Flash失败时数据保留在缓存中、计错误、之后重试成功。
+ * 次数、等待时间的比较和故障注入需要主机上的W25Q512模型，目标板上只检查内容和分步写入。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "CHIP_W25Q512_MSC_test.h"
+#include "CHIP_W25Q512.h"
+#include "HDL_CPU_Time.h"
+#include "log.h"
+
+// 全速USB批量传输一个4KB扇区的时间，约900KB/s
+#define USB_SECTOR_NS  4500000ULL
+// 读取测试的区域：2MB
+#define READ_FIRST     2048U
+#define READ_SECTORS   512U
+// 写入测试的区域：FAT、目录项和数据区
+#define WRITE_FAT      8192U
+#define WRITE_DIR      (WRITE_FAT + 1)
+#define WRITE_DATA     (WRITE_FAT + 16)
+// 复制的文件数和每个文件的扇区数，每16个扇区更新一次FAT和目录项
+#define COPY_FILES     2U
+#define FILE_SECTORS   32U
+#define CHUNK_SECTORS  16U
+#define WRITE_SECTORS  (WRITE_DATA + COPY_FILES * FILE_SECTORS - WRITE_FAT)
+
+typedef struct {
+    uint32_t sector;
+    uint32_t version; // 同一个扇区的第几个版本，决定内容
+} TraceOp_t;
+
+static uint8_t _gSector[W25Q512_SECTOR_SIZE];
+static uint8_t _gRead[W25Q512_SECTOR_SIZE];
+static uint8_t _gExpect[WRITE_SECTORS][W25Q512_SECTOR_SIZE];
+static TraceOp_t _gTrace[256];
+static uint32_t _gTraceLen                         = 0;
+static const CHIP_W25Q512_MSC_TestHooks_t *_gHooks = NULL;
+static uint64_t _gStartNs                          = 0;
+static uint32_t _gErrorCnt                         = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[MSC Test] check failed: %s", what);
+    }
+}
+
+static uint64_t now_ns()
+{
+    return HDL_CPU_Time_GetUsTick64() * 1000ULL;
+}
+
+static void flash_reset_stat()
+{
+    if (_gHooks != NULL) {
+        _gHooks->reset_stat();
+    } else {
+        _gStartNs = now_ns();
+    }
+}
+
+// 没有模型时只有经过的时间
+static void flash_get_stat(CHIP_W25Q512_MSC_TestStat_t *pStat)
+{
+    if (_gHooks != NULL) {
+        _gHooks->get_stat(pStat);
+    } else {
+        memset(pStat, 0, sizeof(CHIP_W25Q512_MSC_TestStat_t));
+        pStat->nowNs = now_ns() - _gStartNs;
+    }
+}
+
+static void flash_elapse(uint64_t ns)
+{
+    if (_gHooks != NULL) {
+        _gHooks->elapse(ns);
+    } else {
+        HDL_CPU_Time_DelayUs((uint32_t)(ns / 1000U));
+    }
+}
+
+// 读取区域中第sector个扇区的内容
+static void read_pattern(uint32_t sector, uint8_t *buf)
+{
+    for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+        buf[i] = (uint8_t)(sector * 7U + i * 13U + (i >> 8));
+    }
+}
+
+/**
+ * @brief 写入序列中扇区的内容：FAT按版本分配更多的簇，目录项按版本增加文件和长度，
+ * 数据扇区只有一个版本。
+ *
+ */
+static void trace_content(uint32_t sector, uint32_t version, uint8_t *buf)
+{
+    memset(buf, 0, W25Q512_SECTOR_SIZE);
+    if (sector == WRITE_FAT) {
+        // 每个版本多分配一块的簇，FAT16表项是下一个簇号
+        for (uint32_t i = 0; i < version * CHUNK_SECTORS && i < W25Q512_SECTOR_SIZE / 2 - 2; i++) {
+            buf[4 + i * 2]     = (uint8_t)(i + 3);
+            buf[4 + i * 2 + 1] = 0;
+        }
+    } else if (sector == WRITE_DIR) {
+        // 每个文件一个32字节的目录项，版本号的高位是文件序号，低位是写入的块数
+        for (uint32_t f = 0; f <= version >> 8; f++) {
+            uint32_t size = f < version >> 8 ? FILE_SECTORS : (version & 0xFF) * CHUNK_SECTORS;
+            memcpy(buf + f * 32, "LOG     TXT", 11);
+            buf[f * 32 + 7]  = (uint8_t)('0' + f);
+            buf[f * 32 + 28] = (uint8_t)(size * W25Q512_SECTOR_SIZE);
+            buf[f * 32 + 29] = (uint8_t)(size * W25Q512_SECTOR_SIZE >> 8);
+            buf[f * 32 + 30] = (uint8_t)(size * W25Q512_SECTOR_SIZE >> 16);
+        }
+    } else {
+        for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+            buf[i] = (uint8_t)(sector * 31U + i * 3U + version);
+        }
+    }
+}
+
+static void trace_add(uint32_t sector, uint32_t version)
+{
+    _gTrace[_gTraceLen].sector  = sector;
+    _gTrace[_gTraceLen].version = version;
+    _gTraceLen++;
+}
+
+/**
+ * @brief 主机复制文件的写入序列：新建目录项，每16个数据扇区之后更新FAT和目录项，
+ * 文件结束时目录项连续写两次（长度、属性），最后同步时FAT和目录项内容不变地再写一次。
+ *
+ */
+static void trace_build()
+{
+    uint32_t fatVersion = 0;
+    uint32_t dirVersion = 0;
+    uint32_t data       = WRITE_DATA;
+
+    for (uint32_t f = 0; f < COPY_FILES; f++) {
+        dirVersion = f << 8;
+        trace_add(WRITE_DIR, dirVersion);
+        for (uint32_t chunk = 0; chunk < FILE_SECTORS / CHUNK_SECTORS; chunk++) {
+            for (uint32_t i = 0; i < CHUNK_SECTORS; i++) {
+                trace_add(data++, 0);
+            }
+            trace_add(WRITE_FAT, ++fatVersion);
+            trace_add(WRITE_DIR, ++dirVersion);
+        }
+        trace_add(WRITE_DIR, dirVersion);
+    }
+    trace_add(WRITE_FAT, fatVersion);
+    trace_add(WRITE_DIR, dirVersion);
+
+    for (uint32_t i = 0; i < _gTraceLen; i++) {
+        trace_content(_gTrace[i].sector, _gTrace[i].version, _gExpect[_gTrace[i].sector - WRITE_FAT]);
+    }
+}
+
+/**
+ * @brief 写入区域的初始状态：FAT和目录项是空的（全0），数据区前一半是删除的文件留下的旧数据，后一半已经擦除。
+ *
+ */
+static void write_area_reset()
+{
+    memset(_gSector, 0, sizeof(_gSector));
+    w25q512_write_one_sector(WRITE_FAT, _gSector);
+    w25q512_write_one_sector(WRITE_DIR, _gSector);
+    for (uint32_t s = WRITE_DATA; s < WRITE_FAT + WRITE_SECTORS; s++) {
+        if (s < WRITE_DATA + COPY_FILES * FILE_SECTORS / 2) {
+            trace_content(s, 0x55, _gSector);
+            w25q512_write_one_sector(s, _gSector);
+        } else {
+            w25q512_erase_one_sector(s);
+        }
+    }
+}
+
+static void write_area_verify(const char *what)
+{
+    uint32_t bad = 0;
+
+    for (uint32_t s = 0; s < WRITE_SECTORS; s++) {
+        CHIP_W25Q512_read(((WRITE_FAT + s) * W25Q512_SECTOR_SIZE), _gRead, W25Q512_SECTOR_SIZE);
+        if (s == WRITE_DIR - WRITE_FAT || s == 0 || s >= WRITE_DATA - WRITE_FAT) {
+            bad += memcmp(_gRead, _gExpect[s], W25Q512_SECTOR_SIZE) != 0;
+        }
+    }
+    check(bad == 0, what);
+}
+
+static void stat_show(const char *name, uint32_t sectors, const CHIP_W25Q512_MSC_TestStat_t *pStat)
+{
+    ULOG_INFO("[MSC Test] %s: %u sectors, %u erases, %u page programs, flash wait %.1f ms, total %.2f s (%.0f KB/s)",
+              name, sectors, pStat->erases, pStat->pagePrograms, (double)pStat->waitNs / 1e6, (double)pStat->nowNs / 1e9,
+              (double)sectors * W25Q512_SECTOR_SIZE / 1024.0 / ((double)pStat->nowNs / 1e9));
+}
+
+static void read_test()
+{
+    CHIP_W25Q512_MSC_TestStat_t legacy;
+    CHIP_W25Q512_MSC_TestStat_t cached;
+    CHIP_W25Q512_MSC_Stat_t msc;
+    uint32_t bad = 0;
+
+    for (uint32_t s = 0; s < READ_SECTORS; s++) {
+        read_pattern(s, _gSector);
+        w25q512_write_one_sector(READ_FIRST + s, _gSector);
+    }
+
+    // 原来的回调：每个扇区在回调中读取
+    flash_reset_stat();
+    for (uint32_t s = 0; s < READ_SECTORS; s++) {
+        CHIP_W25Q512_read_one_sector(READ_FIRST + s, _gRead);
+        flash_elapse(USB_SECTOR_NS);
+    }
+    flash_get_stat(&legacy);
+    stat_show("legacy read", READ_SECTORS, &legacy);
+
+    flash_reset_stat();
+    CHIP_W25Q512_MSC_reset_stat();
+    for (uint32_t s = 0; s < READ_SECTORS; s++) {
+        check(CHIP_W25Q512_MSC_read(READ_FIRST + s, _gRead, 1) == 0, "msc read");
+        read_pattern(s, _gSector);
+        bad += memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) != 0;
+        flash_elapse(USB_SECTOR_NS);
+    }
+    flash_get_stat(&cached);
+    CHIP_W25Q512_MSC_get_stat(&msc);
+    stat_show("read-ahead", READ_SECTORS, &cached);
+    CHIP_W25Q512_MSC_stat_show();
+
+    check(bad == 0, "read-ahead data");
+    check(msc.readHits >= READ_SECTORS - 2, "sequential reads served from read-ahead buffer");
+    if (_gHooks != NULL) {
+        check(cached.waitNs * 10 < legacy.waitNs, "flash read overlapped with USB transfer");
+        check(cached.nowNs < legacy.nowNs, "shorter total time than legacy");
+    }
+
+    // 随机读取不预读
+    CHIP_W25Q512_MSC_reset_stat();
+    for (uint32_t s = 0; s < 8; s++) {
+        check(CHIP_W25Q512_MSC_read(READ_FIRST + (s * 37U) % READ_SECTORS, _gRead, 1) == 0, "random read");
+        read_pattern((s * 37U) % READ_SECTORS, _gSector);
+        bad += memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) != 0;
+    }
+    CHIP_W25Q512_MSC_get_stat(&msc);
+    check(bad == 0, "random read data");
+    check(msc.prefetches == 0, "no prefetch for random reads");
+}
+
+static void wait_flush_timeout()
+{
+    uint32_t start = HDL_CPU_Time_GetTick();
+
+    while (HDL_CPU_Time_GetTick() - start <= CHIP_W25Q512_MSC_FLUSH_MS) {
+        HDL_CPU_Time_DelayMs(10);
+    }
+}
+
+/**
+ * @brief 像主循环一样反复调用handler直到缓存写入Flash，每次调用之间推进1ms模型时间。
+ * 有模型时检查每次调用都不等待擦除、编程完成。
+ *
+ * @return uint32_t 调用的次数。
+ */
+static uint32_t handler_until_clean()
+{
+    CHIP_W25Q512_MSC_TestStat_t before;
+    CHIP_W25Q512_MSC_TestStat_t after;
+    uint64_t maxWaitNs = 0;
+    uint32_t calls     = 0;
+
+    while (CHIP_W25Q512_MSC_is_dirty() && calls < 1000) {
+        flash_get_stat(&before);
+        CHIP_W25Q512_MSC_handler();
+        flash_get_stat(&after);
+        if (after.waitNs - before.waitNs > maxWaitNs) {
+            maxWaitNs = after.waitNs - before.waitNs;
+        }
+        flash_elapse(1000000ULL);
+        calls++;
+    }
+    if (_gHooks != NULL) {
+        check(maxWaitNs < _gHooks->programNs, "handler does not wait for erase or program");
+    }
+    return calls;
+}
+
+/**
+ * @brief 写入Flash失败时缓存中的数据保留并计错误，之后可以重试。需要模型注入故障。
+ *
+ * @return uint32_t handler调用的次数。
+ */
+static uint32_t write_error_test()
+{
+    CHIP_W25Q512_MSC_Stat_t msc;
+    uint32_t calls = 0;
+
+    // 缓存换出时擦除失败：这次写入失败，原来的扇区留在缓存中
+    trace_content(WRITE_DATA, 0x81, _gSector);
+    check(CHIP_W25Q512_MSC_write(WRITE_DATA, _gSector, 1) == 0, "write before flush error");
+    CHIP_W25Q512_MSC_reset_stat();
+    _gHooks->fail_ops(1);
+    trace_content(WRITE_DATA + 1, 0x82, _gRead);
+    check(CHIP_W25Q512_MSC_write(WRITE_DATA + 1, _gRead, 1) != 0, "write fails when evicting sector fails");
+    CHIP_W25Q512_MSC_get_stat(&msc);
+    check(msc.errors == 1 && msc.flushes == 0, "flush error counted");
+    check(CHIP_W25Q512_MSC_is_dirty(), "failed sector kept in cache");
+    check(CHIP_W25Q512_MSC_read(WRITE_DATA, _gRead, 1) == 0 && memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) == 0,
+          "failed sector still readable");
+    // 主机同步时重试成功
+    check(CHIP_W25Q512_MSC_flush() == 0 && !CHIP_W25Q512_MSC_is_dirty(), "sync flush after error");
+    CHIP_W25Q512_read(WRITE_DATA * W25Q512_SECTOR_SIZE, _gRead, W25Q512_SECTOR_SIZE);
+    check(memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) == 0, "content after retried flush");
+    check(CHIP_W25Q512_MSC_flush() == 0, "flush with empty cache");
+
+    // handler分步写入时擦除命令失败：保留，超时后重试
+    trace_content(WRITE_DATA, 0x83, _gSector);
+    CHIP_W25Q512_MSC_write(WRITE_DATA, _gSector, 1);
+    CHIP_W25Q512_MSC_reset_stat();
+    _gHooks->fail_ops(1);
+    wait_flush_timeout();
+    for (uint32_t i = 0; i < 40 && CHIP_W25Q512_MSC_is_dirty(); i++) {
+        CHIP_W25Q512_MSC_handler();
+        flash_elapse(_gHooks->eraseNs);
+    }
+    CHIP_W25Q512_MSC_get_stat(&msc);
+    check(msc.errors == 1 && CHIP_W25Q512_MSC_is_dirty(), "background flush error kept sector");
+    wait_flush_timeout();
+    calls = handler_until_clean();
+    CHIP_W25Q512_MSC_get_stat(&msc);
+    check(!CHIP_W25Q512_MSC_is_dirty() && msc.flushes == 1 && msc.errors == 1, "background flush retried");
+    CHIP_W25Q512_read(WRITE_DATA * W25Q512_SECTOR_SIZE, _gRead, W25Q512_SECTOR_SIZE);
+    check(memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) == 0, "content after background retry");
+    return calls;
+}
+
+/**
+ * @brief 分步写入期间主机写入同一个扇区时写入最新的内容。
+ *
+ */
+static void rewrite_test()
+{
+    uint32_t calls = 0;
+
+    if (_gHooks != NULL) {
+        calls = write_error_test();
+    }
+    // 分步写入期间主机写入同一个扇区：写入的是最新的内容
+    trace_content(WRITE_DATA, 0x84, _gSector);
+    CHIP_W25Q512_MSC_write(WRITE_DATA, _gSector, 1);
+    wait_flush_timeout();
+    CHIP_W25Q512_MSC_handler();
+    check(CHIP_W25Q512_IsProgramming(), "erase runs in background");
+    trace_content(WRITE_DATA, 0x85, _gSector);
+    CHIP_W25Q512_MSC_write(WRITE_DATA, _gSector, 1);
+    CHIP_W25Q512_MSC_handler();
+    check(CHIP_W25Q512_MSC_is_dirty(), "new write restarts the timeout");
+    wait_flush_timeout();
+    calls += handler_until_clean();
+    CHIP_W25Q512_read(WRITE_DATA * W25Q512_SECTOR_SIZE, _gRead, W25Q512_SECTOR_SIZE);
+    check(memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) == 0, "rewrite during background flush");
+    ULOG_INFO("[MSC Test] background flush: %u handler calls", calls);
+}
+
+static void write_test()
+{
+    CHIP_W25Q512_MSC_TestStat_t legacy;
+    CHIP_W25Q512_MSC_TestStat_t cached;
+    CHIP_W25Q512_MSC_Stat_t msc;
+
+    trace_build();
+
+    // 原来的回调：每个扇区在回调中擦除（没有擦除时）、编程
+    write_area_reset();
+    flash_reset_stat();
+    for (uint32_t i = 0; i < _gTraceLen; i++) {
+        trace_content(_gTrace[i].sector, _gTrace[i].version, _gSector);
+        w25q512_write_one_sector(_gTrace[i].sector, _gSector);
+        flash_elapse(USB_SECTOR_NS);
+    }
+    flash_get_stat(&legacy);
+    stat_show("legacy write", _gTraceLen, &legacy);
+    write_area_verify("legacy write content");
+
+    write_area_reset();
+    flash_reset_stat();
+    CHIP_W25Q512_MSC_reset_stat();
+    for (uint32_t i = 0; i < _gTraceLen; i++) {
+        trace_content(_gTrace[i].sector, _gTrace[i].version, _gSector);
+        check(CHIP_W25Q512_MSC_write(_gTrace[i].sector, _gSector, 1) == 0, "msc write");
+        flash_elapse(USB_SECTOR_NS);
+    }
+    check(CHIP_W25Q512_MSC_flush() == 0, "msc flush");
+    flash_get_stat(&cached);
+    CHIP_W25Q512_MSC_get_stat(&msc);
+    stat_show("write-back", _gTraceLen, &cached);
+    CHIP_W25Q512_MSC_stat_show();
+    write_area_verify("write-back content");
+
+    check(msc.writeMerged >= COPY_FILES, "consecutive writes to the same sector merged");
+    check(msc.skipped >= 2, "unchanged sectors skipped");
+    check(msc.errors == 0, "no errors");
+    if (_gHooks != NULL) {
+        check(cached.erases < legacy.erases, "fewer erases than legacy");
+        check(cached.pagePrograms < legacy.pagePrograms, "fewer page programs than legacy");
+        check(cached.waitNs < legacy.waitNs, "less flash wait than legacy");
+    }
+
+    // 同样的内容再写一遍：不擦除也不编程
+    flash_reset_stat();
+    for (uint32_t s = 0; s < WRITE_SECTORS; s++) {
+        if (s == 0 || s == WRITE_DIR - WRITE_FAT || s >= WRITE_DATA - WRITE_FAT) {
+            CHIP_W25Q512_MSC_write(WRITE_FAT + s, _gExpect[s], 1);
+        }
+    }
+    CHIP_W25Q512_MSC_flush();
+    flash_get_stat(&cached);
+    if (_gHooks != NULL) {
+        check(cached.erases == 0 && cached.pagePrograms == 0, "identical rewrite neither erases nor programs");
+    }
+
+    // 缓存中的扇区可以读回，超时后由handler写入Flash
+    trace_content(WRITE_DATA, 0x77, _gSector);
+    CHIP_W25Q512_MSC_write(WRITE_DATA, _gSector, 1);
+    check(CHIP_W25Q512_MSC_is_dirty(), "write cached");
+    check(CHIP_W25Q512_MSC_read(WRITE_DATA, _gRead, 1) == 0 && memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) == 0,
+          "read back cached sector");
+    CHIP_W25Q512_MSC_handler();
+    check(CHIP_W25Q512_MSC_is_dirty(), "not flushed before timeout");
+    wait_flush_timeout();
+    CHIP_W25Q512_MSC_handler();
+    check(CHIP_W25Q512_MSC_is_dirty(), "erase started, not waited");
+    handler_until_clean();
+    check(!CHIP_W25Q512_MSC_is_dirty(), "flushed after timeout");
+    CHIP_W25Q512_read(WRITE_DATA * W25Q512_SECTOR_SIZE, _gRead, W25Q512_SECTOR_SIZE);
+    check(memcmp(_gRead, _gSector, W25Q512_SECTOR_SIZE) == 0, "flushed content");
+
+    // 超出主机可以访问的范围
+    check(CHIP_W25Q512_MSC_write(CHIP_W25Q512_MSC_SECTOR_NUM, _gSector, 1) != 0, "write past end fails");
+    check(CHIP_W25Q512_MSC_read(CHIP_W25Q512_MSC_SECTOR_NUM - 1, _gRead, 2) != 0, "read past end fails");
+}
+
+/**
+ * @brief CHIP_W25Q512_MSC测试，会改写Flash第2048扇区开始的2MB和第8192扇区开始的80个扇区。
+ *
+ * @param pHooks Flash的统计和故障注入，没有时为NULL，只检查读写的内容和handler的分步写入。
+ * @return uint32_t 错误数。
+ */
+uint32_t CHIP_W25Q512_MSC_test(const CHIP_W25Q512_MSC_TestHooks_t *pHooks)
+{
+    _gHooks    = pHooks;
+    _gErrorCnt = 0;
+    _gTraceLen = 0;
+    read_test();
+    write_test();
+    rewrite_test();
+    ULOG_INFO("[MSC Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
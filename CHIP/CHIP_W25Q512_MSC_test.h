@@ -0,0 +1,35 @@
+/**
+ * @file CHIP_W25Q512_MSC_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef CHIP_W25Q512_MSC_TEST_H
+#define CHIP_W25Q512_MSC_TEST_H
+#include <stdint.h>
+#include "CHIP_W25Q512_MSC.h"
+
+typedef struct {
+    uint32_t erases;       // 扇区擦除次数
+    uint32_t pagePrograms; // 页编程次数
+    uint64_t waitNs;       // CPU等待Flash的时间
+    uint64_t nowNs;        // 清零以来的时间
+} CHIP_W25Q512_MSC_TestStat_t;
+
+// Flash的统计和故障注入，主机上由W25Q512模型提供，目标板上为NULL
+typedef struct {
+    void (*reset_stat)(void);
+    void (*get_stat)(CHIP_W25Q512_MSC_TestStat_t *pStat);
+    void (*elapse)(uint64_t ns);  // 推进时间，模拟USB传输和主循环的间隔
+    void (*fail_ops)(uint32_t n); // 之后的n次擦除、编程失败
+    uint64_t programNs;           // 页编程时间
+    uint64_t eraseNs;             // 扇区擦除时间
+} CHIP_W25Q512_MSC_TestHooks_t;
+
+uint32_t CHIP_W25Q512_MSC_test(const CHIP_W25Q512_MSC_TestHooks_t *pHooks);
+#endif // !CHIP_W25Q512_MSC_TEST_H
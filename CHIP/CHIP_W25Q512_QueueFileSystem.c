@@ -36,9 +36,9 @@ uint32_t CHIP_W25Q512_QFS_asyn_pop(uint8_t *buf, uint32_t pop_len);
 // QFS头部信息存储扇区大小,一个扇区
 #define QFS_HEADER_SECTOR_SIZE 1
 // QFS数据区域逻辑扇区数量,最大为W25Q512_SECTOR_COUNT - 1UL，有一个扇区用于存储头部信息。
-#define QFS_DATA_FILED_LOGIC_SECTOR_COUNT (W25Q512_SECTOR_COUNT / 4 - 1UL)
+#define QFS_DATA_FILED_LOGIC_SECTOR_COUNT (W25Q512_QFS_SECTOR_COUNT - QFS_HEADER_SECTOR_SIZE)
 // 逻辑扇区号到物理扇区号的偏移.例如这个偏移量等于1时表示QFS从物理扇区编号1开始存储数据
-#define LOGIC_SECTOR_OFFSET_OF_PHYSICAL_SECTOR_INDEX (W25Q512_SECTOR_COUNT / 4)
+#define LOGIC_SECTOR_OFFSET_OF_PHYSICAL_SECTOR_INDEX W25Q512_QFS_FIRST_SECTOR
 
 #define QFS_HEADER_PHYSICAL_SECTOR_INDEX             (LOGIC_SECTOR_OFFSET_OF_PHYSICAL_SECTOR_INDEX)
 // QFS的数据存储区域始终开始于首部信息存储扇区之后的一个扇区，也就是物理扇区索引@QFS_HEADER_PHYSICAL_SECTOR_INDEX + 1的位置
@@ -76,6 +76,11 @@ uint8_t flush_data2flash_threshold_persentage = 60;
 
 // QFS写入缓存
 uint8_t qfs_wbuffer[W25Q512_SECTOR_SIZE] = {0};
+// QFS为空时直接从写入缓存队列读出的字节数（对扇区大小取余），下一个写入的扇区中这部分填充0xFF，
+// 使数据在扇区中的偏移始终等于它在写入的字节流中的位置对扇区大小取余，调用者可以按扇区边界对齐数据
+static uint32_t qfs_wqueue_poped = 0;
+// 正在写入的扇区开头填充的字节数
+static uint32_t qfs_wbuffer_poped = 0;
 
 // 测试QFS写入缓存队列的性能所用到的变量
 // 从写入缓存队列中读取到的字节数
@@ -111,14 +116,16 @@ void CHIP_W25Q512_QFS_init()
 
     // 创建QFS写入缓存队列
     c_arr_queue_create(&qfs_wqueue, qfs_wqueue_buf, sizeof(qfs_wqueue_buf));
+    qfs_wqueue_poped = 0;
 
     if (CHIP_W25Q512_QFS_isFormated()) {
         // 更新当前的状态到内存中
         QFSHeader_t _header;
         CHIP_W25Q512_read(LOGIC_SECTOR_OFFSET_OF_PHYSICAL_SECTOR_INDEX * W25Q512_SECTOR_SIZE, (uint8_t *)&_header, sizeof(QFSHeader_t));
+        // 出队进度只精确到扇区，上次没有出队完的扇区会从头再读一次
         _header.font_sec_poped = 0;
         _header.rear_sec_used  = 0;
-        // header = _header;
+        header                 = _header;
     } else {
         CHIP_W25Q512_QFS_format();
     }
@@ -184,7 +191,10 @@ void CHIP_W25Q512_QFS_handler()
                     // 检查队列是否包含一个W25Q512_SECTOR_SIZE的数据
                     if (c_arr_queue_size(&qfs_wqueue) >= flush_data2flash_threshold) {
                         if (!w25q512_is_busy()) {
-                            c_arr_queue_out(&qfs_wqueue, qfs_wbuffer, W25Q512_SECTOR_SIZE);
+                            memset(qfs_wbuffer, 0xFF, qfs_wqueue_poped);
+                            c_arr_queue_out(&qfs_wqueue, qfs_wbuffer + qfs_wqueue_poped, W25Q512_SECTOR_SIZE - qfs_wqueue_poped);
+                            qfs_wbuffer_poped = qfs_wqueue_poped;
+                            qfs_wqueue_poped  = 0;
                             w25q512_erase_one_sector_cmd(QFS_PHYSICAL_SECTOR_INDEX(header.rear_sec_numb));
                             qfs_sm = QFS_WAITING_ERASE_FINISH;
                         }
@@ -211,7 +221,10 @@ void CHIP_W25Q512_QFS_handler()
                     {
                         w25q512_wait_busy(W25Q512_TIMEOUT_DEFAULT_VALUE);
 
-                        // QFS enqueue
+                        // QFS enqueue，填充的部分已经被读出了
+                        if (CHIP_W25Q512_QFS_is_empty()) {
+                            header.font_sec_poped = qfs_wbuffer_poped;
+                        }
                         header.rear_sec_numb = (header.rear_sec_numb + 1) % QFS_DATA_FILED_LOGIC_SECTOR_COUNT;
 
                         page_idx = 0;
@@ -231,7 +244,7 @@ void CHIP_W25Q512_QFS_handler()
             switch (qfs_sm) {
                 case QFS_IDLE:
                     if (!w25q512_is_busy()) {
-                        w25q512_erase_one_sector_cmd(0);
+                        w25q512_erase_one_sector_cmd(QFS_HEADER_PHYSICAL_SECTOR_INDEX);
                         qfs_sm = QFS_WAITING_ERASE_FINISH;
                     }
                     break;
@@ -245,7 +258,7 @@ void CHIP_W25Q512_QFS_handler()
 
                     if (page_idx < W25Q512_SECTOR_SIZE / W25Q512_PAGE_SIZE) {
                         if (!w25q512_is_busy()) {
-                            uint32_t sector = 0;
+                            uint32_t sector = QFS_HEADER_PHYSICAL_SECTOR_INDEX;
                             uint8_t *buf    = qfs_wbuffer;
                             w25q512_write_page_no_erase_no_wait(sector * W25Q512_SECTOR_SIZE + page_idx * W25Q512_PAGE_SIZE, buf + page_idx * W25Q512_PAGE_SIZE, W25Q512_PAGE_SIZE);
                             page_idx++;
@@ -288,6 +301,19 @@ uint32_t CHIP_W25Q512_QFS_push(uint8_t *buf, uint32_t len)
     return ret;
 }
 
+/**
+ * @brief 写入缓存队列还能写入的字节数，QFS满了时返回0。用来保证一段数据能完整写入。
+ *
+ * @return uint32_t 字节数
+ */
+uint32_t CHIP_W25Q512_QFS_residual_byte_size()
+{
+    if (CHIP_W25Q512_QFS_is_full()) {
+        return 0;
+    }
+    return QFS_WRITE_QUEUE_CAPACITY - 1 - c_arr_queue_size(&qfs_wqueue);
+}
+
 /**
  * @brief 获取Flash队列首部扇区数据的地址。
  *
@@ -483,6 +509,7 @@ uint32_t CHIP_W25Q512_QFS_asyn_read(uint8_t *buf, uint32_t len)
                     // 首先是要读取QFS中存放到物理存储的数据
                     if (CHIP_W25Q512_QFS_is_empty()) {
                         tmp = c_arr_queue_out(&qfs_wqueue, buf, len);
+                        qfs_wqueue_poped = (qfs_wqueue_poped + tmp) % W25Q512_SECTOR_SIZE;
                         len -= tmp;
                         buf += tmp;
                         ret += tmp;
@@ -508,6 +535,7 @@ uint32_t CHIP_W25Q512_QFS_asyn_read(uint8_t *buf, uint32_t len)
             case QFS_WRITE_HEADER:
                 if (CHIP_W25Q512_QFS_is_empty()) {
                     tmp = c_arr_queue_out(&qfs_wqueue, buf, len);
+                    qfs_wqueue_poped = (qfs_wqueue_poped + tmp) % W25Q512_SECTOR_SIZE;
                     len -= tmp;
                     buf += tmp;
                     ret += tmp;
@@ -595,6 +623,57 @@ uint32_t CHIP_W25Q512_QFS_font(uint8_t *buf)
     return ret;
 }
 
+/**
+ * @brief 记录队列中已经写入Flash的数据的位置和长度，之后用CHIP_W25Q512_QFS_snapshot_read读取，不出队。
+ * 写入只改变队列尾部，出队只改变首部，快照中的数据在被新写入的数据覆盖之前都可以读取。
+ *
+ * @param pSnap
+ */
+void CHIP_W25Q512_QFS_snapshot(QFSSnapshot_t *pSnap)
+{
+    pSnap->font_sec_numb  = header.font_sec_numb;
+    pSnap->font_sec_poped = header.font_sec_poped;
+    pSnap->byte_size      = CHIP_W25Q512_QFS_byte_size();
+}
+
+/**
+ * @brief 读取快照中offset处的数据，跨扇区、跨队列首尾时分段读取。
+ *
+ * @param pSnap CHIP_W25Q512_QFS_snapshot记录的快照。
+ * @param offset 相对快照开头的偏移。
+ * @param buf
+ * @param len
+ * @return uint32_t 实际读取的字节数，超出快照的部分不读取。
+ */
+uint32_t CHIP_W25Q512_QFS_snapshot_read(const QFSSnapshot_t *pSnap, uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    uint32_t ret = 0;
+    uint32_t pos = 0;
+    uint32_t sec = 0;
+    uint32_t n   = 0;
+
+    if (offset >= pSnap->byte_size) {
+        return 0;
+    }
+    if (len > pSnap->byte_size - offset) {
+        len = pSnap->byte_size - offset;
+    }
+    w25q512_wait_busy(W25Q512_TIMEOUT_DEFAULT_VALUE);
+    while (ret < len) {
+        pos = pSnap->font_sec_poped + offset + ret;
+        sec = (pSnap->font_sec_numb + pos / W25Q512_SECTOR_SIZE) % QFS_DATA_FILED_LOGIC_SECTOR_COUNT;
+        n   = W25Q512_SECTOR_SIZE - pos % W25Q512_SECTOR_SIZE;
+        if (n > len - ret) {
+            n = len - ret;
+        }
+        if (CHIP_W25Q512_read(QFS_PHYSICAL_SECTOR_INDEX(sec) * W25Q512_SECTOR_SIZE + pos % W25Q512_SECTOR_SIZE, buf + ret, n) != 0) {
+            break;
+        }
+        ret += n;
+    }
+    return ret;
+}
+
 /**
  * @brief 返回QFS队列中的数据的字节数。这个字节数是已经存放到FLASH的数据减去pop掉的字节数。
  *
@@ -627,8 +706,7 @@ uint8_t CHIP_W25Q512_QFS_is_idle()
 int32_t CHIP_W25Q512_read_one_sector(uint32_t sec_idx, uint8_t *buf)
 {
     int32_t ret = 0;
-    if (buf != NULL) {
-        CHIP_W25Q512_read(sec_idx * W25Q512_SECTOR_SIZE, buf, W25Q512_SECTOR_SIZE);
+    if (buf != NULL && CHIP_W25Q512_read(sec_idx * W25Q512_SECTOR_SIZE, buf, W25Q512_SECTOR_SIZE) == 0) {
         ret = 1;
     }
     return ret;
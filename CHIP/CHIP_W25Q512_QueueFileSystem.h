@@ -13,6 +13,20 @@
 #define CHIP_W25Q512_QUEUEFILESYSTEM_H
 
 #include "CHIP_W25Q512.h"
+#include "CHIP_W25Q512_LogPartition.h"
+
+/*
+W25Q512的扇区分配：
+| FatFS "0:"和USB MSC | QFS（头部一个扇区 + 数据区） | 日志分区 |
+0                     W25Q512_QFS_FIRST_SECTOR       W25Q512_LOG_FIRST_SECTOR
+QFS只由BFL_4G_MQTT的发送队列溢出写入和出队，其他模块（ymodem导出）只能通过快照读取，不能出队。
+*/
+// QFS占用的扇区数，16MB
+#define W25Q512_QFS_SECTOR_COUNT  (W25Q512_SECTOR_COUNT / 4)
+// QFS的第一个物理扇区（头部），紧挨在日志分区之前
+#define W25Q512_QFS_FIRST_SECTOR  (W25Q512_LOG_FIRST_SECTOR - W25Q512_QFS_SECTOR_COUNT)
+// FatFS和USB MSC使用的扇区数，QFS和日志分区之前的全部扇区
+#define W25Q512_DISK_SECTOR_COUNT W25Q512_QFS_FIRST_SECTOR
 
 /*
 round-robin queue
@@ -40,10 +54,21 @@ typedef struct tagQFSHeader {
     uint32_t font_sec_poped; // 首扇区已出队字节数0-SectorSize-1，在pop中使用
 } QFSHeader_t;
 
+/**
+ * @brief 队列中数据的快照，用于不出队地读取数据（例如导出）。
+ *
+ */
+typedef struct tagQFSSnapshot {
+    uint32_t font_sec_numb;  // 快照开始的逻辑扇区号
+    uint32_t font_sec_poped; // 开始扇区中已出队的字节数
+    uint32_t byte_size;      // 快照中的字节数
+} QFSSnapshot_t;
+
 // 用户接口
 void CHIP_W25Q512_QFS_init();
 void CHIP_W25Q512_QFS_handler();
 uint32_t CHIP_W25Q512_QFS_push(uint8_t *buf, uint32_t len);
+uint32_t CHIP_W25Q512_QFS_residual_byte_size();
 uint32_t CHIP_W25Q512_QFS_asyn_read(uint8_t *buf, uint32_t len);
 uint8_t CHIP_W25Q512_QFS_asyn_readable();
 uint32_t CHIP_W25Q512_QFS_asyn_readable_byte_size();
@@ -64,6 +89,9 @@ void CHIP_W25Q512_QFS_flush();
 uint32_t CHIP_W25Q512_QFS_get_font_address();
 uint32_t CHIP_W25Q512_QFS_get_rear_address();
 uint32_t CHIP_W25Q512_QFS_font(uint8_t *buf);
+// 快照
+void CHIP_W25Q512_QFS_snapshot(QFSSnapshot_t *pSnap);
+uint32_t CHIP_W25Q512_QFS_snapshot_read(const QFSSnapshot_t *pSnap, uint32_t offset, uint8_t *buf, uint32_t len);
 
 // 外部看QFS状态机
 uint8_t CHIP_W25Q512_QFS_is_idle();
@@ -11,7 +11,11 @@
 #include "CHIP_W25Q512_test.h"
 #include "HDL_Flash_test.h"
 #include "CHIP_W25Q512_QueueFileSystem.h"
+#include "CHIP_W25Q512_LogPartition.h"
+#include "CHIP_W25Q512_MSC.h"
 #include "HDL_CPU_Time.h"
+#include "app_fatfs.h"
+#include "crc.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -236,3 +240,212 @@ void CHIP_W25Q512_QFS_test()
         // }
     }
 }
+
+/**
+ * @brief 日志分区测试：写入一批记录后重新加载分区，读出最后的记录逐条比较，并统计页编程次数。
+ * 会擦除整个日志分区。
+ *
+ */
+void CHIP_W25Q512_LOG_test()
+{
+    W25Q512_LogCursor_t cursor;
+    W25Q512_LogStat_t stat;
+    uint8_t type        = 0;
+    uint32_t error      = 0;
+    uint32_t len        = 0;
+    uint32_t base       = 0;
+    uint32_t begin_tick = 0;
+    int32_t read_len    = 0;
+    char expect[64];
+
+    Debug_Printf("\r\n%s\r\n", __func__);
+    CHIP_W25Q512_LOG_format();
+
+    begin_tick = HDL_CPU_Time_GetTick();
+    for (uint32_t i = 0; i < 2000; i++) {
+        len = sprintf(expect, "log record %u", i);
+        while (!CHIP_W25Q512_LOG_append(CHIP_W25Q512_LOG_TYPE_TEXT, expect, len)) {
+            CHIP_W25Q512_LOG_handler();
+        }
+        CHIP_W25Q512_LOG_handler();
+    }
+    CHIP_W25Q512_LOG_flush();
+    while (!CHIP_W25Q512_LOG_is_idle()) {
+        CHIP_W25Q512_LOG_handler();
+    }
+    CHIP_W25Q512_LOG_get_stat(&stat);
+    Debug_Printf("[LOG Test]: 2000 records in %u ms, programs:%u erases:%u\r\n", HDL_CPU_Time_GetTick() - begin_tick,
+                 stat.programs, stat.erases);
+
+    // 模拟复位，重新加载后记录数不变
+    CHIP_W25Q512_LOG_init();
+    if (CHIP_W25Q512_LOG_record_seq() != 2000) {
+        Debug_Printf("[LOG Test]: record seq %u after remount\r\n", CHIP_W25Q512_LOG_record_seq());
+        error++;
+    }
+
+    begin_tick = HDL_CPU_Time_GetTick();
+    if (CHIP_W25Q512_LOG_seek_tail(&cursor, 50) != 50) {
+        error++;
+    }
+    Debug_Printf("[LOG Test]: seek tail cost %u ms\r\n", HDL_CPU_Time_GetTick() - begin_tick);
+    base = cursor.recSeq;
+    for (uint32_t i = 0; i < 50; i++) {
+        read_len = CHIP_W25Q512_LOG_read_next(&cursor, &type, test_buf, sizeof(test_buf));
+        len      = sprintf(expect, "log record %u", base + i);
+        if (read_len != (int32_t)len || type != CHIP_W25Q512_LOG_TYPE_TEXT || memcmp(test_buf, expect, len) != 0) {
+            error++;
+        }
+    }
+    if (CHIP_W25Q512_LOG_read_next(&cursor, &type, test_buf, sizeof(test_buf)) != 0) {
+        error++;
+    }
+    Debug_Printf("[LOG Test]: %s, error:%u\r\n", error == 0 ? "pass" : "fail", error);
+}
+
+// 共用测试：MSC连续读取的扇区数、FatFS测试文件的扇区数、MSC写入的扇区数（MSC区域末尾）
+#define SHARE_MSC_SECTORS  32U
+#define SHARE_FILE_SECTORS 16U
+#define SHARE_WB_SECTORS   4U
+
+static uint8_t share_data(uint32_t sector, uint32_t i, uint32_t seed)
+{
+    return (uint8_t)(sector * 31U + i * 7U + (i >> 8) + seed);
+}
+
+/**
+ * @brief 日志分区和FatFS、USB MSC共用Flash的测试。日志分区的擦除和页编程不等待完成，
+ * 每写一条日志之后穿插MSC连续读取（带预读）、FatFS读文件和MSC写入，检查读到的数据、
+ * 写入的结果和日志记录。会擦除整个日志分区，"0:"上没有文件系统时格式化，
+ * 改写"0:"上的share.bin和MSC区域末尾的SHARE_WB_SECTORS个扇区。
+ *
+ */
+void CHIP_W25Q512_LOG_share_test()
+{
+    static FATFS fs;
+    static FIL file;
+    static uint32_t msc_crc[SHARE_MSC_SECTORS];
+    uint32_t wb_seed[SHARE_WB_SECTORS] = {0};
+    W25Q512_LogCursor_t cursor;
+    FRESULT res;
+    UINT bw             = 0;
+    uint8_t type        = 0;
+    uint32_t error      = 0;
+    uint32_t len        = 0;
+    uint32_t base       = 0;
+    uint32_t sector     = 0;
+    int32_t read_len    = 0;
+    char expect[64];
+
+    Debug_Printf("\r\n%s\r\n", __func__);
+    MX_FATFS_Init();
+    res = f_mount(&fs, "0:", 1);
+    if (res == FR_NO_FILESYSTEM) {
+        res = f_mkfs("0:", FM_ANY, 0, test_buf, sizeof(test_buf));
+        if (res == FR_OK) {
+            res = f_mount(&fs, "0:", 1);
+        }
+    }
+    if (res != FR_OK) {
+        Debug_Printf("[LOG Share Test]: mount failed %d\r\n", res);
+        error++;
+    }
+
+    // 准备FatFS文件，记下MSC前SHARE_MSC_SECTORS个扇区的CRC32
+    if (f_open(&file, "0:share.bin", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        error++;
+    } else {
+        for (uint32_t s = 0; s < SHARE_FILE_SECTORS; s++) {
+            for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+                test_buf[i] = share_data(s, i, 0);
+            }
+            if (f_write(&file, test_buf, W25Q512_SECTOR_SIZE, &bw) != FR_OK || bw != W25Q512_SECTOR_SIZE) {
+                error++;
+            }
+        }
+        f_close(&file);
+    }
+    for (uint32_t s = 0; s < SHARE_MSC_SECTORS; s++) {
+        CHIP_W25Q512_read(s * W25Q512_SECTOR_SIZE, read_buf, W25Q512_SECTOR_SIZE);
+        msc_crc[s] = CRC32(read_buf, W25Q512_SECTOR_SIZE);
+    }
+    if (f_open(&file, "0:share.bin", FA_READ) != FR_OK) {
+        error++;
+    }
+
+    CHIP_W25Q512_LOG_format();
+    for (uint32_t n = 0; n < 2000; n++) {
+        len = sprintf(expect, "share record %u", n);
+        while (!CHIP_W25Q512_LOG_append(CHIP_W25Q512_LOG_TYPE_TEXT, expect, len)) {
+            CHIP_W25Q512_LOG_handler();
+        }
+        // 启动的擦除、页编程不等待完成，紧接着读取
+        CHIP_W25Q512_LOG_handler();
+
+        sector = n % SHARE_MSC_SECTORS;
+        if (CHIP_W25Q512_MSC_read(sector, read_buf, 1) != 0 || CRC32(read_buf, W25Q512_SECTOR_SIZE) != msc_crc[sector]) {
+            Debug_Printf("[LOG Share Test]: MSC read sector %u wrong at record %u\r\n", sector, n);
+            error++;
+        }
+
+        if (n % 4 == 0) {
+            sector = (n / 4) % SHARE_FILE_SECTORS;
+            if (f_lseek(&file, sector * W25Q512_SECTOR_SIZE) != FR_OK ||
+                f_read(&file, test_buf, W25Q512_SECTOR_SIZE, &bw) != FR_OK || bw != W25Q512_SECTOR_SIZE) {
+                error++;
+            } else {
+                for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+                    if (test_buf[i] != share_data(sector, i, 0)) {
+                        Debug_Printf("[LOG Share Test]: FatFs read sector %u wrong at record %u\r\n", sector, n);
+                        error++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // MSC写入另一个扇区时写回缓存中的扇区写入Flash，写使能在日志分区的编程之后发出
+        if (n % 50 == 0) {
+            uint32_t k = (n / 50) % SHARE_WB_SECTORS;
+            wb_seed[k] = n + 1;
+            for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+                test_buf[i] = share_data(k, i, wb_seed[k]);
+            }
+            if (CHIP_W25Q512_MSC_write(CHIP_W25Q512_MSC_SECTOR_NUM - 1 - k, test_buf, 1) != 0) {
+                error++;
+            }
+        }
+    }
+    f_close(&file);
+    CHIP_W25Q512_MSC_flush();
+    CHIP_W25Q512_LOG_flush();
+    while (!CHIP_W25Q512_LOG_is_idle()) {
+        CHIP_W25Q512_LOG_handler();
+    }
+
+    for (uint32_t k = 0; k < SHARE_WB_SECTORS; k++) {
+        CHIP_W25Q512_read((CHIP_W25Q512_MSC_SECTOR_NUM - 1 - k) * W25Q512_SECTOR_SIZE, read_buf, W25Q512_SECTOR_SIZE);
+        for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+            if (read_buf[i] != share_data(k, i, wb_seed[k])) {
+                Debug_Printf("[LOG Share Test]: MSC write sector %u lost\r\n", CHIP_W25Q512_MSC_SECTOR_NUM - 1 - k);
+                error++;
+                break;
+            }
+        }
+    }
+
+    // 重新加载日志分区，最后的记录完整
+    CHIP_W25Q512_LOG_init();
+    if (CHIP_W25Q512_LOG_record_seq() != 2000 || CHIP_W25Q512_LOG_seek_tail(&cursor, 50) != 50) {
+        error++;
+    }
+    base = cursor.recSeq;
+    for (uint32_t i = 0; i < 50; i++) {
+        read_len = CHIP_W25Q512_LOG_read_next(&cursor, &type, test_buf, sizeof(test_buf));
+        len      = sprintf(expect, "share record %u", base + i);
+        if (read_len != (int32_t)len || type != CHIP_W25Q512_LOG_TYPE_TEXT || memcmp(test_buf, expect, len) != 0) {
+            error++;
+        }
+    }
+    Debug_Printf("[LOG Share Test]: %s, error:%u\r\n", error == 0 ? "pass" : "fail", error);
+}
@@ -18,4 +18,6 @@ void CHIP_W25Q512_io_check(uint32_t start_address);
 void CHIP_W25Q512_io_rate();
 void CHIP_W25Q512_sector_io_check();
 void CHIP_W25Q512_QFS_test();
+void CHIP_W25Q512_LOG_test();
+void CHIP_W25Q512_LOG_share_test();
 #endif // !CHIP_W25Q512_TEST_H
\ No newline at end of file
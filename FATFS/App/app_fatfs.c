@@ -30,6 +30,8 @@
 #include <math.h>
 #include <stdlib.h>
 #include "crc.h"
+#include "BFL_FileVerify.h"
+#include "CHIP_W25Q512_QueueFileSystem.h"
 
 /* USER CODE END Includes */
 
@@ -128,10 +130,28 @@ DWORD get_fattime(void)
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
+/**
+ * @brief 已挂载的卷结束的扇区（不包含），卷从volbase开始，数据区之后是最后一个簇。
+ *
+ * @param pFs 文件系统对象。
+ * @return DWORD 扇区号。
+ */
+static DWORD fatfs_volume_end(const FATFS *pFs)
+{
+    return pFs->database + (pFs->n_fatent - 2) * pFs->csize;
+}
+
 void fatfs_register()
 {
     FRESULT g_res;
     g_res = f_mount(&fs, "0:", 1);
+    if (g_res == FR_OK && fatfs_volume_end(&fs) > W25Q512_DISK_SECTOR_COUNT) {
+        // 以前的固件把整片Flash格式化为一个卷，卷的末尾和QFS、日志分区重叠，重新格式化
+        ULOG_WARNING("[FatFs] volume ends at sector %u, overlaps QFS and log partition, reformat",
+                     fatfs_volume_end(&fs));
+        f_mount(NULL, "0:", 1);
+        g_res = FR_NO_FILESYSTEM;
+    }
     if (g_res == FR_NO_FILESYSTEM) {
         ULOG_INFO("[FatFs] No file systems.");
         g_res = f_mkfs("0:", FM_ANY, 0, work_buff, sizeof(work_buff));
@@ -140,7 +160,7 @@ void fatfs_register()
             /* 格式化后，先取消挂载 */
             f_mount(NULL, "0:", 1);
             /* 重新挂载 */
-            f_mount(&fs_sd, "0:", 1);
+            f_mount(&fs, "0:", 1);
         } else {
             ULOG_INFO("[FatFs] f_mkfs failed err code = %d", g_res);
         }
@@ -491,6 +511,7 @@ void fatfsTaskFun(void *argument)
 
 /**
  * @brief 计算文件的CRC32值。不会修改文件指针的位置。
+ * 由BFL_FileVerify按扇区对齐的大块读取，使用静态缓冲区，不分配内存。
  *
  * @param pFile 已经打开的文件对象指针。
  * @param crcRes
@@ -498,40 +519,6 @@ void fatfsTaskFun(void *argument)
  */
 int CRC32_File(FIL *pFile, uint32_t *crcRes)
 {
-    if (pFile == NULL || crcRes == NULL) {
-        return 1; // 无效的参数
-    }
-
-    uint32_t crc = 0xFFFFFFFFUL; // 初始化CRC32值
-    // 获取初始时的文件指针位置
-    uint32_t filePos = f_tell(pFile);
-    // 将文件指针移动到文件开头
-    f_lseek(pFile, 0);
-
-    // 动态分配缓冲区
-    uint8_t *buffer = (uint8_t *)malloc(1024);
-    if (buffer == NULL) {
-        return 1; // 内存分配失败
-    }
-
-    // 读取文件并计算CRC32
-    while (1) {
-        UINT bytesRead = 0;
-        if (f_read(pFile, buffer, 1024, &bytesRead) != FR_OK || bytesRead == 0) {
-            break; // 读取文件失败或到达文件末尾
-        }
-        crc = CRC32_With(buffer, bytesRead, crc); // 使用现有的CRC32函数更新CRC32值
-    }
-
-    // 还原文件指针位置
-    f_lseek(pFile, filePos);
-
-    // 释放动态分配的缓冲区
-    free(buffer);
-
-    // 计算最终的CRC32值
-    *crcRes = ~crc; // 取反以得到最终的CRC32值
-
-    return 0; // 成功
+    return BFL_FileVerify_CRC32(pFile, crcRes) == 0 ? 0 : 1;
 }
 /* USER CODE END Application */
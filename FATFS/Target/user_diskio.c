@@ -39,6 +39,7 @@
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 #include "CHIP_W25Q512.h"
+#include "CHIP_W25Q512_QueueFileSystem.h"
 #include "./sdcard/bsp_spi_sdcard.h"
 #include "log.h"
 /* Private variables ---------------------------------------------------------*/
@@ -164,17 +165,21 @@ DRESULT USER_read(
             SD_state = SD_ReadMultiBlocks(buff, (uint64_t)sector * SD_BLOCKSIZE, SD_BLOCKSIZE, count);
             if (SD_state != SD_RESPONSE_NO_ERROR) {
                 status = RES_ERROR;
-                ULOG_INFO("SD Read Error sector %d, count %d", sector, count);
+                DLOG_ERROR("SD Read Error sector %d, count %d", sector, count);
             } else {
                 status = RES_OK;
-                ULOG_INFO("SD read sector %d, count %d", sector, count);
+                DLOG_DEBUG("SD read sector %d, count %d", sector, count);
             }
             break;
         case SPI_FLASH: /* SPI Flash */
+            status = RES_OK;
             for (UINT i = 0; i < count; i++) {
-                CHIP_W25Q512_read_one_sector(sector + i, buff + i * W25Q512_SECTOR_SIZE);
+                // 等待日志分区的擦除、编程超时时读取失败
+                if (CHIP_W25Q512_read_one_sector(sector + i, buff + i * W25Q512_SECTOR_SIZE) != 1) {
+                    status = RES_ERROR;
+                    break;
+                }
             }
-            status = RES_OK;
             break;
         default:
             status = RES_PARERR;
@@ -215,9 +220,9 @@ DRESULT USER_write(
             SD_state = SD_WriteMultiBlocks((uint8_t *)buff, (uint64_t)sector * SD_BLOCKSIZE, SD_BLOCKSIZE, count);
             if (SD_state == SD_RESPONSE_NO_ERROR) {
                 status = RES_OK;
-                ULOG_INFO("[FatFS] SD write sector %d, count %d", sector, count);
+                DLOG_DEBUG("[FatFS] SD write sector %d, count %d", sector, count);
             } else {
-                ULOG_INFO("SD Write Error sector %d, count %d", sector, count);
+                DLOG_ERROR("SD Write Error sector %d, count %d, written %d", sector, count, SD_GetWrittenBlocks());
                 status = RES_ERROR;
             }
             break;
@@ -225,7 +230,7 @@ DRESULT USER_write(
         case SPI_FLASH:
             for (UINT i = 0; i < count; i++) {
                 w25q512_write_one_sector(sector + i, (uint8_t *)buff + i * W25Q512_SECTOR_SIZE);
-                ULOG_INFO("[FatFS] Flash write sector %d", sector + i);
+                DLOG_DEBUG("[FatFS] Flash write sector %d", sector + i);
             }
             status = RES_OK;
             break;
@@ -281,7 +286,8 @@ DRESULT USER_ioctl(
                 *(DWORD *)buff = SDCardInfo.CardCapacity / SDCardInfo.CardBlockSize;
                 res            = RES_OK;
             } else if (pdrv == SPI_FLASH) {
-                *(DWORD *)buff = W25Q512_SECTOR_COUNT;
+                // 末尾的QFS和日志分区不给文件系统使用
+                *(DWORD *)buff = W25Q512_DISK_SECTOR_COUNT;
                 res            = RES_OK;
             }
             break;
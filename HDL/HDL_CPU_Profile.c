@@ -0,0 +1,93 @@
+/**
+ * @file HDL_CPU_Profile.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 按统计点汇总代码段的执行周期数，用法见HDL_CPU_Time.h。
+ * 只依赖HDL_CPU_Time_GetCycles和HDL_CPU_Time_CyclesPerUs，目标板和主机上共用。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "HDL_CPU_Time.h"
+#include "main.h"
+
+// 已经记录过的统计点，新的统计点插在链表头
+static HDL_CPU_ProfileSite_t *_gProfileSites = NULL;
+
+/**
+ * @brief 记录一次执行，一般通过HDL_CPU_PROFILE_END调用，可以在中断中调用。
+ *
+ * @param site 统计点，第一次记录时挂到链表上。
+ * @param cycles 本次执行的周期数。
+ */
+void HDL_CPU_Profile_Record(HDL_CPU_ProfileSite_t *site, uint32_t cycles)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!site->linked) {
+        site->linked   = true;
+        site->next     = _gProfileSites;
+        _gProfileSites = site;
+    }
+    site->count++;
+    site->totalCycles += cycles;
+    if (cycles < site->minCycles) {
+        site->minCycles = cycles;
+    }
+    if (cycles > site->maxCycles) {
+        site->maxCycles = cycles;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 清零所有统计点，统计点仍然留在链表上。
+ *
+ */
+void HDL_CPU_Profile_Reset()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (HDL_CPU_ProfileSite_t *site = _gProfileSites; site != NULL; site = site->next) {
+        site->count       = 0;
+        site->minCycles   = 0xFFFFFFFFU;
+        site->maxCycles   = 0;
+        site->totalCycles = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 打印所有统计点，每个统计点一行。
+ *
+ * @param print 打印接口，例如Debug_Printf。
+ */
+void HDL_CPU_Profile_Show(HDL_CPU_Profile_Print_t print)
+{
+    HDL_CPU_ProfileSite_t snap;
+    uint32_t perUs   = HDL_CPU_Time_CyclesPerUs();
+    uint32_t avg     = 0;
+    uint32_t primask = 0;
+
+    if (print == NULL) {
+        return;
+    }
+    if (perUs == 0) {
+        perUs = 1;
+    }
+    for (HDL_CPU_ProfileSite_t *site = _gProfileSites; site != NULL; site = site->next) {
+        // 打印比较慢，先取一份快照，避免打印期间被中断修改
+        primask = __get_PRIMASK();
+        __disable_irq();
+        snap = *site;
+        __set_PRIMASK(primask);
+        if (snap.count == 0) {
+            continue;
+        }
+        avg = (uint32_t)(snap.totalCycles / snap.count);
+        print("[PROFILE] %-16s cnt:%u min:%u avg:%u max:%u cycles, avg:%uus max:%uus\r\n", snap.name, snap.count,
+              snap.minCycles, avg, snap.maxCycles, avg / perUs, snap.maxCycles / perUs);
+    }
+}
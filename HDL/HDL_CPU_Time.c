@@ -13,6 +13,8 @@
 
 #define CPU_TIM    TIM1
 #define CPU_US_TIM TIM2
+// CPU_TIM计数频率10MHz，每us计数10次
+#define CPU_TIM_CNT_PER_US 10U
 /**
  * 定时器：TIM1
  * 中断优先级: 抢占0，子优先级0
@@ -21,8 +23,16 @@
  */
 
 static __IO uint32_t uwCpuTick;
+// uwCpuTick回绕的次数，和uwCpuTick组成64位ms tick
+static __IO uint32_t uwCpuTickHigh;
+// CPU_US_TIM溢出的次数，在更新中断中增加，和计数器组成64位us tick
+static __IO uint32_t uwUsOverflow;
+// HDL_CPU_Time_ResetTick/ResetUsTick之前已经过去的时间，保证64位时间单调递增
+static uint64_t ullTickBase;
+static uint64_t ullUsTickBase;
 static CPU_Time_Callback_t _gCPUTickCallback = NULL;
 bool cpu_time_init_flag                      = false;
+static HDL_CPU_Time_IdleStat_t _gIdleStat    = {0};
 
 /**
  * @brief CPU滴答时钟初始化。
@@ -92,13 +102,19 @@ void HDL_CPU_Time_Init()
     LL_TIM_DisableMasterSlaveMode(CPU_US_TIM);
 
     LL_TIM_SetCounter(CPU_US_TIM, 0);
-    LL_TIM_DisableIT_UPDATE(CPU_US_TIM);
+    // LL_TIM_Init产生的更新事件会置位更新标志，先清除，再用更新中断统计溢出次数
+    LL_TIM_ClearFlag_UPDATE(CPU_US_TIM);
+    LL_TIM_EnableIT_UPDATE(CPU_US_TIM);
 
     NVIC_SetPriority(TIM2_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 15, 0));
     NVIC_EnableIRQ(TIM2_IRQn);
 
     LL_TIM_EnableCounter(CPU_US_TIM); // 计数使能
 
+    // DWT周期计数器，用于HDL_CPU_Time_GetCycles
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
     cpu_time_init_flag = true;
 }
 
@@ -118,7 +134,27 @@ uint32_t HDL_CPU_Time_GetTick()
  */
 void HDL_CPU_Time_ResetTick()
 {
-    uwCpuTick = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ullTickBase += ((uint64_t)uwCpuTickHigh << 32) | uwCpuTick;
+    uwCpuTickHigh = 0;
+    uwCpuTick     = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 获取64位CPU滴答时钟，单位ms，不会回绕，HDL_CPU_Time_ResetTick也不会让它变小。
+ *
+ * @return uint64_t
+ */
+uint64_t HDL_CPU_Time_GetTick64()
+{
+    uint64_t tick    = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    tick = ullTickBase + (((uint64_t)uwCpuTickHigh << 32) | uwCpuTick);
+    __set_PRIMASK(primask);
+    return tick;
 }
 
 /**
@@ -133,6 +169,9 @@ void HDL_CPU_Time_ResetTick()
 static inline void HDL_CPU_IncTick(void)
 {
     uwCpuTick++;
+    if (uwCpuTick == 0) {
+        uwCpuTickHigh++;
+    }
 }
 
 /**
@@ -151,7 +190,58 @@ uint32_t HDL_CPU_Time_GetUsTick()
  */
 void HDL_CPU_Time_ResetUsTick()
 {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ullUsTickBase = HDL_CPU_Time_GetUsTick64();
     LL_TIM_SetCounter(CPU_US_TIM, 0);
+    LL_TIM_ClearFlag_UPDATE(CPU_US_TIM);
+    uwUsOverflow = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 获取64位微秒滴答时钟，不会回绕，HDL_CPU_Time_ResetUsTick也不会让它变小。可以在中断中调用。
+ *
+ * @return uint64_t
+ */
+uint64_t HDL_CPU_Time_GetUsTick64()
+{
+    uint32_t high    = 0;
+    uint32_t low     = 0;
+    uint64_t base    = 0;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    base = ullUsTickBase;
+    high = uwUsOverflow;
+    low  = LL_TIM_GetCounter(CPU_US_TIM);
+    // 计数器已经溢出但是更新中断还没有处理（关中断期间或者在更高优先级的中断中调用），
+    // 读到的low是溢出之后的值时需要补上这次溢出
+    if (LL_TIM_IsActiveFlag_UPDATE(CPU_US_TIM) && low < 0x80000000UL) {
+        high++;
+    }
+    __set_PRIMASK(primask);
+    return base + (((uint64_t)high << 32) | low);
+}
+
+/**
+ * @brief 获取DWT周期计数器，每个CPU时钟加1，用于测量很短的代码段。
+ *
+ * @return uint32_t
+ */
+uint32_t HDL_CPU_Time_GetCycles()
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief 每us的周期数，用于把HDL_CPU_Time_GetCycles的差值换算为us。
+ *
+ * @return uint32_t
+ */
+uint32_t HDL_CPU_Time_CyclesPerUs()
+{
+    return SystemCoreClock / 1000000U;
 }
 
 /**
@@ -305,6 +395,11 @@ void TIM2_IRQHandler()
 {
     TIM_TypeDef *TIMx = CPU_US_TIM;
 
+    if (LL_TIM_IsEnabledIT_UPDATE(TIMx) && LL_TIM_IsActiveFlag_UPDATE(TIMx)) {
+        LL_TIM_ClearFlag_UPDATE(TIMx);
+        uwUsOverflow++;
+    }
+
     if (LL_TIM_IsEnabledIT_CC1(TIMx) && LL_TIM_IsActiveFlag_CC1(TIMx)) {
         LL_TIM_ClearFlag_CC1(TIMx); /* 清除CC1中断标志 */
         LL_TIM_DisableIT_CC1(TIMx); /* 禁能CC1中断 */
@@ -346,4 +441,82 @@ void TIM2_IRQHandler()
 void HDL_CPU_Time_SetCPUTickCallback(CPU_Time_Callback_t _pCallBack)
 {
     _gCPUTickCallback = _pCallBack;
-}
\ No newline at end of file
+}
+
+static void HDL_CPU_Time_IdleWakeupCallback(void)
+{
+    // 只用于把CPU从WFI中唤醒
+}
+
+/**
+ * @brief 低功耗空闲：关闭毫秒tick中断后WFI，直到maxTicks个tick后或者有其他中断时唤醒，
+ * 唤醒后按微秒定时器补偿睡眠期间少计的tick。
+ * CPU_TIM在睡眠期间继续计数，只是不产生中断，所以唤醒后tick的相位不变。
+ * @note 补偿的tick不会调用HDL_CPU_Time_SetCPUTickCallback设置的回调。
+ * @param maxTicks 最多睡眠的tick数，超过HDL_CPU_TIME_IDLE_MAX_TICKS按HDL_CPU_TIME_IDLE_MAX_TICKS算。
+ * @return uint32_t 补偿的tick数。
+ */
+uint32_t HDL_CPU_Time_Idle(uint32_t maxTicks)
+{
+    uint32_t startUs  = 0;
+    uint32_t phaseUs  = 0;
+    uint32_t elapseUs = 0;
+    uint32_t cnt      = 0;
+    uint32_t ticks    = 0;
+
+    if (maxTicks == 0 || cpu_time_init_flag == false) {
+        return 0;
+    }
+    maxTicks = maxTicks > HDL_CPU_TIME_IDLE_MAX_TICKS ? HDL_CPU_TIME_IDLE_MAX_TICKS : maxTicks;
+
+    __disable_irq();
+    // 先记录当前tick内已经过去的时间，再检查是否有tick中断等待处理，
+    // 这样无论tick在哪一时刻到来都不会被漏算
+    phaseUs = LL_TIM_GetCounter(CPU_TIM) / CPU_TIM_CNT_PER_US;
+    startUs = LL_TIM_GetCounter(CPU_US_TIM);
+    if (LL_TIM_IsActiveFlag_UPDATE(CPU_TIM)) {
+        __enable_irq();
+        return 0;
+    }
+    LL_TIM_DisableIT_UPDATE(CPU_TIM);
+    // 在tick边界上唤醒
+    HDL_CPU_Time_StartHardTimer(HDL_CPU_TIME_IDLE_CC, maxTicks * 1000U - phaseUs, HDL_CPU_Time_IdleWakeupCallback);
+
+    __DSB();
+    __WFI();
+    __ISB();
+
+    elapseUs = LL_TIM_GetCounter(CPU_US_TIM) - startUs;
+    cnt      = LL_TIM_GetCounter(CPU_TIM);
+    LL_TIM_ClearFlag_UPDATE(CPU_TIM);
+    // 两个定时器同源，phaseUs+elapseUs-当前相位应该是整数个ms，四舍五入消除读寄存器的时间差
+    ticks = (phaseUs + elapseUs + 500U - cnt / CPU_TIM_CNT_PER_US) / 1000U;
+    // 读取cnt之后、清除更新标志之前刚好经过tick边界
+    if (LL_TIM_GetCounter(CPU_TIM) < cnt) {
+        ticks++;
+    }
+    if (uwCpuTick + ticks < uwCpuTick) {
+        uwCpuTickHigh++;
+    }
+    uwCpuTick += ticks;
+    HDL_CPU_Time_StopHardTimer(HDL_CPU_TIME_IDLE_CC);
+    LL_TIM_EnableIT_UPDATE(CPU_TIM);
+
+    _gIdleStat.sleepUs += elapseUs;
+    _gIdleStat.wakeups++;
+    __enable_irq();
+
+    return ticks;
+}
+
+/**
+ * @brief 获取低功耗空闲的统计，两次获取的差值除以间隔时间就是睡眠占比和每秒唤醒次数。
+ *
+ * @param pStat
+ */
+void HDL_CPU_Time_GetIdleStat(HDL_CPU_Time_IdleStat_t *pStat)
+{
+    __disable_irq();
+    *pStat = _gIdleStat;
+    __enable_irq();
+}
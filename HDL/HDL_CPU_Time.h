@@ -35,12 +35,79 @@ void HDL_CPU_Time_DelayMs(uint32_t DelayMs);
 void HDL_CPU_Time_ResetTick();
 uint32_t HDL_CPU_Time_GetUsTick();
 void HDL_CPU_Time_ResetUsTick();
+uint64_t HDL_CPU_Time_GetTick64();
+uint64_t HDL_CPU_Time_GetUsTick64();
+uint32_t HDL_CPU_Time_GetCycles();
+uint32_t HDL_CPU_Time_CyclesPerUs();
+
+/**
+ * @brief 32位tick或者周期数的先后比较，a在b之前时为真，在回绕前后都正确，要求两者相差不超过2^31。
+ * 32位的ms tick约49天回绕一次，us tick约71分钟回绕一次，周期数在170MHz下约25秒回绕一次，
+ * 比较超时时用HDL_CPU_TIME_BEFORE或者now - start >= timeout，不要直接比较大小。
+ *
+ */
+#define HDL_CPU_TIME_BEFORE(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
 
 void HDL_CPU_Time_DelayUs(uint32_t DelayUs);
 void HDL_CPU_Time_StartHardTimer(uint8_t _CC, UsTimer_t _uiTimeOut, void *_pCallBack);
 void HDL_CPU_Time_StopHardTimer(uint8_t _CC);
 void HDL_CPU_Time_SetCPUTickCallback(CPU_Time_Callback_t _pCallBack);
 
+// 低功耗空闲使用微秒定时器的这个比较通道唤醒，其他地方不要再用这个通道
+#define HDL_CPU_TIME_IDLE_CC        4
+// 一次空闲最多睡眠的tick数
+#define HDL_CPU_TIME_IDLE_MAX_TICKS 1000U
+
+typedef struct tagHDL_CPU_Time_IdleStat_t {
+    uint64_t sleepUs; // 累计睡眠时间，us
+    uint32_t wakeups; // 累计唤醒次数
+} HDL_CPU_Time_IdleStat_t;
+
+uint32_t HDL_CPU_Time_Idle(uint32_t maxTicks);
+void HDL_CPU_Time_GetIdleStat(HDL_CPU_Time_IdleStat_t *pStat);
+
+// 代码段执行周期统计开关，为0时HDL_CPU_PROFILE_BEGIN/END不产生任何代码
+#ifndef HDL_CPU_PROFILE_ENABLE
+#define HDL_CPU_PROFILE_ENABLE 0
+#endif
+
+/**
+ * @brief 一个统计点，由HDL_CPU_PROFILE_BEGIN定义为静态变量，第一次记录时挂到统计点链表上。
+ *
+ */
+typedef struct tagHDL_CPU_ProfileSite_t {
+    const char *name;
+    uint32_t count;       // 执行次数
+    uint32_t minCycles;   // 最短执行周期数
+    uint32_t maxCycles;   // 最长执行周期数
+    uint64_t totalCycles; // 总执行周期数，平均值为totalCycles/count
+    bool linked;          // 是否已经挂到统计点链表上
+    struct tagHDL_CPU_ProfileSite_t *next;
+} HDL_CPU_ProfileSite_t;
+
+// 打印接口，与Debug_Printf相同
+typedef void (*HDL_CPU_Profile_Print_t)(const void *format, ...);
+
+#if HDL_CPU_PROFILE_ENABLE
+/**
+ * @brief 统计BEGIN和END之间代码的执行周期数，两者必须在同一个作用域中成对使用，name在作用域内不能重复。
+ * 可以在中断中使用，嵌套时外层包含内层的时间。
+ *
+ */
+#define HDL_CPU_PROFILE_BEGIN(name)                                                                       \
+    static HDL_CPU_ProfileSite_t _cpu_profile_site_##name = {#name, 0, 0xFFFFFFFFU, 0, 0, false, NULL}; \
+    uint32_t _cpu_profile_start_##name                    = HDL_CPU_Time_GetCycles()
+#define HDL_CPU_PROFILE_END(name) \
+    HDL_CPU_Profile_Record(&_cpu_profile_site_##name, HDL_CPU_Time_GetCycles() - _cpu_profile_start_##name)
+#else
+#define HDL_CPU_PROFILE_BEGIN(name)
+#define HDL_CPU_PROFILE_END(name)
+#endif
+
+void HDL_CPU_Profile_Record(HDL_CPU_ProfileSite_t *site, uint32_t cycles);
+void HDL_CPU_Profile_Reset();
+void HDL_CPU_Profile_Show(HDL_CPU_Profile_Print_t print);
+
 #define HDL_CPU_TIME_OEN_TICK_TIME 1000ULL // 1000 us
 /**
  * @brief 将时间转换为tick,time单位为ms,
@@ -54,6 +121,27 @@ void HDL_CPU_Time_SetCPUTickCallback(CPU_Time_Callback_t _pCallBack);
  */
 #define HDL_TICK_TO_TIME(_tick) ((((_time) * HDL_CPU_TIME_OEN_TICK_TIME) / 1000ULL))
 
+/*************************Document****************************/
+/*
+// 64位时间不会回绕，适合做时间戳和长时间的间隔
+uint64_t start = HDL_CPU_Time_GetUsTick64();
+//...
+uint64_t elapseUs = HDL_CPU_Time_GetUsTick64() - start;
+
+// 统计一段代码的执行周期，编译时定义HDL_CPU_PROFILE_ENABLE=1
+void SD_ReadBlocks()
+{
+    HDL_CPU_PROFILE_BEGIN(sd_read);
+    //...
+    HDL_CPU_PROFILE_END(sd_read);
+}
+
+// 在主循环中定期打印
+HDL_CPU_Profile_Show(Debug_Printf);
+// [PROFILE] sd_read        cnt:1200 min:8123 avg:8450 max:21077 cycles, avg:49us max:123us
+ */
+/*************************Document End************************/
+
 #ifdef __cplusplus
 }
 #endif
@@ -44,7 +44,7 @@ void call2()
 {
     static int i = 0;
     Debug_Printf("call 2 = %u\r\n", i);
-    HDL_CPU_Time_StartHardTimer(4, 50000U, call2);
+    HDL_CPU_Time_StartHardTimer(2, 50000U, call2);
 }
 
 /**
@@ -55,8 +55,9 @@ void HDL_CPU_Time_hard_timer_test()
 {
     HDL_CPU_Time_Init();
     ulog_init_user();
+    // 通道HDL_CPU_TIME_IDLE_CC留给低功耗空闲，测试只用通道1、2
     HDL_CPU_Time_StartHardTimer(1, 50000U, call1);
-    HDL_CPU_Time_StartHardTimer(4, 50000U, call2);
+    HDL_CPU_Time_StartHardTimer(2, 50000U, call2);
     uint32_t cpu_tick    = 0;
     uint32_t cpu_us_tick = 0;
     uint32_t hal_tick    = 0;
@@ -67,4 +68,44 @@ void HDL_CPU_Time_hard_timer_test()
         Debug_Printf("hal_tick = %u,cpu_tick = %u,hal_tick - cpu_tick %d\r\n", hal_tick, cpu_tick, hal_tick - cpu_tick);
         Debug_Printf("cpu_us_tick = %u\r\n", cpu_us_tick);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 64位时钟和周期统计测试。把微秒定时器的计数器设置到溢出前，检查64位us tick在溢出前后单调递增，
+ * 并和周期数换算的时间对比。HDL_CPU_PROFILE_ENABLE为1时打印统计点。
+ *
+ */
+void HDL_CPU_Time_tick64_test()
+{
+    uint64_t last    = 0;
+    uint64_t now     = 0;
+    uint32_t errors  = 0;
+    uint32_t cycles  = 0;
+    uint64_t startUs = 0;
+
+    HDL_CPU_Time_Init();
+    ulog_init_user();
+
+    // 1ms后微秒定时器溢出
+    LL_TIM_SetCounter(TIM2, 0xFFFFFFFFUL - 1000U);
+    last = HDL_CPU_Time_GetUsTick64();
+    for (uint32_t i = 0; i < 200000U; i++) {
+        HDL_CPU_PROFILE_BEGIN(us_tick64);
+        now = HDL_CPU_Time_GetUsTick64();
+        HDL_CPU_PROFILE_END(us_tick64);
+        if (now < last) {
+            errors++;
+        }
+        last = now;
+    }
+    Debug_Printf("us tick64 = %u:%u, errors = %u\r\n", (uint32_t)(last >> 32), (uint32_t)last, errors);
+
+    startUs = HDL_CPU_Time_GetUsTick64();
+    cycles  = HDL_CPU_Time_GetCycles();
+    HDL_CPU_Time_DelayMs(10);
+    cycles = HDL_CPU_Time_GetCycles() - cycles;
+    Debug_Printf("delay 10ms: %u us by tick64, %u us by cycles, tick64 = %u ms\r\n",
+                 (uint32_t)(HDL_CPU_Time_GetUsTick64() - startUs), cycles / HDL_CPU_Time_CyclesPerUs(),
+                 (uint32_t)HDL_CPU_Time_GetTick64());
+    HDL_CPU_Profile_Show(Debug_Printf);
+}
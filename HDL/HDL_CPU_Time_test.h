@@ -14,4 +14,5 @@
 #include "HDL_CPU_Time.h"
 void HDL_CPU_Time_test();
 void HDL_CPU_Time_hard_timer_test();
+void HDL_CPU_Time_tick64_test();
 #endif // !CPU_TIME_TEST_H
@@ -310,3 +310,32 @@ int HDL_Flash_write_one_sector_nocheck(uint32_t sector, uint8_t *buf)
     HAL_FLASH_Lock();
     return status;
 }
+
+/**
+ * @brief 按双字编程已经擦除的区域，不读出、不擦除，用于顺序写入大块数据。
+ *
+ * @param address 写入地址，按HDL_FLASH_PROGRAMM_BYTE_WIDTHT对齐。
+ * @param data 数据，不需要对齐。
+ * @param size 数据长度，HDL_FLASH_PROGRAMM_BYTE_WIDTHT的整数倍。
+ * @return int 成功返回0，失败返回-1。
+ */
+int HDL_Flash_program_nocheck(uint32_t address, const uint8_t *data, uint32_t size)
+{
+    int status = 0;
+    uint64_t dword;
+
+    if (address % HDL_FLASH_PROGRAMM_BYTE_WIDTHT != 0 || size % HDL_FLASH_PROGRAMM_BYTE_WIDTHT != 0 ||
+        address < HDL_FLASH_BASE_ADDR || size > HDL_FLASH_END_ADDR - address + 1) {
+        return -1;
+    }
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < size; i += HDL_FLASH_PROGRAMM_BYTE_WIDTHT) {
+        memcpy(&dword, data + i, sizeof(dword));
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + i, dword) != HAL_OK) {
+            status = -1;
+            break;
+        }
+    }
+    HAL_FLASH_Lock();
+    return status;
+}
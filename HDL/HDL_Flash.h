@@ -64,6 +64,8 @@ Fast program a 32 row double-word (64-bit) at a specified address.
 int HDL_Flash_init();
 int HDL_Flash_write(uint32_t address, uint8_t *data, uint32_t size);
 int HDL_Flash_read(uint32_t address, uint8_t *buf, uint32_t size);
+int HDL_Flash_erase_one_sector(uint32_t sector);
+int HDL_Flash_program_nocheck(uint32_t address, const uint8_t *data, uint32_t size);
 #ifdef __cplusplus
 }
 #endif
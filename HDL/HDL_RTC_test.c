@@ -62,16 +62,33 @@ void HDL_RTC_test()
     }
 }
 
-void HDL_RTC_leap_year_test()
+static uint32_t rtc_test_error = 0;
+
+static void rtc_check(bool ok, const char *what)
+{
+    if (!ok) {
+        rtc_test_error++;
+        ULOG_ERROR("[RTC Test] check failed: %s", what);
+    }
+}
+
+/**
+ * @brief 闰年测试：从2044-02-28 23:59:57走过2月29日0点，检查每秒读到的日期、时间和星期。
+ *
+ * @return uint32_t 错误数。
+ */
+uint32_t HDL_RTC_leap_year_test()
 {
     ulog_init_user();
 
     HDL_RTC_Init();
     mtime_t setTime;
     mtime_t datetime;
-    uint16_t subsec    = 0;
-    uint32_t timestamp = 0;
-    uint8_t week       = 0;
+    uint32_t setTick  = 0;
+    uint32_t offset   = 0;
+    uint32_t lastTick = 0;
+    uint8_t week      = 0;
+    bool crossed      = false;
 
     // CASE 1:
     //  setTime.nYear = 2000;
@@ -82,6 +99,7 @@ void HDL_RTC_leap_year_test()
     //  setTime.nSec = 58;
     //  setTime.wSub = 0;
 
+    rtc_test_error = 0;
     setTime.nYear  = 2044;
     setTime.nMonth = 2;
     setTime.nDay   = 28;
@@ -90,9 +108,11 @@ void HDL_RTC_leap_year_test()
     setTime.nSec   = 57;
     setTime.wSub   = 0;
     HDL_RTC_SetStructTime(&setTime);
+    setTick  = mtime_2_unix_sec(&setTime);
+    lastTick = setTick;
 
     int n = 4;
-    while (n--) {
+    for (int i = 1; i <= n; i++) {
         HDL_CPU_Time_DelayMs(1000 - 1);
 
         HDL_RTC_GetStructTime(&datetime);
@@ -100,7 +120,27 @@ void HDL_RTC_leap_year_test()
         Debug_Printf("%04d-%02d-%02d %02d:%02d:%02d %02d\r\n", datetime.nYear, datetime.nMonth, datetime.nDay, datetime.nHour, datetime.nMin, datetime.nSec, datetime.wSub);
         week = mtime_get_week(datetime.nYear, datetime.nMonth, datetime.nDay);
         Debug_Printf("week : %u\r\n", (uint32_t)week);
+
+        // 每次等待999ms，第i次读到的时间比设置的时间晚i-1或者i秒
+        offset = mtime_2_unix_sec(&datetime) - setTick;
+        rtc_check(offset + 1 >= (uint32_t)i && offset <= (uint32_t)i, "elapsed seconds");
+        rtc_check(mtime_2_unix_sec(&datetime) >= lastTick, "time goes backwards");
+        lastTick = mtime_2_unix_sec(&datetime);
+        if (offset < 3) {
+            rtc_check(datetime.nYear == 2044 && datetime.nMonth == 2 && datetime.nDay == 28, "date before midnight");
+            rtc_check(datetime.nHour == 23 && datetime.nMin == 59 && datetime.nSec == 57 + offset, "time before midnight");
+            rtc_check(week == 7, "week of 2044-02-28");
+        } else {
+            rtc_check(datetime.nYear == 2044 && datetime.nMonth == 2 && datetime.nDay == 29, "date after midnight");
+            rtc_check(datetime.nHour == 0 && datetime.nMin == 0 && datetime.nSec == offset - 3, "time after midnight");
+            rtc_check(week == 1, "week of 2044-02-29");
+            crossed = true;
+        }
     }
+    rtc_check(crossed, "2044-02-29 reached");
+
+    ULOG_INFO("[RTC Test] %s", rtc_test_error == 0 ? "pass" : "fail");
+    return rtc_test_error;
 }
 
 /**
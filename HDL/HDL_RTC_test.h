@@ -14,6 +14,6 @@
 
 #include "HDL_RTC.h"
 void HDL_RTC_test();
-void HDL_RTC_leap_year_test();
+uint32_t HDL_RTC_leap_year_test();
 void HDL_RTC_subsecond_test();
 #endif // !HDL_RTC_TEST_H
\ No newline at end of file
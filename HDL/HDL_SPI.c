@@ -12,6 +12,33 @@
 #include "HDL_CPU_Time.h"
 #include "main.h"
 
+// SPI2的块传输使用DMA2，DMA1的通道已经分给了ADC和QSPI。完成标志轮询等待，不使用中断。
+#define HDL_SPI_DMA            DMA2
+#define HDL_SPI_DMA_RX_CHANNEL LL_DMA_CHANNEL_1
+#define HDL_SPI_DMA_TX_CHANNEL LL_DMA_CHANNEL_2
+
+/**
+ * @brief 配置SPI2收发的DMA通道，外设地址、请求和数据宽度固定，存储器地址和长度每次传输时设置。
+ *
+ */
+static void HDL_SPI_DMA_Init()
+{
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMAMUX1);
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+    LL_DMA_SetPeriphRequest(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL, LL_DMAMUX_REQ_SPI2_RX);
+    LL_DMA_ConfigTransfer(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL,
+                          LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_PRIORITY_VERYHIGH | LL_DMA_MODE_NORMAL |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE);
+    LL_DMA_SetPeriphAddress(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL, LL_SPI_DMA_GetRegAddr(SPI2));
+
+    LL_DMA_SetPeriphRequest(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL, LL_DMAMUX_REQ_SPI2_TX);
+    LL_DMA_ConfigTransfer(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL,
+                          LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_PRIORITY_HIGH | LL_DMA_MODE_NORMAL |
+                              LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE);
+    LL_DMA_SetPeriphAddress(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL, LL_SPI_DMA_GetRegAddr(SPI2));
+}
+
 /**
  * @brief SPI初始化。默认为全双工主机,MSB First。通信频率会尽量接近SPI外设允许的最大频率。软件片选。
  *
@@ -96,9 +123,43 @@ void HDL_SPI_Init(SPI_ID_t spiID, uint8_t dataSize, uint32_t CPOL, uint32_t CPHA
     LL_SPI_DisableNSSPulseMgt(SPI2);
     /* USER CODE BEGIN SPI2_Init 2 */
     LL_SPI_Enable(SPI2);
+    HDL_SPI_DMA_Init();
     /* USER CODE END SPI2_Init 2 */
 }
 
+/**
+ * @brief 设置SPI时钟频率，选择不超过maxHz的最高频率。SPI时钟为PCLK1的2~256分频，
+ * maxHz低于256分频时使用256分频。必须在没有传输进行时调用。
+ *
+ * @param spiID SPI设备ID。
+ * @param maxHz 允许的最高频率，Hz。
+ * @return uint32_t 实际的SPI时钟频率，Hz。
+ */
+uint32_t HDL_SPI_SetClock(SPI_ID_t spiID, uint32_t maxHz)
+{
+    const uint32_t prescalerTable[] = {LL_SPI_BAUDRATEPRESCALER_DIV2, LL_SPI_BAUDRATEPRESCALER_DIV4, LL_SPI_BAUDRATEPRESCALER_DIV8, LL_SPI_BAUDRATEPRESCALER_DIV16, LL_SPI_BAUDRATEPRESCALER_DIV32, LL_SPI_BAUDRATEPRESCALER_DIV64, LL_SPI_BAUDRATEPRESCALER_DIV128, LL_SPI_BAUDRATEPRESCALER_DIV256};
+    LL_RCC_ClocksTypeDef clocks     = {0};
+    uint32_t startMoment            = 0;
+    uint32_t hz                     = 0;
+    uint32_t i                      = 0;
+
+    LL_RCC_GetSystemClocksFreq(&clocks);
+    hz = clocks.PCLK1_Frequency / 2;
+    while (hz > maxHz && i < sizeof(prescalerTable) / sizeof(prescalerTable[0]) - 1) {
+        hz /= 2;
+        i++;
+    }
+
+    // 分频系数只能在SPI关闭时修改，关闭前等最后一帧发完
+    startMoment = HDL_CPU_Time_GetTick();
+    while (LL_SPI_IsActiveFlag_BSY(SPI2) && HDL_CPU_Time_GetTick() - startMoment <= 10) {
+    }
+    LL_SPI_Disable(SPI2);
+    LL_SPI_SetBaudRatePrescaler(SPI2, prescalerTable[i]);
+    LL_SPI_Enable(SPI2);
+    return hz;
+}
+
 /**
  * @brief SPI读写。阻塞式读写方法。不能再中断中调用。默认超时时间为10ms。
  *
@@ -191,6 +252,130 @@ uint32_t HDL_SPI_Read(SPI_ID_t spiID, byte_t *pRxData, uint16_t size, uint32_t t
     return true;
 }
 
+/**
+ * @brief 逐字节收发，发送或接收缓冲区不递增时重复使用第一个字节。
+ *
+ */
+static bool HDL_SPI_TransferPolling(const byte_t *pTxData, bool txIncrement, byte_t *pRxData, bool rxIncrement, uint16_t size, uint32_t timeout)
+{
+    uint32_t startMoment = HDL_CPU_Time_GetTick();
+
+    while (size--) {
+        while (!LL_SPI_IsActiveFlag_TXE(SPI2)) {
+            if (HDL_CPU_Time_GetTick() - startMoment > timeout) {
+                return false;
+            }
+        }
+        LL_SPI_TransmitData8(SPI2, *pTxData);
+        while (!LL_SPI_IsActiveFlag_RXNE(SPI2)) {
+            if (HDL_CPU_Time_GetTick() - startMoment > timeout) {
+                return false;
+            }
+        }
+        *pRxData = LL_SPI_ReceiveData8(SPI2);
+        pTxData += txIncrement ? 1 : 0;
+        pRxData += rxIncrement ? 1 : 0;
+    }
+    return true;
+}
+
+/**
+ * @brief DMA收发，CPU只等待接收通道完成。接收完成时最后一个字节已经发送完毕，
+ * 所以只检查接收通道的完成标志。
+ *
+ */
+static bool HDL_SPI_TransferDMA(const byte_t *pTxData, bool txIncrement, byte_t *pRxData, bool rxIncrement, uint16_t size, uint32_t timeout)
+{
+    uint32_t startMoment = HDL_CPU_Time_GetTick();
+    bool ok              = true;
+
+    // 丢弃接收FIFO中残留的数据，否则DMA会先搬走旧数据
+    while (LL_SPI_IsActiveFlag_RXNE(SPI2)) {
+        (void)LL_SPI_ReceiveData8(SPI2);
+    }
+
+    LL_DMA_SetMemoryIncMode(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL, rxIncrement ? LL_DMA_MEMORY_INCREMENT : LL_DMA_MEMORY_NOINCREMENT);
+    LL_DMA_SetMemoryAddress(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL, (uint32_t)pRxData);
+    LL_DMA_SetDataLength(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL, size);
+    LL_DMA_SetMemoryIncMode(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL, txIncrement ? LL_DMA_MEMORY_INCREMENT : LL_DMA_MEMORY_NOINCREMENT);
+    LL_DMA_SetMemoryAddress(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL, (uint32_t)pTxData);
+    LL_DMA_SetDataLength(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL, size);
+    LL_DMA_ClearFlag_GI1(HDL_SPI_DMA);
+    LL_DMA_ClearFlag_GI2(HDL_SPI_DMA);
+
+    // 参考手册要求的顺序：先使能接收请求和接收通道，再使能发送通道和发送请求
+    LL_SPI_EnableDMAReq_RX(SPI2);
+    LL_DMA_EnableChannel(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL);
+    LL_DMA_EnableChannel(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL);
+    LL_SPI_EnableDMAReq_TX(SPI2);
+
+    while (!LL_DMA_IsActiveFlag_TC1(HDL_SPI_DMA)) {
+        if (LL_DMA_IsActiveFlag_TE1(HDL_SPI_DMA) || LL_DMA_IsActiveFlag_TE2(HDL_SPI_DMA) ||
+            HDL_CPU_Time_GetTick() - startMoment > timeout) {
+            ok = false;
+            break;
+        }
+    }
+
+    LL_SPI_DisableDMAReq_TX(SPI2);
+    LL_DMA_DisableChannel(HDL_SPI_DMA, HDL_SPI_DMA_TX_CHANNEL);
+    LL_DMA_DisableChannel(HDL_SPI_DMA, HDL_SPI_DMA_RX_CHANNEL);
+    LL_SPI_DisableDMAReq_RX(SPI2);
+    LL_DMA_ClearFlag_GI1(HDL_SPI_DMA);
+    LL_DMA_ClearFlag_GI2(HDL_SPI_DMA);
+    return ok;
+}
+
+/**
+ * @brief 块写，接收到的数据丢弃。不少于HDL_SPI_DMA_MIN_SIZE字节时由DMA搬运，
+ * 字节之间没有间隙，SPI时钟连续。阻塞到传输完成，不能在中断中调用。
+ *
+ * @param spiID SPI设备ID。
+ * @param pTxData 发送数据缓冲区。
+ * @param size 数据长度。
+ * @param timeout 超时时间，ms。
+ * @return true 写成功。
+ * @return false 超时或者DMA错误。
+ */
+bool HDL_SPI_WriteBlock(SPI_ID_t spiID, const byte_t *pTxData, uint16_t size, uint32_t timeout)
+{
+    static byte_t discard = 0;
+
+    if (pTxData == NULL || size == 0) {
+        return false;
+    }
+    if (size < HDL_SPI_DMA_MIN_SIZE) {
+        return HDL_SPI_TransferPolling(pTxData, true, &discard, false, size, timeout);
+    }
+    return HDL_SPI_TransferDMA(pTxData, true, &discard, false, size, timeout);
+}
+
+/**
+ * @brief 块读，发送线上一直输出fill。不少于HDL_SPI_DMA_MIN_SIZE字节时由DMA搬运。
+ * 阻塞到传输完成，不能在中断中调用。
+ *
+ * @param spiID SPI设备ID。
+ * @param pRxData 接收数据缓冲区。
+ * @param size 数据长度。
+ * @param fill 读取时发送的字节，SD卡、Flash一般为0xFF。
+ * @param timeout 超时时间，ms。
+ * @return true 读成功。
+ * @return false 超时或者DMA错误。
+ */
+bool HDL_SPI_ReadBlock(SPI_ID_t spiID, byte_t *pRxData, uint16_t size, byte_t fill, uint32_t timeout)
+{
+    static byte_t txFill = 0;
+
+    if (pRxData == NULL || size == 0) {
+        return false;
+    }
+    txFill = fill;
+    if (size < HDL_SPI_DMA_MIN_SIZE) {
+        return HDL_SPI_TransferPolling(&txFill, false, pRxData, true, size, timeout);
+    }
+    return HDL_SPI_TransferDMA(&txFill, false, pRxData, true, size, timeout);
+}
+
 /**
  * @brief SPI去初始化。
  *
@@ -58,10 +58,16 @@ CPOL as active-high.
 #define HDL_SPI_DATA_SIZE_8  (8 - 1)
 #define HDL_SPI_DATA_SIZE_16 (16 - 1)
 
+// 块传输不少于这么多字节时使用DMA，更短的数据配置DMA的开销比逐字节读写还大
+#define HDL_SPI_DMA_MIN_SIZE 16
+
 void HDL_SPI_Init(SPI_ID_t spiID, byte_t dataSize, uint32_t CPOL, uint32_t CPHA);
+uint32_t HDL_SPI_SetClock(SPI_ID_t spiID, uint32_t maxHz);
 bool HDL_SPI_WriteRead(SPI_ID_t spiID, byte_t *pTxData, byte_t *pRxData, uint16_t size, uint32_t timeout);
 uint32_t HDL_SPI_Read(SPI_ID_t spiID, byte_t *pRxData, uint16_t size, uint32_t timeout);
 uint32_t HDL_SPI_Write(SPI_ID_t spiID, byte_t *pTxData, uint32_t size, uint32_t timeout);
+bool HDL_SPI_WriteBlock(SPI_ID_t spiID, const byte_t *pTxData, uint16_t size, uint32_t timeout);
+bool HDL_SPI_ReadBlock(SPI_ID_t spiID, byte_t *pRxData, uint16_t size, byte_t fill, uint32_t timeout);
 void HDL_SPI_DeInit(SPI_ID_t spiID);
 
 #ifdef __cplusplus
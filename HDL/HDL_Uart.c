@@ -554,6 +554,7 @@ uint32_t Uart_Write(COMID_t comId, const uint8_t *writeBuf, uint32_t uLen)
                 Uart_EnableIT_TXE(comId);
             }
         }
+        uiBytesWritten++;
     }
 
     Uart_EnableIT_TXE(comId);
@@ -593,6 +594,22 @@ uint32_t Uart_AvailableBytes(COMID_t comId)
     return uRtn;
 }
 
+/**
+ * @brief 是否有已经初始化的串口接收缓存中还有数据没有读取，主循环据此决定能否低功耗空闲。
+ *
+ * @return true 有数据没有读取。
+ * @return false 所有串口接收缓存都是空的。
+ */
+bool Uart_HasPendingWork()
+{
+    for (int i = 0; i < COM_NUM; i++) {
+        if (_gCOMList[i].inited && !cqueue_is_empty(&_gCOMList[i].rxQueue)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief 清空串口接收缓存。
  *
@@ -26,6 +26,7 @@
 extern "C" {
 #endif
 #include "main.h"
+#include <stdbool.h>
 
 // 串口号定义
 typedef enum {
@@ -45,6 +46,7 @@ void Uart_Init(COMID_t comId, uint32_t baud, uint32_t wordLen, uint32_t stopBit,
 uint32_t Uart_Write(COMID_t comId, const uint8_t *writeBuf, uint32_t uLen);
 uint32_t Uart_Read(COMID_t comId, uint8_t *pBuf, uint32_t uiLen);
 uint32_t Uart_AvailableBytes(COMID_t comId);
+bool Uart_HasPendingWork();
 uint32_t Uart_EmptyReadBuffer(COMID_t comId);
 uint8_t Uart_SetWriteOverCallback(COMID_t comId, UartWriteOverCallback_t callback, void *args);
 uint8_t Uart_RegisterReceiveCharCallback(COMID_t comId, UartReceiveCharCallback_t callback);
@@ -0,0 +1,416 @@
+/**
+ * @file CHIP_W25Q512_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上的W25Q512实现，64MB的镜像文件映射到内存中，文件由环境变量RTU_HOST_FLASH指定，
+ * 默认RTU_HOST_IMAGE_DIR下的w25q512.bin，不存在时创建并填充0xFF。
+ * 和NOR Flash一样，页编程只能把1写成0（新数据和原数据按位与），超过页末尾的数据回到页开头，
+ * 擦除把整个扇区写成0xFF，上层在主机上写错的地方和目标板上一样会读出错误的数据。
+ * 数据立即写入镜像，耗时只记在模型时间中，见CHIP_W25Q512_host.h。QSPI永远不忙；不等待完成的擦除和编程
+ * 之后芯片在模型时间中忙，读取和命令和目标板一样先等待，芯片忙时发出的读取得到错误的数据。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CHIP_W25Q512.h"
+#include "CHIP_W25Q512_host.h"
+#include "HDL_Host.h"
+
+int32_t w25q512_wait_busy(uint32_t timeout);
+int32_t w25q512_send_cmd(uint8_t cmd);
+uint8_t w25q512_is_busy();
+
+static uint8_t *_gImage = NULL;
+static CHIP_W25Q512_Host_Stat_t _gStat;
+// 后台读取完成的模型时间
+static uint64_t _gReadDoneNs = 0;
+// 不等待完成的擦除、编程结束的模型时间
+static uint64_t _gBusyDoneNs = 0;
+// 同目标板的w25q512_pending
+static bool _gPending = false;
+// 之后这么多次擦除、编程命令失败，用于测试错误处理
+static uint32_t _gFailOps = 0;
+
+static uint64_t w25q512_host_read_ns(uint32_t size)
+{
+    return (uint64_t)((W25Q512_HOST_READ_CMD_CLKS + 2.0 * size) * W25Q512_HOST_CLK_NS);
+}
+
+/**
+ * @brief 阻塞的操作：先等后台读取完成，再等操作本身。
+ *
+ */
+static void w25q512_host_block(uint64_t ns)
+{
+    CHIP_W25Q512_read_wait();
+    _gStat.waitNs += ns;
+    _gStat.nowNs += ns;
+}
+
+static bool w25q512_host_chip_busy()
+{
+    return _gStat.nowNs < _gBusyDoneNs;
+}
+
+/**
+ * @brief 同目标板的w25q512_wait_pending：有不等待完成的擦除、编程时等待结束。
+ *
+ */
+static void w25q512_host_wait_pending()
+{
+    if (_gPending) {
+        if (w25q512_host_chip_busy()) {
+            _gStat.busyWaits++;
+        }
+        w25q512_wait_busy(W25Q512_TIMEOUT_DEFAULT_VALUE);
+    }
+}
+
+/**
+ * @brief 芯片忙时发出的读取、编程和擦除在目标板上得不到正确的结果。
+ *
+ * @return true 芯片空闲，可以执行。
+ */
+static bool w25q512_host_cmd_ok()
+{
+    if (w25q512_host_chip_busy()) {
+        _gStat.busyViolations++;
+        return false;
+    }
+    return true;
+}
+
+void CHIP_W25Q512_Host_Elapse(uint64_t ns)
+{
+    _gStat.nowNs += ns;
+}
+
+void CHIP_W25Q512_Host_GetStat(CHIP_W25Q512_Host_Stat_t *pStat)
+{
+    *pStat = _gStat;
+}
+
+void CHIP_W25Q512_Host_FailOps(uint32_t n)
+{
+    _gFailOps = n;
+}
+
+void CHIP_W25Q512_Host_ResetStat(void)
+{
+    memset(&_gStat, 0, sizeof(_gStat));
+    _gReadDoneNs = 0;
+    _gBusyDoneNs = 0;
+    _gPending    = false;
+}
+
+/**
+ * @brief 打开并映射镜像文件，新建的文件填充0xFF。
+ *
+ * @return int32_t 成功返回0，失败返回-1。
+ */
+static int32_t w25q512_host_open()
+{
+    const char *path = getenv("RTU_HOST_FLASH");
+    struct stat st;
+    bool fresh = false;
+    int fd     = -1;
+
+    if (_gImage != NULL) {
+        return 0;
+    }
+    if (path == NULL || path[0] == '\0') {
+        path = RTU_HOST_IMAGE_DIR "/w25q512.bin";
+    }
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "[HOST] open %s failed: %s\n", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    if ((uint64_t)st.st_size != W25Q512_FLASH_SIZE) {
+        fresh = true;
+        if (ftruncate(fd, W25Q512_FLASH_SIZE) != 0) {
+            fprintf(stderr, "[HOST] resize %s failed: %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+    }
+    _gImage = mmap(NULL, W25Q512_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (_gImage == MAP_FAILED) {
+        fprintf(stderr, "[HOST] mmap %s failed: %s\n", path, strerror(errno));
+        _gImage = NULL;
+        return -1;
+    }
+    if (fresh) {
+        memset(_gImage, 0xFF, W25Q512_FLASH_SIZE);
+    }
+    return 0;
+}
+
+static bool w25q512_host_range_ok(uint32_t address, uint32_t size)
+{
+    return w25q512_host_open() == 0 && address < W25Q512_FLASH_SIZE && size <= W25Q512_FLASH_SIZE - address;
+}
+
+int32_t CHIP_W25Q512_Init()
+{
+    return w25q512_host_open();
+}
+
+bool CHIP_W25Q512_IsBusy()
+{
+    return false;
+}
+
+bool CHIP_W25Q512_IsProgramming()
+{
+    return _gPending && w25q512_is_busy();
+}
+
+int32_t CHIP_W25Q512_read(uint32_t address, uint8_t *buf, uint32_t size)
+{
+    if (CHIP_W25Q512_read_start(address, buf, size) != 0) {
+        return -1;
+    }
+    return CHIP_W25Q512_read_wait();
+}
+
+/**
+ * @brief 数据立即复制到buf，读取的时间在模型时间中后台进行。芯片忙时读出的是错误的数据。
+ *
+ */
+int32_t CHIP_W25Q512_read_start(uint32_t address, uint8_t *buf, uint32_t size)
+{
+    if (!w25q512_host_range_ok(address, size)) {
+        return -1;
+    }
+    CHIP_W25Q512_read_wait();
+    w25q512_host_wait_pending();
+    if (w25q512_host_cmd_ok()) {
+        memcpy(buf, _gImage + address, size);
+    } else {
+        memset(buf, 0x5A, size);
+    }
+    _gStat.reads++;
+    _gStat.readBytes += size;
+    _gReadDoneNs = _gStat.nowNs + w25q512_host_read_ns(size);
+    return 0;
+}
+
+int32_t CHIP_W25Q512_read_wait()
+{
+    if (_gReadDoneNs > _gStat.nowNs) {
+        _gStat.waitNs += _gReadDoneNs - _gStat.nowNs;
+        _gStat.nowNs = _gReadDoneNs;
+    }
+    return 0;
+}
+
+/**
+ * @brief 随机写，和目标板一样按扇区读出、修改、擦除、写回。
+ *
+ * @param address 数据写到flash中的地址。
+ * @param data 指向待存放数据的指针。
+ * @param size 数据长度，单位字节。
+ * @return int32_t 成功返回0，失败返回-1。
+ */
+int32_t CHIP_W25Q512_write(uint32_t address, uint8_t *data, uint32_t size)
+{
+    static uint8_t sector_buf[W25Q512_SECTOR_SIZE];
+    uint32_t sec    = 0;
+    uint32_t offset = 0;
+    uint32_t len    = 0;
+
+    if (!w25q512_host_range_ok(address, size)) {
+        return -1;
+    }
+    while (size > 0) {
+        sec    = address / W25Q512_SECTOR_SIZE;
+        offset = address % W25Q512_SECTOR_SIZE;
+        len    = W25Q512_SECTOR_SIZE - offset < size ? W25Q512_SECTOR_SIZE - offset : size;
+        CHIP_W25Q512_read(sec * W25Q512_SECTOR_SIZE, sector_buf, W25Q512_SECTOR_SIZE);
+        memcpy(sector_buf + offset, data, len);
+        w25q512_erase_one_sector(sec);
+        w25q512_write_one_sector_no_erase(sec, sector_buf);
+        address += len;
+        data += len;
+        size -= len;
+    }
+    return 0;
+}
+
+int32_t w25q512_wait_busy(uint32_t timeout)
+{
+    (void)timeout;
+    CHIP_W25Q512_read_wait();
+    if (w25q512_host_chip_busy()) {
+        _gStat.waitNs += _gBusyDoneNs - _gStat.nowNs;
+        _gStat.nowNs = _gBusyDoneNs;
+    }
+    _gPending = false;
+    return 0;
+}
+
+int32_t w25q512_send_cmd(uint8_t cmd)
+{
+    (void)cmd;
+    CHIP_W25Q512_read_wait();
+    w25q512_host_wait_pending();
+    return w25q512_host_open();
+}
+
+bool w25q512_is_sector_erased(uint32_t sector)
+{
+    if (!w25q512_host_range_ok(sector * W25Q512_SECTOR_SIZE, W25Q512_SECTOR_SIZE)) {
+        return false;
+    }
+    // 目标板上读出整个扇区检查
+    CHIP_W25Q512_read_wait();
+    w25q512_host_wait_pending();
+    w25q512_host_cmd_ok();
+    _gStat.reads++;
+    _gStat.readBytes += W25Q512_SECTOR_SIZE;
+    w25q512_host_block(w25q512_host_read_ns(W25Q512_SECTOR_SIZE));
+    for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+        if (_gImage[sector * W25Q512_SECTOR_SIZE + i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 发出擦除命令，芯片在模型时间中忙ns，ns不为0时是不等待完成的擦除。
+ * 先和目标板一样发写使能（等待之前的擦除、编程）。
+ *
+ */
+static int32_t w25q512_host_erase(uint32_t sector, uint64_t ns)
+{
+    if (!w25q512_host_range_ok(sector * W25Q512_SECTOR_SIZE, W25Q512_SECTOR_SIZE)) {
+        return -1;
+    }
+    w25q512_send_cmd(W25QXX_CMD_WriteEnable);
+    if (_gFailOps > 0) {
+        _gFailOps--;
+        return -1;
+    }
+    if (!w25q512_host_cmd_ok()) {
+        return 0;
+    }
+    memset(_gImage + sector * W25Q512_SECTOR_SIZE, 0xFF, W25Q512_SECTOR_SIZE);
+    _gStat.erases++;
+    _gBusyDoneNs = _gStat.nowNs + ns;
+    _gPending    = ns != 0;
+    return 0;
+}
+
+int32_t w25q512_erase_one_sector(uint32_t sector)
+{
+    int32_t status = w25q512_host_erase(sector, 0);
+
+    w25q512_host_block(W25Q512_HOST_ERASE_NS);
+    return status;
+}
+
+int32_t w25q512_erase_one_sector_cmd(uint32_t sector)
+{
+    return w25q512_host_erase(sector, W25Q512_HOST_ERASE_NS);
+}
+
+/**
+ * @brief 页编程，超过页末尾的数据从页开头继续写，和芯片的行为相同。
+ *
+ * @param address 写入闪存的数据地址。
+ * @param buf 指向待写入数据的指针。
+ * @param size 待写入数据的大小，单位字节，不超过一页。
+ * @return int32_t 成功返回0，失败返回-1。
+ */
+static int32_t w25q512_host_program(uint32_t address, uint8_t *buf, uint32_t size, uint64_t ns)
+{
+    uint32_t page = address - address % W25Q512_PAGE_SIZE;
+
+    if (size > W25Q512_PAGE_SIZE || !w25q512_host_range_ok(page, W25Q512_PAGE_SIZE)) {
+        return -1;
+    }
+    w25q512_send_cmd(W25QXX_CMD_WriteEnable);
+    if (_gFailOps > 0) {
+        _gFailOps--;
+        return -1;
+    }
+    if (!w25q512_host_cmd_ok()) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        _gImage[page + (address + i) % W25Q512_PAGE_SIZE] &= buf[i];
+    }
+    _gStat.pagePrograms++;
+    _gBusyDoneNs = _gStat.nowNs + ns;
+    _gPending    = ns != 0;
+    return 0;
+}
+
+int32_t w25q512_write_page_no_erase(uint32_t address, uint8_t *buf, uint32_t size)
+{
+    int32_t status = w25q512_host_program(address, buf, size, 0);
+
+    w25q512_host_block(W25Q512_HOST_PROGRAM_NS);
+    return status;
+}
+
+int32_t w25q512_write_page_no_erase_no_wait(uint32_t address, uint8_t *buf, uint32_t size)
+{
+    return w25q512_host_program(address, buf, size, W25Q512_HOST_PROGRAM_NS);
+}
+
+int32_t w25q512_write_one_sector_no_erase(uint32_t sector, uint8_t *buf)
+{
+    int32_t status = 0;
+
+    for (uint32_t page_idx = 0; page_idx < W25Q512_SECTOR_SIZE / W25Q512_PAGE_SIZE; page_idx++) {
+        status = w25q512_write_page_no_erase(sector * W25Q512_SECTOR_SIZE + page_idx * W25Q512_PAGE_SIZE,
+                                             buf + page_idx * W25Q512_PAGE_SIZE, W25Q512_PAGE_SIZE);
+    }
+    return status;
+}
+
+int32_t w25q512_write_one_sector(uint32_t sector, uint8_t *buf)
+{
+    if (!w25q512_is_sector_erased(sector)) {
+        w25q512_erase_one_sector(sector);
+    }
+    return w25q512_write_one_sector_no_erase(sector, buf);
+}
+
+uint8_t w25q512_read_status_reg(uint8_t reg)
+{
+    // 读状态寄存器的时间，轮询忙标志的循环因此推进模型时间
+    w25q512_host_block((uint64_t)(W25Q512_HOST_STATUS_CLKS * W25Q512_HOST_CLK_NS));
+    if (reg == W25QXX_CMD_ReadStatusReg1) {
+        return w25q512_host_chip_busy() ? W25QXX_STATUS_REG1_BUSY : 0;
+    }
+    // 状态寄存器3：4字节地址模式
+    return reg == W25QXX_CMD_ReadStatusReg3 ? W25QXX_STATUS_REG3_ADS : 0;
+}
+
+uint8_t w25q512_is_busy()
+{
+    uint8_t status = (w25q512_read_status_reg(W25QXX_CMD_ReadStatusReg1) & W25QXX_STATUS_REG1_BUSY) != 0;
+
+    if (status == 0) {
+        _gPending = false;
+    }
+    return status;
+}
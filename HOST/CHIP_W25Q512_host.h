@@ -0,0 +1,58 @@
+/**
+ * @file CHIP_W25Q512_host.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上W25Q512模型的附加接口：操作计数和按典型时间累计的模型时间。
+ * 读取按42.5MHz的1-4-4快速读计时，擦除一个扇区和编程一页按数据手册的典型值计时。
+ * 阻塞的操作推进模型时间，CHIP_W25Q512_read_start启动的读取在后台进行，
+ * CHIP_W25Q512_read_wait只等待剩余的时间，CHIP_W25Q512_Host_Elapse模拟期间CPU在做别的事情（例如USB传输）。
+ * 不等待完成的擦除和页编程（日志分区、QFS）之后芯片在模型时间中忙，和目标板一样读取和命令先等芯片空闲，
+ * 芯片忙时发出的读取读出错误的数据、编程和擦除被忽略，记在busyViolations中。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef CHIP_W25Q512_HOST_H
+#define CHIP_W25Q512_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+// QSPI时钟周期，ns（170MHz 4分频）
+#define W25Q512_HOST_CLK_NS        (1000.0 / 42.5)
+// 1-4-4快速读的指令、地址、模式位和空周期
+#define W25Q512_HOST_READ_CMD_CLKS 22U
+// 擦除一个扇区的典型时间，ns
+#define W25Q512_HOST_ERASE_NS      45000000ULL
+// 编程一页的典型时间，ns
+#define W25Q512_HOST_PROGRAM_NS    400000ULL
+// 读一次状态寄存器的时钟周期数
+#define W25Q512_HOST_STATUS_CLKS   16U
+
+typedef struct {
+    uint32_t reads;        // 读命令数
+    uint64_t readBytes;    // 读取的字节数
+    uint32_t erases;       // 扇区擦除次数
+    uint32_t pagePrograms; // 页编程次数
+    uint64_t waitNs;       // CPU等待Flash的时间：阻塞的读取、擦除、编程和等待后台读取完成
+    uint64_t nowNs;        // 模型时间
+    uint32_t busyWaits;      // 读取或者命令等待不等待完成的擦除、编程结束的次数
+    uint32_t busyViolations; // 芯片忙时发出的读取、编程和擦除，目标板上读出错误的数据或者写入丢失
+} CHIP_W25Q512_Host_Stat_t;
+
+void CHIP_W25Q512_Host_Elapse(uint64_t ns);
+void CHIP_W25Q512_Host_GetStat(CHIP_W25Q512_Host_Stat_t *pStat);
+void CHIP_W25Q512_Host_ResetStat(void);
+// 之后的n次擦除、编程命令失败（返回-1，不修改内容）
+void CHIP_W25Q512_Host_FailOps(uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !CHIP_W25Q512_HOST_H
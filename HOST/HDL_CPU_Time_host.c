@@ -0,0 +1,264 @@
+/**
+ * @file HDL_CPU_Time_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上的HDL_CPU_Time实现，时间来自clock_gettime(CLOCK_MONOTONIC)，
+ * 上层代码和HDL_CPU_PROFILE_BEGIN/END在仿真中不用修改。
+ * 主机上没有定时器中断：硬件定时器的回调、CPU tick回调和HDL_Host_AddPoll注册的轮询函数在读取时间、
+ * 延时和空闲时检查并执行，主循环一直在读时间，所以回调的延迟一般在几十us以内，但是不会打断正在执行的代码。
+ * 周期数按1ns一个周期计，HDL_CPU_Time_CyclesPerUs返回1000。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "HDL_CPU_Time.h"
+#include "HDL_Host.h"
+
+#define HOST_HARD_TIMER_NUM 4
+
+typedef struct tagHostHardTimer_t {
+    bool active;
+    uint64_t deadlineUs;
+    CPU_Time_Callback_t callback;
+} HostHardTimer_t;
+
+bool cpu_time_init_flag = false;
+static struct timespec _gStart;
+// HDL_CPU_Time_ResetTick/ResetUsTick时的时间，32位tick从这里开始计数
+static uint64_t _gTickZeroUs;
+static uint64_t _gUsTickZeroUs;
+static uint64_t _gLastTickCallbackMs;
+static CPU_Time_Callback_t _gCPUTickCallback = NULL;
+static HostHardTimer_t _gHardTimer[HOST_HARD_TIMER_NUM];
+static HDL_CPU_Time_IdleStat_t _gIdleStat = {0};
+static bool _gInDispatch                  = false;
+static HDL_Host_Poll_t _gPoll[HDL_HOST_POLL_MAX];
+static uint32_t _gPollNum    = 0;
+static uint64_t _gLastPollUs = 0;
+
+static uint64_t HDL_CPU_Time_HostNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - _gStart.tv_sec) * 1000000000ULL + (uint64_t)now.tv_nsec - (uint64_t)_gStart.tv_nsec;
+}
+
+/**
+ * @brief 执行轮询函数、已经到期的硬件定时器回调和CPU tick回调，代替目标板上的中断。
+ * 回调中再读时间不会重复进入。
+ *
+ */
+static void HDL_CPU_Time_HostDispatch()
+{
+    uint64_t nowUs = 0;
+    uint64_t nowMs = 0;
+
+    if (_gInDispatch || cpu_time_init_flag == false) {
+        return;
+    }
+    _gInDispatch = true;
+    nowUs        = HDL_CPU_Time_HostNs() / 1000U;
+    // 轮询函数一般要做系统调用，限制频率，不拖慢主循环的频率测试
+    if (nowUs - _gLastPollUs >= HDL_HOST_POLL_INTERVAL_US) {
+        _gLastPollUs = nowUs;
+        for (uint32_t i = 0; i < _gPollNum; i++) {
+            _gPoll[i]();
+        }
+    }
+    for (uint32_t i = 0; i < HOST_HARD_TIMER_NUM; i++) {
+        if (_gHardTimer[i].active && nowUs >= _gHardTimer[i].deadlineUs) {
+            // 先关闭再执行回调，回调可能重新启动定时器
+            _gHardTimer[i].active = false;
+            _gHardTimer[i].callback();
+        }
+    }
+    nowMs = nowUs / 1000U;
+    if (_gCPUTickCallback != NULL) {
+        while (_gLastTickCallbackMs < nowMs) {
+            _gLastTickCallbackMs++;
+            _gCPUTickCallback();
+        }
+    } else {
+        _gLastTickCallbackMs = nowMs;
+    }
+    _gInDispatch = false;
+}
+
+/**
+ * @brief 注册轮询函数，代替目标板上的外设中断。
+ *
+ * @param poll
+ * @return true 成功。
+ * @return false 已经注册了HDL_HOST_POLL_MAX个。
+ */
+bool HDL_Host_AddPoll(HDL_Host_Poll_t poll)
+{
+    for (uint32_t i = 0; i < _gPollNum; i++) {
+        if (_gPoll[i] == poll) {
+            return true;
+        }
+    }
+    if (_gPollNum >= HDL_HOST_POLL_MAX) {
+        return false;
+    }
+    _gPoll[_gPollNum++] = poll;
+    return true;
+}
+
+void HDL_CPU_Time_Init()
+{
+    if (cpu_time_init_flag == true) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &_gStart);
+    _gTickZeroUs         = 0;
+    _gUsTickZeroUs       = 0;
+    _gLastTickCallbackMs = 0;
+    cpu_time_init_flag   = true;
+}
+
+uint32_t HDL_CPU_Time_GetTick()
+{
+    HDL_CPU_Time_HostDispatch();
+    return (uint32_t)((HDL_CPU_Time_HostNs() / 1000U - _gTickZeroUs) / 1000U);
+}
+
+uint64_t HDL_CPU_Time_GetTick64()
+{
+    HDL_CPU_Time_HostDispatch();
+    return HDL_CPU_Time_HostNs() / 1000000U;
+}
+
+void HDL_CPU_Time_ResetTick()
+{
+    _gTickZeroUs = HDL_CPU_Time_HostNs() / 1000U;
+}
+
+uint32_t HDL_CPU_Time_GetUsTick()
+{
+    HDL_CPU_Time_HostDispatch();
+    return (uint32_t)(HDL_CPU_Time_HostNs() / 1000U - _gUsTickZeroUs);
+}
+
+uint64_t HDL_CPU_Time_GetUsTick64()
+{
+    HDL_CPU_Time_HostDispatch();
+    return HDL_CPU_Time_HostNs() / 1000U;
+}
+
+void HDL_CPU_Time_ResetUsTick()
+{
+    _gUsTickZeroUs = HDL_CPU_Time_HostNs() / 1000U;
+}
+
+uint32_t HDL_CPU_Time_GetCycles()
+{
+    return (uint32_t)HDL_CPU_Time_HostNs();
+}
+
+uint32_t HDL_CPU_Time_CyclesPerUs()
+{
+    return 1000U;
+}
+
+/**
+ * @brief 忙等待，和目标板一样不让出CPU，期间到期的回调照常执行。
+ *
+ * @param DelayUs
+ */
+void HDL_CPU_Time_DelayUs(uint32_t DelayUs)
+{
+    uint64_t start = HDL_CPU_Time_GetUsTick64();
+
+    while (HDL_CPU_Time_GetUsTick64() - start < DelayUs) {
+    }
+}
+
+void HDL_CPU_Time_DelayMs(uint32_t DelayMs)
+{
+    uint64_t start = HDL_CPU_Time_GetTick64();
+
+    while (HDL_CPU_Time_GetTick64() - start < DelayMs) {
+    }
+}
+
+void HDL_CPU_Time_StartHardTimer(uint8_t _CC, UsTimer_t _uiTimeOut, void *_pCallBack)
+{
+    if (_CC < 1 || _CC > HOST_HARD_TIMER_NUM) {
+        return;
+    }
+    _gHardTimer[_CC - 1].callback   = (CPU_Time_Callback_t)_pCallBack;
+    _gHardTimer[_CC - 1].deadlineUs = HDL_CPU_Time_HostNs() / 1000U + _uiTimeOut;
+    _gHardTimer[_CC - 1].active     = true;
+}
+
+void HDL_CPU_Time_StopHardTimer(uint8_t _CC)
+{
+    if (_CC < 1 || _CC > HOST_HARD_TIMER_NUM) {
+        return;
+    }
+    _gHardTimer[_CC - 1].active = false;
+}
+
+void HDL_CPU_Time_SetCPUTickCallback(CPU_Time_Callback_t _pCallBack)
+{
+    _gLastTickCallbackMs = HDL_CPU_Time_HostNs() / 1000000U;
+    _gCPUTickCallback    = _pCallBack;
+}
+
+/**
+ * @brief 睡眠到下一个tick边界之后maxTicks-1个tick，或者最早的硬件定时器到期。
+ * 主机上tick由真实时间推算，不需要补偿，返回0。
+ *
+ * @param maxTicks
+ * @return uint32_t
+ */
+uint32_t HDL_CPU_Time_Idle(uint32_t maxTicks)
+{
+    struct timespec req;
+    uint64_t nowUs   = 0;
+    uint64_t wakeUs  = 0;
+    uint64_t sleepUs = 0;
+
+    if (maxTicks == 0 || cpu_time_init_flag == false) {
+        return 0;
+    }
+    maxTicks = maxTicks > HDL_CPU_TIME_IDLE_MAX_TICKS ? HDL_CPU_TIME_IDLE_MAX_TICKS : maxTicks;
+    nowUs    = HDL_CPU_Time_HostNs() / 1000U;
+    wakeUs   = (nowUs / 1000U + maxTicks) * 1000U;
+    for (uint32_t i = 0; i < HOST_HARD_TIMER_NUM; i++) {
+        if (_gHardTimer[i].active && _gHardTimer[i].deadlineUs < wakeUs) {
+            wakeUs = _gHardTimer[i].deadlineUs;
+        }
+    }
+    if (wakeUs > nowUs) {
+        sleepUs     = wakeUs - nowUs;
+        req.tv_sec  = (time_t)(sleepUs / 1000000U);
+        req.tv_nsec = (long)(sleepUs % 1000000U) * 1000L;
+        nanosleep(&req, NULL);
+    }
+    _gIdleStat.sleepUs += sleepUs;
+    _gIdleStat.wakeups++;
+    HDL_CPU_Time_HostDispatch();
+    return 0;
+}
+
+void HDL_CPU_Time_GetIdleStat(HDL_CPU_Time_IdleStat_t *pStat)
+{
+    *pStat = _gIdleStat;
+}
+
+// 主机上HAL的时基和CPU tick相同
+uint32_t HAL_GetTick(void)
+{
+    return HDL_CPU_Time_GetTick();
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    HDL_CPU_Time_DelayMs(Delay);
+}
@@ -0,0 +1,131 @@
+/**
+ * @file HDL_Flash_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上的片内Flash实现，用内存数组模拟STM32G473的512KB Flash，地址和目标板相同，
+ * 从HDL_FLASH_BASE_ADDR开始。程序退出后内容不保留。
+ * 编程只能把1写成0，擦除以page为单位写成0xFF。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "HDL_Flash.h"
+
+static uint8_t _gFlash[HDL_FLASH_SIZE];
+static bool _gFlashInited = false;
+
+static bool HDL_Flash_host_range_ok(uint32_t address, uint32_t size)
+{
+    if (!_gFlashInited) {
+        HDL_Flash_init();
+    }
+    return address >= HDL_FLASH_BASE_ADDR && address <= HDL_FLASH_END_ADDR &&
+           size <= HDL_FLASH_END_ADDR - address + 1;
+}
+
+int HDL_Flash_init()
+{
+    if (!_gFlashInited) {
+        memset(_gFlash, 0xFF, sizeof(_gFlash));
+        _gFlashInited = true;
+    }
+    return 0;
+}
+
+uint32_t HDL_Flash_get_address_by_sector(uint32_t sector)
+{
+    uint32_t addr = 0xFFFFFFFFUL;
+    if (sector < HDL_FLASH_SECTOR_NB) {
+        addr = HDL_FLASH_BASE_ADDR + sector * HDL_FLASH_SECTOR_SIZE;
+    }
+    return addr;
+}
+
+int HDL_Flash_read(uint32_t address, uint8_t *buf, uint32_t size)
+{
+    if (!HDL_Flash_host_range_ok(address, size)) {
+        return -1;
+    }
+    memcpy(buf, &_gFlash[address - HDL_FLASH_BASE_ADDR], size);
+    return 0;
+}
+
+int HDL_Flash_erase_one_sector(uint32_t sector)
+{
+    if (sector >= HDL_FLASH_SECTOR_NB || !HDL_Flash_host_range_ok(HDL_FLASH_ADDR_OF_SECTOR(sector), 0)) {
+        return -1;
+    }
+    memset(&_gFlash[sector * HDL_FLASH_SECTOR_SIZE], 0xFF, HDL_FLASH_SECTOR_SIZE);
+    return 0;
+}
+
+int HDL_Flash_erase_sector(uint32_t sector, uint32_t count)
+{
+    int status = 0;
+    for (uint32_t i = sector; i < sector + count; i++) {
+        status = HDL_Flash_erase_one_sector(i);
+        if (status != 0) {
+            break;
+        }
+    }
+    return status;
+}
+
+int HDL_Flash_write_one_sector_nocheck(uint32_t sector, uint8_t *buf)
+{
+    if (sector >= HDL_FLASH_SECTOR_NB || !HDL_Flash_host_range_ok(HDL_FLASH_ADDR_OF_SECTOR(sector), 0)) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < HDL_FLASH_SECTOR_SIZE; i++) {
+        _gFlash[sector * HDL_FLASH_SECTOR_SIZE + i] &= buf[i];
+    }
+    return 0;
+}
+
+/**
+ * @brief 随机写，和目标板一样按扇区读出、修改、擦除、写回。
+ *
+ * @param address 数据写到内部flash中的地址。
+ * @param data 指向待存放数据的指针。
+ * @param size 数据长度，单位字节。
+ * @return int 成功返回0，失败返回-1。
+ */
+int HDL_Flash_write(uint32_t address, uint8_t *data, uint32_t size)
+{
+    static uint8_t sector_buf[HDL_FLASH_SECTOR_SIZE];
+    uint32_t sec    = 0;
+    uint32_t offset = 0;
+    uint32_t len    = 0;
+
+    if (!HDL_Flash_host_range_ok(address, size)) {
+        return -1;
+    }
+    while (size > 0) {
+        sec    = HDL_SECTOR_OF_ADDRESS(address);
+        offset = address % HDL_FLASH_SECTOR_SIZE;
+        len    = HDL_FLASH_SECTOR_SIZE - offset < size ? HDL_FLASH_SECTOR_SIZE - offset : size;
+        HDL_Flash_read(HDL_FLASH_ADDR_OF_SECTOR(sec), sector_buf, HDL_FLASH_SECTOR_SIZE);
+        memcpy(sector_buf + offset, data, len);
+        HDL_Flash_erase_one_sector(sec);
+        HDL_Flash_write_one_sector_nocheck(sec, sector_buf);
+        address += len;
+        data += len;
+        size -= len;
+    }
+    return 0;
+}
+
+int HDL_Flash_program_nocheck(uint32_t address, const uint8_t *data, uint32_t size)
+{
+    if (address % HDL_FLASH_PROGRAMM_BYTE_WIDTHT != 0 || size % HDL_FLASH_PROGRAMM_BYTE_WIDTHT != 0 ||
+        !HDL_Flash_host_range_ok(address, size)) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        _gFlash[address - HDL_FLASH_BASE_ADDR + i] &= data[i];
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file HDL_Host.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)编译时HDL层的附加接口，目标板上没有对应的实现。
+ * 主机上没有中断，串口接收等原本在中断中完成的工作注册为轮询函数，读取时间、延时和空闲时执行，
+ * 和硬件定时器回调在同一个地方，因此不会打断正在执行的代码。
+ *
+ * 外设和环境变量的对应关系：
+ * RTU_HOST_COM<n>   串口n的后端：stdio、pty、路径（FIFO、串口或者pty从设备）、"接收路径:发送路径"，
+ *                   没有设置时COM1为stdio，其他串口丢弃发送的数据、没有接收数据。
+ * RTU_HOST_FLASH    W25Q512的镜像文件，默认RTU_HOST_IMAGE_DIR下的w25q512.bin，不存在时创建并填充0xFF。
+ * RTU_HOST_RTC      RTC的初始时间，1970-1-1以来的秒数，没有设置时使用主机的当前时间。
+ * RTU_HOST_SD       SD卡模型的镜像文件，默认RTU_HOST_IMAGE_DIR下的sdcard.bin，不存在时创建。
+ * RTU_HOST_IMAGE_DIR是编译时的宏，CMake设置为构建目录，镜像不会写进源码树。
+ *
+ * SPI总线上的设备由HDL_Host_SPI_Attach接入，每传输一个字节调用一次设备的交换函数，
+ * 没有接入设备时读到0xFF。总线时间按HDL_SPI_SetClock设置的时钟累计，用于估算目标板上的吞吐量。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef HDL_HOST_H
+#define HDL_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "HDL_SPI.h"
+
+// 最多注册的轮询函数个数
+#define HDL_HOST_POLL_MAX         8
+// 轮询函数执行的最小间隔，us
+#define HDL_HOST_POLL_INTERVAL_US 100U
+// 没有设置环境变量时镜像文件所在的目录
+#ifndef RTU_HOST_IMAGE_DIR
+#define RTU_HOST_IMAGE_DIR        "."
+#endif
+
+typedef void (*HDL_Host_Poll_t)(void);
+
+bool HDL_Host_AddPoll(HDL_Host_Poll_t poll);
+
+// SPI设备的交换函数：输入主机发出的字节，返回设备同时发出的字节
+typedef uint8_t (*HDL_Host_SPI_Device_t)(uint8_t mosi);
+
+typedef struct {
+    uint32_t transfers; // HDL_SPI读写函数的调用次数
+    uint64_t bytes;     // 传输的字节数
+    uint64_t dmaBytes;  // 其中由DMA搬运的字节数
+    uint64_t busNs;     // 按SPI时钟折算的总线时间，ns
+} HDL_Host_SPI_Stat_t;
+
+void HDL_Host_SPI_Attach(SPI_ID_t spiID, HDL_Host_SPI_Device_t device);
+void HDL_Host_SPI_GetStat(SPI_ID_t spiID, HDL_Host_SPI_Stat_t *pStat);
+void HDL_Host_SPI_ResetStat(SPI_ID_t spiID);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !HDL_HOST_H
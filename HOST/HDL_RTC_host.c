@@ -0,0 +1,140 @@
+/**
+ * @file HDL_RTC_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上的HDL_RTC实现。初始时间来自环境变量RTU_HOST_RTC（1970-1-1以来的秒数），
+ * 没有设置时使用主机的当前时间，之后按CLOCK_MONOTONIC走时，不受主机改时间的影响。
+ * 和目标板一样，本地时间当作UTC时间，亚秒按RTC_SUBSEC_MAX计数。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <time.h>
+#include "HDL_RTC.h"
+
+struct hostRTC_t {
+    uint64_t baseUs;            // 设置时间时的1970-1-1以来的总微秒数
+    uint64_t baseMonoUs;        // 设置时间时的CLOCK_MONOTONIC，us
+    bool calibratedAtLeastOnce; // 校准过至少一次
+    bool inited;
+};
+
+static struct hostRTC_t hostRTC = {0};
+
+/**
+ * @brief 读取主机时钟，微秒。
+ * timespec只在这里使用，HDL_RTC_Init中不再有局部的timespec，避免-O3内联后的-Wdangling-pointer误报。
+ *
+ * @param clk CLOCK_REALTIME或CLOCK_MONOTONIC
+ * @return uint64_t
+ */
+static uint64_t HDL_RTC_HostClockUs(clockid_t clk)
+{
+    struct timespec now = {0};
+
+    clock_gettime(clk, &now);
+    return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000U;
+}
+
+static uint64_t HDL_RTC_HostMonoUs()
+{
+    return HDL_RTC_HostClockUs(CLOCK_MONOTONIC);
+}
+
+/**
+ * @brief 当前时间，1970-1-1以来的总微秒数。
+ *
+ * @return uint64_t
+ */
+static uint64_t HDL_RTC_HostNowUs()
+{
+    // 目标板上RTC在后备域中一直走时，没有调用HDL_RTC_Init也能读到时间
+    if (!hostRTC.inited) {
+        HDL_RTC_Init();
+    }
+    return hostRTC.baseUs + HDL_RTC_HostMonoUs() - hostRTC.baseMonoUs;
+}
+
+void HDL_RTC_Init()
+{
+    const char *env = getenv("RTU_HOST_RTC");
+
+    hostRTC.calibratedAtLeastOnce = false;
+    // 和目标板的后备域一样，重复初始化不改变时间
+    if (hostRTC.inited) {
+        return;
+    }
+    if (env != NULL && env[0] != '\0') {
+        hostRTC.baseUs = strtoull(env, NULL, 0) * 1000000ULL;
+    } else {
+        hostRTC.baseUs = HDL_RTC_HostClockUs(CLOCK_REALTIME);
+    }
+    hostRTC.baseMonoUs = HDL_RTC_HostMonoUs();
+    hostRTC.inited     = true;
+}
+
+/**
+ * @brief 获取本地1970-1-1以来总秒数
+ *
+ * @param pSub 用于获取亚秒数。不需要可以为NULL。
+ * @return uint64_t 秒数
+ */
+uint64_t HDL_RTC_GetTimeTick(uint16_t *pSub)
+{
+    uint64_t nowUs = HDL_RTC_HostNowUs();
+
+    if (pSub != NULL) {
+        *pSub = (uint16_t)(nowUs % 1000000U * RTC_SUBSEC_MAX / 1000000U);
+    }
+    return nowUs / 1000000U;
+}
+
+void HDL_RTC_GetStructTime(mtime_t *mTime)
+{
+    uint16_t sub = 0;
+    uint64_t sec = HDL_RTC_GetTimeTick(&sub);
+
+    mtime_unix_sec_2_time((unsigned int)sec, mTime);
+    mTime->wSub = sub;
+}
+
+/**
+ * @brief 使用时间戳设置时间，设置时间的时间精度为秒。
+ *
+ * @param timestamp 1970-1-1以来总秒数。
+ */
+void HDL_RTC_SetTimeTick(uint64_t timestamp)
+{
+    hostRTC.baseUs     = timestamp * 1000000ULL;
+    hostRTC.baseMonoUs = HDL_RTC_HostMonoUs();
+    hostRTC.inited     = true;
+    HDL_RTC_SetSynced();
+}
+
+void HDL_RTC_SetStructTime(mtime_t *mTime)
+{
+    HDL_RTC_SetTimeTick(mtime_2_unix_sec(mTime));
+}
+
+uint64_t HDL_RTC_GetMsTimestamp()
+{
+    uint16_t sub = 0;
+    uint64_t sec = HDL_RTC_GetTimeTick(&sub);
+
+    // 和目标板一样由亚秒换算，保持相同的精度
+    return sec * 1000 + HDL_RTC_Subsec2mSec(sub);
+}
+
+bool HDL_RTC_HasSynced()
+{
+    return hostRTC.calibratedAtLeastOnce;
+}
+
+void HDL_RTC_SetSynced()
+{
+    hostRTC.calibratedAtLeastOnce = true;
+}
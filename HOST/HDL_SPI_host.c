@@ -0,0 +1,195 @@
+/**
+ * @file HDL_SPI_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上的HDL_SPI实现。总线上的设备由HDL_Host_SPI_Attach接入，每个字节调用一次设备的交换函数，
+ * 没有接入设备时读到0xFF。传输立即完成，不会超时。
+ * 时钟分频的计算和目标板相同（PCLK1为170MHz），记录调用次数、字节数和按时钟折算的总线时间，
+ * 用来比较逐字节读写和块传输的开销。
+ * 片选等GPIO的端口寄存器也放在这里，目前只有SD卡的片选、检测和电源控制脚用到。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "HDL_SPI.h"
+#include "HDL_Host.h"
+#include "main.h"
+
+// 和目标板相同的APB1时钟
+#define HOST_SPI_PCLK_HZ 170000000U
+
+// 复位后输出寄存器为0，片选为低；SD卡检测脚为低，表示卡已插入
+GPIO_TypeDef _gHostGPIOA = {0};
+GPIO_TypeDef _gHostGPIOB = {0};
+
+typedef struct {
+    HDL_Host_SPI_Device_t device;
+    uint32_t clockHz;
+    HDL_Host_SPI_Stat_t stat;
+} HostSPI_Dev_t;
+
+static HostSPI_Dev_t _gHostSPIList[SPI_NUM];
+
+/**
+ * @brief 交换一个字节，没有设备时MISO上拉为高。
+ *
+ */
+static byte_t HDL_SPI_HostExchange(HostSPI_Dev_t *pDev, byte_t mosi)
+{
+    return pDev->device != NULL ? pDev->device(mosi) : 0xFF;
+}
+
+/**
+ * @brief 记录一次传输。
+ *
+ */
+static void HDL_SPI_HostAccount(HostSPI_Dev_t *pDev, uint32_t size, bool dma)
+{
+    pDev->stat.transfers++;
+    pDev->stat.bytes += size;
+    if (dma) {
+        pDev->stat.dmaBytes += size;
+    }
+    // 没有初始化时按复位后的4分频计算
+    uint32_t hz = pDev->clockHz != 0 ? pDev->clockHz : HOST_SPI_PCLK_HZ / 4;
+    pDev->stat.busNs += (uint64_t)size * 8U * 1000000000ULL / hz;
+}
+
+void HDL_SPI_Init(SPI_ID_t spiID, byte_t dataSize, uint32_t CPOL, uint32_t CPHA)
+{
+    (void)dataSize;
+    (void)CPOL;
+    (void)CPHA;
+
+    if (spiID >= SPI_NUM) {
+        return;
+    }
+    // 和目标板的初始化相同，4分频
+    _gHostSPIList[spiID].clockHz = HOST_SPI_PCLK_HZ / 4;
+}
+
+uint32_t HDL_SPI_SetClock(SPI_ID_t spiID, uint32_t maxHz)
+{
+    uint32_t hz = HOST_SPI_PCLK_HZ / 2;
+
+    for (uint32_t div = 2; hz > maxHz && div < 256; div *= 2) {
+        hz /= 2;
+    }
+    if (spiID < SPI_NUM) {
+        _gHostSPIList[spiID].clockHz = hz;
+    }
+    return hz;
+}
+
+bool HDL_SPI_WriteRead(SPI_ID_t spiID, byte_t *pTxData, byte_t *pRxData, uint16_t size, uint32_t timeout)
+{
+    (void)timeout;
+
+    if (spiID >= SPI_NUM || pTxData == NULL || pRxData == NULL || size == 0) {
+        return false;
+    }
+    HostSPI_Dev_t *pDev = &_gHostSPIList[spiID];
+    HDL_SPI_HostAccount(pDev, size, false);
+    for (uint16_t i = 0; i < size; i++) {
+        pRxData[i] = HDL_SPI_HostExchange(pDev, pTxData[i]);
+    }
+    return true;
+}
+
+uint32_t HDL_SPI_Write(SPI_ID_t spiID, byte_t *pTxData, uint32_t size, uint32_t timeout)
+{
+    (void)timeout;
+
+    if (spiID >= SPI_NUM || pTxData == NULL || size == 0) {
+        return false;
+    }
+    HostSPI_Dev_t *pDev = &_gHostSPIList[spiID];
+    HDL_SPI_HostAccount(pDev, size, false);
+    for (uint32_t i = 0; i < size; i++) {
+        HDL_SPI_HostExchange(pDev, pTxData[i]);
+    }
+    return true;
+}
+
+uint32_t HDL_SPI_Read(SPI_ID_t spiID, byte_t *pRxData, uint16_t size, uint32_t timeout)
+{
+    (void)timeout;
+
+    if (spiID >= SPI_NUM || pRxData == NULL || size == 0) {
+        return false;
+    }
+    HostSPI_Dev_t *pDev = &_gHostSPIList[spiID];
+    HDL_SPI_HostAccount(pDev, size, false);
+    for (uint16_t i = 0; i < size; i++) {
+        pRxData[i] = HDL_SPI_HostExchange(pDev, 0xFF);
+    }
+    return true;
+}
+
+bool HDL_SPI_WriteBlock(SPI_ID_t spiID, const byte_t *pTxData, uint16_t size, uint32_t timeout)
+{
+    (void)timeout;
+
+    if (spiID >= SPI_NUM || pTxData == NULL || size == 0) {
+        return false;
+    }
+    HostSPI_Dev_t *pDev = &_gHostSPIList[spiID];
+    HDL_SPI_HostAccount(pDev, size, size >= HDL_SPI_DMA_MIN_SIZE);
+    for (uint16_t i = 0; i < size; i++) {
+        HDL_SPI_HostExchange(pDev, pTxData[i]);
+    }
+    return true;
+}
+
+bool HDL_SPI_ReadBlock(SPI_ID_t spiID, byte_t *pRxData, uint16_t size, byte_t fill, uint32_t timeout)
+{
+    (void)timeout;
+
+    if (spiID >= SPI_NUM || pRxData == NULL || size == 0) {
+        return false;
+    }
+    HostSPI_Dev_t *pDev = &_gHostSPIList[spiID];
+    HDL_SPI_HostAccount(pDev, size, size >= HDL_SPI_DMA_MIN_SIZE);
+    for (uint16_t i = 0; i < size; i++) {
+        pRxData[i] = HDL_SPI_HostExchange(pDev, fill);
+    }
+    return true;
+}
+
+void HDL_SPI_DeInit(SPI_ID_t spiID)
+{
+    (void)spiID;
+}
+
+/**
+ * @brief 把设备接到SPI总线上，device为NULL时断开。
+ *
+ * @param spiID SPI设备ID。
+ * @param device 设备的交换函数。
+ */
+void HDL_Host_SPI_Attach(SPI_ID_t spiID, HDL_Host_SPI_Device_t device)
+{
+    if (spiID >= SPI_NUM) {
+        return;
+    }
+    _gHostSPIList[spiID].device = device;
+}
+
+void HDL_Host_SPI_GetStat(SPI_ID_t spiID, HDL_Host_SPI_Stat_t *pStat)
+{
+    if (spiID >= SPI_NUM || pStat == NULL) {
+        return;
+    }
+    *pStat = _gHostSPIList[spiID].stat;
+}
+
+void HDL_Host_SPI_ResetStat(SPI_ID_t spiID)
+{
+    if (spiID >= SPI_NUM) {
+        return;
+    }
+    HDL_Host_SPI_Stat_t empty = {0};
+    _gHostSPIList[spiID].stat = empty;
+}
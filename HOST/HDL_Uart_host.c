@@ -0,0 +1,290 @@
+/**
+ * @file HDL_Uart_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上的HDL_Uart实现，每个串口接到一个文件描述符上，后端由环境变量RTU_HOST_COM<n>选择：
+ * stdio                 标准输入输出。
+ * pty                   新建一个伪终端，从设备的路径打印到stderr，用minicom、pyserial或者另一个进程打开。
+ * <路径>                打开FIFO、串口或者pty从设备，收发都用这个文件。
+ * <接收路径>:<发送路径>   收发分别使用两个文件，一般是两个FIFO。
+ * 没有设置时COM1为stdio，其他串口丢弃发送的数据、没有接收数据。
+ * 接收由HDL_Host_AddPoll注册的轮询函数读入接收队列，或者交给注册的接收字符回调，和目标板的接收中断相同。
+ * 发送直接写入文件描述符，写完即调用发送完成回调；对端不读取导致写不进去时丢弃剩下的数据。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#define _XOPEN_SOURCE 600
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "HDL_Uart.h"
+#include "HDL_Host.h"
+#include "cqueue.h"
+
+#define HOST_UART_RX_BUF_SIZE 1024U
+
+typedef struct tagHostCOM_Dev_t {
+    int rxFd;
+    int txFd;
+    UartWriteOverCallback_t write_over_callback;
+    void *write_over_callback_args;
+    UartReceiveCharCallback_t receive_char_callback;
+    CQueue_t rxQueue;
+    uint8_t rxBuf[HOST_UART_RX_BUF_SIZE];
+    uint32_t txDropped; // 对端不读取丢弃的字节数
+    bool inited;
+} HostCOM_Dev_t;
+
+// 下标就是串口号
+static HostCOM_Dev_t _gHostCOMList[COM_NUM + 1];
+
+static void Uart_HostSetRaw(int fd)
+{
+    struct termios tio;
+
+    if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+}
+
+static int Uart_HostOpenPath(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if (fd < 0) {
+        fprintf(stderr, "[HOST] open %s failed: %s\n", path, strerror(errno));
+        return -1;
+    }
+    Uart_HostSetRaw(fd);
+    return fd;
+}
+
+/**
+ * @brief 按RTU_HOST_COM<n>打开串口的后端。
+ *
+ * @param comId
+ * @param pDev
+ */
+static void Uart_HostOpen(COMID_t comId, HostCOM_Dev_t *pDev)
+{
+    char name[32];
+    char path[256];
+    const char *backend = NULL;
+    char *split         = NULL;
+    int fd              = -1;
+
+    pDev->rxFd = -1;
+    pDev->txFd = -1;
+    snprintf(name, sizeof(name), "RTU_HOST_COM%d", (int)comId);
+    backend = getenv(name);
+    if (backend == NULL) {
+        backend = comId == COM1 ? "stdio" : "";
+    }
+
+    if (strcmp(backend, "stdio") == 0) {
+        pDev->rxFd = STDIN_FILENO;
+        pDev->txFd = STDOUT_FILENO;
+    } else if (strcmp(backend, "pty") == 0) {
+        fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+            fprintf(stderr, "[HOST] COM%d: create pty failed: %s\n", (int)comId, strerror(errno));
+            return;
+        }
+        Uart_HostSetRaw(fd);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fprintf(stderr, "[HOST] COM%d <-> %s\n", (int)comId, ptsname(fd));
+        pDev->rxFd = fd;
+        pDev->txFd = fd;
+    } else if (backend[0] != '\0') {
+        snprintf(path, sizeof(path), "%s", backend);
+        split = strchr(path, ':');
+        if (split != NULL) {
+            *split     = '\0';
+            pDev->rxFd = Uart_HostOpenPath(path);
+            pDev->txFd = Uart_HostOpenPath(split + 1);
+        } else {
+            pDev->rxFd = Uart_HostOpenPath(path);
+            pDev->txFd = pDev->rxFd;
+        }
+    }
+}
+
+/**
+ * @brief 把文件描述符中已经到达的数据读入接收队列，代替接收中断。
+ *
+ */
+static void Uart_HostPoll()
+{
+    uint8_t buf[256];
+    struct pollfd pfd;
+    uint32_t space = 0;
+    size_t size    = 0;
+    ssize_t n      = 0;
+
+    for (int comId = COM1; comId <= COM_NUM; comId++) {
+        HostCOM_Dev_t *pDev = &_gHostCOMList[comId];
+        if (!pDev->inited || pDev->rxFd < 0) {
+            continue;
+        }
+        pfd.fd     = pDev->rxFd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 0) <= 0 || (pfd.revents & POLLIN) == 0) {
+            continue;
+        }
+        size = sizeof(buf);
+        if (pDev->receive_char_callback == NULL) {
+            // 接收队列放不下的数据留在内核缓冲区中，下次再读
+            // 环形队列最多存放容量-1个元素
+            space = HOST_UART_RX_BUF_SIZE - 1U - cqueue_size(&pDev->rxQueue);
+            if (space == 0) {
+                continue;
+            }
+            size = space < size ? space : size;
+        }
+        n = read(pDev->rxFd, buf, size);
+        for (ssize_t i = 0; i < n; i++) {
+            if (pDev->receive_char_callback != NULL) {
+                pDev->receive_char_callback(buf[i]);
+            } else {
+                cqueue_enqueue(&pDev->rxQueue, &buf[i]);
+            }
+        }
+    }
+}
+
+void Uart_Init(COMID_t comId, uint32_t baud, uint32_t wordLen, uint32_t stopBit, uint32_t parity)
+{
+    (void)baud;
+    (void)wordLen;
+    (void)stopBit;
+    (void)parity;
+
+    if (comId < COM1 || comId > COM_NUM) {
+        return;
+    }
+    HostCOM_Dev_t *pDev = &_gHostCOMList[comId];
+    if (pDev->inited) {
+        return;
+    }
+    cqueue_create(&pDev->rxQueue, pDev->rxBuf, HOST_UART_RX_BUF_SIZE, sizeof(uint8_t));
+    Uart_HostOpen(comId, pDev);
+    HDL_Host_AddPoll(Uart_HostPoll);
+    pDev->inited = true;
+}
+
+/**
+ * @brief 串口写操作。
+ *
+ * @param comId 串口号
+ * @param writeBuf 存放待写数据缓存区的指针
+ * @param uLen 需要写多少个字节
+ * @return uint32_t >0-写出去实际字节数，0-未初始化，写失败
+ */
+uint32_t Uart_Write(COMID_t comId, const uint8_t *writeBuf, uint32_t uLen)
+{
+    uint32_t written = 0;
+    ssize_t n        = 0;
+
+    if (comId < COM1 || comId > COM_NUM || writeBuf == NULL || uLen == 0) {
+        return 0;
+    }
+    HostCOM_Dev_t *pDev = &_gHostCOMList[comId];
+    if (pDev->inited == false) {
+        return 0;
+    }
+
+    while (pDev->txFd >= 0 && written < uLen) {
+        n = write(pDev->txFd, writeBuf + written, uLen - written);
+        if (n > 0) {
+            written += (uint32_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    // 和目标板一样，数据都交给了串口，写不出去的部分丢弃
+    pDev->txDropped += uLen - written;
+    if (pDev->write_over_callback != NULL) {
+        pDev->write_over_callback(pDev->write_over_callback_args);
+    }
+    return uLen;
+}
+
+uint32_t Uart_Read(COMID_t comId, uint8_t *pBuf, uint32_t uiLen)
+{
+    if (comId < COM1 || comId > COM_NUM || !_gHostCOMList[comId].inited) {
+        return 0;
+    }
+    Uart_HostPoll();
+    return cqueue_out(&_gHostCOMList[comId].rxQueue, pBuf, uiLen);
+}
+
+uint32_t Uart_AvailableBytes(COMID_t comId)
+{
+    if (comId < COM1 || comId > COM_NUM || !_gHostCOMList[comId].inited) {
+        return 0;
+    }
+    Uart_HostPoll();
+    return cqueue_size(&_gHostCOMList[comId].rxQueue);
+}
+
+bool Uart_HasPendingWork()
+{
+    Uart_HostPoll();
+    for (int comId = COM1; comId <= COM_NUM; comId++) {
+        if (_gHostCOMList[comId].inited && !cqueue_is_empty(&_gHostCOMList[comId].rxQueue)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t Uart_EmptyReadBuffer(COMID_t comId)
+{
+    uint32_t uRtn = 0;
+
+    if (comId < COM1 || comId > COM_NUM || !_gHostCOMList[comId].inited) {
+        return 0;
+    }
+    uRtn = cqueue_size(&_gHostCOMList[comId].rxQueue);
+    cqueue_make_empty(&_gHostCOMList[comId].rxQueue);
+    return uRtn;
+}
+
+uint8_t Uart_SetWriteOverCallback(COMID_t comId, UartWriteOverCallback_t callback, void *args)
+{
+    if (comId < COM1 || comId > COM_NUM) {
+        return 0;
+    }
+    _gHostCOMList[comId].write_over_callback      = callback;
+    _gHostCOMList[comId].write_over_callback_args = args;
+    return 1;
+}
+
+uint8_t Uart_RegisterReceiveCharCallback(COMID_t comId, UartReceiveCharCallback_t callback)
+{
+    if (comId < COM1 || comId > COM_NUM) {
+        return 0;
+    }
+    _gHostCOMList[comId].receive_char_callback = callback;
+    return 1;
+}
+
+uint8_t Uart_UnregisterReceiveCharCallback(COMID_t comId)
+{
+    if (comId < COM1 || comId > COM_NUM) {
+        return 0;
+    }
+    _gHostCOMList[comId].receive_char_callback = NULL;
+    return 1;
+}
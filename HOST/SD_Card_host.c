@@ -0,0 +1,447 @@
+/**
+ * @file SD_Card_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上SPI模式SD卡的命令模型。卡的内容是映射到内存的镜像文件，由环境变量RTU_HOST_SD指定，
+ * 默认RTU_HOST_IMAGE_DIR下的sdcard.bin。每个SPI字节先从输出队列取出卡发送的字节，再按当前状态处理主机发送的字节：
+ * 空闲和连续读时解析命令帧，写入时等待数据令牌、接收数据块。
+ * 连续读时输出队列空了就准备下一块，主机开始发送命令帧后不再准备，CMD12之前读出的块数因此是准确的。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SD_Card_host.h"
+#include "HDL_Host.h"
+#include "./sdcard/bsp_spi_sdcard.h"
+
+#define SD_HOST_BLOCKS     (SD_HOST_CAPACITY / SD_BLOCK_SIZE)
+#define SD_HOST_OUT_SIZE   600U
+// 命令帧的第一个字节为01xxxxxx
+#define SD_HOST_IS_CMD(b)  (((b) & 0xC0) == 0x40)
+
+typedef enum {
+    SD_HOST_IDLE = 0,    // 等待命令
+    SD_HOST_READING,     // CMD18连续读
+    SD_HOST_WRITE_TOKEN, // CMD24/25之后等待数据令牌
+    SD_HOST_WRITE_DATA,  // 接收数据块和CRC
+} SD_Host_State_t;
+
+typedef struct {
+    uint8_t *image;
+    SD_Host_State_t state;
+    bool ready;           // ACMD41完成初始化
+    bool appCmd;          // 上一条命令是CMD55
+    bool multiWrite;      // CMD25
+    uint32_t initTries;   // ACMD41的次数
+    uint32_t block;       // 当前读写的块
+    uint32_t wellWritten; // 最近一次CMD25写入的块数，ACMD22返回
+    uint32_t failAfter;   // 再写入这么多块后下一块写入失败，UINT32_MAX表示不失败
+    uint8_t status;       // CMD13的R2第二个字节，读出后清除
+    uint8_t cmd[6];
+    uint32_t cmdLen;
+    uint8_t out[SD_HOST_OUT_SIZE];
+    uint32_t outHead;
+    uint32_t outLen;
+    uint8_t data[SD_BLOCK_SIZE + 2];
+    uint32_t dataLen;
+    SD_Host_Stat_t stat;
+} SD_Host_Card_t;
+
+static SD_Host_Card_t _gCard = {.failAfter = UINT32_MAX};
+
+/**
+ * @brief 打开并映射镜像文件，新建的文件内容为0，和擦除过的SD卡相同。
+ *
+ * @return int32_t 成功返回0，失败返回-1。
+ */
+static int32_t SD_Host_Open()
+{
+    const char *path = getenv("RTU_HOST_SD");
+    struct stat st;
+    int fd = -1;
+
+    if (_gCard.image != NULL) {
+        return 0;
+    }
+    if (path == NULL || path[0] == '\0') {
+        path = RTU_HOST_IMAGE_DIR "/sdcard.bin";
+    }
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "[HOST] open %s failed: %s\n", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    if ((uint64_t)st.st_size != SD_HOST_CAPACITY && ftruncate(fd, SD_HOST_CAPACITY) != 0) {
+        fprintf(stderr, "[HOST] resize %s failed: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    _gCard.image = mmap(NULL, SD_HOST_CAPACITY, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (_gCard.image == MAP_FAILED) {
+        fprintf(stderr, "[HOST] mmap %s failed: %s\n", path, strerror(errno));
+        _gCard.image = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static uint16_t SD_Host_CRC16(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0;
+
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void SD_Host_Push(uint8_t byte)
+{
+    if (_gCard.outHead + _gCard.outLen >= SD_HOST_OUT_SIZE) {
+        memmove(_gCard.out, &_gCard.out[_gCard.outHead], _gCard.outLen);
+        _gCard.outHead = 0;
+    }
+    _gCard.out[_gCard.outHead + _gCard.outLen++] = byte;
+}
+
+/**
+ * @brief 数据包：1字节等待、起始令牌、数据、CRC16。
+ *
+ */
+static void SD_Host_PushData(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = SD_Host_CRC16(data, len);
+
+    SD_Host_Push(SD_DUMMY_BYTE);
+    SD_Host_Push(SD_START_DATA_SINGLE_BLOCK_READ);
+    for (uint32_t i = 0; i < len; i++) {
+        SD_Host_Push(data[i]);
+    }
+    SD_Host_Push((uint8_t)(crc >> 8));
+    SD_Host_Push((uint8_t)crc);
+}
+
+/**
+ * @brief 发送一块数据，超出容量时发送数据错误令牌（out of range）并结束连续读。
+ *
+ */
+static void SD_Host_PushBlock()
+{
+    if (_gCard.block >= SD_HOST_BLOCKS) {
+        SD_Host_Push(SD_DUMMY_BYTE);
+        SD_Host_Push(0x08);
+        _gCard.state = SD_HOST_IDLE;
+        return;
+    }
+    SD_Host_PushData(&_gCard.image[(uint64_t)_gCard.block * SD_BLOCK_SIZE], SD_BLOCK_SIZE);
+    _gCard.block++;
+    _gCard.stat.blocksRead++;
+}
+
+static void SD_Host_PushBusy()
+{
+    for (int i = 0; i < SD_HOST_BUSY_BYTES; i++) {
+        SD_Host_Push(0x00);
+    }
+}
+
+static void SD_Host_PushCSD()
+{
+    // CSD 2.0，TRAN_SPEED为25MHz，块大小512
+    const uint32_t cSize = SD_HOST_CAPACITY / (512UL * 1024) - 1;
+    uint8_t csd[16]      = {0x40, 0x0E, 0x00, 0x32, 0x5B, 0x59, 0x00, 0, 0, 0, 0x7F, 0x80, 0x0A, 0x40, 0x00, 0x01};
+
+    csd[7] = (uint8_t)((cSize >> 16) & 0x3F);
+    csd[8] = (uint8_t)(cSize >> 8);
+    csd[9] = (uint8_t)cSize;
+    SD_Host_PushData(csd, sizeof(csd));
+}
+
+static void SD_Host_PushCID()
+{
+    const uint8_t cid[16] = {0x03, 'S', 'D', 'H', 'O', 'S', 'T', '1', 0x10, 0x12, 0x34, 0x56, 0x78, 0x01, 0x7A, 0x01};
+
+    SD_Host_PushData(cid, sizeof(cid));
+}
+
+/**
+ * @brief 执行收到的命令帧，响应放入输出队列。
+ *
+ */
+static void SD_Host_Execute()
+{
+    uint8_t cmd  = _gCard.cmd[0] & 0x3F;
+    uint32_t arg = ((uint32_t)_gCard.cmd[1] << 24) | ((uint32_t)_gCard.cmd[2] << 16) | ((uint32_t)_gCard.cmd[3] << 8) | _gCard.cmd[4];
+    bool app     = _gCard.appCmd;
+    uint8_t r1   = _gCard.ready ? SD_RESPONSE_NO_ERROR : SD_IN_IDLE_STATE;
+
+    // 新命令放弃没有读完的响应，响应之前有1字节NCR
+    _gCard.appCmd  = false;
+    _gCard.outHead = 0;
+    _gCard.outLen  = 0;
+    SD_Host_Push(SD_DUMMY_BYTE);
+
+    if (app) {
+        _gCard.stat.acmdCount[cmd]++;
+        switch (cmd) {
+            case SD_ACMD_SD_SEND_OP_COND:
+                if (++_gCard.initTries >= SD_HOST_INIT_TRIES) {
+                    _gCard.ready = true;
+                }
+                SD_Host_Push(_gCard.ready ? SD_RESPONSE_NO_ERROR : SD_IN_IDLE_STATE);
+                break;
+            case SD_ACMD_SET_WR_BLK_ERASE_COUNT:
+                _gCard.stat.preEraseBlocks = arg & 0x7FFFFF;
+                SD_Host_Push(r1);
+                break;
+            case SD_ACMD_SEND_NUM_WR_BLOCKS: {
+                const uint8_t num[4] = {(uint8_t)(_gCard.wellWritten >> 24), (uint8_t)(_gCard.wellWritten >> 16),
+                                        (uint8_t)(_gCard.wellWritten >> 8), (uint8_t)_gCard.wellWritten};
+                SD_Host_Push(r1);
+                SD_Host_PushData(num, sizeof(num));
+                break;
+            }
+            default:
+                SD_Host_Push(r1 | SD_ILLEGAL_COMMAND);
+                break;
+        }
+        return;
+    }
+
+    _gCard.stat.cmdCount[cmd]++;
+    if (!_gCard.ready && cmd != SD_CMD_GO_IDLE_STATE && cmd != SD_CMD_SEND_IF_COND && cmd != SD_CMD_APP_CMD &&
+        cmd != SD_CMD_READ_OCR) {
+        SD_Host_Push(r1 | SD_ILLEGAL_COMMAND);
+        return;
+    }
+    switch (cmd) {
+        case SD_CMD_GO_IDLE_STATE:
+            _gCard.ready     = false;
+            _gCard.initTries = 0;
+            _gCard.state     = SD_HOST_IDLE;
+            SD_Host_Push(SD_IN_IDLE_STATE);
+            break;
+        case SD_CMD_SEND_IF_COND:
+            // R7：电压范围和检查模式原样返回
+            SD_Host_Push(r1);
+            SD_Host_Push(0x00);
+            SD_Host_Push(0x00);
+            SD_Host_Push((uint8_t)((arg >> 8) & 0x0F));
+            SD_Host_Push((uint8_t)arg);
+            break;
+        case SD_CMD_APP_CMD:
+            _gCard.appCmd = true;
+            SD_Host_Push(r1);
+            break;
+        case SD_CMD_READ_OCR:
+            // 初始化完成后上电完成和CCS（SDHC）置位
+            SD_Host_Push(r1);
+            SD_Host_Push(_gCard.ready ? 0xC0 : 0x00);
+            SD_Host_Push(0xFF);
+            SD_Host_Push(0x80);
+            SD_Host_Push(0x00);
+            break;
+        case SD_CMD_SEND_CSD:
+            SD_Host_Push(r1);
+            SD_Host_PushCSD();
+            break;
+        case SD_CMD_SEND_CID:
+            SD_Host_Push(r1);
+            SD_Host_PushCID();
+            break;
+        case SD_CMD_STOP_TRANSMISSION:
+            // NCR的位置是填充字节，之后R1，然后短暂忙
+            _gCard.state = SD_HOST_IDLE;
+            SD_Host_Push(r1);
+            SD_Host_Push(0x00);
+            SD_Host_Push(0x00);
+            break;
+        case SD_CMD_SEND_STATUS:
+            SD_Host_Push(r1);
+            SD_Host_Push(_gCard.status);
+            _gCard.status = 0;
+            break;
+        case SD_CMD_SET_BLOCKLEN:
+            SD_Host_Push(r1);
+            break;
+        case SD_CMD_READ_SINGLE_BLOCK:
+        case SD_CMD_READ_MULT_BLOCK:
+        case SD_CMD_WRITE_SINGLE_BLOCK:
+        case SD_CMD_WRITE_MULT_BLOCK:
+            if (arg >= SD_HOST_BLOCKS) {
+                SD_Host_Push(r1 | SD_ADDRESS_ERROR);
+                break;
+            }
+            SD_Host_Push(r1);
+            _gCard.block = arg;
+            if (cmd == SD_CMD_READ_SINGLE_BLOCK) {
+                SD_Host_PushBlock();
+            } else if (cmd == SD_CMD_READ_MULT_BLOCK) {
+                _gCard.state = SD_HOST_READING;
+            } else {
+                _gCard.state      = SD_HOST_WRITE_TOKEN;
+                _gCard.multiWrite = cmd == SD_CMD_WRITE_MULT_BLOCK;
+                if (_gCard.multiWrite) {
+                    _gCard.wellWritten = 0;
+                }
+            }
+            break;
+        default:
+            SD_Host_Push(r1 | SD_ILLEGAL_COMMAND);
+            break;
+    }
+}
+
+static void SD_Host_CommandByte(uint8_t mosi)
+{
+    if (_gCard.cmdLen == 0 && !SD_HOST_IS_CMD(mosi)) {
+        return;
+    }
+    _gCard.cmd[_gCard.cmdLen++] = mosi;
+    if (_gCard.cmdLen == sizeof(_gCard.cmd)) {
+        _gCard.cmdLen = 0;
+        SD_Host_Execute();
+    }
+}
+
+static void SD_Host_WriteToken(uint8_t mosi)
+{
+    if (mosi == SD_DUMMY_BYTE) {
+        return;
+    }
+    // 忙的时候不能发送令牌
+    if (_gCard.outLen > 0) {
+        _gCard.stat.protocolErrors++;
+        return;
+    }
+    if ((_gCard.multiWrite && mosi == SD_START_DATA_MULTIPLE_BLOCK_WRITE) ||
+        (!_gCard.multiWrite && mosi == SD_START_DATA_SINGLE_BLOCK_WRITE)) {
+        _gCard.state   = SD_HOST_WRITE_DATA;
+        _gCard.dataLen = 0;
+    } else if (_gCard.multiWrite && mosi == SD_STOP_DATA_MULTIPLE_BLOCK_WRITE) {
+        // 停止令牌之后1字节开始忙
+        SD_Host_Push(SD_DUMMY_BYTE);
+        SD_Host_PushBusy();
+        _gCard.state = SD_HOST_IDLE;
+    } else {
+        _gCard.stat.protocolErrors++;
+    }
+}
+
+static void SD_Host_WriteData(uint8_t mosi)
+{
+    _gCard.data[_gCard.dataLen++] = mosi;
+    if (_gCard.dataLen < sizeof(_gCard.data)) {
+        return;
+    }
+    // 数据响应的高3位不确定，驱动应该只看低5位
+    if (_gCard.block < SD_HOST_BLOCKS && _gCard.failAfter != 0) {
+        memcpy(&_gCard.image[(uint64_t)_gCard.block * SD_BLOCK_SIZE], _gCard.data, SD_BLOCK_SIZE);
+        _gCard.block++;
+        _gCard.wellWritten++;
+        _gCard.stat.blocksWritten++;
+        if (_gCard.failAfter != UINT32_MAX) {
+            _gCard.failAfter--;
+        }
+        SD_Host_Push(0xE0 | SD_DATA_OK);
+    } else {
+        // R2的Error位
+        _gCard.failAfter = UINT32_MAX;
+        _gCard.status |= 0x04;
+        SD_Host_Push(0xE0 | SD_DATA_WRITE_ERROR);
+    }
+    SD_Host_PushBusy();
+    _gCard.state = _gCard.multiWrite ? SD_HOST_WRITE_TOKEN : SD_HOST_IDLE;
+}
+
+/**
+ * @brief SPI总线上的交换函数。
+ *
+ * @param mosi 主机发送的字节。
+ * @return uint8_t 卡发送的字节，没有选中时为0xFF。
+ */
+static uint8_t SD_Host_Exchange(uint8_t mosi)
+{
+    uint8_t miso = SD_DUMMY_BYTE;
+
+    if (LL_GPIO_IsOutputPinSet(SD_CS_GPIO_PORT, SD_CS_PIN)) {
+        _gCard.cmdLen = 0;
+        return SD_DUMMY_BYTE;
+    }
+    if (_gCard.state == SD_HOST_READING && _gCard.outLen == 0 && _gCard.cmdLen == 0 && !SD_HOST_IS_CMD(mosi)) {
+        SD_Host_PushBlock();
+    }
+    if (_gCard.outLen > 0) {
+        miso = _gCard.out[_gCard.outHead++];
+        _gCard.outLen--;
+    }
+
+    switch (_gCard.state) {
+        case SD_HOST_WRITE_TOKEN:
+            SD_Host_WriteToken(mosi);
+            break;
+        case SD_HOST_WRITE_DATA:
+            SD_Host_WriteData(mosi);
+            break;
+        default:
+            SD_Host_CommandByte(mosi);
+            break;
+    }
+    return miso;
+}
+
+/**
+ * @brief 打开镜像文件，把卡接到SD卡驱动的SPI总线上，卡检测脚为低（已插入）。
+ *
+ * @return true 成功。
+ * @return false 镜像文件打不开。
+ */
+bool SD_Host_Attach(void)
+{
+    if (SD_Host_Open() != 0) {
+        return false;
+    }
+    SD_DETECT_GPIO_Port->IDR &= ~SD_DETECT_Pin;
+    HDL_Host_SPI_Attach(SPI_1, SD_Host_Exchange);
+    return true;
+}
+
+void SD_Host_GetStat(SD_Host_Stat_t *pStat)
+{
+    if (pStat != NULL) {
+        *pStat = _gCard.stat;
+    }
+}
+
+/**
+ * @brief 再写入n块后，下一块写入失败（数据响应为写错误），只失败一次。
+ *
+ * @param n
+ */
+void SD_Host_FailWrite(uint32_t n)
+{
+    _gCard.failAfter = n;
+}
+
+void SD_Host_ResetStat(void)
+{
+    SD_Host_Stat_t empty = {0};
+    _gCard.stat          = empty;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file SD_Card_host.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上SPI模式SD卡的命令模型，接在SD卡驱动使用的SPI总线上，由驱动的片选控制。
+ * 模拟一张64MB的SDHC卡：CMD0/8/55/ACMD41/58初始化，CMD9/10读寄存器，CMD17/18单块、连续读，
+ * CMD12停止连续读，CMD24/25单块、连续写（0xFC数据令牌、0xFD停止令牌），ACMD23预擦除。
+ * 响应之前有1字节的NCR，读数据令牌之前有1字节的等待，写入每块之后忙若干字节，
+ * 用来检查驱动的命令序列和等待是否正确。镜像文件见HDL_Host.h中的RTU_HOST_SD。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef SD_CARD_HOST_H
+#define SD_CARD_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+
+// 卡容量，字节
+#define SD_HOST_CAPACITY   (64UL * 1024 * 1024)
+// ACMD41发送多少次后初始化完成
+#define SD_HOST_INIT_TRIES 3
+// 每块写入后的忙字节数
+#define SD_HOST_BUSY_BYTES 8
+
+typedef struct {
+    uint32_t cmdCount[64];   // 每条命令收到的次数
+    uint32_t acmdCount[64];  // 每条ACMD收到的次数
+    uint32_t blocksRead;     // 发出的数据块数
+    uint32_t blocksWritten;  // 写入的数据块数
+    uint32_t preEraseBlocks; // 最近一次ACMD23的预擦除块数
+    uint32_t protocolErrors; // 不符合协议的字节序列，例如写数据时收到未知的令牌
+} SD_Host_Stat_t;
+
+bool SD_Host_Attach(void);
+void SD_Host_GetStat(SD_Host_Stat_t *pStat);
+void SD_Host_ResetStat(void);
+// 再写入n块后下一块写入失败，只失败一次
+void SD_Host_FailWrite(uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !SD_CARD_HOST_H
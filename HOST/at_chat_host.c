@@ -0,0 +1,345 @@
+/**
+ * @file at_chat_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上at_chat的实现，命令交给测试注册的应答函数，见at_chat_host.h。
+ * 只有一个AT对象，at_obj_create忽略适配器（不使用串口）。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "at_chat_host.h"
+
+#define AT_HOST_URC_MAX 16
+
+typedef enum {
+    AT_HOST_REQ_LINE = 0,  // 单行命令
+    AT_HOST_REQ_MULTILINE, // 多行命令，逐行发送
+    AT_HOST_REQ_DATA,      // 数据
+} at_host_req_type_t;
+
+typedef struct {
+    at_host_req_type_t type;
+    at_attr_t attr;
+    char *cmd;
+    const char **multiline; // 调用者的数组，和目标板一样要求在发送完之前有效
+    uint8_t *data;
+    unsigned int len;
+} at_host_req_t;
+
+struct at_obj {
+    at_callback_t curr_cb;
+    urc_item_t *urc_tbl;
+    int urc_count;
+};
+
+static struct at_obj at_host_obj;
+static at_host_responder_t at_host_responder;
+
+static at_host_req_t at_host_queue[AT_HOST_QUEUE_MAX];
+static int at_host_queue_len;
+
+// 应答函数挂起的命令
+static at_host_req_t at_host_curr;
+static bool at_host_curr_pending;
+static bool at_host_curr_done;
+static at_resp_code at_host_curr_code;
+
+static char at_host_recvbuf[AT_HOST_BUF_SIZE];
+
+static char *at_host_urcs[AT_HOST_URC_MAX];
+static int at_host_urc_len;
+static char at_host_urcbuf[AT_HOST_BUF_SIZE];
+
+at_obj_t *at_obj_create(const at_adapter_t *adap)
+{
+    (void)adap;
+    memset(&at_host_obj, 0, sizeof(at_host_obj));
+    return &at_host_obj;
+}
+
+void at_obj_set_curr_at_cb(at_obj_t *at, at_callback_t cb)
+{
+    at->curr_cb = cb;
+}
+
+void at_obj_set_urc(at_obj_t *at, urc_item_t *tbl, int count)
+{
+    at->urc_tbl   = tbl;
+    at->urc_count = count;
+}
+
+void *at_malloc(unsigned int nbytes)
+{
+    return malloc(nbytes);
+}
+
+void at_free(void *ptr)
+{
+    free(ptr);
+}
+
+static int at_host_push(const at_host_req_t *req)
+{
+    if (at_host_queue_len >= AT_HOST_QUEUE_MAX) {
+        free(req->cmd);
+        free(req->data);
+        return 0;
+    }
+    if (req->attr.priority == AT_PRIORITY_HIGH) {
+        memmove(&at_host_queue[1], &at_host_queue[0], sizeof(at_host_req_t) * at_host_queue_len);
+        at_host_queue[0] = *req;
+    } else {
+        at_host_queue[at_host_queue_len] = *req;
+    }
+    at_host_queue_len++;
+    return 1;
+}
+
+int at_send_singlline(at_obj_t *at, const at_attr_t *attr, const char *singlling)
+{
+    at_host_req_t req;
+
+    (void)at;
+    memset(&req, 0, sizeof(req));
+    req.type = AT_HOST_REQ_LINE;
+    req.attr = *attr;
+    req.cmd  = strdup(singlling);
+    return at_host_push(&req);
+}
+
+int at_send_multiline(at_obj_t *at, const at_attr_t *attr, const char **multiline)
+{
+    at_host_req_t req;
+
+    (void)at;
+    memset(&req, 0, sizeof(req));
+    req.type      = AT_HOST_REQ_MULTILINE;
+    req.attr      = *attr;
+    req.multiline = multiline;
+    return at_host_push(&req);
+}
+
+int at_exec_cmd(at_obj_t *at, const at_attr_t *attr, const char *cmd, ...)
+{
+    char line[AT_HOST_BUF_SIZE];
+    va_list args;
+
+    va_start(args, cmd);
+    vsnprintf(line, sizeof(line), cmd, args);
+    va_end(args);
+    return at_send_singlline(at, attr, line);
+}
+
+int at_send_data(at_obj_t *at, const at_attr_t *attr, const void *databuf, unsigned int bufsize)
+{
+    at_host_req_t req;
+
+    (void)at;
+    memset(&req, 0, sizeof(req));
+    req.type = AT_HOST_REQ_DATA;
+    req.attr = *attr;
+    req.data = (uint8_t *)malloc(bufsize ? bufsize : 1);
+    req.len  = bufsize;
+    memcpy(req.data, databuf, bufsize);
+    return at_host_push(&req);
+}
+
+void at_host_set_responder(at_host_responder_t responder)
+{
+    at_host_responder = responder;
+}
+
+static at_resp_code at_host_code(const at_host_req_t *req)
+{
+    const char *suffix = req->attr.suffix != NULL ? req->attr.suffix : "OK";
+
+    if (strstr(at_host_recvbuf, suffix) != NULL) {
+        return AT_RESP_OK;
+    }
+    if (strstr(at_host_recvbuf, "ERROR") != NULL) {
+        return AT_RESP_ERROR;
+    }
+    return AT_RESP_TIMEOUT;
+}
+
+/**
+ * @brief 把一行命令或者数据交给应答函数，响应放在at_host_recvbuf中。
+ *
+ * @return at_host_result_t
+ */
+static at_host_result_t at_host_ask(const at_host_req_t *req, const char *line)
+{
+    at_host_result_t res;
+
+    at_host_recvbuf[0] = '\0';
+    if (at_host_responder == NULL) {
+        strcpy(at_host_recvbuf, "OK");
+        return AT_HOST_REPLY;
+    }
+    if (req->type == AT_HOST_REQ_DATA) {
+        res = at_host_responder(NULL, req->data, req->len, at_host_recvbuf, sizeof(at_host_recvbuf));
+    } else {
+        res = at_host_responder(line, NULL, 0, at_host_recvbuf, sizeof(at_host_recvbuf));
+    }
+    at_host_recvbuf[sizeof(at_host_recvbuf) - 1] = '\0';
+    return res;
+}
+
+static void at_host_finish(at_host_req_t *req, at_resp_code code)
+{
+    at_response_t r;
+    const char *suffix = req->attr.suffix != NULL ? req->attr.suffix : "OK";
+
+    r.params  = req->attr.params;
+    r.recvbuf = at_host_recvbuf;
+    r.recvcnt = (unsigned short)strlen(at_host_recvbuf);
+    r.prefix  = NULL;
+    if (req->attr.prefix != NULL) {
+        r.prefix = strstr(at_host_recvbuf, req->attr.prefix);
+    }
+    if (r.prefix == NULL) {
+        r.prefix = at_host_recvbuf;
+    }
+    r.suffix = strstr(at_host_recvbuf, suffix);
+    if (r.suffix == NULL) {
+        r.suffix = at_host_recvbuf + r.recvcnt;
+    }
+    r.code = code;
+
+    if (req->attr.cb != NULL) {
+        req->attr.cb(&r);
+    }
+    if (at_host_obj.curr_cb != NULL) {
+        at_host_obj.curr_cb(&r);
+    }
+    free(req->cmd);
+    free(req->data);
+}
+
+/**
+ * @brief 发送一条命令，失败时按retry重发。
+ *
+ * @return true 得到了结果，false 应答函数挂起了命令
+ */
+static bool at_host_run(at_host_req_t *req, at_resp_code *pCode)
+{
+    at_host_result_t res = AT_HOST_REPLY;
+    at_resp_code code    = AT_RESP_OK;
+    int tries;
+    int i;
+
+    for (tries = 0; tries <= req->attr.retry; tries++) {
+        if (req->type == AT_HOST_REQ_MULTILINE) {
+            code = AT_RESP_OK;
+            for (i = 0; req->multiline[i] != NULL && code == AT_RESP_OK; i++) {
+                res  = at_host_ask(req, req->multiline[i]);
+                code = res == AT_HOST_REPLY ? at_host_code(req) : AT_RESP_TIMEOUT;
+            }
+        } else {
+            res = at_host_ask(req, req->cmd);
+            if (res == AT_HOST_PENDING) {
+                return false;
+            }
+            code = res == AT_HOST_REPLY ? at_host_code(req) : AT_RESP_TIMEOUT;
+        }
+        if (code == AT_RESP_OK) {
+            break;
+        }
+    }
+    *pCode = code;
+    return true;
+}
+
+static void at_host_dispatch_urc(const char *line)
+{
+    at_urc_info_t info;
+    int i;
+
+    for (i = 0; i < at_host_obj.urc_count; i++) {
+        const char *prefix = at_host_obj.urc_tbl[i].prefix;
+        if (strncmp(line, prefix, strlen(prefix)) == 0) {
+            snprintf(at_host_urcbuf, sizeof(at_host_urcbuf), "%s", line);
+            info.urcbuf = at_host_urcbuf;
+            info.urclen = (int)strlen(at_host_urcbuf);
+            at_host_obj.urc_tbl[i].handler(&info);
+            return;
+        }
+    }
+}
+
+void at_obj_process(at_obj_t *at)
+{
+    at_host_req_t req;
+    at_resp_code code;
+    int i;
+
+    (void)at;
+    // 先分发URC，测试在命令的响应之前注入的URC和串口上一样先到
+    for (i = 0; i < at_host_urc_len; i++) {
+        at_host_dispatch_urc(at_host_urcs[i]);
+        free(at_host_urcs[i]);
+    }
+    at_host_urc_len = 0;
+
+    if (at_host_curr_pending) {
+        if (at_host_curr_done) {
+            at_host_curr_pending = false;
+            at_host_finish(&at_host_curr, at_host_curr_code);
+        }
+        return;
+    }
+    if (at_host_queue_len == 0) {
+        return;
+    }
+    req = at_host_queue[0];
+    at_host_queue_len--;
+    memmove(&at_host_queue[0], &at_host_queue[1], sizeof(at_host_req_t) * at_host_queue_len);
+    if (at_host_run(&req, &code)) {
+        at_host_finish(&req, code);
+    } else {
+        at_host_curr         = req;
+        at_host_curr_pending = true;
+        at_host_curr_done    = false;
+    }
+}
+
+void at_host_reply(const char *reply)
+{
+    if (!at_host_curr_pending || at_host_curr_done) {
+        return;
+    }
+    snprintf(at_host_recvbuf, sizeof(at_host_recvbuf), "%s", reply);
+    at_host_curr_code = at_host_code(&at_host_curr);
+    at_host_curr_done = true;
+}
+
+void at_host_timeout(void)
+{
+    if (!at_host_curr_pending || at_host_curr_done) {
+        return;
+    }
+    at_host_recvbuf[0] = '\0';
+    at_host_curr_code  = AT_RESP_TIMEOUT;
+    at_host_curr_done  = true;
+}
+
+bool at_host_is_pending(void)
+{
+    return at_host_curr_pending && !at_host_curr_done;
+}
+
+bool at_host_urc(const char *line)
+{
+    if (at_host_urc_len >= AT_HOST_URC_MAX) {
+        return false;
+    }
+    at_host_urcs[at_host_urc_len++] = strdup(line);
+    return true;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file at_chat_host.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)上at_chat的模组模型：命令不经过串口，按发送的顺序逐条交给测试注册的应答函数，
+ * 应答函数返回模组的响应、超时或者挂起，挂起的命令由测试之后调用at_host_reply/at_host_timeout结束，
+ * 期间后面的命令和目标板上一样排队等待。
+ * 每次at_obj_process最多结束一条命令，然后分发测试用at_host_urc注入的URC。
+ * 响应中有attr的suffix（没有设置时为"OK"）为AT_RESP_OK，有"ERROR"为AT_RESP_ERROR，其他为AT_RESP_TIMEOUT，
+ * 失败时按attr的retry重发。多行命令逐行发送，不支持挂起。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef AT_CHAT_HOST_H
+#define AT_CHAT_HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "at_chat.h"
+
+// 等待发送的命令的最大条数
+#define AT_HOST_QUEUE_MAX 32
+// 响应和URC的最大长度
+#define AT_HOST_BUF_SIZE  2048
+
+typedef enum {
+    AT_HOST_REPLY = 0, // reply中是模组的响应
+    AT_HOST_TIMEOUT,   // 模组没有响应
+    AT_HOST_PENDING,   // 之后由at_host_reply/at_host_timeout结束
+} at_host_result_t;
+
+// 应答函数：cmd是命令行（不含\r\n），at_send_data发送的数据时cmd为NULL，数据在data、len中
+typedef at_host_result_t (*at_host_responder_t)(const char *cmd, const uint8_t *data, unsigned int len,
+                                               char *reply, unsigned int size);
+
+// 没有注册应答函数时所有命令响应"OK"
+void at_host_set_responder(at_host_responder_t responder);
+// 结束挂起的命令
+void at_host_reply(const char *reply);
+void at_host_timeout(void);
+bool at_host_is_pending(void);
+// 注入一条URC，在下一次at_obj_process中分发
+bool at_host_urc(const char *line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !AT_CHAT_HOST_H
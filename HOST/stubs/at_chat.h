@@ -0,0 +1,87 @@
+/**
+ * @file at_chat.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机编译时代替AT-Command组件的at_chat.h，只声明BFL_4G用到的类型和接口。
+ * 实现在HOST/at_chat_host.c中，不经过串口，命令直接交给测试注册的应答函数，见at_chat_host.h。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef AT_CHAT_H
+#define AT_CHAT_H
+
+#include <stddef.h>
+
+typedef enum {
+    AT_RESP_OK = 0,  // 收到了suffix
+    AT_RESP_ERROR,   // 收到了ERROR
+    AT_RESP_TIMEOUT, // 超时
+    AT_RESP_ABORT,   // 被中止
+} at_resp_code;
+
+typedef enum {
+    AT_PRIORITY_LOW = 0,
+    AT_PRIORITY_HIGH, // 插到等待队列的最前面
+} at_priority;
+
+typedef struct {
+    void *params;
+    char *recvbuf;          // 收到的全部响应
+    unsigned short recvcnt; // 响应的长度
+    const char *prefix;     // 响应中prefix开始的位置，没有设置prefix时为recvbuf
+    const char *suffix;     // 响应中suffix开始的位置
+    at_resp_code code;
+} at_response_t;
+
+typedef void (*at_callback_t)(at_response_t *r);
+
+typedef struct {
+    void *params;
+    const char *prefix;
+    const char *suffix;
+    at_callback_t cb;
+    unsigned short timeout; // ms
+    unsigned char retry;    // 错误或者超时后重发的次数
+    at_priority priority;
+    void *ctx;
+} at_attr_t;
+
+typedef struct {
+    char *urcbuf;
+    int urclen;
+} at_urc_info_t;
+
+typedef struct {
+    const char *prefix;
+    const char *stem;
+    char endmark;
+    int (*handler)(at_urc_info_t *info);
+} urc_item_t;
+
+typedef struct {
+    void (*lock)(void);
+    void (*unlock)(void);
+    unsigned int (*write)(const void *buf, unsigned int len);
+    unsigned int (*read)(void *buf, unsigned int len);
+    void (*debug)(const char *fmt, ...);
+    int urc_bufsize;
+    int recv_bufsize;
+} at_adapter_t;
+
+typedef struct at_obj at_obj_t;
+
+at_obj_t *at_obj_create(const at_adapter_t *adap);
+void at_obj_process(at_obj_t *at);
+void at_obj_set_curr_at_cb(at_obj_t *at, at_callback_t cb);
+void at_obj_set_urc(at_obj_t *at, urc_item_t *tbl, int count);
+int at_send_singlline(at_obj_t *at, const at_attr_t *attr, const char *singlling);
+int at_send_multiline(at_obj_t *at, const at_attr_t *attr, const char **multiline);
+int at_exec_cmd(at_obj_t *at, const at_attr_t *attr, const char *cmd, ...);
+int at_send_data(at_obj_t *at, const at_attr_t *attr, const void *databuf, unsigned int bufsize);
+void *at_malloc(unsigned int nbytes);
+void at_free(void *ptr);
+
+#endif // !AT_CHAT_H
@@ -0,0 +1,18 @@
+/**
+ * @file cmsis_os.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机编译时代替CMSIS-RTOS的头文件。FatFs没有开启可重入（_FS_REENTRANT为0），
+ * ffconf.h中的_SYNC_t不会用到，这里只提供类型名。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef CMSIS_OS_H
+#define CMSIS_OS_H
+
+typedef void *osSemaphoreId_t;
+
+#endif /* CMSIS_OS_H */
@@ -0,0 +1,226 @@
+/**
+ * @file main.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机(Linux)编译时代替Core/Inc/main.h，只提供HDL以上各层用到的Cortex-M内核接口、
+ * HAL时基、串口和SPI参数，以及SD卡驱动用到的GPIO、EXTI接口。主机上没有中断，关中断和开中断、
+ * 中断配置都是空操作。GPIO只模拟输出和输入寄存器，SD卡模型从输出寄存器读取片选，
+ * GPIOA只有SD卡电源控制脚用到。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef __IO
+#define __IO volatile
+#endif
+
+// Uart_Init的参数，主机上忽略
+#define LL_USART_DATAWIDTH_7B 0x10000000U
+#define LL_USART_DATAWIDTH_8B 0x00000000U
+#define LL_USART_DATAWIDTH_9B 0x00001000U
+#define LL_USART_STOPBITS_1   0x00000000U
+#define LL_USART_STOPBITS_2   0x00002000U
+#define LL_USART_PARITY_NONE  0x00000000U
+#define LL_USART_PARITY_EVEN  0x00000400U
+#define LL_USART_PARITY_ODD   0x00000600U
+
+// HDL_SPI_Init的参数，主机上忽略
+#define LL_SPI_POLARITY_LOW  0x00000000U
+#define LL_SPI_POLARITY_HIGH 0x00000002U
+#define LL_SPI_PHASE_1EDGE   0x00000000U
+#define LL_SPI_PHASE_2EDGE   0x00000001U
+
+typedef enum {
+    DISABLE = 0,
+    ENABLE  = !DISABLE
+} FunctionalState;
+
+typedef enum {
+    SUCCESS = 0,
+    ERROR   = !SUCCESS
+} ErrorStatus;
+
+typedef struct {
+    __IO uint32_t ODR;
+    __IO uint32_t IDR;
+} GPIO_TypeDef;
+
+// 端口寄存器定义在HOST/HDL_SPI_host.c
+extern GPIO_TypeDef _gHostGPIOA;
+extern GPIO_TypeDef _gHostGPIOB;
+#define GPIOA (&_gHostGPIOA)
+#define GPIOB (&_gHostGPIOB)
+
+#define LL_GPIO_PIN_1            0x00000002U
+#define LL_GPIO_PIN_11           0x00000800U
+#define LL_GPIO_PIN_12           0x00001000U
+#define LL_GPIO_MODE_INPUT       0x00000000U
+#define LL_GPIO_MODE_OUTPUT      0x00000001U
+#define LL_GPIO_SPEED_FREQ_LOW   0x00000000U
+#define LL_GPIO_SPEED_FREQ_HIGH  0x00000002U
+#define LL_GPIO_OUTPUT_PUSHPULL  0x00000000U
+#define LL_GPIO_PULL_NO          0x00000000U
+#define LL_GPIO_PULL_UP          0x00000001U
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Speed;
+    uint32_t OutputType;
+    uint32_t Pull;
+    uint32_t Alternate;
+} LL_GPIO_InitTypeDef;
+
+#define LL_AHB2_GRP1_PERIPH_GPIOA 0x00000001U
+#define LL_AHB2_GRP1_PERIPH_GPIOB 0x00000002U
+
+static inline void LL_AHB2_GRP1_EnableClock(uint32_t periphs)
+{
+    (void)periphs;
+}
+
+static inline ErrorStatus LL_GPIO_Init(GPIO_TypeDef *GPIOx, LL_GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    (void)GPIOx;
+    (void)GPIO_InitStruct;
+    return SUCCESS;
+}
+
+static inline void LL_GPIO_SetPinMode(GPIO_TypeDef *GPIOx, uint32_t Pin, uint32_t Mode)
+{
+    (void)GPIOx;
+    (void)Pin;
+    (void)Mode;
+}
+
+static inline void LL_GPIO_SetPinPull(GPIO_TypeDef *GPIOx, uint32_t Pin, uint32_t Pull)
+{
+    (void)GPIOx;
+    (void)Pin;
+    (void)Pull;
+}
+
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    GPIOx->ODR |= PinMask;
+}
+
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    GPIOx->ODR &= ~PinMask;
+}
+
+static inline uint32_t LL_GPIO_IsOutputPinSet(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    return (GPIOx->ODR & PinMask) == PinMask;
+}
+
+static inline uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    return (GPIOx->IDR & PinMask) == PinMask;
+}
+
+#define LL_EXTI_LINE_11                0x00000800U
+#define LL_EXTI_MODE_IT                0x00U
+#define LL_EXTI_TRIGGER_RISING_FALLING 0x03U
+#define LL_SYSCFG_EXTI_PORTB           1U
+#define LL_SYSCFG_EXTI_LINE11          11U
+
+typedef struct {
+    uint32_t Line_0_31;
+    uint32_t Line_32_63;
+    FunctionalState LineCommand;
+    uint8_t Mode;
+    uint8_t Trigger;
+} LL_EXTI_InitTypeDef;
+
+static inline ErrorStatus LL_EXTI_Init(LL_EXTI_InitTypeDef *EXTI_InitStruct)
+{
+    (void)EXTI_InitStruct;
+    return SUCCESS;
+}
+
+static inline void LL_SYSCFG_SetEXTISource(uint32_t Port, uint32_t Line)
+{
+    (void)Port;
+    (void)Line;
+}
+
+typedef enum {
+    EXTI15_10_IRQn = 40,
+} IRQn_Type;
+
+static inline uint32_t NVIC_GetPriorityGrouping(void)
+{
+    return 0;
+}
+
+static inline uint32_t NVIC_EncodePriority(uint32_t PriorityGroup, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)PriorityGroup;
+    (void)SubPriority;
+    return PreemptPriority;
+}
+
+static inline void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    (void)IRQn;
+    (void)priority;
+}
+
+static inline void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+// HAL时基，实现见HOST/HDL_CPU_Time_host.c
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+static inline void __set_PRIMASK(uint32_t priMask)
+{
+    (void)priMask;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+static inline void __enable_irq(void)
+{
+}
+
+static inline void __DSB(void)
+{
+}
+
+static inline void __ISB(void)
+{
+}
+
+static inline void __NOP(void)
+{
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MAIN_H */
@@ -0,0 +1,17 @@
+/**
+ * @file stm32g4xx_hal.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机编译时代替HAL的总头文件，FatFs的ffconf.h包含它，需要的定义都在main.h中。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef STM32G4xx_HAL_H
+#define STM32G4xx_HAL_H
+
+#include "main.h"
+
+#endif /* STM32G4xx_HAL_H */
@@ -0,0 +1,20 @@
+/**
+ * @file stm32g4xx_hal_flash.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机编译时代替HAL的Flash头文件，只提供HDL_Flash.h用到的STM32G473片上Flash参数。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef STM32G4xx_HAL_FLASH_H
+#define STM32G4xx_HAL_FLASH_H
+
+#define FLASH_BASE      0x08000000UL
+#define FLASH_SIZE      0x80000UL // 512KB
+#define FLASH_PAGE_SIZE 0x800UL   // 2KB
+#define FLASH_PAGE_NB   128U      // 一个BANK的page数
+
+#endif /* STM32G4xx_HAL_FLASH_H */
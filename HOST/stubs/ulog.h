@@ -0,0 +1,79 @@
+/**
+ * @file ulog.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机编译时3rdparty/ulog没有检出时使用的ulog接口，和3rdparty/ulog/src/ulog.h的接口一致，
+ * 实现见HOST/ulog_host.c。检出了3rdparty/ulog时CMakeLists.txt直接使用原来的ulog。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef ULOG_H_
+#define ULOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ULOG_MAX_SUBSCRIBERS    6
+#define ULOG_MAX_MESSAGE_LENGTH 120
+
+typedef enum {
+    ULOG_TRACE_LEVEL = 100,
+    ULOG_DEBUG_LEVEL,
+    ULOG_INFO_LEVEL,
+    ULOG_WARNING_LEVEL,
+    ULOG_ERROR_LEVEL,
+    ULOG_CRITICAL_LEVEL,
+    ULOG_ALWAYS_LEVEL
+} ulog_level_t;
+
+typedef enum {
+    ULOG_ERR_NONE = 0,
+    ULOG_ERR_SUBSCRIBERS_EXCEEDED,
+    ULOG_ERR_NOT_SUBSCRIBED,
+} ulog_err_t;
+
+typedef void (*ulog_function_t)(ulog_level_t severity, char *msg);
+
+#ifdef ULOG_ENABLED
+#define ULOG_INIT()            ulog_init()
+#define ULOG_SUBSCRIBE(a, b)   ulog_subscribe(a, b)
+#define ULOG_UNSUBSCRIBE(a)    ulog_unsubscribe(a)
+#define ULOG_LEVEL_NAME(a)     ulog_level_name(a)
+#define ULOG(...)              ulog_message(__VA_ARGS__)
+#define ULOG_TRACE(...)        ulog_message(ULOG_TRACE_LEVEL, __VA_ARGS__)
+#define ULOG_DEBUG(...)        ulog_message(ULOG_DEBUG_LEVEL, __VA_ARGS__)
+#define ULOG_INFO(...)         ulog_message(ULOG_INFO_LEVEL, __VA_ARGS__)
+#define ULOG_WARNING(...)      ulog_message(ULOG_WARNING_LEVEL, __VA_ARGS__)
+#define ULOG_ERROR(...)        ulog_message(ULOG_ERROR_LEVEL, __VA_ARGS__)
+#define ULOG_CRITICAL(...)     ulog_message(ULOG_CRITICAL_LEVEL, __VA_ARGS__)
+#define ULOG_ALWAYS(...)       ulog_message(ULOG_ALWAYS_LEVEL, __VA_ARGS__)
+#else
+#define ULOG_INIT()            do {} while (0)
+#define ULOG_SUBSCRIBE(a, b)   do {} while (0)
+#define ULOG_UNSUBSCRIBE(a)    do {} while (0)
+#define ULOG_LEVEL_NAME(a)     do {} while (0)
+#define ULOG(...)              do {} while (0)
+#define ULOG_TRACE(...)        do {} while (0)
+#define ULOG_DEBUG(...)        do {} while (0)
+#define ULOG_INFO(...)         do {} while (0)
+#define ULOG_WARNING(...)      do {} while (0)
+#define ULOG_ERROR(...)        do {} while (0)
+#define ULOG_CRITICAL(...)     do {} while (0)
+#define ULOG_ALWAYS(...)       do {} while (0)
+#endif
+
+void ulog_init(void);
+ulog_err_t ulog_subscribe(ulog_function_t fn, ulog_level_t threshold);
+ulog_err_t ulog_unsubscribe(ulog_function_t fn);
+const char *ulog_level_name(ulog_level_t level);
+void ulog_message(ulog_level_t severity, const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_H_ */
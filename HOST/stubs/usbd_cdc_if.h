@@ -0,0 +1,27 @@
+/**
+ * @file usbd_cdc_if.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机编译时代替USB_Device/App/usbd_cdc_if.h，主机上没有USB，发送总是返回忙。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef __USBD_CDC_IF_H__
+#define __USBD_CDC_IF_H__
+#include <stdint.h>
+
+#define USBD_OK   0U
+#define USBD_BUSY 1U
+#define USBD_FAIL 3U
+
+static inline uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len)
+{
+    (void)Buf;
+    (void)Len;
+    return USBD_BUSY;
+}
+
+#endif /* __USBD_CDC_IF_H__ */
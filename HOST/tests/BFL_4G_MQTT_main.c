@@ -0,0 +1,605 @@
+/**
+ * @file BFL_4G_MQTT_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上用HOST/at_chat_host.c的模组模型和W25Q512模型测试BFL_4G_MQTT_Task.c：
+ * 应答函数模拟EC800M和MQTT服务器，记录每次发布的序号，荷载由序号生成，可以检查内容。
+ * 不带参数运行时新建Flash镜像，依次检查：
+ * 订阅的'+'和'#'通配符匹配（"a/#"也匹配"a"）；
+ * QoS1的消息只有收到+QMTPUBEX的成功应答后才从队列中删除，失败的应答重发，断线后迟到的应答不删除，重连后重发；
+ * 模组不应答时内存队列写满后溢出到QFS，应答恢复后按写入顺序每条发布一次；
+ * 最后在QFS的首部写入Flash、读位置在扇区中间时直接退出，模拟掉电。
+ * 带参数resume运行时先按记录格式独立解析掉电前Flash中QFS队列的扇区，再启动MQTT，
+ * 检查恢复的消息从队首扇区的第一条记录开始、和解析的结果一致，之后是新写入的消息；
+ * 同时检查QFS的首部在它自己的扇区中，没有写到物理扇区0。
+ * 模组模型不能在目标板上运行，所以测试只在主机上编译。Flash镜像由RTU_HOST_FLASH指定。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "BFL_4G.h"
+#include "BFL_4G_Task.h"
+#include "CHIP_W25Q512.h"
+#include "CHIP_W25Q512_QueueFileSystem.h"
+#include "CHIP_W25Q512_host.h"
+#include "at_chat_host.h"
+#include "crc.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+// 和BFL_4G_MQTT_Task.c的记录格式、CHIP_W25Q512_QueueFileSystem.c的扇区布局一致，用来独立解析Flash中的内容
+#define RECORD_MAGIC         0xA5
+#define RECORD_HEAD_SIZE     5
+#define RECORD_SIZE(LEN)     (RECORD_HEAD_SIZE + (LEN) + 2)
+#define QFS_HEADER_SECTOR    W25Q512_QFS_FIRST_SECTOR
+#define QFS_DATA_SECTORS     (W25Q512_QFS_SECTOR_COUNT - 1)
+#define QFS_DATA_SECTOR(N)   (QFS_HEADER_SECTOR + 1 + (N))
+
+// 一条记录207字节，一个扇区放19条，内存队列放19条
+#define PAYLOAD_LEN          200U
+#define PUB_TOPIC            "rtu/dev1/data"
+#define MAX_PUBS             1024U
+// 每次轮询推进的W25Q512模型时间，ns
+#define POLL_NS              100000ULL
+// 掉电恢复后新写入的消息的序号
+#define RESUME_SEQ           1000U
+#define RESUME_NEW           5U
+
+typedef struct {
+    uint32_t seq;
+    uint16_t msgId;
+    uint8_t qos;
+    bool valid; // 荷载和序号生成的内容一致
+} Pub_t;
+
+typedef struct {
+    bool offline;   // 模组不响应
+    bool mqttUp;    // +QMTCONN?查询到的连接状态
+    int32_t ackLeft; // 还直接应答的发布次数，为0时挂起，由测试应答，<0不限
+    unsigned pubMsgId;
+    unsigned pubQos;
+    unsigned pubLen;
+    char pubTopic[64];
+    Pub_t pubs[MAX_PUBS];
+    uint32_t pubNum;
+    char subs[8][64];
+    uint32_t subNum;
+    uint32_t conns;
+} Broker_t;
+
+typedef bool (*Cond_t)(void);
+
+static Broker_t _gBroker;
+static uint32_t _gWantPubs = 0;
+static uint32_t _gErrorCnt = 0;
+// 订阅ID 0的回调收到的消息
+static uint8_t _gHandlerBuf[16];
+static uint32_t _gHandlerLen   = 0;
+static uint32_t _gHandlerTimes = 0;
+static uint8_t _gSector[W25Q512_SECTOR_SIZE];
+static uint32_t _gExpect[MAX_PUBS];
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[MQTT Test] check failed: %s", what);
+    }
+}
+
+/**
+ * @brief 模组由at_chat_host.c模拟，不需要上电时序。
+ *
+ */
+void CHIP_EC800M_Init()
+{
+}
+
+static void make_payload(uint32_t seq, uint8_t *buf)
+{
+    buf[0] = (uint8_t)seq;
+    buf[1] = (uint8_t)(seq >> 8);
+    buf[2] = (uint8_t)(seq >> 16);
+    buf[3] = (uint8_t)(seq >> 24);
+    for (uint32_t i = 4; i < PAYLOAD_LEN; i++) {
+        buf[i] = (uint8_t)(seq * 7U + i);
+    }
+}
+
+static bool payload_check(const uint8_t *buf, uint32_t len, uint32_t *pSeq)
+{
+    uint8_t expect[PAYLOAD_LEN];
+
+    if (len != PAYLOAD_LEN) {
+        return false;
+    }
+    *pSeq = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+    make_payload(*pSeq, expect);
+    return memcmp(buf, expect, PAYLOAD_LEN) == 0;
+}
+
+/**
+ * @brief 模组和服务器的应答。
+ *
+ */
+static at_host_result_t broker_respond(const char *cmd, const uint8_t *data, unsigned int len, char *reply, unsigned int size)
+{
+    Pub_t *pPub = NULL;
+
+    if (cmd == NULL) {
+        // '>'之后发送的荷载
+        if (_gBroker.pubNum < MAX_PUBS) {
+            pPub        = &_gBroker.pubs[_gBroker.pubNum++];
+            pPub->msgId = (uint16_t)_gBroker.pubMsgId;
+            pPub->qos   = (uint8_t)_gBroker.pubQos;
+            pPub->valid = len == _gBroker.pubLen && strcmp(_gBroker.pubTopic, PUB_TOPIC) == 0 &&
+                          payload_check(data, len, &pPub->seq);
+        }
+        if (_gBroker.ackLeft == 0) {
+            return AT_HOST_PENDING;
+        }
+        if (_gBroker.ackLeft > 0) {
+            _gBroker.ackLeft--;
+        }
+        snprintf(reply, size, "+QMTPUBEX: 0,%u,0", _gBroker.pubMsgId);
+        return AT_HOST_REPLY;
+    }
+    if (_gBroker.offline || cmd[0] == '\0') {
+        // 空命令是at_task_delay的延时
+        return AT_HOST_TIMEOUT;
+    }
+
+    if (strncmp(cmd, "AT+QMTPUBEX=", 12) == 0) {
+        _gBroker.pubTopic[0] = '\0';
+        sscanf(cmd, "AT+QMTPUBEX=0,%u,%u,%*u,\"%63[^\"]\",%u", &_gBroker.pubMsgId, &_gBroker.pubQos,
+               _gBroker.pubTopic, &_gBroker.pubLen);
+        snprintf(reply, size, ">");
+    } else if (strncmp(cmd, "AT+CREG?;", 9) == 0) {
+        snprintf(reply, size, "+CREG: 0,1\r\n+QIACT: 1,1,1,\"10.0.0.2\"\r\n+QMTCONN: 0,%d\r\nOK", _gBroker.mqttUp ? 3 : 1);
+    } else if (strcmp(cmd, "AT+CPIN?") == 0) {
+        snprintf(reply, size, "+CPIN: READY\r\nOK");
+    } else if (strcmp(cmd, "AT+CREG?") == 0) {
+        snprintf(reply, size, "+CREG: 0,1\r\nOK");
+    } else if (strcmp(cmd, "AT+CCLK?") == 0) {
+        snprintf(reply, size, "+CCLK: \"23/10/24,08:00:00+32\"\r\nOK");
+    } else if (strncmp(cmd, "AT+QMTOPEN=", 11) == 0) {
+        snprintf(reply, size, "OK\r\n\r\n+QMTOPEN: 0,0");
+    } else if (strncmp(cmd, "AT+QMTCONN=", 11) == 0) {
+        _gBroker.mqttUp = true;
+        _gBroker.conns++;
+        snprintf(reply, size, "OK\r\n\r\n+QMTCONN: 0,0,0");
+    } else if (strncmp(cmd, "AT+QMTSUB=", 10) == 0) {
+        unsigned msgId = 0;
+        if (_gBroker.subNum < 8) {
+            sscanf(cmd, "AT+QMTSUB=0,%u,\"%63[^\"]\"", &msgId, _gBroker.subs[_gBroker.subNum++]);
+        }
+        snprintf(reply, size, "OK\r\n\r\n+QMTSUB: 0,%u,0,1", msgId);
+    } else {
+        snprintf(reply, size, "OK");
+    }
+    return AT_HOST_REPLY;
+}
+
+static void poll_once()
+{
+    BFL_4G_Poll();
+    // W25Q512模型的时间只在操作Flash时推进，按轮询间隔推进后不等待完成的擦除、编程才会结束
+    CHIP_W25Q512_Host_Elapse(POLL_NS);
+    usleep(100);
+}
+
+static void poll_ms(uint32_t ms)
+{
+    uint32_t start = HDL_CPU_Time_GetTick();
+    while (HDL_CPU_Time_GetTick() - start < ms) {
+        poll_once();
+    }
+}
+
+static bool poll_until(Cond_t cond, uint32_t timeoutMs)
+{
+    uint32_t start = HDL_CPU_Time_GetTick();
+    while (!cond()) {
+        if (HDL_CPU_Time_GetTick() - start > timeoutMs) {
+            return false;
+        }
+        poll_once();
+    }
+    return true;
+}
+
+static bool mqtt_connected()
+{
+    return BFL_4G_MQTT_IsConnected();
+}
+
+static bool ack_pending()
+{
+    return at_host_is_pending();
+}
+
+static bool pubs_reached()
+{
+    return _gBroker.pubNum >= _gWantPubs;
+}
+
+// 连接后逐个订阅
+static bool subscribed()
+{
+    return _gBroker.subNum >= ALLOWED_SUBSCRIBE_TOPIC_NUM;
+}
+
+static bool mqtt_writeable()
+{
+    return BFL_4G_MQTT_Writeable(0);
+}
+
+static bool qfs_has_sector()
+{
+    return CHIP_W25Q512_QFS_size() > 0;
+}
+
+static bool write_seq(uint32_t seq, uint8_t qos)
+{
+    uint8_t payload[PAYLOAD_LEN];
+
+    // QFS的写入缓存满时等待写到Flash
+    if (!poll_until(mqtt_writeable, 3000)) {
+        return false;
+    }
+    make_payload(seq, payload);
+    return BFL_4G_MQTT_Write(0, payload, PAYLOAD_LEN, qos, 0) == PAYLOAD_LEN;
+}
+
+// 从第first条开始的发布的序号依次为seq, seq+1, ...，共num条，内容都正确
+static bool pubs_in_order(uint32_t first, uint32_t seq, uint32_t num)
+{
+    if (_gBroker.pubNum < first + num) {
+        ULOG_ERROR("[MQTT Test] %u publishes, expect at least %u", _gBroker.pubNum, first + num);
+        return false;
+    }
+    for (uint32_t i = 0; i < num; i++) {
+        const Pub_t *pPub = &_gBroker.pubs[first + i];
+        if (!pPub->valid || pPub->seq != seq + i) {
+            ULOG_ERROR("[MQTT Test] publish %u: seq %u valid %d, expect seq %u", first + i, pPub->seq, pPub->valid, seq + i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void sub_handler(int mqttSubId, const uint8_t *payload, uint32_t uiLen)
+{
+    _gHandlerTimes++;
+    _gHandlerLen = uiLen < sizeof(_gHandlerBuf) ? uiLen : sizeof(_gHandlerBuf);
+    memcpy(_gHandlerBuf, payload, _gHandlerLen);
+    check(mqttSubId == 0, "handler sub id");
+}
+
+static void mqtt_start()
+{
+    at_host_set_responder(broker_respond);
+    BFL_4G_Init("IP", "CMIOT");
+    BFL_4G_MQTT_PublishTopicInit(0, PUB_TOPIC, false);
+    BFL_4G_MQTT_Init("broker.test", 1883, "rtu-test", NULL, NULL);
+}
+
+static void connect_test()
+{
+    _gBroker.ackLeft = -1;
+    mqtt_start();
+    check(BFL_4G_MQTT_Subscribe(0, "rtu/+/cmd", 1, sub_handler) == 0, "subscribe 0");
+    check(BFL_4G_MQTT_Subscribe(1, "rtu/cfg/#", 1, NULL) == 0, "subscribe 1");
+    check(BFL_4G_MQTT_Subscribe(2, "+/status", 0, NULL) == 0, "subscribe 2");
+    check(BFL_4G_MQTT_Subscribe(3, "rtu/#", 0, NULL) == 0, "subscribe 3");
+
+    check(poll_until(mqtt_connected, 20000), "connected");
+    check(_gBroker.conns == 1, "one connection");
+    check(poll_until(subscribed, 2000), "four subscriptions");
+    check(strcmp(_gBroker.subs[0], "rtu/+/cmd") == 0 && strcmp(_gBroker.subs[1], "rtu/cfg/#") == 0 &&
+              strcmp(_gBroker.subs[2], "+/status") == 0 && strcmp(_gBroker.subs[3], "rtu/#") == 0,
+          "subscription filters in order");
+}
+
+// 订阅ID下的下一条消息只有一个字节expect
+static void read_expect(int mqttSubId, uint8_t expect)
+{
+    uint8_t buf[16];
+    char what[48];
+
+    snprintf(what, sizeof(what), "sub %d reads 0x%02X", mqttSubId, expect);
+    check(BFL_4G_MQTT_Read(mqttSubId, buf, sizeof(buf)) == 1 && buf[0] == expect, what);
+}
+
+static void topic_test()
+{
+    at_host_urc("+QMTRECV: 0,1,\"rtu/dev1/cmd\",2,\"0102\"\r\n");
+    at_host_urc("+QMTRECV: 0,2,\"rtu/cfg\",1,\"AA\"\r\n");
+    at_host_urc("+QMTRECV: 0,3,\"rtu/cfg/a/b\",1,\"BB\"\r\n");
+    at_host_urc("+QMTRECV: 0,4,\"dev/status\",1,\"CC\"\r\n");
+    at_host_urc("+QMTRECV: 0,5,\"dev/x/status\",1,\"DD\"\r\n");
+    at_host_urc("+QMTRECV: 0,6,\"rtu/dev1/cmd/x\",1,\"EE\"\r\n");
+    at_host_urc("+QMTRECV: 0,7,\"other/x\",1,\"FF\"\r\n");
+    // 解码后为空的消息丢弃，不进入接收队列
+    at_host_urc("+QMTRECV: 0,8,\"dev/status\",1,\"ZZ\"\r\n");
+    poll_ms(10);
+
+    // '+'只匹配一级
+    check(_gHandlerTimes == 1 && _gHandlerLen == 2 && _gHandlerBuf[0] == 0x01 && _gHandlerBuf[1] == 0x02,
+          "rtu/+/cmd matches rtu/dev1/cmd only");
+    // '#'匹配父级和任意多级
+    check(BFL_4G_MQTT_Readable(1), "one byte message readable");
+    read_expect(1, 0xAA);
+    read_expect(1, 0xBB);
+    read_expect(2, 0xCC);
+    // 前面的过滤器不匹配时由后面的订阅ID接收
+    read_expect(3, 0xEE);
+    for (int i = 0; i < 4; i++) {
+        check(!BFL_4G_MQTT_Readable(i), "no other messages");
+    }
+}
+
+static void ack_test()
+{
+    uint32_t first = _gBroker.pubNum;
+    char ack[48];
+
+    // 发布挂起，在途时不发布下一条
+    _gBroker.ackLeft = 0;
+    check(write_seq(0, 1), "write seq 0");
+    check(write_seq(1, 1), "write seq 1");
+    check(poll_until(ack_pending, 2000), "seq 0 published");
+    poll_ms(300);
+    check(pubs_in_order(first, 0, 1), "only seq 0 in flight");
+    check(_gBroker.pubs[first].qos == 1 && _gBroker.pubs[first].msgId != 0, "QoS1 with msgId");
+
+    // 发布失败：消息留在队列中，退避后重发
+    snprintf(ack, sizeof(ack), "+QMTPUBEX: 0,%u,2", _gBroker.pubs[first].msgId);
+    at_host_reply(ack);
+    _gWantPubs = first + 2;
+    check(poll_until(pubs_reached, 3000), "seq 0 republished after failure");
+    check(_gBroker.pubs[first + 1].seq == 0 && _gBroker.pubs[first + 1].msgId != _gBroker.pubs[first].msgId,
+          "republish uses a new msgId");
+
+    // 连接断开后才到的成功应答不删除消息，重连后重发
+    _gBroker.mqttUp = false;
+    at_host_urc("+QMTSTAT: 0,1\r\n");
+    snprintf(ack, sizeof(ack), "+QMTPUBEX: 0,%u,0", _gBroker.pubs[first + 1].msgId);
+    at_host_reply(ack);
+    _gBroker.ackLeft = -1;
+    poll_ms(10);
+    check(!BFL_4G_MQTT_IsConnected(), "down after +QMTSTAT");
+    check(poll_until(mqtt_connected, 5000), "reconnected");
+    check(_gBroker.conns == 2, "second connection");
+
+    _gWantPubs = first + 4;
+    check(poll_until(pubs_reached, 3000), "queue drained");
+    check(write_seq(2, 0), "write seq 2");
+    _gWantPubs = first + 5;
+    check(poll_until(pubs_reached, 3000), "seq 2 published");
+    poll_ms(300);
+    check(_gBroker.pubNum == first + 5, "no more publishes");
+    check(_gBroker.pubs[first + 2].seq == 0 && _gBroker.pubs[first + 3].seq == 1 && _gBroker.pubs[first + 4].seq == 2,
+          "publish order after reconnect");
+    check(_gBroker.pubs[first + 4].qos == 0 && _gBroker.pubs[first + 4].msgId == 0, "QoS0 without msgId");
+    for (uint32_t i = first; i < first + 5; i++) {
+        check(_gBroker.pubs[i].valid, "payload intact");
+    }
+}
+
+static void spill_test()
+{
+    CHIP_W25Q512_Host_Stat_t stat;
+    uint32_t first   = _gBroker.pubNum;
+    uint32_t erases  = 0;
+    bool writeOk     = true;
+
+    CHIP_W25Q512_Host_GetStat(&stat);
+    erases = stat.erases;
+
+    // 第一条挂起，后面的消息写满内存队列后溢出到QFS
+    _gBroker.ackLeft = 0;
+    check(write_seq(100, 1), "write seq 100");
+    check(poll_until(ack_pending, 2000), "seq 100 published");
+    for (uint32_t seq = 101; seq < 160; seq++) {
+        writeOk = write_seq(seq, 1) && writeOk;
+        poll_ms(1);
+    }
+    check(writeOk, "all spilled writes accepted");
+    check(poll_until(qfs_has_sector, 3000), "spill reached the flash");
+    CHIP_W25Q512_Host_GetStat(&stat);
+    check(stat.erases > erases, "QFS sector written");
+
+    // 应答恢复后按顺序每条发布一次
+    _gBroker.ackLeft = -1;
+    {
+        char ack[48];
+        snprintf(ack, sizeof(ack), "+QMTPUBEX: 0,%u,0", _gBroker.pubs[first].msgId);
+        at_host_reply(ack);
+    }
+    _gWantPubs = first + 60;
+    check(poll_until(pubs_reached, 10000), "spilled messages published");
+    poll_ms(300);
+    check(_gBroker.pubNum == first + 60 && pubs_in_order(first, 100, 60), "spilled messages in order, once each");
+    check(CHIP_W25Q512_QFS_is_empty(), "QFS drained");
+}
+
+// Flash中的QFS首部
+static void read_header(QFSHeader_t *pHeader)
+{
+    CHIP_W25Q512_read(QFS_HEADER_SECTOR * W25Q512_SECTOR_SIZE, (uint8_t *)pHeader, sizeof(QFSHeader_t));
+}
+
+/**
+ * @brief 首部写入Flash时的状态就是掉电恢复的状态，等首部写入、和内存中的队列一致、读位置在扇区中时退出。
+ *
+ */
+static bool header_flushed()
+{
+    static QFSHeader_t snapshot;
+    static bool hasSnapshot = false;
+    QFSHeader_t flash;
+
+    read_header(&flash);
+    if (!hasSnapshot) {
+        snapshot    = flash;
+        hasSnapshot = true;
+        return false;
+    }
+    return memcmp(flash.flag, "QFS", 4) == 0 && memcmp(&flash, &snapshot, sizeof(flash)) != 0 &&
+           flash.font_sec_numb != flash.rear_sec_numb &&
+           QFS_DATA_SECTOR(flash.font_sec_numb) * W25Q512_SECTOR_SIZE == CHIP_W25Q512_QFS_get_font_address() &&
+           QFS_DATA_SECTOR(flash.rear_sec_numb) * W25Q512_SECTOR_SIZE == CHIP_W25Q512_QFS_get_rear_address();
+}
+
+static void power_cut_test()
+{
+    uint32_t seq = 200;
+    bool writeOk = true;
+    bool flushed = false;
+    uint32_t start;
+
+    header_flushed();
+    _gBroker.ackLeft = 0;
+    check(write_seq(seq++, 1), "write seq 200");
+    check(poll_until(ack_pending, 2000), "seq 200 published");
+    while (seq < 290) {
+        writeOk = write_seq(seq++, 1) && writeOk;
+        poll_ms(1);
+    }
+    check(writeOk, "writes before power cut accepted");
+
+    // 再发布8条，内存队列从QFS中读回几条，读位置停在溢出的第一个扇区中，
+    // 这个扇区开头是spill_test最后从写入缓存直接读出的部分，QFS填充了0xFF
+    {
+        char ack[48];
+        _gBroker.ackLeft = 8;
+        snprintf(ack, sizeof(ack), "+QMTPUBEX: 0,%u,0", _gBroker.pubs[_gBroker.pubNum - 1].msgId);
+        at_host_reply(ack);
+    }
+    // 首部最多每4s写一次，继续写入，等扇区写完后写入首部
+    start = HDL_CPU_Time_GetTick();
+    while (!(flushed = header_flushed()) && HDL_CPU_Time_GetTick() - start < 12000) {
+        writeOk = write_seq(seq++, 1) && writeOk;
+        poll_ms(50);
+    }
+    check(writeOk, "writes while waiting for the header accepted");
+    check(flushed, "QFS header flushed with the queue mid-way");
+    ULOG_INFO("[MQTT Test] power cut after seq %u, %u published", seq - 1, _gBroker.pubNum);
+}
+
+/**
+ * @brief 按记录格式解析掉电前QFS队列中的记录，扇区开头的0xFF是QFS的填充，记录之后到扇区结束是填充。
+ *
+ * @return uint32_t 记录数
+ */
+static uint32_t parse_flash(const QFSHeader_t *pHeader)
+{
+    uint32_t num = 0;
+    uint32_t off = 0;
+    uint32_t len = 0;
+    uint16_t crc = 0;
+    bool padOk   = true;
+
+    for (uint32_t sec = pHeader->font_sec_numb; sec != pHeader->rear_sec_numb; sec = (sec + 1) % QFS_DATA_SECTORS) {
+        CHIP_W25Q512_read(QFS_DATA_SECTOR(sec) * W25Q512_SECTOR_SIZE, _gSector, W25Q512_SECTOR_SIZE);
+        off = 0;
+        while (off < W25Q512_SECTOR_SIZE && _gSector[off] == 0xFF) {
+            off++;
+        }
+        while (off + RECORD_HEAD_SIZE <= W25Q512_SECTOR_SIZE && _gSector[off] == RECORD_MAGIC) {
+            len = _gSector[off + 3] | (_gSector[off + 4] << 8);
+            if (off + RECORD_SIZE(len) > W25Q512_SECTOR_SIZE) {
+                break;
+            }
+            crc = CRC16_Modbus(_gSector + off, RECORD_HEAD_SIZE + len);
+            check(_gSector[off + RECORD_HEAD_SIZE + len] == (uint8_t)(crc >> 8) &&
+                      _gSector[off + RECORD_HEAD_SIZE + len + 1] == (uint8_t)crc,
+                  "record CRC in flash");
+            check(num < MAX_PUBS && payload_check(_gSector + off + RECORD_HEAD_SIZE, len, &_gExpect[num]),
+                  "record payload in flash");
+            num++;
+            off += RECORD_SIZE(len);
+        }
+        for (; off < W25Q512_SECTOR_SIZE; off++) {
+            padOk = padOk && _gSector[off] == 0xFF;
+        }
+    }
+    check(padOk, "sector tails are padding");
+    return num;
+}
+
+static void resume_test()
+{
+    QFSHeader_t header;
+    uint32_t num  = 0;
+    bool erased   = true;
+    bool inOrder  = true;
+
+    CHIP_W25Q512_Init();
+    // 首部在QFS自己的扇区中，物理扇区0没有被写过
+    read_header(&header);
+    check(memcmp(header.flag, "QFS", 4) == 0, "QFS header in its own sector");
+    CHIP_W25Q512_read(0, _gSector, W25Q512_SECTOR_SIZE);
+    for (uint32_t i = 0; i < W25Q512_SECTOR_SIZE; i++) {
+        erased = erased && _gSector[i] == 0xFF;
+    }
+    check(erased, "sector 0 untouched");
+
+    num = parse_flash(&header);
+    ULOG_INFO("[MQTT Test] QFS font %u poped %u rear %u, %u records, first seq %u", header.font_sec_numb,
+              header.font_sec_poped, header.rear_sec_numb, num, num > 0 ? _gExpect[0] : 0);
+    check(num > 0, "records survived the power cut");
+    for (uint32_t i = 1; i < num; i++) {
+        inOrder = inOrder && _gExpect[i] == _gExpect[i - 1] + 1;
+    }
+    check(inOrder, "records in flash are contiguous");
+
+    // 连接前写入的新消息排在恢复的消息之后
+    _gBroker.ackLeft = -1;
+    mqtt_start();
+    for (uint32_t i = 0; i < RESUME_NEW; i++) {
+        check(write_seq(RESUME_SEQ + i, 1), "write after resume");
+    }
+    _gWantPubs = num + RESUME_NEW;
+    check(poll_until(pubs_reached, 20000), "recovered messages published");
+    poll_ms(300);
+    if (num > 0) {
+        check(pubs_in_order(0, _gExpect[0], num), "recovered from the first record of the font sector");
+    }
+    check(_gBroker.pubNum == num + RESUME_NEW && pubs_in_order(num, RESUME_SEQ, RESUME_NEW),
+          "new messages after the recovered ones");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = getenv("RTU_HOST_FLASH");
+    bool resume      = argc > 1 && strcmp(argv[1], "resume") == 0;
+
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+
+    if (resume) {
+        resume_test();
+    } else {
+        // 从空白的Flash开始
+        if (path != NULL && path[0] != '\0') {
+            unlink(path);
+        }
+        connect_test();
+        topic_test();
+        ack_test();
+        spill_test();
+        power_cut_test();
+    }
+    ULOG_INFO("[MQTT Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt == 0 ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file BFL_FileVerify_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上用SD卡模型和FatFs运行BFL/BFL_FileVerify_test.c，读命令数和总线时间由SD卡模型统计。
+ * 镜像文件由RTU_HOST_SD指定，每次运行重新格式化。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "BFL_FileVerify_test.h"
+#include "app_fatfs.h"
+#include "SD_Card_host.h"
+#include "HDL_Host.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+static uint8_t _gWork[_MAX_SS];
+
+static void sd_reset(void)
+{
+    SD_Host_ResetStat();
+    HDL_Host_SPI_ResetStat(SPI_1);
+}
+
+static uint64_t sd_bus_ns(void)
+{
+    HDL_Host_SPI_Stat_t spi;
+    HDL_Host_SPI_GetStat(SPI_1, &spi);
+    return spi.busNs;
+}
+
+static uint32_t sd_read_cmds(void)
+{
+    SD_Host_Stat_t sd;
+    SD_Host_GetStat(&sd);
+    return sd.cmdCount[17] + sd.cmdCount[18];
+}
+
+static const BFL_FileVerify_TestHooks_t _gHooks = {sd_reset, sd_bus_ns, sd_read_cmds};
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    if (!SD_Host_Attach()) {
+        return 1;
+    }
+    // 和目标板一样，0:盘是W25Q512（这里只连接驱动、不挂载），SD卡是1:盘
+    MX_FATFS_Init();
+    SD_Card_FatFs_Init();
+    // 每次从空的文件系统开始
+    if (f_mkfs("1:", FM_ANY, 0, _gWork, sizeof(_gWork)) != FR_OK) {
+        ULOG_ERROR("[FileVerify Test] format failed");
+        return 1;
+    }
+    SD_Card_FatFs_DeInit();
+    SD_Card_FatFs_Init();
+    if (!SD_Card_Fs_IsMounted()) {
+        ULOG_ERROR("[FileVerify Test] mount failed");
+        return 1;
+    }
+    return BFL_FileVerify_test(&_gHooks) == 0 ? 0 : 1;
+}
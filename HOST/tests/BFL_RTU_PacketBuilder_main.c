@@ -0,0 +1,28 @@
+/**
+ * @file BFL_RTU_PacketBuilder_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行APP/BFL_RTU_PacketBuilder_test.c。测试不发送数据，4G接口只需要能链接。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "BFL_RTU_PacketBuilder_test.h"
+#include "BFL_4G.h"
+
+uint32_t BFL_4G_TCP_Write(int sockid, uint8_t *writeBuf, uint32_t uLen)
+{
+    return 0;
+}
+
+uint32_t BFL_4G_TCP_Writeable(int sockid)
+{
+    return 0;
+}
+
+int main()
+{
+    return BFL_RTU_PacketBuilder_test();
+}
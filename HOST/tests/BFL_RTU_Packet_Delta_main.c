@@ -0,0 +1,17 @@
+/**
+ * @file BFL_RTU_Packet_Delta_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行APP/BFL_RTU_Packet_Delta_test.c，返回值为失败的用例数。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "BFL_RTU_Packet_Delta_test.h"
+
+int main()
+{
+    return BFL_RTU_Packet_Delta_test();
+}
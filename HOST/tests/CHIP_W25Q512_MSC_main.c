@@ -0,0 +1,48 @@
+/**
+ * @file CHIP_W25Q512_MSC_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上用W25Q512模型运行CHIP/CHIP_W25Q512_MSC_test.c，模型提供时间、统计和故障注入。
+ * Flash镜像由RTU_HOST_FLASH指定。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "CHIP_W25Q512_MSC_test.h"
+#include "CHIP_W25Q512_host.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+static void flash_get_stat(CHIP_W25Q512_MSC_TestStat_t *pStat)
+{
+    CHIP_W25Q512_Host_Stat_t stat;
+
+    CHIP_W25Q512_Host_GetStat(&stat);
+    pStat->erases       = stat.erases;
+    pStat->pagePrograms = stat.pagePrograms;
+    pStat->waitNs       = stat.waitNs;
+    pStat->nowNs        = stat.nowNs;
+}
+
+static const CHIP_W25Q512_MSC_TestHooks_t _gHooks = {
+    .reset_stat = CHIP_W25Q512_Host_ResetStat,
+    .get_stat   = flash_get_stat,
+    .elapse     = CHIP_W25Q512_Host_Elapse,
+    .fail_ops   = CHIP_W25Q512_Host_FailOps,
+    .programNs  = W25Q512_HOST_PROGRAM_NS,
+    .eraseNs    = W25Q512_HOST_ERASE_NS,
+};
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    if (CHIP_W25Q512_Init() != 0) {
+        return 1;
+    }
+    return CHIP_W25Q512_MSC_test(&_gHooks) == 0 ? 0 : 1;
+}
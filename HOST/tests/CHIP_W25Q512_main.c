@@ -0,0 +1,35 @@
+/**
+ * @file CHIP_W25Q512_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行CHIP/CHIP_W25Q512_test.c的读写检查和日志分区测试，Flash镜像由RTU_HOST_FLASH指定。
+ * 共用测试之后再检查Flash模型的计数：读取确实等待过日志分区的擦除、编程，芯片忙时没有发出读取和写入。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "CHIP_W25Q512_test.h"
+#include "HDL_CPU_Time.h"
+#include "CHIP_W25Q512_host.h"
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    CHIP_W25Q512_Init();
+    CHIP_W25Q512_io_check(0);
+    CHIP_W25Q512_sector_io_check();
+    CHIP_W25Q512_LOG_test();
+
+    CHIP_W25Q512_Host_Stat_t stat;
+    CHIP_W25Q512_Host_ResetStat();
+    CHIP_W25Q512_LOG_share_test();
+    CHIP_W25Q512_Host_GetStat(&stat);
+    Debug_Printf("[LOG Share Test]: busy waits:%u, busy violations:%u\r\n", stat.busyWaits, stat.busyViolations);
+    if (stat.busyWaits == 0 || stat.busyViolations != 0) {
+        Debug_Printf("[LOG Share Test]: flash model fail\r\n");
+    }
+    return 0;
+}
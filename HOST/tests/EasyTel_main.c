@@ -0,0 +1,23 @@
+/**
+ * @file EasyTel_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行3rdparty/EasyTel/src/EasyTel_test.c的仿真，需要定义SIMPLEDPP_SIMULATION。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "EasyTel_test.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    return EasyTel_test() == 0 ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file HDL_RTC_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行HDL/HDL_RTC_test.c的闰年测试，从2044-02-28 23:59:57走过2月29日。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "HDL_RTC_test.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    return HDL_RTC_leap_year_test() == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+/**
+ * @file base64_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行LIB/base64_test.c，吞吐量测试的数据按主机的内存和速度改大。
+ * @version 0.1
+ * @date 2024-01-06
+ * @last modified 2024-01-06
+ *
+ * @copyright Copyright (c) 2024 Liu Yuanlin Personal.
+ *
+ */
+#include "base64_test.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    return base64_stream_test() == 0 ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+/**
+ * @file circular_array_queu_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行LIB/circular_array_queu_test.c。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+int circular_array_queu_test();
+
+int main()
+{
+    return circular_array_queu_test();
+}
@@ -0,0 +1,18 @@
+/**
+ * @file cooperate_scheduler_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行LIB/cooperate_scheduler_test.c的调度仿真，需要定义COOPERATE_SCHEDULER_SIMULATION。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "cooperate_scheduler_test.h"
+
+int main()
+{
+    cooperate_scheduler_simulation();
+    return 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file dlog_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行BFL/dlog_test.c，返回值为错误数。
+ * 设置了环境变量RTU_HOST_DLOG时把输出的字节流和一行文本写入该文件，用tools/dlog_decode.py按本程序的ELF解析，
+ * 程序需要按非PIE链接，格式字符串的地址才不超过32位。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "dlog_test.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+int main()
+{
+    const char *path   = getenv("RTU_HOST_DLOG");
+    const uint8_t *buf = NULL;
+    uint32_t len       = 0;
+    uint32_t error     = 0;
+    FILE *fp           = NULL;
+
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    error = dlog_test();
+
+    if (path != NULL) {
+        buf = dlog_test_capture(&len);
+        fp  = fopen(path, "wb");
+        if (fp == NULL) {
+            printf("open %s failed\r\n", path);
+            return 1;
+        }
+        // 二进制记录和文本混在一起，解析时文本原样输出
+        fputs("text before records\n", fp);
+        fwrite(buf, 1, len, fp);
+        fputs("text after records\n", fp);
+        fclose(fp);
+    }
+    return error == 0 ? 0 : 1;
+}
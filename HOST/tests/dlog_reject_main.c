@@ -0,0 +1,32 @@
+/**
+ * @file dlog_reject_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief DLOG_*宏的编译期检查：DLOG_REJECT_CASE为1、2、3时分别传入指针、64位整数、浮点数，应该编译失败。
+ * 只在ctest中单独编译，不属于默认目标。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "dlog.h"
+
+int main()
+{
+    static const char str[] = "str";
+    uint64_t u64            = 1;
+    float f                 = 1.0f;
+
+    (void)str;
+    (void)u64;
+    (void)f;
+#if DLOG_REJECT_CASE == 1
+    DLOG_INFO("%s", str);
+#elif DLOG_REJECT_CASE == 2
+    DLOG_INFO("%u", u64);
+#elif DLOG_REJECT_CASE == 3
+    DLOG_INFO("%f", f);
+#endif
+    return 0;
+}
@@ -0,0 +1,23 @@
+/**
+ * @file mtime_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行LIB/mtime_test.c，返回值为错误数。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "mtime_test.h"
+#include "HDL_CPU_Time.h"
+
+int main()
+{
+    uint32_t error = 0;
+
+    HDL_CPU_Time_Init();
+    error = mtime_round_trip_test();
+    mtime_benchmark();
+    return error == 0 ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file scheduler_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行BFL/scheduler_test.c的调度正确性测试和主循环频率测试，SCHEDULER_TASK_MAX_NUM定义为1000。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "scheduler_test.h"
+#include "HDL_Uart.h"
+
+int main()
+{
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    scheduler_check_test();
+    scheduler_benchmark_test();
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file sdcard_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上用SD卡命令模型测试3rdparty/sdcard的SPI驱动：初始化、单块和多块读写、吞吐量测试，
+ * 再用模型的命令统计检查多块读写的命令序列：多块读为一条CMD18加CMD12，多块写为ACMD23预擦除加一条CMD25，
+ * 数据块由DMA搬运，出错后片选释放、卡回到空闲状态，多块写中途出错时由ACMD22得到实际写入的块数。
+ * 镜像文件由RTU_HOST_SD指定。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "./sdcard/sdcard_test.h"
+#include "./sdcard/bsp_spi_sdcard.h"
+#include "SD_Card_host.h"
+#include "HDL_Host.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+#define PROTOCOL_SECTOR 100
+#define PROTOCOL_BLOCKS 64
+
+static uint8_t _gTx[PROTOCOL_BLOCKS * SD_BLOCKSIZE];
+static uint8_t _gRx[PROTOCOL_BLOCKS * SD_BLOCKSIZE];
+static uint32_t _gErrorCnt = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[SD Host] check failed: %s", what);
+    }
+}
+
+static void protocol_test()
+{
+    SD_Host_Stat_t stat;
+    HDL_Host_SPI_Stat_t spi;
+    uint64_t addr = (uint64_t)PROTOCOL_SECTOR * SD_BLOCKSIZE;
+
+    for (uint32_t i = 0; i < sizeof(_gTx); i++) {
+        _gTx[i] = (uint8_t)(i * 7 + i / SD_BLOCKSIZE);
+    }
+
+    // 多块写：ACMD23预擦除，一条CMD25
+    SD_Host_ResetStat();
+    HDL_Host_SPI_ResetStat(SPI_1);
+    check(SD_WriteMultiBlocks(_gTx, addr, SD_BLOCKSIZE, PROTOCOL_BLOCKS) == SD_RESPONSE_NO_ERROR, "multi write");
+    SD_Host_GetStat(&stat);
+    HDL_Host_SPI_GetStat(SPI_1, &spi);
+    check(stat.cmdCount[SD_CMD_WRITE_MULT_BLOCK] == 1, "one CMD25");
+    check(stat.cmdCount[SD_CMD_WRITE_SINGLE_BLOCK] == 0, "no CMD24");
+    check(stat.acmdCount[SD_ACMD_SET_WR_BLK_ERASE_COUNT] == 1, "one ACMD23");
+    check(stat.preEraseBlocks == PROTOCOL_BLOCKS, "ACMD23 block count");
+    check(stat.blocksWritten == PROTOCOL_BLOCKS, "blocks written");
+    check(spi.dmaBytes == sizeof(_gTx), "write payload by DMA");
+    ULOG_INFO("[SD Host] write %u blocks: %u SPI transfers, bus %u KB/s", PROTOCOL_BLOCKS, spi.transfers,
+              (uint32_t)(spi.bytes * 1000000000ULL / 1024 / spi.busNs));
+
+    // 多块读：一条CMD18，CMD12停止
+    SD_Host_ResetStat();
+    HDL_Host_SPI_ResetStat(SPI_1);
+    memset(_gRx, 0, sizeof(_gRx));
+    check(SD_ReadMultiBlocks(_gRx, addr, SD_BLOCKSIZE, PROTOCOL_BLOCKS) == SD_RESPONSE_NO_ERROR, "multi read");
+    SD_Host_GetStat(&stat);
+    HDL_Host_SPI_GetStat(SPI_1, &spi);
+    check(memcmp(_gTx, _gRx, sizeof(_gTx)) == 0, "read back data");
+    check(stat.cmdCount[SD_CMD_READ_MULT_BLOCK] == 1, "one CMD18");
+    check(stat.cmdCount[SD_CMD_STOP_TRANSMISSION] == 1, "one CMD12");
+    check(stat.cmdCount[SD_CMD_READ_SINGLE_BLOCK] == 0, "no CMD17");
+    check(stat.blocksRead == PROTOCOL_BLOCKS, "blocks read");
+    check(spi.dmaBytes == sizeof(_gRx), "read payload by DMA");
+    ULOG_INFO("[SD Host] read %u blocks: %u SPI transfers, bus %u KB/s", PROTOCOL_BLOCKS, spi.transfers,
+              (uint32_t)(spi.bytes * 1000000000ULL / 1024 / spi.busNs));
+
+    // 只读写一块时用CMD17/CMD24
+    SD_Host_ResetStat();
+    check(SD_WriteMultiBlocks(_gTx, addr, SD_BLOCKSIZE, 1) == SD_RESPONSE_NO_ERROR, "single write");
+    check(SD_ReadMultiBlocks(_gRx, addr, SD_BLOCKSIZE, 1) == SD_RESPONSE_NO_ERROR, "single read");
+    SD_Host_GetStat(&stat);
+    check(stat.cmdCount[SD_CMD_WRITE_SINGLE_BLOCK] == 1 && stat.cmdCount[SD_CMD_WRITE_MULT_BLOCK] == 0, "CMD24 for one block");
+    check(stat.cmdCount[SD_CMD_READ_SINGLE_BLOCK] == 1 && stat.cmdCount[SD_CMD_READ_MULT_BLOCK] == 0, "CMD17 for one block");
+    check(stat.acmdCount[SD_ACMD_SET_WR_BLK_ERASE_COUNT] == 0, "no ACMD23 for one block");
+
+    // 多块写中途写错误：停止令牌结束，CMD13清除错误状态，ACMD22查询实际写入的块数
+    addr = (uint64_t)PROTOCOL_SECTOR * SD_BLOCKSIZE;
+    SD_Host_ResetStat();
+    SD_Host_FailWrite(10);
+    check(SD_WriteMultiBlocks(_gTx, addr, SD_BLOCKSIZE, PROTOCOL_BLOCKS) != SD_RESPONSE_NO_ERROR, "multi write fails on write error");
+    SD_Host_GetStat(&stat);
+    check(stat.cmdCount[SD_CMD_SEND_STATUS] == 1 && stat.acmdCount[SD_ACMD_SEND_NUM_WR_BLOCKS] == 1, "CMD13 and ACMD22 after failed CMD25");
+    check(SD_GetWrittenBlocks() == 10, "written blocks reported by ACMD22");
+    check(LL_GPIO_IsOutputPinSet(SD_CS_GPIO_PORT, SD_CS_PIN), "CS released after write error");
+    check(SD_WriteMultiBlocks(_gTx, addr, SD_BLOCKSIZE, PROTOCOL_BLOCKS) == SD_RESPONSE_NO_ERROR, "multi write after error");
+    check(SD_GetWrittenBlocks() == PROTOCOL_BLOCKS, "all blocks written");
+    SD_Host_GetStat(&stat);
+    check(stat.acmdCount[SD_ACMD_SEND_NUM_WR_BLOCKS] == 1, "no ACMD22 after successful CMD25");
+
+    // 读到卡的末尾之后出错，片选释放，卡仍然可以访问
+    addr = SD_HOST_CAPACITY - 2 * SD_BLOCKSIZE;
+    check(SD_ReadMultiBlocks(_gRx, addr, SD_BLOCKSIZE, 4) != SD_RESPONSE_NO_ERROR, "read past end fails");
+    check(LL_GPIO_IsOutputPinSet(SD_CS_GPIO_PORT, SD_CS_PIN), "CS released after error");
+    check(SD_ReadMultiBlocks(_gRx, (uint64_t)PROTOCOL_SECTOR * SD_BLOCKSIZE, SD_BLOCKSIZE, 2) == SD_RESPONSE_NO_ERROR, "read after error");
+    check(memcmp(_gTx, _gRx, 2 * SD_BLOCKSIZE) == 0, "data after error");
+
+    SD_Host_GetStat(&stat);
+    check(stat.protocolErrors == 0, "no protocol errors");
+    check(SD_GetClock() <= 25000000U, "full speed clock within 25MHz");
+}
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    if (!SD_Host_Attach()) {
+        return 1;
+    }
+    if (SD_Card_Init() != SD_RESPONSE_NO_ERROR) {
+        ULOG_ERROR("[SD Host] init failed");
+        return 1;
+    }
+    SD_Test();
+    protocol_test();
+    SD_SpeedTest();
+    ULOG_INFO("[SD Host] protocol: %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt == 0 ? 0 : 1;
+}
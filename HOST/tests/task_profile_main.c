@@ -0,0 +1,25 @@
+/**
+ * @file task_profile_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行LIB/task_profile_test.c和BFL/scheduler_test.c中的执行时间统计检查，
+ * scheduler和cooperate_scheduler使用虚拟时钟。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "task_profile_test.h"
+#include "scheduler_test.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    return task_profile_test() + scheduler_profile_check() == 0 ? 0 : 1;
+}
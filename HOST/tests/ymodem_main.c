@@ -0,0 +1,69 @@
+/**
+ * @file ymodem_main.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 主机上运行BFL/ymodem_test.c，需要定义YMODEM_SIMULATION。存储时间取W25Q512模型的时间和SD卡的SPI总线时间。
+ * W25Q512镜像文件由RTU_HOST_FLASH、SD卡镜像由RTU_HOST_SD指定，每次运行重新格式化。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "ymodem_test.h"
+#include "ff.h"
+#include "app_fatfs.h"
+#include "CHIP_W25Q512_host.h"
+#include "CHIP_W25Q512_QueueFileSystem.h"
+#include "SD_Card_host.h"
+#include "HDL_Host.h"
+#include "HDL_CPU_Time.h"
+#include "HDL_Uart.h"
+#include "log.h"
+
+static uint8_t _gWork[_MAX_SS];
+static FATFS _gFs;
+
+static uint64_t flash_ns(void)
+{
+    CHIP_W25Q512_Host_Stat_t w25q;
+
+    CHIP_W25Q512_Host_GetStat(&w25q);
+    return w25q.nowNs;
+}
+
+static uint64_t sd_ns(void)
+{
+    HDL_Host_SPI_Stat_t spi;
+
+    HDL_Host_SPI_GetStat(SPI_1, &spi);
+    return spi.busNs;
+}
+
+static const Ymodem_TestHooks_t _gHooks = {flash_ns, sd_ns, CHIP_W25Q512_Host_Elapse};
+
+int main()
+{
+    HDL_CPU_Time_Init();
+    Uart_Init(COM1, 115200, LL_USART_DATAWIDTH_8B, LL_USART_STOPBITS_1, LL_USART_PARITY_NONE);
+    ulog_init_user();
+    MX_FATFS_Init();
+    // 每次从空的文件系统开始
+    if (f_mkfs(YMODEM_DRIVE, FM_ANY, 0, _gWork, sizeof(_gWork)) != FR_OK || f_mount(&_gFs, YMODEM_DRIVE, 1) != FR_OK) {
+        ULOG_ERROR("[Ymodem Test] format failed");
+        return 1;
+    }
+    // 发送的文件放在SD卡上
+    if (!SD_Host_Attach()) {
+        return 1;
+    }
+    SD_Card_FatFs_Init();
+    if (f_mkfs("1:", FM_ANY, 0, _gWork, sizeof(_gWork)) != FR_OK) {
+        ULOG_ERROR("[Ymodem Test] format sd failed");
+        return 1;
+    }
+    SD_Card_FatFs_DeInit();
+    SD_Card_FatFs_Init();
+    CHIP_W25Q512_QFS_init();
+    return ymodem_test(&_gHooks) == 0 ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file ulog_host.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 3rdparty/ulog没有检出时主机编译使用的ulog实现，行为和原来的ulog相同：
+ * 格式化一次，交给所有阈值不高于这条日志等级的订阅者。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "ulog.h"
+
+typedef struct tagUlogSubscriber_t {
+    ulog_function_t fn;
+    ulog_level_t threshold;
+} UlogSubscriber_t;
+
+static UlogSubscriber_t ulog_subscribers[ULOG_MAX_SUBSCRIBERS];
+static char ulog_message_buffer[ULOG_MAX_MESSAGE_LENGTH];
+
+void ulog_init(void)
+{
+    memset(ulog_subscribers, 0, sizeof(ulog_subscribers));
+}
+
+/**
+ * @brief 订阅日志，已经订阅过时只更新阈值。
+ *
+ * @param fn
+ * @param threshold 低于这个等级的日志不交给fn。
+ * @return ulog_err_t
+ */
+ulog_err_t ulog_subscribe(ulog_function_t fn, ulog_level_t threshold)
+{
+    int available = -1;
+
+    for (int i = 0; i < ULOG_MAX_SUBSCRIBERS; i++) {
+        if (ulog_subscribers[i].fn == fn) {
+            ulog_subscribers[i].threshold = threshold;
+            return ULOG_ERR_NONE;
+        }
+        if (ulog_subscribers[i].fn == NULL && available < 0) {
+            available = i;
+        }
+    }
+    if (available < 0) {
+        return ULOG_ERR_SUBSCRIBERS_EXCEEDED;
+    }
+    ulog_subscribers[available].fn        = fn;
+    ulog_subscribers[available].threshold = threshold;
+    return ULOG_ERR_NONE;
+}
+
+ulog_err_t ulog_unsubscribe(ulog_function_t fn)
+{
+    for (int i = 0; i < ULOG_MAX_SUBSCRIBERS; i++) {
+        if (ulog_subscribers[i].fn == fn) {
+            ulog_subscribers[i].fn = NULL;
+            return ULOG_ERR_NONE;
+        }
+    }
+    return ULOG_ERR_NOT_SUBSCRIBED;
+}
+
+const char *ulog_level_name(ulog_level_t severity)
+{
+    switch (severity) {
+        case ULOG_TRACE_LEVEL:
+            return "TRACE";
+        case ULOG_DEBUG_LEVEL:
+            return "DEBUG";
+        case ULOG_INFO_LEVEL:
+            return "INFO";
+        case ULOG_WARNING_LEVEL:
+            return "WARNING";
+        case ULOG_ERROR_LEVEL:
+            return "ERROR";
+        case ULOG_CRITICAL_LEVEL:
+            return "CRITICAL";
+        case ULOG_ALWAYS_LEVEL:
+            return "ALWAYS";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+void ulog_message(ulog_level_t severity, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(ulog_message_buffer, ULOG_MAX_MESSAGE_LENGTH, fmt, ap);
+    va_end(ap);
+
+    for (int i = 0; i < ULOG_MAX_SUBSCRIBERS; i++) {
+        if (ulog_subscribers[i].fn != NULL && severity >= ulog_subscribers[i].threshold) {
+            ulog_subscribers[i].fn(severity, ulog_message_buffer);
+        }
+    }
+}
@@ -17,132 +17,325 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
-static const char base64_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const uint8_t base64_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-int base64_encode(const uint8_t *restrict src, size_t srclen, char *restrict out, size_t out_buf_capacity, size_t *outlen)
+// 解码表：0-63是字符的值，BASE64_DEC_SPACE是可以跳过的空白，BASE64_DEC_PAD是'='，0xFF是非法字符。
+// 不是0-63的值都有最高位，一组字符的值或在一起就能判断能不能直接解码。
+#define BASE64_DEC_SPACE 0x80
+#define BASE64_DEC_PAD   0x81
+static const uint8_t base64_dec_table[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x80, 0x80, 0xFF, 0xFF, 0x80, 0xFF, 0xFF, // 0-15
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 16-31
+    0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F, // 32-47
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0x81, 0xFF, 0xFF, // 48-63
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, // 64-79
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 80-95
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, // 96-111
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 112-127
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 128-143
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 144-159
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 160-175
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 176-191
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 192-207
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 208-223
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 224-239
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 240-255
+};
+
+// 按大端读写32位字，Cortex-M4可以不对齐访问，memcpy编译成一条LDR/STR
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define BASE64_BE32(x) (x)
+#elif defined(__GNUC__) || defined(__clang__)
+#define BASE64_BE32(x) __builtin_bswap32(x)
+#else
+#define BASE64_BE32(x) ((((x) & 0xFFU) << 24) | (((x) & 0xFF00U) << 8) | (((x) >> 8) & 0xFF00U) | ((x) >> 24))
+#endif
+
+static inline uint32_t base64_load_be32(const uint8_t *p)
 {
-    if (src == NULL || out == NULL || srclen == 0) {
-        return 1; // Failure due to invalid arguments
-    }
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return BASE64_BE32(w);
+}
 
-    size_t outlen_ = 4 * ((srclen + 2) / 3);   // Calculate the length of encoded string
-    if (outlen_ >= out_buf_capacity) return 1; // Output buffer is too small
-    if (outlen != NULL) {
-        *outlen = outlen_;
-    }
+static inline void base64_store_be32(uint8_t *p, uint32_t w)
+{
+    w = BASE64_BE32(w);
+    memcpy(p, &w, sizeof(w));
+}
 
-    size_t j = 0;
-    for (size_t i = 0; i < srclen;) {
-        uint32_t octet_a = i < srclen ? (uint8_t)src[i++] : 0;
-        uint32_t octet_b = i < srclen ? (uint8_t)src[i++] : 0;
-        uint32_t octet_c = i < srclen ? (uint8_t)src[i++] : 0;
+// 低24位编码成4个字符，第一个字符在最高字节
+static inline uint32_t base64_enc_group(uint32_t g)
+{
+    return ((uint32_t)base64_table[(g >> 18) & 0x3F] << 24) | ((uint32_t)base64_table[(g >> 12) & 0x3F] << 16) |
+           ((uint32_t)base64_table[(g >> 6) & 0x3F] << 8) | base64_table[g & 0x3F];
+}
 
-        uint32_t triple = (octet_a << 16) + (octet_b << 8) + octet_c;
+// 4个字符（第一个在最高字节）解码成24位，有不能直接解码的字符时置最高位
+static inline uint32_t base64_dec_group(uint32_t w)
+{
+    uint32_t a = base64_dec_table[w >> 24];
+    uint32_t b = base64_dec_table[(w >> 16) & 0xFF];
+    uint32_t c = base64_dec_table[(w >> 8) & 0xFF];
+    uint32_t d = base64_dec_table[w & 0xFF];
+    return ((a << 18) | (b << 12) | (c << 6) | d) | (((a | b | c | d) & 0x80) << 24);
+}
 
-        out[j++] = base64_table[(triple >> 18) & 0x3F];
-        out[j++] = base64_table[(triple >> 12) & 0x3F];
-        out[j++] = base64_table[(triple >> 6) & 0x3F];
-        out[j++] = base64_table[triple & 0x3F];
-    }
+// 暂存区交给write，没有全部写入时流出错
+static bool base64_flush(base64_stream_t *ctx)
+{
+    if (ctx->write == NULL || ctx->buf_len == 0) return true;
+    uint32_t written = ctx->write(ctx->arg, ctx->buf, (uint32_t)ctx->buf_len);
+    bool ok          = written == ctx->buf_len;
+    ctx->total += written;
+    ctx->buf_len = 0;
+    if (!ok) ctx->err = 1;
+    return ok;
+}
 
-    // Add padding
-    const int mod_table[] = {0, 2, 1};
-    size_t padding        = mod_table[srclen % 3];
-    for (size_t i = 0; i < padding; i++) {
-        out[outlen_ - 1 - i] = '=';
-    }
-    out[outlen_] = '\0';
-    return 0; // Success
+// 保证buf还有n个字节的空间，有write时先把暂存区交出去
+static bool base64_reserve(base64_stream_t *ctx, size_t n)
+{
+    if (ctx->err != 0) return false;
+    if (ctx->buf_capacity - ctx->buf_len >= n) return true;
+    if (ctx->write == NULL) return false;
+    return base64_flush(ctx) && ctx->buf_capacity >= n;
 }
 
-#if __STDC_VERSION__ >= 199901L
-#define SUPPORTS_C99
-#endif
+static void base64_stream_init(base64_stream_t *ctx, void *buf, size_t buf_capacity, base64_write_t write, void *arg)
+{
+    memset(ctx, 0, sizeof(base64_stream_t));
+    ctx->buf          = buf;
+    ctx->buf_capacity = buf == NULL ? 0 : buf_capacity;
+    ctx->write        = write;
+    ctx->arg          = arg;
+}
 
-#ifdef SUPPORTS_C99
-// 定义Base64解码表，将Base64编码字符映射为相应的值
-static const int base64_dec_table[256] = {
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, // 0-15: 无效字符
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, // 16-31: 无效字符
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63, // 32-47: 无效字符, '+' 解码为 62, '/' 解码为 63
-    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1, // 48-63: '0'-'9' 解码为 0-9, 以及 'A'-'Z' 解码为 52-61
-    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,           // 64-79: 'a'-'z' 解码为 0-25
-    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1, // 80-95: 'A'-'Z' 解码为 26-51
-    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, // 96-111: 'a'-'z' 解码为 27-51
-    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1, // 112-127: '0'-'9' 解码为 41-51, 其他字符无效
-    // 剩余字符都被标记为无效字符，用 -1 表示
-    // 这些字符包括特殊字符和非Base64字符
-};
-#else
-// 定义Base64解码表，将Base64编码字符映射为相应的值
-static const int base64_dec_table[256] = {
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, // 0-15: 无效字符
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, // 16-31: 无效字符
-    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63, // 32-47: 无效字符, '+' 解码为 62, '/' 解码为 63
-    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1, // 48-63: '0'-'9' 解码为 0-9, 以及 'A'-'Z' 解码为 52-61
-    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,           // 64-79: 'a'-'z' 解码为 0-25
-    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1, // 80-95: 'A'-'Z' 解码为 26-51
-    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, // 96-111: 'a'-'z' 解码为 27-51
-    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1, // 112-127: '0'-'9' 解码为 41-51, 其他字符无效
-    // 剩余字符都被标记为无效字符，用 -1 表示
-    // 这些字符包括特殊字符和非Base64字符
-};
-#endif
+void base64_enc_init(base64_stream_t *ctx, void *buf, size_t buf_capacity, base64_write_t write, void *arg)
+{
+    base64_stream_init(ctx, buf, buf_capacity, write, arg);
+}
 
-int base64_decode(const char *restrict src, uint8_t *restrict out, size_t out_buf_capacity, size_t *outlen)
+int base64_enc_update(base64_stream_t *ctx, const uint8_t *src, size_t len)
 {
-    if (src == NULL || out == NULL) {
-        return 1; // Failure due to invalid arguments
+    if (ctx == NULL || (src == NULL && len > 0)) return 2;
+    if (ctx->err != 0) return ctx->err;
+
+    // 先凑满上次剩下的一组
+    while (ctx->rem_len > 0 && len > 0) {
+        ctx->rem[ctx->rem_len++] = *src++;
+        len--;
+        if (ctx->rem_len == 3) {
+            if (!base64_reserve(ctx, 4)) return ctx->err = 1;
+            base64_store_be32(ctx->buf + ctx->buf_len,
+                              base64_enc_group(((uint32_t)ctx->rem[0] << 16) | ((uint32_t)ctx->rem[1] << 8) | ctx->rem[2]));
+            ctx->buf_len += 4;
+            ctx->rem_len = 0;
+        }
     }
 
-    size_t srclen                    = 0;
-    size_t srclen_without_whitespace = 0;
-    // Get Base64 string length without '\n' , '\r', '\t', ' '
-    const char *p_src                 = src;
-    const char *p_last_non_whitespace = NULL;
-    while (*p_src != '\0') {
-        if (*p_src != '\n' && *p_src != '\r' && *p_src != '\t' && *p_src != ' ') {
-            srclen_without_whitespace++;
-            p_last_non_whitespace = p_src;
+    // 每次4组：读3个字，写4个字。循环里只用局部变量，免得每次写输出后重新读ctx
+    while (len >= 12 && base64_reserve(ctx, 16)) {
+        size_t blocks = (ctx->buf_capacity - ctx->buf_len) / 16;
+        blocks        = blocks < len / 12 ? blocks : len / 12;
+        uint8_t *p    = ctx->buf + ctx->buf_len;
+        ctx->buf_len += blocks * 16;
+        len -= blocks * 12;
+        while (blocks-- > 0) {
+            uint32_t w0 = base64_load_be32(src);
+            uint32_t w1 = base64_load_be32(src + 4);
+            uint32_t w2 = base64_load_be32(src + 8);
+            base64_store_be32(p, base64_enc_group(w0 >> 8));
+            base64_store_be32(p + 4, base64_enc_group((w0 << 16) | (w1 >> 16)));
+            base64_store_be32(p + 8, base64_enc_group((w1 << 8) | (w2 >> 24)));
+            base64_store_be32(p + 12, base64_enc_group(w2));
+            p += 16;
+            src += 12;
         }
-        p_src++;
-        srclen++;
     }
 
-    if (srclen_without_whitespace % 4 != 0 || srclen_without_whitespace == 0) return 2; // Invalid input size
+    while (len >= 3) {
+        if (!base64_reserve(ctx, 4)) return ctx->err = 1;
+        base64_store_be32(ctx->buf + ctx->buf_len,
+                          base64_enc_group(((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2]));
+        ctx->buf_len += 4;
+        src += 3;
+        len -= 3;
+    }
+
+    while (len > 0) {
+        ctx->rem[ctx->rem_len++] = *src++;
+        len--;
+    }
+    return 0;
+}
+
+int base64_enc_finish(base64_stream_t *ctx, size_t *outlen)
+{
+    if (ctx == NULL) return 2;
+    if (ctx->err != 0) return ctx->err;
 
-    size_t outlen_ = srclen_without_whitespace / 4 * 3;
+    if (ctx->rem_len > 0) {
+        if (!base64_reserve(ctx, 4)) return ctx->err = 1;
+        uint32_t g = ((uint32_t)ctx->rem[0] << 16) | (ctx->rem_len > 1 ? ((uint32_t)ctx->rem[1] << 8) : 0);
+        uint32_t w = base64_enc_group(g);
+        w          = ctx->rem_len == 1 ? ((w & 0xFFFF0000UL) | ('=' << 8) | '=') : ((w & 0xFFFFFF00UL) | '=');
+        base64_store_be32(ctx->buf + ctx->buf_len, w);
+        ctx->buf_len += 4;
+        ctx->rem_len = 0;
+    }
 
-    if (*p_last_non_whitespace == '=') (outlen_)--;
-    if (*(p_last_non_whitespace - 1) == '=') (outlen_)--;
-    if (outlen_ >= out_buf_capacity) return 1; // Output buffer is too small
+    size_t n = ctx->total + ctx->buf_len;
+    if (ctx->write == NULL) {
+        if (ctx->buf_len < ctx->buf_capacity) ctx->buf[ctx->buf_len] = '\0';
+    } else if (!base64_flush(ctx)) {
+        return ctx->err;
+    }
     if (outlen != NULL) {
-        *outlen = outlen_;
+        *outlen = n;
     }
+    return 0;
+}
 
-    size_t j = 0;
-    for (size_t i = 0; i < srclen;) {
-        uint32_t sextet_a = 0, sextet_b = 0, sextet_c = 0, sextet_d = 0;
+void base64_dec_init(base64_stream_t *ctx, void *buf, size_t buf_capacity, base64_write_t write, void *arg)
+{
+    base64_stream_init(ctx, buf, buf_capacity, write, arg);
+}
 
-        while (src[i] == '\n' || src[i] == '\r' || src[i] == '\t' || src[i] == ' ') { i++; }
-        src[i] == '=' ? i++ : (sextet_a = base64_dec_table[src[i++]]);
+int base64_dec_update(base64_stream_t *ctx, const char *src, size_t len)
+{
+    const uint8_t *s = (const uint8_t *)src;
 
-        while (src[i] == '\n' || src[i] == '\r' || src[i] == '\t' || src[i] == ' ') { i++; }
-        src[i] == '=' ? i++ : (sextet_b = base64_dec_table[src[i++]]);
+    if (ctx == NULL || (src == NULL && len > 0)) return 2;
+    if (ctx->err != 0) return ctx->err;
 
-        while (src[i] == '\n' || src[i] == '\r' || src[i] == '\t' || src[i] == ' ') { i++; }
-        src[i] == '=' ? i++ : (sextet_c = base64_dec_table[src[i++]]);
+    while (len > 0) {
+        // 在组的边界上并且没有空白和填充时直接按组解码
+        if (ctx->acc_n == 0 && !ctx->done) {
+            // 每次4组：读4个字，写3个字，遇到空白或者填充停下
+            while (len >= 16 && base64_reserve(ctx, 12)) {
+                size_t blocks = (ctx->buf_capacity - ctx->buf_len) / 12;
+                blocks        = blocks < len / 16 ? blocks : len / 16;
+                uint8_t *p    = ctx->buf + ctx->buf_len;
+                uint8_t *end  = p + blocks * 12;
+                while (p < end) {
+                    uint32_t g0 = base64_dec_group(base64_load_be32(s));
+                    uint32_t g1 = base64_dec_group(base64_load_be32(s + 4));
+                    uint32_t g2 = base64_dec_group(base64_load_be32(s + 8));
+                    uint32_t g3 = base64_dec_group(base64_load_be32(s + 12));
+                    if ((g0 | g1 | g2 | g3) & 0x80000000UL) break;
+                    base64_store_be32(p, (g0 << 8) | (g1 >> 16));
+                    base64_store_be32(p + 4, (g1 << 16) | (g2 >> 8));
+                    base64_store_be32(p + 8, (g2 << 24) | g3);
+                    p += 12;
+                    s += 16;
+                }
+                size_t n = (size_t)(p - (ctx->buf + ctx->buf_len));
+                ctx->buf_len += n;
+                len -= n / 12 * 16;
+                if (p < end) break;
+            }
+            // 换行前不够4组的部分
+            while (len >= 4 && base64_reserve(ctx, 3)) {
+                uint32_t g = base64_dec_group(base64_load_be32(s));
+                if (g & 0x80000000UL) break;
+                uint8_t *p = ctx->buf + ctx->buf_len;
+                p[0]       = (uint8_t)(g >> 16);
+                p[1]       = (uint8_t)(g >> 8);
+                p[2]       = (uint8_t)g;
+                ctx->buf_len += 3;
+                s += 4;
+                len -= 4;
+            }
+            if (len == 0) break;
+        }
 
-        while (src[i] == '\n' || src[i] == '\r' || src[i] == '\t' || src[i] == ' ') { i++; }
-        src[i] == '=' ? i++ : (sextet_d = base64_dec_table[src[i++]]);
+        // 逐个字符处理空白、填充和跨update的组
+        uint8_t v = base64_dec_table[*s++];
+        len--;
+        if (v < 64) {
+            if (ctx->pad > 0 || ctx->done) return ctx->err = 2;
+            ctx->acc = (ctx->acc << 6) | v;
+            if (++ctx->acc_n == 4) {
+                if (!base64_reserve(ctx, 3)) return ctx->err = 1;
+                uint8_t *p = ctx->buf + ctx->buf_len;
+                p[0]       = (uint8_t)(ctx->acc >> 16);
+                p[1]       = (uint8_t)(ctx->acc >> 8);
+                p[2]       = (uint8_t)ctx->acc;
+                ctx->buf_len += 3;
+                ctx->acc_n = 0;
+                ctx->acc   = 0;
+            }
+        } else if (v == BASE64_DEC_PAD) {
+            // "xx=="或者"xxx="，填充之后只能有空白
+            if (ctx->done || ctx->acc_n < 2) return ctx->err = 2;
+            if (ctx->acc_n + ++ctx->pad == 4) {
+                uint8_t n = ctx->acc_n - 1;
+                if (!base64_reserve(ctx, n)) return ctx->err = 1;
+                uint32_t g = ctx->acc << (6 * ctx->pad);
+                ctx->buf[ctx->buf_len++] = (uint8_t)(g >> 16);
+                if (n > 1) ctx->buf[ctx->buf_len++] = (uint8_t)(g >> 8);
+                ctx->acc_n = 0;
+                ctx->acc   = 0;
+                ctx->pad   = 0;
+                ctx->done  = true;
+            }
+        } else if (v != BASE64_DEC_SPACE) {
+            return ctx->err = 2;
+        }
+    }
+    return 0;
+}
 
-        uint32_t triple = (sextet_a << 18) + (sextet_b << 12) + (sextet_c << 6) + sextet_d;
+int base64_dec_finish(base64_stream_t *ctx, size_t *outlen)
+{
+    if (ctx == NULL) return 2;
+    if (ctx->err != 0) return ctx->err;
+    if (ctx->acc_n != 0 || ctx->pad != 0) return ctx->err = 2;
 
-        if (j < outlen_) out[j++] = (triple >> 16) & 0xFF;
-        if (j < outlen_) out[j++] = (triple >> 8) & 0xFF;
-        if (j < outlen_) out[j++] = triple & 0xFF;
+    size_t n = ctx->total + ctx->buf_len;
+    if (!base64_flush(ctx)) return ctx->err;
+    if (outlen != NULL) {
+        *outlen = n;
     }
+    return 0;
+}
 
+int base64_encode(const uint8_t *restrict src, size_t srclen, char *restrict out, size_t out_buf_capacity, size_t *outlen)
+{
+    if (src == NULL || out == NULL || srclen == 0) {
+        return 1; // Failure due to invalid arguments
+    }
+
+    size_t outlen_ = BASE64_ENCODE_LEN(srclen); // Calculate the length of encoded string
+    if (outlen_ >= out_buf_capacity) return 1;  // Output buffer is too small
+    if (outlen != NULL) {
+        *outlen = outlen_;
+    }
+
+    base64_stream_t ctx;
+    base64_enc_init(&ctx, out, out_buf_capacity, NULL, NULL);
+    base64_enc_update(&ctx, src, srclen);
+    return base64_enc_finish(&ctx, NULL);
+}
+
+int base64_decode(const char *restrict src, uint8_t *restrict out, size_t out_buf_capacity, size_t *outlen)
+{
+    if (src == NULL || out == NULL || out_buf_capacity == 0) {
+        return 1; // Failure due to invalid arguments
+    }
+
+    // 和原来一样给'\0'留一个字节
+    base64_stream_t ctx;
+    size_t outlen_ = 0;
+    base64_dec_init(&ctx, out, out_buf_capacity - 1, NULL, NULL);
+    int ret = base64_dec_update(&ctx, src, strlen(src));
+    if (ret == 0) ret = base64_dec_finish(&ctx, &outlen_);
+    if (ret != 0) return ret;
+    if (outlen_ == 0 && !ctx.done) return 2; // Invalid input size
+    if (outlen != NULL) {
+        *outlen = outlen_;
+    }
     return 0; // Success
 }
 
@@ -47,6 +47,111 @@ int base64_encode(const uint8_t *restrict src, size_t srclen, char *restrict out
  * @return int 0 success, 1 output buffer is too small, 2 invalid argument.
  */
 int base64_decode(const char *restrict src, uint8_t *restrict out, size_t out_buf_capacity, size_t *outlen);
+
+/**
+ * @brief 编码len个字节后的base64字符数（带'='填充，不含'\0'）。
+ */
+#define BASE64_ENCODE_LEN(len) ((((len) + 2) / 3) * 4)
+
+/**
+ * @brief 解码len个base64字符（不含空白）后最多的字节数。
+ */
+#define BASE64_DECODE_LEN(len) (((len) / 4) * 3)
+
+/**
+ * @brief 流式编解码的输出函数，例如串口或者4G模块发送环形缓冲区的写入函数。
+ * 必须把len个字节全部接收，返回值小于len时流出错。
+ *
+ * @param arg base64_enc_init/base64_dec_init传入的参数。
+ * @param data
+ * @param len
+ * @return uint32_t 写入的字节数。
+ */
+typedef uint32_t (*base64_write_t)(void *arg, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief 流式编码的上下文。
+ * 输出有两种方式：
+ * write为NULL时，输出直接写到buf，buf写满返回1；
+ * write不为NULL时，buf是暂存区，放不下下一组时交给write，适合直接写入串口发送队列，例如：
+ *   static uint32_t uart_sink(void *arg, const uint8_t *data, uint32_t len)
+ *   { return Uart_Write((COMID_t)(uintptr_t)arg, data, len); }
+ *   base64_enc_init(&ctx, stage, sizeof(stage), uart_sink, (void *)COM2);
+ * 暂存区至少16字节，越大调用write的次数越少。
+ */
+typedef struct
+{
+    uint8_t *buf;         // 输出缓冲区或者暂存区
+    size_t buf_capacity;  //
+    size_t buf_len;       // buf中的字节数
+    base64_write_t write; //
+    void *arg;            //
+    size_t total;         // 已经交给write的字节数
+    uint8_t rem[3];       // 不够3个字节的输入，留到下一次update
+    uint8_t rem_len;      //
+    uint8_t pad;          // 解码：已经收到的'='个数
+    uint8_t acc_n;        // 解码：acc中的字符个数
+    bool done;            // 解码：已经收到结尾的填充
+    int err;              // 出错后保持错误码，之后的调用直接返回
+    uint32_t acc;         // 解码：不够4个字符的输入
+} base64_stream_t;
+
+/**
+ * @brief 初始化流式编码。
+ *
+ * @param ctx
+ * @param buf write为NULL时是输出缓冲区，否则是暂存区。编码、解码使用同一种缓冲区，char、uint8_t数组都可以直接传入。
+ * @param buf_capacity
+ * @param write 输出函数，NULL表示只写buf。
+ * @param arg 传给write的参数。
+ */
+void base64_enc_init(base64_stream_t *ctx, void *buf, size_t buf_capacity, base64_write_t write, void *arg);
+
+/**
+ * @brief 编码一段数据，可以分多次调用，每次的长度任意。
+ * 每次处理12个字节（4组），按32位字读入、写出。
+ *
+ * @param ctx
+ * @param src
+ * @param len
+ * @return int 0 成功，1 输出缓冲区满或者write没有全部写入，2 参数错误。
+ */
+int base64_enc_update(base64_stream_t *ctx, const uint8_t *src, size_t len);
+
+/**
+ * @brief 编码剩下的字节并加上'='填充，write不为NULL时把暂存区全部交给write。
+ * write为NULL且buf还有空间时在结尾补'\0'。
+ *
+ * @param ctx
+ * @param outlen 输出的总字符数，不需要时传NULL。
+ * @return int 0 成功，1 输出缓冲区满或者write没有全部写入，2 参数错误。
+ */
+int base64_enc_finish(base64_stream_t *ctx, size_t *outlen);
+
+/**
+ * @brief 初始化流式解码，参数同base64_enc_init，输出的是解码后的字节。
+ */
+void base64_dec_init(base64_stream_t *ctx, void *buf, size_t buf_capacity, base64_write_t write, void *arg);
+
+/**
+ * @brief 解码一段base64字符，可以分多次调用，每次的长度任意，跳过'\n'、'\r'、'\t'、' '。
+ * 没有空白的部分每次处理16个字符（4组），按32位字读入、写出。
+ *
+ * @param ctx
+ * @param src
+ * @param len
+ * @return int 0 成功，1 输出缓冲区满或者write没有全部写入，2 非法字符或者填充之后还有数据。
+ */
+int base64_dec_update(base64_stream_t *ctx, const char *src, size_t len);
+
+/**
+ * @brief 结束解码，write不为NULL时把暂存区全部交给write。
+ *
+ * @param ctx
+ * @param outlen 输出的总字节数，不需要时传NULL。
+ * @return int 0 成功，1 输出缓冲区满或者write没有全部写入，2 输入不是4个字符的整数倍。
+ */
+int base64_dec_finish(base64_stream_t *ctx, size_t *outlen);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,503 @@
+/**
+ * @file base64_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 流式base64测试：
+ * RFC 4648的例子；随机长度、随机切分的数据经过暂存区写入模拟的串口发送队列（cqueue，满了由“中断”取走），
+ * 编码结果和逐位计算的结果相同，再加上换行、空格随机切分解码回原数据；错误的字符、填充、截断和写满输出的返回值；
+ * 最后和原来逐字节查表的base64_encode/base64_decode比较编码、解码的MB/s。
+ * @version 0.1
+ * @date 2024-01-06
+ * @last modified 2024-01-06
+ *
+ * @copyright Copyright (c) 2024 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "base64_test.h"
+#include "cqueue.h"
+#include "HDL_CPU_Time.h"
+#include "log.h"
+
+#define FUZZ_ROUNDS  3000
+#define FUZZ_MAX_LEN 700
+// 模拟的串口发送队列长度
+#define TX_RING_SIZE 128
+// 吞吐量测试：每轮的数据长度（3的倍数）和总字节数，默认按目标板的RAM和速度，主机上可以改大
+#ifndef BASE64_TEST_BENCH_LEN
+#define BASE64_TEST_BENCH_LEN   (3UL * 1024)
+#endif
+#ifndef BASE64_TEST_BENCH_BYTES
+#define BASE64_TEST_BENCH_BYTES (1UL * 1024 * 1024)
+#endif
+#define BENCH_LEN    BASE64_TEST_BENCH_LEN
+#define BENCH_BYTES  BASE64_TEST_BENCH_BYTES
+// 吞吐量测试中每次update的字节数和暂存区大小
+#define BENCH_CHUNK  256
+#define BENCH_STAGE  256
+// 吞吐量测试的轮数，每种方式取最快的一轮，减少其他进程和中断的影响
+#define BENCH_PASSES 3
+// 负载高时比较结果可能不成立，继续测量，最多的轮数
+#define BENCH_MAX_PASSES 12
+// 换行的base64每行的字符数
+#define LINE_LEN     76
+
+static uint8_t _gData[BENCH_LEN];
+static char _gText[BENCH_LEN * 2];
+static char _gRef[BENCH_LEN * 2];
+static uint8_t _gOut[BENCH_LEN * 2];
+static uint32_t _gOutLen = 0;
+static uint8_t _gTxRingBuf[TX_RING_SIZE];
+static CQueue_t _gTxRing;
+static uint32_t _gDrainCnt = 0;
+static uint64_t _gSinkBytes = 0;
+static uint32_t _gRng       = 0x2468ACE1UL;
+static uint32_t _gErrorCnt  = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[base64 Test] check failed: %s", what);
+    }
+}
+
+static uint32_t rng()
+{
+    _gRng ^= _gRng << 13;
+    _gRng ^= _gRng >> 17;
+    _gRng ^= _gRng << 5;
+    return _gRng;
+}
+
+static double mbps(uint64_t bytes, uint64_t us)
+{
+    return us == 0 ? 0.0 : (double)bytes / (1024.0 * 1024.0) * 1e6 / (double)us;
+}
+
+// 逐位取6位的参考编码，不用被测代码的表
+static size_t ref_encode(const uint8_t *src, size_t len, char *out)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t n                     = 0;
+    for (size_t bit = 0; bit < len * 8; bit += 6) {
+        uint32_t v = 0;
+        for (int k = 0; k < 6; k++) {
+            size_t b = bit + k;
+            v        = (v << 1) | (b < len * 8 ? (src[b / 8] >> (7 - b % 8)) & 1U : 0);
+        }
+        out[n++] = alphabet[v];
+    }
+    while (n % 4 != 0) {
+        out[n++] = '=';
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// 原来的base64_encode：每次一组，逐字节查表
+static const char legacy_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int legacy_encode(const uint8_t *src, size_t srclen, char *out, size_t out_buf_capacity, size_t *outlen)
+{
+    if (src == NULL || out == NULL || srclen == 0) return 1;
+    size_t outlen_ = 4 * ((srclen + 2) / 3);
+    if (outlen_ >= out_buf_capacity) return 1;
+    if (outlen != NULL) *outlen = outlen_;
+    size_t j = 0;
+    for (size_t i = 0; i < srclen;) {
+        uint32_t octet_a = i < srclen ? (uint8_t)src[i++] : 0;
+        uint32_t octet_b = i < srclen ? (uint8_t)src[i++] : 0;
+        uint32_t octet_c = i < srclen ? (uint8_t)src[i++] : 0;
+        uint32_t triple  = (octet_a << 16) + (octet_b << 8) + octet_c;
+        out[j++]         = legacy_table[(triple >> 18) & 0x3F];
+        out[j++]         = legacy_table[(triple >> 12) & 0x3F];
+        out[j++]         = legacy_table[(triple >> 6) & 0x3F];
+        out[j++]         = legacy_table[triple & 0x3F];
+    }
+    const int mod_table[] = {0, 2, 1};
+    for (int i = 0; i < mod_table[srclen % 3]; i++) {
+        out[outlen_ - 1 - i] = '=';
+    }
+    out[outlen_] = '\0';
+    return 0;
+}
+
+// 原来的base64_decode：先数一遍长度，再每次一组，每个字符前跳过空白
+static int legacy_dec_table[256];
+
+static bool is_space(char c)
+{
+    return c == '\n' || c == '\r' || c == '\t' || c == ' ';
+}
+
+static int legacy_decode(const char *src, uint8_t *out, size_t out_buf_capacity, size_t *outlen)
+{
+    size_t srclen = 0, n = 0;
+    const char *p_last = NULL;
+    for (const char *p = src; *p != '\0'; p++, srclen++) {
+        if (!is_space(*p)) {
+            n++;
+            p_last = p;
+        }
+    }
+    if (n % 4 != 0 || n == 0) return 2;
+    size_t outlen_ = n / 4 * 3;
+    if (*p_last == '=') outlen_--;
+    if (*(p_last - 1) == '=') outlen_--;
+    if (outlen_ >= out_buf_capacity) return 1;
+    if (outlen != NULL) *outlen = outlen_;
+    size_t j = 0;
+    for (size_t i = 0; i < srclen;) {
+        uint32_t sextet[4] = {0};
+        for (int k = 0; k < 4; k++) {
+            while (is_space(src[i])) { i++; }
+            src[i] == '=' ? i++ : (sextet[k] = legacy_dec_table[(uint8_t)src[i++]]);
+        }
+        uint32_t triple = (sextet[0] << 18) + (sextet[1] << 12) + (sextet[2] << 6) + sextet[3];
+        if (j < outlen_) out[j++] = (triple >> 16) & 0xFF;
+        if (j < outlen_) out[j++] = (triple >> 8) & 0xFF;
+        if (j < outlen_) out[j++] = triple & 0xFF;
+    }
+    return 0;
+}
+
+// 模拟串口发送中断：把发送队列里的数据全部取走
+static void tx_ring_drain()
+{
+    _gOutLen += cqueue_out(&_gTxRing, &_gOut[_gOutLen], sizeof(_gOut) - _gOutLen);
+    _gDrainCnt++;
+}
+
+// 和Uart_Write一样，发送队列满时等待中断取走数据
+static uint32_t tx_ring_write(void *arg, const uint8_t *data, uint32_t len)
+{
+    uint32_t done = 0;
+    while (done < len) {
+        done += cqueue_in((CQueue)arg, (void *)(data + done), len - done);
+        if (done < len) tx_ring_drain();
+    }
+    return done;
+}
+
+static uint32_t short_write(void *arg, const uint8_t *data, uint32_t len)
+{
+    return len / 2;
+}
+
+static uint32_t null_write(void *arg, const uint8_t *data, uint32_t len)
+{
+    _gSinkBytes += len + data[len - 1];
+    return len;
+}
+
+static void tx_ring_reset()
+{
+    cqueue_create(&_gTxRing, _gTxRingBuf, sizeof(_gTxRingBuf), sizeof(uint8_t));
+    _gOutLen = 0;
+}
+
+// 切成随机长度的若干段送给update
+static int enc_chunks(base64_stream_t *ctx, const uint8_t *src, size_t len)
+{
+    int ret = 0;
+    while (len > 0 && ret == 0) {
+        size_t n = 1 + rng() % (rng() & 1 ? 8 : 80);
+        n        = n > len ? len : n;
+        ret      = base64_enc_update(ctx, src, n);
+        src += n;
+        len -= n;
+    }
+    return ret;
+}
+
+static int dec_chunks(base64_stream_t *ctx, const char *src, size_t len)
+{
+    int ret = 0;
+    while (len > 0 && ret == 0) {
+        size_t n = 1 + rng() % (rng() & 1 ? 8 : 80);
+        n        = n > len ? len : n;
+        ret      = base64_dec_update(ctx, src, n);
+        src += n;
+        len -= n;
+    }
+    return ret;
+}
+
+// 加上换行或者随机的空白
+static size_t add_spaces(const char *src, size_t len, char *out)
+{
+    static const char spaces[] = {' ', '\t', '\r', '\n'};
+    bool lines                 = rng() & 1;
+    size_t n                   = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (lines && i > 0 && i % LINE_LEN == 0) {
+            out[n++] = '\r';
+            out[n++] = '\n';
+        } else if (!lines && rng() % 16 == 0) {
+            out[n++] = spaces[rng() % 4];
+        }
+        out[n++] = src[i];
+    }
+    if (lines) {
+        out[n++] = '\r';
+        out[n++] = '\n';
+    }
+    out[n] = '\0';
+    return n;
+}
+
+static void vector_test()
+{
+    static const char *const plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    static const char *const coded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    char text[16];
+    uint8_t data[16];
+    base64_stream_t ctx;
+    size_t n = 0;
+
+    for (int i = 0; i < 7; i++) {
+        size_t len = strlen(plain[i]);
+        base64_enc_init(&ctx, text, sizeof(text), NULL, NULL);
+        check(base64_enc_update(&ctx, (const uint8_t *)plain[i], len) == 0, "vector encode update");
+        check(base64_enc_finish(&ctx, &n) == 0 && n == strlen(coded[i]) && strcmp(text, coded[i]) == 0, "vector encode");
+
+        base64_dec_init(&ctx, data, sizeof(data), NULL, NULL);
+        check(base64_dec_update(&ctx, coded[i], strlen(coded[i])) == 0, "vector decode update");
+        check(base64_dec_finish(&ctx, &n) == 0 && n == len && memcmp(data, plain[i], len) == 0, "vector decode");
+
+        if (len > 0) {
+            check(base64_encode((const uint8_t *)plain[i], len, text, sizeof(text), &n) == 0 && strcmp(text, coded[i]) == 0,
+                  "vector base64_encode");
+            memset(data, 0, sizeof(data));
+            check(base64_decode(coded[i], data, sizeof(data), &n) == 0 && n == len && memcmp(data, plain[i], len) == 0,
+                  "vector base64_decode");
+        }
+    }
+
+    // 原来的接口：输出缓冲区要给'\0'留位置，空的输入不合法
+    check(base64_encode((const uint8_t *)"foo", 3, text, 4, &n) == 1, "base64_encode needs room for '\\0'");
+    check(base64_decode("Zm9v", data, 3, &n) == 1, "base64_decode needs room for '\\0'");
+    check(base64_decode(" \r\n", data, sizeof(data), &n) == 2, "base64_decode empty input");
+    check(base64_decode("Zm9\nvYmFy\n", data, sizeof(data), &n) == 0 && n == 6 && memcmp(data, "foobar", 6) == 0,
+          "base64_decode with newlines");
+
+    // 错误的输入
+    static const char *const bad[] = {"Zm9v*", "Zg=a", "Zg==Zg==", "Z===", "=Zg=", "Zm9vY", "Zg=", "Zm\x80v"};
+    for (int i = 0; i < 8; i++) {
+        base64_dec_init(&ctx, data, sizeof(data), NULL, NULL);
+        int ret = base64_dec_update(&ctx, bad[i], strlen(bad[i]));
+        if (ret == 0) ret = base64_dec_finish(&ctx, &n);
+        check(ret == 2, "bad input rejected");
+        check(base64_dec_update(&ctx, "Zm9v", 4) == 2, "error is sticky");
+    }
+    // 填充之后的空白可以接受
+    base64_dec_init(&ctx, data, sizeof(data), NULL, NULL);
+    check(base64_dec_update(&ctx, "Zg==\r\n", 6) == 0 && base64_dec_finish(&ctx, &n) == 0 && n == 1, "space after padding");
+
+    // 输出缓冲区满、write没有全部写入
+    base64_enc_init(&ctx, text, 7, NULL, NULL);
+    check(base64_enc_update(&ctx, (const uint8_t *)"foobar", 6) == 1, "encode buffer full");
+    base64_enc_init(&ctx, text, 8, NULL, NULL);
+    check(base64_enc_update(&ctx, (const uint8_t *)"foobar", 6) == 0 && base64_enc_finish(&ctx, &n) == 0 && n == 8,
+          "encode into exact buffer");
+    base64_dec_init(&ctx, data, 5, NULL, NULL);
+    check(base64_dec_update(&ctx, "Zm9vYmFy", 8) == 1, "decode buffer full");
+    base64_dec_init(&ctx, data, 4, NULL, NULL);
+    check(base64_dec_update(&ctx, "Zm9vYg==", 8) == 0 && base64_dec_finish(&ctx, &n) == 0 && n == 4,
+          "decode into exact buffer");
+    base64_enc_init(&ctx, text, 16, short_write, NULL);
+    check(base64_enc_update(&ctx, (const uint8_t *)"foobar", 6) == 0 && base64_enc_finish(&ctx, &n) == 1,
+          "short write fails the stream");
+}
+
+static void fuzz_test()
+{
+    static uint8_t stage[128];
+    base64_stream_t ctx;
+    size_t n = 0;
+    uint32_t drains = 0;
+
+    for (uint32_t round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t len = round < 64 ? round : rng() % FUZZ_MAX_LEN;
+        for (size_t i = 0; i < len; i++) {
+            _gData[i] = (uint8_t)rng();
+        }
+        size_t ref_len = ref_encode(_gData, len, _gRef);
+
+        // 编码：暂存区大小随机，经过发送队列
+        tx_ring_reset();
+        _gDrainCnt = 0;
+        base64_enc_init(&ctx, stage, 16 + rng() % (sizeof(stage) - 15), tx_ring_write, &_gTxRing);
+        check(enc_chunks(&ctx, _gData, len) == 0, "fuzz encode update");
+        check(base64_enc_finish(&ctx, &n) == 0 && n == ref_len, "fuzz encode length");
+        tx_ring_drain();
+        check(_gOutLen == ref_len && memcmp(_gOut, _gRef, ref_len) == 0, "fuzz encode matches reference");
+        drains += _gDrainCnt;
+
+        // 编码：直接写入刚好放得下的缓冲区
+        base64_enc_init(&ctx, _gText, ref_len, NULL, NULL);
+        check(enc_chunks(&ctx, _gData, len) == 0 && base64_enc_finish(&ctx, &n) == 0 && n == ref_len &&
+                  memcmp(_gText, _gRef, ref_len) == 0,
+              "fuzz encode into buffer");
+        if (len > 0) {
+            check(base64_encode(_gData, len, _gText, ref_len + 1, &n) == 0 && strcmp(_gText, _gRef) == 0,
+                  "fuzz base64_encode");
+        }
+
+        // 解码：加上空白，随机切分
+        size_t text_len = add_spaces(_gRef, ref_len, _gText);
+        tx_ring_reset();
+        if (rng() & 1) {
+            base64_dec_init(&ctx, stage, 16 + rng() % (sizeof(stage) - 15), tx_ring_write, &_gTxRing);
+        } else {
+            base64_dec_init(&ctx, _gOut, len, NULL, NULL);
+        }
+        check(dec_chunks(&ctx, _gText, text_len) == 0, "fuzz decode update");
+        check(base64_dec_finish(&ctx, &n) == 0 && n == len, "fuzz decode length");
+        if (ctx.write != NULL) tx_ring_drain();
+        check(memcmp(_gOut, _gData, len) == 0, "fuzz decode matches data");
+        if (len > 0) {
+            memset(_gOut, 0, len);
+            check(base64_decode(_gText, _gOut, len + 1, &n) == 0 && n == len && memcmp(_gOut, _gData, len) == 0,
+                  "fuzz base64_decode");
+        }
+
+        // 随机换掉一个字符，变成非法字符
+        if (ref_len > 0) {
+            static const char invalid[] = {'*', '-', '_', '.', '\0', '\x7F', '\xC3', '\v'};
+            _gText[rng() % text_len]    = invalid[rng() % sizeof(invalid)];
+            base64_dec_init(&ctx, _gOut, sizeof(_gOut), NULL, NULL);
+            int ret = dec_chunks(&ctx, _gText, text_len);
+            if (ret == 0) ret = base64_dec_finish(&ctx, &n);
+            // 换掉的是空白时仍然合法
+            check(ret == 2 || (ret == 0 && n == len && memcmp(_gOut, _gData, len) == 0), "fuzz corrupted input");
+        }
+    }
+    check(drains > FUZZ_ROUNDS, "tx ring filled up while encoding");
+    ULOG_INFO("[base64 Test] fuzz %u rounds, tx ring drained %u times", (unsigned)FUZZ_ROUNDS, (unsigned)drains);
+}
+
+static void bench_pass(double *r)
+{
+    static uint8_t stage[BENCH_STAGE];
+    base64_stream_t ctx;
+    size_t text_len = 0, n = 0;
+    uint64_t us;
+
+    for (size_t i = 0; i < BENCH_LEN; i++) {
+        _gData[i] = (uint8_t)rng();
+    }
+    for (int i = 0; i < 64; i++) {
+        legacy_dec_table[(uint8_t)legacy_table[i]] = i;
+    }
+
+    // 编码：原来的一次编码、一次编码到缓冲区、每次BENCH_CHUNK字节经过暂存区交给write
+    us = HDL_CPU_Time_GetUsTick64();
+    for (uint64_t done = 0; done < BENCH_BYTES; done += BENCH_LEN) {
+        _gData[0] = (uint8_t)done;
+        legacy_encode(_gData, BENCH_LEN, _gText, sizeof(_gText), &text_len);
+    }
+    r[0] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    us   = HDL_CPU_Time_GetUsTick64();
+    for (uint64_t done = 0; done < BENCH_BYTES; done += BENCH_LEN) {
+        _gData[0] = (uint8_t)done;
+        base64_enc_init(&ctx, _gRef, sizeof(_gRef), NULL, NULL);
+        base64_enc_update(&ctx, _gData, BENCH_LEN);
+        base64_enc_finish(&ctx, &n);
+    }
+    r[1] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    check(n == text_len && memcmp(_gRef, _gText, n) == 0, "bench encode matches legacy");
+    us = HDL_CPU_Time_GetUsTick64();
+    for (uint64_t done = 0; done < BENCH_BYTES; done += BENCH_LEN) {
+        _gData[0] = (uint8_t)done;
+        base64_enc_init(&ctx, stage, sizeof(stage), null_write, NULL);
+        for (size_t i = 0; i < BENCH_LEN; i += BENCH_CHUNK) {
+            base64_enc_update(&ctx, &_gData[i], BENCH_LEN - i < BENCH_CHUNK ? BENCH_LEN - i : BENCH_CHUNK);
+        }
+        base64_enc_finish(&ctx, &n);
+    }
+    r[2] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    check(n == text_len, "bench streamed encode length");
+
+    // 解码：按编码后的字符数计算
+    us = HDL_CPU_Time_GetUsTick64();
+    for (uint64_t done = 0; done < BENCH_BYTES; done += text_len) {
+        legacy_decode(_gText, _gOut, sizeof(_gOut), &n);
+    }
+    r[3] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    check(n == BENCH_LEN && memcmp(_gOut, _gData, n) == 0, "bench legacy decode");
+    memset(_gOut, 0, BENCH_LEN);
+    us = HDL_CPU_Time_GetUsTick64();
+    for (uint64_t done = 0; done < BENCH_BYTES; done += text_len) {
+        base64_dec_init(&ctx, _gOut, sizeof(_gOut), NULL, NULL);
+        base64_dec_update(&ctx, _gText, text_len);
+        base64_dec_finish(&ctx, &n);
+    }
+    r[4] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    check(n == BENCH_LEN && memcmp(_gOut, _gData, n) == 0, "bench decode");
+
+    // 每行76个字符的base64
+    text_len = 0;
+    for (size_t i = 0; i < BENCH_LEN / 57 * 57; i += 57) {
+        base64_encode(&_gData[i], 57, &_gRef[text_len], sizeof(_gRef) - text_len, &n);
+        text_len += n;
+        _gRef[text_len++] = '\r';
+        _gRef[text_len++] = '\n';
+    }
+    _gRef[text_len] = '\0';
+    us              = HDL_CPU_Time_GetUsTick64();
+    for (uint64_t done = 0; done < BENCH_BYTES; done += text_len) {
+        legacy_decode(_gRef, _gOut, sizeof(_gOut), &n);
+    }
+    r[5] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    us   = HDL_CPU_Time_GetUsTick64();
+    for (uint64_t done = 0; done < BENCH_BYTES; done += text_len) {
+        base64_dec_init(&ctx, stage, sizeof(stage), null_write, NULL);
+        for (size_t i = 0; i < text_len; i += BENCH_CHUNK) {
+            base64_dec_update(&ctx, &_gRef[i], text_len - i < BENCH_CHUNK ? text_len - i : BENCH_CHUNK);
+        }
+        base64_dec_finish(&ctx, &n);
+    }
+    r[6] = mbps(BENCH_BYTES, HDL_CPU_Time_GetUsTick64() - us);
+    check(n == BENCH_LEN / 57 * 57, "bench streamed decode length");
+}
+
+static bool bench_faster(const double *r)
+{
+    return r[1] > r[0] && r[2] > r[0] && r[4] > r[3] && r[6] > r[5];
+}
+
+static void bench_test()
+{
+    double pass[7];
+    double r[7] = {0};
+
+    for (int i = 0; i < BENCH_PASSES || (!bench_faster(r) && i < BENCH_MAX_PASSES); i++) {
+        bench_pass(pass);
+        for (int k = 0; k < 7; k++) {
+            r[k] = pass[k] > r[k] ? pass[k] : r[k];
+        }
+    }
+    ULOG_INFO("[base64 Test] encode: legacy %.1f, buffer %.1f, streamed %.1f MB/s", r[0], r[1], r[2]);
+    ULOG_INFO("[base64 Test] decode: legacy %.1f, buffer %.1f MB/s", r[3], r[4]);
+    ULOG_INFO("[base64 Test] decode 76-char lines: legacy %.1f, streamed %.1f MB/s", r[5], r[6]);
+    check(r[1] > r[0] && r[2] > r[0], "encode faster than legacy");
+    check(r[4] > r[3] && r[6] > r[5], "decode faster than legacy");
+}
+
+/**
+ * @brief 流式base64测试，只依赖HDL_CPU_Time的us计时，可以在目标板上运行。
+ *
+ * @return uint32_t 错误数。
+ */
+uint32_t base64_stream_test()
+{
+    _gErrorCnt = 0;
+    _gRng      = 0x2468ACE1UL;
+    vector_test();
+    fuzz_test();
+    bench_test();
+    ULOG_INFO("[base64 Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file base64_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2024-01-06
+ * @last modified 2024-01-06
+ *
+ * @copyright Copyright (c) 2024 Liu Yuanlin Personal.
+ *
+ */
+#ifndef BASE64_TEST_H
+#define BASE64_TEST_H
+#include <stdint.h>
+#include "base64.h"
+
+uint32_t base64_stream_test();
+#endif // !BASE64_TEST_H
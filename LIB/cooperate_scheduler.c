@@ -9,6 +9,7 @@
  *
  */
 #include "cooperate_scheduler.h"
+#include "log.h"
 
 static CooperateScheduler_t _gcooperate_scheduler;
 
@@ -38,7 +39,7 @@ static float oen_tick_time = 1; // ms
  * @return true
  * @return false
  */
-bool Functional_execute(Functional_t *functional)
+static bool Functional_execute(Functional_t *functional)
 {
     bool exe_source_free = false;
     if (functional->fun != NULL) {
@@ -56,9 +57,89 @@ void cooperate_scheduler_init()
     sc_list_init(&_gcooperate_scheduler.group_list);
 }
 
+#define COOPERATE_TICK_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+// 饿死的任务的有效优先级，高于所有uint8_t优先级
+#define COOPERATE_PRIORITY_STARVING 0x100U
+
+/**
+ * @brief 任务本次到期的时刻：距离上一次执行一个周期，并且不早于注册延时结束。
+ * last_exe_tick比当前时刻还晚时(例如第一次注册时last_exe_tick为0)按马上到期处理，与到期判断一致。
+ *
+ * @param task
+ * @param now
+ * @return uint32_t
+ */
+static uint32_t cooperate_task_release_tick(TaskNode_t *task, uint32_t now)
+{
+    uint32_t release = task->last_exe_tick + task->period;
+    uint32_t first   = task->register_tick + task->delay_before_first_exe;
+
+    release = COOPERATE_TICK_BEFORE(release, first) ? first : release;
+    return COOPERATE_TICK_BEFORE(now, release) ? now : release;
+}
+
+/**
+ * @brief 任务是否到期需要执行。
+ *
+ * @param task
+ * @param now
+ * @return true
+ * @return false
+ */
+static bool cooperate_task_is_due(TaskNode_t *task, uint32_t now)
+{
+    // 这里一定是>=，如果是 > ，那么在1 cpu tick间隔的时候时间上是2cpu tick执行一次。
+    // 这里不允许period为0，不然就会失去调度作用。
+    // 首次执行时刻用回绕安全的比较，register_tick + delay回绕后直接比较大小会让任务提前执行。
+    return task->exe_cnt < task->exe_times &&
+           !COOPERATE_TICK_BEFORE(now, task->register_tick + task->delay_before_first_exe) &&
+           now - task->last_exe_tick >= task->period;
+}
+
+/**
+ * @brief 从组内到期的任务中选出下一个执行的任务：饿死的任务最先，其次优先级高的，
+ * 优先级相同的截止时刻早的，都相同时链表中靠前的(执行成功的任务会移到链表尾部，轮流执行)。
+ *
+ * @param group
+ * @param now
+ * @return TaskNode_t* 没有到期的任务时返回NULL。
+ */
+static TaskNode_t *cooperate_group_select(CooperativeGroup_t *group, uint32_t now)
+{
+    struct sc_list *it    = NULL;
+    TaskNode_t *task      = NULL;
+    TaskNode_t *best      = NULL;
+    uint32_t prio         = 0;
+    uint32_t bestPrio     = 0;
+    uint32_t deadline     = 0;
+    uint32_t bestDeadline = 0;
+
+    sc_list_foreach(&group->task_list, it)
+    {
+        task = sc_list_entry(it, TaskNode_t, next);
+        if (!cooperate_task_is_due(task, now)) {
+            continue;
+        }
+        task->_release_tick = cooperate_task_release_tick(task, now);
+        deadline            = task->_release_tick + (task->deadline != 0 ? task->deadline : task->period);
+        prio                = task->priority;
+        if (group->starvation_ticks != 0 && now - task->_release_tick >= group->starvation_ticks) {
+            prio = COOPERATE_PRIORITY_STARVING;
+        }
+        if (best == NULL || prio > bestPrio || (prio == bestPrio && COOPERATE_TICK_BEFORE(deadline, bestDeadline))) {
+            best         = task;
+            bestPrio     = prio;
+            bestDeadline = deadline;
+        }
+    }
+    return best;
+}
+
 /**
  * @brief cooperate_scheduler处理器。
  * 只有保证cooperate_scheduler_handler执行频率大于cooperate_scheduler计时器的计时分辨率的频率才能保证时间相对准确的定时任务调度。
+ * 每个任务组每次最多执行一个任务：到期的任务中优先级最高的，优先级相同时截止时刻最早的，
+ * 等待超过starvation_ticks的任务优先于所有其他任务。资源忙时整个组等待min_period后再重试。
  */
 void cooperate_scheduler_handler()
 {
@@ -66,53 +147,68 @@ void cooperate_scheduler_handler()
     static CooperativeGroup_t *group        = NULL;
     static const struct sc_list *group_list = &_gcooperate_scheduler.group_list;
 
-    static struct sc_list *it_task = NULL;
-    static TaskNode_t *task        = NULL;
+    static TaskNode_t *task = NULL;
     // Group所共用的资源是否是空闲的
-    static bool exe_source_free  = false;
-    static struct sc_list *poped = NULL;
+    static bool exe_source_free = false;
+    static uint32_t now         = 0;
+    static uint32_t latency     = 0;
+#if TASK_PROFILE_ENABLE
+    static uint32_t start_us = 0;
+    static uint32_t exe_us   = 0;
+#endif
     sc_list_foreach(group_list, it)
     {
         group = sc_list_entry(it, CooperativeGroup_t, next);
-        sc_list_foreach(&group->task_list, it_task)
-        {
-            task = sc_list_entry(it_task, TaskNode_t, next);
-            if (scheduler_get_cpu_tick() >= (task->register_tick + task->delay_before_first_exe)) {
-                if (task->exe_cnt < task->exe_times) {
-                    // 这里一定是>=，如果是 > ，那么在1 cpu tick间隔的时候时间上是2cpu tick执行一次。
-                    // 这里不允许period为0，不然就会失去调度作用。
-                    // 这里需要保证一定的实时性
-                    if ((scheduler_get_cpu_tick() - task->last_exe_tick) >= task->period) {
-                        exe_source_free = Functional_execute(&task->fun);
-                        if (exe_source_free) {
-                            task->_elapsed_tick_since_last_exe = scheduler_get_cpu_tick() - task->last_exe_tick;
-                            task->_exe_tick_error              = task->_elapsed_tick_since_last_exe - 2 * task->period;
-                            if (task->_exe_tick_error > 0) {
-                                // 调整后的上一次的执行时刻
-                                task->last_exe_tick = scheduler_get_cpu_tick();
-                            } else {
-                                task->last_exe_tick += task->period;
-                            }
-                            task->exe_cnt++;
-                            task->exe_cnt = task->exe_cnt == cooperate_scheduler_EXE_TIMES_INF ? 0 : task->exe_cnt;
-
-                            poped = sc_list_pop_head(&group->task_list);
-                            sc_list_add_tail(&group->task_list, poped);
-                        } else {
-                            task->_elapsed_tick_since_last_exe = scheduler_get_cpu_tick() - task->last_exe_tick;
-                            task->_exe_tick_error              = task->_elapsed_tick_since_last_exe - 2 * task->period;
-                            if (task->_exe_tick_error > 0) {
-                                // 调整后的上一次的执行时刻
-                                task->last_exe_tick = scheduler_get_cpu_tick();
-                            } else {
-                                // 这个任务这次发现资源忙以后会等待1个tick再去执行Functional_execute看资源是否可用
-                                task->last_exe_tick += group->min_period;
-                            }
-                            task->exe_fail_cnt++;
-                        }
-                    }
-                }
+        now   = scheduler_get_cpu_tick();
+        if (group->_retry_pending && COOPERATE_TICK_BEFORE(now, group->_retry_tick)) {
+            continue;
+        }
+        group->_retry_pending = false;
+
+        task = cooperate_group_select(group, now);
+        if (task == NULL) {
+            continue;
+        }
+        latency = now - task->_release_tick;
+
+#if TASK_PROFILE_ENABLE
+        start_us        = HDL_CPU_Time_GetUsTick();
+        exe_source_free = Functional_execute(&task->fun);
+        exe_us          = HDL_CPU_Time_GetUsTick() - start_us;
+        task_profile_exe_time(&task->profile, exe_us);
+        task_profile_exe_time(&group->profile, exe_us);
+        if (exe_source_free) {
+            task_profile_release(&task->profile, latency, exe_us, task->period);
+        }
+#else
+        exe_source_free = Functional_execute(&task->fun);
+#endif
+        task->_elapsed_tick_since_last_exe = scheduler_get_cpu_tick() - task->last_exe_tick;
+        if (exe_source_free) {
+            task->_exe_tick_error = task->_elapsed_tick_since_last_exe - 2 * task->period;
+            if (task->_exe_tick_error > 0) {
+                // 调整后的上一次的执行时刻
+                task->last_exe_tick = scheduler_get_cpu_tick();
+            } else {
+                task->last_exe_tick += task->period;
+            }
+            task->exe_cnt++;
+            task->exe_cnt = task->exe_cnt == cooperate_scheduler_EXE_TIMES_INF ? 0 : task->exe_cnt;
+
+            task->latency_sum += latency;
+            task->max_latency = latency > task->max_latency ? latency : task->max_latency;
+            if (scheduler_get_cpu_tick() - task->_release_tick > (task->deadline != 0 ? task->deadline : task->period)) {
+                task->deadline_miss_cnt++;
             }
+
+            // 移到链表尾部，优先级和截止时刻都相同的任务轮流执行
+            sc_list_add_tail(&group->task_list, &task->next);
+        } else {
+            // 资源忙，组内其他任务也拿不到资源，整个组等待min_period后再重试，
+            // 任务的到期时刻不变，等待的时间计入延迟
+            group->_retry_tick    = now + group->min_period;
+            group->_retry_pending = true;
+            task->exe_fail_cnt++;
         }
     }
 }
@@ -173,6 +269,9 @@ bool cooperate_scheduler_unregister(CooperativeGroup_t *group)
 void cooperate_group_init(CooperativeGroup_t *group)
 {
     sc_list_init(&group->task_list);
+    group->starvation_ticks = COOPERATE_GROUP_STARVATION_TICKS_DEFAULT / oen_tick_time;
+    group->_retry_tick      = 0;
+    group->_retry_pending   = false;
 }
 
 /**
@@ -279,4 +378,106 @@ void cooperate_scheduler_set_task_freq(TaskNode_t *task, int freq)
     if (task != NULL) {
         task->period = 1000.0f / freq / oen_tick_time;
     }
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief 设置任务在组内的优先级和相对截止时间。
+ *
+ * @param task
+ * @param priority 越大越优先。
+ * @param deadline_ms 从到期开始算的截止时间，0表示等于周期。
+ */
+void cooperate_scheduler_set_task_deadline(TaskNode_t *task, uint8_t priority, uint32_t deadline_ms)
+{
+    if (task != NULL) {
+        task->priority = priority;
+        task->deadline = deadline_ms / oen_tick_time;
+    }
+}
+
+/**
+ * @brief 设置任务组的饿死保护时间。
+ *
+ * @param group
+ * @param ms 任务到期后等待超过这个时间就最先执行，0表示不做饿死保护。
+ */
+void cooperate_group_set_starvation_time(CooperativeGroup_t *group, uint32_t ms)
+{
+    group->starvation_ticks = ms / oen_tick_time;
+}
+
+/**
+ * @brief 打印任务组中每个任务的执行次数、失败次数、截止时刻超时次数和延迟。
+ *
+ * @param group
+ */
+void cooperate_group_stat_show(CooperativeGroup_t *group)
+{
+    struct sc_list *it = NULL;
+    TaskNode_t *task   = NULL;
+
+    sc_list_foreach(&group->task_list, it)
+    {
+        task = sc_list_entry(it, TaskNode_t, next);
+        ULOG_INFO("[Cooperate] %s prio:%u deadline:%u exe:%u fail:%u miss:%u latency avg:%u max:%u",
+                  task->name != NULL ? task->name : "-", task->priority,
+                  task->deadline != 0 ? task->deadline : task->period, task->exe_cnt, task->exe_fail_cnt,
+                  task->deadline_miss_cnt, task->exe_cnt != 0 ? (uint32_t)(task->latency_sum / task->exe_cnt) : 0,
+                  task->max_latency);
+    }
+}
+
+#if TASK_PROFILE_ENABLE
+/**
+ * @brief 按总执行时间从大到小打印注册的任务组和任务的执行时间统计。
+ *
+ * @param top_n 打印前多少个任务组和任务，最多TASK_PROFILE_TOP_MAX个。
+ */
+void cooperate_scheduler_profile_dump(uint32_t top_n)
+{
+    TaskProfileTop_t groupTop[TASK_PROFILE_TOP_MAX];
+    TaskProfileTop_t taskTop[TASK_PROFILE_TOP_MAX];
+    uint32_t groupNum         = 0;
+    uint32_t taskNum          = 0;
+    struct sc_list *it        = NULL;
+    struct sc_list *it_task   = NULL;
+    CooperativeGroup_t *group = NULL;
+    TaskNode_t *task          = NULL;
+
+    top_n = top_n > TASK_PROFILE_TOP_MAX ? TASK_PROFILE_TOP_MAX : top_n;
+    sc_list_foreach(&_gcooperate_scheduler.group_list, it)
+    {
+        group = sc_list_entry(it, CooperativeGroup_t, next);
+        task_profile_top_insert(groupTop, &groupNum, top_n, &group->profile, NULL, group);
+        sc_list_foreach(&group->task_list, it_task)
+        {
+            task = sc_list_entry(it_task, TaskNode_t, next);
+            task_profile_top_insert(taskTop, &taskNum, top_n, &task->profile, task->name, task);
+        }
+    }
+    task_profile_top_show(groupTop, groupNum, "Cooperate Group");
+    task_profile_top_show(taskTop, taskNum, "Cooperate Task");
+}
+
+/**
+ * @brief 清空所有注册的任务组和任务的执行时间统计。
+ *
+ */
+void cooperate_scheduler_profile_reset()
+{
+    struct sc_list *it        = NULL;
+    struct sc_list *it_task   = NULL;
+    CooperativeGroup_t *group = NULL;
+
+    sc_list_foreach(&_gcooperate_scheduler.group_list, it)
+    {
+        group = sc_list_entry(it, CooperativeGroup_t, next);
+        task_profile_reset(&group->profile);
+        sc_list_foreach(&group->task_list, it_task)
+        {
+            task_profile_reset(&sc_list_entry(it_task, TaskNode_t, next)->profile);
+        }
+    }
+}
+#endif
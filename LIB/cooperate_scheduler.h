@@ -17,9 +17,19 @@
 #include <limits.h>
 #include "sc_list.h"
 #include "HDL_CPU_Time.h"
+#include "task_profile.h"
 
 /* Config CPU Tick here */
+#ifdef COOPERATE_SCHEDULER_SIMULATION
+// 上位机仿真时使用虚拟时钟，由仿真程序推进
+extern uint32_t cooperate_sim_tick;
+#define scheduler_get_cpu_tick() cooperate_sim_tick
+#else
 #define scheduler_get_cpu_tick() HDL_CPU_Time_GetTick()
+#endif
+
+// 任务等待超过这么多tick后不论优先级都最先执行，防止低优先级任务饿死
+#define COOPERATE_GROUP_STARVATION_TICKS_DEFAULT 1000
 
 typedef bool (*Function_t)(void *arg);
 
@@ -38,12 +48,22 @@ typedef struct tagFunctionalListNode_t {
     uint32_t exe_cnt;       // 执行了多少次
     uint32_t exe_fail_cnt;  // 执行失败了多少次
     uint32_t period;        // 执行周期，单位为CPU tick的周期，必须大于0，否则就是相当于死循环了。
+    uint8_t priority;       // 组内优先级，越大越优先，相同优先级按截止时刻最早优先(EDF)
+    uint32_t deadline;      // 相对截止时间，从到期时刻算起，单位tick，0表示等于period
+
+    uint32_t deadline_miss_cnt; // 执行完成时已经超过截止时刻的次数
+    uint32_t max_latency;       // 从到期到开始执行的最大延迟，单位tick
+    uint64_t latency_sum;       // 延迟之和，除以exe_cnt为平均延迟
 
     uint32_t delay_before_first_exe;       // 从注册第一次真正执行调度的延迟
     uint32_t register_tick;                // 注册时刻
     Functional_t fun;                      // 执行的方法
     int32_t _exe_tick_error;               // 执行时刻误差
     uint32_t _elapsed_tick_since_last_exe; // 距离上传执行逝去了多少事件
+    uint32_t _release_tick;                // 本次到期的时刻
+#if TASK_PROFILE_ENABLE
+    TaskProfile_t profile; // 执行时间统计，资源忙的调用只统计执行时间
+#endif
 
     struct sc_list next;
 } TaskNode_t;
@@ -56,6 +76,13 @@ typedef struct tagCooperativeGroup_t {
     // 一个最小的占用时间，用于任务组内任务请求资源失败的延时。设置为最小是为了保证
     // 调度频率的准确性。
     uint32_t min_period;
+    // 任务到期后等待超过这么多tick就提升到最高优先级，0表示不做饿死保护
+    uint32_t starvation_ticks;
+    uint32_t _retry_tick; // 资源忙时整个组在这个时刻之后才重试
+    bool _retry_pending;
+#if TASK_PROFILE_ENABLE
+    TaskProfile_t profile; // 组内所有任务的执行时间统计
+#endif
     struct sc_list task_list; // for TaskNode_t
     struct sc_list next;      // for self
 } CooperativeGroup_t;
@@ -75,6 +102,8 @@ void cooperate_scheduler_init();
 /**
  * @brief cooperate_scheduler处理器。
  * 只有保证cooperate_scheduler_handler执行频率大于cooperate_scheduler计时器的计时分辨率的频率才能保证时间相对准确的定时任务调度。
+ * 每个任务组每次最多执行一个任务：到期的任务中优先级最高的，优先级相同时截止时刻最早的，
+ * 等待超过starvation_ticks的任务优先于所有其他任务。资源忙时整个组等待min_period后再重试。
  */
 void cooperate_scheduler_handler();
 
@@ -159,4 +188,43 @@ bool cooperate_group_unregister(CooperativeGroup_t *group, TaskNode_t *task);
  */
 void cooperate_scheduler_set_task_freq(TaskNode_t *task, int freq);
 
+/**
+ * @brief 设置任务在组内的优先级和相对截止时间。
+ *
+ * @param task
+ * @param priority 越大越优先。
+ * @param deadline_ms 从到期开始算的截止时间，0表示等于周期。
+ */
+void cooperate_scheduler_set_task_deadline(TaskNode_t *task, uint8_t priority, uint32_t deadline_ms);
+
+/**
+ * @brief 设置任务组的饿死保护时间。
+ *
+ * @param group
+ * @param ms 任务到期后等待超过这个时间就最先执行，0表示不做饿死保护。
+ */
+void cooperate_group_set_starvation_time(CooperativeGroup_t *group, uint32_t ms);
+
+/**
+ * @brief 打印任务组中每个任务的执行次数、失败次数、截止时刻超时次数和延迟。
+ *
+ * @param group
+ */
+void cooperate_group_stat_show(CooperativeGroup_t *group);
+
+#if TASK_PROFILE_ENABLE
+/**
+ * @brief 按总执行时间从大到小打印注册的任务组和任务的执行时间统计。
+ *
+ * @param top_n 打印前多少个任务组和任务，最多TASK_PROFILE_TOP_MAX个。
+ */
+void cooperate_scheduler_profile_dump(uint32_t top_n);
+
+/**
+ * @brief 清空所有注册的任务组和任务的执行时间统计。
+ *
+ */
+void cooperate_scheduler_profile_reset();
+#endif
+
 #endif //! cooperate_scheduler_H
\ No newline at end of file
@@ -12,6 +12,9 @@
 #include "cooperate_scheduler_test.h"
 #include "HDL_CPU_Time.h"
 #include <stdio.h>
+#include <string.h>
+
+#define COOPERATE_TICK_BEFORE_SIM(a, b) ((int32_t)((a) - (b)) < 0)
 
 /*
 task1会执行十次fun1,1000ms执行一次
@@ -193,3 +196,164 @@ void cooperate_scheduler_test()
         }
     }
 }
+
+#ifdef COOPERATE_SCHEDULER_SIMULATION
+/*
+上位机仿真：一个任务组模拟一条RS485总线，任务执行成功后总线被占用cost个tick，期间组内其他任务
+拿不到资源。告警任务周期10tick、占用1tick；背景是20个周期90-110tick、占用2-6tick的慢轮询，
+相位随机，总负载约90%。分别统计告警任务从到期到开始执行的延迟分布和各任务的截止时刻超时次数：
+  1. 所有任务截止时间相同(100tick)、优先级相同，相当于先到期先执行；
+  2. 告警任务截止时间10tick，EDF；
+  3. 告警任务截止时间10tick并且优先级为1；
+  4/5. 告警任务周期改为2tick造成过载，比较没有饿死保护和50tick饿死保护时背景任务的执行情况。
+编译时定义COOPERATE_SCHEDULER_SIMULATION，scheduler_get_cpu_tick()使用虚拟时钟cooperate_sim_tick。
+*/
+#define SIM_BG_TASK_NUM   20
+#define SIM_HIST_BINS     8
+#define SIM_START_TICK    1000
+#define SIM_DURATION_TICK 100000
+
+uint32_t cooperate_sim_tick = 0;
+static uint32_t sim_bus_busy_until;
+static uint32_t sim_rand_seed;
+
+typedef struct {
+    TaskNode_t task;
+    uint32_t cost;                // 执行成功后占用总线的tick数
+    uint32_t hist[SIM_HIST_BINS]; // 延迟分布：0,1,2-3,4-7,8-15,16-31,32-63,>=64
+} SimTask_t;
+
+static uint32_t sim_rand(uint32_t range)
+{
+    sim_rand_seed = sim_rand_seed * 1103515245U + 12345U;
+    return (sim_rand_seed >> 16) % range;
+}
+
+typedef struct {
+    uint32_t alarmMax;  // 告警任务最大延迟
+    uint32_t alarmMiss; // 告警任务截止时刻超时次数
+    uint32_t bgExe;     // 背景任务执行次数
+    uint32_t bgMax;     // 背景任务最大延迟
+} SimResult_t;
+
+static SimTask_t sim_alarm;
+static SimTask_t sim_bg[SIM_BG_TASK_NUM];
+static uint32_t sim_errors;
+
+static bool sim_fun(void *arg)
+{
+    SimTask_t *sim   = (SimTask_t *)arg;
+    uint32_t latency = cooperate_sim_tick - sim->task._release_tick;
+    uint32_t bin     = 0;
+
+    if (COOPERATE_TICK_BEFORE_SIM(cooperate_sim_tick, sim_bus_busy_until)) {
+        return false;
+    }
+    sim_bus_busy_until = cooperate_sim_tick + sim->cost;
+    while (latency != 0 && bin < SIM_HIST_BINS - 1) {
+        latency >>= 1;
+        bin++;
+    }
+    sim->hist[bin]++;
+    return true;
+}
+
+static void sim_task_init(SimTask_t *sim, const char *name, uint32_t period, uint32_t cost, uint8_t priority, uint32_t deadline)
+{
+    memset(sim, 0, sizeof(SimTask_t));
+    sim->task.name      = (char *)name;
+    sim->task.exe_times = cooperate_scheduler_EXE_TIMES_INF;
+    sim->task.period    = period;
+    sim->task.priority  = priority;
+    sim->task.deadline  = deadline;
+    sim->task.fun.fun   = sim_fun;
+    sim->task.fun.arg   = sim;
+    sim->cost           = cost;
+}
+
+static void sim_run(const char *title, uint32_t alarmPeriod, uint32_t alarmDeadline, uint8_t alarmPriority, uint32_t starvation,
+                    SimResult_t *pResult)
+{
+    CooperativeGroup_t group;
+    uint32_t bgExe  = 0;
+    uint32_t bgMiss = 0;
+    uint32_t bgMax  = 0;
+    uint32_t period = 0;
+    uint32_t cost   = 0;
+
+    cooperate_sim_tick = SIM_START_TICK;
+    sim_bus_busy_until = 0;
+    sim_rand_seed      = 1;
+    cooperate_scheduler_init();
+    cooperate_group_init(&group);
+    cooperate_scheduler_register(&group);
+    cooperate_group_set_starvation_time(&group, starvation);
+
+    sim_task_init(&sim_alarm, "alarm", alarmPeriod, 1, alarmPriority, alarmDeadline);
+    cooperate_group_register(&group, &sim_alarm.task);
+    for (int i = 0; i < SIM_BG_TASK_NUM; i++) {
+        period = 90 + sim_rand(21);
+        cost   = 2 + sim_rand(5);
+        sim_task_init(&sim_bg[i], "bg", period, cost, 0, 100);
+        // 随机相位
+        sim_bg[i].task.last_exe_tick = SIM_START_TICK - period + sim_rand(period);
+        cooperate_group_register(&group, &sim_bg[i].task);
+    }
+
+    sim_alarm.task.last_exe_tick = SIM_START_TICK - alarmPeriod;
+    for (; cooperate_sim_tick < SIM_START_TICK + SIM_DURATION_TICK; cooperate_sim_tick++) {
+        cooperate_scheduler_handler();
+    }
+
+    for (int i = 0; i < SIM_BG_TASK_NUM; i++) {
+        bgExe += sim_bg[i].task.exe_cnt;
+        bgMiss += sim_bg[i].task.deadline_miss_cnt;
+        bgMax = sim_bg[i].task.max_latency > bgMax ? sim_bg[i].task.max_latency : bgMax;
+    }
+    printf("[Cooperate Sim] %s\r\n", title);
+    printf("  alarm exe %u miss %u latency avg %.2f max %u, hist(0,1,2-3,4-7,8-15,16-31,32-63,64+): %u %u %u %u %u %u %u %u\r\n",
+           sim_alarm.task.exe_cnt, sim_alarm.task.deadline_miss_cnt,
+           sim_alarm.task.exe_cnt ? (double)sim_alarm.task.latency_sum / sim_alarm.task.exe_cnt : 0.0, sim_alarm.task.max_latency,
+           sim_alarm.hist[0], sim_alarm.hist[1], sim_alarm.hist[2], sim_alarm.hist[3],
+           sim_alarm.hist[4], sim_alarm.hist[5], sim_alarm.hist[6], sim_alarm.hist[7]);
+    printf("  background exe %u miss %u max latency %u\r\n", bgExe, bgMiss, bgMax);
+    pResult->alarmMax  = sim_alarm.task.max_latency;
+    pResult->alarmMiss = sim_alarm.task.deadline_miss_cnt;
+    pResult->bgExe     = bgExe;
+    pResult->bgMax     = bgMax;
+}
+
+static void sim_check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("[Cooperate Sim] check failed: %s\r\n", what);
+        sim_errors++;
+    }
+}
+
+/**
+ * @brief 任务组优先级、EDF和饿死保护的上位机仿真。检查告警任务的最大延迟FIFO > EDF > EDF+优先级，
+ * 过载时饿死保护降低背景任务的最大延迟，最后打印pass或者fail。
+ *
+ */
+void cooperate_scheduler_simulation()
+{
+    SimResult_t fifo, edf, prio, overload, starved;
+
+    sim_errors = 0;
+    sim_run("FIFO: same priority, all deadlines 100", 10, 100, 0, 1000, &fifo);
+    sim_run("EDF: alarm deadline 10", 10, 10, 0, 1000, &edf);
+    sim_run("EDF + alarm priority 1", 10, 10, 1, 1000, &prio);
+    sim_run("overload: alarm period 2 priority 1, no starvation protection", 2, 2, 1, 0, &overload);
+    sim_run("overload: alarm period 2 priority 1, starvation 50 ticks", 2, 2, 1, 50, &starved);
+
+    sim_check(edf.alarmMax < fifo.alarmMax, "EDF alarm worst latency below FIFO");
+    sim_check(prio.alarmMax < edf.alarmMax, "EDF + priority alarm worst latency below EDF");
+    sim_check(prio.alarmMax < 10 && prio.alarmMiss == 0, "EDF + priority alarm meets its deadline");
+    sim_check(overload.alarmMax <= prio.alarmMax, "overload without protection still serves the alarm first");
+    sim_check(starved.bgMax < overload.bgMax, "starvation protection lowers background worst latency");
+    sim_check(starved.bgExe > overload.bgExe, "starvation protection runs background tasks more often");
+    sim_check(starved.bgMax <= 100, "starvation protection keeps background within its deadline");
+    printf("[Cooperate Sim] %s\r\n", sim_errors == 0 ? "pass" : "fail");
+}
+#endif
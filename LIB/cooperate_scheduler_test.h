@@ -15,4 +15,7 @@
 
 void cooperate_scheduler_test();
 void period_test();
+#ifdef COOPERATE_SCHEDULER_SIMULATION
+void cooperate_scheduler_simulation();
+#endif
 #endif // !cooperate_scheduler_TEST_H
\ No newline at end of file
@@ -126,3 +126,55 @@ uint32_t cqueue_out(CQueue Q, CObject_t pBuf, uint32_t bufSize)
 
     return ret;
 }
+
+/**
+ * @brief 从队首偏移offset个元素的位置开始复制一部分元素，不出队。
+ *
+ * @param Q
+ * @param offset 相对队首的偏移，单位是元素个数。
+ * @param pBuf 指向存放复制元素内存的指针。
+ * @param bufSize 希望复制的元素个数。
+ * @return uint32_t 实际复制的元素个数。
+ */
+uint32_t cqueue_peek(CQueue Q, uint32_t offset, CObject_t pBuf, uint32_t bufSize)
+{
+    uint32_t ret      = 0;
+    uint32_t size     = cqueue_size(Q);
+    uint8_t *pBufTemp = pBuf;
+    uint32_t idx      = 0;
+
+    if (offset >= size) {
+        return 0;
+    }
+    if (bufSize > size - offset) {
+        bufSize = size - offset;
+    }
+
+    idx = (Q->Front + offset) % Q->Capacity;
+    while (bufSize > 0) {
+        memcpy(pBufTemp, (uint8_t *)(Q->pData) + idx * Q->ItemSize, Q->ItemSize);
+        pBufTemp += Q->ItemSize;
+        idx = (idx + 1) % Q->Capacity;
+        bufSize--;
+        ret++;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief 直接丢弃队首的一部分元素。
+ *
+ * @param Q
+ * @param num 希望丢弃的元素个数。
+ * @return uint32_t 实际丢弃的元素个数。
+ */
+uint32_t cqueue_skip(CQueue Q, uint32_t num)
+{
+    uint32_t size = cqueue_size(Q);
+    if (num > size) {
+        num = size;
+    }
+    Q->Front = (Q->Front + num) % Q->Capacity;
+    return num;
+}
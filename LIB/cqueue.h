@@ -40,6 +40,8 @@ uint8_t cqueue_enqueue(CQueue Q, const CObject_t pX);
 uint8_t cqueue_dequeue(CQueue Q, CObject_t pX);
 uint32_t cqueue_in(CQueue Q, const CObject_t pBuf, uint32_t bufSize);
 uint32_t cqueue_out(CQueue Q, CObject_t pBuf, uint32_t bufSize);
+uint32_t cqueue_peek(CQueue Q, uint32_t offset, CObject_t pBuf, uint32_t bufSize);
+uint32_t cqueue_skip(CQueue Q, uint32_t num);
 
 // 返回队列容量：元素个数
 #define cqueue_capacity(Q) ((Q)->Capacity)
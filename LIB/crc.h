@@ -11,7 +11,12 @@
 #ifndef CRC_H
 #define CRC_H
 #include <stdint.h>
+#define CRC16_MODBUS_INIT 0xFFFFU
 uint16_t CRC16_Modbus(const uint8_t *_pBuf, uint16_t _usLen);
+uint16_t CRC16_Modbus_Update(uint16_t _usCRC, const uint8_t *_pBuf, uint32_t _ulLen);
+uint16_t CRC16_Modbus_Shift(uint16_t _usCRC, uint32_t _ulZeroLen);
+#define CRC16_CCITT_XMODEM_INIT 0x0000U
+uint16_t CRC16_CCITT_Update(uint16_t _usCRC, const uint8_t *_pBuf, uint32_t _ulLen);
 uint32_t CRC32(const uint8_t *_pBuf, uint32_t _ulLen);
 uint32_t CRC32_With(const uint8_t *_pBuf, uint32_t _ulLen, uint32_t _ulCRC);
 #endif // !CRC_H
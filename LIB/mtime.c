@@ -124,7 +124,60 @@ uint8_t mtime_get_week(uint16_t year, uint8_t month, uint8_t day)
 
 /*
  * 功能：
- *     根据UTC时间戳得到对应的日期
+ *     计算公历日期距离1970-01-01的天数，常数时间，不需要按年、按月循环。
+ *     以3月1日作为一年的开始，闰日在一年的最后，每400年(146097天)为一个周期。
+ * 参数：
+ *     year：年份，不小于1970
+ *     month：月份，1-12
+ *     day：日，1-31
+ *
+ * 返回值：
+ *     天数
+ */
+static uint32_t mtime_days_from_civil(uint32_t year, uint32_t month, uint32_t day)
+{
+    uint32_t era = 0;
+    uint32_t yoe = 0; // 400年周期内的年份，0-399
+    uint32_t doy = 0; // 从3月1日开始的一年中的第几天，0-365
+    uint32_t doe = 0; // 400年周期内的第几天，0-146096
+
+    year -= month <= 2;
+    era = year / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    // 719468为0000-03-01到1970-01-01的天数
+    return era * 146097 + doe - 719468;
+}
+
+/*
+ * 功能：
+ *     mtime_days_from_civil的逆运算，根据距离1970-01-01的天数得到公历日期，常数时间。
+ * 参数：
+ *     days：天数
+ *     result：计算出的年、月、日
+ *
+ * 返回值：
+ *     无
+ */
+static void mtime_civil_from_days(uint32_t days, mtime_t *result)
+{
+    uint32_t z   = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp  = (5 * doy + 2) / 153; // 从3月开始的月份，0-11
+    uint32_t m   = mp < 10 ? mp + 3 : mp - 9;
+
+    result->nYear  = (uint16_t)(yoe + era * 400 + (m <= 2));
+    result->nMonth = (uint8_t)m;
+    result->nDay   = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+}
+
+/*
+ * 功能：
+ *     根据UTC时间戳得到对应的日期，常数时间
  * 参数：
  *     utc_sec：给定的UTC时间戳
  *     result：计算出的结果
@@ -134,113 +187,45 @@ uint8_t mtime_get_week(uint16_t year, uint8_t month, uint8_t day)
  */
 void mtime_unix_sec_2_time(unsigned int utc_sec, mtime_t *result)
 {
-    /*----------------------------------------------------------------*/
-    /* Local Variables                                                */
-    /*----------------------------------------------------------------*/
-    int sec, day;
-    uint16_t y;
-    uint8_t m;
-    uint16_t d;
-    // uint8_t dst;
-
-    /*----------------------------------------------------------------*/
-    /* Code Body                                                      */
-    /*----------------------------------------------------------------*/
+    uint32_t day = utc_sec / SEC_PER_DAY;
+    uint32_t sec = utc_sec - day * SEC_PER_DAY;
 
-    // if (daylightSaving) {
-    //     utc_sec += SEC_PER_HOUR;
-    // }
-
-    /* hour, min, sec */
-    /* hour */
-    sec           = utc_sec % SEC_PER_DAY;
     result->nHour = sec / SEC_PER_HOUR;
-
-    /* min */
     sec %= SEC_PER_HOUR;
     result->nMin = sec / SEC_PER_MIN;
-
-    /* sec */
     result->nSec = sec % SEC_PER_MIN;
+    result->wSub = 0;
 
-    /* year, month, day */
-    /* year */
-    /* year */
-    day = utc_sec / SEC_PER_DAY;
-    for (y = UTC_BASE_YEAR; day > 0; y++) {
-        d = (DAY_PER_YEAR + applib_dt_is_leap_year(y));
-        if (day >= d) {
-            day -= d;
-        } else {
-            break;
-        }
-    }
-
-    result->nYear = y;
-
-    for (m = 1; m < MONTH_PER_YEAR; m++) {
-        d = applib_dt_last_day_of_mon(m, y);
-        if (day >= d) {
-            day -= d;
-        } else {
-            break;
-        }
-    }
-
-    result->nMonth = m;
-    result->nDay   = (uint8_t)(day + 1);
-    /* 根据给定的日期得到对应的星期 */
-    result->nWeek = mtime_get_week(result->nYear, result->nMonth, result->nDay);
+    mtime_civil_from_days(day, result);
+    /* 1970-01-01是星期四，和mtime_get_week一样，1 - 星期一 ... 7 - 星期天 */
+    result->nWeek = (uint8_t)((day + 3) % 7 + 1);
 }
 
 /*
  * 功能：
- *     根据时间计算出UTC时间戳
+ *     根据时间计算出UTC时间戳，常数时间
  * 参数：
  *     currTime：给定的时间
  *
  * 返回值：
- *     UTC时间戳
+ *     UTC时间戳，年份小于1970时返回0
  */
 unsigned int mtime_2_unix_sec(mtime_t *currTime)
 {
-    /*----------------------------------------------------------------*/
-    /* Local Variables                                                */
-    /*----------------------------------------------------------------*/
-    uint16_t i;
-    unsigned int no_of_days = 0;
-    int utc_time;
-    // uint8_t dst;
+    uint32_t month = currTime->nMonth;
 
-    /*----------------------------------------------------------------*/
-    /* Code Body                                                      */
-    /*----------------------------------------------------------------*/
     if (currTime->nYear < UTC_BASE_YEAR) {
         return 0;
     }
-
-    /* year */
-    for (i = UTC_BASE_YEAR; i < currTime->nYear; i++) {
-        no_of_days += (DAY_PER_YEAR + applib_dt_is_leap_year(i));
+    // 月份无效时按1月或者12月计算
+    if (month < 1) {
+        month = 1;
+    } else if (month > MONTH_PER_YEAR) {
+        month = MONTH_PER_YEAR;
     }
 
-    /* month */
-    for (i = 1; i < currTime->nMonth; i++) {
-        no_of_days += applib_dt_last_day_of_mon((uint8_t)i, currTime->nYear);
-    }
-
-    /* day */
-    no_of_days += (currTime->nDay - 1);
-
-    /* sec */
-    utc_time = (unsigned int)no_of_days * SEC_PER_DAY + (unsigned int)(currTime->nHour * SEC_PER_HOUR +
-                                                                       currTime->nMin * SEC_PER_MIN + currTime->nSec);
-
-    // if (dst && daylightSaving) {
-    //     utc_time -= SEC_PER_HOUR;
-    // }
-
-    return utc_time;
+    return mtime_days_from_civil(currTime->nYear, month, currTime->nDay) * SEC_PER_DAY +
+           (unsigned int)(currTime->nHour * SEC_PER_HOUR + currTime->nMin * SEC_PER_MIN + currTime->nSec);
 }
 
 // 根据UTC时间戳得到对应的日期字符串
@@ -28,7 +28,7 @@ typedef struct
     uint8_t nHour;
     uint8_t nMin;
     uint8_t nSec;
-    uint8_t nWeek; /* 0 = Sunday */
+    uint8_t nWeek; /* 1 = Monday ... 7 = Sunday */
     uint16_t wSub; // 亚秒
 } mtime_t;
 
@@ -38,7 +38,7 @@ typedef struct
  * @param year
  * @param month
  * @param day
- * @return uint8_t 0 = Sunday
+ * @return uint8_t 1 = Monday ... 7 = Sunday
  */
 uint8_t mtime_get_week(uint16_t year, uint8_t month, uint8_t day);
 void mtime_unix_sec_2_time(unsigned int utc_sec, mtime_t *result); // 根据UTC时间戳得到对应的日期
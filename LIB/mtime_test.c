@@ -0,0 +1,144 @@
+/**
+ * @file mtime_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 日期转换测试：1970到2106年逐天往返转换并和逐年逐月累加的参考实现比较，以及转换耗时对比。
+ * 只依赖HDL_CPU_Time的us计时，可以在目标板上运行，也可以在PC上运行。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include "mtime_test.h"
+#include "HDL_CPU_Time.h"
+#include <stdio.h>
+
+// unsigned int时间戳能表示的最后一天，2106-02-07
+#define MTIME_TEST_LAST_DAY (0xFFFFFFFFUL / 86400UL)
+
+static uint8_t ref_is_leap_year(uint32_t year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static uint8_t ref_days_of_month(uint32_t month, uint32_t year)
+{
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return days[month - 1] + (month == 2 ? ref_is_leap_year(year) : 0);
+}
+
+/**
+ * @brief 参考实现，逐年、逐月累加，和原来的mtime_unix_sec_2_time相同。
+ *
+ */
+static void ref_unix_sec_2_time(uint32_t utc_sec, mtime_t *result)
+{
+    uint32_t day = utc_sec / 86400;
+    uint32_t sec = utc_sec % 86400;
+    uint32_t y   = 1970;
+    uint32_t m   = 1;
+
+    result->nHour = sec / 3600;
+    result->nMin  = sec % 3600 / 60;
+    result->nSec  = sec % 60;
+    while (day >= 365U + ref_is_leap_year(y)) {
+        day -= 365U + ref_is_leap_year(y);
+        y++;
+    }
+    while (day >= ref_days_of_month(m, y)) {
+        day -= ref_days_of_month(m, y);
+        m++;
+    }
+    result->nYear  = y;
+    result->nMonth = m;
+    result->nDay   = day + 1;
+    result->nWeek  = mtime_get_week(result->nYear, result->nMonth, result->nDay);
+}
+
+static uint32_t mtime_check(uint32_t utc_sec)
+{
+    mtime_t t;
+    mtime_t ref;
+    uint32_t back = 0;
+
+    mtime_unix_sec_2_time(utc_sec, &t);
+    ref_unix_sec_2_time(utc_sec, &ref);
+    back = mtime_2_unix_sec(&t);
+    if (t.nYear != ref.nYear || t.nMonth != ref.nMonth || t.nDay != ref.nDay || t.nHour != ref.nHour ||
+        t.nMin != ref.nMin || t.nSec != ref.nSec || t.nWeek != ref.nWeek || back != utc_sec) {
+        printf("[mtime Test]: %u -> %04u-%02u-%02u %02u:%02u:%02u week %u -> %u, expect %04u-%02u-%02u week %u\r\n",
+               utc_sec, t.nYear, t.nMonth, t.nDay, t.nHour, t.nMin, t.nSec, t.nWeek, back, ref.nYear, ref.nMonth,
+               ref.nDay, ref.nWeek);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 1970-01-01到2106-02-07逐天检查：时间戳转日期和参考实现一致，日期转回时间戳不变。
+ * 每天检查第一秒、最后一秒和一个随天数变化的时刻，最后检查0xFFFFFFFF。
+ *
+ * @return uint32_t 错误数，0表示通过。
+ */
+uint32_t mtime_round_trip_test()
+{
+    uint32_t error = 0;
+    uint32_t base  = 0;
+
+    for (uint32_t day = 0; day <= MTIME_TEST_LAST_DAY && error < 10; day++) {
+        base = day * 86400UL;
+        error += mtime_check(base);
+        error += mtime_check(base + (day * 7919UL) % 86400UL);
+        if (day < MTIME_TEST_LAST_DAY) {
+            error += mtime_check(base + 86399UL);
+        }
+    }
+    error += mtime_check(0xFFFFFFFFUL);
+    printf("[mtime Test]: round trip 1970-2106 %u days, %s, error:%u\r\n", (unsigned int)MTIME_TEST_LAST_DAY + 1,
+           error == 0 ? "pass" : "fail", error);
+    return error;
+}
+
+/**
+ * @brief 常数时间转换和逐年累加的参考实现的耗时对比，时间戳均匀分布在1970到2106年。
+ *
+ */
+void mtime_benchmark()
+{
+    const uint32_t n       = 20000;
+    const uint32_t step    = 0xFFFFFFFFUL / n;
+    volatile uint32_t sink = 0;
+    uint32_t begin         = 0;
+    uint32_t t_new         = 0;
+    uint32_t t_ref         = 0;
+    uint32_t t_back        = 0;
+    mtime_t t;
+
+    begin = HDL_CPU_Time_GetUsTick();
+    for (uint32_t i = 0; i < n; i++) {
+        mtime_unix_sec_2_time(i * step, &t);
+        sink += t.nDay;
+    }
+    t_new = HDL_CPU_Time_GetUsTick() - begin;
+
+    begin = HDL_CPU_Time_GetUsTick();
+    for (uint32_t i = 0; i < n; i++) {
+        ref_unix_sec_2_time(i * step, &t);
+        sink += t.nDay;
+    }
+    t_ref = HDL_CPU_Time_GetUsTick() - begin;
+
+    begin = HDL_CPU_Time_GetUsTick();
+    for (uint32_t i = 0; i < n; i++) {
+        t.nYear  = 1970 + i % 136;
+        t.nMonth = 1 + i % 12;
+        t.nDay   = 1 + i % 28;
+        sink += mtime_2_unix_sec(&t);
+    }
+    t_back = HDL_CPU_Time_GetUsTick() - begin;
+
+    printf("[mtime Test]: %u conversions, unix_sec_2_time %u us (loop reference %u us), 2_unix_sec %u us\r\n", n, t_new,
+           t_ref, t_back);
+    (void)sink;
+}
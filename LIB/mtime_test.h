@@ -0,0 +1,19 @@
+/**
+ * @file mtime_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef MTIME_TEST_H
+#define MTIME_TEST_H
+#include <stdint.h>
+#include "mtime.h"
+
+uint32_t mtime_round_trip_test();
+void mtime_benchmark();
+#endif // !MTIME_TEST_H
@@ -0,0 +1,131 @@
+/**
+ * @file task_profile.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief scheduler和cooperate_scheduler共用的任务执行时间统计。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <string.h>
+#include "task_profile.h"
+
+#if TASK_PROFILE_ENABLE
+#include "HDL_CPU_Time.h"
+#include "log.h"
+
+/**
+ * @brief 清空统计。
+ *
+ * @param prof
+ */
+void task_profile_reset(TaskProfile_t *prof)
+{
+    memset(prof, 0, sizeof(TaskProfile_t));
+    prof->min_us = UINT32_MAX;
+}
+
+/**
+ * @brief 记录一次调用的执行时间。
+ *
+ * @param prof
+ * @param exe_us 执行时间，us。
+ */
+void task_profile_exe_time(TaskProfile_t *prof, uint32_t exe_us)
+{
+    // 静态初始化为0的统计结构，第一次记录时当作空的
+    if (prof->call_cnt == 0) {
+        prof->min_us = exe_us;
+    }
+    prof->call_cnt++;
+    prof->total_us += exe_us;
+    prof->min_us = exe_us < prof->min_us ? exe_us : prof->min_us;
+    prof->max_us = exe_us > prof->max_us ? exe_us : prof->max_us;
+}
+
+/**
+ * @brief 记录一次按周期释放的执行：开始时刻的延迟和是否超过截止时刻。
+ * 截止时刻为下一个周期的到期时刻，即延迟加上执行时间超过一个周期算一次超时。
+ *
+ * @param prof
+ * @param late_tick 实际开始执行时刻比到期时刻晚了多少tick。
+ * @param exe_us 执行时间，us。
+ * @param period_tick 任务周期，tick。
+ */
+void task_profile_release(TaskProfile_t *prof, uint32_t late_tick, uint32_t exe_us, uint32_t period_tick)
+{
+    uint32_t bin = 0;
+
+    prof->release_cnt++;
+    if ((uint64_t)late_tick * HDL_CPU_TIME_OEN_TICK_TIME + exe_us > (uint64_t)period_tick * HDL_CPU_TIME_OEN_TICK_TIME) {
+        prof->deadline_miss++;
+    }
+    while (late_tick != 0 && bin < TASK_PROFILE_JITTER_BINS - 1) {
+        late_tick >>= 1;
+        bin++;
+    }
+    prof->jitter_hist[bin]++;
+}
+
+/**
+ * @brief 按总执行时间从大到小插入到top数组中，只保留前top_n个。
+ *
+ * @param top
+ * @param pnum top中当前的个数。
+ * @param top_n top的容量。
+ * @param prof
+ * @param name
+ * @param id
+ */
+void task_profile_top_insert(TaskProfileTop_t *top, uint32_t *pnum, uint32_t top_n, const TaskProfile_t *prof, const char *name, const void *id)
+{
+    uint32_t pos = *pnum;
+
+    while (pos > 0 && top[pos - 1].prof->total_us < prof->total_us) {
+        if (pos < top_n) {
+            top[pos] = top[pos - 1];
+        }
+        pos--;
+    }
+    if (pos >= top_n) {
+        return;
+    }
+    top[pos].prof = prof;
+    top[pos].name = name;
+    top[pos].id   = id;
+    *pnum += *pnum < top_n;
+}
+
+/**
+ * @brief 打印top数组。
+ *
+ * @param top
+ * @param num
+ * @param title
+ */
+void task_profile_top_show(const TaskProfileTop_t *top, uint32_t num, const char *title)
+{
+    const TaskProfile_t *prof = NULL;
+    uint32_t avg_us           = 0;
+
+    ULOG_INFO("[%s] top %u by total exe time:", title, num);
+    ULOG_INFO("%-3s %-16s %8s %8s %8s %8s %10s %6s %s", "#", "task", "calls", "min_us", "avg_us", "max_us", "total_ms", "miss", "late(0,1,2-3,4-7,...)tick");
+    for (uint32_t i = 0; i < num; i++) {
+        prof   = top[i].prof;
+        avg_us = prof->call_cnt ? (uint32_t)(prof->total_us / prof->call_cnt) : 0;
+        if (top[i].name != NULL) {
+            ULOG_INFO("%-3u %-16s %8u %8u %8u %8u %10u %6u %u,%u,%u,%u,%u,%u,%u,%u", i, top[i].name, prof->call_cnt,
+                      prof->call_cnt ? prof->min_us : 0, avg_us, prof->max_us, (uint32_t)(prof->total_us / 1000), prof->deadline_miss,
+                      prof->jitter_hist[0], prof->jitter_hist[1], prof->jitter_hist[2], prof->jitter_hist[3],
+                      prof->jitter_hist[4], prof->jitter_hist[5], prof->jitter_hist[6], prof->jitter_hist[7]);
+        } else {
+            ULOG_INFO("%-3u 0x%-14lx %8u %8u %8u %8u %10u %6u %u,%u,%u,%u,%u,%u,%u,%u", i, (unsigned long)top[i].id, prof->call_cnt,
+                      prof->call_cnt ? prof->min_us : 0, avg_us, prof->max_us, (uint32_t)(prof->total_us / 1000), prof->deadline_miss,
+                      prof->jitter_hist[0], prof->jitter_hist[1], prof->jitter_hist[2], prof->jitter_hist[3],
+                      prof->jitter_hist[4], prof->jitter_hist[5], prof->jitter_hist[6], prof->jitter_hist[7]);
+        }
+    }
+}
+#endif
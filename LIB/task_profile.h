@@ -0,0 +1,52 @@
+/**
+ * @file task_profile.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief scheduler和cooperate_scheduler共用的任务执行时间统计。
+ * TASK_PROFILE_ENABLE为0时统计字段和统计代码都不编译进去。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef TASK_PROFILE_H
+#define TASK_PROFILE_H
+#include <stdint.h>
+#include <stdbool.h>
+
+// 任务执行时间统计开关
+#ifndef TASK_PROFILE_ENABLE
+#define TASK_PROFILE_ENABLE 0
+#endif
+
+// 调度延迟直方图的桶数，第0个桶为延迟0 tick，第k个桶为[2^(k-1), 2^k) tick，最后一个桶包含更大的延迟
+#define TASK_PROFILE_JITTER_BINS 8
+// 一次打印的最多任务数
+#define TASK_PROFILE_TOP_MAX     16
+
+typedef struct tagTaskProfile_t {
+    uint32_t call_cnt;        // 调用次数，包括cooperate_scheduler中资源忙的调用
+    uint32_t min_us;          // 最短执行时间，us
+    uint32_t max_us;          // 最长执行时间，us
+    uint64_t total_us;        // 总执行时间，us，平均值为total_us/call_cnt
+    uint32_t release_cnt;     // 按周期释放并执行成功的次数
+    uint32_t deadline_miss;   // 执行结束时已经超过下一个周期的次数
+    uint32_t jitter_hist[TASK_PROFILE_JITTER_BINS]; // 实际开始执行时刻相对到期时刻的延迟分布
+} TaskProfile_t;
+
+typedef struct tagTaskProfileTop_t {
+    const TaskProfile_t *prof;
+    const char *name; // 可以为NULL
+    const void *id;   // name为NULL时打印的任务标识，一般为任务对象的地址，可以在map文件中查到
+} TaskProfileTop_t;
+
+#if TASK_PROFILE_ENABLE
+void task_profile_reset(TaskProfile_t *prof);
+void task_profile_exe_time(TaskProfile_t *prof, uint32_t exe_us);
+void task_profile_release(TaskProfile_t *prof, uint32_t late_tick, uint32_t exe_us, uint32_t period_tick);
+void task_profile_top_insert(TaskProfileTop_t *top, uint32_t *pnum, uint32_t top_n, const TaskProfile_t *prof, const char *name, const void *id);
+void task_profile_top_show(const TaskProfileTop_t *top, uint32_t num, const char *title);
+#endif
+
+#endif // !TASK_PROFILE_H
@@ -0,0 +1,285 @@
+/**
+ * @file task_profile_test.c
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief 任务执行时间统计测试，编译时定义TASK_PROFILE_ENABLE=1：
+ * 统计函数的最短、最长、平均执行时间，截止时刻超时的边界，调度延迟直方图每个桶的边界，按总执行时间排序和截断；
+ * 上位机上再定义COOPERATE_SCHEDULER_SIMULATION，用虚拟时钟运行cooperate_scheduler，检查调度器记录的统计和
+ * 打印出来的排序结果，延迟和超时次数和主机负载无关。scheduler和cooperate_scheduler的头文件不能同时包含，
+ * scheduler的部分在BFL/scheduler_test.c的scheduler_profile_check中，打印的截获和解析由这里提供。
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include "task_profile_test.h"
+#include "HDL_CPU_Time.h"
+#include "log.h"
+
+#if TASK_PROFILE_ENABLE
+#include "cooperate_scheduler.h"
+
+#define TICK_US       ((uint32_t)HDL_CPU_TIME_OEN_TICK_TIME)
+// 截获打印的行数和每行的长度
+#define CAPTURE_LINES 8
+#define CAPTURE_LEN   128
+
+static char _gLines[CAPTURE_LINES][CAPTURE_LEN];
+static uint32_t _gLineNum  = 0;
+static uint32_t _gErrorCnt = 0;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        _gErrorCnt++;
+        ULOG_ERROR("[Profile Test] check failed: %s", what);
+    }
+}
+
+static void capture_logger(ulog_level_t severity, char *msg)
+{
+    (void)severity;
+    if (_gLineNum < CAPTURE_LINES) {
+        strncpy(_gLines[_gLineNum], msg, CAPTURE_LEN - 1);
+        _gLines[_gLineNum][CAPTURE_LEN - 1] = '\0';
+    }
+    _gLineNum++;
+}
+
+/**
+ * @brief 截获dump(top_n)打印的行。
+ *
+ * @param dump scheduler_profile_dump或者cooperate_scheduler_profile_dump。
+ * @param top_n
+ * @return uint32_t 打印的行数。
+ */
+uint32_t task_profile_test_capture(void (*dump)(uint32_t top_n), uint32_t top_n)
+{
+    memset(_gLines, 0, sizeof(_gLines));
+    _gLineNum = 0;
+    ULOG_SUBSCRIBE(capture_logger, ULOG_INFO_LEVEL);
+    dump(top_n);
+    ULOG_UNSUBSCRIBE(capture_logger);
+    return _gLineNum;
+}
+
+/**
+ * @brief 截获的第line行。
+ *
+ */
+const char *task_profile_test_line(uint32_t line)
+{
+    return line < CAPTURE_LINES ? _gLines[line] : "";
+}
+
+/**
+ * @brief 截获的第line行是排在第index的任务，name不为NULL时按名称比较，否则按地址id比较。
+ *
+ */
+bool task_profile_test_row(uint32_t line, uint32_t index, const char *name, const void *id)
+{
+    unsigned int idx   = 0;
+    unsigned long addr = 0;
+    char rowName[17];
+
+    if (line >= CAPTURE_LINES) {
+        return false;
+    }
+    if (name != NULL) {
+        return sscanf(_gLines[line], "%u %16s", &idx, rowName) == 2 && idx == index && strcmp(rowName, name) == 0;
+    }
+    return sscanf(_gLines[line], "%u 0x%lx", &idx, &addr) == 2 && idx == index && addr == (unsigned long)id;
+}
+
+static uint32_t hist_sum(const TaskProfile_t *prof)
+{
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < TASK_PROFILE_JITTER_BINS; i++) {
+        sum += prof->jitter_hist[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief 平均执行时间在最短和最长之间。
+ *
+ */
+static bool mean_in_range(const TaskProfile_t *prof)
+{
+    uint64_t mean = prof->call_cnt ? prof->total_us / prof->call_cnt : 0;
+
+    return prof->call_cnt > 0 && prof->min_us <= mean && mean <= prof->max_us;
+}
+
+static void exe_time_test()
+{
+    TaskProfile_t prof;
+    static TaskProfile_t zero;
+
+    task_profile_reset(&prof);
+    check(prof.call_cnt == 0 && prof.min_us == UINT32_MAX && prof.max_us == 0 && prof.total_us == 0, "reset");
+    task_profile_exe_time(&prof, 30);
+    task_profile_exe_time(&prof, 10);
+    task_profile_exe_time(&prof, 20);
+    check(prof.call_cnt == 3 && prof.min_us == 10 && prof.max_us == 30, "min max");
+    check(prof.total_us == 60 && prof.total_us / prof.call_cnt == 20, "mean");
+    check(prof.release_cnt == 0, "exe time does not count releases");
+
+    // 静态初始化为0的统计结构，第一次记录的时间是最短时间
+    task_profile_exe_time(&zero, 50);
+    check(zero.call_cnt == 1 && zero.min_us == 50 && zero.max_us == 50, "zero initialised min");
+}
+
+static void release_test()
+{
+    // 延迟和直方图的桶：0,1,2-3,4-7,8-15,16-31,32-63,>=64
+    static const uint32_t late[] = {0, 1, 2, 3, 4, 7, 8, 15, 16, 31, 32, 63, 64, 127, 128, 100000};
+    static const uint32_t bin[]  = {0, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 7, 7};
+    TaskProfile_t prof;
+    char what[48];
+
+    for (uint32_t i = 0; i < sizeof(late) / sizeof(late[0]); i++) {
+        task_profile_reset(&prof);
+        task_profile_release(&prof, late[i], 0, UINT32_MAX);
+        snprintf(what, sizeof(what), "late %u in bin %u", late[i], bin[i]);
+        check(prof.release_cnt == 1 && prof.jitter_hist[bin[i]] == 1 && hist_sum(&prof) == 1, what);
+    }
+
+    // 截止时刻是下一个周期的到期时刻，延迟加执行时间等于周期不算超时
+    task_profile_reset(&prof);
+    task_profile_release(&prof, 0, 10 * TICK_US, 10);
+    check(prof.deadline_miss == 0, "exe time equal to period meets deadline");
+    task_profile_release(&prof, 0, 10 * TICK_US + 1, 10);
+    check(prof.deadline_miss == 1, "exe time over period misses deadline");
+    task_profile_release(&prof, 9, TICK_US, 10);
+    check(prof.deadline_miss == 1, "late plus exe time equal to period meets deadline");
+    task_profile_release(&prof, 9, TICK_US + 1, 10);
+    check(prof.deadline_miss == 2, "late plus exe time over period misses deadline");
+    task_profile_release(&prof, 10, 0, 10);
+    check(prof.deadline_miss == 2, "late by one period without exe time meets deadline");
+    check(prof.release_cnt == 5 && hist_sum(&prof) == 5, "release count");
+}
+
+static void top_test()
+{
+    static const uint32_t total[] = {30, 50, 10, 40, 20, 50};
+    TaskProfile_t prof[6];
+    TaskProfileTop_t top[3];
+    uint32_t num = 0;
+
+    for (uint32_t i = 0; i < 6; i++) {
+        task_profile_reset(&prof[i]);
+        task_profile_exe_time(&prof[i], total[i]);
+        task_profile_top_insert(top, &num, 3, &prof[i], NULL, &prof[i]);
+    }
+    // 从大到小，总时间相同时先插入的在前，只保留前3个
+    check(num == 3, "top keeps top_n");
+    check(top[0].prof == &prof[1] && top[1].prof == &prof[5] && top[2].prof == &prof[3], "top sorted by total time");
+    check(top[0].id == &prof[1] && top[0].name == NULL, "top id");
+}
+
+#ifdef COOPERATE_SCHEDULER_SIMULATION
+#define SIM_START_TICK 1000
+
+uint32_t cooperate_sim_tick = 0;
+
+typedef struct {
+    TaskNode_t task;
+    uint32_t exeUs;    // 执行成功时的执行时间
+    uint32_t busyLeft; // 还有多少次调用返回资源忙
+} CoopTask_t;
+
+static CoopTask_t _gCoopSlow;
+static CoopTask_t _gCoopFast;
+
+static bool coop_fun(void *arg)
+{
+    CoopTask_t *pTask = (CoopTask_t *)arg;
+
+    if (pTask->busyLeft > 0) {
+        pTask->busyLeft--;
+        return false;
+    }
+    HDL_CPU_Time_DelayUs(pTask->exeUs);
+    return true;
+}
+
+static void coop_task_init(CoopTask_t *pTask, const char *name, uint32_t exeUs, uint32_t busy)
+{
+    memset(pTask, 0, sizeof(CoopTask_t));
+    pTask->task.name      = (char *)name;
+    pTask->task.exe_times = cooperate_scheduler_EXE_TIMES_INF;
+    pTask->task.period    = 10;
+    pTask->task.fun.fun   = coop_fun;
+    pTask->task.fun.arg   = pTask;
+    pTask->exeUs          = exeUs;
+    pTask->busyLeft       = busy;
+}
+
+static void cooperate_profile_check()
+{
+    static CooperativeGroup_t group;
+    const TaskProfile_t *pSlow = &_gCoopSlow.task.profile;
+    const TaskProfile_t *pFast = &_gCoopFast.task.profile;
+
+    cooperate_sim_tick = SIM_START_TICK;
+    cooperate_scheduler_init();
+    memset(&group, 0, sizeof(group));
+    cooperate_group_init(&group);
+    cooperate_scheduler_register(&group);
+    coop_task_init(&_gCoopSlow, "slow", TICK_US + TICK_US / 2, 0);
+    coop_task_init(&_gCoopFast, "fast", 0, 3);
+    cooperate_group_register(&group, &_gCoopSlow.task);
+    cooperate_group_register(&group, &_gCoopFast.task);
+    cooperate_scheduler_profile_reset();
+
+    for (uint32_t i = 0; i < 100; i++) {
+        cooperate_scheduler_handler();
+        cooperate_sim_tick++;
+    }
+
+    // 资源忙的调用只统计执行时间，不算一次释放
+    check(pSlow->release_cnt == _gCoopSlow.task.exe_cnt && pSlow->call_cnt == pSlow->release_cnt, "cooperate slow task releases");
+    check(pFast->release_cnt == _gCoopFast.task.exe_cnt && pFast->call_cnt == pFast->release_cnt + 3,
+          "cooperate busy calls counted as calls only");
+    check(pSlow->release_cnt >= 9 && pFast->release_cnt >= 9, "cooperate tasks ran every period");
+    check(pSlow->min_us >= TICK_US + TICK_US / 2 && mean_in_range(pSlow) && mean_in_range(pFast), "cooperate min max mean");
+    check(hist_sum(pSlow) == pSlow->release_cnt && hist_sum(pFast) == pFast->release_cnt, "cooperate histogram counts releases");
+    check(group.profile.call_cnt == pSlow->call_cnt + pFast->call_cnt && group.profile.total_us == pSlow->total_us + pFast->total_us &&
+              group.profile.release_cnt == 0,
+          "cooperate group sums its tasks");
+
+    // 先打印任务组，再打印任务，任务按总执行时间从大到小
+    check(task_profile_test_capture(cooperate_scheduler_profile_dump, 2) == 7 &&
+              strstr(task_profile_test_line(0), "[Cooperate Group] top 1") != NULL && task_profile_test_row(2, 0, NULL, &group),
+          "cooperate dump group");
+    check(strstr(task_profile_test_line(3), "[Cooperate Task] top 2") != NULL && task_profile_test_row(5, 0, "slow", NULL) &&
+              task_profile_test_row(6, 1, "fast", NULL),
+          "cooperate dump tasks sorted");
+
+    cooperate_scheduler_unregister(&group);
+}
+#endif
+
+/**
+ * @brief 任务执行时间统计测试。
+ *
+ * @return uint32_t 错误数。
+ */
+uint32_t task_profile_test()
+{
+    _gErrorCnt = 0;
+    exe_time_test();
+    release_test();
+    top_test();
+#ifdef COOPERATE_SCHEDULER_SIMULATION
+    cooperate_profile_check();
+#endif
+    ULOG_INFO("[Profile Test] %s", _gErrorCnt == 0 ? "pass" : "fail");
+    return _gErrorCnt;
+}
+#endif
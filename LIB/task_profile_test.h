@@ -0,0 +1,24 @@
+/**
+ * @file task_profile_test.h
+ * @author Liu Yuanlin (liuyuanlins@outlook.com)
+ * @brief
+ * @version 0.1
+ * @date 2023-10-24
+ * @last modified 2023-10-24
+ *
+ * @copyright Copyright (c) 2023 Liu Yuanlin Personal.
+ *
+ */
+#ifndef TASK_PROFILE_TEST_H
+#define TASK_PROFILE_TEST_H
+#include <stdint.h>
+#include <stdbool.h>
+#include "task_profile.h"
+
+#if TASK_PROFILE_ENABLE
+uint32_t task_profile_test();
+uint32_t task_profile_test_capture(void (*dump)(uint32_t top_n), uint32_t top_n);
+const char *task_profile_test_line(uint32_t line);
+bool task_profile_test_row(uint32_t line, uint32_t index, const char *name, const void *id);
+#endif
+#endif // !TASK_PROFILE_TEST_H
@@ -74,6 +74,8 @@ typedef struct _USBD_STORAGE {
     int8_t (*Write)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
     int8_t (*GetMaxLun)(void);
     int8_t *pInquiry;
+    // 把缓存中的数据写入存储器，SYNCHRONIZE CACHE、允许移除和弹出时调用，可以为NULL
+    int8_t (*Sync)(uint8_t lun);
 
 } USBD_StorageTypeDef;
 
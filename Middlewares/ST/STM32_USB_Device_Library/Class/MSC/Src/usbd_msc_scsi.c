@@ -92,6 +92,8 @@ static int8_t SCSI_Write12(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *param
 static int8_t SCSI_Read10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
 static int8_t SCSI_Read12(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
 static int8_t SCSI_Verify10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_SynchronizeCache(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params);
+static int8_t SCSI_Sync(USBD_HandleTypeDef *pdev, uint8_t lun);
 static int8_t SCSI_CheckAddressRange(USBD_HandleTypeDef *pdev, uint8_t lun,
                                      uint32_t blk_offset, uint32_t blk_nbr);
 
@@ -190,6 +192,11 @@ int8_t SCSI_ProcessCmd(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *cmd)
       ret = SCSI_Verify10(pdev, lun, cmd);
       break;
 
+    case SCSI_SYNCHRONIZE_CACHE10:
+    case SCSI_SYNCHRONIZE_CACHE16:
+      ret = SCSI_SynchronizeCache(pdev, lun, cmd);
+      break;
+
     default:
       SCSI_SenseCode(pdev, lun, ILLEGAL_REQUEST, INVALID_CDB);
       hmsc->bot_status = USBD_BOT_STATUS_ERROR;
@@ -624,6 +631,12 @@ static int8_t SCSI_StartStopUnit(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t
     return -1;
   }
 
+  /* STOP or eject: write back cached data before the host powers down or removes the medium */
+  if (((params[4] & 0x1U) == 0U) && (SCSI_Sync(pdev, lun) < 0))
+  {
+    return -1;
+  }
+
   if ((params[4] & 0x3U) == 0x1U) /* START=1 */
   {
     hmsc->scsi_medium_state = SCSI_MEDIUM_UNLOCKED;
@@ -665,6 +678,11 @@ static int8_t SCSI_AllowPreventRemovable(USBD_HandleTypeDef *pdev, uint8_t lun,
 
   if (params[4] == 0U)
   {
+    /* Removal allowed: write back cached data first */
+    if (SCSI_Sync(pdev, lun) < 0)
+    {
+      return -1;
+    }
     hmsc->scsi_medium_state = SCSI_MEDIUM_UNLOCKED;
   }
   else
@@ -678,6 +696,49 @@ static int8_t SCSI_AllowPreventRemovable(USBD_HandleTypeDef *pdev, uint8_t lun,
 }
 
 
+/**
+  * @brief  SCSI_Sync
+  *         Write back data cached by the storage interface
+  * @param  lun: Logical unit number
+  * @retval status
+  */
+static int8_t SCSI_Sync(USBD_HandleTypeDef *pdev, uint8_t lun)
+{
+  USBD_StorageTypeDef *storage = (USBD_StorageTypeDef *)pdev->pUserDatas[USBD_MSC_USERDATA_ID];
+
+  if ((storage->Sync != NULL) && (storage->Sync(lun) < 0))
+  {
+    SCSI_SenseCode(pdev, lun, HARDWARE_ERROR, WRITE_FAULT);
+    return -1;
+  }
+
+  return 0;
+}
+
+
+/**
+  * @brief  SCSI_SynchronizeCache
+  *         Process Synchronize Cache (10)/(16) command
+  * @param  lun: Logical unit number
+  * @param  params: Command parameters
+  * @retval status
+  */
+static int8_t SCSI_SynchronizeCache(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params)
+{
+  UNUSED(params);
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassDatas[USBD_MSC_CLASS_ID];
+
+  if (hmsc == NULL)
+  {
+    return -1;
+  }
+
+  hmsc->bot_data_length = 0U;
+
+  return SCSI_Sync(pdev, lun);
+}
+
+
 /**
   * @brief  SCSI_Read10
   *         Process Read10 command
@@ -22,7 +22,9 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN INCLUDE */
+#include <string.h>
 #include "usbd_composite.h"
+#include "log.h"
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -94,6 +96,8 @@ uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
 uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
 
 /* USER CODE BEGIN PRIVATE_VARIABLES */
+// "logtail N"命令默认读出的Flash日志条数
+#define CDC_LOGTAIL_DEFAULT 100U
 
 /* USER CODE END PRIVATE_VARIABLES */
 
@@ -262,6 +266,20 @@ static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
+#if LOG_FLASH_ENABLE
+  // "logtail N"读出最近N条Flash日志，在主循环中输出
+  if (*Len >= 7 && memcmp(Buf, "logtail", 7) == 0) {
+    uint32_t n = 0;
+    for (uint32_t i = 7; i < *Len; i++) {
+      if (Buf[i] >= '0' && Buf[i] <= '9') {
+        n = n * 10 + (Buf[i] - '0');
+      }
+    }
+    log_flash_dump(n != 0 ? n : CDC_LOGTAIL_DEFAULT, log_cdc_write);
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+    return (USBD_OK);
+  }
+#endif
   //echo 
   CDC_Transmit_FS(Buf,*Len);
   USBD_CDC_ReceivePacket(&hUsbDeviceFS);
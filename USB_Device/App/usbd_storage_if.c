@@ -161,9 +161,11 @@ static int8_t STORAGE_IsWriteProtected_FS(uint8_t lun);
 static int8_t STORAGE_Read_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
 static int8_t STORAGE_Write_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
 static int8_t STORAGE_GetMaxLun_FS(void);
+static int8_t STORAGE_Sync_FS(uint8_t lun);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
 #include "CHIP_W25Q512.h"
+#include "CHIP_W25Q512_MSC.h"
 #include "./sdcard/bsp_spi_sdcard.h"
 #include "log.h"
 /* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
@@ -181,7 +183,8 @@ USBD_StorageTypeDef USBD_Storage_Interface_fops_FS =
         STORAGE_Read_FS,
         STORAGE_Write_FS,
         STORAGE_GetMaxLun_FS,
-        (int8_t *)STORAGE_Inquirydata_FS};
+        (int8_t *)STORAGE_Inquirydata_FS,
+        STORAGE_Sync_FS};
 
 /* Private functions ---------------------------------------------------------*/
 /**
@@ -230,7 +233,8 @@ int8_t STORAGE_GetCapacity_FS(uint8_t lun, uint32_t *block_num, uint16_t *block_
     int8_t ret = USBD_OK;
     switch (lun) {
         case LUN_SPI_FLASH: // LUN 1: SPI 闪存
-            *block_num  = CHIP_W25Q512_GetSectorNum();
+            // 末尾的日志分区不给主机使用
+            *block_num  = CHIP_W25Q512_MSC_SECTOR_NUM;
             *block_size = CHIP_W25Q512_GetSectorSize();
             break;
 
@@ -296,11 +300,9 @@ int8_t STORAGE_Read_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t bl
     int8_t ret = USBD_OK;
     switch (lun) {
         case LUN_SPI_FLASH: // LUN 1: SPI 闪存
-            for (uint32_t i = 0; i < blk_len; i++) {
-                if (CHIP_W25Q512_read_one_sector(blk_addr + i, buf + i * W25Q512_SECTOR_SIZE) == 0) {
-                    ret = USBD_FAIL;
-                    break;
-                }
+            // 顺序读取时数据来自预读缓冲区，返回前启动下一个扇区的预读
+            if (CHIP_W25Q512_MSC_read(blk_addr, buf, blk_len) != 0) {
+                ret = USBD_FAIL;
             }
             break;
 
@@ -333,11 +335,9 @@ int8_t STORAGE_Write_FS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t b
     switch (lun) {
 
         case LUN_SPI_FLASH: // LUN 1: SPI 闪存
-            for (uint32_t i = 0; i < blk_len; i++) {
-                if (w25q512_write_one_sector(blk_addr + i, buf + i * W25Q512_SECTOR_SIZE) != 0) {
-                    ret = USBD_FAIL;
-                    break;
-                }
+            // 写入写回缓存，写入另一个扇区或者主循环中超时后才写入Flash
+            if (CHIP_W25Q512_MSC_write(blk_addr, buf, blk_len) != 0) {
+                ret = USBD_FAIL;
             }
             break;
 
@@ -369,6 +369,33 @@ int8_t STORAGE_GetMaxLun_FS(void)
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+/**
+ * @brief 主机发出SYNCHRONIZE CACHE、允许移除或者弹出时把写回缓存写入Flash，在USB中断中调用。
+ * @param  lun: .
+ * @retval USBD_OK if all operations are OK else USBD_FAIL
+ */
+int8_t STORAGE_Sync_FS(uint8_t lun)
+{
+    int8_t ret = USBD_OK;
+
+    // SD卡没有写回缓存
+    if (lun == LUN_SPI_FLASH && CHIP_W25Q512_MSC_flush() != 0) {
+        ret = USBD_FAIL;
+    }
+    return ret;
+}
+
+/**
+ * @brief 在主循环中调用，把超时的写回缓存分步写入Flash、丢弃过期的预读数据。
+ * 读写缓存也在USB中断中使用，每一步期间屏蔽USB中断。每一步只读出比较或者发出一个擦除、编程命令，
+ * 不等待擦除和编程完成，屏蔽的时间很短；USB中断中的读取会先等待正在进行的擦除、编程。
+ */
+void STORAGE_Poll_FS(void)
+{
+    HAL_NVIC_DisableIRQ(USB_LP_IRQn);
+    CHIP_W25Q512_MSC_handler();
+    HAL_NVIC_EnableIRQ(USB_LP_IRQn);
+}
 
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
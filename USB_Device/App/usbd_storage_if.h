@@ -104,6 +104,7 @@ extern USBD_StorageTypeDef USBD_Storage_Interface_fops_FS;
   */
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+void STORAGE_Poll_FS(void);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 
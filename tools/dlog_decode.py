@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+dlog_decode.py - 还原BFL/dlog.c输出的二进制日志。
+
+记录格式（小端）：
+| 0xD1 | argc(1) | level(1) | seq(1) | fmt地址(4) | 时间戳us(4) | 参数(4*argc) |
+格式字符串按地址从固件ELF(.axf)的可加载段中读取。二进制记录和文本日志混在同一个调试口中，
+不是合法记录的字节按文本原样输出。
+
+用法：
+    python dlog_decode.py RTU_Dev_V2_0.axf capture.bin
+    python dlog_decode.py RTU_Dev_V2_0.axf --serial COM3 --baud 1500000   (需要pyserial)
+"""
+import argparse
+import re
+import struct
+import sys
+
+DLOG_SYNC = 0xD1
+DLOG_HEADER_LEN = 12
+DLOG_ARG_MAX = 8
+LEVEL_NAMES = {1: "DEBUG", 2: "INFO", 3: "WARNING", 4: "ERROR"}
+
+# printf转换说明：标志、宽度、精度、长度修饰、转换字符
+SPEC_RE = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t)?([diouxXcspf%])")
+
+
+class Elf(object):
+    """只读取可加载段，用于按地址取常量字符串。支持ELF32/ELF64小端。"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("not an ELF file: %s" % path)
+        is64 = self.data[4] == 2
+        if is64:
+            phoff, = struct.unpack_from("<Q", self.data, 0x20)
+            phentsize, phnum = struct.unpack_from("<HH", self.data, 0x36)
+        else:
+            phoff, = struct.unpack_from("<I", self.data, 0x1C)
+            phentsize, phnum = struct.unpack_from("<HH", self.data, 0x2A)
+        self.segments = []
+        for i in range(phnum):
+            off = phoff + i * phentsize
+            if is64:
+                p_type, _, p_offset, p_vaddr, p_paddr, p_filesz = struct.unpack_from("<IIQQQQ", self.data, off)
+            else:
+                p_type, p_offset, p_vaddr, p_paddr, p_filesz = struct.unpack_from("<IIIII", self.data, off)
+            if p_type == 1 and p_filesz > 0:  # PT_LOAD
+                self.segments.append((p_vaddr, p_offset, p_filesz))
+                if p_paddr != p_vaddr:
+                    self.segments.append((p_paddr, p_offset, p_filesz))
+        self.cache = {}
+
+    def string_at(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        s = None
+        for vaddr, offset, size in self.segments:
+            if vaddr <= addr < vaddr + size:
+                start = offset + addr - vaddr
+                end = self.data.find(b"\0", start, offset + size)
+                if end >= 0 and end - start < 512:
+                    s = self.data[start:end].decode("utf-8", "replace")
+                break
+        self.cache[addr] = s
+        return s
+
+
+def spec_count(fmt):
+    return sum(1 for m in SPEC_RE.finditer(fmt) if m.group(5) != "%")
+
+
+def format_record(elf, fmt, args):
+    """按C的printf规则格式化，参数都是32位原始值。"""
+    it = iter(args)
+
+    def conv(m):
+        flags, width, prec, _, c = m.groups()
+        if c == "%":
+            return "%"
+        v = next(it, 0)
+        pyspec = "%" + flags + (width or "") + ("." + prec if prec else "")
+        if c in "di":
+            return (pyspec + "d") % (v - (1 << 32) if v & 0x80000000 else v)
+        if c in "uoxX":
+            return (pyspec + (c if c != "u" else "d")) % v
+        if c == "c":
+            return (pyspec + "c") % chr(v & 0xFF)
+        if c == "s":
+            s = elf.string_at(v)
+            return (pyspec + "s") % (s if s is not None else "<0x%08X>" % v)
+        if c == "p":
+            return "0x%08X" % v
+        return "<%s:0x%08X>" % (c, v)  # %f等不支持的转换
+
+    return SPEC_RE.sub(conv, fmt)
+
+
+class Decoder(object):
+    def __init__(self, elf, out):
+        self.elf = elf
+        self.out = out
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.last_seq = None
+        self.base_us = None
+        self.last_us = 0
+        self.wraps = 0
+        self.records = 0
+        self.lost = 0
+
+    def flush_text(self):
+        if self.text:
+            self.out.write(self.text.decode("utf-8", "replace"))
+            self.text = bytearray()
+
+    def try_record(self):
+        """buf[0]为同步字节时尝试解析一条记录。返回消耗的字节数，0表示需要更多数据，-1表示不是记录。"""
+        if len(self.buf) < DLOG_HEADER_LEN:
+            return 0
+        argc, level, seq = self.buf[1], self.buf[2], self.buf[3]
+        if argc > DLOG_ARG_MAX or level not in LEVEL_NAMES:
+            return -1
+        fmt_addr, ts = struct.unpack_from("<II", self.buf, 4)
+        fmt = self.elf.string_at(fmt_addr)
+        if fmt is None or spec_count(fmt) != argc:
+            return -1
+        n = DLOG_HEADER_LEN + argc * 4
+        if len(self.buf) < n:
+            return 0
+        args = struct.unpack_from("<%dI" % argc, self.buf, DLOG_HEADER_LEN)
+
+        if self.last_seq is not None:
+            gap = (seq - self.last_seq - 1) & 0xFF
+            if gap:
+                self.lost += gap
+                self.flush_text()
+                self.out.write("[dlog] %d record(s) lost\n" % gap)
+        self.last_seq = seq
+        # 32位us时间戳约71分钟回绕一次
+        if self.base_us is None:
+            self.base_us = ts
+        elif ts < self.last_us:
+            self.wraps += 1
+        self.last_us = ts
+        t = ((self.wraps << 32) + ts - self.base_us) / 1e6
+
+        self.flush_text()
+        self.out.write("#%12.6f [%s]: %s\n" % (t, LEVEL_NAMES[level], format_record(self.elf, fmt, args).rstrip("\r\n")))
+        self.records += 1
+        return n
+
+    def feed(self, data):
+        self.buf.extend(data)
+        while self.buf:
+            if self.buf[0] == DLOG_SYNC:
+                n = self.try_record()
+                if n == 0:
+                    return
+                if n > 0:
+                    del self.buf[:n]
+                    continue
+            self.text.append(self.buf[0])
+            del self.buf[0]
+            if self.text[-1:] == b"\n":
+                self.flush_text()
+
+    def finish(self):
+        self.text.extend(self.buf)
+        self.buf = bytearray()
+        self.flush_text()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="decode deferred binary logs written by BFL/dlog.c")
+    parser.add_argument("elf", help="firmware ELF (.axf) the log was produced by")
+    parser.add_argument("input", nargs="?", help="captured byte stream, stdin if omitted")
+    parser.add_argument("--serial", help="read from a serial port instead (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=1500000)
+    args = parser.parse_args()
+
+    out = sys.stdout
+    dec = Decoder(Elf(args.elf), out)
+    if args.serial:
+        import serial
+        port = serial.Serial(args.serial, args.baud, timeout=0.1)
+        try:
+            while True:
+                dec.feed(port.read(4096))
+                out.flush()
+        except KeyboardInterrupt:
+            pass
+    else:
+        f = open(args.input, "rb") if args.input else sys.stdin.buffer
+        while True:
+            data = f.read(65536)
+            if not data:
+                break
+            dec.feed(data)
+    dec.finish()
+    sys.stderr.write("[dlog] %d record(s) decoded, %d lost\n" % (dec.records, dec.lost))
+
+
+if __name__ == "__main__":
+    main()